@@ -47,6 +47,10 @@
 #define OONF_LAYER2_H_
 
 #include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/bitmap256.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr_lpm.h>
 #include <oonf/oonf.h>
 #include <oonf/libcore/oonf_subsystem.h>
 #include <oonf/base/os_interface.h>
@@ -255,6 +259,12 @@ struct oonf_layer2_data {
 
   /*! layer2 originator id */
   const struct oonf_layer2_origin *_origin;
+
+  /*! true if value has changed since the last commit of its object */
+  bool _modified;
+
+  /*! true if value has been set since the last commit of its object, even if it did not change */
+  bool _updated;
 };
 
 /**
@@ -437,6 +447,11 @@ enum oonf_layer2_neighbor_index
   OONF_LAYER2_NEIGH_COUNT,
 };
 
+enum oonf_layer2_net_mods {
+  OONF_LAYER2_NET_MODIFY_NONE       = 0,
+  OONF_LAYER2_NET_MODIFY_PEER_IPS   = 1<<0,
+};
+
 /**
  * representation of a layer2 interface
  */
@@ -465,6 +480,12 @@ struct oonf_layer2_net {
   /*! global tree of all remote neighbor IPs */
   struct avl_tree remote_neighbor_ips;
 
+  /*! hash index of remote neighbors by neighbor key */
+  struct hashmap _neighbor_index;
+
+  /*! hash index of all remote neighbor IPs, one object for each IP */
+  struct hashmap _remote_ip_index;
+
   /*! absolute timestamp when network has been active last */
   uint64_t last_seen;
 
@@ -474,6 +495,21 @@ struct oonf_layer2_net {
   /*! default values of neighbor layer2 data */
   struct oonf_layer2_data neighdata[OONF_LAYER2_NEIGH_COUNT];
 
+  /*! fields modified since last commit */
+  enum oonf_layer2_net_mods modified;
+
+  /*! network data indices changed by the commit, only valid during the change event */
+  struct bitmap256 modified_data;
+
+  /*! neighbor default data indices changed by the commit, only valid during the change event */
+  struct bitmap256 modified_neighdata;
+
+  /*! true while the change event of a commit is delivered */
+  bool _changeset;
+
+  /*! member entry for pending commits of a database transaction */
+  struct list_entity _pending_node;
+
   /*! node to hook into global l2network tree */
   struct avl_node _node;
 };
@@ -520,11 +556,66 @@ union oonf_layer2_neigh_key_str {
   char buf[sizeof(struct netaddr_str) + 5 + 16*2];
 };
 
+/*! maximum number of neighbor data indices with a history */
+#define OONF_LAYER2_HISTORY_MAX_INDICES 8
+
+/*! maximum number of samples stored per neighbor and data index */
+#define OONF_LAYER2_HISTORY_MAX_DEPTH 1024
+
+/**
+ * Ring buffers of timestamped samples for the configured neighbor data
+ * indices of a layer2 neighbor. Each neighbor commit adds a sample for
+ * every index that has been set since the last commit, even if its value
+ * did not change. Header and sample arrays are allocated as a single
+ * memory block.
+ */
+struct oonf_layer2_history {
+  /*! number of samples stored per data index */
+  uint16_t depth;
+
+  /*! number of data indices stored */
+  uint16_t slots;
+
+  /*! position of the next sample of each data index */
+  uint16_t next[OONF_LAYER2_HISTORY_MAX_INDICES];
+
+  /*! number of valid samples of each data index */
+  uint16_t count[OONF_LAYER2_HISTORY_MAX_INDICES];
+
+  /*! sample values, depth entries for each data index */
+  int64_t *values;
+
+  /*! lower 32 bit of the absolute sample timestamps, depth entries for each data index */
+  uint32_t *timestamps;
+};
+
+/**
+ * Aggregated values of the samples of a layer2 data history
+ */
+struct oonf_layer2_history_stats {
+  /*! number of samples used for aggregation */
+  uint32_t count;
+
+  /*! smallest sample value */
+  int64_t min;
+
+  /*! largest sample value */
+  int64_t max;
+
+  /*! average of all sample values */
+  int64_t avg;
+
+  /*! sample value at the requested percentile */
+  int64_t percentile;
+};
+
 enum oonf_layer2_neigh_mods {
   OONF_LAYER2_NEIGH_MODIFY_NONE       = 0,
   OONF_LAYER2_NEIGH_MODIFY_NEXTHOP_V4 = 1<<0,
   OONF_LAYER2_NEIGH_MODIFY_NEXTHOP_V6 = 1<<1,
   OONF_LAYER2_NEIGH_MODIFY_LASTSEEN   = 1<<2,
+  OONF_LAYER2_NEIGH_MODIFY_REMOTE_IPS = 1<<3,
+  OONF_LAYER2_NEIGH_MODIFY_DESTINATIONS = 1<<4,
 };
 
 /**
@@ -558,8 +649,23 @@ struct oonf_layer2_neigh {
   /*! neigbor layer 2 data */
   struct oonf_layer2_data data[OONF_LAYER2_NEIGH_COUNT];
 
+  /*! data indices changed by the commit, only valid during the change event */
+  struct bitmap256 modified_data;
+
+  /*! true while the change event of a commit is delivered */
+  bool _changeset;
+
+  /*! history of the configured data indices, NULL if not recorded */
+  struct oonf_layer2_history *_history;
+
+  /*! member entry for pending commits of a database transaction */
+  struct list_entity _pending_node;
+
   /*! node to hook into tree of layer2 network */
   struct avl_node _node;
+
+  /*! node to hook into neighbor index of layer2 network */
+  struct hashmap_node _index_node;
 };
 
 /**
@@ -578,6 +684,12 @@ struct oonf_layer2_neighbor_address {
   /*! (interface) global tree of neighbor IP addresses */
   struct avl_node _net_node;
 
+  /*! node for (interface) global index of neighbor IP addresses */
+  struct hashmap_node _net_index_node;
+
+  /*! node for longest prefix match index of all neighbor IP addresses */
+  struct netaddr_lpm_node _lpm_node;
+
   /*! node for tree of ip addresses */
   struct avl_node _neigh_node;
 };
@@ -610,6 +722,9 @@ struct oonf_layer2_lid {
 EXPORT void oonf_layer2_origin_add(struct oonf_layer2_origin *origin);
 EXPORT void oonf_layer2_origin_remove(struct oonf_layer2_origin *origin);
 
+EXPORT void oonf_layer2_transaction_start(void);
+EXPORT void oonf_layer2_transaction_commit(void);
+
 EXPORT int oonf_layer2_data_parse_string(
   union oonf_layer2_value *value, const struct oonf_layer2_metadata *meta, const char *input);
 EXPORT const char *oonf_layer2_data_to_string(
@@ -661,6 +776,14 @@ EXPORT struct oonf_layer2_data *oonf_layer2_neigh_add_path(
 EXPORT struct oonf_layer2_data *oonf_layer2_neigh_get_data(
   struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx);
 
+EXPORT bool oonf_layer2_neigh_is_history_index(enum oonf_layer2_neighbor_index idx);
+EXPORT size_t oonf_layer2_neigh_get_history_count(
+  const struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx);
+EXPORT int oonf_layer2_neigh_get_history_sample(int64_t *value, uint64_t *timestamp,
+  const struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx, size_t n);
+EXPORT int oonf_layer2_neigh_get_history_stats(struct oonf_layer2_history_stats *stats,
+  const struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx, uint64_t window, uint32_t percentile);
+
 EXPORT const struct oonf_layer2_metadata *oonf_layer2_neigh_metadata_get(enum oonf_layer2_neighbor_index);
 EXPORT const struct oonf_layer2_metadata *oonf_layer2_net_metadata_get(enum oonf_layer2_network_index);
 EXPORT const char *oonf_layer2_cfg_get_l2net_key(size_t index, const void *unused);
@@ -676,6 +799,7 @@ EXPORT const char *oonf_layer2_net_get_type_name(enum oonf_layer2_network_type);
 EXPORT struct avl_tree *oonf_layer2_get_net_tree(void);
 EXPORT struct avl_tree *oonf_layer2_get_origin_tree(void);
 EXPORT int oonf_layer2_avlcmp_neigh_key(const void *p1, const void *p2);
+EXPORT uint32_t oonf_layer2_hash_neigh_key(const void *key);
 EXPORT const char *oonf_layer2_neigh_key_to_string(union oonf_layer2_neigh_key_str *buf,
     const struct oonf_layer2_neigh_key *key, bool show_mac);
 EXPORT int oonf_layer2_neigh_key_from_string(struct oonf_layer2_neigh_key *key, const char *string);
@@ -722,7 +846,7 @@ oonf_layer2_net_get_local_ip(const struct oonf_layer2_net *l2net, const struct n
 static INLINE struct oonf_layer2_neighbor_address *
 oonf_layer2_net_get_remote_ip(const struct oonf_layer2_net *l2net, const struct netaddr *addr) {
   struct oonf_layer2_neighbor_address *l2ip;
-  return avl_find_element(&l2net->remote_neighbor_ips, addr, l2ip, _net_node);
+  return hashmap_find_element(&l2net->_remote_ip_index, addr, l2ip, _net_index_node);
 }
 
 static INLINE struct oonf_layer2_neigh *
@@ -747,7 +871,7 @@ oonf_layer2_neigh_get(const struct oonf_layer2_net *l2net, const struct netaddr
 
   memset(&key, 0, sizeof(key));
   memcpy(&key.addr, addr, sizeof(*addr));
-  return avl_find_element(&l2net->neighbors, &key, l2neigh, _node);
+  return hashmap_find_element(&l2net->_neighbor_index, &key, l2neigh, _index_node);
 }
 
 /**
@@ -759,7 +883,7 @@ oonf_layer2_neigh_get(const struct oonf_layer2_net *l2net, const struct netaddr
 static INLINE struct oonf_layer2_neigh *
 oonf_layer2_neigh_get_lid(const struct oonf_layer2_net *l2net, const struct oonf_layer2_neigh_key *key) {
   struct oonf_layer2_neigh *l2neigh;
-  return avl_find_element(&l2net->neighbors, key, l2neigh, _node);
+  return hashmap_find_element(&l2net->_neighbor_index, key, l2neigh, _index_node);
 }
 
 static INLINE bool
@@ -767,6 +891,68 @@ oonf_layer2_neigh_is_modified(const struct oonf_layer2_neigh *neigh, enum oonf_l
   return (neigh->modified & mod_mask) != 0;
 }
 
+/**
+ * @param neigh layer-2 neighbor object
+ * @return true if the neighbor change event of a commit is delivered right
+ *   now and the modified_data bitmap contains the changed data indices
+ */
+static INLINE bool
+oonf_layer2_neigh_has_changeset(const struct oonf_layer2_neigh *neigh) {
+  return neigh->_changeset;
+}
+
+/**
+ * Check if a neighbor data value has been changed by the current commit.
+ * Outside of a change event all data is considered to be modified.
+ * @param neigh layer-2 neighbor object
+ * @param idx neighbor data index
+ * @return true if data might have changed, false otherwise
+ */
+static INLINE bool
+oonf_layer2_neigh_is_data_modified(const struct oonf_layer2_neigh *neigh, enum oonf_layer2_neighbor_index idx) {
+  return !neigh->_changeset || bitmap256_get(&neigh->modified_data, idx);
+}
+
+static INLINE bool
+oonf_layer2_net_is_modified(const struct oonf_layer2_net *net, enum oonf_layer2_net_mods mod_mask) {
+  return (net->modified & mod_mask) != 0;
+}
+
+/**
+ * @param net layer-2 network object
+ * @return true if the network change event of a commit is delivered right
+ *   now and the modified bitmaps contain the changed data indices
+ */
+static INLINE bool
+oonf_layer2_net_has_changeset(const struct oonf_layer2_net *net) {
+  return net->_changeset;
+}
+
+/**
+ * Check if a network data value has been changed by the current commit.
+ * Outside of a change event all data is considered to be modified.
+ * @param net layer-2 network object
+ * @param idx network data index
+ * @return true if data might have changed, false otherwise
+ */
+static INLINE bool
+oonf_layer2_net_is_data_modified(const struct oonf_layer2_net *net, enum oonf_layer2_network_index idx) {
+  return !net->_changeset || bitmap256_get(&net->modified_data, idx);
+}
+
+/**
+ * Check if a neighbor default value of a network has been changed by the
+ * current commit. Outside of a change event all data is considered to be
+ * modified.
+ * @param net layer-2 network object
+ * @param idx neighbor data index
+ * @return true if data might have changed, false otherwise
+ */
+static INLINE bool
+oonf_layer2_net_is_neighdata_modified(const struct oonf_layer2_net *net, enum oonf_layer2_neighbor_index idx) {
+  return !net->_changeset || bitmap256_get(&net->modified_neighdata, idx);
+}
+
 static INLINE const struct netaddr *
 oonf_layer2_neigh_get_nexthop(const struct oonf_layer2_neigh *neigh, int af_type) {
   switch (af_type) {
@@ -983,6 +1169,9 @@ oonf_layer2_neigh_data_from_string(struct oonf_layer2_data *data, enum oonf_laye
  */
 static INLINE void
 oonf_layer2_data_reset(struct oonf_layer2_data *l2data) {
+  if (oonf_layer2_data_has_value(l2data)) {
+    l2data->_modified = true;
+  }
   l2data->_meta = NULL;
   l2data->_origin = NULL;
 }
@@ -285,6 +285,8 @@ EXPORT const union netaddr_socket *oonf_rfc5444_interface_get_local_socket(
 EXPORT const union netaddr_socket *oonf_rfc5444_target_get_local_socket(struct oonf_rfc5444_target *target);
 
 EXPORT enum rfc5444_result oonf_rfc5444_send_if(struct oonf_rfc5444_target *, uint8_t msgid);
+EXPORT enum rfc5444_result oonf_rfc5444_send_if_binary(
+  struct oonf_rfc5444_target *, const uint8_t *msg, size_t len);
 EXPORT enum rfc5444_result oonf_rfc5444_send_all(
   struct oonf_rfc5444_protocol *protocol, uint8_t msgid, uint8_t addr_len, rfc5444_writer_targetselector useIf);
 
@@ -75,6 +75,12 @@ struct os_route_str;
 #define RT_TABLE_UNSPEC 0
 #endif
 
+/*! maximum number of next hops of a multipath route (including the primary one) */
+enum
+{
+  OS_ROUTE_MAX_NEXTHOPS = 4
+};
+
 
 /**
  * Struct for text representation of a route
@@ -102,6 +108,8 @@ struct os_route_str {
     /* table, protocol */
     + 6 + 4 + 9 + 4 + 3 + IF_NAMESIZE + 2 + 10 +
     2
+    /* multipath */
+    + 11 + 3
     /* footer and 0-byte */
     + 2];
 };
@@ -159,6 +167,17 @@ struct os_route_key {
   struct netaddr src;
 };
 
+/**
+ * additional next hop of a multipath route
+ */
+struct os_route_nexthop {
+  /*! gateway of next hop */
+  struct netaddr gw;
+
+  /*! index of outgoing interface of next hop */
+  unsigned int if_index;
+};
+
 struct os_route_parameter {
   /*! address family */
   unsigned char family;
@@ -186,6 +205,12 @@ struct os_route_parameter {
 
   /*! index of outgoing interface */
   unsigned int if_index;
+
+  /*! number of additional next hops of a multipath route */
+  unsigned int multipath_count;
+
+  /*! additional next hops of a multipath route (gw and if_index are the first one) */
+  struct os_route_nexthop multipath[OS_ROUTE_MAX_NEXTHOPS - 1];
 };
 
 /* include os-specific headers */
@@ -369,6 +369,8 @@ EXPORT int dlep_extension_radio_write_session_init_ack(
   struct dlep_extension *ext, struct dlep_session *session, const struct oonf_layer2_neigh_key *neigh);
 EXPORT int dlep_extension_radio_write_session_update(
   struct dlep_extension *ext, struct dlep_session *session, const struct oonf_layer2_neigh_key *neigh);
+EXPORT int dlep_extension_radio_write_destination_update(
+  struct dlep_extension *ext, struct dlep_session *session, const struct oonf_layer2_neigh_key *neigh);
 EXPORT int dlep_extension_radio_write_destination(
   struct dlep_extension *ext, struct dlep_session *session, const struct oonf_layer2_neigh_key *neigh);
 
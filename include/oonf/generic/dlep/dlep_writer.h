@@ -76,6 +76,10 @@ int dlep_writer_map_identity(struct dlep_writer *writer, struct oonf_layer2_data
   const struct oonf_layer2_metadata *meta, uint16_t tlv, uint16_t length, uint64_t scaling);
 int dlep_writer_map_l2neigh_data(
   struct dlep_writer *writer, struct dlep_extension *ext, struct oonf_layer2_data *data, struct oonf_layer2_data *def);
+int dlep_writer_map_l2neigh_changes(
+  struct dlep_writer *writer, struct dlep_extension *ext, struct oonf_layer2_neigh *l2neigh);
 int dlep_writer_map_l2net_data(struct dlep_writer *writer, struct dlep_extension *ext, struct oonf_layer2_data *data);
+int dlep_writer_map_l2net_changes(
+  struct dlep_writer *writer, struct dlep_extension *ext, struct oonf_layer2_net *l2net);
 
 #endif /* DLEP_WRITER_H_ */
@@ -48,8 +48,11 @@
 
 #include <oonf/generic/nl80211_listener/nl80211_listener.h>
 
+int nl80211_init_station_dump(void);
+void nl80211_cleanup_station_dump(void);
 void nl80211_send_get_station_dump(
   struct os_system_netlink *nl, struct nlmsghdr *nl_msg, struct genlmsghdr *hdr, struct nl80211_if *interf);
 void nl80211_process_get_station_dump_result(struct nl80211_if *interf, struct nlmsghdr *);
+void nl80211_finalize_get_station_dump(struct nl80211_if *interf);
 
 #endif /* NL80211_GET_STATION_DUMP_H_ */
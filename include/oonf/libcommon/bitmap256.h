@@ -71,10 +71,19 @@ EXPORT bool bitmap256_is_subset(struct bitmap256 *set, struct bitmap256 *subset)
  * @return content of the bit
  */
 static inline bool
-bitmap256_get(struct bitmap256 *map, uint8_t bit) {
+bitmap256_get(const struct bitmap256 *map, uint8_t bit) {
   return ((map->b[bit >> 6]) & (1ull << (bit & 63ull))) != 0;
 }
 
+/**
+ * @param map pointer to bit array
+ * @return true if no bit of the array is set
+ */
+static inline bool
+bitmap256_is_empty(const struct bitmap256 *map) {
+  return (map->b[0] | map->b[1] | map->b[2] | map->b[3]) == 0;
+}
+
 /**
  * set a bit of the bit array
  * @param map pointer to bit array
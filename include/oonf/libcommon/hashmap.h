@@ -0,0 +1,151 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef _HASHMAP_H
+#define _HASHMAP_H
+
+#include <stddef.h>
+
+#include <oonf/oonf.h>
+#include <oonf/libcommon/container_of.h>
+#include <oonf/libcommon/list.h>
+
+/*! initial number of buckets of a hashmap */
+enum
+{
+  HASHMAP_INITIAL_BUCKETS = 16
+};
+
+/**
+ * This element is a member of a hashmap. It must be contained in all
+ * larger structs that should be put into a hashmap.
+ */
+struct hashmap_node {
+  /*! linked list node of the bucket */
+  struct list_entity _list;
+
+  /**
+   * pointer to key of node, must be set before the node
+   * is inserted into a hashmap
+   */
+  const void *key;
+
+  /*! hash value of the key */
+  uint32_t _hash;
+};
+
+/**
+ * This struct is the central management part of a hashmap.
+ * Buckets are allocated with the first insert and the number of
+ * buckets is doubled when the map contains more elements than buckets.
+ */
+struct hashmap {
+  /*! array of bucket list heads */
+  struct list_entity *_buckets;
+
+  /*! number of buckets, always a power of two (or zero) */
+  uint32_t _bucket_count;
+
+  /*! number of nodes in the hashmap */
+  uint32_t count;
+
+  /**
+   * Prototype for hash function
+   * @param key pointer to key
+   * @return hash value of key
+   */
+  uint32_t (*hash)(const void *key);
+
+  /**
+   * Prototype for key comparator (same as avl comparators)
+   * @param k1 first key
+   * @param k2 second key
+   * @return 0 if k1==k2, non-zero otherwise
+   */
+  int (*comp)(const void *k1, const void *k2);
+};
+
+EXPORT void hashmap_init(
+  struct hashmap *, uint32_t (*hash)(const void *key), int (*comp)(const void *k1, const void *k2));
+EXPORT void hashmap_free(struct hashmap *);
+EXPORT int hashmap_insert(struct hashmap *, struct hashmap_node *);
+EXPORT void hashmap_remove(struct hashmap *, struct hashmap_node *);
+EXPORT struct hashmap_node *hashmap_find(const struct hashmap *, const void *key);
+
+EXPORT uint32_t hashmap_hash_bytes(const void *data, size_t length);
+EXPORT uint32_t hashmap_hash_netaddr(const void *addr);
+
+/**
+ * @param map pointer to hashmap
+ * @return true if the hashmap is empty, false otherwise
+ */
+static INLINE bool
+hashmap_is_empty(const struct hashmap *map) {
+  return map->count == 0;
+}
+
+/**
+ * @param node pointer to hashmap node
+ * @return true if node is currently in a hashmap, false otherwise
+ */
+static INLINE bool
+hashmap_is_node_added(const struct hashmap_node *node) {
+  return list_is_node_added(&node->_list);
+}
+
+/**
+ * @param map pointer to hashmap
+ * @param key pointer to key
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_element name of the hashmap_node element inside the
+ *    larger struct
+ * @return pointer to hashmap element with the specified key,
+ *    NULL if no element was found
+ */
+#define hashmap_find_element(map, key, element, node_element)                                                          \
+  container_of_if_notnull(hashmap_find(map, key), typeof(*(element)), node_element)
+
+#endif /* _HASHMAP_H */
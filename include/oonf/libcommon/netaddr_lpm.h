@@ -0,0 +1,122 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef _NETADDR_LPM_H
+#define _NETADDR_LPM_H
+
+#include <oonf/oonf.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+
+/*! maximum prefix length of all supported address families */
+enum
+{
+  NETADDR_LPM_MAX_PREFIX = 128
+};
+
+/**
+ * This element is a member of a longest prefix match index. It must
+ * be contained in all larger structs that should be put into an index.
+ */
+struct netaddr_lpm_node {
+  /*! prefix with all host bits set to zero, key of the hash index */
+  struct netaddr _prefix;
+
+  /*! member of the hash index */
+  struct hashmap_node _node;
+
+  /**
+   * ring of all nodes with the same prefix, only the first
+   * of them is part of the hash index
+   */
+  struct list_entity _duplicates;
+};
+
+/**
+ * Longest prefix match index for netaddr prefixes. Prefixes are
+ * stored in a hashmap, a lookup checks all prefix lengths that
+ * are used by at least one node, starting with the longest one.
+ */
+struct netaddr_lpm {
+  /*! hash index of all prefixes */
+  struct hashmap _map;
+
+  /*! number of nodes for each prefix length */
+  uint32_t _prefix_count[NETADDR_LPM_MAX_PREFIX + 1];
+
+  /*! number of nodes in the index */
+  uint32_t count;
+};
+
+EXPORT void netaddr_lpm_init(struct netaddr_lpm *);
+EXPORT void netaddr_lpm_free(struct netaddr_lpm *);
+EXPORT int netaddr_lpm_add(struct netaddr_lpm *, struct netaddr_lpm_node *, const struct netaddr *prefix);
+EXPORT void netaddr_lpm_remove(struct netaddr_lpm *, struct netaddr_lpm_node *);
+EXPORT struct netaddr_lpm_node *netaddr_lpm_find(const struct netaddr_lpm *, const struct netaddr *addr);
+
+/**
+ * @param node pointer to longest prefix match node
+ * @return true if node is currently in an index, false otherwise
+ */
+static INLINE bool
+netaddr_lpm_is_node_added(const struct netaddr_lpm_node *node) {
+  return list_is_node_added(&node->_duplicates);
+}
+
+/**
+ * @param lpm pointer to longest prefix match index
+ * @param addr pointer to address
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_element name of the netaddr_lpm_node element inside the
+ *    larger struct
+ * @return pointer to element with the longest prefix containing the
+ *    address, NULL if no element was found
+ */
+#define netaddr_lpm_find_element(lpm, addr, element, node_element)                                                     \
+  container_of_if_notnull(netaddr_lpm_find(lpm, addr), typeof(*(element)), node_element)
+
+#endif /* _NETADDR_LPM_H */
@@ -680,6 +680,8 @@ EXPORT enum rfc5444_result rfc5444_writer_create_message(
 
 EXPORT enum rfc5444_result rfc5444_writer_forward_msg(
   struct rfc5444_writer *writer, struct rfc5444_reader_tlvblock_context *context, const uint8_t *msg, size_t len);
+EXPORT enum rfc5444_result rfc5444_writer_add_binary_msg(
+  struct rfc5444_writer *writer, struct rfc5444_writer_target *target, const uint8_t *msg, size_t len);
 
 EXPORT void rfc5444_writer_flush(struct rfc5444_writer *, struct rfc5444_writer_target *, bool);
 
@@ -56,6 +56,6 @@ struct mpr_flooding_data {
   struct neighbor_graph neigh_graph;
 };
 
-void mpr_calculate_neighbor_graph_flooding(const struct nhdp_domain *domain, struct mpr_flooding_data *data);
+int mpr_calculate_neighbor_graph_flooding(const struct nhdp_domain *domain, struct mpr_flooding_data *data);
 
 #endif
@@ -50,6 +50,6 @@
 
 #include <oonf/nhdp/mpr/neighbor-graph.h>
 
-void mpr_calculate_neighbor_graph_routing(const struct nhdp_domain *domain, struct neighbor_graph *graph);
+int mpr_calculate_neighbor_graph_routing(const struct nhdp_domain *domain, struct neighbor_graph *graph);
 
 #endif
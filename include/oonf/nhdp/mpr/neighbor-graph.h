@@ -47,6 +47,7 @@
 #define __NEIGHBOR_GRAPH__
 
 #include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/list.h>
 #include <oonf/libcommon/netaddr.h>
 #include <oonf/nhdp/nhdp/nhdp_db.h>
 #include <oonf/nhdp/nhdp/nhdp_domain.h>
@@ -55,10 +56,53 @@ struct neighbor_graph;
 struct addr_node;
 struct n1_node;
 
+/* number of graph nodes in one arena block */
+#define MPR_ARENA_BLOCK_NODES 256
+
+/* minimum size of an arena chunk for arrays in bytes */
+#define MPR_ARENA_CHUNK_SIZE 16384
+
+/**
+ * Reusable storage for the nodes and arrays of a neighbor graph.
+ * Nothing is freed individually, the whole arena is reset after
+ * a calculation and keeps its memory for the next one.
+ */
+struct mpr_arena {
+  /*! list of allocated blocks */
+  struct list_entity _blocks;
+
+  /*! block used for the next allocation, NULL if arena is empty */
+  struct mpr_arena_block *_current;
+
+  /*! list of allocated chunks for arrays */
+  struct list_entity _chunks;
+};
+
+/**
+ * Global statistics of all MPR arenas
+ */
+struct mpr_arena_stats {
+  /*! number of nodes allocated from arenas */
+  uint64_t node_allocs;
+
+  /*! number of node blocks and array chunks allocated from the heap */
+  uint64_t block_allocs;
+
+  /*! number of node blocks and array chunks returned to the heap */
+  uint64_t block_frees;
+
+  /*! number of arena resets */
+  uint64_t resets;
+
+  /*! number of node blocks and array chunks currently allocated */
+  uint32_t blocks;
+};
+
 struct neighbor_graph_interface {
   bool (*is_allowed_link_tuple)(
     const struct nhdp_domain *, struct nhdp_interface *current_interface, struct nhdp_link *link);
   uint32_t (*calculate_d1_x_of_n2_addr)(const struct nhdp_domain *, struct neighbor_graph *, struct addr_node *);
+  uint32_t (*calculate_d1_x)(const struct nhdp_domain *, struct n1_node *);
   uint32_t (*calculate_d_x_y)(
     const struct nhdp_domain *, struct neighbor_graph *, struct n1_node *, struct addr_node *);
   uint32_t (*calculate_d2_x_y)(const struct nhdp_domain *, struct n1_node *, struct addr_node *);
@@ -74,6 +118,15 @@ struct neighbor_graph {
   struct neighbor_graph_interface *methods;
 
   uint32_t *d_x_y_cache;
+
+  /* number of N2 rows allocated in the d(x,y) cache */
+  uint32_t d_x_y_rows;
+
+  /* number of N2 rows used in the d(x,y) cache */
+  uint32_t d_x_y_used;
+
+  /* storage for all nodes of the graph */
+  struct mpr_arena *arena;
 };
 
 /* FIXME Find a more consistent naming and/or approach to defining the set elements */
@@ -83,6 +136,12 @@ struct addr_node {
 
   uint32_t table_offset;
   uint32_t min_d_z_y;
+
+  /* d1(y) when the node was last evaluated */
+  uint32_t d1;
+
+  /* true if the node has to be evaluated by the next incremental update */
+  bool changed;
 };
 
 /* FIXME The link field is only used for flooding, while neigh is only used for routingt MPRs;
@@ -94,11 +153,66 @@ struct n1_node {
   struct avl_node _avl_node;
 
   uint32_t table_offset;
+
+  /* W(x) when the MPR set was calculated */
+  uint32_t willingness;
+
+  /* d1(x) when the MPR set was calculated */
+  uint32_t d1;
+
+  /* true if d1(x) changed since the last MPR calculation */
+  bool changed;
+};
+
+/**
+ * Block of graph nodes of an arena
+ */
+struct mpr_arena_block {
+  /*! hook into list of arena blocks */
+  struct list_entity _node;
+
+  /*! number of used nodes */
+  uint32_t used;
+
+  /*! storage for graph nodes */
+  union {
+    struct n1_node n1;
+    struct addr_node addr;
+  } nodes[MPR_ARENA_BLOCK_NODES];
+};
+
+/**
+ * Chunk of memory for arrays of an arena
+ */
+struct mpr_arena_chunk {
+  /*! hook into list of arena chunks */
+  struct list_entity _node;
+
+  /*! size of data in bytes */
+  size_t size;
+
+  /*! number of used bytes */
+  size_t used;
+
+  /*! storage for arrays, 64 bit aligned */
+  uint64_t data[];
 };
 
-void mpr_add_n1_node_to_set(struct avl_tree *set, struct nhdp_neighbor *neigh, struct nhdp_link *link, uint32_t offset);
+void mpr_arena_init(struct mpr_arena *arena);
+
+void mpr_arena_reset(struct mpr_arena *arena);
+
+void mpr_arena_free(struct mpr_arena *arena);
+
+const struct mpr_arena_stats *mpr_arena_get_stats(void);
+
+void *mpr_arena_alloc_array(struct mpr_arena *arena, size_t count, size_t size);
+
+int mpr_add_n1_node_to_set(struct neighbor_graph *graph, struct avl_tree *set, struct nhdp_neighbor *neigh,
+  struct nhdp_link *link, uint32_t offset);
 
-void mpr_add_addr_node_to_set(struct avl_tree *set, const struct netaddr addr, uint32_t offset);
+int mpr_add_addr_node_to_set(
+  struct neighbor_graph *graph, struct avl_tree *set, const struct netaddr addr, uint32_t offset);
 
 void mpr_init_neighbor_graph(struct neighbor_graph *graph, struct neighbor_graph_interface *methods);
 
@@ -50,6 +50,9 @@
 
 #include <oonf/nhdp/mpr/neighbor-graph.h>
 
-void mpr_calculate_mpr_rfc7181(const struct nhdp_domain *, struct neighbor_graph *graph);
+int mpr_calculate_mpr_rfc7181(const struct nhdp_domain *, struct neighbor_graph *graph);
+int mpr_calculate_mpr_rfc7181_bitset(const struct nhdp_domain *, struct neighbor_graph *graph);
+int mpr_update_mpr_rfc7181(const struct nhdp_domain *, struct neighbor_graph *graph, const struct netaddr *changed,
+  uint32_t changed_count, uint32_t max_affected);
 
 #endif
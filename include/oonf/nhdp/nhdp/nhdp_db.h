@@ -52,6 +52,7 @@ struct nhdp_l2hop;
 struct nhdp_laddr;
 
 #include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/hashmap.h>
 #include <oonf/oonf.h>
 #include <oonf/libcommon/list.h>
 #include <oonf/libcommon/netaddr.h>
@@ -229,6 +230,9 @@ struct nhdp_link {
   /*! tree of two-hop addresses reachable through the other side of the link */
   struct avl_tree _2hop;
 
+  /*! hash index of two-hop addresses of the link (nhdp_l2hop objects) */
+  struct hashmap _2hop_index;
+
   /*! member entry for global list of nhdp links */
   struct list_entity _global_node;
 
@@ -241,8 +245,11 @@ struct nhdp_link {
   /*! optional member node for interface tree of originators */
   struct avl_node _originator_node;
 
-  /*! Array of link metrics */
-  struct nhdp_link_domaindata _domaindata[NHDP_MAXIMUM_DOMAINS];
+  /*! member entry for pending change events of a database transaction */
+  struct list_entity _pending_node;
+
+  /*! slot of the per-domain data (metrics, MPR) in the domain storage */
+  uint32_t _domain_slot;
 };
 
 /**
@@ -264,8 +271,8 @@ struct nhdp_laddr {
   /*! member entry for addresss of neighbor */
   struct avl_node _neigh_node;
 
-  /*! member entry for interface tree of link addresses */
-  struct avl_node _if_node;
+  /*! member entry for interface index of link addresses */
+  struct hashmap_node _if_node;
 };
 
 /**
@@ -284,14 +291,20 @@ struct nhdp_l2hop {
   /*! validity time for this address */
   struct oonf_timer_instance _vtime;
 
+  /*! absolute validity time for timer-free expiry, 0 if not set */
+  uint64_t _vtime_expire;
+
   /*! member entry for two-hop addresses of neighbor link */
   struct avl_node _link_node;
 
+  /*! member entry for two-hop address index of neighbor link */
+  struct hashmap_node _link_index_node;
+
   /*! member entry for interface list of two-hop addresses */
   struct avl_node _if_node;
 
-  /*! Array of link metrics */
-  struct nhdp_l2hop_domaindata _domaindata[NHDP_MAXIMUM_DOMAINS];
+  /*! slot of the per-domain data (metrics, MPR) in the domain storage */
+  uint32_t _domain_slot;
 };
 
 /**
@@ -334,8 +347,17 @@ struct nhdp_neighbor {
   /*! optional member node for global tree of originators */
   struct avl_node _originator_node;
 
-  /*! Array of link metrics */
-  struct nhdp_neighbor_domaindata _domaindata[NHDP_MAXIMUM_DOMAINS];
+  /*! member entry for pending changes of a database transaction */
+  struct list_entity _pending_node;
+
+  /*! true if a change event is pending until the end of the transaction */
+  bool _change_pending;
+
+  /*! true if a metric recalculation is pending until the end of the transaction */
+  bool _metric_pending;
+
+  /*! slot of the per-domain data (metrics, MPR) in the domain storage */
+  uint32_t _domain_slot;
 };
 
 /**
@@ -355,12 +377,18 @@ struct nhdp_naddr {
   /*! validity time for this address when its lost */
   struct oonf_timer_instance _lost_vtime;
 
+  /*! absolute validity time of lost address for timer-free expiry, 0 if not lost */
+  uint64_t _lost_expire;
+
   /*! member entry for neighbor address tree */
   struct avl_node _neigh_node;
 
   /*! member entry for global neighbor address tree */
   struct avl_node _global_node;
 
+  /*! member entry for global neighbor address index */
+  struct hashmap_node _global_index_node;
+
   /**
    * temporary variables for NHDP Hello processing
    * true if address is part of the local interface
@@ -388,6 +416,14 @@ EXPORT void nhdp_db_neighbor_set_originator(struct nhdp_neighbor *, const struct
 EXPORT void nhdp_db_neighbor_connect_dualstack(struct nhdp_neighbor *, struct nhdp_neighbor *);
 EXPORT void nhdp_db_neigbor_disconnect_dualstack(struct nhdp_neighbor *neigh);
 EXPORT uint32_t nhdp_db_neighbor_get_set_id(void);
+EXPORT uint32_t nhdp_db_get_generation(void);
+EXPORT void nhdp_db_increase_generation(void);
+EXPORT void nhdp_db_transaction_start(void);
+EXPORT void nhdp_db_transaction_commit(void);
+EXPORT void nhdp_db_neighbor_update_metrics(struct nhdp_neighbor *neigh);
+EXPORT void nhdp_db_set_timer_free_expiry(bool enable, uint64_t interval);
+EXPORT void nhdp_db_neighbor_addr_set_lost(struct nhdp_naddr *naddr, uint64_t vtime);
+EXPORT void nhdp_db_neighbor_addr_not_lost(struct nhdp_naddr *naddr);
 
 EXPORT struct nhdp_link *nhdp_db_link_add(struct nhdp_neighbor *ipv4, struct nhdp_interface *ipv6);
 EXPORT void nhdp_db_link_remove(struct nhdp_link *);
@@ -397,6 +433,8 @@ EXPORT void nhdp_db_link_addr_remove(struct nhdp_laddr *);
 EXPORT void nhdp_db_link_addr_move(struct nhdp_link *, struct nhdp_laddr *);
 EXPORT struct nhdp_l2hop *nhdp_db_link_2hop_add(struct nhdp_link *, const struct netaddr *);
 EXPORT void nhdp_db_link_2hop_remove(struct nhdp_l2hop *);
+EXPORT void nhdp_db_link_2hop_set_vtime(struct nhdp_l2hop *l2hop, uint64_t vtime);
+EXPORT void nhdp_db_link_2hop_changed(struct nhdp_l2hop *l2hop);
 EXPORT void nhdp_db_link_connect_dualstack(struct nhdp_link *ipv4, struct nhdp_link *ipv6);
 EXPORT void nhdp_db_link_disconnect_dualstack(struct nhdp_link *lnk);
 
@@ -408,6 +446,7 @@ EXPORT const char *nhdp_db_link_status_to_string(struct nhdp_link *);
 EXPORT struct list_entity *nhdp_db_get_neigh_list(void);
 EXPORT struct list_entity *nhdp_db_get_link_list(void);
 EXPORT struct avl_tree *nhdp_db_get_naddr_tree(void);
+EXPORT struct hashmap *nhdp_db_get_naddr_index(void);
 EXPORT struct avl_tree *nhdp_db_get_neigh_originator_tree(void);
 
 /**
@@ -417,7 +456,7 @@ EXPORT struct avl_tree *nhdp_db_get_neigh_originator_tree(void);
 static INLINE struct nhdp_naddr *
 nhdp_db_neighbor_addr_get(const struct netaddr *addr) {
   struct nhdp_naddr *naddr;
-  return avl_find_element(nhdp_db_get_naddr_tree(), addr, naddr, _global_node);
+  return hashmap_find_element(nhdp_db_get_naddr_index(), addr, naddr, _global_index_node);
 }
 
 /**
@@ -449,7 +488,7 @@ nhdp_db_link_addr_get(const struct nhdp_link *lnk, const struct netaddr *addr) {
 static INLINE struct nhdp_l2hop *
 ndhp_db_link_2hop_get(const struct nhdp_link *lnk, const struct netaddr *addr) {
   struct nhdp_l2hop *l2hop;
-  return avl_find_element(&lnk->_2hop, addr, l2hop, _link_node);
+  return hashmap_find_element(&lnk->_2hop_index, addr, l2hop, _link_index_node);
 }
 
 /**
@@ -484,41 +523,36 @@ nhdp_db_link_set_symtime(struct nhdp_link *lnk, uint64_t stime) {
 }
 
 /**
- * Set the validity time of a two-hop neighbor
  * @param l2hop nhdp link two-hop neighbor
- * @param vtime new validity time
- */
-static INLINE void
-nhdp_db_link_2hop_set_vtime(struct nhdp_l2hop *l2hop, uint64_t vtime) {
-  oonf_timer_set(&l2hop->_vtime, vtime);
-}
-
-/**
- * Define a neighbor address as lost
- * @param naddr nhdp neighbor address
- * @param vtime time until lost address gets purged from the database
+ * @return number of milliseconds until the two-hop neighbor expires
  */
-static INLINE void
-nhdp_db_neighbor_addr_set_lost(struct nhdp_naddr *naddr, uint64_t vtime) {
-  oonf_timer_set(&naddr->_lost_vtime, vtime);
+static INLINE int64_t
+nhdp_db_link_2hop_get_vtime(const struct nhdp_l2hop *l2hop) {
+  if (l2hop->_vtime_expire) {
+    return oonf_clock_get_relative(l2hop->_vtime_expire);
+  }
+  return oonf_timer_get_due(&l2hop->_vtime);
 }
 
 /**
- * Define a neighbor address as not lost anymore
  * @param naddr nhdp neighbor address
+ * @return true if address is lost, false otherwise
  */
-static INLINE void
-nhdp_db_neighbor_addr_not_lost(struct nhdp_naddr *naddr) {
-  oonf_timer_stop(&naddr->_lost_vtime);
+static INLINE bool
+nhdp_db_neighbor_addr_is_lost(const struct nhdp_naddr *naddr) {
+  return naddr->_lost_expire != 0 || oonf_timer_is_active(&naddr->_lost_vtime);
 }
 
 /**
  * @param naddr nhdp neighbor address
- * @return true if address is lost, false otherwise
+ * @return number of milliseconds until a lost address gets purged
  */
-static INLINE bool
-nhdp_db_neighbor_addr_is_lost(const struct nhdp_naddr *naddr) {
-  return oonf_timer_is_active(&naddr->_lost_vtime);
+static INLINE int64_t
+nhdp_db_neighbor_addr_get_lost_vtime(const struct nhdp_naddr *naddr) {
+  if (naddr->_lost_expire) {
+    return oonf_clock_get_relative(naddr->_lost_expire);
+  }
+  return oonf_timer_get_due(&naddr->_lost_vtime);
 }
 
 /**
@@ -590,6 +624,6 @@ nhdp_db_neighbor_is_ipv6_dualstack(const struct nhdp_neighbor *neigh) {
 
 static INLINE bool
 nhdp_db_2hop_is_lost(const struct nhdp_l2hop *l2hop) {
-  return oonf_timer_is_active(&l2hop->_vtime);
+  return l2hop->_vtime_expire != 0 || oonf_timer_is_active(&l2hop->_vtime);
 }
 #endif /* NHDP_DB_H_ */
@@ -69,6 +69,40 @@ enum
 
   /*! maximum length of mpr name */
   NHDP_DOMAIN_MPR_MAXLEN = 16,
+
+  /*! number of bits of a domain data slot used as index inside a storage page */
+  NHDP_DOMAIN_PAGE_BITS = 6,
+
+  /*! number of domain data entries in a storage page */
+  NHDP_DOMAIN_PAGE_SIZE = 1 << NHDP_DOMAIN_PAGE_BITS,
+};
+
+/**
+ * Types of NHDP database objects with per-domain data
+ */
+enum nhdp_domain_data_type
+{
+  /*! per-domain data of NHDP links */
+  NHDP_DOMAIN_DATA_LINK,
+
+  /*! per-domain data of NHDP neighbors */
+  NHDP_DOMAIN_DATA_NEIGHBOR,
+
+  /*! per-domain data of NHDP twohop neighbors */
+  NHDP_DOMAIN_DATA_L2HOP,
+
+  /*! number of object types */
+  NHDP_DOMAIN_DATA_COUNT,
+};
+
+/**
+ * Storage for the per-domain data of all NHDP objects of one domain index.
+ * The data of an object is found through its storage slot, the pages are
+ * never moved so pointers to domain data stay valid until the object is removed.
+ */
+struct nhdp_domain_storage {
+  /*! arrays of storage pages, one for each object type */
+  void **pages[NHDP_DOMAIN_DATA_COUNT];
 };
 
 /**
@@ -250,6 +284,21 @@ struct nhdp_domain {
   /*! index in the domain array */
   int index;
 
+  /*! minimum relative change of an incoming link metric (in 1/1000), 0 to disable */
+  uint32_t metric_threshold_relative;
+
+  /*! minimum absolute change of an incoming link metric, 0 to disable */
+  uint32_t metric_threshold_absolute;
+
+  /*! time after the last metric change when any new metric is applied, 0 to disable */
+  uint64_t metric_refresh_interval;
+
+  /*! number of incoming link metric changes suppressed as insignificant */
+  uint64_t metric_suppressed_count;
+
+  /*! storage of the per-domain data of NHDP objects for this domain index */
+  struct nhdp_domain_storage *_storage;
+
   /*! true if MPR should be recalculated */
   bool _mpr_outdated;
 
@@ -307,6 +356,8 @@ EXPORT size_t nhdp_domain_get_count(void);
 EXPORT struct nhdp_domain *nhdp_domain_add(uint8_t ext);
 EXPORT struct nhdp_domain *nhdp_domain_configure(
   uint8_t ext, const char *metric_name, const char *mpr_name, uint8_t willingness);
+EXPORT void nhdp_domain_set_metric_hysteresis(
+  struct nhdp_domain *domain, uint32_t relative, uint32_t absolute, uint64_t refresh_interval);
 
 EXPORT int nhdp_domain_metric_add(struct nhdp_domain_metric *);
 EXPORT void nhdp_domain_metric_remove(struct nhdp_domain_metric *);
@@ -321,9 +372,12 @@ EXPORT void nhdp_domain_metric_postprocessor_add(struct nhdp_domain_metric_postp
 EXPORT void nhdp_domain_metric_postprocessor_remove(struct nhdp_domain_metric_postprocessor *);
 EXPORT struct nhdp_domain *nhdp_domain_get_by_ext(uint8_t);
 
-EXPORT void nhdp_domain_init_link(struct nhdp_link *);
-EXPORT void nhdp_domain_init_l2hop(struct nhdp_l2hop *);
-EXPORT void nhdp_domain_init_neighbor(struct nhdp_neighbor *);
+EXPORT int nhdp_domain_init_link(struct nhdp_link *);
+EXPORT int nhdp_domain_init_l2hop(struct nhdp_l2hop *);
+EXPORT int nhdp_domain_init_neighbor(struct nhdp_neighbor *);
+EXPORT void nhdp_domain_cleanup_link(struct nhdp_link *);
+EXPORT void nhdp_domain_cleanup_l2hop(struct nhdp_l2hop *);
+EXPORT void nhdp_domain_cleanup_neighbor(struct nhdp_neighbor *);
 
 EXPORT void nhdp_domain_process_metric_linktlv(struct nhdp_domain *, struct nhdp_link *lnk, const uint8_t *value);
 EXPORT void nhdp_domain_process_metric_2hoptlv(struct nhdp_domain *d, struct nhdp_l2hop *l2hop, const uint8_t *value);
@@ -332,6 +386,8 @@ EXPORT size_t nhdp_domain_process_mprtypes_tlv(
   uint8_t *mprtypes, size_t mprtypes_size, struct rfc5444_reader_tlvblock_entry *tlv);
 EXPORT void nhdp_domain_process_mpr_tlv(
   uint8_t *mprtypes, size_t mprtypes_size, struct nhdp_link *, struct rfc5444_reader_tlvblock_entry *tlv);
+EXPORT void nhdp_domain_process_mpr_value(
+  uint8_t *mprtypes, size_t mprtypes_size, struct nhdp_link *, const uint8_t *value, size_t length);
 EXPORT void nhdp_domain_process_willingness_tlv(
   uint8_t *mpr_types, size_t mprtypes_size, struct rfc5444_reader_tlvblock_entry *tlv);
 EXPORT void nhdp_domain_store_willingness(struct nhdp_link *);
@@ -342,9 +398,13 @@ EXPORT size_t nhdp_domain_encode_willingness_tlvvalue(uint8_t *tlvvalue, size_t
 EXPORT bool nhdp_domain_set_incoming_metric(
   struct nhdp_domain_metric *metric, struct nhdp_link *lnk, uint32_t metric_in);
 EXPORT bool nhdp_domain_recalculate_metrics(struct nhdp_domain *domain, struct nhdp_neighbor *neigh);
+EXPORT bool nhdp_domain_recalculate_neighbor_metrics(struct nhdp_neighbor *neigh);
+EXPORT void nhdp_domain_trigger_metric_update(struct nhdp_domain *domain, bool changed);
 EXPORT enum nhdp_metric_result nhdp_domain_get_metric(struct nhdp_domain *domain, uint32_t *metric, struct oonf_layer2_neigh *neigh);
 
 EXPORT bool nhdp_domain_node_is_mpr(void);
+EXPORT uint32_t nhdp_domain_get_generation(void);
+EXPORT void nhdp_domain_increase_generation(void);
 EXPORT void nhdp_domain_delayed_mpr_recalculation(struct nhdp_domain *domain, struct nhdp_neighbor *neigh);
 EXPORT void nhdp_domain_recalculate_mpr(void);
 
@@ -361,7 +421,10 @@ EXPORT const struct nhdp_domain *nhdp_domain_get_flooding_domain(void);
  */
 static INLINE struct nhdp_link_domaindata *
 nhdp_domain_get_linkdata(const struct nhdp_domain *domain, struct nhdp_link *lnk) {
-  return &lnk->_domaindata[domain->index];
+  struct nhdp_link_domaindata *page;
+
+  page = domain->_storage->pages[NHDP_DOMAIN_DATA_LINK][lnk->_domain_slot >> NHDP_DOMAIN_PAGE_BITS];
+  return &page[lnk->_domain_slot & (NHDP_DOMAIN_PAGE_SIZE - 1)];
 }
 
 /**
@@ -371,7 +434,10 @@ nhdp_domain_get_linkdata(const struct nhdp_domain *domain, struct nhdp_link *lnk
  */
 static INLINE struct nhdp_neighbor_domaindata *
 nhdp_domain_get_neighbordata(const struct nhdp_domain *domain, struct nhdp_neighbor *neigh) {
-  return &neigh->_domaindata[domain->index];
+  struct nhdp_neighbor_domaindata *page;
+
+  page = domain->_storage->pages[NHDP_DOMAIN_DATA_NEIGHBOR][neigh->_domain_slot >> NHDP_DOMAIN_PAGE_BITS];
+  return &page[neigh->_domain_slot & (NHDP_DOMAIN_PAGE_SIZE - 1)];
 }
 
 /**
@@ -381,7 +447,10 @@ nhdp_domain_get_neighbordata(const struct nhdp_domain *domain, struct nhdp_neigh
  */
 static INLINE struct nhdp_l2hop_domaindata *
 nhdp_domain_get_l2hopdata(const struct nhdp_domain *domain, struct nhdp_l2hop *l2hop) {
-  return &l2hop->_domaindata[domain->index];
+  struct nhdp_l2hop_domaindata *page;
+
+  page = domain->_storage->pages[NHDP_DOMAIN_DATA_L2HOP][l2hop->_domain_slot >> NHDP_DOMAIN_PAGE_BITS];
+  return &page[l2hop->_domain_slot & (NHDP_DOMAIN_PAGE_SIZE - 1)];
 }
 
 /**
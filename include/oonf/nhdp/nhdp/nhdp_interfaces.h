@@ -51,6 +51,7 @@ struct nhdp_interface_addr;
 struct nhdp_interface_domaindata;
 
 #include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/hashmap.h>
 #include <oonf/oonf.h>
 #include <oonf/libcommon/list.h>
 #include <oonf/libcommon/netaddr.h>
@@ -67,6 +68,32 @@ struct nhdp_interface_domaindata;
 /*! memory class for NHDP interface address */
 #define NHDP_CLASS_INTERFACE_ADDRESS "nhdp_iaddr"
 
+/**
+ * Serialized HELLO message of a NHDP interface for one address family
+ */
+struct nhdp_interface_hello_cache {
+  /*! binary HELLO message(s), NULL if nothing was cached */
+  uint8_t *buffer;
+
+  /*! number of used bytes in buffer */
+  size_t length;
+
+  /*! number of allocated bytes in buffer */
+  size_t size;
+
+  /*! generation of NHDP database used to generate the HELLO */
+  uint32_t db_generation;
+
+  /*! generation of NHDP domain data used to generate the HELLO */
+  uint32_t domain_generation;
+
+  /*! MAC address of the interface used to generate the HELLO */
+  struct netaddr mac;
+
+  /*! true if buffer contains a complete HELLO */
+  bool valid;
+};
+
 /**
  * nhdp_interface represents a local interface
  * participating in the mesh network
@@ -105,6 +132,12 @@ struct nhdp_interface {
   /*! variables to store hello validity overwritten by a plugin */
   uint64_t overwrite_hello_validity;
 
+  /*! true if generated hellos should be cached until the NHDP database changes */
+  bool hello_cache;
+
+  /*! minimal interval between a triggered hello and the last one, 0 to disable triggered hellos */
+  uint64_t hello_min_interval;
+
   /*! ACL for interface addresses that should be included into HELLOs */
   struct netaddr_acl ifaddr_filter;
 
@@ -132,6 +165,15 @@ struct nhdp_interface {
   /*! timer for hello generation */
   struct oonf_timer_instance _hello_timer;
 
+  /*! timer for triggered hello generation */
+  struct oonf_timer_instance _trigger_timer;
+
+  /*! timestamp of the last hello sent through this interface */
+  uint64_t _last_hello;
+
+  /*! cached IPv4 and IPv6 hello */
+  struct nhdp_interface_hello_cache _hello_cache[2];
+
   /*! member entry for global interface tree */
   struct avl_node _node;
 
@@ -141,8 +183,8 @@ struct nhdp_interface {
   /*! list of interface nhdp links (nhdp_link objects) */
   struct list_entity _links;
 
-  /*! tree of addresses of links (nhdp_laddr objects) */
-  struct avl_tree _link_addresses;
+  /*! hash index of addresses of links (nhdp_laddr objects) */
+  struct hashmap _link_addresses;
 
   /*! tree of originator addresses of links (nhdp_link objects) */
   struct avl_tree _link_originators;
@@ -193,6 +235,7 @@ EXPORT struct nhdp_interface *nhdp_interface_add(const char *name);
 EXPORT void nhdp_interface_remove(struct nhdp_interface *interf);
 EXPORT void nhdp_interface_apply_settings(struct nhdp_interface *interf);
 EXPORT void nhdp_interface_update_status(struct nhdp_interface *);
+EXPORT void nhdp_interface_trigger_hello(struct nhdp_interface *);
 
 EXPORT struct avl_tree *nhdp_interface_get_tree(void);
 EXPORT struct avl_tree *nhdp_interface_get_address_tree(void);
@@ -288,10 +331,11 @@ nhdp_interface_remove_l2hop(struct nhdp_l2hop *twohop) {
 /**
  * Attach a link address to the local nhdp interface
  * @param laddr NHDP link address
+ * @return -1 if the address is already attached or out of memory, 0 otherwise
  */
-static INLINE void
+static INLINE int
 nhdp_interface_add_laddr(struct nhdp_laddr *laddr) {
-  avl_insert(&laddr->link->local_if->_link_addresses, &laddr->_if_node);
+  return hashmap_insert(&laddr->link->local_if->_link_addresses, &laddr->_if_node);
 }
 
 /**
@@ -300,7 +344,7 @@ nhdp_interface_add_laddr(struct nhdp_laddr *laddr) {
  */
 static INLINE void
 nhdp_interface_remove_laddr(struct nhdp_laddr *laddr) {
-  avl_remove(&laddr->link->local_if->_link_addresses, &laddr->_if_node);
+  hashmap_remove(&laddr->link->local_if->_link_addresses, &laddr->_if_node);
 }
 
 /**
@@ -312,7 +356,7 @@ static INLINE struct nhdp_laddr *
 nhdp_interface_get_link_addr(const struct nhdp_interface *interf, const struct netaddr *addr) {
   struct nhdp_laddr *laddr;
 
-  return avl_find_element(&interf->_link_addresses, addr, laddr, _if_node);
+  return hashmap_find_element(&interf->_link_addresses, addr, laddr, _if_node);
 }
 
 /**
@@ -51,6 +51,7 @@
 
 int nhdp_writer_init(struct oonf_rfc5444_protocol *) __attribute__((warn_unused_result));
 void nhdp_writer_cleanup(void);
+void nhdp_writer_clear_hello_cache(struct nhdp_interface *interf);
 
 EXPORT void nhdp_writer_send_hello(struct nhdp_interface *interf);
 
@@ -57,10 +57,65 @@
 #include <oonf/nhdp/nhdp/nhdp_db.h>
 #include <oonf/nhdp/nhdp/nhdp_domain.h>
 
-/*! minimum time between two dijkstra calculations in milliseconds */
+/*! number of dijkstra runs stored in the history of a domain */
 enum
 {
-  OLSRv2_DIJKSTRA_RATE_LIMITATION = 1000
+  OLSRV2_ROUTING_HISTORY_LENGTH = 16
+};
+
+/**
+ * Reasons for triggering a dijkstra run, used as a bitmask
+ */
+enum olsrv2_routing_cause
+{
+  /*! topology control data changed */
+  OLSRV2_ROUTING_CAUSE_TOPOLOGY = 1 << 0,
+
+  /*! locally attached networks changed */
+  OLSRV2_ROUTING_CAUSE_LAN = 1 << 1,
+
+  /*! MPR set changed */
+  OLSRV2_ROUTING_CAUSE_MPR = 1 << 2,
+
+  /*! NHDP link metrics changed */
+  OLSRV2_ROUTING_CAUSE_METRIC = 1 << 3,
+
+  /*! routing domain configuration changed */
+  OLSRV2_ROUTING_CAUSE_CONFIG = 1 << 4,
+
+  /*! kernel routing table audit or warm restart */
+  OLSRV2_ROUTING_CAUSE_KERNEL = 1 << 5,
+
+  /*! route dampening released a route */
+  OLSRV2_ROUTING_CAUSE_DAMPENING = 1 << 6,
+
+  /*! external trigger */
+  OLSRV2_ROUTING_CAUSE_EXTERNAL = 1 << 7,
+
+  /*! number of defined causes */
+  OLSRV2_ROUTING_CAUSE_COUNT = 8,
+};
+
+/**
+ * buffer for string representation of a set of dijkstra causes
+ */
+struct olsrv2_routing_cause_str {
+  /*! string buffer */
+  char buf[80];
+};
+
+/**
+ * alternative first hop of a node in the dijkstra tree
+ */
+struct olsrv2_dijkstra_nexthop {
+  /*! pointer to nhdp neighbor that represents the first hop */
+  struct nhdp_neighbor *first_hop;
+
+  /*! link cost to the first hop */
+  uint32_t link_cost;
+
+  /*! total path cost through this first hop */
+  uint32_t path_cost;
 };
 
 /**
@@ -85,6 +140,15 @@ struct olsrv2_dijkstra_node {
   /*! pointer to nhpd neighbor that represents the first hop */
   struct nhdp_neighbor *first_hop;
 
+  /*! link cost to the first hop */
+  uint32_t first_hop_cost;
+
+  /*! alternative first hops for equal-cost multipath routes */
+  struct olsrv2_dijkstra_nexthop ecmp[OS_ROUTE_MAX_NEXTHOPS - 1];
+
+  /*! number of alternative first hops */
+  uint8_t ecmp_count;
+
   /**
    * address of the last originator in the routing tree before
    * the destination
@@ -135,9 +199,42 @@ struct olsrv2_routing_entry {
   /*! true if this route is being processed by the kernel at the moment */
   bool in_processing;
 
+  /*! true if next-hop changes of this route are suppressed by dampening */
+  bool suppressed;
+
+  /*! true if route was found in the kernel but not yet calculated by dijkstra */
+  bool adopted;
+
+  /*! true if the current kernel audit has not found this route in the kernel yet */
+  bool _audit_missing;
+
+  /*! true if the current kernel audit found a different kernel route */
+  bool _audit_repair;
+
+  /*! dampening penalty of route, valid at the time of _penalty_time */
+  uint32_t _penalty;
+
+  /*! timestamp of the last penalty update */
+  uint64_t _penalty_time;
+
   /*! old values of route before current dijstra run */
   struct os_route_parameter _old;
 
+  /*! path cost before current dijkstra run */
+  uint32_t _old_path_cost;
+
+  /*! path hops before current dijkstra run */
+  uint8_t _old_path_hops;
+
+  /*! originator of node that announced the route before current dijkstra run */
+  struct netaddr _old_originator;
+
+  /*! originator address of next hop before current dijkstra run */
+  struct netaddr _old_next_originator;
+
+  /*! originator of last hop before target before current dijkstra run */
+  struct netaddr _old_last_originator;
+
   /*! hook into working queues */
   struct list_entity _working_node;
 
@@ -163,6 +260,85 @@ struct olsrv2_routing_domain {
 
   /*! domain uses source specific routing */
   bool source_specific;
+
+  /*! true if next-hop changes of routes should be dampened */
+  bool dampening;
+
+  /*! penalty added to a route for each next-hop change */
+  int32_t dampening_penalty;
+
+  /*! penalty above which next-hop changes of a route are suppressed */
+  int32_t dampening_suppress;
+
+  /*! penalty below which a suppressed route is released again */
+  int32_t dampening_reuse;
+
+  /*! time in milliseconds until the penalty of a route is halved */
+  uint64_t dampening_half_life;
+
+  /*! maximum number of next hops for a route, 1 disables multipath routes */
+  int32_t ecmp_max_paths;
+
+  /*! maximum path cost difference between the best path and an alternative one */
+  int32_t ecmp_tolerance;
+
+  /*! time in milliseconds between the first change and a dijkstra run in a stable network */
+  uint64_t spf_initial_delay;
+
+  /*! minimum time in milliseconds between two dijkstra runs */
+  uint64_t spf_hold;
+
+  /*! maximum time in milliseconds the hold time can grow to during continuous changes */
+  uint64_t spf_max_wait;
+};
+
+/**
+ * statistics of a single dijkstra run
+ */
+struct olsrv2_routing_dijkstra_run {
+  /*! absolute timestamp of the run */
+  uint64_t timestamp;
+
+  /*! time in milliseconds between the first trigger and the run */
+  uint64_t delay;
+
+  /*! hold time in milliseconds until the next run can start */
+  uint64_t hold;
+
+  /*! duration of the run in microseconds */
+  uint64_t duration;
+
+  /*! bitmask of causes that triggered the run */
+  uint32_t causes;
+};
+
+/**
+ * routing domain specific statistics
+ */
+struct olsrv2_routing_statistics {
+  /*! number of next-hop changes sent to the kernel */
+  uint32_t nexthop_changes;
+
+  /*! number of next-hop changes suppressed by route dampening */
+  uint32_t suppressed_changes;
+
+  /*! number of routes currently suppressed by route dampening */
+  uint32_t suppressed_routes;
+
+  /*! number of routes currently using multiple next hops */
+  uint32_t multipath_routes;
+
+  /*! number of kernel routes adopted into the routing set by a kernel audit */
+  uint32_t audit_adopted;
+
+  /*! number of kernel routes repaired by a kernel audit */
+  uint32_t audit_repaired;
+
+  /*! number of dijkstra runs */
+  uint32_t dijkstra_runs;
+
+  /*! ring buffer of the last dijkstra runs, indexed by dijkstra_runs */
+  struct olsrv2_routing_dijkstra_run history[OLSRV2_ROUTING_HISTORY_LENGTH];
 };
 
 /**
@@ -194,12 +370,20 @@ EXPORT void olsrv2_routing_force_ansn_increment(uint16_t increment);
 EXPORT void olsrv2_routing_set_domain_parameter(struct nhdp_domain *domain, struct olsrv2_routing_domain *parameter);
 
 EXPORT void olsrv2_routing_domain_changed(struct nhdp_domain *domain, bool autoupdate_ansn);
+EXPORT void olsrv2_routing_domain_changed_ext(
+  struct nhdp_domain *domain, bool autoupdate_ansn, enum olsrv2_routing_cause cause);
 EXPORT void olsrv2_routing_force_update(bool skip_wait);
 EXPORT void olsrv2_routing_trigger_update(void);
 
 EXPORT void olsrv2_routing_freeze_routes(bool freeze);
+EXPORT void olsrv2_routing_set_kernel_audit(uint64_t interval, uint64_t warm_restart_hold);
 
 EXPORT const struct olsrv2_routing_domain *olsrv2_routing_get_parameters(struct nhdp_domain *);
+EXPORT const struct olsrv2_routing_statistics *olsrv2_routing_get_statistics(struct nhdp_domain *);
+
+EXPORT const struct olsrv2_routing_dijkstra_run *olsrv2_routing_get_dijkstra_run(
+  struct nhdp_domain *domain, uint32_t age);
+EXPORT const char *olsrv2_routing_cause_to_string(struct olsrv2_routing_cause_str *buf, uint32_t causes);
 
 EXPORT struct avl_tree *olsrv2_routing_get_tree(struct nhdp_domain *domain);
 EXPORT struct list_entity *olsrv2_routing_get_filter_list(void);
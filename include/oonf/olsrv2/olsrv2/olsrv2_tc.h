@@ -47,6 +47,7 @@
 #define OLSRV2_TC_H_
 
 #include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/hashmap.h>
 #include <oonf/oonf.h>
 #include <oonf/libcommon/netaddr.h>
 
@@ -138,6 +139,20 @@ struct olsrv2_tc_node {
 
   /*! node for tree of tc_nodes */
   struct avl_node _originator_node;
+
+  /*! node for hash index of tc_nodes */
+  struct hashmap_node _originator_hnode;
+};
+
+/**
+ * key of a tc edge in the global edge index
+ */
+struct olsrv2_tc_edge_key {
+  /*! originator of source node */
+  struct netaddr src;
+
+  /*! originator of destination node */
+  struct netaddr dst;
 };
 
 /**
@@ -167,6 +182,12 @@ struct olsrv2_tc_edge {
 
   /*! node for tree of source node */
   struct avl_node _node;
+
+  /*! key for global edge index */
+  struct olsrv2_tc_edge_key _key;
+
+  /*! node for global edge index */
+  struct hashmap_node _hnode;
 };
 
 /**
@@ -211,12 +232,16 @@ struct olsrv2_tc_endpoint {
 
   /*! node for global tree of endpoints */
   struct avl_node _node;
+
+  /*! node for global hash index of endpoints */
+  struct hashmap_node _hnode;
 };
 
 void olsrv2_tc_init(void);
 void olsrv2_tc_cleanup(void);
 
 EXPORT struct olsrv2_tc_node *olsrv2_tc_node_add(struct netaddr *, uint64_t vtime, uint16_t ansn);
+EXPORT struct olsrv2_tc_node *olsrv2_tc_node_get(const struct netaddr *originator);
 EXPORT void olsrv2_tc_node_remove(struct olsrv2_tc_node *);
 
 EXPORT struct olsrv2_tc_edge *olsrv2_tc_edge_add(struct olsrv2_tc_node *, struct netaddr *);
@@ -230,17 +255,6 @@ void olsrv2_tc_trigger_change(struct olsrv2_tc_node *);
 EXPORT struct avl_tree *olsrv2_tc_get_tree(void);
 EXPORT struct avl_tree *olsrv2_tc_get_endpoint_tree(void);
 
-/**
- * @param originator originator address of a tc node
- * @return pointer to tc node, NULL if not found
- */
-static INLINE struct olsrv2_tc_node *
-olsrv2_tc_node_get(struct netaddr *originator) {
-  struct olsrv2_tc_node *node;
-
-  return avl_find_element(olsrv2_tc_get_tree(), originator, node, _originator_node);
-}
-
 /**
  * @param node pointer to olsrv2 node
  * @return true if node is virtual
@@ -43,16 +43,21 @@
  * @file
  */
 
+#include <stdlib.h>
+
 #include <oonf/libcommon/avl.h>
 #include <oonf/libcommon/avl_comp.h>
 #include <oonf/oonf.h>
+#include <oonf/libcommon/hashmap.h>
 #include <oonf/libcommon/json.h>
 #include <oonf/libcommon/netaddr.h>
+#include <oonf/libcommon/netaddr_lpm.h>
 #include <oonf/libconfig/cfg_schema.h>
 #include <oonf/libconfig/cfg_validate.h>
 #include <oonf/libconfig/cfg_help.h>
 #include <oonf/libcore/oonf_subsystem.h>
 #include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
 #include <oonf/base/os_interface.h>
 
 #include <oonf/base/oonf_layer2.h>
@@ -60,16 +65,63 @@
 /* Definitions */
 #define LOG_LAYER2 _oonf_layer2_subsystem.logging
 
+enum {
+  IDX_HISTORY_DEPTH,
+  IDX_HISTORY,
+};
+
+/**
+ * Configuration of the layer2 database
+ */
+struct _layer2_config {
+  /*! number of samples stored per neighbor and data index */
+  int32_t history_depth;
+};
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
+static void _cb_config_changed(void);
+static int _cb_validate_history(
+  const struct cfg_schema_entry *entry, const char *section_name, const char *value, struct autobuf *out);
 
+static bool _net_commit(struct oonf_layer2_net *l2net);
 static void _net_remove(struct oonf_layer2_net *l2net);
+static bool _neigh_commit(struct oonf_layer2_neigh *l2neigh);
 static void _neigh_remove(struct oonf_layer2_neigh *l2neigh);
+static bool _has_data(const struct oonf_layer2_data *data, size_t count);
+static void _collect_modified_data(struct bitmap256 *modified, struct oonf_layer2_data *data, size_t count);
+static void _history_append(struct oonf_layer2_neigh *l2neigh);
+static void _history_free(struct oonf_layer2_neigh *l2neigh);
+static int64_t _history_select(int64_t *values, size_t count, size_t k);
+
+/* configuration */
+static struct cfg_schema_entry _layer2_entries[] = {
+  [IDX_HISTORY_DEPTH] = CFG_MAP_INT32_MINMAX(_layer2_config, history_depth, "history_depth", "0",
+    "Number of samples stored for each neighbor and history data index, 0 disables the history", 0, 0,
+    OONF_LAYER2_HISTORY_MAX_DEPTH),
+  [IDX_HISTORY] = _CFG_VALIDATE("history",
+    "rx_bitrate\0"
+    "tx_bitrate\0"
+    "latency",
+    "Neighbor data indices with a history of samples, only integer data can be stored",
+    .cb_validate = _cb_validate_history, .cb_valhelp = cfg_schema_help_choice,
+    .validate_param = { { .ptr = oonf_layer2_cfg_get_l2neigh_key }, { .s = OONF_LAYER2_NEIGH_COUNT } }, .list = true),
+};
+
+static struct cfg_schema_section _layer2_section = {
+  .type = OONF_LAYER2_SUBSYSTEM,
+  .mode = CFG_SSMODE_UNNAMED,
+  .help = "Settings for the layer2 database",
+  .cb_delta_handler = _cb_config_changed,
+  .entries = _layer2_entries,
+  .entry_count = ARRAYSIZE(_layer2_entries),
+};
 
 /* subsystem definition */
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
   OONF_OS_INTERFACE_SUBSYSTEM,
 };
 
@@ -79,6 +131,7 @@ static struct oonf_subsystem _oonf_layer2_subsystem = {
   .dependencies_count = ARRAYSIZE(_dependencies),
   .init = _init,
   .cleanup = _cleanup,
+  .cfg_section = &_layer2_section,
 };
 DECLARE_OONF_PLUGIN(_oonf_layer2_subsystem);
 
@@ -191,8 +244,27 @@ static struct avl_tree _local_peer_ips_tree;
 
 static struct avl_tree _lid_tree;
 
+/* longest prefix match index of all remote neighbor IPs */
+static struct netaddr_lpm _remote_ip_lpm;
+
 static uint32_t _lid_originator_count;
 
+/* nesting level of database transactions */
+static uint32_t _transaction_level;
+
+/* networks and neighbors with pending commits during a transaction */
+static struct list_entity _pending_nets;
+static struct list_entity _pending_neighbors;
+
+/* number of samples stored per neighbor and history data index */
+static uint16_t _history_depth;
+
+/* number of neighbor data indices with a history */
+static uint16_t _history_slots;
+
+/* history slot of each neighbor data index, -1 if no history is stored */
+static int8_t _history_slot[OONF_LAYER2_NEIGH_COUNT];
+
 /**
  * Subsystem constructor
  * @return always returns 0
@@ -210,8 +282,16 @@ _init(void) {
   avl_init(&_oonf_originator_tree, avl_comp_strcasecmp, false);
   avl_init(&_local_peer_ips_tree, avl_comp_netaddr, true);
   avl_init(&_lid_tree, avl_comp_netaddr, false);
+  netaddr_lpm_init(&_remote_ip_lpm);
 
   _lid_originator_count = 0;
+  _transaction_level = 0;
+  list_init_head(&_pending_nets);
+  list_init_head(&_pending_neighbors);
+
+  _history_depth = 0;
+  _history_slots = 0;
+  memset(_history_slot, -1, sizeof(_history_slot));
   return 0;
 }
 
@@ -230,6 +310,7 @@ _cleanup(void) {
     avl_remove(&_lid_tree, &lid->_node);
     oonf_class_free(&_lid_class, lid);
   }
+  netaddr_lpm_free(&_remote_ip_lpm);
 
   oonf_class_remove(&_lid_class);
   oonf_class_remove(&_l2neigh_addr_class);
@@ -239,6 +320,89 @@ _cleanup(void) {
   oonf_class_remove(&_l2network_class);
 }
 
+/**
+ * Schema entry validator for the history data indices, only integer
+ * neighbor data can be sampled into the history.
+ * @param entry pointer to schema entry
+ * @param section_name name of section type and name
+ * @param value value of schema entry
+ * @param out pointer to autobuffer for validator output
+ * @return 0 if validation found no problems, -1 otherwise
+ */
+static int
+_cb_validate_history(
+  const struct cfg_schema_entry *entry, const char *section_name, const char *value, struct autobuf *out) {
+  int idx;
+
+  if (cfg_schema_validate_choice(entry, section_name, value, out)) {
+    return -1;
+  }
+
+  idx = cfg_get_choice_index(value, oonf_layer2_cfg_get_l2neigh_key, OONF_LAYER2_NEIGH_COUNT, NULL);
+  if (_metadata_neigh[idx].type != OONF_LAYER2_INTEGER_DATA) {
+    cfg_append_printable_line(out, "Value '%s' for entry '%s' in section %s is %s data, not integer data", value,
+      entry->key.entry, section_name, oonf_layer2_data_get_type_string(&_metadata_neigh[idx]));
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Callback for configuration changes
+ */
+static void
+_cb_config_changed(void) {
+  struct _layer2_config config;
+  struct oonf_layer2_net *l2net;
+  struct oonf_layer2_neigh *l2neigh;
+  const struct const_strarray *array;
+  int8_t slots[OONF_LAYER2_NEIGH_COUNT];
+  uint16_t slot_count, depth;
+  const char *ptr;
+  int idx;
+
+  memset(&config, 0, sizeof(config));
+  if (cfg_schema_tobin(&config, _layer2_section.post, _layer2_entries, ARRAYSIZE(_layer2_entries))) {
+    OONF_WARN(LOG_LAYER2, "Cannot map layer2 config to binary data");
+    return;
+  }
+
+  memset(slots, -1, sizeof(slots));
+  slot_count = 0;
+
+  array = cfg_db_get_schema_entry_value(_layer2_section.post, &_layer2_entries[IDX_HISTORY]);
+  if (array) {
+    strarray_for_each_element(array, ptr) {
+      idx = cfg_get_choice_index(ptr, oonf_layer2_cfg_get_l2neigh_key, OONF_LAYER2_NEIGH_COUNT, NULL);
+      if (idx < 0 || slots[idx] >= 0) {
+        continue;
+      }
+      if (slot_count == OONF_LAYER2_HISTORY_MAX_INDICES) {
+        OONF_WARN(LOG_LAYER2, "Only %d neighbor data indices can have a history, ignoring '%s'",
+          OONF_LAYER2_HISTORY_MAX_INDICES, ptr);
+        continue;
+      }
+      slots[idx] = slot_count++;
+    }
+  }
+
+  depth = slot_count > 0 ? config.history_depth : 0;
+  if (depth == _history_depth && memcmp(slots, _history_slot, sizeof(slots)) == 0) {
+    return;
+  }
+
+  /* layout of the history changed, drop all stored samples */
+  avl_for_each_element(&_oonf_layer2_net_tree, l2net, _node) {
+    avl_for_each_element(&l2net->neighbors, l2neigh, _node) {
+      _history_free(l2neigh);
+    }
+  }
+
+  _history_depth = depth;
+  _history_slots = slot_count;
+  memcpy(_history_slot, slots, sizeof(slots));
+}
+
 /**
  * Register a new data originator number for layer2 data
  * @param origin layer2 originator
@@ -273,6 +437,47 @@ oonf_layer2_origin_remove(struct oonf_layer2_origin *origin) {
   avl_remove(&_oonf_originator_tree, &origin->_node);
 }
 
+/**
+ * Start a transaction of database changes. Commits of layer2 networks
+ * and neighbors will be delayed and coalesced until the transaction is
+ * committed, so each modified object triggers a single change event with
+ * the combined change set. Added and removed events are still triggered
+ * immediately. Transactions can be nested.
+ */
+void
+oonf_layer2_transaction_start(void) {
+  _transaction_level++;
+}
+
+/**
+ * Commit a transaction of database changes. The outermost commit
+ * commits all neighbors and networks modified during the transaction.
+ */
+void
+oonf_layer2_transaction_commit(void) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+
+  if (_transaction_level == 0 || --_transaction_level > 0) {
+    return;
+  }
+
+  /* commit neighbors first, removing them might make a network empty */
+  while (!list_is_empty(&_pending_neighbors)) {
+    l2neigh = list_first_element(&_pending_neighbors, l2neigh, _pending_node);
+    list_remove(&l2neigh->_pending_node);
+
+    _neigh_commit(l2neigh);
+  }
+
+  while (!list_is_empty(&_pending_nets)) {
+    l2net = list_first_element(&_pending_nets, l2net, _pending_node);
+    list_remove(&l2net->_pending_node);
+
+    _net_commit(l2net);
+  }
+}
+
 /**
  * Parse a string into a layer2 data object
  * @param value target buffer for layer2 data
@@ -353,6 +558,8 @@ oonf_layer2_data_set(struct oonf_layer2_data *l2data, const struct oonf_layer2_o
     memcpy(&l2data->_value, input, sizeof(*input));
     l2data->_meta = meta;
     l2data->_origin = origin;
+    l2data->_modified |= changed;
+    l2data->_updated = true;
   }
   return changed;
 }
@@ -517,6 +724,8 @@ oonf_layer2_net_add(const char *ifname) {
   avl_init(&l2net->neighbors, oonf_layer2_avlcmp_neigh_key, false);
   avl_init(&l2net->local_peer_ips, avl_comp_netaddr, false);
   avl_init(&l2net->remote_neighbor_ips, avl_comp_netaddr, true);
+  hashmap_init(&l2net->_neighbor_index, oonf_layer2_hash_neigh_key, oonf_layer2_avlcmp_neigh_key);
+  hashmap_init(&l2net->_remote_ip_index, hashmap_hash_netaddr, avl_comp_netaddr);
 
   /* initialize interface listener */
   l2net->if_listener.name = l2net->name;
@@ -605,34 +814,42 @@ oonf_layer2_net_remove(struct oonf_layer2_net *l2net, const struct oonf_layer2_o
 /**
  * Commit all changes to a layer-2 addr object. This might remove the
  * object from the database if all data has been removed from the object.
+ * The commit will be delayed until the end of a running transaction.
  * @param l2net layer-2 addr object
  * @return true if the object has been removed, false otherwise
  */
 bool
 oonf_layer2_net_commit(struct oonf_layer2_net *l2net) {
-  size_t i;
-
-  if (l2net->neighbors.count > 0) {
-    oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
+  if (_transaction_level > 0) {
+    if (!list_is_node_added(&l2net->_pending_node)) {
+      list_add_tail(&_pending_nets, &l2net->_pending_node);
+    }
     return false;
   }
+  return _net_commit(l2net);
+}
 
-  for (i = 0; i < OONF_LAYER2_NET_COUNT; i++) {
-    if (oonf_layer2_data_has_value(&l2net->data[i])) {
-      oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
-      return false;
-    }
+/**
+ * Commit all changes to a layer-2 addr object
+ * @param l2net layer-2 addr object
+ * @return true if the object has been removed, false otherwise
+ */
+static bool
+_net_commit(struct oonf_layer2_net *l2net) {
+  if (l2net->neighbors.count == 0 && !_has_data(l2net->data, OONF_LAYER2_NET_COUNT) &&
+      !_has_data(l2net->neighdata, OONF_LAYER2_NEIGH_COUNT)) {
+    _net_remove(l2net);
+    return true;
   }
 
-  for (i = 0; i < OONF_LAYER2_NEIGH_COUNT; i++) {
-    if (oonf_layer2_data_has_value(&l2net->neighdata[i])) {
-      oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
-      return false;
-    }
-  }
+  _collect_modified_data(&l2net->modified_data, l2net->data, OONF_LAYER2_NET_COUNT);
+  _collect_modified_data(&l2net->modified_neighdata, l2net->neighdata, OONF_LAYER2_NEIGH_COUNT);
 
-  _net_remove(l2net);
-  return true;
+  l2net->_changeset = true;
+  oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
+  l2net->_changeset = false;
+  l2net->modified = OONF_LAYER2_NET_MODIFY_NONE;
+  return false;
 }
 
 /**
@@ -704,6 +921,7 @@ oonf_layer2_net_add_ip(
     l2addr->_global_node.key = &l2addr->ip;
     avl_insert(&_local_peer_ips_tree, &l2addr->_global_node);
 
+    l2net->modified |= OONF_LAYER2_NET_MODIFY_PEER_IPS;
     oonf_class_event(&_l2net_addr_class, l2addr, OONF_OBJECT_ADDED);
   }
 
@@ -723,6 +941,7 @@ oonf_layer2_net_remove_ip(struct oonf_layer2_peer_address *ip, const struct oonf
     return -1;
   }
 
+  ip->l2net->modified |= OONF_LAYER2_NET_MODIFY_PEER_IPS;
   oonf_class_event(&_l2net_addr_class, ip, OONF_OBJECT_REMOVED);
 
   avl_remove(&ip->l2net->local_peer_ips, &ip->_net_node);
@@ -732,32 +951,16 @@ oonf_layer2_net_remove_ip(struct oonf_layer2_peer_address *ip, const struct oonf
 }
 
 /**
- * Look for the best matching prefix in all layer2 neighbor addresses
+ * Look for the longest prefix in all layer2 neighbor addresses
  * that contains a specific address
  * @param addr ip address to look for
  * @return layer2 neighbor address object, NULL if no match was found
  */
 struct oonf_layer2_neighbor_address *
 oonf_layer2_net_get_best_neighbor_match(const struct netaddr *addr) {
-  struct oonf_layer2_neighbor_address *best_match, *l2addr;
-  struct oonf_layer2_neigh *l2neigh;
-  struct oonf_layer2_net *l2net;
-  int prefix_length;
+  struct oonf_layer2_neighbor_address *best_match;
 
-  prefix_length = 256;
-  best_match = NULL;
-
-  avl_for_each_element(&_oonf_layer2_net_tree, l2net, _node) {
-    avl_for_each_element(&l2net->neighbors, l2neigh, _node) {
-      avl_for_each_element(&l2neigh->remote_neighbor_ips, l2addr, _neigh_node) {
-        if (netaddr_is_in_subnet(&l2addr->ip, addr) && netaddr_get_prefix_length(&l2addr->ip) < prefix_length) {
-          best_match = l2addr;
-          prefix_length = netaddr_get_prefix_length(&l2addr->ip);
-        }
-      }
-    }
-  }
-  return best_match;
+  return netaddr_lpm_find_element(&_remote_ip_lpm, addr, best_match, _lpm_node);
 }
 
 /**
@@ -842,6 +1045,11 @@ oonf_layer2_neigh_add_lid(struct oonf_layer2_net *l2net, const struct oonf_layer
   l2neigh->_node.key = &l2neigh->key;
   l2neigh->network = l2net;
 
+  l2neigh->_index_node.key = &l2neigh->key;
+  if (hashmap_insert(&l2net->_neighbor_index, &l2neigh->_index_node)) {
+    oonf_class_free(&_l2neighbor_class, l2neigh);
+    return NULL;
+  }
   avl_insert(&l2net->neighbors, &l2neigh->_node);
 
   avl_init(&l2neigh->destinations, avl_comp_netaddr, false);
@@ -922,29 +1130,44 @@ oonf_layer2_neigh_remove(struct oonf_layer2_neigh *l2neigh, const struct oonf_la
 /**
  * Commit all changes to a layer-2 neighbor object. This might remove the
  * object from the database if all data has been removed from the object.
+ * The commit will be delayed until the end of a running transaction.
  * @param l2neigh layer-2 neighbor object
  * @return true if the object has been removed, false otherwise
  */
 bool
 oonf_layer2_neigh_commit(struct oonf_layer2_neigh *l2neigh) {
-  size_t i;
-
-  if (l2neigh->destinations.count > 0 || l2neigh->remote_neighbor_ips.count > 0) {
-    oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_CHANGED);
-    l2neigh->modified = OONF_LAYER2_NEIGH_MODIFY_NONE;
+  if (_transaction_level > 0) {
+    if (!list_is_node_added(&l2neigh->_pending_node)) {
+      list_add_tail(&_pending_neighbors, &l2neigh->_pending_node);
+    }
     return false;
   }
+  return _neigh_commit(l2neigh);
+}
 
-  for (i = 0; i < OONF_LAYER2_NEIGH_COUNT; i++) {
-    if (oonf_layer2_data_has_value(&l2neigh->data[i])) {
-      oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_CHANGED);
-      l2neigh->modified = OONF_LAYER2_NEIGH_MODIFY_NONE;
-      return false;
-    }
+/**
+ * Commit all changes to a layer-2 neighbor object
+ * @param l2neigh layer-2 neighbor object
+ * @return true if the object has been removed, false otherwise
+ */
+static bool
+_neigh_commit(struct oonf_layer2_neigh *l2neigh) {
+  if (l2neigh->destinations.count == 0 && l2neigh->remote_neighbor_ips.count == 0 &&
+      !_has_data(l2neigh->data, OONF_LAYER2_NEIGH_COUNT)) {
+    _neigh_remove(l2neigh);
+    return true;
   }
 
-  _neigh_remove(l2neigh);
-  return true;
+  if (_history_depth > 0) {
+    _history_append(l2neigh);
+  }
+  _collect_modified_data(&l2neigh->modified_data, l2neigh->data, OONF_LAYER2_NEIGH_COUNT);
+
+  l2neigh->_changeset = true;
+  oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_CHANGED);
+  l2neigh->_changeset = false;
+  l2neigh->modified = OONF_LAYER2_NEIGH_MODIFY_NONE;
+  return false;
 }
 
 /**
@@ -1044,6 +1267,25 @@ oonf_layer2_neigh_add_ip(
   /* set back reference */
   l2addr->l2neigh = l2neigh;
 
+  /*
+   * the index only contains one object for each IP, the tree might have duplicates.
+   * If another neighbor of the network is indexed with this IP, this object takes
+   * over when the other one is removed.
+   */
+  l2addr->_net_index_node.key = &l2addr->ip;
+  if (oonf_layer2_net_get_remote_ip(l2neigh->network, ip) == NULL
+      && hashmap_insert(&l2neigh->network->_remote_ip_index, &l2addr->_net_index_node)) {
+    OONF_WARN(LOG_LAYER2, "Out of memory for layer2 neighbor IP index");
+    oonf_class_free(&_l2neigh_addr_class, l2addr);
+    return NULL;
+  }
+  if (netaddr_lpm_add(&_remote_ip_lpm, &l2addr->_lpm_node, &l2addr->ip)) {
+    OONF_WARN(LOG_LAYER2, "Out of memory for layer2 neighbor IP prefix index");
+    hashmap_remove(&l2neigh->network->_remote_ip_index, &l2addr->_net_index_node);
+    oonf_class_free(&_l2neigh_addr_class, l2addr);
+    return NULL;
+  }
+
   /* add to tree */
   l2addr->_neigh_node.key = &l2addr->ip;
   avl_insert(&l2neigh->remote_neighbor_ips, &l2addr->_neigh_node);
@@ -1053,6 +1295,7 @@ oonf_layer2_neigh_add_ip(
   /* remember originator */
   l2addr->origin = origin;
 
+  l2neigh->modified |= OONF_LAYER2_NEIGH_MODIFY_REMOTE_IPS;
   oonf_class_event(&_l2neigh_addr_class, l2addr, OONF_OBJECT_ADDED);
   return l2addr;
 }
@@ -1065,14 +1308,28 @@ oonf_layer2_neigh_add_ip(
  */
 int
 oonf_layer2_neigh_remove_ip(struct oonf_layer2_neighbor_address *ip, const struct oonf_layer2_origin *origin) {
+  struct oonf_layer2_neighbor_address *dup;
+
   if (ip->origin != origin) {
     return -1;
   }
 
+  ip->l2neigh->modified |= OONF_LAYER2_NEIGH_MODIFY_REMOTE_IPS;
   oonf_class_event(&_l2neigh_addr_class, ip, OONF_OBJECT_REMOVED);
 
   avl_remove(&ip->l2neigh->remote_neighbor_ips, &ip->_neigh_node);
   avl_remove(&ip->l2neigh->network->remote_neighbor_ips, &ip->_net_node);
+  netaddr_lpm_remove(&_remote_ip_lpm, &ip->_lpm_node);
+
+  if (hashmap_is_node_added(&ip->_net_index_node)) {
+    hashmap_remove(&ip->l2neigh->network->_remote_ip_index, &ip->_net_index_node);
+
+    /* another neighbor of the network might have the same IP */
+    dup = avl_find_element(&ip->l2neigh->network->remote_neighbor_ips, &ip->ip, dup, _net_node);
+    if (dup) {
+      hashmap_insert(&ip->l2neigh->network->_remote_ip_index, &dup->_net_index_node);
+    }
+  }
   oonf_class_free(&_l2neigh_addr_class, ip);
   return 0;
 }
@@ -1111,6 +1368,7 @@ oonf_layer2_destination_add(
   l2dst->_node.key = &l2dst->destination;
   avl_insert(&l2neigh->destinations, &l2dst->_node);
 
+  l2neigh->modified |= OONF_LAYER2_NEIGH_MODIFY_DESTINATIONS;
   oonf_class_event(&_l2dst_class, l2dst, OONF_OBJECT_ADDED);
   return l2dst;
 }
@@ -1124,6 +1382,7 @@ oonf_layer2_destination_remove(struct oonf_layer2_destination *l2dst) {
   if (!avl_is_node_added(&l2dst->_node)) {
     return;
   }
+  l2dst->neighbor->modified |= OONF_LAYER2_NEIGH_MODIFY_DESTINATIONS;
   oonf_class_event(&_l2dst_class, l2dst, OONF_OBJECT_REMOVED);
 
   avl_remove(&l2dst->neighbor->destinations, &l2dst->_node);
@@ -1222,6 +1481,124 @@ oonf_layer2_neigh_get_data(struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_n
   return NULL;
 }
 
+/**
+ * @param idx neighbor data index
+ * @return true if a history of samples is stored for the data index
+ */
+bool
+oonf_layer2_neigh_is_history_index(enum oonf_layer2_neighbor_index idx) {
+  return _history_depth > 0 && _history_slot[idx] >= 0;
+}
+
+/**
+ * Get the number of stored history samples of a neighbor data index
+ * @param l2neigh layer2 neighbor
+ * @param idx neighbor data index
+ * @return number of samples
+ */
+size_t
+oonf_layer2_neigh_get_history_count(const struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx) {
+  if (!l2neigh->_history || _history_slot[idx] < 0) {
+    return 0;
+  }
+  return l2neigh->_history->count[_history_slot[idx]];
+}
+
+/**
+ * Get a sample of the history of a neighbor data index
+ * @param value pointer to buffer for sample value
+ * @param timestamp pointer to buffer for absolute sample timestamp, might be NULL
+ * @param l2neigh layer2 neighbor
+ * @param idx neighbor data index
+ * @param n number of the sample, 0 is the newest one
+ * @return -1 if the sample does not exist, 0 otherwise
+ */
+int
+oonf_layer2_neigh_get_history_sample(int64_t *value, uint64_t *timestamp, const struct oonf_layer2_neigh *l2neigh,
+  enum oonf_layer2_neighbor_index idx, size_t n) {
+  const struct oonf_layer2_history *history;
+  uint64_t now;
+  size_t pos;
+  int slot;
+
+  history = l2neigh->_history;
+  slot = _history_slot[idx];
+  if (!history || slot < 0 || n >= history->count[slot]) {
+    return -1;
+  }
+
+  pos = (size_t)slot * history->depth + (history->next[slot] + history->depth - 1u - n) % history->depth;
+  *value = history->values[pos];
+
+  if (timestamp) {
+    /* timestamps are stored with 32 bit, the unsigned difference survives a wrap-around */
+    now = oonf_clock_getNow();
+    *timestamp = now - (uint32_t)((uint32_t)now - history->timestamps[pos]);
+  }
+  return 0;
+}
+
+/**
+ * Aggregate the history samples of a neighbor data index
+ * @param stats pointer to buffer for aggregated values
+ * @param l2neigh layer2 neighbor
+ * @param idx neighbor data index
+ * @param window maximum age of samples in milliseconds, 0 to use all samples
+ * @param percentile percentile (0-100) to calculate
+ * @return -1 if no sample is available, 0 otherwise
+ */
+int
+oonf_layer2_neigh_get_history_stats(struct oonf_layer2_history_stats *stats, const struct oonf_layer2_neigh *l2neigh,
+  enum oonf_layer2_neighbor_index idx, uint64_t window, uint32_t percentile) {
+  int64_t values[OONF_LAYER2_HISTORY_MAX_DEPTH];
+  int64_t sum;
+  uint64_t timestamp, now;
+  size_t i, count, k;
+
+  memset(stats, 0, sizeof(*stats));
+
+  now = oonf_clock_getNow();
+  count = oonf_layer2_neigh_get_history_count(l2neigh, idx);
+  sum = 0;
+
+  for (i = 0; i < count; i++) {
+    if (oonf_layer2_neigh_get_history_sample(&values[i], &timestamp, l2neigh, idx, i)) {
+      break;
+    }
+    if (window > 0 && now - timestamp > window) {
+      /* samples are stored in chronological order */
+      break;
+    }
+
+    if (i == 0 || values[i] < stats->min) {
+      stats->min = values[i];
+    }
+    if (i == 0 || values[i] > stats->max) {
+      stats->max = values[i];
+    }
+    sum += values[i];
+  }
+
+  if (i == 0) {
+    return -1;
+  }
+
+  if (percentile > 100) {
+    percentile = 100;
+  }
+
+  /* nearest rank */
+  k = (percentile * i + 99u) / 100u;
+  if (k > 0) {
+    k--;
+  }
+
+  stats->count = i;
+  stats->avg = sum / (int64_t)i;
+  stats->percentile = _history_select(values, i, k);
+  return 0;
+}
+
 /**
  * get neighbor metric metadata
  * @param idx neighbor metric index
@@ -1392,6 +1769,16 @@ oonf_layer2_avlcmp_neigh_key(const void *p1, const void *p2) {
   return memcmp(k1, k2, sizeof(*k1));
 }
 
+/**
+ * Calculates the hash value of a layer2 neighbor key
+ * @param key pointer to neighbor key
+ * @return hash value of key
+ */
+uint32_t
+oonf_layer2_hash_neigh_key(const void *key) {
+  return hashmap_hash_bytes(key, sizeof(struct oonf_layer2_neigh_key));
+}
+
 /**
  * Converts a layer2 neighbor key into a string representation
  * @param buf buffer for output string
@@ -1504,14 +1891,165 @@ _net_remove(struct oonf_layer2_net *l2net) {
 
   oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_REMOVED);
 
+  /* drop pending commit of transaction */
+  if (list_is_node_added(&l2net->_pending_node)) {
+    list_remove(&l2net->_pending_node);
+  }
+
   /* remove interface listener */
   os_interface_remove(&l2net->if_listener);
 
   /* free addr */
   avl_remove(&_oonf_layer2_net_tree, &l2net->_node);
+  hashmap_free(&l2net->_neighbor_index);
+  hashmap_free(&l2net->_remote_ip_index);
   oonf_class_free(&_l2network_class, l2net);
 }
 
+/**
+ * @param data array of layer2 data objects
+ * @param count number of objects in array
+ * @return true if at least one object has a value
+ */
+static bool
+_has_data(const struct oonf_layer2_data *data, size_t count) {
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    if (oonf_layer2_data_has_value(&data[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Collect the indices of all changed layer2 data objects of an
+ * array into a bitmap and reset their modification and update flags
+ * @param modified bitmap for modified indices
+ * @param data array of layer2 data objects
+ * @param count number of objects in array
+ */
+static void
+_collect_modified_data(struct bitmap256 *modified, struct oonf_layer2_data *data, size_t count) {
+  size_t i;
+
+  memset(modified, 0, sizeof(*modified));
+  for (i = 0; i < count; i++) {
+    if (data[i]._modified) {
+      bitmap256_set(modified, i);
+      data[i]._modified = false;
+    }
+    data[i]._updated = false;
+  }
+}
+
+/**
+ * Append the values of all history data indices of a neighbor that have
+ * been set since the last commit to its history, allocates the history
+ * on first use. Setting the same value again records a new sample, so
+ * a stable link still produces a time series.
+ * @param l2neigh layer-2 neighbor object
+ */
+static void
+_history_append(struct oonf_layer2_neigh *l2neigh) {
+  struct oonf_layer2_history *history;
+  uint32_t now;
+  size_t i, pos, samples;
+  int slot;
+
+  history = l2neigh->_history;
+  now = (uint32_t)oonf_clock_getNow();
+
+  for (i = 0; i < OONF_LAYER2_NEIGH_COUNT; i++) {
+    slot = _history_slot[i];
+    if (slot < 0 || !l2neigh->data[i]._updated || !oonf_layer2_data_has_value(&l2neigh->data[i])) {
+      continue;
+    }
+
+    if (!history) {
+      samples = (size_t)_history_slots * _history_depth;
+      history = calloc(1, sizeof(*history) + samples * (sizeof(int64_t) + sizeof(uint32_t)));
+      if (!history) {
+        OONF_WARN(LOG_LAYER2, "Not enough memory for layer2 neighbor history");
+        return;
+      }
+
+      history->depth = _history_depth;
+      history->slots = _history_slots;
+      history->values = (int64_t *)(history + 1);
+      history->timestamps = (uint32_t *)(history->values + samples);
+      l2neigh->_history = history;
+    }
+
+    pos = (size_t)slot * history->depth + history->next[slot];
+    history->values[pos] = l2neigh->data[i]._value.integer;
+    history->timestamps[pos] = now;
+
+    history->next[slot] = (history->next[slot] + 1u) % history->depth;
+    if (history->count[slot] < history->depth) {
+      history->count[slot]++;
+    }
+  }
+}
+
+/**
+ * Free the history of a layer-2 neighbor
+ * @param l2neigh layer-2 neighbor object
+ */
+static void
+_history_free(struct oonf_layer2_neigh *l2neigh) {
+  free(l2neigh->_history);
+  l2neigh->_history = NULL;
+}
+
+/**
+ * Select the k-th smallest element of an array, the array will
+ * be reordered in the process
+ * @param values array of values
+ * @param count number of values in array
+ * @param k index of the value in the sorted array
+ * @return k-th smallest value
+ */
+static int64_t
+_history_select(int64_t *values, size_t count, size_t k) {
+  size_t left, right, i, store;
+  int64_t pivot, tmp;
+
+  left = 0;
+  right = count - 1;
+  while (left < right) {
+    /* move middle element as pivot to the end */
+    i = left + (right - left) / 2;
+    pivot = values[i];
+    values[i] = values[right];
+    values[right] = pivot;
+
+    store = left;
+    for (i = left; i < right; i++) {
+      if (values[i] < pivot) {
+        tmp = values[i];
+        values[i] = values[store];
+        values[store] = tmp;
+        store++;
+      }
+    }
+    values[right] = values[store];
+    values[store] = pivot;
+
+    if (store == k) {
+      return pivot;
+    }
+    if (k < store) {
+      right = store - 1;
+    }
+    else {
+      left = store + 1;
+    }
+  }
+  return values[k];
+}
+
 /**
  * Removes a layer-2 neighbor object from the database
  * @param l2neigh layer-2 neighbor object
@@ -1534,7 +2072,14 @@ _neigh_remove(struct oonf_layer2_neigh *l2neigh) {
   /* inform user that mac entry will be removed */
   oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_REMOVED);
 
+  /* drop pending commit of transaction */
+  if (list_is_node_added(&l2neigh->_pending_node)) {
+    list_remove(&l2neigh->_pending_node);
+  }
+
   /* free resources for mac entry */
   avl_remove(&l2neigh->network->neighbors, &l2neigh->_node);
+  hashmap_remove(&l2neigh->network->_neighbor_index, &l2neigh->_index_node);
+  _history_free(l2neigh);
   oonf_class_free(&_l2neighbor_class, l2neigh);
 }
@@ -406,6 +406,31 @@ oonf_rfc5444_send_if(struct oonf_rfc5444_target *target, uint8_t msgid)
     &target->interface->protocol->writer, msgid, addr_len, _cb_single_target_selector, target);
 }
 
+/**
+ * Send a previously generated binary RFC5444 message through a specific interface
+ * @param target interface for outgoing message
+ * @param msg pointer to binary message
+ * @param len length of binary message
+ * @return return code of rfc5444 writer
+ */
+enum rfc5444_result
+oonf_rfc5444_send_if_binary(struct oonf_rfc5444_target *target, const uint8_t *msg, size_t len)
+{
+#ifdef OONF_LOG_INFO
+  struct netaddr_str buf;
+#endif
+
+  /* check if socket can send data */
+  if (!oonf_rfc5444_is_target_active(target)) {
+    return RFC5444_OKAY;
+  }
+
+  OONF_INFO(LOG_RFC5444, "Add binary message id %d for protocol %s/target %s on interface %s", msg[0],
+    target->interface->protocol->name, netaddr_to_string(&buf, &target->dst), target->interface->name);
+
+  return rfc5444_writer_add_binary_msg(&target->interface->protocol->writer, &target->rfc5444_target, msg, len);
+}
+
 /**
  * Trigger the creation of a RFC5444 message for a group of interfaces
  * @param protocol protocol for outgoing message
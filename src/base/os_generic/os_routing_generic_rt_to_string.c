@@ -71,12 +71,12 @@ os_routing_generic_rt_to_string(struct os_route_str *buf, const struct os_route_
   char ifbuf[IF_NAMESIZE];
   int result;
   result = snprintf(buf->buf, sizeof(*buf),
-    "'src-ip %s gw %s dst %s %s src-prefix %s metric %d table %u protocol %u if %s (%u)'",
+    "'src-ip %s gw %s dst %s %s src-prefix %s metric %d table %u protocol %u if %s (%u) multipath %u'",
     netaddr_to_string(&buf1, &route_parameter->src_ip), netaddr_to_string(&buf2, &route_parameter->gw),
     _route_types[route_parameter->type], netaddr_to_string(&buf3, &route_parameter->key.dst),
     netaddr_to_string(&buf4, &route_parameter->key.src), route_parameter->metric,
     (unsigned int)(route_parameter->table), (unsigned int)(route_parameter->protocol),
-    if_indextoname(route_parameter->if_index, ifbuf), route_parameter->if_index);
+    if_indextoname(route_parameter->if_index, ifbuf), route_parameter->if_index, route_parameter->multipath_count);
 
   if (result < 0 || result > (int)sizeof(*buf)) {
     return NULL;
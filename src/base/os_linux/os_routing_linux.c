@@ -79,6 +79,8 @@ static int _init(void);
 static void _cleanup(void);
 
 static int _routing_set(struct nlmsghdr *msg, struct os_route *route, unsigned char rt_scope);
+static int _routing_set_multipath(struct nlmsghdr *msg, struct os_route *route);
+static void _routing_parse_multipath(struct os_route *route, struct rtattr *rt_attr);
 
 static void _routing_finished(struct os_route *route, int error);
 static void _cb_rtnetlink_message(struct nlmsghdr *);
@@ -235,8 +237,9 @@ os_routing_linux_set(struct os_route *route, bool set, bool del_similar) {
     netaddr_invalidate(&os_rt.p.src_ip);
 
     if (del_similar) {
-      /* no interface necessary */
+      /* no interface or multipath next hops necessary */
       os_rt.p.if_index = 0;
+      os_rt.p.multipath_count = 0;
 
       /* as wildcard for fuzzy deletion */
       scope = RT_SCOPE_NOWHERE;
@@ -434,7 +437,13 @@ _routing_set(struct nlmsghdr *msg, struct os_route *route, unsigned char rt_scop
     }
   }
 
-  if (netaddr_get_address_family(&route->p.gw) != AF_UNSPEC) {
+  if (route->p.multipath_count > 0 && netaddr_get_address_family(&route->p.gw) != AF_UNSPEC) {
+    /* add all next hops including the primary one */
+    if (_routing_set_multipath(msg, route)) {
+      return -1;
+    }
+  }
+  else if (netaddr_get_address_family(&route->p.gw) != AF_UNSPEC) {
     rt_msg->rtm_flags |= RTNH_F_ONLINK;
 
     /* add gateway */
@@ -469,7 +478,7 @@ _routing_set(struct nlmsghdr *msg, struct os_route *route, unsigned char rt_scop
     }
   }
 
-  if (route->p.if_index) {
+  if (route->p.if_index && route->p.multipath_count == 0) {
     /* add interface*/
     if (os_system_linux_netlink_addreq(
           &_rtnetlink_socket, msg, RTA_OIF, &route->p.if_index, sizeof(route->p.if_index))) {
@@ -479,6 +488,99 @@ _routing_set(struct nlmsghdr *msg, struct os_route *route, unsigned char rt_scop
   return 0;
 }
 
+/**
+ * Add a RTA_MULTIPATH attribute with all next hops of a route
+ * to a netlink message
+ * @param msg pointer to netlink message header
+ * @param route route with multipath next hops
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_routing_set_multipath(struct nlmsghdr *msg, struct os_route *route) {
+  uint8_t buffer[OS_ROUTE_MAX_NEXTHOPS * RTNH_ALIGN(sizeof(struct rtnexthop) + RTA_SPACE(16))];
+  const struct netaddr *gw;
+  struct rtnexthop *rtnh;
+  struct rtattr *rt_attr;
+  unsigned int if_index;
+  size_t len, addr_len;
+  unsigned int i;
+
+  memset(buffer, 0, sizeof(buffer));
+  len = 0;
+
+  for (i = 0; i <= route->p.multipath_count && i < OS_ROUTE_MAX_NEXTHOPS; i++) {
+    if (i == 0) {
+      gw = &route->p.gw;
+      if_index = route->p.if_index;
+    }
+    else {
+      gw = &route->p.multipath[i - 1].gw;
+      if_index = route->p.multipath[i - 1].if_index;
+    }
+
+    if (netaddr_get_address_family(gw) != route->p.family) {
+      return -1;
+    }
+    addr_len = netaddr_get_binlength(gw);
+
+    rtnh = (struct rtnexthop *)&buffer[len];
+    rtnh->rtnh_len = RTNH_LENGTH(RTA_LENGTH(addr_len));
+    rtnh->rtnh_flags = RTNH_F_ONLINK;
+    rtnh->rtnh_hops = 0;
+    rtnh->rtnh_ifindex = if_index;
+
+    rt_attr = RTNH_DATA(rtnh);
+    rt_attr->rta_type = RTA_GATEWAY;
+    rt_attr->rta_len = RTA_LENGTH(addr_len);
+    netaddr_to_binary(RTA_DATA(rt_attr), gw, addr_len);
+
+    len += RTNH_ALIGN(rtnh->rtnh_len);
+  }
+
+  return os_system_linux_netlink_addreq(&_rtnetlink_socket, msg, RTA_MULTIPATH, buffer, len);
+}
+
+/**
+ * Parse a RTA_MULTIPATH attribute into the next hops of an os_route object
+ * @param route pointer to target os_route
+ * @param rt_attr pointer to multipath attribute
+ */
+static void
+_routing_parse_multipath(struct os_route *route, struct rtattr *rt_attr) {
+  struct os_route_nexthop *nexthop;
+  struct rtnexthop *rtnh;
+  struct rtattr *nh_attr;
+  int rtnh_len, attr_len;
+
+  rtnh = RTA_DATA(rt_attr);
+  rtnh_len = RTA_PAYLOAD(rt_attr);
+
+  for (; RTNH_OK(rtnh, rtnh_len); rtnh_len -= RTNH_ALIGN(rtnh->rtnh_len), rtnh = RTNH_NEXT(rtnh)) {
+    if (route->p.if_index == 0) {
+      /* first next hop is stored as the primary one */
+      route->p.if_index = rtnh->rtnh_ifindex;
+      nexthop = NULL;
+    }
+    else if (route->p.multipath_count < OS_ROUTE_MAX_NEXTHOPS - 1) {
+      nexthop = &route->p.multipath[route->p.multipath_count++];
+      nexthop->if_index = rtnh->rtnh_ifindex;
+    }
+    else {
+      OONF_DEBUG(LOG_OS_ROUTING, "Ignore additional next hops of multipath route");
+      return;
+    }
+
+    nh_attr = RTNH_DATA(rtnh);
+    attr_len = rtnh->rtnh_len - sizeof(*rtnh);
+    for (; RTA_OK(nh_attr, attr_len); nh_attr = RTA_NEXT(nh_attr, attr_len)) {
+      if (nh_attr->rta_type == RTA_GATEWAY) {
+        netaddr_from_binary(nexthop ? &nexthop->gw : &route->p.gw, RTA_DATA(nh_attr), RTA_PAYLOAD(nh_attr),
+          route->p.family);
+      }
+    }
+  }
+}
+
 /**
  * Parse a rtnetlink header into a os_route object
  * @param route pointer to target os_route
@@ -549,6 +651,9 @@ _routing_parse_nlmsg(struct os_route *route, struct nlmsghdr *msg) {
       case RTA_OIF:
         memcpy(&route->p.if_index, RTA_DATA(rt_attr), sizeof(route->p.if_index));
         break;
+      case RTA_MULTIPATH:
+        _routing_parse_multipath(route, rt_attr);
+        break;
       default:
         break;
     }
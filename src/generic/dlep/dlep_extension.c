@@ -259,6 +259,8 @@ dlep_extension_router_process_destination(struct dlep_extension *ext, struct dle
     OONF_INFO(session->log_source, "tlv mapping for extension %d failed: %d", ext->id, result);
     return DLEP_NEW_PARSER_UNSUPPORTED_TLV;
   }
+
+  oonf_layer2_neigh_commit(l2neigh);
   return DLEP_NEW_PARSER_OKAY;
 }
 
@@ -356,13 +358,8 @@ dlep_extension_radio_write_session_update(
     return -1;
   }
 
-  result = dlep_writer_map_l2neigh_data(&session->writer, ext, l2net->neighdata, NULL);
-  if (result) {
-    OONF_WARN(session->log_source, "tlv mapping for extension %d failed: %d", ext->id, result);
-    return result;
-  }
-
-  result = dlep_writer_map_l2net_data(&session->writer, ext, l2net->data);
+  /* only transport the values changed by the current layer2 commit */
+  result = dlep_writer_map_l2net_changes(&session->writer, ext, l2net);
   if (result) {
     OONF_WARN(session->log_source, "tlv mapping for extension %d failed: %d", ext->id, result);
     return result;
@@ -404,6 +401,41 @@ dlep_extension_radio_write_destination(
   return 0;
 }
 
+/**
+ * Generate destination update for DLEP extension by automatically
+ * mapping the oonf_layer2_data changed by the current layer2 commit
+ * to DLEP TLVs
+ * @param ext dlep extension
+ * @param session dlep session
+ * @param neigh neighbor that should be updated
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+dlep_extension_radio_write_destination_update(
+  struct dlep_extension *ext, struct dlep_session *session, const struct oonf_layer2_neigh_key *neigh) {
+  struct oonf_layer2_neigh *l2neigh;
+  union oonf_layer2_neigh_key_str nbuf;
+  int result;
+
+  l2neigh = dlep_session_get_local_l2_neighbor(session, neigh);
+  if (!l2neigh) {
+    OONF_WARN(session->log_source,
+      "Could not find l2neigh "
+      "for neighbor %s",
+      oonf_layer2_neigh_key_to_string(&nbuf, neigh, true));
+    return -1;
+  }
+
+  result = dlep_writer_map_l2neigh_changes(&session->writer, ext, l2neigh);
+  if (result) {
+    OONF_WARN(session->log_source,
+      "tlv mapping for extension %d and neighbor %s failed: %d",
+      ext->id, oonf_layer2_neigh_key_to_string(&nbuf, neigh, true), result);
+    return result;
+  }
+  return 0;
+}
+
 /**
  * Handle peer update and session init ACK for DLEP extension
  * by automatically mapping oonf_layer2_data to DLEP TLVs
@@ -433,5 +465,7 @@ _process_interface_specific_update(struct dlep_extension *ext, struct dlep_sessi
     OONF_INFO(session->log_source, "tlv mapping for extension %d failed: %d", ext->id, result);
     return DLEP_NEW_PARSER_UNSUPPORTED_TLV;
   }
+
+  oonf_layer2_net_commit(l2net);
   return DLEP_NEW_PARSER_OKAY;
 }
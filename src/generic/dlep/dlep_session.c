@@ -320,7 +320,8 @@ dlep_session_process_tcp(struct oonf_stream_session *tcp_session, struct dlep_se
 }
 
 /**
- * Process the content of a buffer as DLEP signal(s)
+ * Process the content of a buffer as DLEP signal(s). All layer2
+ * database changes of the buffer are committed in a single transaction.
  * @param session dlep session
  * @param buffer pointer to buffer
  * @param length length of buffer
@@ -339,6 +340,8 @@ dlep_session_process_buffer(struct dlep_session *session, const void *buffer, si
     "Processing buffer of"
     " %" PRINTF_SIZE_T_SPECIFIER " bytes",
     length);
+
+  oonf_layer2_transaction_start();
   while (length > 0) {
     OONF_DEBUG(session->log_source,
       "Processing message at offset"
@@ -347,17 +350,18 @@ dlep_session_process_buffer(struct dlep_session *session, const void *buffer, si
 
     if ((result = dlep_session_process_signal(session, &ptr[offset], length, is_udp)) <= 0) {
       if (result < 0) {
-        return result;
+        offset = result;
       }
       break;
     }
 
     if (session->restrict_signal == DLEP_KILL_SESSION) {
-      return offset;
+      break;
     }
     length -= result;
     offset += result;
   }
+  oonf_layer2_transaction_commit();
   return offset;
 }
 
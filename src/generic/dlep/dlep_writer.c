@@ -471,6 +471,43 @@ dlep_writer_map_l2neigh_data(
   return 0;
 }
 
+/**
+ * Automatically map the predefined metric values of an
+ * extension for layer2 neighbor data that have been changed
+ * by the current layer2 commit to DLEP TLVs. Outside of a layer2
+ * neighbor change event all values are mapped.
+ * @param writer dlep writer
+ * @param ext dlep extension
+ * @param l2neigh layer2 neighbor
+ * @return 0 if everything worked fine, negative index
+ *   (minus 1) of the conversion that failed.
+ */
+int
+dlep_writer_map_l2neigh_changes(
+  struct dlep_writer *writer, struct dlep_extension *ext, struct oonf_layer2_neigh *l2neigh) {
+  struct dlep_neighbor_mapping *map;
+  struct oonf_layer2_data *ptr;
+  size_t i;
+
+  for (i = 0; i < ext->neigh_mapping_count; i++) {
+    map = &ext->neigh_mapping[i];
+
+    if (!oonf_layer2_neigh_is_data_modified(l2neigh, map->layer2)) {
+      continue;
+    }
+
+    ptr = &l2neigh->data[map->layer2];
+    if (!oonf_layer2_data_has_value(ptr)) {
+      ptr = &l2neigh->network->neighdata[map->layer2];
+    }
+
+    if (map->to_tlv(writer, ptr, oonf_layer2_neigh_metadata_get(map->layer2), map->dlep, map->length, map->scaling)) {
+      return -(i + 1);
+    }
+  }
+  return 0;
+}
+
 /**
  * Automatically map all predefined metric values of an
  * extension for layer2 network data from the layer2
@@ -495,3 +532,47 @@ dlep_writer_map_l2net_data(struct dlep_writer *writer, struct dlep_extension *ex
   }
   return 0;
 }
+
+/**
+ * Automatically map the predefined neighbor default and network
+ * values of an extension that have been changed by the current
+ * layer2 commit to DLEP TLVs. Outside of a layer2 network change
+ * event all values are mapped.
+ * @param writer dlep writer
+ * @param ext dlep extension
+ * @param l2net layer2 network
+ * @return 0 if everything worked fine, negative index
+ *   (minus 1) of the conversion that failed.
+ */
+int
+dlep_writer_map_l2net_changes(
+  struct dlep_writer *writer, struct dlep_extension *ext, struct oonf_layer2_net *l2net) {
+  struct dlep_neighbor_mapping *neigh_map;
+  struct dlep_network_mapping *net_map;
+  size_t i;
+
+  for (i = 0; i < ext->neigh_mapping_count; i++) {
+    neigh_map = &ext->neigh_mapping[i];
+
+    if (!oonf_layer2_net_is_neighdata_modified(l2net, neigh_map->layer2)) {
+      continue;
+    }
+    if (neigh_map->to_tlv(writer, &l2net->neighdata[neigh_map->layer2],
+          oonf_layer2_neigh_metadata_get(neigh_map->layer2), neigh_map->dlep, neigh_map->length, neigh_map->scaling)) {
+      return -(i + 1);
+    }
+  }
+
+  for (i = 0; i < ext->if_mapping_count; i++) {
+    net_map = &ext->if_mapping[i];
+
+    if (!oonf_layer2_net_is_data_modified(l2net, net_map->layer2)) {
+      continue;
+    }
+    if (net_map->to_tlv(writer, &l2net->data[net_map->layer2], oonf_layer2_net_metadata_get(net_map->layer2),
+          net_map->dlep, net_map->length, net_map->scaling)) {
+      return -(ext->neigh_mapping_count + i + 1);
+    }
+  }
+  return 0;
+}
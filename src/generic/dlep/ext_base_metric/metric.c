@@ -136,7 +136,7 @@ static struct dlep_extension_signal _signals[] = {
     .supported_tlv_count = ARRAYSIZE(_dst_tlvs),
     .mandatory_tlvs = _dst_mandatory,
     .mandatory_tlv_count = ARRAYSIZE(_dst_mandatory),
-    .add_radio_tlvs = dlep_extension_radio_write_destination,
+    .add_radio_tlvs = dlep_extension_radio_write_destination_update,
     .process_router = dlep_extension_router_process_destination,
   },
 };
@@ -558,12 +558,17 @@ _l2_neigh_changed(
   struct dlep_radio_if *radio_if;
   struct dlep_radio_session *radio_session;
   struct dlep_local_neighbor *local;
+  bool update;
 
   radio_if = dlep_radio_get_by_layer2_if(l2neigh->network->name);
   if (!radio_if) {
     return;
   }
 
+  /* only data and IP changes of a commit are transported by a destination update */
+  update = !oonf_layer2_neigh_has_changeset(l2neigh) || !bitmap256_is_empty(&l2neigh->modified_data) ||
+           oonf_layer2_neigh_is_modified(l2neigh, OONF_LAYER2_NEIGH_MODIFY_REMOTE_IPS);
+
   avl_for_each_element(&radio_if->interf.session_tree, radio_session, _node) {
     if (l2dest && !radio_session->session.cfg.send_proxied) {
       continue;
@@ -579,10 +584,12 @@ _l2_neigh_changed(
 
       switch (local->state) {
         case DLEP_NEIGHBOR_UP_SENT:
-          local->changed = true;
+          local->changed |= update;
           break;
         case DLEP_NEIGHBOR_UP_ACKED:
-          dlep_session_generate_signal(&radio_session->session, DLEP_DESTINATION_UPDATE, mac);
+          if (update) {
+            dlep_session_generate_signal(&radio_session->session, DLEP_DESTINATION_UPDATE, mac);
+          }
           local->changed = false;
           break;
         case DLEP_NEIGHBOR_IDLE:
@@ -649,6 +656,13 @@ _cb_l2_net_changed(void *ptr) {
 
   l2net = ptr;
 
+  /* only data and peer IP changes of a commit are transported by a session update */
+  if (oonf_layer2_net_has_changeset(l2net) && bitmap256_is_empty(&l2net->modified_data) &&
+      bitmap256_is_empty(&l2net->modified_neighdata) &&
+      !oonf_layer2_net_is_modified(l2net, OONF_LAYER2_NET_MODIFY_PEER_IPS)) {
+    return;
+  }
+
   radio_if = dlep_radio_get_by_layer2_if(l2net->name);
   if (!radio_if) {
     return;
@@ -392,6 +392,7 @@ _router_process_session_init_ack(struct dlep_extension *ext __attribute__((unuse
     OONF_INFO(session->log_source, "tlv mapping failed for extension %u: %u", ext->id, result);
     return DLEP_NEW_PARSER_INTERNAL_ERROR;
   }
+  oonf_layer2_net_commit(l2net);
 
   OONF_DEBUG(session->log_source, "Remote heartbeat interval %" PRIu64, session->remote_heartbeat_interval);
 
@@ -426,6 +427,7 @@ _router_process_session_update(struct dlep_extension *ext __attribute__((unused)
     OONF_INFO(session->log_source, "tlv mapping failed for extension %u: %u", ext->id, result);
     return DLEP_NEW_PARSER_INTERNAL_ERROR;
   }
+  oonf_layer2_net_commit(l2net);
 
   /* generate ACK */
   if (dlep_session_generate_signal_status(session, DLEP_SESSION_UPDATE_ACK, NULL, DLEP_STATUS_OKAY, "Success")) {
@@ -489,6 +491,7 @@ _router_process_destination_up(struct dlep_extension *ext __attribute__((unused)
     OONF_INFO(session->log_source, "tlv mapping failed for extension %u: %u", ext->id, result);
     return DLEP_NEW_PARSER_INTERNAL_ERROR;
   }
+  oonf_layer2_neigh_commit(l2neigh);
 
   /* generate ACK */
   if (dlep_session_generate_signal_status (session, DLEP_DESTINATION_UP_ACK, &mac_lid, DLEP_STATUS_OKAY, "Success")) {
@@ -590,6 +593,7 @@ _router_process_destination_update(struct dlep_extension *ext __attribute__((unu
     OONF_INFO(session->log_source, "tlv mapping failed for extension %u: %u", ext->id, result);
     return DLEP_NEW_PARSER_INTERNAL_ERROR;
   }
+  oonf_layer2_neigh_commit(l2neigh);
 
   return DLEP_NEW_PARSER_OKAY;
 }
@@ -46,6 +46,7 @@
 #include <stdio.h>
 
 #include <oonf/libcommon/autobuf.h>
+#include <oonf/libcommon/isonumber.h>
 #include <oonf/oonf.h>
 #include <oonf/libcommon/netaddr.h>
 #include <oonf/libcommon/string.h>
@@ -54,22 +55,45 @@
 #include <oonf/libconfig/cfg_schema.h>
 #include <oonf/libcore/oonf_logging.h>
 #include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/libcore/os_core.h>
 #include <oonf/base/oonf_clock.h>
 #include <oonf/base/oonf_layer2.h>
+#include <oonf/base/oonf_telnet.h>
 #include <oonf/base/oonf_timer.h>
+#include <oonf/base/oonf_viewer.h>
+#include <oonf/base/os_clock.h>
 
 #include <oonf/generic/layer2_generator/layer2_generator.h>
 
 /* Definitions */
 #define LOG_L2GEN _layer2_generator_subsystem.logging
 
-/* prototypes */
-static int _init(void);
-static void _cleanup(void);
+/*! maximum number of generated interfaces */
+#define L2GEN_MAX_INTERFACES 255
 
-static void _cb_l2gen_event(struct oonf_timer_instance *);
+/*! maximum number of generated remote IPs per neighbor */
+#define L2GEN_MAX_NEIGHBOR_IPS 255
 
-static void _cb_config_changed(void);
+/*! maximum number of commits per updated neighbor and event */
+#define L2GEN_MAX_COMMITS 16
+
+/**
+ * Distribution of the generated layer2 values
+ */
+enum _l2gen_distribution
+{
+  /*! all values are set to the event counter */
+  L2GEN_DIST_COUNTER,
+
+  /*! values are drawn uniformly from the configured range */
+  L2GEN_DIST_UNIFORM,
+
+  /*! values do a random walk through the configured range */
+  L2GEN_DIST_WALK,
+
+  /*! number of distributions */
+  L2GEN_DIST_COUNT,
+};
 
 /**
  * Configuration of layer2 generator
@@ -89,8 +113,90 @@ struct _l2_generator_config {
 
   /*! proxied MAC behind neighbor for event generation */
   struct netaddr destination;
+
+  /*! number of generated interfaces */
+  int32_t interfaces;
+
+  /*! number of generated neighbors per interface */
+  int32_t neighbors;
+
+  /*! percentage of existing neighbors updated per event */
+  int32_t update;
+
+  /*! percentage of neighbors that appear or disappear per event */
+  int32_t churn;
+
+  /*! distribution of generated values */
+  int32_t distribution;
+
+  /*! lower bound of generated values (internal representation) */
+  int64_t value_min;
+
+  /*! upper bound of generated values (internal representation) */
+  int64_t value_max;
+
+  /*! number of remote IPs generated for each neighbor */
+  int32_t neighbor_ips;
+
+  /*! number of commits the data of an updated neighbor is split into */
+  int32_t commits;
+
+  /*! true if all updates of an event are committed in a single layer2 transaction */
+  bool transaction;
 };
 
+/**
+ * Processing time statistics of generated layer2 batches
+ */
+struct _l2gen_statistics {
+  /*! number of generated batches */
+  uint64_t batches;
+
+  /*! processing time of the last batch in nanoseconds */
+  uint64_t last;
+
+  /*! minimal processing time of a batch in nanoseconds */
+  uint64_t min;
+
+  /*! maximal processing time of a batch in nanoseconds */
+  uint64_t max;
+
+  /*! sum of all processing times in nanoseconds */
+  uint64_t total;
+
+  /*! number of neighbors updated by the last batch */
+  uint32_t updated;
+
+  /*! number of neighbors added by the last batch */
+  uint32_t added;
+
+  /*! number of neighbors removed by the last batch */
+  uint32_t removed;
+
+  /*! number of generated neighbors after the last batch */
+  uint32_t neighbors;
+};
+
+/* prototypes */
+static int _init(void);
+static void _cleanup(void);
+
+static uint32_t _random(void);
+static int64_t _get_value(const struct oonf_layer2_data *data, uint64_t event_counter);
+static void _set_data(
+  struct oonf_layer2_data *data, const struct oonf_layer2_metadata *meta, uint64_t event_counter);
+static void _get_neighbor_key(struct oonf_layer2_neigh_key *key, uint32_t number);
+static void _generate_neighbor(struct oonf_layer2_net *net, uint32_t if_number, uint32_t number,
+  uint64_t event_counter);
+static void _generate_interface(uint32_t if_number, uint64_t event_counter);
+static void _cb_l2gen_event(struct oonf_timer_instance *);
+
+static enum oonf_telnet_result _cb_l2gen(struct oonf_telnet_data *con);
+static enum oonf_telnet_result _cb_l2gen_help(struct oonf_telnet_data *con);
+static int _cb_create_text_batch(struct oonf_viewer_template *);
+
+static void _cb_config_changed(void);
+
 static struct oonf_timer_class _l2gen_timer_info = {
   .name = "L2 Generator event",
   .callback = _cb_l2gen_event,
@@ -102,16 +208,48 @@ static struct oonf_timer_instance _l2gen_timer = {
 };
 
 /* configuration */
+static const char *_distribution_names[L2GEN_DIST_COUNT] = {
+  [L2GEN_DIST_COUNTER] = "counter",
+  [L2GEN_DIST_UNIFORM] = "uniform",
+  [L2GEN_DIST_WALK] = "walk",
+};
+
 static struct _l2_generator_config _l2gen_config;
 
 static struct cfg_schema_entry _l2gen_entries[] = {
-  CFG_MAP_CLOCK_MIN(_l2_generator_config, interval, "interval", "3.000", "Interval between L2 generator events", 500),
-  CFG_MAP_STRING_ARRAY(_l2_generator_config, interface, "interface", "eth0", "Interface of example radio", IF_NAMESIZE),
+  CFG_MAP_CLOCK_MIN(_l2_generator_config, interval, "interval", "3.000", "Interval between L2 generator events", 10),
+  CFG_MAP_STRING_ARRAY(_l2_generator_config, interface, "interface", "eth0",
+    "Interface of example radio, additional interfaces get a '-<n>' suffix", IF_NAMESIZE),
   CFG_MAP_NETADDR_MAC48(
     _l2_generator_config, neighbor, "neighbor", "02:00:00:00:00:01", "Mac address of example radio", false, false),
   CFG_MAP_NETADDR_MAC48(_l2_generator_config, destination, "destination", "02:00:00:00:00:02",
     "Mac address of example radio destination", false, true),
   CFG_MAP_BOOL(_l2_generator_config, active, "active", "false", "Activates artificially generated layer2 data"),
+  CFG_MAP_INT32_MINMAX(_l2_generator_config, interfaces, "interfaces", "1", "Number of generated interfaces", 0, 1,
+    L2GEN_MAX_INTERFACES),
+  CFG_MAP_INT32_MINMAX(_l2_generator_config, neighbors, "neighbors", "1",
+    "Number of generated neighbors per interface, the mac addresses are counted up from the neighbor mac", 0, 1, 65535),
+  CFG_MAP_INT32_MINMAX(_l2_generator_config, update, "update", "100",
+    "Percentage of the existing neighbors that are updated by each event", 0, 0, 100),
+  CFG_MAP_INT32_MINMAX(_l2_generator_config, churn, "churn", "0",
+    "Percentage of the neighbors that disappear with each event, they reappear with the next one", 0, 0, 100),
+  CFG_MAP_CHOICE(_l2_generator_config, distribution, "distribution", "counter",
+    "Distribution of generated values: 'counter' uses the event counter, 'uniform' draws random values"
+    " from the value range and 'walk' does a random walk through the value range",
+    _distribution_names),
+  CFG_MAP_INT64_MINMAX(_l2_generator_config, value_min, "value_min", "0",
+    "Lower bound of random values, interpreted as the internal value of each layer2 data entry", 0, INT32_MIN,
+    INT32_MAX),
+  CFG_MAP_INT64_MINMAX(_l2_generator_config, value_max, "value_max", "1000",
+    "Upper bound of random values, interpreted as the internal value of each layer2 data entry", 0, INT32_MIN,
+    INT32_MAX),
+  CFG_MAP_INT32_MINMAX(_l2_generator_config, neighbor_ips, "neighbor_ips", "0",
+    "Number of IPv6 addresses (fd00::/8) generated for each neighbor", 0, 0, L2GEN_MAX_NEIGHBOR_IPS),
+  CFG_MAP_INT32_MINMAX(_l2_generator_config, commits, "commits", "1",
+    "Number of commits the data of an updated neighbor is split into, like a radio that reports"
+    " a neighbor in several messages", 0, 1, L2GEN_MAX_COMMITS),
+  CFG_MAP_BOOL(_l2_generator_config, transaction, "transaction", "true",
+    "Commit all updates of a generator event in a single layer2 database transaction"),
 };
 
 static struct cfg_schema_section _l2gen_section = {
@@ -121,11 +259,89 @@ static struct cfg_schema_section _l2gen_section = {
   .entry_count = ARRAYSIZE(_l2gen_entries),
 };
 
+/*! template key for number of generated batches */
+#define KEY_BATCHES "l2gen_batches"
+
+/*! template key for number of generated neighbors */
+#define KEY_NEIGHBORS "l2gen_neighbors"
+
+/*! template key for number of neighbors updated by the last batch */
+#define KEY_UPDATED "l2gen_updated"
+
+/*! template key for number of neighbors added by the last batch */
+#define KEY_ADDED "l2gen_added"
+
+/*! template key for number of neighbors removed by the last batch */
+#define KEY_REMOVED "l2gen_removed"
+
+/*! template key for processing time of the last batch */
+#define KEY_LAST "l2gen_last_us"
+
+/*! template key for minimal processing time of a batch */
+#define KEY_MIN "l2gen_min_us"
+
+/*! template key for maximal processing time of a batch */
+#define KEY_MAX "l2gen_max_us"
+
+/*! template key for average processing time of a batch */
+#define KEY_AVG "l2gen_avg_us"
+
+/*
+ * buffer space for values that will be assembled
+ * into the output of the telnet command
+ */
+static struct isonumber_str _value_batches;
+static struct isonumber_str _value_neighbors;
+static struct isonumber_str _value_updated;
+static struct isonumber_str _value_added;
+static struct isonumber_str _value_removed;
+static struct isonumber_str _value_last;
+static struct isonumber_str _value_min;
+static struct isonumber_str _value_max;
+static struct isonumber_str _value_avg;
+
+/* definition of the template data entries for JSON and table output */
+static struct abuf_template_data_entry _tde_batch[] = {
+  { KEY_BATCHES, _value_batches.buf, false },
+  { KEY_NEIGHBORS, _value_neighbors.buf, false },
+  { KEY_UPDATED, _value_updated.buf, false },
+  { KEY_ADDED, _value_added.buf, false },
+  { KEY_REMOVED, _value_removed.buf, false },
+  { KEY_LAST, _value_last.buf, false },
+  { KEY_MIN, _value_min.buf, false },
+  { KEY_MAX, _value_max.buf, false },
+  { KEY_AVG, _value_avg.buf, false },
+};
+
+static struct abuf_template_storage _template_storage;
+
+/* Template Data objects (contain one or more Template Data Entries) */
+static struct abuf_template_data _td_batch[] = {
+  { _tde_batch, ARRAYSIZE(_tde_batch) },
+};
+
+/* OONF viewer templates (based on Template Data arrays) */
+static struct oonf_viewer_template _templates[] = {
+  {
+    .data = _td_batch,
+    .data_size = ARRAYSIZE(_td_batch),
+    .json_name = "batch",
+    .cb_function = _cb_create_text_batch,
+  },
+};
+
+/* telnet command of this plugin */
+static struct oonf_telnet_command _telnet_commands[] = {
+  TELNET_CMD(OONF_L2GEN_SUBSYSTEM, _cb_l2gen, "", .help_handler = _cb_l2gen_help),
+};
+
 /* plugin declaration */
 static const char *_dependencies[] = {
   OONF_CLOCK_SUBSYSTEM,
   OONF_LAYER2_SUBSYSTEM,
+  OONF_TELNET_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
+  OONF_VIEWER_SUBSYSTEM,
 };
 
 static struct oonf_subsystem _layer2_generator_subsystem = {
@@ -148,6 +364,12 @@ static struct oonf_layer2_origin _origin = {
   .priority = OONF_LAYER2_ORIGIN_CONFIGURED,
 };
 
+/* state of the pseudo random number generator */
+static uint32_t _random_state;
+
+/* processing time statistics */
+static struct _l2gen_statistics _stats;
+
 /**
  * Constructor of plugin
  * @return 0 if initialization was successful, -1 otherwise
@@ -155,10 +377,17 @@ static struct oonf_layer2_origin _origin = {
 static int
 _init(void) {
   memset(&_l2gen_config, 0, sizeof(_l2gen_config));
+  memset(&_stats, 0, sizeof(_stats));
+
+  /* seed the generator once, the events need lots of cheap random numbers */
+  if (os_core_get_random(&_random_state, sizeof(_random_state)) || _random_state == 0) {
+    _random_state = 0x12345678;
+  }
 
   oonf_layer2_origin_add(&_origin);
   oonf_timer_add(&_l2gen_timer_info);
   oonf_timer_start(&_l2gen_timer, 5000);
+  oonf_telnet_add(&_telnet_commands[0]);
   return 0;
 }
 
@@ -167,18 +396,79 @@ _init(void) {
  */
 static void
 _cleanup(void) {
+  oonf_telnet_remove(&_telnet_commands[0]);
   oonf_layer2_origin_remove(&_origin);
   oonf_timer_stop(&_l2gen_timer);
   oonf_timer_remove(&_l2gen_timer_info);
 }
 
+/**
+ * @return next number of the xorshift pseudo random number generator
+ */
+static uint32_t
+_random(void) {
+  _random_state ^= _random_state << 13;
+  _random_state ^= _random_state >> 17;
+  _random_state ^= _random_state << 5;
+  return _random_state;
+}
+
+/**
+ * Calculate the next value of a layer2 data entry
+ * @param data layer2 data entry
+ * @param event_counter counter of generator events
+ * @return next (internal) value of the data entry
+ */
+static int64_t
+_get_value(const struct oonf_layer2_data *data, uint64_t event_counter) {
+  uint64_t range, step;
+  int64_t value;
+
+  range = (uint64_t)_l2gen_config.value_max - (uint64_t)_l2gen_config.value_min;
+
+  switch (_l2gen_config.distribution) {
+    case L2GEN_DIST_UNIFORM:
+      return _l2gen_config.value_min + (int64_t)(_random() % (range + 1));
+    case L2GEN_DIST_WALK:
+      if (!oonf_layer2_data_has_value(data) || oonf_layer2_data_get_origin(data) != &_origin
+          || oonf_layer2_data_get_type(data) != OONF_LAYER2_INTEGER_DATA) {
+        return _l2gen_config.value_min + (int64_t)(_random() % (range + 1));
+      }
+
+      /* move up to 10% of the value range up or down */
+      step = range / 10 + 1;
+      value = oonf_layer2_data_get_int64(data, data->_meta->scaling, 0);
+      value += (int64_t)(_random() % (2 * step + 1)) - (int64_t)step;
+      if (value < _l2gen_config.value_min) {
+        return _l2gen_config.value_min;
+      }
+      if (value > _l2gen_config.value_max) {
+        return _l2gen_config.value_max;
+      }
+      return value;
+    case L2GEN_DIST_COUNTER:
+    default:
+      return (int64_t)event_counter;
+  }
+}
+
+/**
+ * Set a layer2 data entry to its next generated value
+ * @param data layer2 data entry
+ * @param meta metadata of data entry
+ * @param event_counter counter of generator events
+ */
 static void
-_set_data(struct oonf_layer2_data *data, const struct oonf_layer2_metadata *meta, int64_t value) {
+_set_data(struct oonf_layer2_data *data, const struct oonf_layer2_metadata *meta, uint64_t event_counter) {
+  int64_t value;
+
   switch (meta->type) {
     case OONF_LAYER2_INTEGER_DATA:
+      value = _get_value(data, event_counter);
       oonf_layer2_data_set_int64(data, &_origin, meta, value, meta->scaling);
       break;
     case OONF_LAYER2_BOOLEAN_DATA:
+      value = _l2gen_config.distribution == L2GEN_DIST_COUNTER ? (int64_t)event_counter : (int64_t)_random();
       oonf_layer2_data_set_bool(data, &_origin, meta, (value & 1) != 0);
       break;
     default:
@@ -187,30 +477,124 @@ _set_data(struct oonf_layer2_data *data, const struct oonf_layer2_metadata *meta
 }
 
 /**
- * Callback for generating new layer2 test data
- * @param ptr timer instance that fired
+ * Calculate the key of a generated layer2 neighbor
+ * @param key pointer to neighbor key
+ * @param number number of neighbor, added to the configured neighbor mac
  */
 static void
-_cb_l2gen_event(struct oonf_timer_instance *ptr __attribute((unused))) {
-  static uint64_t event_counter = 100;
-  enum oonf_layer2_network_index net_idx;
+_get_neighbor_key(struct oonf_layer2_neigh_key *key, uint32_t number) {
+  uint8_t mac[6];
+
+  /* count up the lower two octets of the configured mac */
+  memcpy(mac, netaddr_get_binptr(&_l2gen_config.neighbor), sizeof(mac));
+  number += ((uint32_t)mac[4] << 8) | mac[5];
+  mac[4] = (number >> 8) & 0xff;
+  mac[5] = number & 0xff;
+
+  memset(key, 0, sizeof(*key));
+  netaddr_from_binary(&key->addr, mac, sizeof(mac), AF_MAC48);
+}
+
+/**
+ * Generate the data of a layer2 neighbor
+ * @param net layer2 network of neighbor
+ * @param if_number number of generated interface
+ * @param number number of neighbor, added to the configured neighbor mac
+ * @param event_counter counter of generator events
+ */
+static void
+_generate_neighbor(struct oonf_layer2_net *net, uint32_t if_number, uint32_t number, uint64_t event_counter) {
   enum oonf_layer2_neighbor_index neigh_idx;
-  struct oonf_layer2_net *net;
+  struct oonf_layer2_neigh_key key;
   struct oonf_layer2_neigh *neigh;
-#ifdef OONF_LOG_DEBUG_INFO
-  struct netaddr_str buf1;
-#endif
+  struct netaddr ip;
+  uint8_t bin[16];
+  bool present;
+  int32_t i;
+
+  _get_neighbor_key(&key, number);
+  neigh = oonf_layer2_neigh_get_lid(net, &key);
+  present = neigh != NULL;
+
+  if (present && _l2gen_config.churn > 0 && _random() % 100 < (uint32_t)_l2gen_config.churn) {
+    /* neighbor disappears, it will reappear with the next event */
+    if (oonf_layer2_neigh_remove(neigh, &_origin)) {
+      _stats.removed++;
+    }
+    return;
+  }
+  if (present && _random() % 100 >= (uint32_t)_l2gen_config.update) {
+    /* neighbor is not updated by this event */
+    _stats.neighbors++;
+    return;
+  }
 
-  if (oonf_layer2_origin_is_added(&_origin)) {
+  neigh = oonf_layer2_neigh_add_lid(net, &key);
+  if (neigh == NULL) {
+    OONF_WARN(LOG_L2GEN, "Cannot allocate layer2_neighbor");
     return;
   }
 
-  event_counter++;
+  if (!present) {
+    if (netaddr_get_address_family(&_l2gen_config.destination) == AF_MAC48) {
+      oonf_layer2_destination_add(neigh, &_l2gen_config.destination, &_origin);
+    }
+
+    /* generate fd00::/8 addresses with interface and neighbor number encoded */
+    memset(bin, 0, sizeof(bin));
+    bin[0] = 0xfd;
+    bin[6] = (if_number >> 8) & 0xff;
+    bin[7] = if_number & 0xff;
+    bin[8] = (number >> 8) & 0xff;
+    bin[9] = number & 0xff;
+    for (i = 0; i < _l2gen_config.neighbor_ips; i++) {
+      bin[15] = (uint8_t)(i + 1);
+      netaddr_from_binary(&ip, bin, sizeof(bin), AF_INET6);
+      oonf_layer2_neigh_add_ip(neigh, &_origin, &ip);
+    }
+    _stats.added++;
+  }
+  else {
+    _stats.updated++;
+  }
+  _stats.neighbors++;
 
-  OONF_DEBUG(LOG_L2GEN, "L2Gen-Event triggered (%s/%s/%" PRIu64 ")", _l2gen_config.interface,
-    netaddr_to_string(&buf1, &_l2gen_config.neighbor), event_counter);
+  oonf_layer2_neigh_set_lastseen(neigh, oonf_clock_getNow());
+
+  /* each commit sets every n-th data index */
+  for (i = 0; i < _l2gen_config.commits; i++) {
+    for (neigh_idx = i; neigh_idx < OONF_LAYER2_NEIGH_COUNT; neigh_idx += _l2gen_config.commits) {
+      _set_data(&neigh->data[neigh_idx], oonf_layer2_neigh_metadata_get(neigh_idx), event_counter);
+    }
+    oonf_layer2_neigh_commit(neigh);
+  }
+}
+
+/**
+ * Generate the data of a layer2 interface and its neighbors
+ * @param if_number number of generated interface
+ * @param event_counter counter of generator events
+ */
+static void
+_generate_interface(uint32_t if_number, uint64_t event_counter) {
+  enum oonf_layer2_network_index net_idx;
+  enum oonf_layer2_neighbor_index neigh_idx;
+  struct oonf_layer2_net *net;
+  char if_name[IF_NAMESIZE + 12];
+  int32_t i;
 
-  net = oonf_layer2_net_add(_l2gen_config.interface);
+  if (if_number == 0) {
+    strscpy(if_name, _l2gen_config.interface, sizeof(if_name));
+  }
+  else {
+    snprintf(if_name, sizeof(if_name), "%s-%u", _l2gen_config.interface, if_number);
+  }
+  if (strlen(if_name) >= IF_NAMESIZE) {
+    OONF_WARN(LOG_L2GEN, "Generated interface name %s is too long", if_name);
+    return;
+  }
+
+  net = oonf_layer2_net_add(if_name);
   if (net == NULL) {
     OONF_WARN(LOG_L2GEN, "Cannot allocate layer2_network");
     return;
@@ -229,28 +613,115 @@ _cb_l2gen_event(struct oonf_timer_instance *ptr __attribute((unused))) {
 
   if (oonf_layer2_net_commit(net)) {
     /* something bad has happened, l2net was removed */
-    OONF_WARN(LOG_L2GEN, "Could not commit interface %s", _l2gen_config.interface);
+    OONF_WARN(LOG_L2GEN, "Could not commit interface %s", if_name);
     return;
   }
 
-  neigh = oonf_layer2_neigh_add(net, &_l2gen_config.neighbor);
-  if (neigh == NULL) {
-    OONF_WARN(LOG_L2GEN, "Cannot allocate layer2_neighbor");
+  for (i = 0; i < _l2gen_config.neighbors; i++) {
+    _generate_neighbor(net, if_number, (uint32_t)i, event_counter);
+  }
+}
+
+/**
+ * Callback for generating new layer2 test data
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_l2gen_event(struct oonf_timer_instance *ptr __attribute((unused))) {
+  static uint64_t event_counter = 100;
+  uint64_t start, end, duration;
+  int32_t i;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str buf1;
+#endif
+
+  if (!oonf_layer2_origin_is_added(&_origin)) {
     return;
   }
 
-  if (netaddr_get_address_family(&_l2gen_config.destination) == AF_MAC48) {
-    oonf_layer2_destination_add(neigh, &_l2gen_config.destination, &_origin);
+  event_counter++;
+
+  OONF_DEBUG(LOG_L2GEN, "L2Gen-Event triggered (%s/%s/%" PRIu64 ")", _l2gen_config.interface,
+    netaddr_to_string(&buf1, &_l2gen_config.neighbor), event_counter);
+
+  _stats.updated = 0;
+  _stats.added = 0;
+  _stats.removed = 0;
+  _stats.neighbors = 0;
+
+  /* measure the layer2 database including all its listeners */
+  os_clock_gettime64_ns(&start);
+  if (_l2gen_config.transaction) {
+    oonf_layer2_transaction_start();
+  }
+
+  for (i = 0; i < _l2gen_config.interfaces; i++) {
+    _generate_interface((uint32_t)i, event_counter);
   }
-  memcpy(&neigh->key.addr, &_l2gen_config.neighbor, sizeof(neigh->key.addr));
-  neigh->key.link_id[0] = event_counter & 0xff;
-  neigh->key.link_id_length = 1;
-  oonf_layer2_neigh_set_lastseen(neigh, oonf_clock_getNow());
 
-  for (neigh_idx = 0; neigh_idx < OONF_LAYER2_NEIGH_COUNT; neigh_idx++) {
-    _set_data(&neigh->data[neigh_idx], oonf_layer2_neigh_metadata_get(neigh_idx), event_counter);
+  if (_l2gen_config.transaction) {
+    oonf_layer2_transaction_commit();
+  }
+  os_clock_gettime64_ns(&end);
+
+  duration = end - start;
+  if (_stats.batches == 0 || duration < _stats.min) {
+    _stats.min = duration;
   }
-  oonf_layer2_neigh_commit(neigh);
+  if (duration > _stats.max) {
+    _stats.max = duration;
+  }
+  _stats.last = duration;
+  _stats.total += duration;
+  _stats.batches++;
+
+  OONF_INFO(LOG_L2GEN,
+    "L2Gen-Event %" PRIu64 ": updated %u, added %u, removed %u of %u neighbors in %" PRIu64 " us"
+    " (%d commits per neighbor, %s)",
+    event_counter, _stats.updated, _stats.added, _stats.removed, _stats.neighbors, duration / 1000,
+    _l2gen_config.commits, _l2gen_config.transaction ? "transaction" : "single commits");
+}
+
+/**
+ * Callback for the telnet command of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_l2gen(struct oonf_telnet_data *con) {
+  return oonf_viewer_telnet_handler(
+    con->out, &_template_storage, OONF_L2GEN_SUBSYSTEM, con->parameter, _templates, ARRAYSIZE(_templates));
+}
+
+/**
+ * Callback for the help output of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_l2gen_help(struct oonf_telnet_data *con) {
+  return oonf_viewer_telnet_help(con->out, OONF_L2GEN_SUBSYSTEM, con->parameter, _templates, ARRAYSIZE(_templates));
+}
+
+/**
+ * Callback to generate text/json description of the batch statistics
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_batch(struct oonf_viewer_template *template) {
+  isonumber_from_u64(&_value_batches, _stats.batches, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_neighbors, _stats.neighbors, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_updated, _stats.updated, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_added, _stats.added, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_removed, _stats.removed, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_last, _stats.last / 1000, "", 1, true);
+  isonumber_from_u64(&_value_min, _stats.min / 1000, "", 1, true);
+  isonumber_from_u64(&_value_max, _stats.max / 1000, "", 1, true);
+  isonumber_from_u64(&_value_avg, _stats.batches ? _stats.total / _stats.batches / 1000 : 0, "", 1, true);
+
+  oonf_viewer_output_print_line(template);
+  return 0;
 }
 
 static void
@@ -262,15 +733,22 @@ _cb_config_changed(void) {
 
   cfg_get_phy_if(_l2gen_config.interface, _l2gen_config.interface);
 
+  if (_l2gen_config.value_max < _l2gen_config.value_min) {
+    OONF_WARN(LOG_L2GEN, "value_max is smaller than value_min, using value_min for both");
+    _l2gen_config.value_max = _l2gen_config.value_min;
+  }
+
   OONF_DEBUG(LOG_L2GEN, "Generator is now %s for interface %s\n", _l2gen_config.active ? "active" : "inactive",
     _l2gen_config.interface);
 
-  if (!oonf_layer2_origin_is_added(&_origin) && _l2gen_config.active) {
-    oonf_layer2_origin_add(&_origin);
-  }
-  else if (oonf_layer2_origin_is_added(&_origin) && !_l2gen_config.active) {
+  /* drop all generated data, the next event starts from scratch with the new settings */
+  if (oonf_layer2_origin_is_added(&_origin)) {
     oonf_layer2_origin_remove(&_origin);
   }
+  if (_l2gen_config.active) {
+    oonf_layer2_origin_add(&_origin);
+  }
+  memset(&_stats, 0, sizeof(_stats));
 
   /* set new interval */
   oonf_timer_set(&_l2gen_timer, _l2gen_config.interval);
@@ -80,6 +80,8 @@ static void _initialize_neigh_data_values(struct oonf_viewer_template *template,
 static void _initialize_neigh_origin_values(struct oonf_layer2_data *data);
 static void _initialize_neigh_values(struct oonf_layer2_neigh *neigh);
 static void _initialize_neigh_ip_values(struct oonf_layer2_neighbor_address *neigh_addr);
+static void _initialize_history_value(char *buffer, size_t length, struct oonf_viewer_template *template,
+  enum oonf_layer2_neighbor_index idx, int64_t value);
 
 static int _cb_create_text_interface(struct oonf_viewer_template *);
 static int _cb_create_text_interface_ip(struct oonf_viewer_template *);
@@ -87,6 +89,8 @@ static int _cb_create_text_neighbor(struct oonf_viewer_template *);
 static int _cb_create_text_neighbor_ip(struct oonf_viewer_template *);
 static int _cb_create_text_default(struct oonf_viewer_template *);
 static int _cb_create_text_dst(struct oonf_viewer_template *);
+static int _cb_create_text_history(struct oonf_viewer_template *);
+static int _cb_create_text_history_stats(struct oonf_viewer_template *);
 
 /*
  * list of template keys and corresponding buffers for values.
@@ -157,6 +161,33 @@ static int _cb_create_text_dst(struct oonf_viewer_template *);
 /*! template key for destination origin */
 #define KEY_DST_ORIGIN "dst_origin"
 
+/*! template key for neighbor data index of history */
+#define KEY_HISTORY_KEY "history_key"
+
+/*! template key for age of history sample */
+#define KEY_HISTORY_AGE "history_age"
+
+/*! template key for value of history sample */
+#define KEY_HISTORY_VALUE "history_value"
+
+/*! template key for number of history samples */
+#define KEY_HISTORY_SAMPLES "history_samples"
+
+/*! template key for smallest history value */
+#define KEY_HISTORY_MIN "history_min"
+
+/*! template key for largest history value */
+#define KEY_HISTORY_MAX "history_max"
+
+/*! template key for average history value */
+#define KEY_HISTORY_AVG "history_avg"
+
+/*! template key for median history value */
+#define KEY_HISTORY_MEDIAN "history_median"
+
+/*! template key for 90th percentile of history values */
+#define KEY_HISTORY_P90 "history_p90"
+
 /*! string prefix for all interface keys */
 #define KEY_IF_PREFIX "if_"
 
@@ -197,6 +228,16 @@ static char _value_neigh_origin[OONF_LAYER2_NEIGH_COUNT][IF_NAMESIZE];
 static struct netaddr_str _value_dst_addr;
 static char _value_dst_origin[IF_NAMESIZE];
 
+static char _value_history_key[32];
+static struct isonumber_str _value_history_age;
+static char _value_history_value[64];
+static char _value_history_samples[6];
+static char _value_history_min[64];
+static char _value_history_max[64];
+static char _value_history_avg[64];
+static char _value_history_median[64];
+static char _value_history_p90[64];
+
 /* definition of the template data entries for JSON and table output */
 static struct abuf_template_data_entry _tde_if_key[] = {
   { KEY_IF, _value_if, true },
@@ -248,6 +289,21 @@ static struct abuf_template_data_entry _tde_dst[] = {
   { KEY_DST_ORIGIN, _value_dst_origin, true },
 };
 
+static struct abuf_template_data_entry _tde_history[] = {
+  { KEY_HISTORY_KEY, _value_history_key, true },
+  { KEY_HISTORY_AGE, _value_history_age.buf, false },
+  { KEY_HISTORY_VALUE, _value_history_value, true },
+};
+static struct abuf_template_data_entry _tde_history_stats[] = {
+  { KEY_HISTORY_KEY, _value_history_key, true },
+  { KEY_HISTORY_SAMPLES, _value_history_samples, false },
+  { KEY_HISTORY_MIN, _value_history_min, true },
+  { KEY_HISTORY_MAX, _value_history_max, true },
+  { KEY_HISTORY_AVG, _value_history_avg, true },
+  { KEY_HISTORY_MEDIAN, _value_history_median, true },
+  { KEY_HISTORY_P90, _value_history_p90, true },
+};
+
 static struct abuf_template_storage _template_storage;
 static struct autobuf _key_storage;
 
@@ -285,6 +341,16 @@ static struct abuf_template_data _td_dst[] = {
   { _tde_dst_key, ARRAYSIZE(_tde_dst_key) },
   { _tde_dst, ARRAYSIZE(_tde_dst) },
 };
+static struct abuf_template_data _td_history[] = {
+  { _tde_if_key, ARRAYSIZE(_tde_if_key) },
+  { _tde_neigh_key, ARRAYSIZE(_tde_neigh_key) },
+  { _tde_history, ARRAYSIZE(_tde_history) },
+};
+static struct abuf_template_data _td_history_stats[] = {
+  { _tde_if_key, ARRAYSIZE(_tde_if_key) },
+  { _tde_neigh_key, ARRAYSIZE(_tde_neigh_key) },
+  { _tde_history_stats, ARRAYSIZE(_tde_history_stats) },
+};
 
 /* OONF viewer templates (based on Template Data arrays) */
 static struct oonf_viewer_template _templates[] = {
@@ -324,6 +390,18 @@ static struct oonf_viewer_template _templates[] = {
     .json_name = "destination",
     .cb_function = _cb_create_text_dst,
   },
+  {
+    .data = _td_history,
+    .data_size = ARRAYSIZE(_td_history),
+    .json_name = "history",
+    .cb_function = _cb_create_text_history,
+  },
+  {
+    .data = _td_history_stats,
+    .data_size = ARRAYSIZE(_td_history_stats),
+    .json_name = "history_stats",
+    .cb_function = _cb_create_text_history_stats,
+  },
 };
 
 /* telnet command of this plugin */
@@ -579,6 +657,26 @@ _initialize_destination_values(struct oonf_layer2_destination *l2dst) {
   strscpy(_value_dst_origin, l2dst->origin->name, IF_NAMESIZE);
 }
 
+/**
+ * Convert a history sample value of a neighbor data index into a string
+ * @param buffer destination buffer
+ * @param length length of destination buffer
+ * @param template viewer template
+ * @param idx neighbor data index
+ * @param value sample value
+ */
+static void
+_initialize_history_value(char *buffer, size_t length, struct oonf_viewer_template *template,
+  enum oonf_layer2_neighbor_index idx, int64_t value) {
+  struct oonf_layer2_data data;
+
+  memset(&data, 0, sizeof(data));
+  data._value.integer = value;
+
+  buffer[0] = 0;
+  oonf_layer2_neigh_data_to_string(buffer, length, &data, idx, template->create_raw);
+}
+
 /**
  * Callback to generate text/json description of all layer2 interfaces
  * @param template viewer template
@@ -723,3 +821,81 @@ _cb_create_text_dst(struct oonf_viewer_template *template) {
   }
   return 0;
 }
+
+/**
+ * Callback to generate text/json description of all layer2 neighbor history samples
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_history(struct oonf_viewer_template *template) {
+  struct oonf_layer2_neigh *neigh;
+  struct oonf_layer2_net *net;
+  enum oonf_layer2_neighbor_index idx;
+  uint64_t timestamp;
+  int64_t value;
+  size_t n;
+
+  avl_for_each_element(oonf_layer2_get_net_tree(), net, _node) {
+    _initialize_if_values(net);
+
+    avl_for_each_element(&net->neighbors, neigh, _node) {
+      _initialize_neigh_values(neigh);
+
+      for (idx = 0; idx < OONF_LAYER2_NEIGH_COUNT; idx++) {
+        strscpy(_value_history_key, oonf_layer2_neigh_metadata_get(idx)->key, sizeof(_value_history_key));
+
+        for (n = 0; !oonf_layer2_neigh_get_history_sample(&value, &timestamp, neigh, idx, n); n++) {
+          oonf_clock_toIntervalString(&_value_history_age, -oonf_clock_get_relative(timestamp));
+          _initialize_history_value(_value_history_value, sizeof(_value_history_value), template, idx, value);
+
+          /* generate template output */
+          oonf_viewer_output_print_line(template);
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * Callback to generate text/json description of the aggregated history
+ * of all layer2 neighbors
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_history_stats(struct oonf_viewer_template *template) {
+  struct oonf_layer2_history_stats stats, median;
+  struct oonf_layer2_neigh *neigh;
+  struct oonf_layer2_net *net;
+  enum oonf_layer2_neighbor_index idx;
+
+  avl_for_each_element(oonf_layer2_get_net_tree(), net, _node) {
+    _initialize_if_values(net);
+
+    avl_for_each_element(&net->neighbors, neigh, _node) {
+      _initialize_neigh_values(neigh);
+
+      for (idx = 0; idx < OONF_LAYER2_NEIGH_COUNT; idx++) {
+        if (oonf_layer2_neigh_get_history_stats(&median, neigh, idx, 0, 50)
+            || oonf_layer2_neigh_get_history_stats(&stats, neigh, idx, 0, 90)) {
+          continue;
+        }
+
+        strscpy(_value_history_key, oonf_layer2_neigh_metadata_get(idx)->key, sizeof(_value_history_key));
+        snprintf(_value_history_samples, sizeof(_value_history_samples), "%u", stats.count);
+        _initialize_history_value(_value_history_min, sizeof(_value_history_min), template, idx, stats.min);
+        _initialize_history_value(_value_history_max, sizeof(_value_history_max), template, idx, stats.max);
+        _initialize_history_value(_value_history_avg, sizeof(_value_history_avg), template, idx, stats.avg);
+        _initialize_history_value(
+          _value_history_median, sizeof(_value_history_median), template, idx, median.percentile);
+        _initialize_history_value(_value_history_p90, sizeof(_value_history_p90), template, idx, stats.percentile);
+
+        /* generate template output */
+        oonf_viewer_output_print_line(template);
+      }
+    }
+  }
+  return 0;
+}
@@ -79,6 +79,7 @@
 #include <netlink/msg.h>
 
 #include <oonf/oonf.h>
+#include <oonf/libcommon/autobuf.h>
 #include <oonf/base/oonf_clock.h>
 #include <oonf/base/os_system.h>
 
@@ -87,9 +88,30 @@
 #include <oonf/generic/nl80211_listener/nl80211_internal.h>
 #include <oonf/generic/nl80211_listener/nl80211_listener.h>
 
+static void _process_station(struct nl80211_if *interf, struct nlmsghdr *hdr);
 static bool _handle_traffic(struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx, uint32_t new_32bit);
 static int64_t _get_bitrate(struct nlattr *bitrate_attr);
 
+/* station messages of the running dump, applied together when the dump is done */
+static struct autobuf _station_dump;
+
+/**
+ * Initialize the buffer for station dump messages
+ * @return -1 if an out of memory error happened, 0 otherwise
+ */
+int
+nl80211_init_station_dump(void) {
+  return abuf_init(&_station_dump);
+}
+
+/**
+ * Free the buffer for station dump messages
+ */
+void
+nl80211_cleanup_station_dump(void) {
+  abuf_free(&_station_dump);
+}
+
 /**
  * Send a netlink message to get the nl80211 station dump
  * @param nl pointer to netlink handler
@@ -102,6 +124,9 @@ nl80211_send_get_station_dump(
   struct os_system_netlink *nl, struct nlmsghdr *nl_msg, struct genlmsghdr *hdr, struct nl80211_if *interf) {
   int if_index = nl80211_get_if_baseindex(interf);
 
+  /* drop the stations of an earlier dump that failed */
+  abuf_clear(&_station_dump);
+
   hdr->cmd = NL80211_CMD_GET_STATION;
   nl_msg->nlmsg_flags |= NLM_F_DUMP;
 
@@ -110,12 +135,49 @@ nl80211_send_get_station_dump(
 }
 
 /**
- * Process NL80211_CMD_NEW_STATION message
+ * Store NL80211_CMD_NEW_STATION message until the station dump is done
  * @param interf nl80211 listener interface
  * @param hdr pointer to netlink message header
  */
 void
 nl80211_process_get_station_dump_result(struct nl80211_if *interf, struct nlmsghdr *hdr) {
+  static const uint8_t padding[NLMSG_ALIGNTO] = { 0 };
+
+  abuf_memcpy(&_station_dump, hdr, hdr->nlmsg_len);
+  abuf_memcpy(&_station_dump, padding, NLMSG_ALIGN(hdr->nlmsg_len) - hdr->nlmsg_len);
+  if (abuf_has_failed(&_station_dump)) {
+    OONF_WARN(LOG_NL80211, "Not enough memory to store station dump of %s", interf->name);
+  }
+}
+
+/**
+ * Apply all stations of a finished station dump to the layer2 database
+ * @param interf nl80211 listener interface
+ */
+void
+nl80211_finalize_get_station_dump(struct nl80211_if *interf) {
+  struct nlmsghdr *hdr;
+  size_t len;
+
+  /* each station is committed separately, send the changes of the whole dump at once */
+  oonf_layer2_transaction_start();
+
+  len = abuf_getlen(&_station_dump);
+  for (hdr = (struct nlmsghdr *)abuf_getptr(&_station_dump); NLMSG_OK(hdr, len); hdr = NLMSG_NEXT(hdr, len)) {
+    _process_station(interf, hdr);
+  }
+
+  oonf_layer2_transaction_commit();
+  abuf_clear(&_station_dump);
+}
+
+/**
+ * Process NL80211_CMD_NEW_STATION message
+ * @param interf nl80211 listener interface
+ * @param hdr pointer to netlink message header
+ */
+static void
+_process_station(struct nl80211_if *interf, struct nlmsghdr *hdr) {
   struct oonf_layer2_neigh *l2neigh;
   struct netaddr l2neigh_mac;
 
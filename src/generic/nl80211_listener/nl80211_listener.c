@@ -315,7 +315,7 @@ static const struct _nl80211_query _if_query_ops[QUERY_COUNT] = {
       NL80211_CMD_NEW_STATION,
       nl80211_send_get_station_dump,
       nl80211_process_get_station_dump_result,
-      NULL,
+      nl80211_finalize_get_station_dump,
     },
 };
 
@@ -330,7 +330,11 @@ _early_cfg_init(void) {
  */
 static int
 _init(void) {
+  if (nl80211_init_station_dump()) {
+    return -1;
+  }
   if (os_system_linux_netlink_add(&_netlink_handler, NETLINK_GENERIC)) {
+    nl80211_cleanup_station_dump();
     return -1;
   }
 
@@ -361,6 +365,7 @@ _cleanup(void) {
   oonf_timer_stop(&_transmission_timer);
   oonf_timer_remove(&_transmission_timer_info);
   os_system_linux_netlink_remove(&_netlink_handler);
+  nl80211_cleanup_station_dump();
 }
 
 /**
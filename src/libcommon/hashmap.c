@@ -0,0 +1,262 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/oonf.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+
+static int _resize(struct hashmap *map, uint32_t bucket_count);
+
+/**
+ * @param value 32 bit value
+ * @param shift number of bits to rotate
+ * @return value rotated to the left
+ */
+static INLINE uint32_t
+_rotl(uint32_t value, int shift) {
+  return (value << shift) | (value >> (32 - shift));
+}
+
+/**
+ * Scramble a 32 bit block of the hash input
+ * @param k input block
+ * @return scrambled block
+ */
+static INLINE uint32_t
+_mix(uint32_t k) {
+  k *= 0xcc9e2d51;
+  k = _rotl(k, 15);
+  return k * 0x1b873593;
+}
+
+/**
+ * Initialize a new hashmap struct. Buckets are allocated
+ * with the first insert.
+ * @param map pointer to hashmap
+ * @param hash pointer to hash function for keys
+ * @param comp pointer to comparator for keys
+ */
+void
+hashmap_init(struct hashmap *map, uint32_t (*hash)(const void *key), int (*comp)(const void *k1, const void *k2)) {
+  map->_buckets = NULL;
+  map->_bucket_count = 0;
+  map->count = 0;
+  map->hash = hash;
+  map->comp = comp;
+}
+
+/**
+ * Release the bucket memory of a hashmap. The map must
+ * be empty, its nodes are not touched.
+ * @param map pointer to hashmap
+ */
+void
+hashmap_free(struct hashmap *map) {
+  free(map->_buckets);
+  map->_buckets = NULL;
+  map->_bucket_count = 0;
+  map->count = 0;
+}
+
+/**
+ * Insert a node into a hashmap
+ * @param map pointer to hashmap
+ * @param node pointer to node, key must be set
+ * @return 0 if node was inserted, -1 if the key is already
+ *   in the hashmap or memory for the buckets could not be allocated
+ */
+int
+hashmap_insert(struct hashmap *map, struct hashmap_node *node) {
+  if (map->_bucket_count == 0 && _resize(map, HASHMAP_INITIAL_BUCKETS)) {
+    return -1;
+  }
+  if (hashmap_find(map, node->key)) {
+    return -1;
+  }
+
+  if (map->count >= map->_bucket_count) {
+    /* keep the load factor below one, but continue if memory is low */
+    _resize(map, map->_bucket_count * 2);
+  }
+
+  node->_hash = map->hash(node->key);
+  list_add_tail(&map->_buckets[node->_hash & (map->_bucket_count - 1)], &node->_list);
+  map->count++;
+  return 0;
+}
+
+/**
+ * Remove a node from a hashmap
+ * @param map pointer to hashmap
+ * @param node pointer to node
+ */
+void
+hashmap_remove(struct hashmap *map, struct hashmap_node *node) {
+  if (!list_is_node_added(&node->_list)) {
+    return;
+  }
+
+  list_remove(&node->_list);
+  map->count--;
+}
+
+/**
+ * Find a node in a hashmap
+ * @param map pointer to hashmap
+ * @param key pointer to key
+ * @return pointer to hashmap node with the key, NULL if not found
+ */
+struct hashmap_node *
+hashmap_find(const struct hashmap *map, const void *key) {
+  struct hashmap_node *node;
+  uint32_t hash;
+
+  if (map->count == 0) {
+    return NULL;
+  }
+
+  hash = map->hash(key);
+  list_for_each_element(&map->_buckets[hash & (map->_bucket_count - 1)], node, _list) {
+    if (node->_hash == hash && map->comp(node->key, key) == 0) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Calculate a hash value (MurmurHash3, 32 bit) over a memory block
+ * @param data pointer to memory block
+ * @param length length of memory block
+ * @return hash value
+ */
+uint32_t
+hashmap_hash_bytes(const void *data, size_t length) {
+  const uint8_t *ptr = data;
+  uint32_t hash = 0, k;
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    memcpy(&k, &ptr[i], sizeof(k));
+    hash ^= _mix(k);
+    hash = _rotl(hash, 13);
+    hash = hash * 5 + 0xe6546b64;
+  }
+
+  /* handle remaining bytes */
+  k = 0;
+  switch (length & 3) {
+    case 3:
+      k ^= (uint32_t)ptr[i + 2] << 16;
+      /* fall through */
+    case 2:
+      k ^= (uint32_t)ptr[i + 1] << 8;
+      /* fall through */
+    case 1:
+      k ^= ptr[i];
+      hash ^= _mix(k);
+      break;
+    default:
+      break;
+  }
+
+  /* final avalanche */
+  hash ^= (uint32_t)length;
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6b;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+/**
+ * Hash function for netaddr keys, compatible with avl_comp_netaddr
+ * @param addr pointer to netaddr
+ * @return hash value
+ */
+uint32_t
+hashmap_hash_netaddr(const void *addr) {
+  return hashmap_hash_bytes(addr, sizeof(struct netaddr));
+}
+
+/**
+ * Change the number of buckets of a hashmap and move all nodes
+ * into the new buckets
+ * @param map pointer to hashmap
+ * @param bucket_count new number of buckets, must be a power of two
+ * @return -1 if memory for the buckets could not be allocated, 0 otherwise
+ */
+static int
+_resize(struct hashmap *map, uint32_t bucket_count) {
+  struct list_entity *buckets;
+  struct hashmap_node *node, *it;
+  uint32_t i;
+
+  buckets = calloc(bucket_count, sizeof(*buckets));
+  if (buckets == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < bucket_count; i++) {
+    list_init_head(&buckets[i]);
+  }
+
+  for (i = 0; i < map->_bucket_count; i++) {
+    list_for_each_element_safe(&map->_buckets[i], node, _list, it) {
+      list_remove(&node->_list);
+      list_add_tail(&buckets[node->_hash & (bucket_count - 1)], &node->_list);
+    }
+  }
+
+  free(map->_buckets);
+  map->_buckets = buckets;
+  map->_bucket_count = bucket_count;
+  return 0;
+}
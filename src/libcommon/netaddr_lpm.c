@@ -0,0 +1,174 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <string.h>
+
+#include <oonf/oonf.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/libcommon/netaddr_lpm.h>
+
+/**
+ * Initialize a new longest prefix match index
+ * @param lpm pointer to index
+ */
+void
+netaddr_lpm_init(struct netaddr_lpm *lpm) {
+  memset(lpm, 0, sizeof(*lpm));
+  hashmap_init(&lpm->_map, hashmap_hash_netaddr, avl_comp_netaddr);
+}
+
+/**
+ * Release the memory of a longest prefix match index. The index
+ * must be empty, its nodes are not touched.
+ * @param lpm pointer to index
+ */
+void
+netaddr_lpm_free(struct netaddr_lpm *lpm) {
+  hashmap_free(&lpm->_map);
+  memset(lpm->_prefix_count, 0, sizeof(lpm->_prefix_count));
+  lpm->count = 0;
+}
+
+/**
+ * Add a node to a longest prefix match index. Multiple nodes
+ * can have the same prefix.
+ * @param lpm pointer to index
+ * @param node pointer to node
+ * @param prefix prefix of the node, host bits are ignored
+ * @return 0 if node was added, -1 if prefix has an unsupported
+ *   length or memory for the index could not be allocated
+ */
+int
+netaddr_lpm_add(struct netaddr_lpm *lpm, struct netaddr_lpm_node *node, const struct netaddr *prefix) {
+  struct netaddr_lpm_node *first;
+
+  if (netaddr_get_prefix_length(prefix) > NETADDR_LPM_MAX_PREFIX) {
+    return -1;
+  }
+
+  netaddr_truncate(&node->_prefix, prefix);
+  node->_node.key = &node->_prefix;
+  list_init_head(&node->_duplicates);
+
+  first = hashmap_find_element(&lpm->_map, &node->_prefix, first, _node);
+  if (first) {
+    list_add_tail(&first->_duplicates, &node->_duplicates);
+  }
+  else if (hashmap_insert(&lpm->_map, &node->_node)) {
+    list_init_node(&node->_duplicates);
+    return -1;
+  }
+
+  lpm->_prefix_count[netaddr_get_prefix_length(&node->_prefix)]++;
+  lpm->count++;
+  return 0;
+}
+
+/**
+ * Remove a node from a longest prefix match index
+ * @param lpm pointer to index
+ * @param node pointer to node
+ */
+void
+netaddr_lpm_remove(struct netaddr_lpm *lpm, struct netaddr_lpm_node *node) {
+  struct netaddr_lpm_node *next;
+
+  if (!netaddr_lpm_is_node_added(node)) {
+    return;
+  }
+
+  if (hashmap_is_node_added(&node->_node)) {
+    hashmap_remove(&lpm->_map, &node->_node);
+
+    if (!list_is_empty(&node->_duplicates)) {
+      /* next node with the same prefix takes over the hash index */
+      next = list_first_element(&node->_duplicates, next, _duplicates);
+      hashmap_insert(&lpm->_map, &next->_node);
+    }
+  }
+
+  list_remove(&node->_duplicates);
+
+  lpm->_prefix_count[netaddr_get_prefix_length(&node->_prefix)]--;
+  lpm->count--;
+}
+
+/**
+ * Find the node with the longest prefix that contains an address.
+ * The prefix length of the address is ignored.
+ * @param lpm pointer to index
+ * @param addr pointer to address
+ * @return pointer to longest prefix match node, NULL if no prefix
+ *   contains the address
+ */
+struct netaddr_lpm_node *
+netaddr_lpm_find(const struct netaddr_lpm *lpm, const struct netaddr *addr) {
+  struct netaddr_lpm_node *node;
+  struct netaddr key;
+  int len;
+
+  if (lpm->count == 0) {
+    return NULL;
+  }
+
+  memcpy(&key, addr, sizeof(key));
+  for (len = netaddr_get_maxprefix(addr); len >= 0; len--) {
+    if (lpm->_prefix_count[len] == 0) {
+      continue;
+    }
+
+    netaddr_set_prefix_length(&key, len);
+    netaddr_truncate(&key, &key);
+
+    node = hashmap_find_element(&lpm->_map, &key, node, _node);
+    if (node) {
+      return node;
+    }
+  }
+  return NULL;
+}
@@ -621,6 +621,63 @@ rfc5444_writer_forward_msg(
   return RFC5444_OKAY;
 }
 
+/**
+ * Write a previously generated binary rfc5444 message into the
+ * packet buffer of a target. The message is copied unchanged,
+ * post-processors are not run on it again.
+ * This function must NOT be called from the rfc5444 writer callbacks.
+ *
+ * @param writer pointer to writer context
+ * @param target pointer to writer target
+ * @param msg pointer to binary message
+ * @param len number of bytes of message
+ * @return RFC5444_OKAY if the message was put into the writer buffer,
+ *   RFC5444_FW_MESSAGE_TOO_LONG if the message does not fit into a packet
+ */
+enum rfc5444_result
+rfc5444_writer_add_binary_msg(
+  struct rfc5444_writer *writer, struct rfc5444_writer_target *target, const uint8_t *msg, size_t len)
+{
+  uint8_t *ptr;
+  size_t max;
+#if WRITER_STATE_MACHINE == true
+  assert(writer->_state == RFC5444_WRITER_NONE);
+#endif
+
+  if (!target->_is_flushed) {
+    max =
+      target->_pkt.max - (target->_pkt.header + target->_pkt.added + target->_pkt.allocated + target->_bin_msgs_size);
+
+    if (len > max) {
+      /* flush the old packet */
+      rfc5444_writer_flush(writer, target, false);
+    }
+  }
+
+  if (target->_is_flushed) {
+    /* begin a new packet */
+    _rfc5444_writer_begin_packet(writer, target);
+  }
+
+  max =
+    target->_pkt.max - (target->_pkt.header + target->_pkt.added + target->_pkt.allocated + target->_bin_msgs_size);
+  if (len > max) {
+    /* message too long for a packet */
+    return RFC5444_FW_MESSAGE_TOO_LONG;
+  }
+
+  /* copy message into packet buffer */
+  ptr =
+    &target->_pkt.buffer[target->_pkt.header + target->_pkt.added + target->_pkt.allocated + target->_bin_msgs_size];
+  memcpy(ptr, msg, len);
+  target->_bin_msgs_size += len;
+
+  if (writer->message_generation_notifier) {
+    writer->message_generation_notifier(target);
+  }
+  return RFC5444_OKAY;
+}
+
 /**
  * Adds a tlv to a message.
  * This function must not be called outside the message add_tlv callback.
@@ -96,18 +96,18 @@ struct ff_dat_if_config {
 };
 
 /**
- * a single history memory cell, stores the metric
- * data for a single update interval
+ * history ringbuffer of a link, each array stores one value
+ * for DAT_SAMPLING_COUNT update intervals
  */
-struct link_datff_bucket {
+struct link_datff_history {
   /*! number of RFC5444 packets received in time interval */
-  uint32_t received;
+  uint32_t received[DAT_SAMPLING_COUNT];
 
   /*! sum of received and lost RFC5444 packets in time interval */
-  uint32_t total;
+  uint32_t total[DAT_SAMPLING_COUNT];
 
   /*! link speed in bit/s */
-  int64_t raw_speed;
+  int64_t raw_speed[DAT_SAMPLING_COUNT];
 };
 
 /**
@@ -142,7 +142,7 @@ struct link_datff_data {
   uint32_t link_neigborhood;
 
   /*! history ringbuffer */
-  struct link_datff_bucket buckets[DAT_SAMPLING_COUNT];
+  struct link_datff_history history;
 };
 
 /* prototypes */
@@ -161,11 +161,13 @@ static void _cb_nhdpif_added(void *);
 static void _cb_nhdpif_removed(void *);
 
 static void _cb_dat_sampling(struct oonf_timer_instance *);
+static void _sample_link(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk, struct link_datff_data *ldata);
 static void _calculate_link_neighborhood(struct nhdp_link *lnk, struct link_datff_data *ldata);
 static int _calculate_dynamic_loss_exponent(int link_neigborhood);
 
 static int64_t _get_raw_rx_linkspeed(struct nhdp_link *lnk);
-static int _get_median_rx_linkspeed(struct link_datff_data *ldata);
+static int64_t _select_kth_element(int64_t *array, size_t count, size_t k);
+static int64_t _get_median_rx_linkspeed(struct link_datff_data *ldata);
 
 static int64_t _get_bitrate_cost_factor(struct link_datff_data *ldata, struct nhdp_link *lnk, int64_t *bitrate);
 static int64_t _get_lossrate_cost_factor(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk,
@@ -340,8 +342,8 @@ static struct nhdp_domain_metric _datff_handler = {
 #endif
 };
 
-/* Temporary buffer to sort incoming link speed for median calculation */
-static int _rx_sort_array[DAT_SAMPLING_COUNT] = { 0 };
+/* Temporary buffer to select the median of the incoming link speed */
+static int64_t _rx_select_array[DAT_SAMPLING_COUNT] = { 0 };
 
 /* ff_dat has multiple logging targets */
 enum oonf_log_source LOG_FF_DAT;
@@ -467,9 +469,8 @@ _cb_link_added(void *ptr) {
   memset(data, 0, sizeof(*data));
   // data->contains_data = false;
 
-  for (i = 0; i < ARRAYSIZE(data->buckets); i++) {
-    data->buckets[i].total = 1;
-    // data->buckets[i].scaled_speed = 0;
+  for (i = 0; i < DAT_SAMPLING_COUNT; i++) {
+    data->history.total[i] = 1;
   }
 
   /* initialize 'hello lost' timer for link */
@@ -554,52 +555,79 @@ _cb_nhdpif_removed(void *ptr) {
 }
 
 /**
- * Helper for sorting datarate array
- * @param p1 pointer to integer 1
- * @param p2 pointer to integer 2
- * @return <0, 0 >0 (standard comparator output)
+ * Select the k-th smallest element of an array without sorting it
+ * completely (Hoare's selection algorithm). The array will be reordered.
+ * @param array array of integers
+ * @param count number of elements in array
+ * @param k index of element to select (0 for smallest element)
+ * @return k-th smallest element
  */
-static int
-_int_comparator(const void *p1, const void *p2) {
-  const int *i1 = (int *)p1;
-  const int *i2 = (int *)p2;
+static int64_t
+_select_kth_element(int64_t *array, size_t count, size_t k) {
+  size_t left, right, i, j;
+  int64_t pivot, tmp;
+
+  left = 0;
+  right = count - 1;
+  while (left < right) {
+    pivot = array[left + (right - left) / 2];
+    i = left;
+    j = right;
+
+    while (i <= j) {
+      while (array[i] < pivot) {
+        i++;
+      }
+      while (array[j] > pivot) {
+        j--;
+      }
+      if (i <= j) {
+        tmp = array[i];
+        array[i] = array[j];
+        array[j] = tmp;
+        i++;
+        if (j == 0) {
+          break;
+        }
+        j--;
+      }
+    }
 
-  if (*i1 > *i2) {
-    return 1;
-  }
-  else if (*i1 < *i2) {
-    return -1;
+    if (k <= j) {
+      right = j;
+    }
+    else if (k >= i) {
+      left = i;
+    }
+    else {
+      break;
+    }
   }
-  return 0;
+  return array[k];
 }
 
 /**
- * Get the median of all recorded link speeds by sorting
+ * Get the median of all recorded link speeds
  * @param ldata linkdata
- * @return median linkspeed
+ * @return median linkspeed, -1 if no link speed was recorded
  */
-static int
+static int64_t
 _get_median_rx_linkspeed(struct link_datff_data *ldata) {
-  int zero_count;
   size_t window;
   size_t i;
 
-  zero_count = 0;
-  for (i = 0; i < ARRAYSIZE(ldata->buckets); i++) {
-    _rx_sort_array[i] = ldata->buckets[i].raw_speed;
-    if (_rx_sort_array[i] <= 0) {
-      zero_count++;
+  /* only use buckets with a valid link speed */
+  window = 0;
+  for (i = 0; i < DAT_SAMPLING_COUNT; i++) {
+    if (ldata->history.raw_speed[i] > 0) {
+      _rx_select_array[window++] = ldata->history.raw_speed[i];
     }
   }
 
-  window = ARRAYSIZE(ldata->buckets) - zero_count;
   if (window == 0) {
     return -1;
   }
-
-  qsort(_rx_sort_array, ARRAYSIZE(ldata->buckets), sizeof(int), _int_comparator);
-
-  return _rx_sort_array[zero_count + window / 2];
+  return _select_kth_element(_rx_select_array, window, window / 2);
 }
 
 /**
@@ -671,7 +699,7 @@ _scale_linkspeed(struct nhdp_link *lnk __attribute__((unused)), int64_t raw_rx_r
 
 static int64_t
 _get_bitrate_cost_factor(struct link_datff_data *ldata, struct nhdp_link *lnk, int64_t *bitrate) {
-  int rx_bitrate;
+  int64_t rx_bitrate;
   struct netaddr_str nbuf;
 
   /* get median scaled link speed and apply it to metric */
@@ -685,7 +713,7 @@ _get_bitrate_cost_factor(struct link_datff_data *ldata, struct nhdp_link *lnk, i
     return -1;
   }
   if (rx_bitrate > DATFF_LINKSPEED_RANGE) {
-    OONF_WARN(LOG_FF_DAT, "Metric overflow for link %s (if %s): %d", netaddr_to_string(&nbuf, &lnk->if_addr),
+    OONF_WARN(LOG_FF_DAT, "Metric overflow for link %s (if %s): %" PRId64, netaddr_to_string(&nbuf, &lnk->if_addr),
       nhdp_interface_get_name(lnk->local_if), rx_bitrate);
     return (1000ll * DATFF_LINKSPEED_RANGE);
   }
@@ -902,8 +930,9 @@ _shape_metric(uint64_t metric, const char *ifname, struct netaddr *link_id) {
 }
 
 /**
- * Timer callback to sample new metric values into bucket
- * @param ptr nhdp link
+ * Timer callback to sample new metric values of all links of an interface
+ * into their buckets
+ * @param ptr timer instance of interface
  */
 static void
 _cb_dat_sampling(struct oonf_timer_instance *ptr) {
@@ -911,20 +940,13 @@ _cb_dat_sampling(struct oonf_timer_instance *ptr) {
   struct link_datff_data *ldata;
   struct nhdp_interface *nhdp_if;
   struct nhdp_link *lnk;
-  uint32_t total, received;
-  uint64_t mic_cost, throughput_cost, dat_metric;
-  uint32_t metric_value;
-  uint32_t missing_intervals;
-  size_t i;
-#ifdef OONF_LOG_DEBUG_INFO
-  struct netaddr_str nbuf;
-#endif
 
   ifconfig = container_of(ptr, struct ff_dat_if_config, _sampling_timer);
 
   OONF_DEBUG(LOG_FF_DAT, "Calculate Metric from sampled data");
 
   nhdp_if = oonf_class_get_base(&_nhdpif_extenstion, ifconfig);
+
   list_for_each_element(&nhdp_if->_links, lnk, _if_node) {
     ldata = oonf_class_get_extension(&_link_extenstion, lnk);
     if (!ldata->contains_data) {
@@ -932,59 +954,83 @@ _cb_dat_sampling(struct oonf_timer_instance *ptr) {
       continue;
     }
 
-    /* initialize counter */
-    total = 0;
-    received = 0;
+    _sample_link(ifconfig, lnk, ldata);
+  }
 
-    /* calculate metric */
-    for (i = 0; i < ARRAYSIZE(ldata->buckets); i++) {
-      received += ldata->buckets[i].received;
-      total += ldata->buckets[i].total;
-    }
+  oonf_timer_set(&ifconfig->_sampling_timer, nhdp_if->refresh_interval);
+}
 
-    if (ldata->missed_hellos > 0) {
-      missing_intervals = (ldata->missed_hellos * ldata->hello_interval) / lnk->local_if->refresh_interval;
-      if (missing_intervals > ARRAYSIZE(ldata->buckets)) {
-        received = 0;
-      }
-      else {
-        received = (received * (ARRAYSIZE(ldata->buckets) - missing_intervals)) / ARRAYSIZE(ldata->buckets);
-      }
+/**
+ * Calculate a new metric of a link from its sampled data
+ * and advance its history ringbuffer
+ * @param ifconfig datff interface configuration
+ * @param lnk nhdp link
+ * @param ldata datff link data
+ */
+static void
+_sample_link(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk, struct link_datff_data *ldata) {
+  uint32_t total, received;
+  uint64_t mic_cost, throughput_cost, dat_metric;
+  uint32_t metric_value;
+  uint32_t missing_intervals;
+  size_t i;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  /* initialize counter */
+  total = 0;
+  received = 0;
+
+  /* calculate metric */
+  for (i = 0; i < DAT_SAMPLING_COUNT; i++) {
+    received += ldata->history.received[i];
+  }
+  for (i = 0; i < DAT_SAMPLING_COUNT; i++) {
+    total += ldata->history.total[i];
+  }
+
+  if (ldata->missed_hellos > 0) {
+    missing_intervals = (ldata->missed_hellos * ldata->hello_interval) / lnk->local_if->refresh_interval;
+    if (missing_intervals > DAT_SAMPLING_COUNT) {
+      received = 0;
+    }
+    else {
+      received = (received * (DAT_SAMPLING_COUNT - missing_intervals)) / DAT_SAMPLING_COUNT;
     }
+  }
 
-    /* update link speed */
-    ldata->buckets[ldata->activePtr].raw_speed = _get_raw_rx_linkspeed(lnk);
+  /* update link speed */
+  ldata->history.raw_speed[ldata->activePtr] = _get_raw_rx_linkspeed(lnk);
 
-    OONF_DEBUG(LOG_FF_DAT, "Query incoming linkspeed for link %s: %" PRId64, netaddr_to_string(&nbuf, &lnk->if_addr),
-      ldata->buckets[ldata->activePtr].raw_speed);
+  OONF_DEBUG(LOG_FF_DAT, "Query incoming linkspeed for link %s: %" PRId64, netaddr_to_string(&nbuf, &lnk->if_addr),
+    ldata->history.raw_speed[ldata->activePtr]);
 
-    /* calculate cost components of metric */
-    throughput_cost = _get_throughput_cost_factor(ifconfig, lnk, ldata, received, total);
-    mic_cost = _get_mic_cost_factor(ifconfig, lnk, ldata);
+  /* calculate cost components of metric */
+  throughput_cost = _get_throughput_cost_factor(ifconfig, lnk, ldata, received, total);
+  mic_cost = _get_mic_cost_factor(ifconfig, lnk, ldata);
 
-    /* calculate total metric (not multiplied by 1000) */
-    dat_metric = (throughput_cost * mic_cost) / 1000000ll;
+  /* calculate total metric (not multiplied by 1000) */
+  dat_metric = (throughput_cost * mic_cost) / 1000000ll;
 
-    /* shape metric into transmittable format */
-    metric_value = _shape_metric(dat_metric, nhdp_interface_get_name(lnk->local_if), &lnk->if_addr);
+  /* shape metric into transmittable format */
+  metric_value = _shape_metric(dat_metric, nhdp_interface_get_name(lnk->local_if), &lnk->if_addr);
 
-    /* set metric for incoming link */
-    nhdp_domain_set_incoming_metric(&_datff_handler, lnk, metric_value);
+  /* set metric for incoming link */
+  nhdp_domain_set_incoming_metric(&_datff_handler, lnk, metric_value);
 
-    OONF_DEBUG(LOG_FF_DAT,
-      "New sampling rate for link %s (%s): %d/%d = %u\n",
-      netaddr_to_string(&nbuf, &lnk->if_addr), nhdp_interface_get_name(lnk->local_if),
-      received, total, metric_value);
+  OONF_DEBUG(LOG_FF_DAT,
+    "New sampling rate for link %s (%s): %d/%d = %u\n",
+    netaddr_to_string(&nbuf, &lnk->if_addr), nhdp_interface_get_name(lnk->local_if),
+    received, total, metric_value);
 
-    /* update rolling buffer */
-    ldata->activePtr++;
-    if (ldata->activePtr >= ARRAYSIZE(ldata->buckets)) {
-      ldata->activePtr = 0;
-    }
-    ldata->buckets[ldata->activePtr].received = 0;
-    ldata->buckets[ldata->activePtr].total = 0;
+  /* update rolling buffer */
+  ldata->activePtr++;
+  if (ldata->activePtr >= DAT_SAMPLING_COUNT) {
+    ldata->activePtr = 0;
   }
-  oonf_timer_set(&ifconfig->_sampling_timer, nhdp_if->refresh_interval);
+  ldata->history.received[ldata->activePtr] = 0;
+  ldata->history.total[ldata->activePtr] = 0;
 }
 
 /**
@@ -995,7 +1041,6 @@ _cb_dat_sampling(struct oonf_timer_instance *ptr) {
 static void
 _calculate_link_neighborhood(struct nhdp_link *lnk, struct link_datff_data *data) {
   struct nhdp_l2hop *l2hop;
-  struct nhdp_laddr *laddr;
   int count;
 
   /* local link neighbors */
@@ -1004,7 +1049,7 @@ _calculate_link_neighborhood(struct nhdp_link *lnk, struct link_datff_data *data
   /* links twohop neighbors */
   avl_for_each_element(&lnk->_2hop, l2hop, _link_node) {
     if (l2hop->same_interface &&
-        !avl_find_element(&lnk->local_if->_link_addresses, &l2hop->twohop_addr, laddr, _if_node)) {
+        !nhdp_interface_get_link_addr(lnk->local_if, &l2hop->twohop_addr)) {
       count++;
     }
   }
@@ -1145,8 +1190,8 @@ _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
   if (!ldata->contains_data) {
     ldata->contains_data = true;
     ldata->activePtr = 0;
-    ldata->buckets[0].received = 1;
-    ldata->buckets[0].total = 1;
+    ldata->history.received[0] = 1;
+    ldata->history.total[0] = 1;
     ldata->last_seq_nr = context->pkt_seqno;
 
     return RFC5444_OKAY;
@@ -1159,8 +1204,8 @@ _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
     total = ((uint32_t)(context->pkt_seqno) + 65536) - (uint32_t)(ldata->last_seq_nr);
   }
 
-  ldata->buckets[ldata->activePtr].received++;
-  ldata->buckets[ldata->activePtr].total += total;
+  ldata->history.received[ldata->activePtr]++;
+  ldata->history.total[ldata->activePtr] += total;
   ldata->last_seq_nr = context->pkt_seqno;
 
   _reset_missed_hello_timer(ldata);
@@ -1245,14 +1290,14 @@ _int_link_to_string(struct nhdp_metric_str *buf, struct nhdp_link *lnk) {
 
   ldata = oonf_class_get_extension(&_link_extenstion, lnk);
 
-  for (i = 0; i < ARRAYSIZE(ldata->buckets); i++) {
-    received += ldata->buckets[i].received;
-    total += ldata->buckets[i].total;
+  for (i = 0; i < DAT_SAMPLING_COUNT; i++) {
+    received += ldata->history.received[i];
+    total += ldata->history.total[i];
   }
 
   snprintf(buf->buf, sizeof(*buf),
     "p_recv=%" PRId64 ",p_total=%" PRId64 ","
-    "speed=%d,success=%" PRId64 ",missed_hello=%d,lastseq=%u,lneigh=%d",
+    "speed=%" PRId64 ",success=%" PRId64 ",missed_hello=%d,lastseq=%u,lneigh=%d",
     received, total, _get_median_rx_linkspeed(ldata), ldata->last_packet_loss_rate,
     ldata->missed_hellos, ldata->last_seq_nr, ldata->link_neigborhood);
   return buf->buf;
@@ -51,9 +51,11 @@
 #include <oonf/libcore/oonf_logging.h>
 #include <oonf/libcore/oonf_subsystem.h>
 #include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
 #include <oonf/base/oonf_rfc5444.h>
 #include <oonf/base/oonf_timer.h>
 
+#include <oonf/nhdp/nhdp/nhdp_db.h>
 #include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
 #include <oonf/nhdp/nhdp/nhdp_interfaces.h>
 
@@ -62,6 +64,9 @@
 /* definitions and constants */
 #define LOG_HYSTERESIS_OLSRV1 _olsrv2_hysteresis_olsrv1_subsystem.logging
 
+/*! maximum link quality (1.0 multiplied by 1000) */
+#define HYSTERESIS_QUALITY_MAX 1000
+
 /**
  * hysteresis plugin configuration
  */
@@ -74,17 +79,25 @@ struct _config {
 
   /*! alpha factor for exponential aging (multiplied by 1000) */
   int scaling;
+
+  /*! interval between two checks for lost Hellos */
+  uint64_t lost_sweep;
+};
+
+/**
+ * extension of nhdp_interface class for hysteresis calculation
+ */
+struct if_hysteresis_data {
+  /*! timer to check all links of the interface for lost Hellos */
+  struct oonf_timer_instance sweep_timer;
 };
 
 /**
  * extension of nhdp_link class for hysteresis calculation
  */
 struct link_hysteresis_data {
-  /*! timer until the next NHDP Hello should arrive */
-  struct oonf_timer_instance interval_timer;
-
-  /*! back pointer to NHDP link */
-  struct nhdp_link *nhdp_link;
+  /*! absolute time when the next NHDP Hello should have arrived, 0 if none */
+  uint64_t hello_due;
 
   /*! itime time delivered by neighbors Hello */
   uint64_t itime;
@@ -104,16 +117,18 @@ static int _init(void);
 static void _cleanup(void);
 
 static void _update_hysteresis(struct nhdp_link *, struct link_hysteresis_data *, bool);
+static void _update_quality_tables(void);
 
 static void _cb_link_added(void *);
-static void _cb_link_removed(void *);
+static void _cb_interface_added(void *);
+static void _cb_interface_removed(void *);
 
 static void _cb_update_hysteresis(struct nhdp_link *, struct rfc5444_reader_tlvblock_context *context);
 static bool _cb_is_pending(struct nhdp_link *);
 static bool _cb_is_lost(struct nhdp_link *);
 static const char *_cb_to_string(struct nhdp_hysteresis_str *, struct nhdp_link *);
 
-static void _cb_timer_hello_lost(struct oonf_timer_instance *);
+static void _cb_sweep_hello_lost(struct oonf_timer_instance *);
 static void _cb_cfg_changed(void);
 static int _cb_cfg_validate(const char *section_name, struct cfg_named_section *, struct autobuf *);
 
@@ -123,6 +138,7 @@ static struct cfg_schema_entry _hysteresis_entries[] = {
   CFG_MAP_INT32_MINMAX(_config, reject, "reject", "0.3", "link quality to consider a link down", 3, 0, 1000),
   CFG_MAP_INT32_MINMAX(
     _config, scaling, "scaling", "0.25", "exponential aging to control speed of link hysteresis", 3, 1, 1000),
+  CFG_MAP_CLOCK_MIN(_config, lost_sweep, "lost_sweep", "0.1", "Time interval between two checks for lost Hellos", 10),
 };
 
 static struct cfg_schema_section _hysteresis_section = {
@@ -135,9 +151,14 @@ static struct cfg_schema_section _hysteresis_section = {
 
 static struct _config _hysteresis_config;
 
+/* new link quality for each old link quality after a lost or received Hello */
+static uint16_t _quality_lost[HYSTERESIS_QUALITY_MAX + 1];
+static uint16_t _quality_received[HYSTERESIS_QUALITY_MAX + 1];
+
 /* plugin declaration */
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
   OONF_RFC5444_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
   OONF_NHDP_SUBSYSTEM,
@@ -162,13 +183,22 @@ static struct oonf_class_extension _link_extenstion = {
   .class_name = NHDP_CLASS_LINK,
   .size = sizeof(struct link_hysteresis_data),
   .cb_add = _cb_link_added,
-  .cb_remove = _cb_link_removed,
 };
 
-/* timer class to measure itime between Hellos */
-static struct oonf_timer_class _hello_timer_info = {
-  .name = "Hello itime timeout for hysteresis",
-  .callback = _cb_timer_hello_lost,
+/* storage extension for nhdp_interface */
+static struct oonf_class_extension _interface_extenstion = {
+  .ext_name = OONF_HYSTERESIS_OLSRV1_SUBSYSTEM,
+  .class_name = NHDP_CLASS_INTERFACE,
+  .size = sizeof(struct if_hysteresis_data),
+  .cb_add = _cb_interface_added,
+  .cb_remove = _cb_interface_removed,
+};
+
+/* timer class to check all links of an interface for lost Hellos */
+static struct oonf_timer_class _hello_sweep_info = {
+  .name = "Hello lost sweep for hysteresis",
+  .callback = _cb_sweep_hello_lost,
+  .periodic = true,
 };
 
 /* hysteresis handler */
@@ -198,6 +228,21 @@ _init(void) {
     return -1;
   }
 
+  oonf_timer_add(&_hello_sweep_info);
+  if (oonf_class_is_extension_registered(&_interface_extenstion)) {
+    struct nhdp_interface *nhdp_if;
+
+    /* add all custom extensions for interfaces */
+    avl_for_each_element(nhdp_interface_get_tree(), nhdp_if, _node) {
+      _cb_interface_added(nhdp_if);
+    }
+  }
+  else if (oonf_class_extension_add(&_interface_extenstion)) {
+    oonf_timer_remove(&_hello_sweep_info);
+    oonf_class_extension_remove(&_link_extenstion);
+    return -1;
+  }
+
   nhdp_hysteresis_set_handler(&_hysteresis_handler);
   return 0;
 }
@@ -207,15 +252,17 @@ _init(void) {
  */
 static void
 _cleanup(void) {
-  struct nhdp_link *lnk;
+  struct nhdp_interface *nhdp_if;
 
-  /* remove all custom extensions for link */
-  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
-    _cb_link_removed(lnk);
+  /* remove all custom extensions for interfaces */
+  avl_for_each_element(nhdp_interface_get_tree(), nhdp_if, _node) {
+    _cb_interface_removed(nhdp_if);
   }
 
   nhdp_hysteresis_set_handler(NULL);
+  oonf_class_extension_remove(&_interface_extenstion);
   oonf_class_extension_remove(&_link_extenstion);
+  oonf_timer_remove(&_hello_sweep_info);
 }
 
 /**
@@ -226,12 +273,8 @@ _cleanup(void) {
  */
 static void
 _update_hysteresis(struct nhdp_link *lnk, struct link_hysteresis_data *data, bool lost) {
-  /* calculate exponential aging */
-  data->quality = data->quality * (1000 - _hysteresis_config.scaling);
-  data->quality = (data->quality + 999) / 1000;
-  if (!lost) {
-    data->quality += _hysteresis_config.scaling;
-  }
+  /* exponential aging, precalculated for all possible qualities */
+  data->quality = lost ? _quality_lost[data->quality] : _quality_received[data->quality];
 
   if (!data->pending && !data->lost) {
     if (data->quality < _hysteresis_config.reject) {
@@ -248,6 +291,23 @@ _update_hysteresis(struct nhdp_link *lnk, struct link_hysteresis_data *data, boo
   }
 }
 
+/**
+ * Precalculate the exponential aging of the link quality for
+ * lost and received Hellos for the current scaling factor
+ */
+static void
+_update_quality_tables(void) {
+  int32_t quality, aged;
+
+  for (quality = 0; quality <= HYSTERESIS_QUALITY_MAX; quality++) {
+    aged = quality * (HYSTERESIS_QUALITY_MAX - _hysteresis_config.scaling);
+    aged = (aged + HYSTERESIS_QUALITY_MAX - 1) / HYSTERESIS_QUALITY_MAX;
+
+    _quality_lost[quality] = aged;
+    _quality_received[quality] = aged + _hysteresis_config.scaling;
+  }
+}
+
 /**
  * Callback triggered when a new nhdp link is added
  * @param ptr nhdp link
@@ -259,21 +319,33 @@ _cb_link_added(void *ptr) {
 
   memset(data, 0, sizeof(*data));
   data->pending = true;
-  data->nhdp_link = ptr;
+}
 
-  data->interval_timer.class = &_hello_timer_info;
+/**
+ * Callback triggered when a new nhdp interface is added
+ * @param ptr nhdp interface
+ */
+static void
+_cb_interface_added(void *ptr) {
+  struct if_hysteresis_data *data;
+  data = oonf_class_get_extension(&_interface_extenstion, ptr);
+
+  data->sweep_timer.class = &_hello_sweep_info;
+  if (_hysteresis_config.lost_sweep) {
+    oonf_timer_set(&data->sweep_timer, _hysteresis_config.lost_sweep);
+  }
 }
 
 /**
- * Callback triggered when a nhdp link will be removed
- * @param ptr nhdp link
+ * Callback triggered when a nhdp interface will be removed
+ * @param ptr nhdp interface
  */
 static void
-_cb_link_removed(void *ptr) {
-  struct link_hysteresis_data *data;
-  data = oonf_class_get_extension(&_link_extenstion, ptr);
+_cb_interface_removed(void *ptr) {
+  struct if_hysteresis_data *data;
+  data = oonf_class_get_extension(&_interface_extenstion, ptr);
 
-  oonf_timer_stop(&data->interval_timer);
+  oonf_timer_stop(&data->sweep_timer);
 }
 
 /**
@@ -294,11 +366,11 @@ _cb_update_hysteresis(struct nhdp_link *lnk, struct rfc5444_reader_tlvblock_cont
   /* store itime */
   data->itime = lnk->itime_value;
 
-  /* first timer gets a delay */
+  /* first timeout gets a delay */
   if (data->itime == 0) {
     data->itime = lnk->vtime_value;
   }
-  oonf_timer_set(&data->interval_timer, (data->itime * 3) / 2);
+  data->hello_due = oonf_clock_get_absolute((data->itime * 3) / 2);
 }
 
 /**
@@ -347,20 +419,38 @@ _cb_to_string(struct nhdp_hysteresis_str *buf, struct nhdp_link *lnk) {
 }
 
 /**
- * Timer callback triggered when Hello was lost
+ * Timer callback to check all links of an interface for lost Hellos
  * @param ptr timer instance that fired
  */
 static void
-_cb_timer_hello_lost(struct oonf_timer_instance *ptr) {
+_cb_sweep_hello_lost(struct oonf_timer_instance *ptr) {
+  struct if_hysteresis_data *ifdata;
   struct link_hysteresis_data *data;
-
-  data = container_of(ptr, struct link_hysteresis_data, interval_timer);
-
-  /* update hysteresis because of lost Hello */
-  _update_hysteresis(data->nhdp_link, data, true);
-
-  /* reactivate timer */
-  oonf_timer_set(&data->interval_timer, data->itime);
+  struct nhdp_interface *nhdp_if;
+  struct nhdp_link *lnk, *lnk_it;
+  uint64_t now;
+
+  ifdata = container_of(ptr, struct if_hysteresis_data, sweep_timer);
+  nhdp_if = oonf_class_get_base(&_interface_extenstion, ifdata);
+  now = oonf_clock_getNow();
+
+  nhdp_db_transaction_start();
+  list_for_each_element_safe(&nhdp_if->_links, lnk, _if_node, lnk_it) {
+    data = oonf_class_get_extension(&_link_extenstion, lnk);
+
+    /* update hysteresis for each lost Hello since the last sweep */
+    while (data->hello_due != 0 && data->hello_due <= now) {
+      _update_hysteresis(lnk, data, true);
+
+      if (data->itime == 0) {
+        data->hello_due = 0;
+      }
+      else {
+        data->hello_due += data->itime;
+      }
+    }
+  }
+  nhdp_db_transaction_commit();
 }
 
 /**
@@ -368,9 +458,18 @@ _cb_timer_hello_lost(struct oonf_timer_instance *ptr) {
  */
 static void
 _cb_cfg_changed(void) {
+  struct nhdp_interface *nhdp_if;
+
   if (cfg_schema_tobin(
         &_hysteresis_config, _hysteresis_section.post, _hysteresis_entries, ARRAYSIZE(_hysteresis_entries))) {
     OONF_WARN(LOG_HYSTERESIS_OLSRV1, "Could not convert " OONF_HYSTERESIS_OLSRV1_SUBSYSTEM " plugin configuration");
+    return;
+  }
+
+  _update_quality_tables();
+
+  avl_for_each_element(nhdp_interface_get_tree(), nhdp_if, _node) {
+    _cb_interface_added(nhdp_if);
   }
 }
 
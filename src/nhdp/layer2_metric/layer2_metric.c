@@ -0,0 +1,619 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+
+#include <oonf/libcommon/autobuf.h>
+#include <oonf/libcommon/isonumber.h>
+#include <oonf/oonf.h>
+#include <oonf/libconfig/cfg_schema.h>
+#include <oonf/libcore/oonf_cfg.h>
+#include <oonf/libcore/oonf_logging.h>
+#include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_layer2.h>
+#include <oonf/base/os_interface.h>
+
+#include <oonf/nhdp/nhdp/nhdp.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+#include <oonf/nhdp/layer2_metric/layer2_metric.h>
+
+/* constants and definitions */
+#define LOG_L2METRIC _layer2_metric_subsystem.logging
+
+/**
+ * Configuration settings of layer2 metric
+ */
+struct l2metric_if_config {
+  /*! true if the receiver link quality should scale the bitrate */
+  bool rlq;
+
+  /*! additional link cost per millisecond of latency (in 1/1000) */
+  int32_t latency_penalty;
+
+  /*! true if the link cost should be scaled by the available radio resources */
+  bool resources;
+
+  /*! true if we registered the interface */
+  bool registered;
+};
+
+/* prototypes */
+static int _init(void);
+static void _cleanup(void);
+
+static void _cb_enable_metric(void);
+static void _cb_disable_metric(void);
+
+static void _cb_link_changed(void *);
+static void _cb_l2neigh_changed(void *);
+static void _cb_l2neigh_removed(void *);
+
+static void _update_l2neigh_links(struct oonf_layer2_neigh *l2neigh, bool removed);
+static bool _update_link(struct nhdp_link *lnk);
+static enum nhdp_metric_result _calculate_cost(uint32_t *cost, struct l2metric_if_config *ifconfig,
+  struct oonf_layer2_net *l2net, struct oonf_layer2_neigh *l2neigh);
+static int64_t _get_l2value(struct oonf_layer2_net *l2net, struct oonf_layer2_neigh *l2neigh,
+  enum oonf_layer2_neighbor_index idx, uint64_t scale);
+static uint32_t _shape_metric(uint64_t metric);
+
+static enum nhdp_metric_result _cb_get_metric(
+  struct nhdp_domain *domain, uint32_t *metric, struct oonf_layer2_neigh *neigh);
+
+static const char *_link_to_string(struct nhdp_metric_str *buf, uint32_t metric);
+static const char *_path_to_string(struct nhdp_metric_str *buf, uint32_t metric, uint8_t hopcount);
+
+static void _cb_cfg_changed(void);
+
+/* plugin declaration */
+static struct cfg_schema_entry _l2metric_entries[] = {
+  CFG_MAP_BOOL(l2metric_if_config, rlq, "l2metric_rlq", "true",
+    "Scale the incoming bitrate with the receiver link quality if no throughput is available"),
+  CFG_MAP_INT32_MINMAX(l2metric_if_config, latency_penalty, "l2metric_latency_penalty", "0",
+    "Additional link cost (in percent) for each millisecond of latency reported by the radio", 1, 0, 100000),
+  CFG_MAP_BOOL(l2metric_if_config, resources, "l2metric_resources", "false",
+    "Scale the link cost with the available resources reported by the radio"),
+};
+
+static struct cfg_schema_section _l2metric_section = {
+  CFG_OSIF_SCHEMA_INTERFACE_SECTION_INIT,
+
+  .cb_delta_handler = _cb_cfg_changed,
+  .entries = _l2metric_entries,
+  .entry_count = ARRAYSIZE(_l2metric_entries),
+};
+
+static const char *_dependencies[] = {
+  OONF_CLASS_SUBSYSTEM,
+  OONF_LAYER2_SUBSYSTEM,
+  OONF_NHDP_SUBSYSTEM,
+  OONF_OS_INTERFACE_SUBSYSTEM,
+};
+static struct oonf_subsystem _layer2_metric_subsystem = {
+  .name = OONF_LAYER2_METRIC_SUBSYSTEM,
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .descr = "NHDP metric plugin based on layer2 database values",
+  .author = "the olsr.org team",
+
+  .cfg_section = &_l2metric_section,
+
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_layer2_metric_subsystem);
+
+/* storage extension and listeners */
+static struct oonf_class_extension _link_extenstion = {
+  .ext_name = "layer2 linkmetric",
+  .class_name = NHDP_CLASS_LINK,
+
+  .cb_add = _cb_link_changed,
+  .cb_change = _cb_link_changed,
+};
+
+static struct oonf_class_extension _nhdpif_extenstion = {
+  .ext_name = "layer2 linkmetric",
+  .class_name = NHDP_CLASS_INTERFACE,
+  .size = sizeof(struct l2metric_if_config),
+};
+
+static struct oonf_class_extension _l2neigh_extension = {
+  .ext_name = "layer2 linkmetric",
+  .class_name = LAYER2_CLASS_NEIGHBOR,
+
+  .cb_add = _cb_l2neigh_changed,
+  .cb_change = _cb_l2neigh_changed,
+  .cb_remove = _cb_l2neigh_removed,
+};
+
+/* nhdp metric handler */
+static const enum oonf_layer2_neighbor_index _required_l2neigh[] = {
+  OONF_LAYER2_NEIGH_RX_BITRATE,
+  OONF_LAYER2_NEIGH_RX_THROUGHPUT,
+};
+
+/* all layer2 neighbor data used for the link cost */
+static const enum oonf_layer2_neighbor_index _used_l2neigh[] = {
+  OONF_LAYER2_NEIGH_RX_BITRATE,
+  OONF_LAYER2_NEIGH_RX_THROUGHPUT,
+  OONF_LAYER2_NEIGH_RX_RLQ,
+  OONF_LAYER2_NEIGH_LATENCY,
+  OONF_LAYER2_NEIGH_RESOURCES,
+};
+
+static struct nhdp_domain_metric _l2metric_handler = {
+  .name = OONF_LAYER2_METRIC_SUBSYSTEM,
+
+  .metric_minimum = L2METRIC_LINKCOST_MINIMUM,
+  .metric_maximum = L2METRIC_LINKCOST_MAXIMUM,
+
+  .link_to_string = _link_to_string,
+  .path_to_string = _path_to_string,
+
+  .enable = _cb_enable_metric,
+  .disable = _cb_disable_metric,
+
+  .required_l2neigh_data = _required_l2neigh,
+  .required_l2neigh_count = ARRAYSIZE(_required_l2neigh),
+
+  .cb_get_metric = _cb_get_metric,
+};
+
+/* true if at least one domain uses the metric */
+static bool _active = false;
+
+/**
+ * Initialize plugin
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_init(void) {
+  if (nhdp_domain_metric_add(&_l2metric_handler)) {
+    return -1;
+  }
+
+  if (oonf_class_extension_add(&_nhdpif_extenstion)) {
+    nhdp_domain_metric_remove(&_l2metric_handler);
+    return -1;
+  }
+  if (oonf_class_extension_add(&_link_extenstion)) {
+    oonf_class_extension_remove(&_nhdpif_extenstion);
+    nhdp_domain_metric_remove(&_l2metric_handler);
+    return -1;
+  }
+  if (oonf_class_extension_add(&_l2neigh_extension)) {
+    oonf_class_extension_remove(&_link_extenstion);
+    oonf_class_extension_remove(&_nhdpif_extenstion);
+    nhdp_domain_metric_remove(&_l2metric_handler);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Cleanup plugin
+ */
+static void
+_cleanup(void) {
+  struct nhdp_interface *nhdp_if, *nhdp_if_it;
+  struct l2metric_if_config *ifconfig;
+
+  avl_for_each_element_safe(nhdp_interface_get_tree(), nhdp_if, _node, nhdp_if_it) {
+    ifconfig = oonf_class_get_extension(&_nhdpif_extenstion, nhdp_if);
+    if (ifconfig->registered) {
+      nhdp_interface_remove(nhdp_if);
+    }
+  }
+
+  /* remove metric from core */
+  nhdp_domain_metric_remove(&_l2metric_handler);
+
+  oonf_class_extension_remove(&_l2neigh_extension);
+  oonf_class_extension_remove(&_link_extenstion);
+  oonf_class_extension_remove(&_nhdpif_extenstion);
+}
+
+/**
+ * Enable metric calculation
+ */
+static void
+_cb_enable_metric(void) {
+  struct nhdp_neighbor *neigh;
+  struct nhdp_link *lnk;
+
+  _active = true;
+
+  /* set the metric of all existing links in one go */
+  nhdp_db_transaction_start();
+  list_for_each_element(nhdp_db_get_neigh_list(), neigh, _global_node) {
+    list_for_each_element(&neigh->_links, lnk, _neigh_node) {
+      _update_link(lnk);
+    }
+    nhdp_db_neighbor_update_metrics(neigh);
+  }
+  nhdp_db_transaction_commit();
+}
+
+/**
+ * Disable metric calculation
+ */
+static void
+_cb_disable_metric(void) {
+  _active = false;
+}
+
+/**
+ * Callback triggered when a nhdp link was added or changed, the
+ * remote MAC of the link might be known now.
+ * @param ptr nhdp link
+ */
+static void
+_cb_link_changed(void *ptr) {
+  struct nhdp_link *lnk = ptr;
+
+  if (_active && _update_link(lnk)) {
+    nhdp_db_neighbor_update_metrics(lnk->neigh);
+  }
+}
+
+/**
+ * Callback triggered when a layer2 neighbor was added or its data
+ * has been committed
+ * @param ptr layer2 neighbor
+ */
+static void
+_cb_l2neigh_changed(void *ptr) {
+  struct oonf_layer2_neigh *l2neigh;
+  size_t i;
+
+  if (!_active) {
+    return;
+  }
+
+  l2neigh = ptr;
+  for (i = 0; i < ARRAYSIZE(_used_l2neigh); i++) {
+    if (oonf_layer2_neigh_is_data_modified(l2neigh, _used_l2neigh[i])) {
+      _update_l2neigh_links(l2neigh, false);
+      return;
+    }
+  }
+}
+
+/**
+ * Callback triggered when a layer2 neighbor is removed
+ * @param ptr layer2 neighbor
+ */
+static void
+_cb_l2neigh_removed(void *ptr) {
+  if (_active) {
+    _update_l2neigh_links(ptr, true);
+  }
+}
+
+/**
+ * Recalculate the metric of all NHDP links to a layer2 neighbor
+ * @param l2neigh layer2 neighbor
+ * @param removed true if the layer2 neighbor is removed
+ */
+static void
+_update_l2neigh_links(struct oonf_layer2_neigh *l2neigh, bool removed) {
+  struct l2metric_if_config *ifconfig;
+  struct nhdp_interface *nhdp_if;
+  struct nhdp_link *lnk;
+  uint32_t cost;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  nhdp_if = nhdp_interface_get(l2neigh->network->name);
+  if (!nhdp_if) {
+    return;
+  }
+  ifconfig = oonf_class_get_extension(&_nhdpif_extenstion, nhdp_if);
+
+  OONF_DEBUG(LOG_L2METRIC, "Layer2 data of neighbor %s on %s %s", netaddr_to_string(&nbuf, &l2neigh->key.addr),
+    l2neigh->network->name, removed ? "removed" : "changed");
+
+  nhdp_db_transaction_start();
+  list_for_each_element(&nhdp_if->_links, lnk, _if_node) {
+    if (netaddr_cmp(&lnk->remote_mac, &l2neigh->key.addr) != 0) {
+      continue;
+    }
+
+    /* a removed neighbor can only fall back to the interface defaults */
+    if (_calculate_cost(&cost, ifconfig, l2neigh->network, removed ? NULL : l2neigh) == NHDP_METRIC_NOT_AVAILABLE) {
+      cost = RFC7181_METRIC_INFINITE;
+    }
+    if (nhdp_domain_set_incoming_metric(&_l2metric_handler, lnk, cost)) {
+      nhdp_db_neighbor_update_metrics(lnk->neigh);
+    }
+  }
+  nhdp_db_transaction_commit();
+}
+
+/**
+ * Set the incoming metric of a NHDP link from the layer2 database
+ * @param lnk nhdp link
+ * @return true if the metric changed
+ */
+static bool
+_update_link(struct nhdp_link *lnk) {
+  struct l2metric_if_config *ifconfig;
+  struct oonf_layer2_net *l2net;
+  uint32_t cost;
+
+  cost = RFC7181_METRIC_INFINITE;
+
+  l2net = oonf_layer2_net_get(nhdp_interface_get_name(lnk->local_if));
+  if (l2net) {
+    ifconfig = oonf_class_get_extension(&_nhdpif_extenstion, lnk->local_if);
+    if (_calculate_cost(&cost, ifconfig, l2net, oonf_layer2_neigh_get(l2net, &lnk->remote_mac))
+        == NHDP_METRIC_NOT_AVAILABLE) {
+      cost = RFC7181_METRIC_INFINITE;
+    }
+  }
+  return nhdp_domain_set_incoming_metric(&_l2metric_handler, lnk, cost);
+}
+
+/**
+ * Calculate the link cost of a layer2 neighbor
+ * @param cost pointer to target buffer for link cost
+ * @param ifconfig layer2 metric interface configuration
+ * @param l2net layer2 network of neighbor
+ * @param l2neigh layer2 neighbor, NULL to only use network defaults
+ * @return status of metric calculation
+ */
+static enum nhdp_metric_result
+_calculate_cost(uint32_t *cost, struct l2metric_if_config *ifconfig, struct oonf_layer2_net *l2net,
+  struct oonf_layer2_neigh *l2neigh) {
+  enum nhdp_metric_result result;
+  int64_t rate, rlq, latency, resources;
+  uint64_t speed, metric;
+
+  result = NHDP_METRIC_OKAY;
+
+  /* prefer the measured throughput of the radio */
+  rate = _get_l2value(l2net, l2neigh, OONF_LAYER2_NEIGH_RX_THROUGHPUT, 1);
+  if (rate <= 0) {
+    rate = _get_l2value(l2net, l2neigh, OONF_LAYER2_NEIGH_RX_BITRATE, 1);
+    result = NHDP_METRIC_PARTIAL_DATA;
+
+    rlq = _get_l2value(l2net, l2neigh, OONF_LAYER2_NEIGH_RX_RLQ, 1);
+    if (ifconfig->rlq && rate > 0 && rlq >= 0) {
+      rate = rate * rlq / 100;
+    }
+  }
+  if (rate <= 0) {
+    return NHDP_METRIC_NOT_AVAILABLE;
+  }
+
+  /* convert linkspeed into cost, round up */
+  speed = ((uint64_t)rate + L2METRIC_LINKSPEED_MINIMUM - 1) / L2METRIC_LINKSPEED_MINIMUM;
+  if (speed > L2METRIC_LINKSPEED_RANGE) {
+    speed = L2METRIC_LINKSPEED_RANGE;
+  }
+  metric = L2METRIC_LINKSPEED_RANGE / speed;
+
+  /* latency penalty, latency in milliseconds */
+  latency = _get_l2value(l2net, l2neigh, OONF_LAYER2_NEIGH_LATENCY, 1000);
+  if (ifconfig->latency_penalty > 0 && latency > 0) {
+    metric = metric * (1000ull + (uint64_t)latency * ifconfig->latency_penalty) / 1000ull;
+  }
+
+  /* available radio resources in percent */
+  resources = _get_l2value(l2net, l2neigh, OONF_LAYER2_NEIGH_RESOURCES, 1);
+  if (ifconfig->resources && resources >= 0) {
+    metric = metric * 100 / (resources > 0 ? resources : 1);
+  }
+
+  *cost = _shape_metric(metric);
+  return result;
+}
+
+/**
+ * Get a layer2 value of a neighbor, fall back to the network defaults
+ * @param l2net layer2 network
+ * @param l2neigh layer2 neighbor, might be NULL
+ * @param idx layer2 neighbor data index
+ * @param scale scaling of the result
+ * @return layer2 value, -1 if not available
+ */
+static int64_t
+_get_l2value(struct oonf_layer2_net *l2net, struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx,
+  uint64_t scale) {
+  if (l2neigh && oonf_layer2_data_has_value(&l2neigh->data[idx])) {
+    return oonf_layer2_data_get_int64(&l2neigh->data[idx], scale, -1);
+  }
+  return oonf_layer2_data_get_int64(&l2net->neighdata[idx], scale, -1);
+}
+
+/**
+ * Shape a link cost into a value that can be transmitted over the network
+ * @param metric link cost
+ * @return transmittable link metric
+ */
+static uint32_t
+_shape_metric(uint64_t metric) {
+  struct rfc7181_metric_field encoded_metric;
+
+  if (metric > RFC7181_METRIC_MAX) {
+    return RFC7181_METRIC_MAX;
+  }
+  if (metric < RFC7181_METRIC_MIN) {
+    return RFC7181_METRIC_MIN;
+  }
+  if (rfc7181_metric_encode(&encoded_metric, metric)) {
+    return RFC7181_METRIC_MAX;
+  }
+  return rfc7181_metric_decode(&encoded_metric);
+}
+
+/**
+ * Calculate the metric of a layer2 neighbor
+ * @param domain nhdp domain
+ * @param metric pointer to target buffer for metric
+ * @param neigh layer2 neighbor
+ * @return status of metric calculation
+ */
+static enum nhdp_metric_result
+_cb_get_metric(struct nhdp_domain *domain __attribute__((unused)), uint32_t *metric, struct oonf_layer2_neigh *neigh) {
+  struct nhdp_interface *nhdp_if;
+
+  nhdp_if = nhdp_interface_get(neigh->network->name);
+  if (!nhdp_if) {
+    return NHDP_METRIC_NOT_AVAILABLE;
+  }
+  return _calculate_cost(metric, oonf_class_get_extension(&_nhdpif_extenstion, nhdp_if), neigh->network, neigh);
+}
+
+/**
+ * Convert layer2 metric into string representation
+ * @param buf pointer to output buffer
+ * @param metric metric value
+ * @return pointer to output string
+ */
+static const char *
+_link_to_string(struct nhdp_metric_str *buf, uint32_t metric) {
+  uint64_t value;
+
+  if (metric < L2METRIC_LINKCOST_MINIMUM) {
+    value = (uint64_t)L2METRIC_LINKSPEED_MINIMUM * (uint64_t)L2METRIC_LINKSPEED_RANGE;
+  }
+  else if (metric > L2METRIC_LINKCOST_MAXIMUM) {
+    strscpy(buf->buf, "infinite", sizeof(*buf));
+    return buf->buf;
+  }
+  else {
+    value = (uint64_t)L2METRIC_LINKSPEED_MINIMUM * (uint64_t)L2METRIC_LINKSPEED_RANGE / metric;
+  }
+  isonumber_from_u64((struct isonumber_str *)buf, value, "bit/s", 1, false);
+  return buf->buf;
+}
+
+/**
+ * Convert layer2 path metric into string representation
+ * @param buf pointer to output buffer
+ * @param metric path metric value
+ * @param hopcount hopcount of path
+ * @return pointer to output string
+ */
+static const char *
+_path_to_string(struct nhdp_metric_str *buf, uint32_t metric, uint8_t hopcount) {
+  struct nhdp_metric_str mbuf;
+
+  if (hopcount == 0) {
+    /* prevent division by zero */
+    hopcount = 1;
+  }
+  snprintf(buf->buf, sizeof(*buf), "%s (%u hops)", _link_to_string(&mbuf, metric / hopcount), hopcount);
+  return buf->buf;
+}
+
+/**
+ * Callback triggered when configuration changes
+ */
+static void
+_cb_cfg_changed(void) {
+  struct l2metric_if_config *ifconfig = NULL;
+  struct nhdp_interface *nhdp_if;
+  struct nhdp_link *lnk;
+  const char *ifname;
+  char ifbuf[IF_NAMESIZE];
+
+  ifname = cfg_get_phy_if(ifbuf, _l2metric_section.section_name);
+
+  if (_l2metric_section.pre == NULL) {
+    /* increase nhdp_interface refcount */
+    nhdp_if = nhdp_interface_add(ifname);
+  }
+  else {
+    /* get interface */
+    nhdp_if = nhdp_interface_get(ifname);
+  }
+
+  if (nhdp_if) {
+    /* get block domain extension */
+    ifconfig = oonf_class_get_extension(&_nhdpif_extenstion, nhdp_if);
+    ifconfig->registered = true;
+  }
+
+  if (_l2metric_section.post == NULL) {
+    /* section was removed */
+    if (nhdp_if != NULL) {
+      ifconfig->registered = false;
+
+      /* decrease nhdp_interface refcount */
+      nhdp_interface_remove(nhdp_if);
+    }
+
+    nhdp_if = NULL;
+  }
+
+  if (!nhdp_if) {
+    return;
+  }
+
+  if (cfg_schema_tobin(ifconfig, _l2metric_section.post, _l2metric_entries, ARRAYSIZE(_l2metric_entries))) {
+    OONF_WARN(LOG_L2METRIC, "Cannot convert configuration for " OONF_LAYER2_METRIC_SUBSYSTEM);
+    return;
+  }
+
+  if (!_active) {
+    return;
+  }
+
+  /* apply new settings to all links of the interface */
+  nhdp_db_transaction_start();
+  list_for_each_element(&nhdp_if->_links, lnk, _if_node) {
+    if (_update_link(lnk)) {
+      nhdp_db_neighbor_update_metrics(lnk->neigh);
+    }
+  }
+  nhdp_db_transaction_commit();
+}
@@ -51,11 +51,17 @@
 #include <oonf/libcommon/avl_comp.h>
 #include <oonf/oonf.h>
 #include <oonf/libcommon/container_of.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/isonumber.h>
+#include <oonf/libcommon/template.h>
 #include <oonf/libconfig/cfg_schema.h>
 #include <oonf/libcore/oonf_logging.h>
 #include <oonf/libcore/oonf_subsystem.h>
 #include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
 #include <oonf/base/oonf_rfc5444.h>
+#include <oonf/base/oonf_telnet.h>
+#include <oonf/base/oonf_viewer.h>
 
 #include <oonf/nhdp/nhdp/nhdp.h>
 #include <oonf/nhdp/nhdp/nhdp_db.h>
@@ -70,20 +76,238 @@
 
 /* FIXME remove unneeded includes */
 
+/**
+ * MPR plugin configuration
+ */
+struct _config {
+  /*! true to use the bitset based MPR selection engine */
+  bool bitset_selection;
+
+  /*! true to keep neighbor graphs and update MPR sets incrementally */
+  bool incremental;
+
+  /*! maximum time between two full MPR calculations in incremental mode */
+  uint64_t full_interval;
+
+  /*! true to share flooding MPR sets between interfaces with identical neighborhoods */
+  bool share_flooding;
+};
+
+/*! maximum number of changed two-hop addresses remembered for an incremental update */
+#define MAX_CHANGED_N2 32
+
+/**
+ * Persistent neighbor graph for incremental MPR calculation
+ */
+struct _mpr_graph {
+  /*! neighbor graph, kept between calculations in incremental mode */
+  struct neighbor_graph *graph;
+
+  /*! node arena of the neighbor graph */
+  struct mpr_arena arena;
+
+  /*! true if the neighbor graph contains a valid MPR set */
+  bool valid;
+
+  /*! true if N1 might have changed and the graph has to be rebuilt */
+  bool rebuild;
+
+  /*! timestamp of the last full MPR calculation */
+  uint64_t last_full;
+
+  /*! two-hop addresses changed since the last calculation */
+  struct netaddr changed[MAX_CHANGED_N2];
+
+  /*! number of changed addresses, more than MAX_CHANGED_N2 if the array overflowed */
+  uint32_t changed_count;
+};
+
+/**
+ * Persistent routing MPR state of a NHDP domain
+ */
+struct _routing_graph {
+  /*! persistent graph state */
+  struct _mpr_graph mg;
+
+  /*! storage for neighbor graph */
+  struct neighbor_graph storage;
+};
+
+/**
+ * Persistent flooding MPR state of a NHDP interface
+ */
+struct _flooding_graph {
+  /*! persistent graph state */
+  struct _mpr_graph mg;
+
+  /*! storage for neighbor graph */
+  struct mpr_flooding_data storage;
+
+  /*! name of NHDP interface */
+  char name[IF_NAMESIZE];
+
+  /*! hash of the flooding neighborhood of the interface */
+  uint32_t hash;
+
+  /*! flooding calculation round of the hash value */
+  uint32_t hash_round;
+
+  /*! flooding calculation round this interface has been processed in */
+  uint32_t round;
+
+  /*! hook into tree of flooding graphs */
+  struct avl_node _node;
+};
+
 /* prototypes */
 static void _early_cfg_init(void);
 static int _init(void);
 static void _cleanup(void);
 static void _cb_update_routing_mpr(struct nhdp_domain *);
 static void _cb_update_flooding_mpr(struct nhdp_domain *);
+static int _calculate_mpr(const struct nhdp_domain *domain, struct _mpr_graph *mg);
+static bool _update_graph(const struct nhdp_domain *domain, struct _mpr_graph *mg, struct nhdp_interface *nhdp_if);
+static bool _is_n1_unchanged(
+  const struct nhdp_domain *domain, struct neighbor_graph *graph, struct nhdp_interface *nhdp_if);
+static void _clear_graph(struct _mpr_graph *mg);
+static void _add_changed_addr(struct _mpr_graph *mg, const struct netaddr *addr, bool only_n2);
+static void _add_changed_routing_addr(const struct netaddr *addr, bool only_n2);
+static struct _flooding_graph *_get_flooding_graph(struct nhdp_interface *nhdp_if);
+static void _remove_flooding_graph(struct _flooding_graph *fg);
+static void _clear_all_graphs(void);
+static void _share_flooding_mpr(const struct nhdp_domain *domain, struct nhdp_interface *nhdp_if,
+  struct _flooding_graph *fg, struct neighbor_graph *graph);
+static uint32_t _get_neighborhood_hash(
+  const struct nhdp_domain *domain, struct nhdp_interface *nhdp_if, struct _flooding_graph *fg);
+static bool _is_same_neighborhood(
+  const struct nhdp_domain *domain, struct nhdp_interface *if1, struct nhdp_interface *if2);
+static struct nhdp_link *_get_single_link(struct nhdp_neighbor *neigh, struct nhdp_interface *nhdp_if);
+static bool _is_flooding_link(const struct nhdp_domain *domain, struct nhdp_link *lnk);
+static bool _is_flooding_2hop(const struct nhdp_domain *domain, struct nhdp_l2hop *l2hop);
+
+static void _cb_l2hop_changed(void *);
+static void _cb_naddr_changed(void *);
+static void _cb_link_changed(void *);
+static void _cb_neighbor_changed(void *);
+static void _cb_interface_removed(void *);
+static void _cb_cfg_changed(void);
+
+static enum oonf_telnet_result _cb_mpr(struct oonf_telnet_data *con);
+static enum oonf_telnet_result _cb_mpr_help(struct oonf_telnet_data *con);
+static int _cb_create_text_arena(struct oonf_viewer_template *);
+static int _cb_create_text_flooding(struct oonf_viewer_template *);
 
 #ifndef NDEBUG
 static void _validate_mpr_set(const struct nhdp_domain *domain, struct neighbor_graph *graph);
 #endif
 
+/* configuration options */
+static struct cfg_schema_entry _mpr_entries[] = {
+  CFG_MAP_BOOL(_config, bitset_selection, "bitset_selection", "false",
+    "Use dense bitsets to calculate MPR sets instead of rescanning the neighbor graph"),
+  CFG_MAP_BOOL(_config, incremental, "incremental", "false",
+    "Keep the neighbor graph between MPR calculations and only re-evaluate two-hop neighbors affected"
+    " by a change. The resulting MPR set is valid, but might be larger than a fully recalculated one."),
+  CFG_MAP_CLOCK_MIN(_config, full_interval, "full_interval", "60.0",
+    "Maximum time between two full MPR calculations in incremental mode", 1000),
+  CFG_MAP_BOOL(_config, share_flooding, "share_flooding", "false",
+    "Calculate the flooding MPR set only once for interfaces with identical one- and two-hop neighborhoods"),
+};
+
+static struct cfg_schema_section _mpr_section = {
+  .type = OONF_MPR_SUBSYSTEM,
+  .cb_delta_handler = _cb_cfg_changed,
+  .entries = _mpr_entries,
+  .entry_count = ARRAYSIZE(_mpr_entries),
+};
+
+static struct _config _mpr_config;
+
+/*! template key for number of arena blocks currently allocated */
+#define KEY_ARENA_BLOCKS "arena_blocks"
+
+/*! template key for number of arena blocks allocated from the heap */
+#define KEY_ARENA_BLOCK_ALLOCS "arena_block_allocs"
+
+/*! template key for number of arena blocks returned to the heap */
+#define KEY_ARENA_BLOCK_FREES "arena_block_frees"
+
+/*! template key for number of graph nodes taken from arenas */
+#define KEY_ARENA_NODE_ALLOCS "arena_node_allocs"
+
+/*! template key for number of arena resets */
+#define KEY_ARENA_RESETS "arena_resets"
+
+/*! template key for number of flooding MPR calculations */
+#define KEY_FLOODING_CALCULATIONS "flooding_calculations"
+
+/*! template key for number of flooding MPR sets copied from an interface with the same neighborhood */
+#define KEY_FLOODING_SHARED "flooding_shared"
+
+/*
+ * buffer space for values that will be assembled
+ * into the output of the telnet command
+ */
+static struct isonumber_str _value_arena_blocks;
+static struct isonumber_str _value_arena_block_allocs;
+static struct isonumber_str _value_arena_block_frees;
+static struct isonumber_str _value_arena_node_allocs;
+static struct isonumber_str _value_arena_resets;
+
+static struct isonumber_str _value_flooding_calculations;
+static struct isonumber_str _value_flooding_shared;
+
+/* definition of the template data entries for JSON and table output */
+static struct abuf_template_data_entry _tde_arena[] = {
+  { KEY_ARENA_BLOCKS, _value_arena_blocks.buf, false },
+  { KEY_ARENA_BLOCK_ALLOCS, _value_arena_block_allocs.buf, false },
+  { KEY_ARENA_BLOCK_FREES, _value_arena_block_frees.buf, false },
+  { KEY_ARENA_NODE_ALLOCS, _value_arena_node_allocs.buf, false },
+  { KEY_ARENA_RESETS, _value_arena_resets.buf, false },
+};
+
+static struct abuf_template_data_entry _tde_flooding[] = {
+  { KEY_FLOODING_CALCULATIONS, _value_flooding_calculations.buf, false },
+  { KEY_FLOODING_SHARED, _value_flooding_shared.buf, false },
+};
+
+static struct abuf_template_storage _template_storage;
+
+/* Template Data objects (contain one or more Template Data Entries) */
+static struct abuf_template_data _td_arena[] = {
+  { _tde_arena, ARRAYSIZE(_tde_arena) },
+};
+static struct abuf_template_data _td_flooding[] = {
+  { _tde_flooding, ARRAYSIZE(_tde_flooding) },
+};
+
+/* OONF viewer templates (based on Template Data arrays) */
+static struct oonf_viewer_template _templates[] = {
+  {
+    .data = _td_arena,
+    .data_size = ARRAYSIZE(_td_arena),
+    .json_name = "arena",
+    .cb_function = _cb_create_text_arena,
+  },
+  {
+    .data = _td_flooding,
+    .data_size = ARRAYSIZE(_td_flooding),
+    .json_name = "flooding",
+    .cb_function = _cb_create_text_flooding,
+  },
+};
+
+/* telnet command of this plugin */
+static struct oonf_telnet_command _telnet_commands[] = {
+  TELNET_CMD(OONF_MPR_SUBSYSTEM, _cb_mpr, "", .help_handler = _cb_mpr_help),
+};
+
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
+  OONF_TELNET_SUBSYSTEM,
+  OONF_VIEWER_SUBSYSTEM,
   OONF_NHDP_SUBSYSTEM,
 };
 static struct oonf_subsystem _nhdp_mpr_subsystem = {
@@ -92,6 +316,8 @@ static struct oonf_subsystem _nhdp_mpr_subsystem = {
   .dependencies_count = ARRAYSIZE(_dependencies),
   .descr = "RFC7181 Appendix B MPR Plugin",
   .author = "Jonathan Kirchhoff",
+  .cfg_section = &_mpr_section,
+
   .early_cfg_init = _early_cfg_init,
 
   .init = _init,
@@ -105,6 +331,55 @@ static struct nhdp_domain_mpr _mpr_handler = {
   .update_flooding_mpr = _cb_update_flooding_mpr,
 };
 
+/* listeners for NHDP database changes */
+static struct oonf_class_extension _l2hop_listener = {
+  .ext_name = OONF_MPR_SUBSYSTEM,
+  .class_name = NHDP_CLASS_LINK_2HOP,
+  .cb_add = _cb_l2hop_changed,
+  .cb_change = _cb_l2hop_changed,
+  .cb_remove = _cb_l2hop_changed,
+};
+
+static struct oonf_class_extension _naddr_listener = {
+  .ext_name = OONF_MPR_SUBSYSTEM,
+  .class_name = NHDP_CLASS_NEIGHBOR_ADDRESS,
+  .cb_add = _cb_naddr_changed,
+  .cb_change = _cb_naddr_changed,
+  .cb_remove = _cb_naddr_changed,
+};
+
+/* new links and neighbors are not symmetric, so they cannot be part of N1 */
+static struct oonf_class_extension _link_listener = {
+  .ext_name = OONF_MPR_SUBSYSTEM,
+  .class_name = NHDP_CLASS_LINK,
+  .cb_change = _cb_link_changed,
+  .cb_remove = _cb_link_changed,
+};
+
+static struct oonf_class_extension _neigh_listener = {
+  .ext_name = OONF_MPR_SUBSYSTEM,
+  .class_name = NHDP_CLASS_NEIGHBOR,
+  .cb_change = _cb_neighbor_changed,
+  .cb_remove = _cb_neighbor_changed,
+};
+
+static struct oonf_class_extension _interface_listener = {
+  .ext_name = OONF_MPR_SUBSYSTEM,
+  .class_name = NHDP_CLASS_INTERFACE,
+  .cb_remove = _cb_interface_removed,
+};
+
+/* persistent neighbor graphs for incremental MPR calculation */
+static struct _routing_graph _routing_graphs[NHDP_MAXIMUM_DOMAINS];
+static struct avl_tree _flooding_graphs;
+
+/* counter for rounds of flooding MPR calculation */
+static uint32_t _flooding_round;
+
+/* statistics for flooding MPR calculations */
+static uint64_t _flooding_calculations;
+static uint64_t _flooding_shared;
+
 /* logging sources for NHDP subsystem */
 enum oonf_log_source LOG_MPR;
 
@@ -122,9 +397,26 @@ _early_cfg_init(void) {
  */
 static int
 _init(void) {
+  size_t i;
+
   if (nhdp_domain_mpr_add(&_mpr_handler)) {
     return -1;
   }
+
+  oonf_class_extension_add(&_l2hop_listener);
+  oonf_class_extension_add(&_naddr_listener);
+  oonf_class_extension_add(&_link_listener);
+  oonf_class_extension_add(&_neigh_listener);
+  oonf_class_extension_add(&_interface_listener);
+
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    _routing_graphs[i].mg.graph = &_routing_graphs[i].storage;
+    _routing_graphs[i].mg.graph->arena = &_routing_graphs[i].mg.arena;
+    mpr_arena_init(&_routing_graphs[i].mg.arena);
+  }
+  avl_init(&_flooding_graphs, avl_comp_strcasecmp, false);
+
+  oonf_telnet_add(&_telnet_commands[0]);
   return 0;
 }
 
@@ -132,7 +424,22 @@ _init(void) {
  * Cleanup plugin
  */
 static void
-_cleanup(void) {}
+_cleanup(void) {
+  size_t i;
+
+  oonf_telnet_remove(&_telnet_commands[0]);
+
+  _clear_all_graphs();
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    mpr_arena_free(&_routing_graphs[i].mg.arena);
+  }
+
+  oonf_class_extension_remove(&_interface_listener);
+  oonf_class_extension_remove(&_neigh_listener);
+  oonf_class_extension_remove(&_link_listener);
+  oonf_class_extension_remove(&_naddr_listener);
+  oonf_class_extension_remove(&_l2hop_listener);
+}
 
 /**
  * Updates the current routing MPR selection in the NHDP database
@@ -170,6 +477,34 @@ _update_nhdp_flooding(struct nhdp_interface *nhdp_if, struct neighbor_graph *gra
   }
 }
 
+/**
+ * Select all symmetric neighbors as routing MPRs, used if the
+ * neighbor graph could not be calculated
+ * @param domain NHDP domain
+ */
+static void
+_select_all_routing(struct nhdp_domain *domain) {
+  struct nhdp_link *lnk;
+
+  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
+    nhdp_domain_get_neighbordata(domain, lnk->neigh)->neigh_is_mpr = lnk->neigh->symmetric > 0;
+  }
+}
+
+/**
+ * Select all symmetric links of an interface as flooding MPRs, used if
+ * the neighbor graph could not be calculated
+ * @param nhdp_if nhdp interface to update
+ */
+static void
+_select_all_flooding(struct nhdp_interface *nhdp_if) {
+  struct nhdp_link *current_link;
+
+  list_for_each_element(&nhdp_if->_links, current_link, _if_node) {
+    current_link->neigh_is_flooding_mpr = current_link->status == NHDP_LINK_SYMMETRIC;
+  }
+}
+
 /**
  * Updates the current flooding MPR selection in the NHDP database
  */
@@ -189,24 +524,247 @@ _clear_nhdp_flooding(void) {
  */
 static void
 _cb_update_flooding_mpr(struct nhdp_domain *domain) {
-  struct mpr_flooding_data flooding_data;
-
-  memset(&flooding_data, 0, sizeof(flooding_data));
+  struct mpr_flooding_data *flooding_data;
+  struct nhdp_interface *nhdp_if;
+  struct _flooding_graph *fg;
+  struct neighbor_graph *graph;
 
   _clear_nhdp_flooding();
-  avl_for_each_element(nhdp_interface_get_tree(), flooding_data.current_interface, _node) {
-    OONF_DEBUG(LOG_MPR, "*** Calculate flooding MPRs for interface %s ***",
-      nhdp_interface_get_name(flooding_data.current_interface));
+  _flooding_round++;
 
-    mpr_calculate_neighbor_graph_flooding(domain, &flooding_data);
-    mpr_calculate_mpr_rfc7181(domain, &flooding_data.neigh_graph);
-    mpr_print_sets(domain, &flooding_data.neigh_graph);
+  avl_for_each_element(nhdp_interface_get_tree(), nhdp_if, _node) {
+    fg = _get_flooding_graph(nhdp_if);
+    if (fg == NULL) {
+      OONF_WARN(LOG_MPR, "Out of memory for flooding neighbor graph of interface %s",
+        nhdp_interface_get_name(nhdp_if));
+      continue;
+    }
+    if (fg->round == _flooding_round) {
+      /* MPR set has been copied from an interface with the same neighborhood */
+      continue;
+    }
+    fg->round = _flooding_round;
+
+    flooding_data = &fg->storage;
+    flooding_data->current_interface = nhdp_if;
+    graph = fg->mg.graph;
+
+    if (_mpr_config.incremental && _update_graph(domain, &fg->mg, nhdp_if)) {
+      OONF_DEBUG(LOG_MPR, "Updated flooding MPRs for interface %s", nhdp_interface_get_name(nhdp_if));
+    }
+    else {
+      OONF_DEBUG(LOG_MPR, "*** Calculate flooding MPRs for interface %s ***", nhdp_interface_get_name(nhdp_if));
+
+      _clear_graph(&fg->mg);
+      _flooding_calculations++;
+      if (mpr_calculate_neighbor_graph_flooding(domain, flooding_data) || _calculate_mpr(domain, &fg->mg)) {
+        OONF_WARN(LOG_MPR, "Out of memory for flooding MPRs of interface %s, select all symmetric links",
+          nhdp_interface_get_name(nhdp_if));
+        _clear_graph(&fg->mg);
+        _select_all_flooding(nhdp_if);
+        continue;
+      }
+    }
+
+    mpr_print_sets(domain, graph);
 #ifndef NDEBUG
-    _validate_mpr_set(domain, &flooding_data.neigh_graph);
+    _validate_mpr_set(domain, graph);
 #endif
-    _update_nhdp_flooding(flooding_data.current_interface, &flooding_data.neigh_graph);
-    mpr_clear_neighbor_graph(&flooding_data.neigh_graph);
+    _update_nhdp_flooding(nhdp_if, graph);
+    _share_flooding_mpr(domain, nhdp_if, fg, graph);
+
+    if (!_mpr_config.incremental) {
+      /* keep the arena blocks for the next calculation */
+      _clear_graph(&fg->mg);
+    }
+  }
+}
+
+/**
+ * Copy the flooding MPR set of an interface to all interfaces that have
+ * not been processed in this round and see the same neighborhood
+ * @param domain flooding domain
+ * @param nhdp_if NHDP interface the MPR set was calculated for
+ * @param fg flooding graph of the interface
+ * @param graph neighbor graph with the MPR set
+ */
+static void
+_share_flooding_mpr(const struct nhdp_domain *domain, struct nhdp_interface *nhdp_if,
+  struct _flooding_graph *fg, struct neighbor_graph *graph) {
+  struct nhdp_interface *other_if;
+  struct _flooding_graph *other_fg;
+  uint32_t hash;
+
+  if (!_mpr_config.share_flooding || list_is_empty(&nhdp_if->_links)) {
+    return;
+  }
+
+  hash = _get_neighborhood_hash(domain, nhdp_if, fg);
+  avl_for_each_element(nhdp_interface_get_tree(), other_if, _node) {
+    other_fg = _get_flooding_graph(other_if);
+    if (other_fg == NULL || other_fg->round == _flooding_round) {
+      continue;
+    }
+
+    if (_get_neighborhood_hash(domain, other_if, other_fg) == hash &&
+        _is_same_neighborhood(domain, nhdp_if, other_if)) {
+      OONF_DEBUG(LOG_MPR, "Use flooding MPRs of interface %s for interface %s", nhdp_interface_get_name(nhdp_if),
+        nhdp_interface_get_name(other_if));
+
+      _update_nhdp_flooding(other_if, graph);
+      other_fg->round = _flooding_round;
+      _flooding_shared++;
+    }
+  }
+}
+
+/**
+ * Calculate an order independent hash over the one- and two-hop
+ * neighborhood of an interface that is used for flooding MPR selection.
+ * The value is calculated once per flooding round.
+ * @param domain flooding domain
+ * @param nhdp_if NHDP interface
+ * @param fg flooding graph of the interface
+ * @return hash value
+ */
+static uint32_t
+_get_neighborhood_hash(const struct nhdp_domain *domain, struct nhdp_interface *nhdp_if, struct _flooding_graph *fg) {
+  struct nhdp_link *lnk;
+  struct nhdp_l2hop *l2hop;
+  uint32_t value[4];
+
+  if (fg->hash_round == _flooding_round) {
+    return fg->hash;
+  }
+
+  fg->hash = 0;
+  list_for_each_element(&nhdp_if->_links, lnk, _if_node) {
+    if (!_is_flooding_link(domain, lnk)) {
+      continue;
+    }
+
+    value[0] = hashmap_hash_netaddr(&lnk->neigh->originator);
+    value[1] = nhdp_domain_get_linkdata(domain, lnk)->metric.out;
+    value[2] = lnk->flooding_willingness;
+    value[3] = 0;
+
+    avl_for_each_element(&lnk->_2hop, l2hop, _link_node) {
+      if (_is_flooding_2hop(domain, l2hop)) {
+        value[3] += hashmap_hash_netaddr(&l2hop->twohop_addr) ^ nhdp_domain_get_l2hopdata(domain, l2hop)->metric.out;
+      }
+    }
+    fg->hash += hashmap_hash_bytes(value, sizeof(value));
+  }
+
+  fg->hash_round = _flooding_round;
+  return fg->hash;
+}
+
+/**
+ * Compare the one- and two-hop neighborhood of two interfaces
+ * @param domain flooding domain
+ * @param if1 first NHDP interface
+ * @param if2 second NHDP interface
+ * @return true if both interfaces result in the same flooding neighbor graph
+ */
+static bool
+_is_same_neighborhood(const struct nhdp_domain *domain, struct nhdp_interface *if1, struct nhdp_interface *if2) {
+  struct nhdp_link *lnk1, *lnk2;
+  struct nhdp_l2hop *l2hop1, *l2hop2;
+  size_t count1, count2;
+
+  count1 = 0;
+  list_for_each_element(&if1->_links, lnk1, _if_node) {
+    if (!_is_flooding_link(domain, lnk1)) {
+      continue;
+    }
+    count1++;
+
+    /* both interfaces must have exactly one link to the neighbor */
+    lnk2 = _get_single_link(lnk1->neigh, if2);
+    if (lnk2 == NULL || _get_single_link(lnk1->neigh, if1) == NULL || !_is_flooding_link(domain, lnk2)) {
+      return false;
+    }
+
+    if (lnk1->flooding_willingness != lnk2->flooding_willingness ||
+        nhdp_domain_get_linkdata(domain, lnk1)->metric.out != nhdp_domain_get_linkdata(domain, lnk2)->metric.out) {
+      return false;
+    }
+
+    count2 = 0;
+    avl_for_each_element(&lnk1->_2hop, l2hop1, _link_node) {
+      if (!_is_flooding_2hop(domain, l2hop1)) {
+        continue;
+      }
+      count2++;
+
+      l2hop2 = ndhp_db_link_2hop_get(lnk2, &l2hop1->twohop_addr);
+      if (l2hop2 == NULL || !_is_flooding_2hop(domain, l2hop2) ||
+          nhdp_domain_get_l2hopdata(domain, l2hop1)->metric.out !=
+            nhdp_domain_get_l2hopdata(domain, l2hop2)->metric.out) {
+        return false;
+      }
+    }
+
+    avl_for_each_element(&lnk2->_2hop, l2hop2, _link_node) {
+      if (_is_flooding_2hop(domain, l2hop2)) {
+        count2--;
+      }
+    }
+    if (count2 != 0) {
+      return false;
+    }
+  }
+
+  list_for_each_element(&if2->_links, lnk2, _if_node) {
+    if (_is_flooding_link(domain, lnk2)) {
+      count1--;
+    }
+  }
+  return count1 == 0;
+}
+
+/**
+ * @param neigh NHDP neighbor
+ * @param nhdp_if NHDP interface
+ * @return link of the neighbor on the interface, NULL if the
+ *   neighbor has no link or more than one link on the interface
+ */
+static struct nhdp_link *
+_get_single_link(struct nhdp_neighbor *neigh, struct nhdp_interface *nhdp_if) {
+  struct nhdp_link *lnk, *result;
+
+  result = NULL;
+  list_for_each_element(&neigh->_links, lnk, _neigh_node) {
+    if (lnk->local_if == nhdp_if) {
+      if (result) {
+        return NULL;
+      }
+      result = lnk;
+    }
   }
+  return result;
+}
+
+/**
+ * @param domain flooding domain
+ * @param lnk NHDP link
+ * @return true if link is part of N1 of the flooding neighbor graph of its interface
+ */
+static bool
+_is_flooding_link(const struct nhdp_domain *domain, struct nhdp_link *lnk) {
+  return lnk->status == NHDP_LINK_SYMMETRIC && lnk->flooding_willingness > RFC7181_WILLINGNESS_NEVER &&
+         nhdp_domain_get_linkdata(domain, lnk)->metric.out <= RFC7181_METRIC_MAX;
+}
+
+/**
+ * @param domain flooding domain
+ * @param l2hop NHDP twohop neighbor
+ * @return true if twohop neighbor is part of N2 of the flooding neighbor graph of its interface
+ */
+static bool
+_is_flooding_2hop(const struct nhdp_domain *domain, struct nhdp_l2hop *l2hop) {
+  return nhdp_domain_get_l2hopdata(domain, l2hop)->metric.out <= RFC7181_METRIC_MAX;
 }
 
 /**
@@ -214,23 +772,411 @@ _cb_update_flooding_mpr(struct nhdp_domain *domain) {
  */
 static void
 _cb_update_routing_mpr(struct nhdp_domain *domain) {
-  struct neighbor_graph routing_graph;
+  struct neighbor_graph *graph;
+  struct _mpr_graph *mg;
 
   if (domain->mpr != &_mpr_handler) {
     /* we are not the routing MPR for this domain */
     return;
   }
-  OONF_DEBUG(LOG_MPR, "*** Calculate routing MPRs for domain %u ***", domain->index);
 
-  memset(&routing_graph, 0, sizeof(routing_graph));
-  mpr_calculate_neighbor_graph_routing(domain, &routing_graph);
-  mpr_calculate_mpr_rfc7181(domain, &routing_graph);
-  mpr_print_sets(domain, &routing_graph);
+  mg = &_routing_graphs[domain->index].mg;
+  graph = mg->graph;
+
+  if (_mpr_config.incremental && _update_graph(domain, mg, NULL)) {
+    OONF_DEBUG(LOG_MPR, "Updated routing MPRs for domain %u", domain->index);
+  }
+  else {
+    OONF_DEBUG(LOG_MPR, "*** Calculate routing MPRs for domain %u ***", domain->index);
+
+    _clear_graph(mg);
+    if (mpr_calculate_neighbor_graph_routing(domain, graph) || _calculate_mpr(domain, mg)) {
+      OONF_WARN(LOG_MPR, "Out of memory for routing MPRs of domain %u, select all symmetric neighbors",
+        domain->index);
+      _clear_graph(mg);
+      _select_all_routing(domain);
+      return;
+    }
+  }
+
+  mpr_print_sets(domain, graph);
 #ifndef NDEBUG
-  _validate_mpr_set(domain, &routing_graph);
+  _validate_mpr_set(domain, graph);
 #endif
-  _update_nhdp_routing(domain, &routing_graph);
-  mpr_clear_neighbor_graph(&routing_graph);
+  _update_nhdp_routing(domain, graph);
+
+  if (!_mpr_config.incremental) {
+    /* keep the arena blocks for the next calculation */
+    _clear_graph(mg);
+  }
+}
+
+/**
+ * Calculate the MPR set of a freshly built neighbor graph with the
+ * configured selection engine
+ * @param domain NHDP domain
+ * @param mg persistent graph state
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_calculate_mpr(const struct nhdp_domain *domain, struct _mpr_graph *mg) {
+  int result;
+
+  if (_mpr_config.bitset_selection) {
+    result = mpr_calculate_mpr_rfc7181_bitset(domain, mg->graph);
+  }
+  else {
+    result = mpr_calculate_mpr_rfc7181(domain, mg->graph);
+  }
+  if (result) {
+    return -1;
+  }
+
+  mg->valid = true;
+  mg->rebuild = false;
+  mg->changed_count = 0;
+  mg->last_full = oonf_clock_getNow();
+  return 0;
+}
+
+/**
+ * Apply the changes of the NHDP database since the last calculation
+ * to the persistent neighbor graph and update its MPR set
+ * @param domain NHDP domain
+ * @param mg persistent graph state
+ * @param nhdp_if NHDP interface of flooding graph, NULL for routing graph
+ * @return true if the MPR set was updated, false if the graph
+ *   has to be rebuilt with a full MPR calculation
+ */
+static bool
+_update_graph(const struct nhdp_domain *domain, struct _mpr_graph *mg, struct nhdp_interface *nhdp_if) {
+  if (!mg->valid || mg->rebuild || mg->changed_count > MAX_CHANGED_N2 ||
+      oonf_clock_get_relative(mg->last_full + _mpr_config.full_interval) <= 0) {
+    return false;
+  }
+
+  /* metric and willingness changes can move neighbors in and out of N1 without a link event */
+  if (!_is_n1_unchanged(domain, mg->graph, nhdp_if)) {
+    OONF_DEBUG(LOG_MPR, "N1 changed");
+    return false;
+  }
+
+  if (mpr_update_mpr_rfc7181(domain, mg->graph, mg->changed, mg->changed_count, mg->graph->set_n2.count / 4)) {
+    return false;
+  }
+
+  mg->changed_count = 0;
+  return true;
+}
+
+/**
+ * Check if the N1 members of a neighbor graph are still the allowed
+ * link tuples of the NHDP database
+ * @param domain NHDP domain
+ * @param graph neighbor graph
+ * @param nhdp_if NHDP interface of flooding graph, NULL for routing graph
+ * @return true if N1 is unchanged
+ */
+static bool
+_is_n1_unchanged(const struct nhdp_domain *domain, struct neighbor_graph *graph, struct nhdp_interface *nhdp_if) {
+  struct nhdp_link *lnk;
+  struct n1_node *n1;
+  bool in_n1;
+
+  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
+    n1 = avl_find_element(&graph->set_n1, &lnk->neigh->originator, n1, _avl_node);
+
+    /* routing graphs contain neighbors, flooding graphs contain links */
+    in_n1 = n1 != NULL && (n1->link == NULL || n1->link == lnk);
+    if (in_n1 != graph->methods->is_allowed_link_tuple(domain, nhdp_if, lnk)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Remove the (maybe partially built) neighbor graph of a persistent
+ * state, the arena keeps its blocks for the next calculation
+ * @param mg persistent graph state
+ */
+static void
+_clear_graph(struct _mpr_graph *mg) {
+  mpr_clear_neighbor_graph(mg->graph);
+  mg->valid = false;
+  mg->changed_count = 0;
+}
+
+/**
+ * Remember a changed two-hop address for the next incremental update
+ * @param mg persistent graph state
+ * @param addr two-hop address
+ * @param only_n2 true if the change only matters for current members of N2
+ */
+static void
+_add_changed_addr(struct _mpr_graph *mg, const struct netaddr *addr, bool only_n2) {
+  struct addr_node *y_node;
+  uint32_t i;
+
+  if (!mg->valid || mg->rebuild || mg->changed_count > MAX_CHANGED_N2) {
+    /* graph will be rebuilt anyways */
+    return;
+  }
+
+  if (only_n2) {
+    y_node = avl_find_element(&mg->graph->set_n2, addr, y_node, _avl_node);
+    if (y_node == NULL) {
+      return;
+    }
+  }
+
+  for (i = 0; i < mg->changed_count; i++) {
+    if (netaddr_cmp(&mg->changed[i], addr) == 0) {
+      return;
+    }
+  }
+
+  if (mg->changed_count < MAX_CHANGED_N2) {
+    memcpy(&mg->changed[mg->changed_count], addr, sizeof(*addr));
+  }
+  mg->changed_count++;
+}
+
+/**
+ * Remember a changed two-hop address for the routing graphs of all domains
+ * @param addr two-hop address
+ * @param only_n2 true if the change only matters for current members of N2
+ */
+static void
+_add_changed_routing_addr(const struct netaddr *addr, bool only_n2) {
+  size_t i;
+
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    _add_changed_addr(&_routing_graphs[i].mg, addr, only_n2);
+  }
+}
+
+/**
+ * Get (or create) the persistent flooding graph of a NHDP interface
+ * @param nhdp_if NHDP interface
+ * @return flooding graph, NULL if out of memory
+ */
+static struct _flooding_graph *
+_get_flooding_graph(struct nhdp_interface *nhdp_if) {
+  struct _flooding_graph *fg;
+
+  fg = avl_find_element(&_flooding_graphs, nhdp_interface_get_name(nhdp_if), fg, _node);
+  if (fg) {
+    return fg;
+  }
+
+  fg = calloc(1, sizeof(*fg));
+  if (!fg) {
+    return NULL;
+  }
+
+  strscpy(fg->name, nhdp_interface_get_name(nhdp_if), sizeof(fg->name));
+  fg->mg.graph = &fg->storage.neigh_graph;
+  fg->mg.graph->arena = &fg->mg.arena;
+  mpr_arena_init(&fg->mg.arena);
+
+  fg->_node.key = fg->name;
+  avl_insert(&_flooding_graphs, &fg->_node);
+  return fg;
+}
+
+/**
+ * Remove a persistent flooding graph
+ * @param fg flooding graph
+ */
+static void
+_remove_flooding_graph(struct _flooding_graph *fg) {
+  _clear_graph(&fg->mg);
+  mpr_arena_free(&fg->mg.arena);
+  avl_remove(&_flooding_graphs, &fg->_node);
+  free(fg);
+}
+
+/**
+ * Remove all persistent neighbor graphs
+ */
+static void
+_clear_all_graphs(void) {
+  struct _flooding_graph *fg, *fg_it;
+  size_t i;
+
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    _clear_graph(&_routing_graphs[i].mg);
+  }
+  avl_for_each_element_safe(&_flooding_graphs, fg, _node, fg_it) {
+    _remove_flooding_graph(fg);
+  }
+}
+
+/**
+ * Callback for added, changed and removed two-hop neighbors
+ * @param ptr NHDP two-hop neighbor
+ */
+static void
+_cb_l2hop_changed(void *ptr) {
+  struct nhdp_l2hop *l2hop = ptr;
+  struct _flooding_graph *fg;
+
+  _add_changed_routing_addr(&l2hop->twohop_addr, false);
+
+  fg = avl_find_element(&_flooding_graphs, nhdp_interface_get_name(l2hop->link->local_if), fg, _node);
+  if (fg) {
+    _add_changed_addr(&fg->mg, &l2hop->twohop_addr, false);
+  }
+}
+
+/**
+ * Callback for added, changed and removed neighbor addresses,
+ * which change d1(y) of two-hop neighbors with the same address
+ * @param ptr NHDP neighbor address
+ */
+static void
+_cb_naddr_changed(void *ptr) {
+  struct nhdp_naddr *naddr = ptr;
+  struct _flooding_graph *fg;
+
+  _add_changed_routing_addr(&naddr->neigh_addr, true);
+
+  avl_for_each_element(&_flooding_graphs, fg, _node) {
+    _add_changed_addr(&fg->mg, &naddr->neigh_addr, true);
+  }
+}
+
+/**
+ * Callback for link status changes and removed links, which might change N1
+ * @param ptr NHDP link, NULL to only rebuild the routing graphs
+ */
+static void
+_cb_link_changed(void *ptr) {
+  struct nhdp_link *lnk = ptr;
+  struct _flooding_graph *fg;
+  size_t i;
+
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    _routing_graphs[i].mg.rebuild = true;
+  }
+
+  if (lnk == NULL) {
+    return;
+  }
+
+  fg = avl_find_element(&_flooding_graphs, nhdp_interface_get_name(lnk->local_if), fg, _node);
+  if (fg) {
+    fg->mg.rebuild = true;
+  }
+}
+
+/**
+ * Callback for changed and removed neighbors, which might change N1
+ * or the originator of a N1 node
+ * @param ptr NHDP neighbor
+ */
+static void
+_cb_neighbor_changed(void *ptr) {
+  struct nhdp_neighbor *neigh = ptr;
+  struct nhdp_link *lnk;
+
+  list_for_each_element(&neigh->_links, lnk, _neigh_node) {
+    _cb_link_changed(lnk);
+  }
+
+  /* neighbor might not have a link anymore */
+  _cb_link_changed(NULL);
+}
+
+/**
+ * Callback for removed NHDP interfaces
+ * @param ptr NHDP interface
+ */
+static void
+_cb_interface_removed(void *ptr) {
+  struct nhdp_interface *nhdp_if = ptr;
+  struct _flooding_graph *fg;
+
+  fg = avl_find_element(&_flooding_graphs, nhdp_interface_get_name(nhdp_if), fg, _node);
+  if (fg) {
+    _remove_flooding_graph(fg);
+  }
+}
+
+/**
+ * Callback for configuration changes
+ */
+static void
+_cb_cfg_changed(void) {
+  if (cfg_schema_tobin(&_mpr_config, _mpr_section.post, _mpr_entries, ARRAYSIZE(_mpr_entries))) {
+    OONF_WARN(LOG_MPR, "Could not convert " OONF_MPR_SUBSYSTEM " plugin configuration");
+    return;
+  }
+
+  /* start from scratch with the new settings */
+  _clear_all_graphs();
+
+  /* recalculate MPRs with the selected engine */
+  nhdp_domain_delayed_mpr_recalculation(NULL, NULL);
+}
+
+/**
+ * Callback for the telnet command of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_mpr(struct oonf_telnet_data *con) {
+  return oonf_viewer_telnet_handler(
+    con->out, &_template_storage, OONF_MPR_SUBSYSTEM, con->parameter, _templates, ARRAYSIZE(_templates));
+}
+
+/**
+ * Callback for the help output of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_mpr_help(struct oonf_telnet_data *con) {
+  return oonf_viewer_telnet_help(con->out, OONF_MPR_SUBSYSTEM, con->parameter, _templates, ARRAYSIZE(_templates));
+}
+
+/**
+ * Callback to generate text/json description of the neighbor graph arenas
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_arena(struct oonf_viewer_template *template) {
+  const struct mpr_arena_stats *stats;
+
+  stats = mpr_arena_get_stats();
+
+  isonumber_from_u64(&_value_arena_blocks, stats->blocks, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_arena_block_allocs, stats->block_allocs, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_arena_block_frees, stats->block_frees, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_arena_node_allocs, stats->node_allocs, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_arena_resets, stats->resets, "", 1, template->create_raw);
+
+  /* generate template output */
+  oonf_viewer_output_print_line(template);
+  return 0;
+}
+
+/**
+ * Callback to generate text/json description of the flooding MPR statistics
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_flooding(struct oonf_viewer_template *template) {
+  isonumber_from_u64(&_value_flooding_calculations, _flooding_calculations, "", 1, template->create_raw);
+  isonumber_from_u64(&_value_flooding_shared, _flooding_shared, "", 1, template->create_raw);
+
+  /* generate template output */
+  oonf_viewer_output_print_line(template);
+  return 0;
 }
 
 #ifndef NDEBUG
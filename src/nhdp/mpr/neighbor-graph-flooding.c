@@ -74,8 +74,8 @@ static uint32_t _calculate_d1_of_y(struct mpr_flooding_data *data, struct addr_n
 #endif
 static uint32_t _calculate_d1_x_of_n2_addr(
   const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *addr);
-static void _calculate_n1(const struct nhdp_domain *domain, struct mpr_flooding_data *data);
-static void _calculate_n2(const struct nhdp_domain *domain, struct mpr_flooding_data *data);
+static int _calculate_n1(const struct nhdp_domain *domain, struct mpr_flooding_data *data);
+static int _calculate_n2(const struct nhdp_domain *domain, struct mpr_flooding_data *data);
 
 static bool _is_allowed_link_tuple(
   const struct nhdp_domain *domain, struct nhdp_interface *current_interface, struct nhdp_link *lnk);
@@ -84,6 +84,7 @@ static uint32_t _get_willingness_n1(const struct nhdp_domain *, struct n1_node *
 static struct neighbor_graph_interface _api_interface = {
   .is_allowed_link_tuple = _is_allowed_link_tuple,
   .calculate_d1_x_of_n2_addr = _calculate_d1_x_of_n2_addr,
+  .calculate_d1_x = _calculate_d1_x,
   .calculate_d_x_y = _calculate_d_x_y,
   .calculate_d2_x_y = _calculate_d2_x_y,
   .get_willingness_n1 = _get_willingness_n1,
@@ -143,7 +144,7 @@ _calculate_d2_x_y(const struct nhdp_domain *domain, struct n1_node *x, struct ad
   struct nhdp_l2hop_domaindata *twohopdata;
 
   /* find the corresponding 2-hop entry, if it exists */
-  tmp_l2hop = avl_find_element(&x->link->_2hop, &y->addr, tmp_l2hop, _link_node);
+  tmp_l2hop = ndhp_db_link_2hop_get(x->link, &y->addr);
   if (tmp_l2hop) {
     twohopdata = nhdp_domain_get_l2hopdata(domain, tmp_l2hop);
     return twohopdata->metric.out;
@@ -214,8 +215,9 @@ _calculate_d1_x_of_n2_addr(const struct nhdp_domain *domain, struct neighbor_gra
  * Calculate N1
  * @param domain NHDP domain
  * @param data flooding data
+ * @return -1 if an error happened, 0 otherwise
  */
-static void
+static int
 _calculate_n1(const struct nhdp_domain *domain, struct mpr_flooding_data *data) {
   struct nhdp_link *lnk;
 
@@ -226,9 +228,12 @@ _calculate_n1(const struct nhdp_domain *domain, struct mpr_flooding_data *data)
     lnk->neigh->selection_is_mpr = false;
 
     if (_is_allowed_link_tuple(domain, data->current_interface, lnk)) {
-      mpr_add_n1_node_to_set(&data->neigh_graph.set_n1, lnk->neigh, lnk, 0);
+      if (mpr_add_n1_node_to_set(&data->neigh_graph, &data->neigh_graph.set_n1, lnk->neigh, lnk, 0)) {
+        return -1;
+      }
     }
   }
+  return 0;
 }
 
 /**
@@ -243,8 +248,9 @@ _calculate_n1(const struct nhdp_domain *domain, struct mpr_flooding_data *data)
  *
  * @param domain NHDP domain
  * @param data flooding data
+ * @return -1 if an error happened, 0 otherwise
  */
-static void
+static int
 _calculate_n2(const struct nhdp_domain *domain, struct mpr_flooding_data *data) {
   struct n1_node *n1_neigh;
   struct nhdp_l2hop *twohop;
@@ -255,10 +261,13 @@ _calculate_n2(const struct nhdp_domain *domain, struct mpr_flooding_data *data)
   avl_for_each_element(&data->neigh_graph.set_n1, n1_neigh, _avl_node) {
     avl_for_each_element(&n1_neigh->link->_2hop, twohop, _link_node) {
       if (_is_allowed_2hop_tuple(domain, data->current_interface, twohop)) {
-        mpr_add_addr_node_to_set(&data->neigh_graph.set_n2, twohop->twohop_addr, 0);
+        if (mpr_add_addr_node_to_set(&data->neigh_graph, &data->neigh_graph.set_n2, twohop->twohop_addr, 0)) {
+          return -1;
+        }
       }
     }
   }
+  return 0;
 }
 
 /**
@@ -272,11 +281,19 @@ _get_willingness_n1(const struct nhdp_domain *domain __attribute__((unused)), st
   return node->link->flooding_willingness;
 }
 
-void
+/**
+ * Calculate the flooding neighbor graph of an interface
+ * @param domain NHDP domain
+ * @param data flooding data
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
 mpr_calculate_neighbor_graph_flooding(const struct nhdp_domain *domain, struct mpr_flooding_data *data) {
   OONF_DEBUG(LOG_MPR, "Calculate neighbor graph for flooding MPRs");
 
   mpr_init_neighbor_graph(&data->neigh_graph, &_api_interface);
-  _calculate_n1(domain, data);
-  _calculate_n2(domain, data);
+  if (_calculate_n1(domain, data) || _calculate_n2(domain, data)) {
+    return -1;
+  }
+  return 0;
 }
@@ -71,6 +71,7 @@ static uint32_t _calculate_d1_x_of_n2_addr(
   const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *addr);
 static uint32_t _calculate_d_x_y(
   const struct nhdp_domain *domain, struct neighbor_graph *, struct n1_node *x, struct addr_node *y);
+static uint32_t _calculate_d1_x(const struct nhdp_domain *domain, struct n1_node *x);
 static uint32_t _calculate_d2_x_y(const struct nhdp_domain *domain, struct n1_node *x, struct addr_node *y);
 static uint32_t _get_willingness_n1(const struct nhdp_domain *domain, struct n1_node *node);
 
@@ -79,6 +80,7 @@ static uint32_t _calculate_d1_of_y(const struct nhdp_domain *domain, struct neig
 static struct neighbor_graph_interface _rt_api_interface = {
   .is_allowed_link_tuple = _is_allowed_link_tuple,
   .calculate_d1_x_of_n2_addr = _calculate_d1_x_of_n2_addr,
+  .calculate_d1_x = _calculate_d1_x,
   .calculate_d_x_y = _calculate_d_x_y,
   .calculate_d2_x_y = _calculate_d2_x_y,
   .get_willingness_n1 = _get_willingness_n1,
@@ -153,7 +155,7 @@ _calculate_d2_x_y(const struct nhdp_domain *domain, struct n1_node *x, struct ad
 
   /* find the corresponding 2-hop entry, if it exists */
   list_for_each_element(&x->neigh->_links, lnk, _neigh_node) {
-    l2hop = avl_find_element(&lnk->_2hop, &y->addr, l2hop, _link_node);
+    l2hop = ndhp_db_link_2hop_get(lnk, &y->addr);
     if (l2hop) {
       twohopdata = nhdp_domain_get_l2hopdata(domain, l2hop);
       return twohopdata->metric.in;
@@ -238,8 +240,9 @@ _calculate_d1_x_of_n2_addr(const struct nhdp_domain *domain, struct neighbor_gra
  * Calculate N1
  * @param domain NHDP domain
  * @param graph neighbor graph instance
+ * @return -1 if an error happened, 0 otherwise
  */
-static void
+static int
 _calculate_n1(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct nhdp_neighbor *neigh;
 
@@ -256,12 +259,21 @@ _calculate_n1(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
     if (_is_allowed_neighbor_tuple(domain, neigh)) {
       OONF_DEBUG(LOG_MPR, "Add neighbor %s in: %u", netaddr_to_string(&buf1, &neigh->originator),
         nhdp_domain_get_neighbordata(domain, neigh)->metric.in);
-      mpr_add_n1_node_to_set(&graph->set_n1, neigh, NULL, 0);
+      if (mpr_add_n1_node_to_set(graph, &graph->set_n1, neigh, NULL, 0)) {
+        return -1;
+      }
     }
   }
+  return 0;
 }
 
-static void
+/**
+ * Calculate N2
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
 _calculate_n2(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct n1_node *n1_neigh;
   struct nhdp_link *lnk;
@@ -295,11 +307,14 @@ _calculate_n2(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
             l2data->metric.in, l2data->metric.out, l2data->metric.in + neighdata->metric.in,
             l2data->metric.out + neighdata->metric.out);
 #endif
-          mpr_add_addr_node_to_set(&graph->set_n2, twohop->twohop_addr, 0);
+          if (mpr_add_addr_node_to_set(graph, &graph->set_n2, twohop->twohop_addr, 0)) {
+            return -1;
+          }
         }
       }
     }
   }
+  return 0;
 }
 
 /**
@@ -321,7 +336,13 @@ _get_neighbor_graph_interface_routing(void) {
   return &_rt_api_interface;
 }
 
-void
+/**
+ * Calculate the routing neighbor graph of a domain
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
 mpr_calculate_neighbor_graph_routing(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct neighbor_graph_interface *methods;
 
@@ -330,6 +351,8 @@ mpr_calculate_neighbor_graph_routing(const struct nhdp_domain *domain, struct ne
   methods = _get_neighbor_graph_interface_routing();
 
   mpr_init_neighbor_graph(graph, methods);
-  _calculate_n1(domain, graph);
-  _calculate_n2(domain, graph);
+  if (_calculate_n1(domain, graph) || _calculate_n2(domain, graph)) {
+    return -1;
+  }
+  return 0;
 }
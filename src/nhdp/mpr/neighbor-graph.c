@@ -67,35 +67,263 @@
 
 /* FIXME remove unneeded includes */
 
+static void *_arena_alloc(struct mpr_arena *arena);
+static struct mpr_arena_chunk *_arena_alloc_chunk(struct mpr_arena *arena, size_t size);
+static void _arena_free_chunks(struct mpr_arena *arena);
+
+/* statistics of all arenas */
+static struct mpr_arena_stats _arena_stats;
+
+/**
+ * Initialize an arena for neighbor graph nodes
+ * @param arena MPR arena
+ */
+void
+mpr_arena_init(struct mpr_arena *arena) {
+  list_init_head(&arena->_blocks);
+  list_init_head(&arena->_chunks);
+  arena->_current = NULL;
+}
+
+/**
+ * Mark all nodes of an arena as unused, but keep the allocated blocks
+ * @param arena MPR arena
+ */
+void
+mpr_arena_reset(struct mpr_arena *arena) {
+  struct mpr_arena_block *block;
+  struct mpr_arena_chunk *chunk;
+  size_t size;
+
+  list_for_each_element(&arena->_blocks, block, _node) {
+    block->used = 0;
+  }
+
+  chunk = list_is_empty(&arena->_chunks) ? NULL : list_first_element(&arena->_chunks, chunk, _node);
+  if (chunk != NULL && !list_is_last(&arena->_chunks, &chunk->_node)) {
+    /* replace multiple chunks by a single one that fits the next calculation */
+    size = 0;
+    list_for_each_element(&arena->_chunks, chunk, _node) {
+      size += chunk->size;
+    }
+    _arena_free_chunks(arena);
+    _arena_alloc_chunk(arena, size);
+  }
+  list_for_each_element(&arena->_chunks, chunk, _node) {
+    chunk->used = 0;
+  }
+
+  arena->_current = list_is_empty(&arena->_blocks) ? NULL : list_first_element(&arena->_blocks, block, _node);
+  _arena_stats.resets++;
+}
+
+/**
+ * Return all blocks of an arena to the heap
+ * @param arena MPR arena
+ */
 void
-mpr_add_n1_node_to_set(struct avl_tree *set, struct nhdp_neighbor *neigh, struct nhdp_link *lnk, uint32_t offset) {
+mpr_arena_free(struct mpr_arena *arena) {
+  struct mpr_arena_block *block, *block_it;
+
+  list_for_each_element_safe(&arena->_blocks, block, _node, block_it) {
+    list_remove(&block->_node);
+    free(block);
+
+    _arena_stats.block_frees++;
+    _arena_stats.blocks--;
+  }
+  arena->_current = NULL;
+
+  _arena_free_chunks(arena);
+}
+
+/**
+ * @return statistics of all MPR arenas
+ */
+const struct mpr_arena_stats *
+mpr_arena_get_stats(void) {
+  return &_arena_stats;
+}
+
+/**
+ * Allocate a cleared graph node from an arena
+ * @param arena MPR arena
+ * @return pointer to node, NULL if out of memory
+ */
+static void *
+_arena_alloc(struct mpr_arena *arena) {
+  struct mpr_arena_block *block;
+  void *node;
+
+  block = arena->_current;
+  if (block != NULL && block->used == MPR_ARENA_BLOCK_NODES) {
+    /* continue with the next allocated block */
+    block = list_is_last(&arena->_blocks, &block->_node) ? NULL : list_next_element(block, _node);
+  }
+
+  if (block == NULL) {
+    block = malloc(sizeof(*block));
+    if (block == NULL) {
+      return NULL;
+    }
+    block->used = 0;
+    list_add_tail(&arena->_blocks, &block->_node);
+
+    _arena_stats.block_allocs++;
+    _arena_stats.blocks++;
+  }
+  arena->_current = block;
+
+  node = &block->nodes[block->used++];
+  memset(node, 0, sizeof(block->nodes[0]));
+
+  _arena_stats.node_allocs++;
+  return node;
+}
+
+/**
+ * Allocate a cleared array from an arena
+ * @param arena MPR arena
+ * @param count number of array elements
+ * @param size size of an array element
+ * @return pointer to 64 bit aligned array, NULL if out of memory
+ */
+void *
+mpr_arena_alloc_array(struct mpr_arena *arena, size_t count, size_t size) {
+  struct mpr_arena_chunk *chunk, *free_chunk;
+  size_t length;
+  void *array;
+
+  if (size != 0 && count > (SIZE_MAX - sizeof(uint64_t)) / size) {
+    return NULL;
+  }
+
+  /* keep all arrays 64 bit aligned */
+  length = (count * size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+
+  free_chunk = NULL;
+  list_for_each_element(&arena->_chunks, chunk, _node) {
+    if (chunk->size - chunk->used >= length) {
+      free_chunk = chunk;
+      break;
+    }
+  }
+  if (free_chunk == NULL) {
+    free_chunk = _arena_alloc_chunk(arena, length);
+    if (free_chunk == NULL) {
+      return NULL;
+    }
+  }
+
+  array = (uint8_t *)free_chunk->data + free_chunk->used;
+  free_chunk->used += length;
+
+  memset(array, 0, length);
+  return array;
+}
+
+/**
+ * Allocate a new chunk for arrays
+ * @param arena MPR arena
+ * @param size minimal size of chunk in bytes
+ * @return pointer to chunk, NULL if out of memory
+ */
+static struct mpr_arena_chunk *
+_arena_alloc_chunk(struct mpr_arena *arena, size_t size) {
+  struct mpr_arena_chunk *chunk;
+
+  if (size < MPR_ARENA_CHUNK_SIZE) {
+    size = MPR_ARENA_CHUNK_SIZE;
+  }
+
+  chunk = malloc(sizeof(*chunk) + size);
+  if (chunk == NULL) {
+    return NULL;
+  }
+  chunk->size = size;
+  chunk->used = 0;
+  list_add_tail(&arena->_chunks, &chunk->_node);
+
+  _arena_stats.block_allocs++;
+  _arena_stats.blocks++;
+  return chunk;
+}
+
+/**
+ * Return all array chunks of an arena to the heap
+ * @param arena MPR arena
+ */
+static void
+_arena_free_chunks(struct mpr_arena *arena) {
+  struct mpr_arena_chunk *chunk, *chunk_it;
+
+  list_for_each_element_safe(&arena->_chunks, chunk, _node, chunk_it) {
+    list_remove(&chunk->_node);
+    free(chunk);
+
+    _arena_stats.block_frees++;
+    _arena_stats.blocks--;
+  }
+}
+
+/**
+ * Add a N1 node to a set of a neighbor graph
+ * @param graph neighbor graph instance
+ * @param set AVL set of N1 nodes
+ * @param neigh NHDP neighbor
+ * @param lnk NHDP link, NULL for routing graphs
+ * @param offset table offset of node
+ * @return -1 if out of memory, 0 otherwise
+ */
+int
+mpr_add_n1_node_to_set(struct neighbor_graph *graph, struct avl_tree *set, struct nhdp_neighbor *neigh,
+  struct nhdp_link *lnk, uint32_t offset) {
   struct n1_node *tmp_n1_neigh;
   tmp_n1_neigh = avl_find_element(set, &neigh->originator, tmp_n1_neigh, _avl_node);
   if (tmp_n1_neigh) {
-    return;
+    return 0;
+  }
+  tmp_n1_neigh = _arena_alloc(graph->arena);
+  if (!tmp_n1_neigh) {
+    OONF_WARN(LOG_MPR, "Out of memory for MPR neighbor graph node");
+    return -1;
   }
-  tmp_n1_neigh = calloc(1, sizeof(struct n1_node));
   tmp_n1_neigh->addr = neigh->originator;
   tmp_n1_neigh->_avl_node.key = &tmp_n1_neigh->addr;
   tmp_n1_neigh->neigh = neigh;
   tmp_n1_neigh->link = lnk;
   tmp_n1_neigh->table_offset = offset;
   avl_insert(set, &tmp_n1_neigh->_avl_node);
+  return 0;
 }
 
-void
-mpr_add_addr_node_to_set(struct avl_tree *set, const struct netaddr addr, uint32_t offset) {
+/**
+ * Add an address node to a set of a neighbor graph
+ * @param graph neighbor graph instance
+ * @param set AVL set of address nodes
+ * @param addr network address
+ * @param offset table offset of node
+ * @return -1 if out of memory, 0 otherwise
+ */
+int
+mpr_add_addr_node_to_set(
+  struct neighbor_graph *graph, struct avl_tree *set, const struct netaddr addr, uint32_t offset) {
   struct addr_node *tmp_node;
 
   tmp_node = avl_find_element(set, &addr, tmp_node, _avl_node);
   if (tmp_node) {
-    return;
+    return 0;
+  }
+  tmp_node = _arena_alloc(graph->arena);
+  if (!tmp_node) {
+    OONF_WARN(LOG_MPR, "Out of memory for MPR neighbor graph node");
+    return -1;
   }
-  tmp_node = calloc(1, sizeof(struct addr_node));
   tmp_node->addr = addr;
   tmp_node->_avl_node.key = &tmp_node->addr;
   tmp_node->table_offset = offset;
   avl_insert(set, &tmp_node->_avl_node);
+  return 0;
 }
 
 /**
@@ -114,31 +342,23 @@ mpr_init_neighbor_graph(struct neighbor_graph *graph, struct neighbor_graph_inte
 }
 
 /**
- * Clear a set of addresses
+ * Clear a set of addresses, the nodes stay allocated
+ * until the arena of the graph is reset
  * @param set AVL set to clear
  */
 void
 mpr_clear_addr_set(struct avl_tree *set) {
-  struct addr_node *current_node, *node_it;
-
-  avl_for_each_element_safe(set, current_node, _avl_node, node_it) {
-    avl_remove(set, &current_node->_avl_node);
-    free(current_node);
-  }
+  avl_init(set, avl_comp_netaddr, false);
 }
 
 /**
- * Clear set of N1 nodes
+ * Clear set of N1 nodes, the nodes stay allocated
+ * until the arena of the graph is reset
  * @param set AVL set to clear
  */
 void
 mpr_clear_n1_set(struct avl_tree *set) {
-  struct n1_node *current_node, *node_it;
-
-  avl_for_each_element_safe(set, current_node, _avl_node, node_it) {
-    avl_remove(set, &current_node->_avl_node);
-    free(current_node);
-  }
+  avl_init(set, avl_comp_netaddr, false);
 }
 
 /**
@@ -153,8 +373,12 @@ mpr_clear_neighbor_graph(struct neighbor_graph *graph) {
   mpr_clear_n1_set(&graph->set_mpr);
   mpr_clear_n1_set(&graph->set_mpr_candidates);
 
-  free(graph->d_x_y_cache);
+  /* the cost cache is part of the arena */
   graph->d_x_y_cache = NULL;
+  graph->d_x_y_rows = 0;
+  graph->d_x_y_used = 0;
+
+  mpr_arena_reset(graph->arena);
 }
 
 /**
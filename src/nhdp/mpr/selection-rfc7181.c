@@ -66,9 +66,54 @@
 
 /* FIXME remove unneeded includes */
 
-static void _calculate_n(const struct nhdp_domain *domain, struct neighbor_graph *graph);
+static int _calculate_n(const struct nhdp_domain *domain, struct neighbor_graph *graph);
 static unsigned int _calculate_r(
   const struct nhdp_domain *domain, struct neighbor_graph *graph, struct n1_node *x_node);
+static bool _is_n_member(const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *y_node);
+static bool _is_n2_member(const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *y_node);
+static int _update_n2_node(const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *y_node);
+static int _init_cost_cache(const struct nhdp_domain *domain, struct neighbor_graph *graph);
+
+static void _bitset_or(uint64_t *dst, const uint64_t *src, size_t words);
+static uint32_t _bitset_count_uncovered(const uint64_t *set, const uint64_t *covered, size_t words);
+
+/*! number of bits in a bitset word */
+#define BITSET_WORD_BITS 64
+
+/*! minimum number of d(x,y) cache rows for two-hop neighbors added by incremental updates */
+#define SPARE_N2_ROWS 16
+
+/**
+ * Dense working data of the bitset based MPR selection
+ */
+struct _bitset_graph {
+  /*! array of N1 nodes, index is the dense N1 id */
+  struct n1_node **n1;
+
+  /*! number of N1 nodes */
+  uint32_t n1_count;
+
+  /*! number of members of N */
+  uint32_t n_count;
+
+  /*! number of 64 bit words of a bitset over N */
+  size_t words;
+
+  /*! n1_count bitsets over N, bit y of set x is set if d(x,y) is minimal */
+  uint64_t *minimal;
+
+  /*! bitset over N, bit y is set if y is covered by a selected MPR */
+  uint64_t *covered;
+
+  /*! number of N1 nodes with defined d2(x,y) for each member of N */
+  uint32_t *reach_count;
+
+  /*! dense N1 id of the last N1 node with defined d2(x,y) */
+  uint32_t *reach_last;
+
+  /*! true if N1 node is selected as an MPR */
+  bool *is_mpr;
+};
 
 /**
  * Calculate N
@@ -79,40 +124,68 @@ static unsigned int _calculate_r(
  *
  * @param domain NHDP domain
  * @param graph neighbor graph instance
+ * @return -1 if out of memory, 0 otherwise
  */
-static void
+static int
 _calculate_n(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct addr_node *y_node;
-  uint32_t d1_y;
-  struct n1_node *x_node;
-  bool add_to_n;
 
   OONF_DEBUG(LOG_MPR, "Calculate N");
 
   avl_for_each_element(&graph->set_n2, y_node, _avl_node) {
-    add_to_n = false;
+    if (_is_n_member(domain, graph, y_node) &&
+        mpr_add_addr_node_to_set(graph, &graph->set_n, y_node->addr, y_node->table_offset)) {
+      return -1;
+    }
+  }
+  return 0;
+}
 
-    /* calculate the 1-hop cost to this node (which may be undefined) */
-    d1_y = graph->methods->calculate_d1_x_of_n2_addr(domain, graph, y_node);
+/**
+ * Check if a member of N2 has to be part of N and remember its d1(y)
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance
+ * @param y_node member of N2
+ * @return true if node is part of N
+ */
+static bool
+_is_n_member(const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *y_node) {
+  struct n1_node *x_node;
 
-    /* if this neighbor can not be reached directly, we need to add it to N */
-    if (d1_y == RFC7181_METRIC_INFINITE) {
-      add_to_n = true;
-    }
-    else {
-      /* check if an intermediate hop would reduce the path cost */
-      avl_for_each_element(&graph->set_n1, x_node, _avl_node) {
-        if (graph->methods->calculate_d_x_y(domain, graph, x_node, y_node) < d1_y) {
-          add_to_n = true;
-          break;
-        }
-      }
+  /* calculate the 1-hop cost to this node (which may be undefined) */
+  y_node->d1 = graph->methods->calculate_d1_x_of_n2_addr(domain, graph, y_node);
+
+  /* if this neighbor can not be reached directly, we need to add it to N */
+  if (y_node->d1 == RFC7181_METRIC_INFINITE) {
+    return true;
+  }
+
+  /* check if an intermediate hop would reduce the path cost */
+  avl_for_each_element(&graph->set_n1, x_node, _avl_node) {
+    if (graph->methods->calculate_d_x_y(domain, graph, x_node, y_node) < y_node->d1) {
+      return true;
     }
+  }
+  return false;
+}
+
+/**
+ * Check if an address is reachable over a member of N1
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance
+ * @param y_node node with two-hop address
+ * @return true if address is part of N2
+ */
+static bool
+_is_n2_member(const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *y_node) {
+  struct n1_node *x_node;
 
-    if (add_to_n) {
-      mpr_add_addr_node_to_set(&graph->set_n, y_node->addr, y_node->table_offset);
+  avl_for_each_element(&graph->set_n1, x_node, _avl_node) {
+    if (graph->methods->calculate_d2_x_y(domain, x_node, y_node) <= RFC7181_METRIC_MAX) {
+      return true;
     }
   }
+  return false;
 }
 
 /**
@@ -191,8 +264,9 @@ _calculate_r(const struct nhdp_domain *domain, struct neighbor_graph *graph, str
  * Add all elements x in N1 that have W(x) = WILL_ALWAYS to M.
  * @param domain NHDP domain
  * @param graph neighbor graph instance
+ * @return -1 if out of memory, 0 otherwise
  */
-static void
+static int
 _process_will_always(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct n1_node *current_n1_node;
 #ifdef OONF_LOG_DEBUG_INFO
@@ -205,10 +279,13 @@ _process_will_always(const struct nhdp_domain *domain, struct neighbor_graph *gr
     if (graph->methods->get_willingness_n1(domain, current_n1_node) == RFC7181_WILLINGNESS_ALWAYS) {
       OONF_DEBUG(
         LOG_MPR, "Add neighbor %s with WILL_ALWAYS to the MPR set", netaddr_to_string(&buf1, &current_n1_node->addr));
-      mpr_add_n1_node_to_set(
-        &graph->set_mpr, current_n1_node->link->neigh, current_n1_node->link, current_n1_node->table_offset);
+      if (mpr_add_n1_node_to_set(graph, &graph->set_mpr, current_n1_node->neigh, current_n1_node->link,
+            current_n1_node->table_offset)) {
+        return -1;
+      }
     }
   }
+  return 0;
 }
 
 /**
@@ -216,8 +293,9 @@ _process_will_always(const struct nhdp_domain *domain, struct neighbor_graph *gr
  * x in N1 such that d2(x,y) is defined, add that element x to M.
  * @param domain NHDP domain
  * @param graph neighbor graph instance
+ * @return -1 if out of memory, 0 otherwise
  */
-static void
+static int
 _process_unique_mprs(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct n1_node *node_n1, *possible_mpr_node;
   struct addr_node *node_n;
@@ -248,11 +326,14 @@ _process_unique_mprs(const struct nhdp_domain *domain, struct neighbor_graph *gr
        * node must become an MPR. */
       OONF_DEBUG(
         LOG_MPR, "Add required neighbor %s to the MPR set", netaddr_to_string(&buf1, &possible_mpr_node->addr));
-      mpr_add_n1_node_to_set(
-        &graph->set_mpr, possible_mpr_node->neigh, possible_mpr_node->link, possible_mpr_node->table_offset);
+      if (mpr_add_n1_node_to_set(graph, &graph->set_mpr, possible_mpr_node->neigh, possible_mpr_node->link,
+            possible_mpr_node->table_offset)) {
+        return -1;
+      }
       possible_mpr_node->neigh->selection_is_mpr = true;
     }
   }
+  return 0;
 }
 
 /**
@@ -261,20 +342,19 @@ _process_unique_mprs(const struct nhdp_domain *domain, struct neighbor_graph *gr
  * @param domain NHDP domain for MPR calculation
  * @param graph neighbor graph instance
  * @param get_property callback for querying neighbor graph data
+ * @return -1 if out of memory, 0 otherwise
  */
-static void
+static int
 _select_greatest_by_property(const struct nhdp_domain *domain, struct neighbor_graph *graph,
   uint32_t (*get_property)(const struct nhdp_domain *, struct neighbor_graph *, struct n1_node *)) {
-  struct avl_tree *n1_subset, tmp_candidate_subset;
+  struct avl_tree *n1_subset;
   struct n1_node *node_n1, *greatest_prop_node;
-  uint32_t current_prop, greatest_prop, number_of_greatest;
+  uint32_t current_prop, greatest_prop;
 
   OONF_DEBUG(LOG_MPR, "Select node with greatest property");
 
   greatest_prop_node = NULL;
-  current_prop = greatest_prop = number_of_greatest = 0;
-
-  avl_init(&tmp_candidate_subset, avl_comp_netaddr, false);
+  current_prop = greatest_prop = 0;
 
   //  if (graph->set_mpr_candidates.count > 0) {
   //    /* We already have MPR candidates, so we need to select from these
@@ -287,37 +367,25 @@ _select_greatest_by_property(const struct nhdp_domain *domain, struct neighbor_g
   //  }
 
   /*
-   * Workaround for performance issues; function requires a rewrite!
+   * only the first node with the greatest property is used by the caller,
+   * so there is no need to collect all of them
    */
   avl_for_each_element(n1_subset, node_n1, _avl_node) {
     current_prop = get_property(domain, graph, node_n1);
-    if (current_prop > 0) {
-      if (greatest_prop_node == NULL || current_prop > greatest_prop) {
-        greatest_prop = current_prop;
-        greatest_prop_node = node_n1;
-        number_of_greatest = 1;
-
-        /* we have a unique candidate */
-        mpr_clear_n1_set(&tmp_candidate_subset);
-        mpr_add_n1_node_to_set(&tmp_candidate_subset, node_n1->neigh, node_n1->link, node_n1->table_offset);
-      }
-      else if (current_prop == greatest_prop) {
-        /* add node to candidate subset */
-        number_of_greatest++;
-        mpr_add_n1_node_to_set(&tmp_candidate_subset, node_n1->neigh, node_n1->link, node_n1->table_offset);
-      }
+    if (current_prop > 0 && (greatest_prop_node == NULL || current_prop > greatest_prop)) {
+      greatest_prop = current_prop;
+      greatest_prop_node = node_n1;
     }
   }
 
   /* write updated candidate subset */
   mpr_clear_n1_set(&graph->set_mpr_candidates);
 
-  avl_for_each_element(&tmp_candidate_subset, node_n1, _avl_node) {
-    mpr_add_n1_node_to_set(&graph->set_mpr_candidates, node_n1->neigh, node_n1->link, node_n1->table_offset);
+  if (greatest_prop_node) {
+    return mpr_add_n1_node_to_set(graph, &graph->set_mpr_candidates, greatest_prop_node->neigh,
+      greatest_prop_node->link, greatest_prop_node->table_offset);
   }
-
-  /* free temporary candidate subset */
-  mpr_clear_n1_set(&tmp_candidate_subset);
+  return 0;
 }
 
 // FIXME Wrapper required for having the correct signature...
@@ -332,8 +400,9 @@ _select_greatest_by_property(const struct nhdp_domain *domain, struct neighbor_g
  * While there exists any element x in N1 with R(x, M) > 0...
  * @param domain NHDP domain
  * @param graph neighbor graph instance
+ * @return -1 if out of memory, 0 otherwise
  */
-static void
+static int
 _process_remaining(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct n1_node *node_n1;
   bool done;
@@ -355,7 +424,9 @@ _process_remaining(const struct nhdp_domain *domain, struct neighbor_graph *grap
     //    if (graph->set_mpr_candidates.count > 1) {
     OONF_DEBUG(LOG_MPR, "Select by greatest coverage");
     //                 graph->set_mpr_candidates.count);
-    _select_greatest_by_property(domain, graph, &_calculate_r);
+    if (_select_greatest_by_property(domain, graph, &_calculate_r)) {
+      return -1;
+    }
     //    }
 
     /* TODO More tie-breaking methods might be added here
@@ -370,50 +441,386 @@ _process_remaining(const struct nhdp_domain *domain, struct neighbor_graph *grap
       OONF_DEBUG(LOG_MPR, "No more candidates, we are done!");
       done = true;
     }
-    else if (graph->set_mpr_candidates.count == 1) {
-      /* a unique candidate was found */
-      node_n1 = avl_first_element(&graph->set_mpr_candidates, node_n1, _avl_node);
-      OONF_DEBUG(LOG_MPR, "Unique candidate %s", netaddr_to_string(&buf1, &node_n1->addr));
-      mpr_add_n1_node_to_set(&graph->set_mpr, node_n1->neigh, node_n1->link, node_n1->table_offset);
-      node_n1->neigh->selection_is_mpr = true;
-      avl_remove(&graph->set_mpr_candidates, &node_n1->_avl_node);
-      free(node_n1);
-      //      done = true;
-    }
     else {
-      /* Multiple candidates were found; arbitrarily add one of the
-       * candidate nodes (first in list). */
+      /* add the first candidate with the greatest coverage */
       node_n1 = avl_first_element(&graph->set_mpr_candidates, node_n1, _avl_node);
-      OONF_DEBUG(LOG_MPR, "Multiple candidates, select %s", netaddr_to_string(&buf1, &node_n1->addr));
-      mpr_add_n1_node_to_set(&graph->set_mpr, node_n1->neigh, node_n1->link, node_n1->table_offset);
+      OONF_DEBUG(LOG_MPR, "Select candidate %s", netaddr_to_string(&buf1, &node_n1->addr));
+      if (mpr_add_n1_node_to_set(graph, &graph->set_mpr, node_n1->neigh, node_n1->link, node_n1->table_offset)) {
+        return -1;
+      }
       node_n1->neigh->selection_is_mpr = true;
       avl_remove(&graph->set_mpr_candidates, &node_n1->_avl_node);
-      free(node_n1);
     }
   }
+  return 0;
 }
 
 /**
  * Calculate MPR
  * @param domain NHDP domain
  * @param graph neighbor graph instance
+ * @return -1 if out of memory, 0 otherwise
  */
-void
+int
 mpr_calculate_mpr_rfc7181(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
+  OONF_DEBUG(LOG_MPR, "Calculate MPR set");
+
+  if (_init_cost_cache(domain, graph) || _calculate_n(domain, graph)) {
+    return -1;
+  }
+
+  if (_process_will_always(domain, graph) || _process_unique_mprs(domain, graph) ||
+      _process_remaining(domain, graph)) {
+    return -1;
+  }
+
+  /* TODO Optional optimization step */
+  return 0;
+}
+
+/**
+ * Calculate MPR with dense N1/N indices and coverage bitsets.
+ *
+ * This produces the same MPR set as mpr_calculate_mpr_rfc7181(), but
+ * computes R(x,M) for all x with a single popcount over the uncovered
+ * part of N instead of rescanning N and N1 for every candidate.
+ * The working arrays are allocated from the arena of the graph.
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance
+ * @return -1 if out of memory, 0 otherwise
+ */
+int
+mpr_calculate_mpr_rfc7181_bitset(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
+  struct _bitset_graph bg;
+  struct n1_node *n1;
+  struct addr_node *y_node;
+  uint32_t i, j, d_x_y, min_d_z_y, r, best_r, best;
+  uint64_t *minimal;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  OONF_DEBUG(LOG_MPR, "Calculate MPR set (bitset)");
+
+  if (_init_cost_cache(domain, graph) || _calculate_n(domain, graph)) {
+    return -1;
+  }
+
+  memset(&bg, 0, sizeof(bg));
+  bg.n1_count = graph->set_n1.count;
+  bg.n_count = graph->set_n.count;
+  bg.words = (bg.n_count + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+
+  bg.n1 = mpr_arena_alloc_array(graph->arena, bg.n1_count, sizeof(struct n1_node *));
+  bg.minimal = mpr_arena_alloc_array(graph->arena, bg.n1_count * bg.words, sizeof(uint64_t));
+  bg.covered = mpr_arena_alloc_array(graph->arena, bg.words, sizeof(uint64_t));
+  bg.reach_count = mpr_arena_alloc_array(graph->arena, bg.n_count, sizeof(uint32_t));
+  bg.reach_last = mpr_arena_alloc_array(graph->arena, bg.n_count, sizeof(uint32_t));
+  bg.is_mpr = mpr_arena_alloc_array(graph->arena, bg.n1_count, sizeof(bool));
+
+  if (!bg.n1 || !bg.minimal || !bg.covered || !bg.reach_count || !bg.reach_last || !bg.is_mpr) {
+    OONF_WARN(LOG_MPR, "Not enough memory for bitset MPR selection, using AVL based selection");
+    if (_process_will_always(domain, graph) || _process_unique_mprs(domain, graph) ||
+        _process_remaining(domain, graph)) {
+      return -1;
+    }
+    return 0;
+  }
+
+  /* assign dense ids to N1 */
+  i = 0;
+  avl_for_each_element(&graph->set_n1, n1, _avl_node) {
+    bg.n1[i++] = n1;
+  }
+
+  /*
+   * calculate minimal cost bitsets and the number of possible MPRs for all members of N.
+   * N1 only contains nodes with a defined d1(x), so d2(x,y) is defined exactly when d(x,y) is.
+   */
+  j = 0;
+  avl_for_each_element(&graph->set_n, y_node, _avl_node) {
+    min_d_z_y = mpr_calculate_minimal_d_z_y(domain, graph, y_node);
+
+    for (i = 0; i < bg.n1_count; i++) {
+      d_x_y = graph->methods->calculate_d_x_y(domain, graph, bg.n1[i], y_node);
+      if (d_x_y == min_d_z_y) {
+        bg.minimal[i * bg.words + j / BITSET_WORD_BITS] |= 1ull << (j % BITSET_WORD_BITS);
+      }
+      if (d_x_y < RFC7181_METRIC_INFINITE_PATH) {
+        bg.reach_count[j]++;
+        bg.reach_last[j] = i;
+      }
+    }
+    OONF_ASSERT(bg.reach_count[j] > 0, LOG_MPR, "There should be at least one possible MPR");
+    j++;
+  }
+
+  /* add all elements x in N1 that have W(x) = WILL_ALWAYS to M */
+  for (i = 0; i < bg.n1_count; i++) {
+    n1 = bg.n1[i];
+    if (graph->methods->get_willingness_n1(domain, n1) == RFC7181_WILLINGNESS_ALWAYS &&
+        mpr_add_n1_node_to_set(graph, &graph->set_mpr, n1->neigh, n1->link, n1->table_offset)) {
+      return -1;
+    }
+  }
+
+  /* add x to M if it is the only element in N1 with defined d2(x,y) for some y in N */
+  for (j = 0; j < bg.n_count; j++) {
+    i = bg.reach_last[j];
+    if (bg.reach_count[j] == 1 && !bg.is_mpr[i]) {
+      n1 = bg.n1[i];
+      OONF_DEBUG(LOG_MPR, "Add required neighbor %s to the MPR set", netaddr_to_string(&nbuf, &n1->addr));
+      if (mpr_add_n1_node_to_set(graph, &graph->set_mpr, n1->neigh, n1->link, n1->table_offset)) {
+        return -1;
+      }
+      n1->neigh->selection_is_mpr = true;
+      bg.is_mpr[i] = true;
+      _bitset_or(bg.covered, &bg.minimal[i * bg.words], bg.words);
+    }
+  }
+
+  /* add the node with the greatest R(x,M) to M until R(x,M) is zero for all x */
+  while (true) {
+    best = 0;
+    best_r = 0;
+    for (i = 0; i < bg.n1_count; i++) {
+      if (bg.is_mpr[i]) {
+        continue;
+      }
+
+      minimal = &bg.minimal[i * bg.words];
+      r = _bitset_count_uncovered(minimal, bg.covered, bg.words);
+      if (r > best_r) {
+        best_r = r;
+        best = i;
+      }
+    }
+
+    if (best_r == 0) {
+      OONF_DEBUG(LOG_MPR, "No more candidates, we are done!");
+      break;
+    }
+
+    n1 = bg.n1[best];
+    OONF_DEBUG(LOG_MPR, "Select %s with R(x,M) = %u", netaddr_to_string(&nbuf, &n1->addr), best_r);
+    if (mpr_add_n1_node_to_set(graph, &graph->set_mpr, n1->neigh, n1->link, n1->table_offset)) {
+      return -1;
+    }
+    n1->neigh->selection_is_mpr = true;
+    bg.is_mpr[best] = true;
+    _bitset_or(bg.covered, &bg.minimal[best * bg.words], bg.words);
+  }
+  return 0;
+}
+
+/**
+ * Update the MPR set of a neighbor graph incrementally after changes
+ * of the neighborhood. N1 must be unchanged since the last calculation.
+ *
+ * The current MPR set is kept and only members of N2 affected by a
+ * change are evaluated again. Two-hop neighbors are added to or removed
+ * from N2 and if one of them is not covered with minimal cost anymore,
+ * the first N1 node providing the minimal cost is added to M. The result
+ * is a valid MPR set, but it might be larger than the one of a full
+ * calculation.
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance with MPR set
+ * @param changed array of two-hop addresses with changed costs or membership
+ * @param changed_count number of addresses in array
+ * @param max_affected maximum number of changed N2 nodes to handle
+ *   incrementally
+ * @return -1 if the neighbor graph must be rebuilt with a full
+ *   MPR calculation (or is out of memory), 0 otherwise
+ */
+int
+mpr_update_mpr_rfc7181(const struct nhdp_domain *domain, struct neighbor_graph *graph, const struct netaddr *changed,
+  uint32_t changed_count, uint32_t max_affected) {
+  struct n1_node *x_node;
+  struct addr_node *y_node, *y_it, tmp_node;
+  uint32_t i, d1_x, affected;
+  bool n1_changed;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  OONF_DEBUG(LOG_MPR, "Update MPR set incrementally");
+
+  /* check W(x) and d1(x) of all members of N1 */
+  n1_changed = false;
+  avl_for_each_element(&graph->set_n1, x_node, _avl_node) {
+    if (graph->methods->get_willingness_n1(domain, x_node) != x_node->willingness) {
+      /* a change of W(x) can add or remove WILL_ALWAYS nodes */
+      OONF_DEBUG(LOG_MPR, "Willingness of %s changed", netaddr_to_string(&nbuf, &x_node->addr));
+      return -1;
+    }
+
+    d1_x = graph->methods->calculate_d1_x(domain, x_node);
+    if (d1_x > RFC7181_METRIC_MAX) {
+      OONF_DEBUG(LOG_MPR, "%s is not part of N1 anymore", netaddr_to_string(&nbuf, &x_node->addr));
+      return -1;
+    }
+    x_node->changed = d1_x != x_node->d1;
+    x_node->d1 = d1_x;
+    n1_changed |= x_node->changed;
+  }
+
+  affected = 0;
+  if (n1_changed) {
+    /* d1(x) is part of d(x,y) for all y reachable over x and might be d1(y) for addresses of x */
+    avl_for_each_element(&graph->set_n1, x_node, _avl_node) {
+      if (!x_node->changed) {
+        continue;
+      }
+      x_node->changed = false;
+
+      avl_for_each_element(&graph->set_n2, y_node, _avl_node) {
+        if (!y_node->changed && (y_node->d1 != RFC7181_METRIC_INFINITE ||
+                                 graph->methods->calculate_d2_x_y(domain, x_node, y_node) <= RFC7181_METRIC_MAX)) {
+          y_node->changed = true;
+          affected++;
+        }
+      }
+    }
+  }
+
+  /* two-hop addresses changed by the NHDP database */
+  memset(&tmp_node, 0, sizeof(tmp_node));
+  for (i = 0; i < changed_count; i++) {
+    y_node = avl_find_element(&graph->set_n2, &changed[i], y_node, _avl_node);
+    if (y_node == NULL) {
+      memcpy(&tmp_node.addr, &changed[i], sizeof(tmp_node.addr));
+      if (!_is_n2_member(domain, graph, &tmp_node)) {
+        continue;
+      }
+      if (graph->d_x_y_used == graph->d_x_y_rows) {
+        OONF_DEBUG(LOG_MPR, "No space left in d(x,y) cache");
+        return -1;
+      }
+
+      /* new two-hop neighbor */
+      if (mpr_add_addr_node_to_set(graph, &graph->set_n2, changed[i], graph->d_x_y_used * graph->set_n1.count)) {
+        return -1;
+      }
+      y_node = avl_find_element(&graph->set_n2, &changed[i], y_node, _avl_node);
+      graph->d_x_y_used++;
+    }
+
+    if (!y_node->changed) {
+      y_node->changed = true;
+      affected++;
+    }
+  }
+
+  OONF_DEBUG(LOG_MPR, "%u of %u N2 nodes changed", affected, graph->set_n2.count);
+  if (affected > max_affected) {
+    return -1;
+  }
+
+  if (affected > 0) {
+    avl_for_each_element_safe(&graph->set_n2, y_node, _avl_node, y_it) {
+      if (y_node->changed) {
+        y_node->changed = false;
+        if (_update_n2_node(domain, graph, y_node)) {
+          return -1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * Evaluate a changed member of N2 again, remove it from N2 if it is
+ * not a two-hop neighbor anymore and make sure it is still covered
+ * with minimal cost by the MPR set
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance
+ * @param y_node member of N2
+ * @return -1 if out of memory, 0 otherwise
+ */
+static int
+_update_n2_node(const struct nhdp_domain *domain, struct neighbor_graph *graph, struct addr_node *y_node) {
+  struct n1_node *x_node;
+  struct addr_node *n_node;
+  uint32_t d_y_n1, d_y_mpr;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf1, nbuf2;
+#endif
+
+  /* all d(x,y) of a N2 node are stored in one consecutive block of the cost cache */
+  memset(&graph->d_x_y_cache[y_node->table_offset], 0, graph->set_n1.count * sizeof(uint32_t));
+  y_node->min_d_z_y = 0;
+
+  n_node = avl_find_element(&graph->set_n, &y_node->addr, n_node, _avl_node);
+  if (!_is_n2_member(domain, graph, y_node)) {
+    OONF_DEBUG(LOG_MPR, "Remove %s from N2", netaddr_to_string(&nbuf1, &y_node->addr));
+    avl_remove(&graph->set_n2, &y_node->_avl_node);
+    if (n_node) {
+      avl_remove(&graph->set_n, &n_node->_avl_node);
+    }
+    return 0;
+  }
+
+  if (!_is_n_member(domain, graph, y_node)) {
+    if (n_node) {
+      avl_remove(&graph->set_n, &n_node->_avl_node);
+    }
+  }
+  else if (!n_node && mpr_add_addr_node_to_set(graph, &graph->set_n, y_node->addr, y_node->table_offset)) {
+    return -1;
+  }
+
+  d_y_n1 = mpr_calculate_d_of_y_s(domain, graph, y_node, &graph->set_n1);
+  d_y_mpr = mpr_calculate_d_of_y_s(domain, graph, y_node, &graph->set_mpr);
+  if (d_y_mpr == d_y_n1) {
+    return 0;
+  }
+
+  avl_for_each_element(&graph->set_n1, x_node, _avl_node) {
+    if (graph->methods->calculate_d_x_y(domain, graph, x_node, y_node) == d_y_n1) {
+      OONF_DEBUG(LOG_MPR, "Add %s to cover %s", netaddr_to_string(&nbuf1, &x_node->addr),
+        netaddr_to_string(&nbuf2, &y_node->addr));
+      if (mpr_add_n1_node_to_set(graph, &graph->set_mpr, x_node->neigh, x_node->link, x_node->table_offset)) {
+        return -1;
+      }
+      x_node->neigh->selection_is_mpr = true;
+      return 0;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Allocate the d(x,y) cache of a neighbor graph, assign the table
+ * offsets of N1 and N2 members and remember W(x) and d1(x) for
+ * incremental updates
+ * @param domain NHDP domain
+ * @param graph neighbor graph instance
+ * @return -1 if out of memory, 0 otherwise
+ */
+static int
+_init_cost_cache(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct n1_node *n1;
   struct addr_node *n2;
   uint32_t n1_count, n2_count, i;
 
-  OONF_DEBUG(LOG_MPR, "Calculate MPR set");
-
   n1_count = graph->set_n1.count;
   n2_count = graph->set_n2.count;
 
-  graph->d_x_y_cache = calloc(n1_count * n2_count, sizeof(uint32_t));
+  /* keep some rows for two-hop neighbors added by incremental updates */
+  graph->d_x_y_used = n2_count;
+  graph->d_x_y_rows = n2_count + n2_count / 4 + SPARE_N2_ROWS;
+
+  graph->d_x_y_cache = mpr_arena_alloc_array(graph->arena, n1_count * graph->d_x_y_rows, sizeof(uint32_t));
+  if (graph->d_x_y_cache == NULL) {
+    return -1;
+  }
 
   i = 0;
   avl_for_each_element(&graph->set_n1, n1, _avl_node) {
     n1->table_offset = i;
+    n1->willingness = graph->methods->get_willingness_n1(domain, n1);
+    n1->d1 = graph->methods->calculate_d1_x(domain, n1);
     i++;
   }
 
@@ -422,12 +829,39 @@ mpr_calculate_mpr_rfc7181(const struct nhdp_domain *domain, struct neighbor_grap
     n2->table_offset = i;
     i += n1_count;
   }
+  return 0;
+}
 
-  _calculate_n(domain, graph);
+/**
+ * Add all members of a bitset to another one
+ * @param dst destination bitset
+ * @param src source bitset
+ * @param words number of words of both bitsets
+ */
+static void
+_bitset_or(uint64_t *dst, const uint64_t *src, size_t words) {
+  size_t i;
 
-  _process_will_always(domain, graph);
-  _process_unique_mprs(domain, graph);
-  _process_remaining(domain, graph);
+  for (i = 0; i < words; i++) {
+    dst[i] |= src[i];
+  }
+}
 
-  /* TODO Optional optimization step */
+/**
+ * Count the members of a bitset which are not part of a second one
+ * @param set bitset to count
+ * @param covered bitset with members to ignore
+ * @param words number of words of both bitsets
+ * @return number of members of set not in covered
+ */
+static uint32_t
+_bitset_count_uncovered(const uint64_t *set, const uint64_t *covered, size_t words) {
+  uint32_t count;
+  size_t i;
+
+  count = 0;
+  for (i = 0; i < words; i++) {
+    count += __builtin_popcountll(set[i] & ~covered[i]);
+  }
+  return count;
 }
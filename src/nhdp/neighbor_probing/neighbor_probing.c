@@ -53,10 +53,13 @@
 #include <oonf/base/oonf_clock.h>
 #include <oonf/base/oonf_layer2.h>
 #include <oonf/base/oonf_rfc5444.h>
+#include <oonf/base/oonf_telnet.h>
 #include <oonf/base/oonf_timer.h>
+#include <oonf/base/oonf_viewer.h>
 #include <oonf/base/os_interface.h>
 
 #include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
 #include <oonf/nhdp/nhdp/nhdp_interfaces.h>
 
 #include <oonf/nhdp/neighbor_probing/neighbor_probing.h>
@@ -64,6 +67,9 @@
 /* definitions and constants */
 #define LOG_PROBING _olsrv2_neighbor_probing_subsystem.logging
 
+/*! maximum number of links probed during one probing interval */
+#define PROBING_MAX_BATCH 16
+
 /**
  * Configuration of neighbor probing plugin
  */
@@ -76,6 +82,12 @@ struct _config {
 
   /*! true to probe all DLEP interfaces */
   bool probe_dlep;
+
+  /*! number of links probed during one interval */
+  int32_t batch_size;
+
+  /*! maximum number of halvings of the probing priority of a link with a stable metric */
+  int32_t max_backoff;
 };
 
 /**
@@ -95,6 +107,32 @@ struct _probing_link_data {
    * pointer to RFC5444 target allocated for link neighbor
    */
   struct oonf_rfc5444_target *target;
+
+  /*! incoming link metric of each domain during the last probe */
+  uint32_t last_metric_in[NHDP_MAXIMUM_DOMAINS];
+
+  /*! number of halvings of the probing priority because of a stable metric */
+  uint32_t backoff;
+
+  /*! number of probes sent to the neighbor */
+  uint64_t probes;
+
+  /*! number of probing checks skipped because of unicast traffic */
+  uint64_t traffic_skips;
+};
+
+/**
+ * Candidate for a link probe
+ */
+struct _probe_candidate {
+  /*! nhdp link to be probed */
+  struct nhdp_link *lnk;
+
+  /*! probing extension of nhdp link */
+  struct _probing_link_data *ldata;
+
+  /*! probing priority of link */
+  uint64_t points;
 };
 
 /* prototypes */
@@ -102,10 +140,18 @@ static int _init(void);
 static void _cleanup(void);
 static void _cb_link_removed(void *);
 static void _cb_probe_link(struct oonf_timer_instance *);
+static void _add_candidate(struct _probe_candidate *candidates, size_t *count, size_t max_count,
+  struct nhdp_link *lnk, struct _probing_link_data *ldata, uint64_t points);
+static bool _has_stable_metric(struct nhdp_link *lnk, struct _probing_link_data *ldata);
+static void _send_probe(struct _probe_candidate *candidate);
 static int _cb_addMessageHeader(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
 static void _cb_addMessageTLVs(struct rfc5444_writer *);
 static void _cb_cfg_changed(void);
 
+static enum oonf_telnet_result _cb_probing(struct oonf_telnet_data *con);
+static enum oonf_telnet_result _cb_probing_help(struct oonf_telnet_data *con);
+static int _cb_create_text_link(struct oonf_viewer_template *);
+
 /* plugin declaration */
 static struct cfg_schema_entry _probing_entries[] = {
   CFG_MAP_CLOCK_MIN(_config, interval, "interval", "0.2", "Time interval between link probing", 100),
@@ -113,6 +159,12 @@ static struct cfg_schema_entry _probing_entries[] = {
   CFG_MAP_BOOL(_config, probe_dlep, "probe_dlep", "true",
     "Probe DLEP interfaces in addition to wireless interfaces"
     " if they don't support the 'need probing' flag"),
+  CFG_MAP_INT32_MINMAX(_config, batch_size, "batch", "1", "Number of links probed during one interval", 0, 1,
+    PROBING_MAX_BATCH),
+  CFG_MAP_INT32_MINMAX(_config, max_backoff, "max_backoff", "0",
+    "Maximum number of times the probing priority of a link is halved while its incoming"
+    " link metric does not change between two probes",
+    0, 0, 16),
 };
 
 static struct cfg_schema_section _probing_section = {
@@ -122,12 +174,75 @@ static struct cfg_schema_section _probing_section = {
   .entry_count = ARRAYSIZE(_probing_entries),
 };
 
+/*! template key for interface name */
+#define KEY_IF "if"
+
+/*! template key for IP address of link */
+#define KEY_LINK_BINDTO "link_bindto"
+
+/*! template key for MAC address of link */
+#define KEY_LINK_MAC "link_mac"
+
+/*! template key for number of probes sent over a link */
+#define KEY_LINK_PROBES "link_probes"
+
+/*! template key for number of probes skipped because of unicast traffic */
+#define KEY_LINK_TRAFFIC_SKIPS "link_traffic_skips"
+
+/*! template key for current probing backoff of link */
+#define KEY_LINK_BACKOFF "link_backoff"
+
+/*
+ * buffer space for values that will be assembled
+ * into the output of the telnet command
+ */
+static char _value_if[IF_NAMESIZE];
+static struct netaddr_str _value_link_bindto;
+static struct netaddr_str _value_link_mac;
+static struct isonumber_str _value_link_probes;
+static struct isonumber_str _value_link_traffic_skips;
+static char _value_link_backoff[3];
+
+/* definition of the template data entries for JSON and table output */
+static struct abuf_template_data_entry _tde_link[] = {
+  { KEY_IF, _value_if, true },
+  { KEY_LINK_BINDTO, _value_link_bindto.buf, true },
+  { KEY_LINK_MAC, _value_link_mac.buf, true },
+  { KEY_LINK_PROBES, _value_link_probes.buf, false },
+  { KEY_LINK_TRAFFIC_SKIPS, _value_link_traffic_skips.buf, false },
+  { KEY_LINK_BACKOFF, _value_link_backoff, false },
+};
+
+static struct abuf_template_storage _template_storage;
+
+/* Template Data objects (contain one or more Template Data Entries) */
+static struct abuf_template_data _td_link[] = {
+  { _tde_link, ARRAYSIZE(_tde_link) },
+};
+
+/* OONF viewer templates (based on Template Data arrays) */
+static struct oonf_viewer_template _templates[] = {
+  {
+    .data = _td_link,
+    .data_size = ARRAYSIZE(_td_link),
+    .json_name = "link",
+    .cb_function = _cb_create_text_link,
+  },
+};
+
+/* telnet command of this plugin */
+static struct oonf_telnet_command _telnet_commands[] = {
+  TELNET_CMD(OONF_NEIGHBOR_PROBING_SUBSYSTEM, _cb_probing, "", .help_handler = _cb_probing_help),
+};
+
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
   OONF_CLOCK_SUBSYSTEM,
   OONF_LAYER2_SUBSYSTEM,
   OONF_RFC5444_SUBSYSTEM,
+  OONF_TELNET_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
+  OONF_VIEWER_SUBSYSTEM,
   OONF_OS_INTERFACE_SUBSYSTEM,
   OONF_NHDP_SUBSYSTEM,
 };
@@ -206,6 +321,7 @@ _init(void) {
   }
 
   oonf_timer_add(&_probe_info);
+  oonf_telnet_add(&_telnet_commands[0]);
   return 0;
 }
 
@@ -214,6 +330,7 @@ _init(void) {
  */
 static void
 _cleanup(void) {
+  oonf_telnet_remove(&_telnet_commands[0]);
   rfc5444_writer_unregister_content_provider(&_protocol->writer, &_probing_msg_provider, NULL, 0);
   rfc5444_writer_unregister_message(&_protocol->writer, _probing_message);
   _protocol = NULL;
@@ -259,28 +376,31 @@ _check_if_type(struct oonf_layer2_net *net) {
 }
 
 /**
- * Callback for triggering a new neighbor probe
+ * Callback for triggering new neighbor probes. The links without unicast
+ * traffic that have not been checked for the longest time are probed.
+ * Links with a stable incoming link metric are probed less often.
  * @param ptr timer instance that fired
  */
 static void
 _cb_probe_link(struct oonf_timer_instance *ptr __attribute__((unused))) {
-  struct nhdp_link *lnk, *best_lnk;
-  struct _probing_link_data *ldata, *best_ldata;
+  struct _probe_candidate candidates[PROBING_MAX_BATCH];
+  struct nhdp_link *lnk;
+  struct _probing_link_data *ldata;
   struct nhdp_interface *nhdp_if;
 
   struct os_interface_listener *if_listener;
   struct oonf_layer2_net *l2net;
   struct oonf_layer2_neigh *l2neigh;
 
-  uint64_t points, best_points;
+  uint64_t points;
   uint64_t last_tx_packets;
+  size_t count, i;
 
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf;
 #endif
 
-  best_ldata = NULL;
-  best_points = 0;
+  count = 0;
 
   OONF_DEBUG(LOG_PROBING, "Start looking for probe candidate");
 
@@ -326,34 +446,129 @@ _cb_probe_link(struct oonf_timer_instance *ptr __attribute__((unused))) {
       if (last_tx_packets != ldata->last_tx_traffic) {
         /* advance timestamp */
         ldata->last_probe_check = oonf_clock_getNow();
+        ldata->traffic_skips++;
         OONF_DEBUG(LOG_PROBING, "Drop link %s (already has unicast traffic)", netaddr_to_string(&nbuf, &l2neigh->key.addr));
         continue;
       }
 
-      points = oonf_clock_getNow() - ldata->last_probe_check;
+      /* links with a stable metric are probed less often */
+      points = (oonf_clock_getNow() - ldata->last_probe_check) >> ldata->backoff;
+      if (ldata->backoff > 0 && points < _probe_config.interval) {
+        OONF_DEBUG(LOG_PROBING, "Drop link %s (backoff %u)", netaddr_to_string(&nbuf, &lnk->if_addr), ldata->backoff);
+        continue;
+      }
 
       OONF_DEBUG(LOG_PROBING, "Link %s has %" PRIu64 " points", netaddr_to_string(&nbuf, &lnk->if_addr), points);
 
-      if (points > best_points) {
-        best_points = points;
-        best_lnk = lnk;
-        best_ldata = ldata;
+      if (points > 0) {
+        _add_candidate(candidates, &count, _probe_config.batch_size, lnk, ldata, points);
       }
     }
   }
 
-  if (best_ldata != NULL) {
-    best_ldata->last_probe_check = oonf_clock_getNow();
+  for (i = 0; i < count; i++) {
+    _send_probe(&candidates[i]);
+  }
+}
 
-    if (best_ldata->target == NULL && netaddr_get_address_family(&best_lnk->if_addr) != AF_UNSPEC) {
-      best_ldata->target = oonf_rfc5444_add_target(best_lnk->local_if->rfc5444_if.interface, &best_lnk->if_addr);
+/**
+ * Add a link to the sorted array of probing candidates if it has
+ * a higher priority than the existing ones.
+ * @param candidates array of probing candidates, sorted by descending points
+ * @param count pointer to number of candidates in array
+ * @param max_count maximum number of candidates
+ * @param lnk nhdp link
+ * @param ldata probing extension of link
+ * @param points probing priority of link
+ */
+static void
+_add_candidate(struct _probe_candidate *candidates, size_t *count, size_t max_count,
+  struct nhdp_link *lnk, struct _probing_link_data *ldata, uint64_t points) {
+  size_t i;
+
+  i = *count;
+  if (i == max_count) {
+    if (candidates[i - 1].points >= points) {
+      /* array is full of better candidates */
+      return;
     }
+    i--;
+  }
+  else {
+    (*count)++;
+  }
+
+  /* move candidates with lower priority back */
+  while (i > 0 && candidates[i - 1].points < points) {
+    candidates[i] = candidates[i - 1];
+    i--;
+  }
 
-    if (best_ldata->target) {
-      OONF_DEBUG(LOG_PROBING, "Send probing to %s", netaddr_to_string(&nbuf, &best_ldata->target->dst));
+  candidates[i].lnk = lnk;
+  candidates[i].ldata = ldata;
+  candidates[i].points = points;
+}
 
-      oonf_rfc5444_send_if(best_ldata->target, RFC5444_MSGTYPE_PROBING);
+/**
+ * Check if the incoming link metric of all domains is unchanged since
+ * the last probe and remember the current metrics. The metrics contain
+ * the packet loss and the link speed measured by the metric plugins
+ * (e.g. ff_dat_metric) and are only modified by significant changes.
+ * @param lnk nhdp link
+ * @param ldata probing extension of link
+ * @return true if the link has a finite and stable metric in all domains
+ */
+static bool
+_has_stable_metric(struct nhdp_link *lnk, struct _probing_link_data *ldata) {
+  struct nhdp_link_domaindata *linkdata;
+  struct nhdp_domain *domain;
+  bool stable;
+
+  stable = true;
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    linkdata = nhdp_domain_get_linkdata(domain, lnk);
+    if (linkdata->metric.in >= RFC7181_METRIC_INFINITE || linkdata->metric.in != ldata->last_metric_in[domain->index]) {
+      stable = false;
     }
+    ldata->last_metric_in[domain->index] = linkdata->metric.in;
+  }
+  return stable;
+}
+
+/**
+ * Send a probe to a link and adapt the probing backoff of the link
+ * @param candidate probing candidate
+ */
+static void
+_send_probe(struct _probe_candidate *candidate) {
+  struct _probing_link_data *ldata;
+  struct nhdp_link *lnk;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  lnk = candidate->lnk;
+  ldata = candidate->ldata;
+
+  ldata->last_probe_check = oonf_clock_getNow();
+
+  /* a stable metric between two probes means the link needs less probing */
+  if (!_has_stable_metric(lnk, ldata)) {
+    ldata->backoff = 0;
+  }
+  else if (ldata->backoff < (uint32_t)_probe_config.max_backoff) {
+    ldata->backoff++;
+  }
+
+  if (ldata->target == NULL && netaddr_get_address_family(&lnk->if_addr) != AF_UNSPEC) {
+    ldata->target = oonf_rfc5444_add_target(lnk->local_if->rfc5444_if.interface, &lnk->if_addr);
+  }
+
+  if (ldata->target) {
+    OONF_DEBUG(LOG_PROBING, "Send probing to %s", netaddr_to_string(&nbuf, &ldata->target->dst));
+
+    oonf_rfc5444_send_if(ldata->target, RFC5444_MSGTYPE_PROBING);
+    ldata->probes++;
   }
 }
 
@@ -383,3 +598,51 @@ _cb_cfg_changed(void) {
 
   oonf_timer_set(&_probe_timer, _probe_config.interval);
 }
+
+/**
+ * Callback for the telnet command of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_probing(struct oonf_telnet_data *con) {
+  return oonf_viewer_telnet_handler(
+    con->out, &_template_storage, OONF_NEIGHBOR_PROBING_SUBSYSTEM, con->parameter, _templates, ARRAYSIZE(_templates));
+}
+
+/**
+ * Callback for the help output of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_probing_help(struct oonf_telnet_data *con) {
+  return oonf_viewer_telnet_help(
+    con->out, OONF_NEIGHBOR_PROBING_SUBSYSTEM, con->parameter, _templates, ARRAYSIZE(_templates));
+}
+
+/**
+ * Callback to generate text/json description of the probing statistics of all links
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_link(struct oonf_viewer_template *template) {
+  struct _probing_link_data *ldata;
+  struct nhdp_link *lnk;
+
+  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
+    ldata = oonf_class_get_extension(&_link_extenstion, lnk);
+
+    strscpy(_value_if, nhdp_interface_get_name(lnk->local_if), sizeof(_value_if));
+    netaddr_to_string(&_value_link_bindto, &lnk->if_addr);
+    netaddr_to_string(&_value_link_mac, &lnk->remote_mac);
+    isonumber_from_u64(&_value_link_probes, ldata->probes, "", 1, template->create_raw);
+    isonumber_from_u64(&_value_link_traffic_skips, ldata->traffic_skips, "", 1, template->create_raw);
+    snprintf(_value_link_backoff, sizeof(_value_link_backoff), "%u", ldata->backoff);
+
+    /* generate template output */
+    oonf_viewer_output_print_line(template);
+  }
+  return 0;
+}
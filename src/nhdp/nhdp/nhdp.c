@@ -71,6 +71,15 @@ struct _domain_parameters {
 
   /*! routing willingness */
   int32_t mpr_willingness;
+
+  /*! minimum relative change of an incoming metric (in 1/1000) */
+  int32_t metric_threshold_relative;
+
+  /*! minimum absolute change of an incoming metric */
+  int32_t metric_threshold_absolute;
+
+  /*! time after which any incoming metric change is applied */
+  uint64_t metric_refresh;
 };
 
 /**
@@ -82,6 +91,12 @@ struct _generic_parameters {
 
   /*! routing willingness */
   int32_t mpr_willingness;
+
+  /*! true if two-hop neighbors and lost addresses expire through a periodic sweep */
+  bool timer_free_expiry;
+
+  /*! interval of the expiry sweep */
+  uint64_t expiry_interval;
 };
 
 /* prototypes */
@@ -106,6 +121,11 @@ static struct cfg_schema_entry _nhdp_entries[] = {
     NHDP_DOMAIN_MPR_MAXLEN),
   CFG_MAP_INT32_MINMAX(_generic_parameters, mpr_willingness, "willingness", RFC7181_WILLINGNESS_DEFAULT_STRING,
     "Flooding willingness for MPR calculation", 0, RFC7181_WILLINGNESS_MIN, RFC7181_WILLINGNESS_MAX),
+  CFG_MAP_BOOL(_generic_parameters, timer_free_expiry, "timer_free_expiry", "false",
+    "Store absolute expiry times for two-hop neighbors and lost neighbor addresses and remove them"
+    " with a periodic sweep instead of restarting one timer per tuple for each HELLO"),
+  CFG_MAP_CLOCK_MIN(_generic_parameters, expiry_interval, "expiry_interval", "0.5",
+    "Interval of the sweep removing expired two-hop neighbors and lost neighbor addresses", 100),
 };
 
 static struct cfg_schema_section _nhdp_section = {
@@ -123,6 +143,11 @@ static struct cfg_schema_entry _interface_entries[] = {
     nhdp_interface, validity_time, "hello_validity", "20.0", "Validity time for NHDP Hello Messages", 100),
   CFG_MAP_CLOCK_MIN(
     nhdp_interface, hello_interval, "hello_interval", "2.0", "Time interval between two NHDP Hello Messages", 100),
+  CFG_MAP_BOOL(nhdp_interface, hello_cache, "hello_cache", "false",
+    "Cache the generated NHDP Hello Messages and only regenerate them if the NHDP database changed"),
+  CFG_MAP_CLOCK(nhdp_interface, hello_min_interval, "hello_min_interval", "0.0",
+    "Minimal time interval between a triggered NHDP Hello Message and the previous one,"
+    " 0 disables triggered Hello Messages"),
 };
 
 static struct cfg_schema_section _interface_section = {
@@ -148,6 +173,14 @@ static struct cfg_schema_entry _domain_entries[] = {
     NHDP_DOMAIN_MPR_MAXLEN),
   CFG_MAP_INT32_MINMAX(_domain_parameters, mpr_willingness, "willingness", RFC7181_WILLINGNESS_DEFAULT_STRING,
     "Routing willingness used for MPR calculation", 0, RFC7181_WILLINGNESS_MIN, RFC7181_WILLINGNESS_MAX),
+  CFG_MAP_INT32_MINMAX(_domain_parameters, metric_threshold_relative, "metric_threshold_relative", "0",
+    "Minimum relative change (in percent) of an incoming link metric before it is used, 0 to disable",
+    1, 0, 1000),
+  CFG_MAP_INT32_MINMAX(_domain_parameters, metric_threshold_absolute, "metric_threshold_absolute", "0",
+    "Minimum absolute change of an incoming link metric before it is used, 0 to disable",
+    0, 0, RFC7181_METRIC_MAX),
+  CFG_MAP_CLOCK(_domain_parameters, metric_refresh, "metric_refresh", "0",
+    "Time after the last change of an incoming link metric when any new value is used, 0 to disable"),
 };
 
 static struct cfg_schema_section _domain_section = {
@@ -256,6 +289,9 @@ nhdp_set_originator(const struct netaddr *addr) {
   else if (netaddr_get_address_family(addr) == AF_INET6) {
     memcpy(&_originator_v6, addr, sizeof(*addr));
   }
+
+  /* originator is part of the HELLO */
+  nhdp_db_increase_generation();
 }
 
 /**
@@ -271,6 +307,9 @@ nhdp_reset_originator(int af_type) {
   else if (af_type == AF_INET6) {
     netaddr_invalidate(&_originator_v6);
   }
+
+  /* originator is part of the HELLO */
+  nhdp_db_increase_generation();
 }
 
 /**
@@ -369,6 +408,7 @@ _forwarding_selector(struct rfc5444_writer_target *rfc5444_target) {
 static void
 _cb_cfg_domain_changed(void) {
   struct _domain_parameters param;
+  struct nhdp_domain *domain;
   int ext;
 
   OONF_INFO(LOG_NHDP, "Received domain cfg change for name '%s': %s %s", _domain_section.section_name,
@@ -381,7 +421,11 @@ _cb_cfg_domain_changed(void) {
     return;
   }
 
-  nhdp_domain_configure(ext, param.metric_name, param.mpr_name, param.mpr_willingness);
+  domain = nhdp_domain_configure(ext, param.metric_name, param.mpr_name, param.mpr_willingness);
+  if (domain) {
+    nhdp_domain_set_metric_hysteresis(
+      domain, param.metric_threshold_relative, param.metric_threshold_absolute, param.metric_refresh);
+  }
 }
 
 /**
@@ -444,6 +488,7 @@ _cb_cfg_nhdp_changed(void) {
   }
 
   nhdp_domain_set_flooding_mpr(param.flooding_mpr_name, param.mpr_willingness);
+  nhdp_db_set_timer_free_expiry(param.timer_free_expiry, param.expiry_interval);
 }
 
 /**
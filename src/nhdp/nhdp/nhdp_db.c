@@ -45,6 +45,7 @@
 
 #include <oonf/libcommon/avl.h>
 #include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
 #include <oonf/oonf.h>
 #include <oonf/libcommon/list.h>
 #include <oonf/libcommon/netaddr.h>
@@ -63,12 +64,16 @@
 static void _link_status_now_symmetric(struct nhdp_link *lnk);
 static void _link_status_not_symmetric_anymore(struct nhdp_link *lnk);
 int _nhdp_db_link_calculate_status(struct nhdp_link *lnk);
+static void _neighbor_changed(struct nhdp_neighbor *neigh);
+static void _fire_neighbor_changed(struct nhdp_neighbor *neigh);
+static void _link_changed(struct nhdp_link *lnk);
 
 static void _cb_link_vtime(struct oonf_timer_instance *);
 static void _cb_link_heard(struct oonf_timer_instance *);
 static void _cb_link_symtime(struct oonf_timer_instance *);
 static void _cb_l2hop_vtime(struct oonf_timer_instance *);
 static void _cb_naddr_vtime(struct oonf_timer_instance *);
+static void _cb_expiry_sweep(struct oonf_timer_instance *);
 
 /* Link status names */
 static const char *_LINK_PENDING = "pending";
@@ -127,9 +132,26 @@ static struct oonf_timer_class _l2hop_vtime_info = {
   .callback = _cb_l2hop_vtime,
 };
 
+static struct oonf_timer_class _expiry_sweep_info = {
+  .name = "NHDP tuple expiry sweep",
+  .callback = _cb_expiry_sweep,
+  .periodic = true,
+};
+
+/* periodic sweep over two-hop neighbors and lost neighbor addresses */
+static struct oonf_timer_instance _expiry_sweep = {
+  .class = &_expiry_sweep_info,
+};
+
+/* true if two-hop neighbors and lost neighbor addresses expire without timers */
+static bool _timer_free_expiry = false;
+
 /* global tree of neighbor addresses */
 static struct avl_tree _naddr_tree;
 
+/* global hash index of neighbor addresses */
+static struct hashmap _naddr_index;
+
 /* list of neighbors */
 static struct list_entity _neigh_list;
 
@@ -142,15 +164,28 @@ static struct list_entity _link_list;
 /* id that will be increased every times the symmetric neighbor set changes */
 static uint32_t _neighbor_set_id = 0;
 
+/* generation counter that will be increased every time the content of a HELLO changes */
+static uint32_t _generation = 0;
+
+/* nesting level of database transactions */
+static uint32_t _transaction_level = 0;
+
+/* neighbors and links with pending changes during a transaction */
+static struct list_entity _pending_neighbors;
+static struct list_entity _pending_links;
+
 /**
  * Initialize NHDP databases
  */
 void
 nhdp_db_init(void) {
   avl_init(&_naddr_tree, avl_comp_netaddr, false);
+  hashmap_init(&_naddr_index, hashmap_hash_netaddr, avl_comp_netaddr);
   list_init_head(&_neigh_list);
   avl_init(&_neigh_originator_tree, avl_comp_netaddr, false);
   list_init_head(&_link_list);
+  list_init_head(&_pending_neighbors);
+  list_init_head(&_pending_links);
 
   oonf_class_add(&_neigh_info);
   oonf_class_add(&_naddr_info);
@@ -163,6 +198,7 @@ nhdp_db_init(void) {
   oonf_timer_add(&_link_heard_info);
   oonf_timer_add(&_link_symtime_info);
   oonf_timer_add(&_l2hop_vtime_info);
+  oonf_timer_add(&_expiry_sweep_info);
 }
 
 /**
@@ -176,8 +212,11 @@ nhdp_db_cleanup(void) {
   list_for_each_element_safe(&_neigh_list, neigh, _global_node, n_it) {
     nhdp_db_neighbor_remove(neigh);
   }
+  hashmap_free(&_naddr_index);
 
   /* cleanup all timers */
+  oonf_timer_stop(&_expiry_sweep);
+  oonf_timer_remove(&_expiry_sweep_info);
   oonf_timer_remove(&_l2hop_vtime_info);
   oonf_timer_remove(&_link_symtime_info);
   oonf_timer_remove(&_link_heard_info);
@@ -205,6 +244,12 @@ nhdp_db_neighbor_add(void) {
     return NULL;
   }
 
+  /* initialize domain data */
+  if (nhdp_domain_init_neighbor(neigh)) {
+    oonf_class_free(&_neigh_info, neigh);
+    return NULL;
+  }
+
   OONF_DEBUG(LOG_NHDP, "New Neighbor: 0x%0zx", (size_t)neigh);
 
   /* initialize trees and lists */
@@ -218,9 +263,6 @@ nhdp_db_neighbor_add(void) {
   /* initialize originator node */
   neigh->_originator_node.key = &neigh->originator;
 
-  /* initialize domain data */
-  nhdp_domain_init_neighbor(neigh);
-
   /* trigger event */
   oonf_class_event(&_neigh_info, neigh, OONF_OBJECT_ADDED);
   return neigh;
@@ -246,6 +288,11 @@ nhdp_db_neighbor_remove(struct nhdp_neighbor *neigh) {
   /* trigger event */
   oonf_class_event(&_neigh_info, neigh, OONF_OBJECT_REMOVED);
 
+  /* drop pending changes of transaction */
+  if (list_is_node_added(&neigh->_pending_node)) {
+    list_remove(&neigh->_pending_node);
+  }
+
   /* disconnect from other IP version */
   nhdp_db_neigbor_disconnect_dualstack(neigh);
 
@@ -281,6 +328,7 @@ nhdp_db_neighbor_remove(struct nhdp_neighbor *neigh) {
 
   /* remove from global list and free memory */
   list_remove(&neigh->_global_node);
+  nhdp_domain_cleanup_neighbor(neigh);
   oonf_class_free(&_neigh_info, neigh);
 }
 
@@ -297,7 +345,7 @@ nhdp_db_neighbor_set_unsymmetric(struct nhdp_neighbor *neigh) {
   }
 
   /* trigger event */
-  oonf_class_event(&_neigh_info, neigh, OONF_OBJECT_CHANGED);
+  _neighbor_changed(neigh);
 }
 
 /**
@@ -371,6 +419,7 @@ nhdp_db_neighbor_addr_add(struct nhdp_neighbor *neigh, const struct netaddr *add
   memcpy(&naddr->neigh_addr, addr, sizeof(naddr->neigh_addr));
   naddr->_neigh_node.key = &naddr->neigh_addr;
   naddr->_global_node.key = &naddr->neigh_addr;
+  naddr->_global_index_node.key = &naddr->neigh_addr;
 
   /* initialize backward link */
   naddr->neigh = neigh;
@@ -378,9 +427,17 @@ nhdp_db_neighbor_addr_add(struct nhdp_neighbor *neigh, const struct netaddr *add
   /* initialize timer for lost addresses */
   naddr->_lost_vtime.class = &_naddr_vtime_info;
 
+  /* add to index first, it is the only insert that can fail */
+  if (hashmap_insert(&_naddr_index, &naddr->_global_index_node)) {
+    OONF_WARN(LOG_NHDP, "Could not add neighbor address to index");
+    oonf_class_free(&_naddr_info, naddr);
+    return NULL;
+  }
+
   /* add to trees */
   avl_insert(&_naddr_tree, &naddr->_global_node);
   avl_insert(&neigh->_neigh_addresses, &naddr->_neigh_node);
+  _generation++;
 
   /* trigger event */
   oonf_class_event(&_naddr_info, naddr, OONF_OBJECT_ADDED);
@@ -399,7 +456,9 @@ nhdp_db_neighbor_addr_remove(struct nhdp_naddr *naddr) {
 
   /* remove from trees */
   avl_remove(&_naddr_tree, &naddr->_global_node);
+  hashmap_remove(&_naddr_index, &naddr->_global_index_node);
   avl_remove(&naddr->neigh->_neigh_addresses, &naddr->_neigh_node);
+  _generation++;
 
   /* stop timer */
   oonf_timer_stop(&naddr->_lost_vtime);
@@ -408,6 +467,39 @@ nhdp_db_neighbor_addr_remove(struct nhdp_naddr *naddr) {
   oonf_class_free(&_naddr_info, naddr);
 }
 
+/**
+ * Define a neighbor address as lost
+ * @param naddr nhdp neighbor address
+ * @param vtime time until lost address gets purged from the database
+ */
+void
+nhdp_db_neighbor_addr_set_lost(struct nhdp_naddr *naddr, uint64_t vtime) {
+  if (!nhdp_db_neighbor_addr_is_lost(naddr)) {
+    _generation++;
+  }
+
+  if (_timer_free_expiry) {
+    naddr->_lost_expire = oonf_clock_get_absolute(vtime);
+  }
+  else {
+    oonf_timer_set(&naddr->_lost_vtime, vtime);
+  }
+}
+
+/**
+ * Define a neighbor address as not lost anymore
+ * @param naddr nhdp neighbor address
+ */
+void
+nhdp_db_neighbor_addr_not_lost(struct nhdp_naddr *naddr) {
+  if (nhdp_db_neighbor_addr_is_lost(naddr)) {
+    _generation++;
+  }
+
+  naddr->_lost_expire = 0;
+  oonf_timer_stop(&naddr->_lost_vtime);
+}
+
 /**
  * Moves a nhdp neighbor address to a different neighbor
  * @param neigh nhdp neighbor
@@ -423,6 +515,10 @@ nhdp_db_neighbor_addr_move(struct nhdp_neighbor *neigh, struct nhdp_naddr *naddr
 
   /* set new backlink */
   naddr->neigh = neigh;
+  _generation++;
+
+  /* trigger event */
+  oonf_class_event(&_naddr_info, naddr, OONF_OBJECT_CHANGED);
 }
 
 /**
@@ -477,10 +573,7 @@ nhdp_db_neighbor_set_originator(struct nhdp_neighbor *neigh, const struct netadd
   }
 
   /* inform everyone */
-  oonf_class_event(&_neigh_info, neigh, OONF_OBJECT_CHANGED);
-
-  /* overwrite "old originator" */
-  memcpy(&neigh->_old_originator, originator, sizeof(*originator));
+  _neighbor_changed(neigh);
 }
 
 /**
@@ -522,6 +615,154 @@ nhdp_db_neighbor_get_set_id(void) {
   return _neighbor_set_id;
 }
 
+/**
+ * @return generation counter of the NHDP database, will be increased
+ *   for every change of addresses and link status that is visible in
+ *   a HELLO message.
+ */
+uint32_t
+nhdp_db_get_generation(void) {
+  return _generation;
+}
+
+/**
+ * Increase generation counter of the NHDP database to signal a change
+ * outside of the database that is visible in a HELLO message.
+ */
+void
+nhdp_db_increase_generation(void) {
+  _generation++;
+}
+
+/**
+ * Start a transaction of database changes. Change events of links and
+ * neighbors and metric recalculations will be delayed and coalesced until
+ * the transaction is committed. Added and removed events are still
+ * triggered immediately. Transactions can be nested.
+ */
+void
+nhdp_db_transaction_start(void) {
+  _transaction_level++;
+}
+
+/**
+ * Commit a transaction of database changes. The outermost commit
+ * recalculates the metrics of all modified neighbors, informs the domain
+ * listeners once about the result and triggers a single change event
+ * for each modified link and neighbor.
+ */
+void
+nhdp_db_transaction_commit(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+  struct nhdp_link *lnk;
+  bool metric_pending, metric_changed;
+
+  if (_transaction_level == 0 || --_transaction_level > 0) {
+    return;
+  }
+
+  /* recalculate metrics first, change listeners might use them */
+  metric_pending = false;
+  metric_changed = false;
+  list_for_each_element_safe(&_pending_neighbors, neigh, _pending_node, n_it) {
+    if (neigh->_metric_pending) {
+      neigh->_metric_pending = false;
+      metric_pending = true;
+      metric_changed |= nhdp_domain_recalculate_neighbor_metrics(neigh);
+    }
+  }
+  if (metric_pending) {
+    /* a single notification for all recalculated neighbors */
+    nhdp_domain_trigger_metric_update(NULL, metric_changed);
+  }
+
+  /* listeners might modify the database, so always take the first pending object */
+  while (!list_is_empty(&_pending_links)) {
+    lnk = list_first_element(&_pending_links, lnk, _pending_node);
+    list_remove(&lnk->_pending_node);
+
+    oonf_class_event(&_link_info, lnk, OONF_OBJECT_CHANGED);
+  }
+
+  while (!list_is_empty(&_pending_neighbors)) {
+    neigh = list_first_element(&_pending_neighbors, neigh, _pending_node);
+    list_remove(&neigh->_pending_node);
+
+    if (neigh->_change_pending) {
+      neigh->_change_pending = false;
+      _fire_neighbor_changed(neigh);
+    }
+  }
+}
+
+/**
+ * Switch the expiry of two-hop neighbors and lost neighbor addresses
+ * between one timer per tuple and a periodic sweep over absolute
+ * expiry timestamps. Existing tuples are converted to the new mode.
+ * @param enable true to use the periodic sweep
+ * @param interval time between two sweeps in milliseconds
+ */
+void
+nhdp_db_set_timer_free_expiry(bool enable, uint64_t interval) {
+  struct nhdp_link *lnk;
+  struct nhdp_l2hop *l2hop;
+  struct nhdp_naddr *naddr;
+  int64_t remaining;
+
+  if (enable != _timer_free_expiry) {
+    list_for_each_element(&_link_list, lnk, _global_node) {
+      avl_for_each_element(&lnk->_2hop, l2hop, _link_node) {
+        if (enable && oonf_timer_is_active(&l2hop->_vtime)) {
+          l2hop->_vtime_expire = oonf_clock_get_absolute(oonf_timer_get_due(&l2hop->_vtime));
+          oonf_timer_stop(&l2hop->_vtime);
+        }
+        else if (!enable && l2hop->_vtime_expire) {
+          remaining = nhdp_db_link_2hop_get_vtime(l2hop);
+          oonf_timer_set(&l2hop->_vtime, remaining > 0 ? remaining : 1);
+          l2hop->_vtime_expire = 0;
+        }
+      }
+    }
+    avl_for_each_element(&_naddr_tree, naddr, _global_node) {
+      if (enable && oonf_timer_is_active(&naddr->_lost_vtime)) {
+        naddr->_lost_expire = oonf_clock_get_absolute(oonf_timer_get_due(&naddr->_lost_vtime));
+        oonf_timer_stop(&naddr->_lost_vtime);
+      }
+      else if (!enable && naddr->_lost_expire) {
+        remaining = nhdp_db_neighbor_addr_get_lost_vtime(naddr);
+        oonf_timer_set(&naddr->_lost_vtime, remaining > 0 ? remaining : 1);
+        naddr->_lost_expire = 0;
+      }
+    }
+    _timer_free_expiry = enable;
+  }
+
+  if (enable) {
+    oonf_timer_set(&_expiry_sweep, interval);
+  }
+  else {
+    oonf_timer_stop(&_expiry_sweep);
+  }
+}
+
+/**
+ * Recalculate the metrics of a neighbor, this will be delayed until the
+ * end of a running transaction.
+ * @param neigh nhdp neighbor
+ */
+void
+nhdp_db_neighbor_update_metrics(struct nhdp_neighbor *neigh) {
+  if (_transaction_level == 0) {
+    nhdp_domain_recalculate_metrics(NULL, neigh);
+    return;
+  }
+
+  neigh->_metric_pending = true;
+  if (!list_is_node_added(&neigh->_pending_node)) {
+    list_add_tail(&_pending_neighbors, &neigh->_pending_node);
+  }
+}
+
 /**
  * Insert a new link into a nhdp neighbors database
  * @param neigh neighbor which will get the new link
@@ -537,6 +778,12 @@ nhdp_db_link_add(struct nhdp_neighbor *neigh, struct nhdp_interface *local_if) {
     return NULL;
   }
 
+  /* initialize link domain data */
+  if (nhdp_domain_init_link(lnk)) {
+    oonf_class_free(&_link_info, lnk);
+    return NULL;
+  }
+
   /* hook into interface */
   nhdp_interface_add_link(local_if, lnk);
 
@@ -550,6 +797,7 @@ nhdp_db_link_add(struct nhdp_neighbor *neigh, struct nhdp_interface *local_if) {
   /* init local trees */
   avl_init(&lnk->_addresses, avl_comp_netaddr, false);
   avl_init(&lnk->_2hop, avl_comp_netaddr, false);
+  hashmap_init(&lnk->_2hop_index, hashmap_hash_netaddr, avl_comp_netaddr);
 
   /* init timers */
   lnk->sym_time.class = &_link_symtime_info;
@@ -564,9 +812,6 @@ nhdp_db_link_add(struct nhdp_neighbor *neigh, struct nhdp_interface *local_if) {
 
   lnk->last_status_change = oonf_clock_getNow();
 
-  /* initialize link domain data */
-  nhdp_domain_init_link(lnk);
-
   /* trigger event */
   oonf_class_event(&_link_info, lnk, OONF_OBJECT_ADDED);
 
@@ -597,7 +842,7 @@ nhdp_db_link_set_unsymmetric(struct nhdp_link *lnk) {
   lnk->last_status_change = oonf_clock_getNow();
 
   /* trigger event */
-  oonf_class_event(&_link_info, lnk, OONF_OBJECT_CHANGED);
+  _link_changed(lnk);
 }
 
 /**
@@ -612,6 +857,11 @@ nhdp_db_link_remove(struct nhdp_link *lnk) {
   /* trigger event */
   oonf_class_event(&_link_info, lnk, OONF_OBJECT_REMOVED);
 
+  /* drop pending changes of transaction */
+  if (list_is_node_added(&lnk->_pending_node)) {
+    list_remove(&lnk->_pending_node);
+  }
+
   oonf_timer_stop(&lnk->sym_time);
   oonf_timer_stop(&lnk->heard_time);
   oonf_timer_stop(&lnk->vtime);
@@ -643,6 +893,8 @@ nhdp_db_link_remove(struct nhdp_link *lnk) {
   list_remove(&lnk->_global_node);
 
   /* free memory */
+  hashmap_free(&lnk->_2hop_index);
+  nhdp_domain_cleanup_link(lnk);
   oonf_class_free(&_link_info, lnk);
 }
 
@@ -670,10 +922,17 @@ nhdp_db_link_addr_add(struct nhdp_link *lnk, const struct netaddr *addr) {
   /* initialize back link */
   laddr->link = lnk;
 
+  /* add to interface index first, it is the only insert that can fail */
+  if (nhdp_interface_add_laddr(laddr)) {
+    OONF_WARN(LOG_NHDP, "Could not add link address to interface index");
+    oonf_class_free(&_laddr_info, laddr);
+    return NULL;
+  }
+
   /* add to trees */
   avl_insert(&lnk->_addresses, &laddr->_link_node);
   avl_insert(&lnk->neigh->_link_addresses, &laddr->_neigh_node);
-  nhdp_interface_add_laddr(laddr);
+  _generation++;
 
   /* trigger event */
   oonf_class_event(&_laddr_info, laddr, OONF_OBJECT_ADDED);
@@ -694,6 +953,7 @@ nhdp_db_link_addr_remove(struct nhdp_laddr *laddr) {
   nhdp_interface_remove_laddr(laddr);
   avl_remove(&laddr->link->_addresses, &laddr->_link_node);
   avl_remove(&laddr->link->neigh->_link_addresses, &laddr->_neigh_node);
+  _generation++;
 
   /* free memory */
   oonf_class_free(&_laddr_info, laddr);
@@ -721,6 +981,7 @@ nhdp_db_link_addr_move(struct nhdp_link *lnk, struct nhdp_laddr *laddr) {
   }
   /* set new backlink */
   laddr->link = lnk;
+  _generation++;
 }
 
 /**
@@ -738,9 +999,16 @@ nhdp_db_link_2hop_add(struct nhdp_link *lnk, const struct netaddr *addr) {
     return NULL;
   }
 
+  /* initialize metrics */
+  if (nhdp_domain_init_l2hop(l2hop)) {
+    oonf_class_free(&_l2hop_info, l2hop);
+    return NULL;
+  }
+
   /* initialize key */
   memcpy(&l2hop->twohop_addr, addr, sizeof(l2hop->twohop_addr));
   l2hop->_link_node.key = &l2hop->twohop_addr;
+  l2hop->_link_index_node.key = &l2hop->twohop_addr;
 
   /* initialize back link */
   l2hop->link = lnk;
@@ -748,15 +1016,18 @@ nhdp_db_link_2hop_add(struct nhdp_link *lnk, const struct netaddr *addr) {
   /* initialize validity timer */
   l2hop->_vtime.class = &_l2hop_vtime_info;
 
-  /* add to link tree */
+  /* add to link index and tree */
+  if (hashmap_insert(&lnk->_2hop_index, &l2hop->_link_index_node)) {
+    OONF_WARN(LOG_NHDP, "Could not add two-hop address to link index");
+    nhdp_domain_cleanup_l2hop(l2hop);
+    oonf_class_free(&_l2hop_info, l2hop);
+    return NULL;
+  }
   avl_insert(&lnk->_2hop, &l2hop->_link_node);
 
   /* add to interface tree */
   nhdp_interface_add_l2hop(lnk->local_if, l2hop);
 
-  /* initialize metrics */
-  nhdp_domain_init_l2hop(l2hop);
-
   /* trigger event */
   oonf_class_event(&_l2hop_info, l2hop, OONF_OBJECT_ADDED);
 
@@ -772,8 +1043,9 @@ nhdp_db_link_2hop_remove(struct nhdp_l2hop *l2hop) {
   /* trigger event */
   oonf_class_event(&_l2hop_info, l2hop, OONF_OBJECT_REMOVED);
 
-  /* remove from link tree */
+  /* remove from link tree and index */
   avl_remove(&l2hop->link->_2hop, &l2hop->_link_node);
+  hashmap_remove(&l2hop->link->_2hop_index, &l2hop->_link_index_node);
 
   /* remove from interface tree */
   nhdp_interface_remove_l2hop(l2hop);
@@ -782,9 +1054,35 @@ nhdp_db_link_2hop_remove(struct nhdp_l2hop *l2hop) {
   oonf_timer_stop(&l2hop->_vtime);
 
   /* free memory */
+  nhdp_domain_cleanup_l2hop(l2hop);
   oonf_class_free(&_l2hop_info, l2hop);
 }
 
+/**
+ * Set the validity time of a two-hop neighbor
+ * @param l2hop nhdp link two-hop neighbor
+ * @param vtime new validity time
+ */
+void
+nhdp_db_link_2hop_set_vtime(struct nhdp_l2hop *l2hop, uint64_t vtime) {
+  if (_timer_free_expiry) {
+    l2hop->_vtime_expire = oonf_clock_get_absolute(vtime);
+  }
+  else {
+    oonf_timer_set(&l2hop->_vtime, vtime);
+  }
+}
+
+/**
+ * Trigger a change event for a two-hop address after
+ * its metric has been updated
+ * @param l2hop nhdp two-hop link address
+ */
+void
+nhdp_db_link_2hop_changed(struct nhdp_l2hop *l2hop) {
+  oonf_class_event(&_l2hop_info, l2hop, OONF_OBJECT_CHANGED);
+}
+
 /**
  * Connect two links as representations of the same node,
  * @param l_ipv4 ipv4 link
@@ -848,11 +1146,15 @@ nhdp_db_link_update_status(struct nhdp_link *lnk) {
   if (old_status != lnk->status) {
     /* link status was changed */
     lnk->last_status_change = oonf_clock_getNow();
-    nhdp_domain_recalculate_metrics(NULL, lnk->neigh);
+    _generation++;
+    nhdp_db_neighbor_update_metrics(lnk->neigh);
     nhdp_domain_delayed_mpr_recalculation(NULL, lnk->neigh);
 
+    /* tell the neighbor early about the new link status */
+    nhdp_interface_trigger_hello(lnk->local_if);
+
     /* trigger change event */
-    oonf_class_event(&_link_info, lnk, OONF_OBJECT_CHANGED);
+    _link_changed(lnk);
   }
 }
 
@@ -901,6 +1203,15 @@ nhdp_db_get_naddr_tree(void) {
   return &_naddr_tree;
 }
 
+/**
+ * get global hash index of nhdp neighbor addresses
+ * @return neighbor address index
+ */
+struct hashmap *
+nhdp_db_get_naddr_index(void) {
+  return &_naddr_index;
+}
+
 /**
  * get global tree of nhdp originators
  * @return originator tree
@@ -969,6 +1280,7 @@ _link_status_now_symmetric(struct nhdp_link *lnk) {
       nhdp_db_neighbor_addr_not_lost(naddr);
     }
     _neighbor_set_id++;
+    _generation++;
   }
 }
 
@@ -994,6 +1306,52 @@ _link_status_not_symmetric_anymore(struct nhdp_link *lnk) {
     }
 
     _neighbor_set_id++;
+    _generation++;
+  }
+}
+
+/**
+ * Trigger a change event for a neighbor or remember it
+ * until the end of the running transaction
+ * @param neigh nhdp neighbor
+ */
+static void
+_neighbor_changed(struct nhdp_neighbor *neigh) {
+  if (_transaction_level == 0) {
+    _fire_neighbor_changed(neigh);
+    return;
+  }
+
+  neigh->_change_pending = true;
+  if (!list_is_node_added(&neigh->_pending_node)) {
+    list_add_tail(&_pending_neighbors, &neigh->_pending_node);
+  }
+}
+
+/**
+ * Trigger a change event for a neighbor
+ * @param neigh nhdp neighbor
+ */
+static void
+_fire_neighbor_changed(struct nhdp_neighbor *neigh) {
+  oonf_class_event(&_neigh_info, neigh, OONF_OBJECT_CHANGED);
+
+  /* overwrite "old originator" */
+  memcpy(&neigh->_old_originator, &neigh->originator, sizeof(neigh->originator));
+}
+
+/**
+ * Trigger a change event for a link or remember it
+ * until the end of the running transaction
+ * @param lnk nhdp link
+ */
+static void
+_link_changed(struct nhdp_link *lnk) {
+  if (_transaction_level == 0) {
+    oonf_class_event(&_link_info, lnk, OONF_OBJECT_CHANGED);
+  }
+  else if (!list_is_node_added(&lnk->_pending_node)) {
+    list_add_tail(&_pending_links, &lnk->_pending_node);
   }
 }
 
@@ -1077,3 +1435,35 @@ _cb_l2hop_vtime(struct oonf_timer_instance *ptr) {
   OONF_DEBUG(LOG_NHDP, "2Hop vtime fired: 0x%0zx", (size_t)ptr);
   nhdp_db_link_2hop_remove(l2hop);
 }
+
+/**
+ * Callback for periodic sweep over the expiry timestamps of
+ * two-hop neighbors and lost neighbor addresses
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_expiry_sweep(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  struct nhdp_link *lnk;
+  struct nhdp_l2hop *l2hop, *l2_it;
+  struct nhdp_naddr *naddr, *na_it;
+
+  nhdp_db_transaction_start();
+
+  list_for_each_element(&_link_list, lnk, _global_node) {
+    avl_for_each_element_safe(&lnk->_2hop, l2hop, _link_node, l2_it) {
+      if (l2hop->_vtime_expire && oonf_clock_is_past(l2hop->_vtime_expire)) {
+        OONF_DEBUG(LOG_NHDP, "2Hop expired: 0x%0zx", (size_t)l2hop);
+        nhdp_db_link_2hop_remove(l2hop);
+      }
+    }
+  }
+
+  avl_for_each_element_safe(&_naddr_tree, naddr, _global_node, na_it) {
+    if (naddr->_lost_expire && oonf_clock_is_past(naddr->_lost_expire)) {
+      OONF_DEBUG(LOG_NHDP, "Neighbor Address Lost expired: 0x%0zx", (size_t)naddr);
+      nhdp_db_neighbor_addr_remove(naddr);
+    }
+  }
+
+  nhdp_db_transaction_commit();
+}
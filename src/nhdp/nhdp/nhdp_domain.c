@@ -44,6 +44,8 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <oonf/libcommon/avl.h>
 #include <oonf/libcommon/avl_comp.h>
@@ -66,10 +68,22 @@ static void _remove_metric(struct nhdp_domain *);
 static void _apply_mpr(struct nhdp_domain *domain, const char *mpr_name, uint8_t willingness);
 static void _remove_mpr(struct nhdp_domain *);
 
+static int _alloc_slot(enum nhdp_domain_data_type type, uint32_t *slot);
+static void _free_slot(enum nhdp_domain_data_type type, uint32_t slot);
+static int _add_page(enum nhdp_domain_data_type type);
+static int _init_storage(struct nhdp_domain_storage *storage);
+static void _free_storage(struct nhdp_domain_storage *storage);
+static void *_alloc_page(enum nhdp_domain_data_type type);
+static void _reset_linkdata(void *ptr);
+static void _reset_neighbordata(void *ptr);
+static void _reset_l2hopdata(void *ptr);
+
 static void _cb_update_everyone_routing_mpr(struct nhdp_domain *domain);
 static void _cb_update_everyone_flooding_mpr(struct nhdp_domain *domain);
 
 static bool _recalculate_neighbor_metric(struct nhdp_domain *domain, struct nhdp_neighbor *neigh);
+static bool _is_significant_metric_change(
+  struct nhdp_domain *domain, struct nhdp_link_domaindata *linkdata, uint32_t new_metric);
 static bool _recalculate_routing_mpr_set(struct nhdp_domain *domain);
 static bool _recalculate_flooding_mpr_set(void);
 
@@ -127,6 +141,58 @@ static struct oonf_rfc5444_protocol *_protocol;
 /* remember if node is MPR or not */
 static bool _node_is_selected_as_mpr = false;
 
+/* generation counter that will be increased every time a metric, MPR or willingness changes */
+static uint32_t _generation = 0;
+
+/**
+ * Slot allocator for the per-domain data of one type of NHDP objects
+ */
+struct _domain_slots {
+  /*! size of a single domain data entry */
+  size_t entry_size;
+
+  /*! callback to reset a domain data entry to its default values */
+  void (*reset)(void *entry);
+
+  /*! array of unused slots, has space for all slots of the allocated pages */
+  uint32_t *free_slots;
+
+  /*! number of unused slots in array */
+  uint32_t free_count;
+
+  /*! next slot that has never been used */
+  uint32_t next_slot;
+
+  /*! number of allocated storage pages */
+  uint32_t page_count;
+};
+
+/* slot allocators for the per-domain data of links, neighbors and twohop neighbors */
+static struct _domain_slots _slots[NHDP_DOMAIN_DATA_COUNT] = {
+  [NHDP_DOMAIN_DATA_LINK] =
+    {
+      .entry_size = sizeof(struct nhdp_link_domaindata),
+      .reset = _reset_linkdata,
+    },
+  [NHDP_DOMAIN_DATA_NEIGHBOR] =
+    {
+      .entry_size = sizeof(struct nhdp_neighbor_domaindata),
+      .reset = _reset_neighbordata,
+    },
+  [NHDP_DOMAIN_DATA_L2HOP] =
+    {
+      .entry_size = sizeof(struct nhdp_l2hop_domaindata),
+      .reset = _reset_l2hopdata,
+    },
+};
+
+/*
+ * storage of per-domain data, one for each domain index. The flooding domain
+ * shares the storage of index 0, so the first one is always allocated.
+ */
+static struct nhdp_domain_storage _storage[NHDP_MAXIMUM_DOMAINS];
+static size_t _storage_count = 1;
+
 /**
  * Initialize nhdp metric core
  * @param p pointer to rfc5444 protocol
@@ -144,6 +210,7 @@ nhdp_domain_init(struct oonf_rfc5444_protocol *p) {
   avl_init(&_domain_mprs, avl_comp_strcasecmp, false);
 
   /* initialize flooding domain */
+  _flooding_domain._storage = &_storage[0];
   _flooding_domain.metric = &_no_metric;
   _flooding_domain.mpr = &_everyone_mprs;
 
@@ -179,6 +246,20 @@ nhdp_domain_cleanup(void) {
     nhdp_domain_listener_remove(listener);
   }
   oonf_class_remove(&_domain_class);
+
+  /* free per-domain data storage */
+  for (i = 0; i < (int)_storage_count; i++) {
+    _free_storage(&_storage[i]);
+  }
+  _storage_count = 1;
+
+  for (i = 0; i < NHDP_DOMAIN_DATA_COUNT; i++) {
+    free(_slots[i].free_slots);
+    _slots[i].free_slots = NULL;
+    _slots[i].free_count = 0;
+    _slots[i].next_slot = 0;
+    _slots[i].page_count = 0;
+  }
 }
 
 /**
@@ -343,12 +424,16 @@ nhdp_domain_get_by_ext(uint8_t ext) {
 /**
  * Initialize the domain data of a new NHDP link
  * @param lnk NHDP link
+ * @return -1 if out of memory, 0 otherwise
  */
-void
+int
 nhdp_domain_init_link(struct nhdp_link *lnk) {
   struct nhdp_domain *domain;
   struct nhdp_link_domaindata *data;
-  int i;
+
+  if (_alloc_slot(NHDP_DOMAIN_DATA_LINK, &lnk->_domain_slot)) {
+    return -1;
+  }
 
   /* initialize flooding MPR settings */
   lnk->flooding_willingness = RFC7181_WILLINGNESS_NEVER;
@@ -356,78 +441,91 @@ nhdp_domain_init_link(struct nhdp_link *lnk) {
   lnk->neigh_is_flooding_mpr = false;
 
   /* initialize metrics */
-  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
-    lnk->_domaindata[i].metric.in = RFC7181_METRIC_INFINITE;
-    lnk->_domaindata[i].metric.out = RFC7181_METRIC_INFINITE;
-    lnk->_domaindata[i].last_metric_change = oonf_clock_getNow();
-  }
   list_for_each_element(&_domain_list, domain, _node) {
     data = nhdp_domain_get_linkdata(domain, lnk);
-
     if (domain->metric->no_default_handling) {
       data->metric.in = domain->metric->incoming_link_start;
       data->metric.out = domain->metric->outgoing_link_start;
     }
   }
+  return 0;
+}
+
+/**
+ * Release the domain data of a NHDP link
+ * @param lnk NHDP link
+ */
+void
+nhdp_domain_cleanup_link(struct nhdp_link *lnk) {
+  _free_slot(NHDP_DOMAIN_DATA_LINK, lnk->_domain_slot);
 }
 
 /**
  * Initialize the domain data of a new NHDP twohop neighbor
  * @param l2hop NHDP twohop neighbor
+ * @return -1 if out of memory, 0 otherwise
  */
-void
+int
 nhdp_domain_init_l2hop(struct nhdp_l2hop *l2hop) {
   struct nhdp_domain *domain;
   struct nhdp_l2hop_domaindata *data;
-  int i;
 
-  /* initialize metrics */
-  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
-    l2hop->_domaindata[i].metric.in = RFC7181_METRIC_INFINITE;
-    l2hop->_domaindata[i].metric.out = RFC7181_METRIC_INFINITE;
+  if (_alloc_slot(NHDP_DOMAIN_DATA_L2HOP, &l2hop->_domain_slot)) {
+    return -1;
   }
 
+  /* initialize metrics */
   list_for_each_element(&_domain_list, domain, _node) {
     data = nhdp_domain_get_l2hopdata(domain, l2hop);
-
     if (domain->metric->no_default_handling) {
       data->metric.in = domain->metric->incoming_2hop_start;
       data->metric.out = domain->metric->outgoing_2hop_start;
     }
   }
+  return 0;
+}
+
+/**
+ * Release the domain data of a NHDP twohop neighbor
+ * @param l2hop NHDP twohop neighbor
+ */
+void
+nhdp_domain_cleanup_l2hop(struct nhdp_l2hop *l2hop) {
+  _free_slot(NHDP_DOMAIN_DATA_L2HOP, l2hop->_domain_slot);
 }
 
 /**
  * Initialize the domain data of a new NHDP neighbor
  * @param neigh NHDP neighbor
+ * @return -1 if out of memory, 0 otherwise
  */
-void
+int
 nhdp_domain_init_neighbor(struct nhdp_neighbor *neigh) {
   struct nhdp_domain *domain;
   struct nhdp_neighbor_domaindata *data;
-  int i;
 
-  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
-    neigh->_domaindata[i].metric.in = RFC7181_METRIC_INFINITE;
-    neigh->_domaindata[i].metric.out = RFC7181_METRIC_INFINITE;
-
-    neigh->_domaindata[i].best_out_link = NULL;
-    neigh->_domaindata[i].best_out_link_metric = RFC7181_METRIC_INFINITE;
-    neigh->_domaindata[i].willingness = RFC7181_WILLINGNESS_NEVER;
-
-    neigh->_domaindata[i].local_is_mpr = false;
-    neigh->_domaindata[i].neigh_is_mpr = false;
+  if (_alloc_slot(NHDP_DOMAIN_DATA_NEIGHBOR, &neigh->_domain_slot)) {
+    return -1;
   }
 
   /* initialize metrics and mprs */
   list_for_each_element(&_domain_list, domain, _node) {
     data = nhdp_domain_get_neighbordata(domain, neigh);
-
     if (domain->metric->no_default_handling) {
       data->metric.in = domain->metric->incoming_link_start;
       data->metric.out = domain->metric->outgoing_link_start;
     }
   }
+  return 0;
+}
+
+/**
+ * Release the domain data of a NHDP neighbor
+ * @param neigh NHDP neighbor
+ */
+void
+nhdp_domain_cleanup_neighbor(struct nhdp_neighbor *neigh) {
+  _free_slot(NHDP_DOMAIN_DATA_NEIGHBOR, neigh->_domain_slot);
 }
 
 /**
@@ -484,7 +582,6 @@ nhdp_domain_process_metric_2hoptlv(struct nhdp_domain *domain, struct nhdp_l2hop
  */
 static bool
 _recalculate_metrics(struct nhdp_domain *domain, struct nhdp_neighbor *neigh, bool trigger) {
-  struct nhdp_domain_listener *listener;
   bool changed_metric;
 
   changed_metric = false;
@@ -508,18 +605,8 @@ _recalculate_metrics(struct nhdp_domain *domain, struct nhdp_neighbor *neigh, bo
     changed_metric |= _recalculate_neighbor_metric(domain, neigh);
   }
 
-  if (trigger && changed_metric) {
-    list_for_each_element(&_domain_listener_list, listener, _node) {
-      /* trigger domain listeners */
-      if (listener->metric_update) {
-        listener->metric_update(domain);
-      }
-    }
-  }
-
   if (trigger) {
-    OONF_INFO(
-      LOG_NHDP, "Metrics changed for domain %d: %s", domain ? domain->index : -1, changed_metric ? "true" : "false");
+    nhdp_domain_trigger_metric_update(domain, changed_metric);
   }
   return changed_metric;
 }
@@ -529,6 +616,39 @@ nhdp_domain_recalculate_metrics(struct nhdp_domain *domain, struct nhdp_neighbor
   return _recalculate_metrics(domain, neigh, true);
 }
 
+/**
+ * Recalculate the metrics of a neighbor in all domains without
+ * triggering the domain listeners. Used to recalculate a batch of
+ * neighbors followed by a single nhdp_domain_trigger_metric_update() call.
+ * @param neigh nhdp neighbor
+ * @return true if an outgoing metric changed, false otherwise
+ */
+bool
+nhdp_domain_recalculate_neighbor_metrics(struct nhdp_neighbor *neigh) {
+  return _recalculate_metrics(NULL, neigh, false);
+}
+
+/**
+ * Inform the domain listeners about a metric recalculation
+ * @param domain NHDP domain of metric change, NULL for all domains
+ * @param changed true if the metric changed, false otherwise
+ */
+void
+nhdp_domain_trigger_metric_update(struct nhdp_domain *domain, bool changed) {
+  struct nhdp_domain_listener *listener;
+
+  if (changed) {
+    list_for_each_element(&_domain_listener_list, listener, _node) {
+      /* trigger domain listeners */
+      if (listener->metric_update) {
+        listener->metric_update(domain);
+      }
+    }
+  }
+
+  OONF_INFO(LOG_NHDP, "Metrics changed for domain %d: %s", domain ? domain->index : -1, changed ? "true" : "false");
+}
+
 static void
 _fire_mpr_changed(struct nhdp_domain *domain) {
   struct nhdp_domain_listener *listener;
@@ -549,6 +669,7 @@ nhdp_domain_recalculate_mpr(void) {
       if (_recalculate_routing_mpr_set(domain)) {
         domain->mpr->update_routing_mpr(domain);
         _fire_mpr_changed(domain);
+        _generation++;
       }
       domain->_mpr_outdated = false;
     }
@@ -557,6 +678,7 @@ nhdp_domain_recalculate_mpr(void) {
     if (_recalculate_flooding_mpr_set()) {
       _flooding_domain.mpr->update_flooding_mpr(&_flooding_domain);
       _fire_mpr_changed(&_flooding_domain);
+      _generation++;
     }
     _flooding_domain._mpr_outdated = false;
   }
@@ -581,6 +703,25 @@ nhdp_domain_delayed_mpr_recalculation(struct nhdp_domain *domain, struct nhdp_ne
   domain->_mpr_outdated = true;
 }
 
+/**
+ * @return generation counter of NHDP domain data, will be increased
+ *   for every change of metric, MPR set or willingness that is visible
+ *   in a HELLO message.
+ */
+uint32_t
+nhdp_domain_get_generation(void) {
+  return _generation;
+}
+
+/**
+ * Increase generation counter of NHDP domain data to signal
+ * a change of metric data outside of the domain code.
+ */
+void
+nhdp_domain_increase_generation(void) {
+  _generation++;
+}
+
 /**
  * @return true if this node is selected as a MPR by any other node
  */
@@ -630,6 +771,25 @@ nhdp_domain_process_mprtypes_tlv(uint8_t *mprtypes, size_t mprtypes_size, struct
 void
 nhdp_domain_process_mpr_tlv(
   uint8_t *mprtypes, size_t mprtypes_size, struct nhdp_link *lnk, struct rfc5444_reader_tlvblock_entry *tlv) {
+  if (tlv) {
+    nhdp_domain_process_mpr_value(mprtypes, mprtypes_size, lnk, tlv->single_value, tlv->length);
+  }
+  else {
+    nhdp_domain_process_mpr_value(mprtypes, mprtypes_size, lnk, NULL, 0);
+  }
+}
+
+/**
+ * Process the value of an in MPR tlv for a NHDP link
+ * @param mprtypes list of extensions for MPR
+ * @param mprtypes_size length of mprtypes array
+ * @param lnk NHDP link
+ * @param value value of MPR tlv, NULL if no tlv was present
+ * @param length length of MPR tlv value
+ */
+void
+nhdp_domain_process_mpr_value(
+  uint8_t *mprtypes, size_t mprtypes_size, struct nhdp_link *lnk, const uint8_t *value, size_t length) {
   struct nhdp_domain *domain;
   struct nhdp_neighbor *neigh;
   size_t bit_idx, byte_idx;
@@ -640,12 +800,12 @@ nhdp_domain_process_mpr_tlv(
     nhdp_domain_get_neighbordata(domain, lnk->neigh)->local_is_mpr = false;
   }
 
-  if (!tlv) {
+  if (!value || length == 0) {
     return;
   }
 
   /* set flooding MPR flag */
-  lnk->local_is_flooding_mpr = (tlv->single_value[0] & RFC7181_MPR_FLOODING) != 0;
+  lnk->local_is_flooding_mpr = (value[0] & RFC7181_MPR_FLOODING) != 0;
   OONF_DEBUG(LOG_NHDP_R, "Flooding MPR for neighbor: %s", lnk->local_is_flooding_mpr ? "true" : "false");
 
   /* set routing MPR flags */
@@ -657,12 +817,11 @@ nhdp_domain_process_mpr_tlv(
     bit_idx = (i + 1) & 7;
     byte_idx = (i + 1) >> 3;
 
-    if (byte_idx >= tlv->length) {
+    if (byte_idx >= length) {
       continue;
     }
 
-    nhdp_domain_get_neighbordata(domain, lnk->neigh)->local_is_mpr =
-      (tlv->single_value[byte_idx] & (1 << bit_idx)) != 0;
+    nhdp_domain_get_neighbordata(domain, lnk->neigh)->local_is_mpr = (value[byte_idx] & (1 << bit_idx)) != 0;
 
     OONF_DEBUG(LOG_NHDP_R, "Routing MPR for neighbor in domain %u: %s", domain->ext,
       nhdp_domain_get_neighbordata(domain, lnk->neigh)->local_is_mpr ? "true" : "false");
@@ -884,6 +1043,8 @@ nhdp_domain_get_flooding_domain(void) {
 /**
  * Sets the incoming metric of a link. This is the only function external
  * code should use to commit the calculated metric values to the nhdp db.
+ * Insignificant changes (see nhdp_domain_set_metric_hysteresis()) are
+ * suppressed.
  * @param metric NHDP domain metric
  * @param lnk NHDP link
  * @param metric_in incoming metric value for NHDP link
@@ -908,11 +1069,18 @@ nhdp_domain_set_incoming_metric(struct nhdp_domain_metric *metric, struct nhdp_l
         new_metric = processor->process_in_metric(domain, lnk, new_metric);
       }
 
-      if (linkdata->metric.in != new_metric) {
-        changed = true;
-        linkdata->last_metric_change = oonf_clock_getNow();
+      if (linkdata->metric.in == new_metric) {
+        continue;
       }
+      if (!_is_significant_metric_change(domain, linkdata, new_metric)) {
+        domain->metric_suppressed_count++;
+        continue;
+      }
+
+      changed = true;
+      linkdata->last_metric_change = oonf_clock_getNow();
       linkdata->metric.in = new_metric;
+      _generation++;
     }
   }
   return changed;
@@ -1018,6 +1186,7 @@ _recalculate_neighbor_metric(struct nhdp_domain *domain, struct nhdp_neighbor *n
   struct nhdp_l2hop *l2hop;
   struct nhdp_l2hop_domaindata *l2hopdata;
   struct nhdp_neighbor_domaindata *neighdata;
+  struct nhdp_metric old_metric;
   bool changed;
 #ifdef OONF_LOG_INFO
   struct netaddr_str nbuf;
@@ -1026,6 +1195,9 @@ _recalculate_neighbor_metric(struct nhdp_domain *domain, struct nhdp_neighbor *n
   neighdata = nhdp_domain_get_neighbordata(domain, neigh);
   changed = false;
 
+  /* remember old metric to detect changes in the HELLO content */
+  memcpy(&old_metric, &neighdata->metric, sizeof(old_metric));
+
   /* reset metric */
   neighdata->metric.in = RFC7181_METRIC_INFINITE;
   neighdata->metric.out = RFC7181_METRIC_INFINITE;
@@ -1078,9 +1250,47 @@ _recalculate_neighbor_metric(struct nhdp_domain *domain, struct nhdp_neighbor *n
     neighdata->best_out_link_metric = linkdata->metric.out;
   }
 
+  if (memcmp(&old_metric, &neighdata->metric, sizeof(old_metric)) != 0) {
+    _generation++;
+  }
   return changed;
 }
 
+/**
+ * Check if a new incoming link metric is different enough from the
+ * current one to be applied
+ * @param domain NHDP domain
+ * @param linkdata domain data of the NHDP link
+ * @param new_metric new incoming metric
+ * @return true if the metric should be applied, false otherwise
+ */
+static bool
+_is_significant_metric_change(
+  struct nhdp_domain *domain, struct nhdp_link_domaindata *linkdata, uint32_t new_metric) {
+  uint32_t old_metric, delta;
+
+  if (domain->metric_threshold_relative == 0 && domain->metric_threshold_absolute == 0) {
+    return true;
+  }
+
+  old_metric = linkdata->metric.in;
+  if (old_metric >= RFC7181_METRIC_INFINITE || new_metric >= RFC7181_METRIC_INFINITE) {
+    /* link appears or disappears */
+    return true;
+  }
+
+  if (domain->metric_refresh_interval > 0
+      && oonf_clock_getNow() >= linkdata->last_metric_change + domain->metric_refresh_interval) {
+    return true;
+  }
+
+  delta = new_metric > old_metric ? new_metric - old_metric : old_metric - new_metric;
+  if (delta < domain->metric_threshold_absolute) {
+    return false;
+  }
+  return (uint64_t)delta * 1000ull >= (uint64_t)old_metric * domain->metric_threshold_relative;
+}
+
 /**
  * Add a new domain to the NHDP system
  * @param ext TLV extension type used for new domain
@@ -1108,7 +1318,18 @@ nhdp_domain_add(uint8_t ext) {
     return NULL;
   }
 
+  /* the storage of the first domain index is always allocated */
+  if (_domain_counter >= _storage_count) {
+    if (_init_storage(&_storage[_domain_counter])) {
+      OONF_WARN(LOG_NHDP, "Out of memory for domain data of NHDP domain %u", ext);
+      oonf_class_free(&_domain_class, domain);
+      return NULL;
+    }
+    _storage_count++;
+  }
+
   domain->ext = ext;
+  domain->_storage = &_storage[_domain_counter];
   domain->index = _domain_counter++;
   domain->metric = &_no_metric;
   domain->mpr = &_everyone_mprs;
@@ -1126,6 +1347,7 @@ nhdp_domain_add(uint8_t ext) {
 
   /* add to domain list */
   list_add_tail(&_domain_list, &domain->_node);
+  _generation++;
 
   oonf_class_event(&_domain_class, domain, OONF_OBJECT_ADDED);
   return domain;
@@ -1166,6 +1388,26 @@ nhdp_domain_configure(uint8_t ext, const char *metric_name, const char *mpr_name
   return domain;
 }
 
+/**
+ * Configure the hysteresis for incoming link metrics of a domain.
+ * A new metric is only applied if it differs from the current one
+ * by at least the relative and the absolute threshold, if the link
+ * had no finite metric before or will lose it, or if the last metric
+ * change of the link is older than the refresh interval.
+ * @param domain pointer to NHDP domain
+ * @param relative minimum relative change in 1/1000, 0 to disable
+ * @param absolute minimum absolute change, 0 to disable
+ * @param refresh_interval time after which any metric change is applied,
+ *   0 to disable
+ */
+void
+nhdp_domain_set_metric_hysteresis(
+  struct nhdp_domain *domain, uint32_t relative, uint32_t absolute, uint64_t refresh_interval) {
+  domain->metric_threshold_relative = relative;
+  domain->metric_threshold_absolute = absolute;
+  domain->metric_refresh_interval = refresh_interval;
+}
+
 /**
  * Apply a new metric algorithm to a NHDP domain
  * @param domain pointer to NHDP domain
@@ -1183,6 +1425,7 @@ _apply_metric(struct nhdp_domain *domain, const char *metric_name) {
     /* nothing to do, we already have the right metric */
     return;
   }
+  _generation++;
 
   if (domain->metric != &_no_metric) {
     _remove_metric(domain);
@@ -1226,6 +1469,7 @@ _remove_metric(struct nhdp_domain *domain) {
   strscpy(domain->metric_name, CFG_DOMAIN_NO_METRIC_MPR, sizeof(domain->metric_name));
   domain->metric = &_no_metric;
   domain->metric->_refcount++;
+  _generation++;
 }
 
 /**
@@ -1242,6 +1486,7 @@ _apply_mpr(struct nhdp_domain *domain, const char *mpr_name, uint8_t willingness
   struct nhdp_domain_mpr *mpr;
 
   domain->local_willingness = willingness;
+  _generation++;
 
   /* check if we have to remove the old mpr first */
   if (strcasecmp(domain->mpr_name, mpr_name) == 0) {
@@ -1291,6 +1536,7 @@ _remove_mpr(struct nhdp_domain *domain) {
   strscpy(domain->mpr_name, CFG_DOMAIN_NO_METRIC_MPR, sizeof(domain->mpr_name));
   domain->mpr = &_everyone_mprs;
   domain->mpr->_refcount++;
+  _generation++;
 }
 
 static void
@@ -1347,3 +1593,212 @@ _int_to_string(struct nhdp_metric_str *buf, struct nhdp_link *lnk __attribute__(
   strscpy(buf->buf, "-", sizeof(*buf));
   return buf->buf;
 }
+
+/**
+ * Allocate a slot for the per-domain data of a NHDP object
+ * @param type type of NHDP object
+ * @param slot pointer to storage for the slot index
+ * @return -1 if out of memory, 0 otherwise
+ */
+static int
+_alloc_slot(enum nhdp_domain_data_type type, uint32_t *slot) {
+  struct _domain_slots *slots = &_slots[type];
+  uint8_t *page;
+  size_t i;
+
+  if (slots->free_count > 0) {
+    /* reuse slot of a removed object */
+    *slot = slots->free_slots[--slots->free_count];
+  }
+  else if (slots->next_slot == slots->page_count * NHDP_DOMAIN_PAGE_SIZE && _add_page(type)) {
+    return -1;
+  }
+  else {
+    *slot = slots->next_slot++;
+  }
+
+  /*
+   * reset the slot of all domain indices, including the first one
+   * that is also used by the flooding domain without a registered domain
+   */
+  for (i = 0; i < _storage_count; i++) {
+    page = _storage[i].pages[type][*slot >> NHDP_DOMAIN_PAGE_BITS];
+    slots->reset(page + (*slot & (NHDP_DOMAIN_PAGE_SIZE - 1)) * slots->entry_size);
+  }
+  return 0;
+}
+
+/**
+ * Mark a slot for per-domain data as unused
+ * @param type type of NHDP object
+ * @param slot slot index
+ */
+static void
+_free_slot(enum nhdp_domain_data_type type, uint32_t slot) {
+  struct _domain_slots *slots = &_slots[type];
+
+  /* array has been allocated together with the storage pages, so there is always space */
+  slots->free_slots[slots->free_count++] = slot;
+}
+
+/**
+ * Add a storage page for a type of NHDP objects to all domain indices
+ * @param type type of NHDP object
+ * @return -1 if out of memory, 0 otherwise
+ */
+static int
+_add_page(enum nhdp_domain_data_type type) {
+  struct _domain_slots *slots = &_slots[type];
+  uint32_t *free_slots;
+  void **pages;
+  size_t i;
+
+  free_slots = realloc(slots->free_slots, sizeof(uint32_t) * (slots->page_count + 1) * NHDP_DOMAIN_PAGE_SIZE);
+  if (!free_slots) {
+    return -1;
+  }
+  slots->free_slots = free_slots;
+
+  for (i = 0; i < _storage_count; i++) {
+    pages = realloc(_storage[i].pages[type], sizeof(void *) * (slots->page_count + 1));
+    if (!pages) {
+      break;
+    }
+    _storage[i].pages[type] = pages;
+
+    pages[slots->page_count] = _alloc_page(type);
+    if (!pages[slots->page_count]) {
+      break;
+    }
+  }
+
+  if (i < _storage_count) {
+    OONF_WARN(LOG_NHDP, "Out of memory for NHDP domain data");
+
+    /* free the pages allocated in this call */
+    while (i-- > 0) {
+      free(_storage[i].pages[type][slots->page_count]);
+    }
+    return -1;
+  }
+
+  slots->page_count++;
+  return 0;
+}
+
+/**
+ * Allocate the storage pages of a new domain index
+ * @param storage pointer to domain storage
+ * @return -1 if out of memory, 0 otherwise
+ */
+static int
+_init_storage(struct nhdp_domain_storage *storage) {
+  uint32_t i;
+  int type;
+
+  for (type = 0; type < NHDP_DOMAIN_DATA_COUNT; type++) {
+    if (_slots[type].page_count == 0) {
+      continue;
+    }
+
+    storage->pages[type] = calloc(_slots[type].page_count, sizeof(void *));
+    if (!storage->pages[type]) {
+      _free_storage(storage);
+      return -1;
+    }
+
+    for (i = 0; i < _slots[type].page_count; i++) {
+      storage->pages[type][i] = _alloc_page(type);
+      if (!storage->pages[type][i]) {
+        _free_storage(storage);
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * Free all storage pages of a domain index
+ * @param storage pointer to domain storage
+ */
+static void
+_free_storage(struct nhdp_domain_storage *storage) {
+  uint32_t i;
+  int type;
+
+  for (type = 0; type < NHDP_DOMAIN_DATA_COUNT; type++) {
+    if (storage->pages[type]) {
+      /* pages array is zeroed or filled up to page_count */
+      for (i = 0; i < _slots[type].page_count; i++) {
+        free(storage->pages[type][i]);
+      }
+      free(storage->pages[type]);
+      storage->pages[type] = NULL;
+    }
+  }
+}
+
+/**
+ * Allocate a storage page with default domain data
+ * @param type type of NHDP object
+ * @return pointer to storage page, NULL if out of memory
+ */
+static void *
+_alloc_page(enum nhdp_domain_data_type type) {
+  struct _domain_slots *slots = &_slots[type];
+  uint8_t *page;
+  size_t i;
+
+  page = malloc(slots->entry_size * NHDP_DOMAIN_PAGE_SIZE);
+  if (page) {
+    for (i = 0; i < NHDP_DOMAIN_PAGE_SIZE; i++) {
+      slots->reset(page + i * slots->entry_size);
+    }
+  }
+  return page;
+}
+
+/**
+ * Reset link domain data to default values
+ * @param ptr pointer to nhdp_link_domaindata
+ */
+static void
+_reset_linkdata(void *ptr) {
+  struct nhdp_link_domaindata *data = ptr;
+
+  memset(data, 0, sizeof(*data));
+  data->metric.in = RFC7181_METRIC_INFINITE;
+  data->metric.out = RFC7181_METRIC_INFINITE;
+  data->last_metric_change = oonf_clock_getNow();
+}
+
+/**
+ * Reset neighbor domain data to default values
+ * @param ptr pointer to nhdp_neighbor_domaindata
+ */
+static void
+_reset_neighbordata(void *ptr) {
+  struct nhdp_neighbor_domaindata *data = ptr;
+
+  memset(data, 0, sizeof(*data));
+  data->metric.in = RFC7181_METRIC_INFINITE;
+  data->metric.out = RFC7181_METRIC_INFINITE;
+
+  data->best_out_link = NULL;
+  data->best_out_link_metric = RFC7181_METRIC_INFINITE;
+  data->willingness = RFC7181_WILLINGNESS_NEVER;
+}
+
+/**
+ * Reset twohop neighbor domain data to default values
+ * @param ptr pointer to nhdp_l2hop_domaindata
+ */
+static void
+_reset_l2hopdata(void *ptr) {
+  struct nhdp_l2hop_domaindata *data = ptr;
+
+  memset(data, 0, sizeof(*data));
+  data->metric.in = RFC7181_METRIC_INFINITE;
+  data->metric.out = RFC7181_METRIC_INFINITE;
+}
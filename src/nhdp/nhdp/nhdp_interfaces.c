@@ -70,7 +70,9 @@ static void _cb_addr_timeout(struct oonf_timer_instance *ptr);
 
 static int avl_comp_ifaddr(const void *k1, const void *k2);
 
+static void _send_hello(struct nhdp_interface *interf);
 static void _cb_generate_hello(struct oonf_timer_instance *ptr);
+static void _cb_triggered_hello(struct oonf_timer_instance *ptr);
 static void _cb_interface_event(struct oonf_rfc5444_interface_listener *, bool);
 
 /* global tree of nhdp interfaces, filters and addresses */
@@ -89,6 +91,11 @@ static struct oonf_timer_class _interface_hello_timer = {
   .callback = _cb_generate_hello,
 };
 
+static struct oonf_timer_class _interface_trigger_timer = {
+  .name = "NHDP triggered hello timer",
+  .callback = _cb_triggered_hello,
+};
+
 static struct oonf_class _addr_info = {
   .name = NHDP_CLASS_INTERFACE_ADDRESS,
   .size = sizeof(struct nhdp_interface_addr),
@@ -113,6 +120,7 @@ nhdp_interfaces_init(struct oonf_rfc5444_protocol *p) {
   oonf_class_add(&_interface_info);
   oonf_class_add(&_addr_info);
   oonf_timer_add(&_interface_hello_timer);
+  oonf_timer_add(&_interface_trigger_timer);
   oonf_timer_add(&_removed_address_hold_timer);
 
   /* default protocol should be always available */
@@ -133,11 +141,37 @@ nhdp_interfaces_cleanup(void) {
   }
 
   oonf_timer_remove(&_interface_hello_timer);
+  oonf_timer_remove(&_interface_trigger_timer);
   oonf_timer_remove(&_removed_address_hold_timer);
   oonf_class_remove(&_interface_info);
   oonf_class_remove(&_addr_info);
 }
 
+/**
+ * Request an early Hello on an interface because of a significant
+ * change of the NHDP database. The Hello is sent with the next timer
+ * tick, but not earlier than hello_min_interval after the last one.
+ * Does nothing if triggered Hellos are disabled for the interface.
+ * @param interf pointer to nhdp interface
+ */
+void
+nhdp_interface_trigger_hello(struct nhdp_interface *interf) {
+  int64_t next;
+
+  if (interf->hello_min_interval == 0 || oonf_timer_is_active(&interf->_trigger_timer)) {
+    /* triggered hellos disabled or already scheduled */
+    return;
+  }
+
+  /* wait until hello_min_interval since the last hello has passed */
+  next = oonf_clock_get_relative(interf->_last_hello + interf->hello_min_interval);
+  if (next < 1) {
+    /* send hello with the next timer tick */
+    next = 1;
+  }
+  oonf_timer_set(&interf->_trigger_timer, next);
+}
+
 /**
  * Recalculates if IPv4 or IPv6 should be used on an interface
  * for flooding messages.
@@ -228,6 +262,7 @@ nhdp_interface_add(const char *name) {
 
     /* initialize timers */
     interf->_hello_timer.class = &_interface_hello_timer;
+    interf->_trigger_timer.class = &_interface_trigger_timer;
 
     /* hook into global interface tree */
     interf->_node.key = interf->rfc5444_if.interface->name;
@@ -239,8 +274,8 @@ nhdp_interface_add(const char *name) {
     /* init link list */
     list_init_head(&interf->_links);
 
-    /* init link address tree */
-    avl_init(&interf->_link_addresses, avl_comp_netaddr, false);
+    /* init link address index */
+    hashmap_init(&interf->_link_addresses, hashmap_hash_netaddr, avl_comp_netaddr);
 
     /*
      * init originator tree
@@ -293,6 +328,8 @@ nhdp_interface_remove(struct nhdp_interface *interf) {
 
   /* stop Hellos */
   oonf_timer_stop(&interf->_hello_timer);
+  oonf_timer_stop(&interf->_trigger_timer);
+  nhdp_writer_clear_hello_cache(interf);
 
   avl_for_each_element_safe(&interf->_if_addresses, addr, _if_node, a_it) {
     _remove_addr(addr);
@@ -308,6 +345,7 @@ nhdp_interface_remove(struct nhdp_interface *interf) {
   /* now clean up the rest */
   os_interface_remove(&interf->os_if_listener);
   oonf_rfc5444_remove_interface(interf->rfc5444_if.interface, &interf->rfc5444_if);
+  hashmap_free(&interf->_link_addresses);
   oonf_class_free(&_interface_info, interf);
 }
 
@@ -341,6 +379,9 @@ nhdp_interface_apply_settings(struct nhdp_interface *interf) {
   interf->l_hold_time = vtime;
   interf->n_hold_time = vtime;
   interf->i_hold_time = vtime;
+
+  /* interval and validity time are part of the HELLO */
+  nhdp_db_increase_generation();
 }
 
 /**
@@ -475,6 +516,8 @@ _remove_addr(struct nhdp_interface_addr *addr) {
   avl_remove(&_ifaddr_tree, &addr->_global_node);
   avl_remove(&addr->interf->_if_addresses, &addr->_if_node);
   oonf_class_free(&_addr_info, addr);
+
+  nhdp_db_increase_generation();
 }
 
 /**
@@ -510,6 +553,16 @@ avl_comp_ifaddr(const void *k1, const void *k2) {
   return memcmp(n1, n2, 16);
 }
 
+/**
+ * Send a Hello through an interface and remember the time
+ * @param interf nhdp interface
+ */
+static void
+_send_hello(struct nhdp_interface *interf) {
+  interf->_last_hello = oonf_clock_getNow();
+  nhdp_writer_send_hello(interf);
+}
+
 /**
  * Callback triggered to generate a Hello on an interface
  * @param ptr timer instance that fired
@@ -519,7 +572,21 @@ _cb_generate_hello(struct oonf_timer_instance *ptr) {
   struct nhdp_interface *nhdp_if;
 
   nhdp_if = container_of(ptr, struct nhdp_interface, _hello_timer);
-  nhdp_writer_send_hello(nhdp_if);
+  oonf_timer_stop(&nhdp_if->_trigger_timer);
+  _send_hello(nhdp_if);
+}
+
+/**
+ * Callback triggered to generate a triggered Hello on an interface
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_triggered_hello(struct oonf_timer_instance *ptr) {
+  struct nhdp_interface *nhdp_if;
+
+  nhdp_if = container_of(ptr, struct nhdp_interface, _trigger_timer);
+  OONF_DEBUG(LOG_NHDP, "Send triggered Hello on interface %s", nhdp_interface_get_name(nhdp_if));
+  _send_hello(nhdp_if);
 }
 
 /**
@@ -607,4 +674,7 @@ _cb_interface_event(struct oonf_rfc5444_interface_listener *ifl, bool changed __
   if (sock) {
     netaddr_from_socket(&interf->local_ipv6, sock);
   }
+
+  /* interface addresses are part of the HELLO */
+  nhdp_db_increase_generation();
 }
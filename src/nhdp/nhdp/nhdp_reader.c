@@ -43,6 +43,8 @@
  * @file
  */
 
+#include <stdlib.h>
+
 #include <oonf/oonf.h>
 #include <oonf/libcommon/netaddr.h>
 #include <oonf/libcore/oonf_logging.h>
@@ -68,44 +70,82 @@ enum
   IDX_TLV_MAC,
 };
 
-/* NHDP address TLV array index pass 1 */
+/* NHDP address TLV array index */
 enum
 {
-  IDX_ADDRTLV1_LOCAL_IF,
-  IDX_ADDRTLV1_LINK_STATUS,
+  IDX_ADDRTLV_LOCAL_IF,
+  IDX_ADDRTLV_LINK_STATUS,
+  IDX_ADDRTLV_OTHER_NEIGHB,
+  IDX_ADDRTLV_MPR,
+  IDX_ADDRTLV_LINKMETRIC,
 };
 
-/* NHDP address TLV array index pass 2 */
-enum
-{
-  IDX_ADDRTLV2_LOCAL_IF,
-  IDX_ADDRTLV2_LINK_STATUS,
-  IDX_ADDRTLV2_OTHER_NEIGHB,
-  IDX_ADDRTLV2_MPR,
-  IDX_ADDRTLV2_LINKMETRIC,
+/*! initial number of buffered HELLO addresses */
+#define NHDP_READER_ADDRESS_STEP 32
+
+/*! maximum number of LINK_METRIC TLVs of an address, one for each domain and metric flag */
+#define NHDP_READER_MAX_METRIC_TLVS (NHDP_MAXIMUM_DOMAINS * 4)
+
+/**
+ * Address of a HELLO together with the TLV values necessary to
+ * update the database after link and neighbor have been resolved.
+ * TLV value pointers point into the packet buffer and are only valid
+ * during processing of the message.
+ */
+struct _hello_address {
+  /*! address from the address block */
+  struct netaddr addr;
+
+  /*! value of LOCAL_IF TLV, 255 if not present */
+  uint8_t local_if;
+
+  /*! value of LINK_STATUS TLV, 255 if not present */
+  uint8_t link_status;
+
+  /*! value of OTHER_NEIGHB TLV, 255 if not present */
+  uint8_t other_neigh;
+
+  /*! true if address belongs to the local interface */
+  bool this_if;
+
+  /*! number of buffered LINK_METRIC TLVs */
+  uint8_t metric_count;
+
+  /*! length of MPR TLV value */
+  uint16_t mpr_length;
+
+  /*! value of MPR TLV, NULL if not present */
+  const uint8_t *mpr;
+
+  /*! domains of the buffered LINK_METRIC TLVs */
+  struct nhdp_domain *metric_domain[NHDP_READER_MAX_METRIC_TLVS];
+
+  /*! values of the buffered LINK_METRIC TLVs */
+  const uint8_t *metric[NHDP_READER_MAX_METRIC_TLVS];
 };
 
 /* prototypes */
 static void _cleanup_error(void);
-static enum rfc5444_result _pass2_process_localif(struct netaddr *addr, uint8_t local_if);
+static enum rfc5444_result _process_localif(struct netaddr *addr, uint8_t local_if);
+static enum rfc5444_result _process_address(struct _hello_address *hello_addr);
+static enum rfc5444_result _process_hello(struct rfc5444_reader_tlvblock_context *context);
+static void _finalize_hello(struct rfc5444_reader_tlvblock_context *context);
 static void _handle_originator(struct rfc5444_reader_tlvblock_context *context);
+static struct _hello_address *_add_hello_address(void);
 
 static enum rfc5444_result _cb_messagetlvs(struct rfc5444_reader_tlvblock_context *context);
 static enum rfc5444_result _cb_failed_constraints(struct rfc5444_reader_tlvblock_context *context);
 
-static enum rfc5444_result _cb_addresstlvs_pass1(struct rfc5444_reader_tlvblock_context *context);
-static enum rfc5444_result _cb_addresstlvs_pass1_end(struct rfc5444_reader_tlvblock_context *context, bool dropped);
-
-static enum rfc5444_result _cb_addr_pass2_block(struct rfc5444_reader_tlvblock_context *context);
-static enum rfc5444_result _cb_msg_pass2_end(struct rfc5444_reader_tlvblock_context *context, bool dropped);
+static enum rfc5444_result _cb_addresstlvs(struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_msg_end(struct rfc5444_reader_tlvblock_context *context, bool dropped);
 
 /* definition of the RFC5444 reader components */
-static struct rfc5444_reader_tlvblock_consumer _nhdp_message_pass1_consumer = {
+static struct rfc5444_reader_tlvblock_consumer _nhdp_message_consumer = {
   .order = RFC5444_MAIN_PARSER_PRIORITY,
   .msg_id = RFC6130_MSGTYPE_HELLO,
   .block_callback = _cb_messagetlvs,
   .block_callback_failed_constraints = _cb_failed_constraints,
-  .end_callback = _cb_addresstlvs_pass1_end,
+  .end_callback = _cb_msg_end,
 };
 
 static struct rfc5444_reader_tlvblock_consumer_entry _nhdp_message_tlvs[] = {
@@ -143,65 +183,35 @@ static struct rfc5444_reader_tlvblock_consumer_entry _nhdp_message_tlvs[] = {
     { .type = NHDP_MSGTLV_MAC, .type_ext = 0, .match_type_ext = true, .min_length = 6, .match_length = true },
 };
 
-static struct rfc5444_reader_tlvblock_consumer _nhdp_address_pass1_consumer = {
+static struct rfc5444_reader_tlvblock_consumer _nhdp_address_consumer = {
   .order = RFC5444_MAIN_PARSER_PRIORITY,
   .msg_id = RFC6130_MSGTYPE_HELLO,
   .addrblock_consumer = true,
-  .block_callback = _cb_addresstlvs_pass1,
-  .block_callback_failed_constraints = _cb_failed_constraints,
-};
-
-static struct rfc5444_reader_tlvblock_consumer_entry _nhdp_address_pass1_tlvs[] = {
-  [IDX_ADDRTLV1_LOCAL_IF] = { .type = RFC6130_ADDRTLV_LOCAL_IF,
-    .type_ext = 0,
-    .match_type_ext = true,
-    .min_length = 1,
-    .max_length = 65535,
-    .match_length = true },
-  [IDX_ADDRTLV1_LINK_STATUS] = { .type = RFC6130_ADDRTLV_LINK_STATUS,
-    .type_ext = 0,
-    .match_type_ext = true,
-    .min_length = 1,
-    .max_length = 65535,
-    .match_length = true },
-};
-
-static struct rfc5444_reader_tlvblock_consumer _nhdp_message_pass2_consumer = {
-  .order = RFC5444_MAIN_PARSER_PRIORITY + 1,
-  .msg_id = RFC6130_MSGTYPE_HELLO,
-  .end_callback = _cb_msg_pass2_end,
-  .block_callback_failed_constraints = _cb_failed_constraints,
-};
-
-static struct rfc5444_reader_tlvblock_consumer _nhdp_address_pass2_consumer = {
-  .order = RFC5444_MAIN_PARSER_PRIORITY + 1,
-  .msg_id = RFC6130_MSGTYPE_HELLO,
-  .addrblock_consumer = true,
-  .block_callback = _cb_addr_pass2_block,
+  .block_callback = _cb_addresstlvs,
   .block_callback_failed_constraints = _cb_failed_constraints,
 };
 
-static struct rfc5444_reader_tlvblock_consumer_entry _nhdp_address_pass2_tlvs[] = {
-  [IDX_ADDRTLV2_LOCAL_IF] = { .type = RFC6130_ADDRTLV_LOCAL_IF,
+static struct rfc5444_reader_tlvblock_consumer_entry _nhdp_address_tlvs[] = {
+  [IDX_ADDRTLV_LOCAL_IF] = { .type = RFC6130_ADDRTLV_LOCAL_IF,
     .type_ext = 0,
     .match_type_ext = true,
     .min_length = 1,
     .max_length = 65535,
     .match_length = true },
-  [IDX_ADDRTLV2_LINK_STATUS] = { .type = RFC6130_ADDRTLV_LINK_STATUS,
+  [IDX_ADDRTLV_LINK_STATUS] = { .type = RFC6130_ADDRTLV_LINK_STATUS,
     .type_ext = 0,
     .match_type_ext = true,
     .min_length = 1,
     .max_length = 65535,
     .match_length = true },
-  [IDX_ADDRTLV2_OTHER_NEIGHB] = { .type = RFC6130_ADDRTLV_OTHER_NEIGHB,
+  [IDX_ADDRTLV_OTHER_NEIGHB] = { .type = RFC6130_ADDRTLV_OTHER_NEIGHB,
     .type_ext = 0,
     .match_type_ext = true,
     .min_length = 1,
     .max_length = 65535,
     .match_length = true },
-  [IDX_ADDRTLV2_MPR] = { .type = RFC7181_ADDRTLV_MPR, .min_length = 1, .max_length = 65535, .match_length = true },
-  [IDX_ADDRTLV2_LINKMETRIC] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .min_length = 2, .match_length = true },
+  [IDX_ADDRTLV_MPR] = { .type = RFC7181_ADDRTLV_MPR, .min_length = 1, .max_length = 65535, .match_length = true },
+  [IDX_ADDRTLV_LINKMETRIC] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .min_length = 2, .match_length = true },
 };
 
 /* nhdp multiplexer/protocol */
@@ -226,8 +236,15 @@ static struct {
 
   uint8_t mprtypes[NHDP_MAXIMUM_DOMAINS];
   size_t mprtypes_size;
+
+  /* number of buffered addresses of the message */
+  size_t address_count;
 } _current;
 
+/* buffer for addresses of the current HELLO, only grows */
+static struct _hello_address *_addresses = NULL;
+static size_t _addresses_size = 0;
+
 /**
  * Initialize nhdp reader
  * @param p rfc5444 protocol
@@ -237,12 +254,9 @@ nhdp_reader_init(struct oonf_rfc5444_protocol *p) {
   _protocol = p;
 
   rfc5444_reader_add_message_consumer(
-    &_protocol->reader, &_nhdp_message_pass1_consumer, _nhdp_message_tlvs, ARRAYSIZE(_nhdp_message_tlvs));
+    &_protocol->reader, &_nhdp_message_consumer, _nhdp_message_tlvs, ARRAYSIZE(_nhdp_message_tlvs));
   rfc5444_reader_add_message_consumer(
-    &_protocol->reader, &_nhdp_address_pass1_consumer, _nhdp_address_pass1_tlvs, ARRAYSIZE(_nhdp_address_pass1_tlvs));
-  rfc5444_reader_add_message_consumer(&_protocol->reader, &_nhdp_message_pass2_consumer, NULL, 0);
-  rfc5444_reader_add_message_consumer(
-    &_protocol->reader, &_nhdp_address_pass2_consumer, _nhdp_address_pass2_tlvs, ARRAYSIZE(_nhdp_address_pass2_tlvs));
+    &_protocol->reader, &_nhdp_address_consumer, _nhdp_address_tlvs, ARRAYSIZE(_nhdp_address_tlvs));
 }
 
 /**
@@ -250,10 +264,12 @@ nhdp_reader_init(struct oonf_rfc5444_protocol *p) {
  */
 void
 nhdp_reader_cleanup(void) {
-  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_nhdp_address_pass2_consumer);
-  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_nhdp_message_pass2_consumer);
-  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_nhdp_address_pass1_consumer);
-  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_nhdp_message_pass1_consumer);
+  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_nhdp_address_consumer);
+  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_nhdp_message_consumer);
+
+  free(_addresses);
+  _addresses = NULL;
+  _addresses_size = 0;
 }
 
 /**
@@ -273,6 +289,32 @@ _cleanup_error(void) {
   }
 }
 
+/**
+ * Get a new buffer entry for an address of the current HELLO,
+ * the buffer grows on demand and is reused for all messages.
+ * @return pointer to cleared address buffer, NULL if out of memory
+ */
+static struct _hello_address *
+_add_hello_address(void) {
+  struct _hello_address *ptr;
+  size_t size;
+
+  if (_current.address_count == _addresses_size) {
+    size = _addresses_size == 0 ? NHDP_READER_ADDRESS_STEP : _addresses_size * 2;
+    ptr = realloc(_addresses, size * sizeof(*_addresses));
+    if (ptr == NULL) {
+      OONF_WARN(LOG_NHDP_R, "Out of memory for HELLO address buffer");
+      return NULL;
+    }
+    _addresses = ptr;
+    _addresses_size = size;
+  }
+
+  ptr = &_addresses[_current.address_count++];
+  memset(ptr, 0, sizeof(*ptr));
+  return ptr;
+}
+
 /**
  * Process an address with a LOCAL_IF TLV
  * @param addr pointer to netaddr object with address
@@ -280,7 +322,7 @@ _cleanup_error(void) {
  * @return RFC5444 processing result
  */
 static enum rfc5444_result
-_pass2_process_localif(struct netaddr *addr, uint8_t local_if) {
+_process_localif(struct netaddr *addr, uint8_t local_if) {
   struct nhdp_neighbor *neigh;
   struct nhdp_naddr *naddr;
   struct nhdp_link *lnk;
@@ -510,32 +552,79 @@ _cb_failed_constraints(struct rfc5444_reader_tlvblock_context *context __attribu
 
 /**
  * Process addresses of NHDP Hello message to determine link/neighbor status
+ * and remember the TLVs necessary to update the database at the end of the message
  * @param context tlv block reader context
  * @return see rfc5444_result enum
  */
 static enum rfc5444_result
-_cb_addresstlvs_pass1(struct rfc5444_reader_tlvblock_context *context) {
-  uint8_t local_if, link_status;
+_cb_addresstlvs(struct rfc5444_reader_tlvblock_context *context) {
+  struct rfc5444_reader_tlvblock_entry *tlv;
+  struct _hello_address *hello_addr;
+  struct nhdp_domain *domain;
+  uint8_t local_if, link_status, other_neigh;
   struct nhdp_naddr *naddr;
   struct nhdp_laddr *laddr;
+  bool this_if;
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf;
 #endif
 
   local_if = 255;
   link_status = 255;
+  other_neigh = 255;
 
-  if (_nhdp_address_pass1_tlvs[IDX_ADDRTLV1_LOCAL_IF].tlv) {
-    local_if = _nhdp_address_pass1_tlvs[IDX_ADDRTLV1_LOCAL_IF].tlv->single_value[0];
+  /* read values of TLVs that can only be present once */
+  if (_nhdp_address_tlvs[IDX_ADDRTLV_LOCAL_IF].tlv) {
+    local_if = _nhdp_address_tlvs[IDX_ADDRTLV_LOCAL_IF].tlv->single_value[0];
     local_if &= RFC6130_LOCALIF_BITMASK;
   }
-  if (_nhdp_address_pass1_tlvs[IDX_ADDRTLV1_LINK_STATUS].tlv) {
-    link_status = _nhdp_address_pass1_tlvs[IDX_ADDRTLV1_LINK_STATUS].tlv->single_value[0];
+  if (_nhdp_address_tlvs[IDX_ADDRTLV_LINK_STATUS].tlv) {
+    link_status = _nhdp_address_tlvs[IDX_ADDRTLV_LINK_STATUS].tlv->single_value[0];
     link_status &= RFC6130_LINKSTATUS_BITMASK;
   }
+  if (_nhdp_address_tlvs[IDX_ADDRTLV_OTHER_NEIGHB].tlv) {
+    other_neigh = _nhdp_address_tlvs[IDX_ADDRTLV_OTHER_NEIGHB].tlv->single_value[0];
+    other_neigh &= RFC6130_OTHERNEIGHB_SYMMETRIC;
+  }
+
+  OONF_DEBUG(LOG_NHDP_R, "Address %s, local_if %u, link_status: %u, other_neigh: %u",
+    netaddr_to_string(&nbuf, &context->addr), local_if, link_status, other_neigh);
+
+  /* only addresses with link or 2-hop information can be our own */
+  this_if = (link_status != 255 || other_neigh != 255) &&
+            nhdp_interface_addr_if_get(_current.localif, &context->addr) != NULL;
+
+  if (local_if == RFC6130_LOCALIF_THIS_IF || local_if == RFC6130_LOCALIF_OTHER_IF || link_status != 255 ||
+      other_neigh != 255) {
+    /* remember address for database update */
+    hello_addr = _add_hello_address();
+    if (hello_addr == NULL) {
+      return RFC5444_DROP_MESSAGE;
+    }
+
+    memcpy(&hello_addr->addr, &context->addr, sizeof(hello_addr->addr));
+    hello_addr->local_if = local_if;
+    hello_addr->link_status = link_status;
+    hello_addr->other_neigh = other_neigh;
+    hello_addr->this_if = this_if;
+
+    tlv = _nhdp_address_tlvs[IDX_ADDRTLV_MPR].tlv;
+    if (tlv) {
+      hello_addr->mpr = tlv->single_value;
+      hello_addr->mpr_length = tlv->length;
+    }
 
-  OONF_DEBUG(LOG_NHDP_R, "Pass 1: address %s, local_if %u, link_status: %u", netaddr_to_string(&nbuf, &context->addr),
-    local_if, link_status);
+    for (tlv = _nhdp_address_tlvs[IDX_ADDRTLV_LINKMETRIC].tlv; tlv != NULL; tlv = tlv->next_entry) {
+      /* only keep metrics of domains with default handling */
+      domain = nhdp_domain_get_by_ext(tlv->type_ext);
+      if (domain != NULL && !domain->metric->no_default_handling &&
+          hello_addr->metric_count < NHDP_READER_MAX_METRIC_TLVS) {
+        hello_addr->metric_domain[hello_addr->metric_count] = domain;
+        hello_addr->metric[hello_addr->metric_count] = tlv->single_value;
+        hello_addr->metric_count++;
+      }
+    }
+  }
 
   if (context->has_origaddr && !_current.originator_in_addrblk &&
       netaddr_cmp(&context->addr, &context->orig_addr) == 0) {
@@ -591,7 +680,7 @@ _cb_addresstlvs_pass1(struct rfc5444_reader_tlvblock_context *context) {
   }
 
   /* detect if our own node is seen by our neighbor */
-  if (link_status != 255 && nhdp_interface_addr_if_get(_current.localif, &context->addr) != NULL) {
+  if (link_status != 255 && this_if) {
     if (link_status == RFC6130_LINKSTATUS_LOST) {
       OONF_DEBUG(LOG_NHDP_R, "Link neighbor lost this node address: %s", netaddr_to_string(&nbuf, &context->addr));
       _current.link_lost = true;
@@ -602,26 +691,50 @@ _cb_addresstlvs_pass1(struct rfc5444_reader_tlvblock_context *context) {
     }
   }
 
-  /* we do nothing in this pass except for detecting the situation */
+  /* the database is updated at the end of the message */
   return RFC5444_OKAY;
 }
 
 /**
- * Handle end of message for pass1 processing. Create link/neighbor if necessary,
- * mark addresses as potentially lost.
+ * Handle end of message. Update the database with the buffered addresses
+ * of the HELLO and update the status of the link.
  * @param context tlv block reader context
- * @param dropped true if block was dropped by another callback
+ * @param dropped true if context was dropped by a callback
  * @return see rfc5444_result enum
  */
 static enum rfc5444_result
-_cb_addresstlvs_pass1_end(struct rfc5444_reader_tlvblock_context *context, bool dropped) {
-  struct nhdp_naddr *naddr;
-  struct nhdp_laddr *laddr;
+_cb_msg_end(struct rfc5444_reader_tlvblock_context *context, bool dropped) {
+  enum rfc5444_result result = RFC5444_OKAY;
+
+  /* deliver all change events of this HELLO at once */
+  nhdp_db_transaction_start();
 
   if (dropped) {
     _cleanup_error();
-    return RFC5444_OKAY;
   }
+  else if (_process_hello(context) != RFC5444_OKAY) {
+    _cleanup_error();
+    result = RFC5444_DROP_MESSAGE;
+  }
+  else {
+    _finalize_hello(context);
+  }
+
+  nhdp_db_transaction_commit();
+  return result;
+}
+
+/**
+ * Create link/neighbor if necessary, mark addresses as potentially lost
+ * and apply the buffered addresses of the HELLO to the database.
+ * @param context tlv block reader context
+ * @return see rfc5444_result enum
+ */
+static enum rfc5444_result
+_process_hello(struct rfc5444_reader_tlvblock_context *context) {
+  struct nhdp_naddr *naddr;
+  struct nhdp_laddr *laddr;
+  size_t i;
 
   /* handle originator address */
   if (context->has_origaddr && !_current.originator_in_addrblk &&
@@ -679,7 +792,9 @@ _cb_addresstlvs_pass1_end(struct rfc5444_reader_tlvblock_context *context, bool
     }
 
     /* parse as if it would be tagged with a LOCAL_IF = THIS_IF TLV */
-    _pass2_process_localif(&addr, RFC6130_LOCALIF_THIS_IF);
+    if (_process_localif(&addr, RFC6130_LOCALIF_THIS_IF) != RFC5444_OKAY) {
+      return RFC5444_DROP_MESSAGE;
+    }
   }
 
   /* remember vtime and itime */
@@ -712,20 +827,28 @@ _cb_addresstlvs_pass1_end(struct rfc5444_reader_tlvblock_context *context, bool
     }
   }
 
-  OONF_DEBUG(LOG_NHDP_R, "pass1 finished");
+  /* apply addresses in the order of the message */
+  for (i = 0; i < _current.address_count; i++) {
+    if (_process_address(&_addresses[i]) != RFC5444_OKAY) {
+      return RFC5444_DROP_MESSAGE;
+    }
+  }
 
+  OONF_DEBUG(LOG_NHDP_R, "%" PRINTF_SIZE_T_SPECIFIER " addresses processed", _current.address_count);
   return RFC5444_OKAY;
 }
 
 /**
  * Process MPR, Willingness and Linkmetric TLVs for local neighbor
- * @param addr address the TLVs are attached to
+ * @param hello_addr buffered address with its TLVs
  */
 static void
-_process_domainspecific_linkdata(struct netaddr *addr __attribute__((unused))) {
-  struct rfc5444_reader_tlvblock_entry *tlv;
+_process_domainspecific_linkdata(struct _hello_address *hello_addr) {
   struct nhdp_domain *domain;
+  uint8_t i;
   struct nhdp_neighbor_domaindata *neighdata;
+  struct nhdp_link_domaindata *linkdata;
+  uint32_t old_metric_out[NHDP_MAXIMUM_DOMAINS];
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str buf;
 #endif
@@ -735,125 +858,119 @@ _process_domainspecific_linkdata(struct netaddr *addr __attribute__((unused))) {
    */
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
     neighdata = nhdp_domain_get_neighbordata(domain, _current.neighbor);
+    linkdata = nhdp_domain_get_linkdata(domain, _current.link);
 
     neighdata->local_is_mpr = false;
     neighdata->willingness = 0;
-    nhdp_domain_get_linkdata(domain, _current.link)->metric.out = RFC7181_METRIC_INFINITE;
+    old_metric_out[domain->index] = linkdata->metric.out;
+    linkdata->metric.out = RFC7181_METRIC_INFINITE;
     neighdata->metric.out = RFC7181_METRIC_INFINITE;
   }
 
   /* process MPR settings of link */
-  nhdp_domain_process_mpr_tlv(
-    _current.mprtypes, _current.mprtypes_size, _current.link, _nhdp_address_pass2_tlvs[IDX_ADDRTLV2_MPR].tlv);
+  nhdp_domain_process_mpr_value(
+    _current.mprtypes, _current.mprtypes_size, _current.link, hello_addr->mpr, hello_addr->mpr_length);
 
   /* update out metric with other sides in metric */
-  tlv = _nhdp_address_pass2_tlvs[IDX_ADDRTLV2_LINKMETRIC].tlv;
-  while (tlv) {
-    /* get metric handler */
-    domain = nhdp_domain_get_by_ext(tlv->type_ext);
-    if (domain != NULL && !domain->metric->no_default_handling) {
-      nhdp_domain_process_metric_linktlv(domain, _current.link, tlv->single_value);
+  for (i = 0; i < hello_addr->metric_count; i++) {
+    domain = hello_addr->metric_domain[i];
+    nhdp_domain_process_metric_linktlv(domain, _current.link, hello_addr->metric[i]);
 
-      /* extract tlv value */
-      OONF_DEBUG(LOG_NHDP_R, "Pass 2: address %s, LQ (ext %u): %02x%02x", netaddr_to_string(&buf, addr), tlv->type_ext,
-        tlv->single_value[0], tlv->single_value[1]);
-    }
+    OONF_DEBUG(LOG_NHDP_R, "Address %s, LQ (ext %u): %02x%02x", netaddr_to_string(&buf, &hello_addr->addr),
+      domain->ext, hello_addr->metric[i][0], hello_addr->metric[i][1]);
+  }
 
-    tlv = tlv->next_entry;
+  /* outgoing link metric is part of our own HELLO */
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    if (nhdp_domain_get_linkdata(domain, _current.link)->metric.out != old_metric_out[domain->index]) {
+      nhdp_domain_increase_generation();
+      break;
+    }
   }
 }
 
 /**
  * Process Linkmetric TLVs for twohop neighbor
  * @param l2hop pointer to twohop neighbor
- * @param addr address the TLVs are attached to
+ * @param hello_addr buffered address with its TLVs
  */
 static void
-_process_domainspecific_2hopdata(struct nhdp_l2hop *l2hop, struct netaddr *addr __attribute__((unused))) {
-  struct rfc5444_reader_tlvblock_entry *tlv;
+_process_domainspecific_2hopdata(struct nhdp_l2hop *l2hop, struct _hello_address *hello_addr) {
   struct nhdp_domain *domain;
+  uint8_t i;
   struct nhdp_l2hop_domaindata *data;
+  struct nhdp_metric old_metric[NHDP_MAXIMUM_DOMAINS];
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str buf;
 #endif
 
   /* clear metric values that should be present in HELLO */
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    data = nhdp_domain_get_l2hopdata(domain, l2hop);
+    old_metric[domain->index] = data->metric;
     if (!domain->metric->no_default_handling) {
-      data = nhdp_domain_get_l2hopdata(domain, l2hop);
       data->metric.in = RFC7181_METRIC_INFINITE;
       data->metric.out = RFC7181_METRIC_INFINITE;
     }
   }
 
   /* update 2-hop metric (no direction reversal!) */
-  tlv = _nhdp_address_pass2_tlvs[IDX_ADDRTLV2_LINKMETRIC].tlv;
-  while (tlv) {
-    /* get metric handler */
-    domain = nhdp_domain_get_by_ext(tlv->type_ext);
-    if (domain != NULL && !domain->metric->no_default_handling) {
-      nhdp_domain_process_metric_2hoptlv(domain, l2hop, tlv->single_value);
+  for (i = 0; i < hello_addr->metric_count; i++) {
+    domain = hello_addr->metric_domain[i];
+    nhdp_domain_process_metric_2hoptlv(domain, l2hop, hello_addr->metric[i]);
 
-      OONF_DEBUG(LOG_NHDP_R, "Pass 2: address %s, LQ (ext %u): %02x%02x", netaddr_to_string(&buf, addr), tlv->type_ext,
-        tlv->single_value[0], tlv->single_value[1]);
-    }
+    OONF_DEBUG(LOG_NHDP_R, "Address %s, LQ (ext %u): %02x%02x", netaddr_to_string(&buf, &hello_addr->addr),
+      domain->ext, hello_addr->metric[i][0], hello_addr->metric[i][1]);
+  }
 
-    tlv = tlv->next_entry;
+  /* tell listeners about changed two-hop metrics */
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    data = nhdp_domain_get_l2hopdata(domain, l2hop);
+    if (data->metric.in != old_metric[domain->index].in || data->metric.out != old_metric[domain->index].out) {
+      nhdp_db_link_2hop_changed(l2hop);
+      break;
+    }
   }
 }
 
 /**
- * Second pass for processing the addresses of the NHDP Hello. This one will update
- * the database
- * @param context tlv block reader context
+ * Update the database with a buffered address of the NHDP Hello
+ * after link and neighbor of the message have been resolved
+ * @param hello_addr buffered address with its TLVs
  * @return see rfc5444_result enum
  */
 static enum rfc5444_result
-_cb_addr_pass2_block(struct rfc5444_reader_tlvblock_context *context) {
+_process_address(struct _hello_address *hello_addr) {
   uint8_t local_if, link_status, other_neigh;
   struct nhdp_l2hop *l2hop;
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str buf;
 #endif
 
-  local_if = 255;
-  link_status = 255;
-  other_neigh = 255;
-
-  /* read values of TLVs that can only be present once */
-  if (_nhdp_address_pass2_tlvs[IDX_ADDRTLV2_LOCAL_IF].tlv) {
-    local_if = _nhdp_address_pass2_tlvs[IDX_ADDRTLV2_LOCAL_IF].tlv->single_value[0];
-    local_if &= RFC6130_LOCALIF_BITMASK;
-  }
-  if (_nhdp_address_pass2_tlvs[IDX_ADDRTLV2_LINK_STATUS].tlv) {
-    link_status = _nhdp_address_pass2_tlvs[IDX_ADDRTLV2_LINK_STATUS].tlv->single_value[0];
-    link_status &= RFC6130_LINKSTATUS_BITMASK;
-  }
-  if (_nhdp_address_pass2_tlvs[IDX_ADDRTLV2_OTHER_NEIGHB].tlv) {
-    other_neigh = _nhdp_address_pass2_tlvs[IDX_ADDRTLV2_OTHER_NEIGHB].tlv->single_value[0];
-    other_neigh &= RFC6130_OTHERNEIGHB_SYMMETRIC;
-  }
-  OONF_DEBUG(LOG_NHDP_R, "Pass 2: address %s, local_if %u, link_status: %u, other_neigh: %u",
-    netaddr_to_string(&buf, &context->addr), local_if, link_status, other_neigh);
+  local_if = hello_addr->local_if;
+  link_status = hello_addr->link_status;
+  other_neigh = hello_addr->other_neigh;
 
   if (local_if == RFC6130_LOCALIF_THIS_IF || local_if == RFC6130_LOCALIF_OTHER_IF) {
     /* parse LOCAL_IF TLV */
-    _pass2_process_localif(&context->addr, local_if);
+    if (_process_localif(&hello_addr->addr, local_if) != RFC5444_OKAY) {
+      return RFC5444_DROP_MESSAGE;
+    }
   }
 
   /* handle 2hop-addresses */
   if (link_status != 255 || other_neigh != 255) {
-    if (nhdp_interface_addr_if_get(_current.localif, &context->addr) != NULL) {
-      _process_domainspecific_linkdata(&context->addr);
+    if (hello_addr->this_if) {
+      _process_domainspecific_linkdata(hello_addr);
     }
-    else if (nhdp_interface_addr_global_get(&context->addr) != NULL) {
-      OONF_DEBUG(LOG_NHDP_R, "Link neighbor heard this node address: %s", netaddr_to_string(&buf, &context->addr));
+    else if (nhdp_interface_addr_global_get(&hello_addr->addr) != NULL) {
+      OONF_DEBUG(LOG_NHDP_R, "Link neighbor heard this node address: %s", netaddr_to_string(&buf, &hello_addr->addr));
     }
     else if (link_status == RFC6130_LINKSTATUS_SYMMETRIC || other_neigh == RFC6130_OTHERNEIGHB_SYMMETRIC) {
-      l2hop = ndhp_db_link_2hop_get(_current.link, &context->addr);
+      l2hop = ndhp_db_link_2hop_get(_current.link, &hello_addr->addr);
       if (l2hop == NULL) {
         /* create new 2hop address */
-        l2hop = nhdp_db_link_2hop_add(_current.link, &context->addr);
+        l2hop = nhdp_db_link_2hop_add(_current.link, &hello_addr->addr);
         if (l2hop == NULL) {
           return RFC5444_DROP_MESSAGE;
         }
@@ -865,10 +982,10 @@ _cb_addr_pass2_block(struct rfc5444_reader_tlvblock_context *context) {
       /* refresh validity time of 2hop address */
       nhdp_db_link_2hop_set_vtime(l2hop, _current.vtime);
 
-      _process_domainspecific_2hopdata(l2hop, &context->addr);
+      _process_domainspecific_2hopdata(l2hop, hello_addr);
     }
     else {
-      l2hop = ndhp_db_link_2hop_get(_current.link, &context->addr);
+      l2hop = ndhp_db_link_2hop_get(_current.link, &hello_addr->addr);
       if (l2hop) {
         /* remove 2hop address */
         nhdp_db_link_2hop_remove(l2hop);
@@ -882,24 +999,17 @@ _cb_addr_pass2_block(struct rfc5444_reader_tlvblock_context *context) {
 /**
  * Finalize changes of the database and update the status of the link
  * @param context tlv block reader context
- * @param dropped true if context was dropped by a callback
- * @return see rfc5444_result enum
  */
-static enum rfc5444_result
-_cb_msg_pass2_end(struct rfc5444_reader_tlvblock_context *context, bool dropped) {
+static void
+_finalize_hello(struct rfc5444_reader_tlvblock_context *context) {
   struct nhdp_naddr *naddr;
   struct nhdp_laddr *laddr, *la_it;
-  struct nhdp_l2hop *twohop, *twohop_it;
+  struct nhdp_l2hop *twohop;
   uint64_t t;
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf;
 #endif
 
-  if (dropped) {
-    _cleanup_error();
-    return RFC5444_OKAY;
-  }
-
   /* remove leftover link addresses */
   avl_for_each_element_safe(&_current.link->_addresses, laddr, _link_node, la_it) {
     if (laddr->_might_be_removed) {
@@ -913,16 +1023,9 @@ _cb_msg_pass2_end(struct rfc5444_reader_tlvblock_context *context, bool dropped)
       /* mark as lost */
       nhdp_db_neighbor_addr_set_lost(naddr, _current.localif->n_hold_time);
 
-      /* section 12.6.1: remove all similar n2 addresses */
-      // TODO: not nice, replace with new iteration macro
-      twohop_it = avl_find_element(&_current.link->_2hop, &naddr->neigh_addr, twohop_it, _link_node);
-      while (twohop_it) {
-        twohop = twohop_it;
-        twohop_it = avl_next_element_safe(&_current.link->_2hop, twohop_it, _link_node);
-        if (twohop_it != NULL && !twohop_it->_link_node.follower) {
-          twohop_it = NULL;
-        }
-
+      /* section 12.6.1: remove similar n2 address (the link 2hop set has no duplicates) */
+      twohop = ndhp_db_link_2hop_get(_current.link, &naddr->neigh_addr);
+      if (twohop) {
         nhdp_db_link_2hop_remove(twohop);
       }
     }
@@ -983,8 +1086,6 @@ _cb_msg_pass2_end(struct rfc5444_reader_tlvblock_context *context, bool dropped)
   nhdp_db_link_update_status(_current.link);
 
   /* update link metrics and MPR */
-  nhdp_domain_recalculate_metrics(NULL, _current.neighbor);
+  nhdp_db_neighbor_update_metrics(_current.neighbor);
   nhdp_domain_delayed_mpr_recalculation(NULL, _current.neighbor);
-
-  return RFC5444_OKAY;
 }
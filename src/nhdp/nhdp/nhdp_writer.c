@@ -43,6 +43,8 @@
  * @file
  */
 
+#include <stdlib.h>
+
 #include <oonf/libcommon/avl.h>
 #include <oonf/libcommon/avl_comp.h>
 #include <oonf/oonf.h>
@@ -69,6 +71,16 @@ static int _cb_addMessageHeader(struct rfc5444_writer *, struct rfc5444_writer_m
 static void _cb_addMessageTLVs(struct rfc5444_writer *);
 static void _cb_addAddresses(struct rfc5444_writer *);
 
+static void _send_hello(
+  struct nhdp_interface *ninterf, struct oonf_rfc5444_target *target, struct nhdp_interface_hello_cache *cache);
+static bool _is_hello_cachable(void);
+static bool _is_cache_valid(struct nhdp_interface *ninterf, struct nhdp_interface_hello_cache *cache);
+static enum rfc5444_result _send_cached_hello(
+  struct oonf_rfc5444_target *target, struct nhdp_interface_hello_cache *cache);
+static bool _cb_is_hello(struct rfc5444_writer_postprocessor *processor, int msg_type);
+static int _cb_cache_hello(struct rfc5444_writer_postprocessor *processor, struct rfc5444_writer_target *target,
+  struct rfc5444_writer_message *msg, uint8_t *data, size_t *length);
+
 static void _add_link_address(struct rfc5444_writer *writer, struct rfc5444_writer_content_provider *prv,
   struct nhdp_interface *interf, struct nhdp_naddr *naddr);
 static void _add_localif_address(struct rfc5444_writer *writer, struct rfc5444_writer_content_provider *prv,
@@ -93,8 +105,21 @@ static struct rfc5444_writer_tlvtype _nhdp_addrtlvs[] = {
   [IDX_ADDRTLV_MPR] = { .type = RFC7181_ADDRTLV_MPR },
 };
 
+/* post-processor that copies the final HELLO into the interface cache */
+static struct rfc5444_writer_postprocessor _hello_cache_processor = {
+  .priority = INT32_MAX,
+  .target_specific = true,
+  .is_matching_signature = _cb_is_hello,
+  .process = _cb_cache_hello,
+};
+
 static struct oonf_rfc5444_protocol *_protocol;
 
+/* cache and target for the HELLO that is currently generated */
+static struct nhdp_interface_hello_cache *_capture_cache = NULL;
+static struct oonf_rfc5444_target *_capture_target = NULL;
+static bool _capture_failed = false;
+
 static bool _cleanedup = false;
 static bool _add_mac_tlv = true;
 static struct nhdp_interface *_nhdp_if = NULL;
@@ -122,6 +147,8 @@ nhdp_writer_init(struct oonf_rfc5444_protocol *p) {
     rfc5444_writer_unregister_message(&_protocol->writer, _nhdp_message);
     return -1;
   }
+
+  rfc5444_writer_register_postprocessor(&_protocol->writer, &_hello_cache_processor);
   return 0;
 }
 
@@ -134,6 +161,7 @@ nhdp_writer_cleanup(void) {
   _cleanedup = true;
 
   /* remove pbb writer */
+  rfc5444_writer_unregister_postprocessor(&_protocol->writer, &_hello_cache_processor);
   rfc5444_writer_unregister_content_provider(
     &_protocol->writer, &_nhdp_msgcontent_provider, _nhdp_addrtlvs, ARRAYSIZE(_nhdp_addrtlvs));
   rfc5444_writer_unregister_message(&_protocol->writer, _nhdp_message);
@@ -146,9 +174,7 @@ nhdp_writer_cleanup(void) {
  */
 void
 nhdp_writer_send_hello(struct nhdp_interface *ninterf) {
-  enum rfc5444_result result;
   struct os_interface_listener *interf;
-  struct netaddr_str buf;
 
   if (_cleanedup) {
     /* do not send more Hellos during shutdown */
@@ -169,17 +195,23 @@ nhdp_writer_send_hello(struct nhdp_interface *ninterf) {
   _nhdp_if = ninterf;
 
   /* send IPv4 (if socket is active) */
-  result = oonf_rfc5444_send_if(ninterf->rfc5444_if.interface->multicast4, RFC6130_MSGTYPE_HELLO);
-  if (result < 0) {
-    OONF_WARN(LOG_NHDP_W, "Could not send NHDP message to %s: %s (%d)",
-      netaddr_to_string(&buf, &ninterf->rfc5444_if.interface->multicast4->dst), rfc5444_strerror(result), result);
-  }
+  _send_hello(ninterf, ninterf->rfc5444_if.interface->multicast4, &ninterf->_hello_cache[0]);
 
   /* send IPV6 (if socket is active) */
-  result = oonf_rfc5444_send_if(ninterf->rfc5444_if.interface->multicast6, RFC6130_MSGTYPE_HELLO);
-  if (result < 0) {
-    OONF_WARN(LOG_NHDP_W, "Could not send NHDP message to %s: %s (%d)",
-      netaddr_to_string(&buf, &ninterf->rfc5444_if.interface->multicast6->dst), rfc5444_strerror(result), result);
+  _send_hello(ninterf, ninterf->rfc5444_if.interface->multicast6, &ninterf->_hello_cache[1]);
+}
+
+/**
+ * Free the cached HELLOs of a NHDP interface
+ * @param ninterf NHDP interface
+ */
+void
+nhdp_writer_clear_hello_cache(struct nhdp_interface *ninterf) {
+  size_t i;
+
+  for (i = 0; i < ARRAYSIZE(ninterf->_hello_cache); i++) {
+    free(ninterf->_hello_cache[i].buffer);
+    memset(&ninterf->_hello_cache[i], 0, sizeof(ninterf->_hello_cache[i]));
   }
 }
 
@@ -189,9 +221,177 @@ nhdp_writer_send_hello(struct nhdp_interface *ninterf) {
  */
 void
 nhdp_writer_set_mac_TLV_state(bool active) {
+  if (_add_mac_tlv != active) {
+    nhdp_db_increase_generation();
+  }
   _add_mac_tlv = active;
 }
 
+/**
+ * Send a HELLO through a target of a NHDP interface, either by
+ * generating it or by using the cached binary HELLO if the NHDP
+ * database did not change since it was generated.
+ * @param ninterf NHDP interface
+ * @param target rfc5444 target of interface
+ * @param cache HELLO cache for the address family of the target
+ */
+static void
+_send_hello(
+  struct nhdp_interface *ninterf, struct oonf_rfc5444_target *target, struct nhdp_interface_hello_cache *cache) {
+  enum rfc5444_result result;
+  struct netaddr_str buf;
+
+  if (!ninterf->hello_cache || !_is_hello_cachable()) {
+    /* generate HELLO without caching it */
+    cache->valid = false;
+    result = oonf_rfc5444_send_if(target, RFC6130_MSGTYPE_HELLO);
+  }
+  else if (_is_cache_valid(ninterf, cache)) {
+    OONF_DEBUG(LOG_NHDP_W, "Use cached Hello for %s", netaddr_to_string(&buf, &target->dst));
+    result = _send_cached_hello(target, cache);
+  }
+  else {
+    OONF_DEBUG(LOG_NHDP_W, "Generate and cache Hello for %s", netaddr_to_string(&buf, &target->dst));
+
+    /* remember state of database the HELLO is based on */
+    cache->length = 0;
+    cache->db_generation = nhdp_db_get_generation();
+    cache->domain_generation = nhdp_domain_get_generation();
+    memcpy(&cache->mac, &nhdp_interface_get_if_listener(ninterf)->data->mac, sizeof(cache->mac));
+
+    /* let the post-processor copy the generated HELLO into the cache */
+    _capture_cache = cache;
+    _capture_target = target;
+    _capture_failed = false;
+
+    result = oonf_rfc5444_send_if(target, RFC6130_MSGTYPE_HELLO);
+
+    cache->valid = result == RFC5444_OKAY && !_capture_failed && cache->length > 0;
+    _capture_cache = NULL;
+    _capture_target = NULL;
+  }
+
+  if (result < 0) {
+    OONF_WARN(LOG_NHDP_W, "Could not send NHDP message to %s: %s (%d)", netaddr_to_string(&buf, &target->dst),
+      rfc5444_strerror(result), result);
+  }
+}
+
+/**
+ * Check if the HELLO is completely generated by the NHDP writer and
+ * not modified by a post-processor, so its binary form can be reused.
+ * @return true if HELLO can be cached
+ */
+static bool
+_is_hello_cachable(void) {
+  struct rfc5444_writer_postprocessor *processor;
+
+  if (_nhdp_message->_provider_tree.count > 1) {
+    /* other content providers might add data to the HELLO */
+    return false;
+  }
+
+  avl_for_each_element(&_protocol->writer._processors, processor, _node) {
+    if (processor != &_hello_cache_processor && processor->is_matching_signature(processor, RFC6130_MSGTYPE_HELLO)) {
+      /* post-processed HELLOs (e.g. signed ones) must be generated again */
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Check if a cached HELLO still represents the current database
+ * @param ninterf NHDP interface
+ * @param cache HELLO cache
+ * @return true if cached HELLO can be sent
+ */
+static bool
+_is_cache_valid(struct nhdp_interface *ninterf, struct nhdp_interface_hello_cache *cache) {
+  return cache->valid && cache->db_generation == nhdp_db_get_generation() &&
+         cache->domain_generation == nhdp_domain_get_generation() &&
+         netaddr_cmp(&cache->mac, &nhdp_interface_get_if_listener(ninterf)->data->mac) == 0;
+}
+
+/**
+ * Send the binary message(s) of a cached HELLO through a target
+ * @param target rfc5444 target
+ * @param cache HELLO cache
+ * @return return code of rfc5444 writer
+ */
+static enum rfc5444_result
+_send_cached_hello(struct oonf_rfc5444_target *target, struct nhdp_interface_hello_cache *cache) {
+  enum rfc5444_result result;
+  size_t offset, len;
+
+  /* a HELLO might have been fragmented into multiple messages */
+  for (offset = 0; offset + 4 <= cache->length; offset += len) {
+    len = ((size_t)cache->buffer[offset + 2] << 8) | cache->buffer[offset + 3];
+    if (len < 4 || offset + len > cache->length) {
+      /* should not happen, generate a new HELLO next time */
+      cache->valid = false;
+      return RFC5444_OKAY;
+    }
+
+    result = oonf_rfc5444_send_if_binary(target, &cache->buffer[offset], len);
+    if (result != RFC5444_OKAY) {
+      cache->valid = false;
+      return result;
+    }
+  }
+  return RFC5444_OKAY;
+}
+
+/**
+ * Callback for post-processor to check if a message is a HELLO
+ * @param processor rfc5444 post-processor
+ * @param msg_type rfc5444 message type
+ * @return true if message is a HELLO
+ */
+static bool
+_cb_is_hello(struct rfc5444_writer_postprocessor *processor __attribute__((unused)), int msg_type) {
+  return msg_type == RFC6130_MSGTYPE_HELLO;
+}
+
+/**
+ * Callback for post-processor to copy a generated HELLO into
+ * the cache of the interface. The message itself is not modified.
+ * @param processor rfc5444 post-processor
+ * @param target rfc5444 target
+ * @param msg rfc5444 message
+ * @param data pointer to binary message
+ * @param length pointer to length of binary message
+ * @return always 0
+ */
+static int
+_cb_cache_hello(struct rfc5444_writer_postprocessor *processor __attribute__((unused)),
+  struct rfc5444_writer_target *target, struct rfc5444_writer_message *msg __attribute__((unused)), uint8_t *data,
+  size_t *length) {
+  uint8_t *ptr;
+  size_t size;
+
+  if (_capture_cache == NULL || _capture_failed ||
+      oonf_rfc5444_get_target_from_rfc5444_target(target) != _capture_target) {
+    return 0;
+  }
+
+  size = _capture_cache->length + *length;
+  if (size > _capture_cache->size) {
+    ptr = realloc(_capture_cache->buffer, size);
+    if (ptr == NULL) {
+      OONF_WARN(LOG_NHDP_W, "Out of memory for Hello cache");
+      _capture_failed = true;
+      return 0;
+    }
+    _capture_cache->buffer = ptr;
+    _capture_cache->size = size;
+  }
+
+  memcpy(&_capture_cache->buffer[_capture_cache->length], data, *length);
+  _capture_cache->length = size;
+  return 0;
+}
+
 /**
  * Callback to initialize the message header for a HELLO message
  * @param writer RFC5444 writer instance
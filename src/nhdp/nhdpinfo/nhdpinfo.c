@@ -88,6 +88,7 @@ static int _cb_create_text_link_address(struct oonf_viewer_template *);
 static int _cb_create_text_link_twohop(struct oonf_viewer_template *);
 static int _cb_create_text_neighbor(struct oonf_viewer_template *);
 static int _cb_create_text_neighbor_address(struct oonf_viewer_template *);
+static int _cb_create_text_domain(struct oonf_viewer_template *);
 
 /*
  * list of template keys and corresponding buffers for values.
@@ -227,6 +228,9 @@ static int _cb_create_text_neighbor_address(struct oonf_viewer_template *);
 /*! template key for routing willingness */
 #define KEY_DOMAIN_MPR_WILL "domain_mpr_willingness"
 
+/*! template key for number of suppressed incoming metric changes */
+#define KEY_DOMAIN_METRIC_SUPPRESSED "domain_metric_suppressed"
+
 /*
  * buffer space for values that will be assembled
  * into the output of the plugin
@@ -280,6 +284,7 @@ static char _value_domain_mpr[NHDP_DOMAIN_MPR_MAXLEN];
 static char _value_domain_mpr_local[TEMPLATE_JSON_BOOL_LENGTH];
 static char _value_domain_mpr_remote[TEMPLATE_JSON_BOOL_LENGTH];
 static char _value_domain_mpr_will[3];
+static char _value_domain_metric_suppressed[21];
 
 /* definition of the template data entries for JSON and table output */
 static struct abuf_template_data_entry _tde_if_key[] = {
@@ -346,6 +351,12 @@ static struct abuf_template_data_entry _tde_domain_mpr[] = {
   { KEY_DOMAIN_MPR_WILL, _value_domain_mpr_will, false },
 };
 
+static struct abuf_template_data_entry _tde_domain_info[] = {
+  { KEY_DOMAIN_METRIC, _value_domain_metric, true },
+  { KEY_DOMAIN_MPR, _value_domain_mpr, true },
+  { KEY_DOMAIN_METRIC_SUPPRESSED, _value_domain_metric_suppressed, false },
+};
+
 static struct abuf_template_data_entry _tde_link_addr[] = {
   { KEY_LINK_ADDRESS, _value_link_address.buf, true },
 };
@@ -411,6 +422,10 @@ static struct abuf_template_data _td_neigh_addr[] = {
   { _tde_neigh_key, ARRAYSIZE(_tde_neigh_key) },
   { _tde_neigh_addr, ARRAYSIZE(_tde_neigh_addr) },
 };
+static struct abuf_template_data _td_domain[] = {
+  { _tde_domain, ARRAYSIZE(_tde_domain) },
+  { _tde_domain_info, ARRAYSIZE(_tde_domain_info) },
+};
 
 /* OONF viewer templates (based on Template Data arrays) */
 static struct oonf_viewer_template _templates[] = { {
@@ -454,6 +469,12 @@ static struct oonf_viewer_template _templates[] = { {
     .data_size = ARRAYSIZE(_td_neigh_addr),
     .json_name = "neighbor_addr",
     .cb_function = _cb_create_text_neighbor_address,
+  },
+  {
+    .data = _td_domain,
+    .data_size = ARRAYSIZE(_td_domain),
+    .json_name = "domain",
+    .cb_function = _cb_create_text_domain,
   } };
 
 /* telnet command of this plugin */
@@ -663,7 +684,7 @@ _initialize_nhdp_link_twohop_values(struct nhdp_l2hop *twohop) {
 
   strscpy(_value_twohop_sameif, json_getbool(twohop->same_interface), sizeof(_value_twohop_sameif));
 
-  oonf_clock_toIntervalString(&_value_twohop_vtime, oonf_timer_get_due(&twohop->_vtime));
+  oonf_clock_toIntervalString(&_value_twohop_vtime, nhdp_db_link_2hop_get_vtime(twohop));
 }
 
 /**
@@ -692,10 +713,10 @@ static void
 _initialize_nhdp_neighbor_address_values(struct nhdp_naddr *naddr) {
   netaddr_to_string(&_value_neighbor_address, &naddr->neigh_addr);
 
-  strscpy(_value_neighbor_address_lost, json_getbool(oonf_timer_is_active(&naddr->_lost_vtime)),
+  strscpy(_value_neighbor_address_lost, json_getbool(nhdp_db_neighbor_addr_is_lost(naddr)),
     sizeof(_value_neighbor_address_lost));
 
-  oonf_clock_toIntervalString(&_value_neighbor_address_lost_vtime, oonf_timer_get_due(&naddr->_lost_vtime));
+  oonf_clock_toIntervalString(&_value_neighbor_address_lost_vtime, nhdp_db_neighbor_addr_get_lost_vtime(naddr));
 }
 
 /**
@@ -887,3 +908,25 @@ _cb_create_text_neighbor_address(struct oonf_viewer_template *template) {
   }
   return 0;
 }
+
+/**
+ * Displays the NHDP domains and their metric statistics.
+ * @param template oonf viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_domain(struct oonf_viewer_template *template) {
+  struct nhdp_domain *domain;
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    snprintf(_value_domain, sizeof(_value_domain), "%u", domain->ext);
+    strscpy(_value_domain_metric, domain->metric->name, sizeof(_value_domain_metric));
+    strscpy(_value_domain_mpr, domain->mpr->name, sizeof(_value_domain_mpr));
+    snprintf(_value_domain_metric_suppressed, sizeof(_value_domain_metric_suppressed), "%" PRIu64,
+      domain->metric_suppressed_count);
+
+    /* generate template output */
+    oonf_viewer_output_print_line(template);
+  }
+  return 0;
+}
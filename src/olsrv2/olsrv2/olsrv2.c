@@ -121,6 +121,12 @@ struct _config {
 
   /*! IP filter for valid originator */
   struct netaddr_acl originator_acl;
+
+  /*! time between two audits of the kernel routing table */
+  uint64_t routing_audit_interval;
+
+  /*! time routes of a previous instance are kept during startup */
+  uint64_t warm_restart_hold;
 };
 
 /**
@@ -165,6 +171,28 @@ static struct cfg_schema_entry _rt_domain_entries[] = {
     olsrv2_routing_domain, distance, "distance", "2", "Metric Distance to be used in routing table", 0, 1, 255),
   CFG_MAP_BOOL(
     olsrv2_routing_domain, source_specific, "source_specific", "true", "This domain uses IPv6 source specific routing"),
+  CFG_MAP_BOOL(olsrv2_routing_domain, dampening, "route_dampening", "false",
+    "Suppress oscillating next-hop changes of routes"),
+  CFG_MAP_INT32_MINMAX(olsrv2_routing_domain, dampening_penalty, "dampening_penalty", "1000",
+    "Penalty added to a route for each next-hop change", 0, 1, 65535),
+  CFG_MAP_INT32_MINMAX(olsrv2_routing_domain, dampening_suppress, "dampening_suppress", "3000",
+    "Penalty above which next-hop changes of a route are suppressed", 0, 1, 1000000),
+  CFG_MAP_INT32_MINMAX(olsrv2_routing_domain, dampening_reuse, "dampening_reuse", "750",
+    "Penalty below which a suppressed route can change its next-hop again", 0, 1, 1000000),
+  CFG_MAP_CLOCK_MIN(olsrv2_routing_domain, dampening_half_life, "dampening_half_life", "15.0",
+    "Time until the dampening penalty of a route is halved", 1000),
+  CFG_MAP_INT32_MINMAX(olsrv2_routing_domain, ecmp_max_paths, "ecmp_max_paths", "1",
+    "Maximum number of next hops of a multipath route, 1 disables equal-cost multipath routing", 0, 1,
+    OS_ROUTE_MAX_NEXTHOPS),
+  CFG_MAP_INT32_MINMAX(olsrv2_routing_domain, ecmp_tolerance, "ecmp_tolerance", "0",
+    "Maximum path cost difference between the best path and an alternative path of a multipath route", 0, 0,
+    RFC7181_METRIC_MAX),
+  CFG_MAP_CLOCK(olsrv2_routing_domain, spf_initial_delay, "spf_initial_delay", "0.010",
+    "Time between the first topology change and the dijkstra run in a stable network"),
+  CFG_MAP_CLOCK_MIN(olsrv2_routing_domain, spf_hold, "spf_hold", "0.5",
+    "Minimum time between two dijkstra runs, doubled for each run during continuous topology changes", 1),
+  CFG_MAP_CLOCK_MIN(olsrv2_routing_domain, spf_max_wait, "spf_max_wait", "5.0",
+    "Maximum time between two dijkstra runs during continuous topology changes", 1),
 };
 
 static struct cfg_schema_section _rt_domain_section = {
@@ -194,6 +222,13 @@ static struct cfg_schema_entry _olsrv2_entries[] = {
     "Filter for router originator addresses (ipv4 and ipv6)"
     " from the interface addresses. Olsrv2 will prefer routable addresses"
     " over linklocal addresses and addresses from loopback over other interfaces."),
+  CFG_MAP_CLOCK(_config, routing_audit_interval, "routing_audit_interval", "0",
+    "Time between two comparisons of the kernel routing table with the calculated routes,"
+    " 0 to only compare them during startup."),
+  CFG_MAP_CLOCK(_config, warm_restart_hold, "warm_restart_hold", "0",
+    "Time the routes of a previous instance are kept in the kernel during startup."
+    " If not 0, routes are also kept in the kernel during shutdown. The default 0 removes all routes on"
+    " shutdown, so a stopped daemon does not leave stale routes in the kernel."),
 };
 
 static struct cfg_schema_section _olsrv2_section = {
@@ -704,6 +739,8 @@ _cb_cfg_olsrv2_changed(void) {
     oonf_timer_set(&_tc_timer, _olsrv2_config.tc_interval);
   }
 
+  olsrv2_routing_set_kernel_audit(_olsrv2_config.routing_audit_interval, _olsrv2_config.warm_restart_hold);
+
   /* check if we have to change the originators */
   _update_originator(AF_INET);
   _update_originator(AF_INET6);
@@ -133,7 +133,7 @@ olsrv2_lan_add(struct nhdp_domain *domain, const struct os_route_key *prefix, ui
   lan_data->outgoing_metric = metric;
   lan_data->distance = distance;
   lan_data->active = true;
-  olsrv2_routing_domain_changed(domain, true);
+  olsrv2_routing_domain_changed_ext(domain, true, OLSRV2_ROUTING_CAUSE_LAN);
 
   tmp_dist = 0;
   entry->same_distance = true;
@@ -172,7 +172,7 @@ olsrv2_lan_remove(struct nhdp_domain *domain, const struct os_route_key *prefix)
 
   lan_data = olsrv2_lan_get_domaindata(domain, entry);
   lan_data->active = false;
-  olsrv2_routing_domain_changed(domain, true);
+  olsrv2_routing_domain_changed_ext(domain, true, OLSRV2_ROUTING_CAUSE_LAN);
 
   for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
     if (entry->_domaindata[i].active) {
@@ -53,8 +53,10 @@
 #include <oonf/libcore/oonf_logging.h>
 #include <oonf/libcore/os_core.h>
 #include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
 #include <oonf/base/oonf_rfc5444.h>
 #include <oonf/base/oonf_timer.h>
+#include <oonf/base/os_clock.h>
 #include <oonf/base/os_routing.h>
 
 #include <oonf/nhdp/nhdp/nhdp_db.h>
@@ -68,13 +70,52 @@
 #include <oonf/olsrv2/olsrv2/olsrv2_routing.h>
 #include <oonf/olsrv2/olsrv2/olsrv2_tc.h>
 
+/**
+ * scheduling state of the dijkstra algorithm of a domain
+ */
+struct _dijkstra_schedule {
+  /*! timer for the next dijkstra run */
+  struct oonf_timer_instance timer;
+
+  /*! domain of the schedule */
+  struct nhdp_domain *domain;
+
+  /*! current minimum time between two dijkstra runs */
+  uint64_t hold;
+
+  /*! timestamp of the last dijkstra run */
+  uint64_t last_run;
+
+  /*! timestamp of the first trigger since the last dijkstra run */
+  uint64_t first_trigger;
+
+  /*! bitmask of causes since the last dijkstra run */
+  uint32_t causes;
+};
+
 /* Prototypes */
+static void _schedule_dijkstra(struct nhdp_domain *domain);
+static void _update_domain_routes(struct nhdp_domain *domain);
 static void _run_dijkstra(struct nhdp_domain *domain, int af_family, bool use_non_ss, bool use_ss);
 static struct olsrv2_routing_entry *_add_entry(struct nhdp_domain *, struct os_route_key *prefix);
 static void _remove_entry(struct olsrv2_routing_entry *);
-static void _insert_into_working_tree(struct olsrv2_tc_target *target, struct nhdp_neighbor *neigh, uint32_t linkcost,
-  uint32_t path_cost, uint8_t path_hops, uint8_t distance, bool single_hop, const struct netaddr *last_originator);
+static void _insert_into_working_tree(struct nhdp_domain *domain, struct olsrv2_tc_target *target,
+  struct nhdp_neighbor *neigh, uint32_t first_hop_cost, uint32_t linkcost, uint32_t path_cost, uint8_t path_hops,
+  uint8_t distance, bool single_hop, const struct netaddr *last_originator);
+static void _insert_ecmp_into_working_tree(struct nhdp_domain *domain, struct olsrv2_tc_target *target,
+  const struct olsrv2_dijkstra_node *predecessor, uint32_t linkcost);
+static bool _is_ecmp_candidate(struct nhdp_domain *domain, uint32_t best_cost, uint32_t link_cost, uint32_t path_cost);
+static void _add_ecmp_nexthop(struct nhdp_domain *domain, struct olsrv2_dijkstra_node *node,
+  struct nhdp_neighbor *neigh, uint32_t link_cost, uint32_t path_cost);
+static void _filter_ecmp_nexthops(struct nhdp_domain *domain, struct olsrv2_dijkstra_node *node);
+static void _update_multipath(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry,
+  struct nhdp_neighbor *first_hop, const struct olsrv2_dijkstra_node *ecmp);
+static void _add_multipath_links(
+  struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry, struct nhdp_neighbor *neigh);
+static void _add_multipath_link(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry,
+  struct nhdp_neighbor_domaindata *neighdata, struct nhdp_link *lnk);
 static void _prepare_routes(struct nhdp_domain *);
+static void _restore_routing_entry(struct olsrv2_routing_entry *rtentry);
 static void _prepare_nodes(void);
 static bool _check_ssnode_split(struct nhdp_domain *domain, int af_family);
 static void _add_one_hop_nodes(struct nhdp_domain *domain, int family, bool, bool);
@@ -83,16 +124,45 @@ static void _handle_nhdp_routes(struct nhdp_domain *);
 static void _add_route_to_kernel_queue(struct olsrv2_routing_entry *rtentry);
 static void _process_dijkstra_result(struct nhdp_domain *);
 static void _process_kernel_queue(void);
+static void _process_kernel_queue_list(struct list_entity *queue);
+
+static bool _is_nexthop_change(struct olsrv2_routing_entry *rtentry);
+static bool _dampen_nexthop_change(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry);
+static void _update_route_penalty(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry);
+static bool _is_old_nexthop_usable(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry);
+static void _schedule_dampening_reuse(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry);
+static void _repair_kernel_routes(void);
+static bool _is_kernel_route_equal(const struct os_route_parameter *route, const struct os_route_parameter *kernel);
 
 static void _cb_mpr_update(struct nhdp_domain *);
 static void _cb_metric_update(struct nhdp_domain *);
 static void _cb_trigger_dijkstra(struct oonf_timer_instance *);
+static void _cb_dampening_reuse(struct oonf_timer_instance *);
+static void _cb_kernel_audit(struct oonf_timer_instance *);
+static void _cb_warm_restart_finished(struct oonf_timer_instance *);
+static void _cb_kernel_query(struct os_route *filter, struct os_route *route);
+static void _cb_kernel_query_finished(struct os_route *route, int error);
 
 static void _cb_route_finished(struct os_route *route, int error);
 
+/*! maximum route penalty as a multiple of the suppress threshold */
+enum
+{
+  DAMPENING_MAX_PENALTY_FACTOR = 4
+};
+
+/*! minimal hold time between two dijkstra runs in milliseconds */
+enum
+{
+  DIJKSTRA_MIN_HOLD = 1
+};
+
 /* Domain parameter of dijkstra algorithm */
 static struct olsrv2_routing_domain _domain_parameter[NHDP_MAXIMUM_DOMAINS];
 
+/* Domain statistics of routing set */
+static struct olsrv2_routing_statistics _domain_statistics[NHDP_MAXIMUM_DOMAINS];
+
 /* memory class for routing entries */
 static struct oonf_class _rtset_entry = {
   .name = "Olsrv2 Routing Set Entry",
@@ -105,9 +175,51 @@ static struct oonf_timer_class _dijkstra_timer_info = {
   .callback = _cb_trigger_dijkstra,
 };
 
-static struct oonf_timer_instance _rate_limit_timer = { .class = &_dijkstra_timer_info };
+static struct _dijkstra_schedule _dijkstra_schedule[NHDP_MAXIMUM_DOMAINS];
+
+/* names of dijkstra causes */
+static const char *_cause_names[OLSRV2_ROUTING_CAUSE_COUNT] = {
+  "topology",
+  "lan",
+  "mpr",
+  "metric",
+  "config",
+  "kernel",
+  "dampening",
+  "external",
+};
+
+/* timer to release routes suppressed by route dampening */
+static struct oonf_timer_class _dampening_timer_info = {
+  .name = "Route dampening reuse timer",
+  .callback = _cb_dampening_reuse,
+};
+
+static struct oonf_timer_instance _dampening_timer = { .class = &_dampening_timer_info };
+
+/* timer for comparing the kernel routing table with the routing set */
+static struct oonf_timer_class _audit_timer_info = {
+  .name = "Kernel route audit timer",
+  .callback = _cb_kernel_audit,
+};
 
-static bool _trigger_dijkstra = false;
+static struct oonf_timer_instance _audit_timer = { .class = &_audit_timer_info };
+
+/* timer to keep routes of a previous instance until the topology is known again */
+static struct oonf_timer_class _warm_restart_timer_info = {
+  .name = "Kernel route warm restart timer",
+  .callback = _cb_warm_restart_finished,
+};
+
+static struct oonf_timer_instance _warm_restart_timer = { .class = &_warm_restart_timer_info };
+
+/* wildcard query to dump the kernel routing table */
+static struct os_route _kernel_query;
+
+/* kernel audit settings */
+static uint64_t _audit_interval;
+static uint64_t _warm_restart_hold;
+static bool _audit_started = false;
 
 /* callback for NHDP domain events */
 static struct nhdp_domain_listener _nhdp_listener = {
@@ -117,7 +229,6 @@ static struct nhdp_domain_listener _nhdp_listener = {
 
 /* status variables for domain changes */
 static uint16_t _ansn;
-static bool _domain_changed[NHDP_MAXIMUM_DOMAINS];
 static bool _update_ansn;
 
 /* global datastructures for routing */
@@ -126,6 +237,7 @@ static struct list_entity _routing_filter_list;
 
 static struct avl_tree _dijkstra_working_tree;
 static struct list_entity _kernel_queue;
+static struct list_entity _kernel_remove_queue;
 
 static bool _initiate_shutdown = false;
 static bool _freeze_routes = false;
@@ -143,19 +255,32 @@ olsrv2_routing_init(void) {
   }
 
   nhdp_domain_listener_add(&_nhdp_listener);
-  memset(_domain_changed, 0, sizeof(_domain_changed));
   _update_ansn = false;
 
   oonf_class_add(&_rtset_entry);
   oonf_timer_add(&_dijkstra_timer_info);
+  oonf_timer_add(&_dampening_timer_info);
+  oonf_timer_add(&_audit_timer_info);
+  oonf_timer_add(&_warm_restart_timer_info);
 
+  memset(_dijkstra_schedule, 0, sizeof(_dijkstra_schedule));
   for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
     avl_init(&_routing_tree[i], os_routing_avl_cmp_route_key, false);
+    _dijkstra_schedule[i].timer.class = &_dijkstra_timer_info;
   }
   list_init_head(&_routing_filter_list);
   avl_init(&_dijkstra_working_tree, avl_comp_uint32, true);
   list_init_head(&_kernel_queue);
+  list_init_head(&_kernel_remove_queue);
 
+  /* initialize kernel routing table dump */
+  os_routing_init_wildcard_route(&_kernel_query);
+  _kernel_query.cb_get = _cb_kernel_query;
+  _kernel_query.cb_finished = _cb_kernel_query_finished;
+  _kernel_query.p.type = OS_ROUTE_UNICAST;
+
+  /* compare kernel routes with routing set as soon as the configuration is applied */
+  oonf_timer_set(&_audit_timer, 1);
   return 0;
 }
 
@@ -171,6 +296,14 @@ olsrv2_routing_initiate_shutdown(void) {
   _initiate_shutdown = true;
   _freeze_routes = false;
 
+  /* stop kernel audit */
+  oonf_timer_stop(&_audit_timer);
+  os_routing_interrupt(&_kernel_query);
+
+  if (_warm_restart_hold > 0) {
+    OONF_INFO(LOG_OLSRV2_ROUTING, "Keep routes in kernel for warm restart");
+  }
+
   /* remove all routes */
   for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
     avl_for_each_element_safe(&_routing_tree[i], entry, _node, e_it) {
@@ -179,7 +312,7 @@ olsrv2_routing_initiate_shutdown(void) {
       os_routing_interrupt(&entry->route);
       entry->route.cb_finished = _cb_route_finished;
 
-      if (entry->set) {
+      if (entry->set && _warm_restart_hold == 0) {
         entry->set = false;
         _add_route_to_kernel_queue(entry);
       }
@@ -199,9 +332,13 @@ olsrv2_routing_cleanup(void) {
   int i;
 
   nhdp_domain_listener_remove(&_nhdp_listener);
-  oonf_timer_stop(&_rate_limit_timer);
+  oonf_timer_stop(&_dampening_timer);
+  oonf_timer_stop(&_audit_timer);
+  oonf_timer_stop(&_warm_restart_timer);
 
   for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    oonf_timer_stop(&_dijkstra_schedule[i].timer);
+
     avl_for_each_element_safe(&_routing_tree[i], entry, _node, e_it) {
       /* remove entry from database */
       _remove_entry(entry);
@@ -212,6 +349,9 @@ olsrv2_routing_cleanup(void) {
     olsrv2_routing_filter_remove(filter);
   }
 
+  oonf_timer_remove(&_warm_restart_timer_info);
+  oonf_timer_remove(&_audit_timer_info);
+  oonf_timer_remove(&_dampening_timer_info);
   oonf_timer_remove(&_dijkstra_timer_info);
   oonf_class_remove(&_rtset_entry);
 }
@@ -234,15 +374,17 @@ olsrv2_routing_force_ansn_increment(uint16_t increment) {
 }
 
 /**
- * Trigger a new dijkstra as soon as we are back in the mainloop
- * (unless the rate limitation timer is active, then we will wait for it)
+ * Trigger a new dijkstra for all changed domains as soon as their
+ * rate limitation allows it
  */
 void
 olsrv2_routing_trigger_update(void) {
-  _trigger_dijkstra = true;
-  if (!oonf_timer_is_active(&_rate_limit_timer)) {
-    /* trigger as soon as we hit the next time slice */
-    oonf_timer_set(&_rate_limit_timer, 1);
+  struct nhdp_domain *domain;
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    if (_dijkstra_schedule[domain->index].causes) {
+      _schedule_dijkstra(domain);
+    }
   }
 
   OONF_DEBUG(LOG_OLSRV2_ROUTING, "Trigger routing update");
@@ -266,6 +408,38 @@ olsrv2_routing_freeze_routes(bool freeze) {
   }
 }
 
+/**
+ * Set the parameters of the kernel routing table audit
+ * @param interval time between two audits of the kernel routing table,
+ *   0 to only compare the kernel table with the routing set during startup
+ * @param warm_restart_hold time routes of a previous instance are kept in
+ *   the kernel during startup, 0 to remove them with the first dijkstra run.
+ *   If not 0, routes are also kept in the kernel during shutdown.
+ */
+void
+olsrv2_routing_set_kernel_audit(uint64_t interval, uint64_t warm_restart_hold) {
+  _audit_interval = interval;
+  _warm_restart_hold = warm_restart_hold;
+
+  if (!_audit_started) {
+    /* startup audit is still pending */
+    if (warm_restart_hold > 0) {
+      oonf_timer_set(&_warm_restart_timer, warm_restart_hold);
+    }
+    else {
+      oonf_timer_stop(&_warm_restart_timer);
+    }
+    return;
+  }
+
+  if (interval > 0) {
+    oonf_timer_set(&_audit_timer, interval);
+  }
+  else {
+    oonf_timer_stop(&_audit_timer);
+  }
+}
+
 /**
  * @param domain nhdp domain
  * @return routing domain parameters
@@ -275,23 +449,51 @@ olsrv2_routing_get_parameters(struct nhdp_domain *domain) {
   return &_domain_parameter[domain->index];
 }
 
+/**
+ * @param domain nhdp domain
+ * @return routing statistics of domain
+ */
+const struct olsrv2_routing_statistics *
+olsrv2_routing_get_statistics(struct nhdp_domain *domain) {
+  return &_domain_statistics[domain->index];
+}
+
 /**
  * Mark a domain as changed to trigger a dijkstra run
+ * because of an external event
  * @param domain NHDP domain, NULL for all domains
  * @param autoupdate_ansn true to make sure ANSN changes
  */
 void
 olsrv2_routing_domain_changed(struct nhdp_domain *domain, bool autoupdate_ansn) {
+  olsrv2_routing_domain_changed_ext(domain, autoupdate_ansn, OLSRV2_ROUTING_CAUSE_EXTERNAL);
+}
+
+/**
+ * Mark a domain as changed to trigger a dijkstra run
+ * @param domain NHDP domain, NULL for all domains
+ * @param autoupdate_ansn true to make sure ANSN changes
+ * @param cause reason for the dijkstra run
+ */
+void
+olsrv2_routing_domain_changed_ext(struct nhdp_domain *domain, bool autoupdate_ansn, enum olsrv2_routing_cause cause) {
+  struct _dijkstra_schedule *schedule;
+
   _update_ansn |= autoupdate_ansn;
   if (domain) {
-    _domain_changed[domain->index] = true;
+    schedule = &_dijkstra_schedule[domain->index];
+    if (schedule->causes == 0) {
+      schedule->first_trigger = oonf_clock_getNow();
+    }
+    schedule->causes |= cause;
+    schedule->domain = domain;
 
-    olsrv2_routing_trigger_update();
+    _schedule_dijkstra(domain);
     return;
   }
 
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
-    olsrv2_routing_domain_changed(domain, false);
+    olsrv2_routing_domain_changed_ext(domain, false, cause);
   }
 }
 
@@ -301,78 +503,74 @@ olsrv2_routing_domain_changed(struct nhdp_domain *domain, bool autoupdate_ansn)
  */
 void
 olsrv2_routing_force_update(bool skip_wait) {
+  struct _dijkstra_schedule *schedule;
   struct nhdp_domain *domain;
-  bool splitv4, splitv6;
 
   if (_initiate_shutdown || _freeze_routes) {
     /* no dijkstra anymore when in shutdown */
     return;
   }
 
-  /* handle dijkstra rate limitation timer */
-  if (oonf_timer_is_active(&_rate_limit_timer)) {
-    if (!skip_wait) {
-      /* trigger dijkstra later */
-      _trigger_dijkstra = true;
-
-      OONF_DEBUG(LOG_OLSRV2_ROUTING, "Delay Dijkstra");
-      return;
-    }
-    oonf_timer_stop(&_rate_limit_timer);
-  }
-
-  if (_update_ansn) {
-    _ansn++;
-    _update_ansn = false;
-    OONF_DEBUG(LOG_OLSRV2_ROUTING, "Update ANSN to %u", _ansn);
-  }
-
-  OONF_DEBUG(LOG_OLSRV2_ROUTING, "Run Dijkstra");
-
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    schedule = &_dijkstra_schedule[domain->index];
+
     /* check if dijkstra is necessary */
-    if (!_domain_changed[domain->index]) {
-      /* nothing to do for this domain */
+    if (!schedule->causes) {
       continue;
     }
-    _domain_changed[domain->index] = false;
-
-    /* initialize dijkstra specific fields */
-    _prepare_routes(domain);
-    _prepare_nodes();
 
-    /* run IPv4 dijkstra (might be two times because of source-specific data) */
-    splitv4 = _check_ssnode_split(domain, AF_INET);
-    _run_dijkstra(domain, AF_INET, true, !splitv4);
-
-    /* run IPv6 dijkstra (might be two times because of source-specific data) */
-    splitv6 = _check_ssnode_split(domain, AF_INET6);
-    _run_dijkstra(domain, AF_INET6, true, !splitv6);
-
-    /* handle source-specific sub-topology if necessary */
-    if (splitv4 || splitv6) {
-      /* re-initialize dijkstra specific node fields */
-      _prepare_nodes();
-
-      if (splitv4) {
-        _run_dijkstra(domain, AF_INET, false, true);
-      }
-      if (splitv6) {
-        _run_dijkstra(domain, AF_INET6, false, true);
+    if (oonf_timer_is_active(&schedule->timer)) {
+      if (!skip_wait) {
+        /* rate limitation is active, dijkstra runs when the timer fires */
+        OONF_DEBUG(LOG_OLSRV2_ROUTING, "Delay Dijkstra for domain %u", domain->index);
+        continue;
       }
+      oonf_timer_stop(&schedule->timer);
     }
-
-    /* check if direct one-hop routes are quicker */
-    _handle_nhdp_routes(domain);
-
-    /* update kernel routes */
-    _process_dijkstra_result(domain);
+    _update_domain_routes(domain);
   }
 
   _process_kernel_queue();
+}
+
+/**
+ * Get the statistics of a recent dijkstra run
+ * @param domain nhdp domain
+ * @param age 0 for the last run, 1 for the one before...
+ * @return statistics of dijkstra run, NULL if not in history
+ */
+const struct olsrv2_routing_dijkstra_run *
+olsrv2_routing_get_dijkstra_run(struct nhdp_domain *domain, uint32_t age) {
+  struct olsrv2_routing_statistics *stats;
 
-  /* make sure dijkstra is not called too often */
-  oonf_timer_set(&_rate_limit_timer, OLSRv2_DIJKSTRA_RATE_LIMITATION);
+  stats = &_domain_statistics[domain->index];
+  if (age >= stats->dijkstra_runs || age >= OLSRV2_ROUTING_HISTORY_LENGTH) {
+    return NULL;
+  }
+  return &stats->history[(stats->dijkstra_runs - 1 - age) % OLSRV2_ROUTING_HISTORY_LENGTH];
+}
+
+/**
+ * Convert a bitmask of dijkstra causes into a comma separated list
+ * @param buf output buffer
+ * @param causes bitmask of olsrv2_routing_cause values
+ * @return pointer to string representation
+ */
+const char *
+olsrv2_routing_cause_to_string(struct olsrv2_routing_cause_str *buf, uint32_t causes) {
+  size_t i, len;
+
+  buf->buf[0] = 0;
+  len = 0;
+  for (i = 0; i < OLSRV2_ROUTING_CAUSE_COUNT; i++) {
+    if (causes & (1u << i)) {
+      len += snprintf(&buf->buf[len], sizeof(buf->buf) - len, "%s%s", len > 0 ? "," : "", _cause_names[i]);
+    }
+  }
+  if (len == 0) {
+    strscpy(buf->buf, "-", sizeof(buf->buf));
+  }
+  return buf->buf;
 }
 
 /**
@@ -393,21 +591,35 @@ olsrv2_routing_dijkstra_node_init(struct olsrv2_dijkstra_node *dijkstra, const s
  */
 void
 olsrv2_routing_set_domain_parameter(struct nhdp_domain *domain, struct olsrv2_routing_domain *parameter) {
+  struct olsrv2_routing_domain *old;
   struct olsrv2_routing_entry *rtentry;
+  bool kernel_change;
 
-  if (memcmp(parameter, &_domain_parameter[domain->index], sizeof(*parameter)) == 0) {
+  old = &_domain_parameter[domain->index];
+  if (memcmp(parameter, old, sizeof(*parameter)) == 0) {
     /* no change */
     return;
   }
 
+  /* dampening and multipath parameters have no influence on the kernel route keys */
+  kernel_change = parameter->use_srcip_in_routes != old->use_srcip_in_routes ||
+                  parameter->protocol != old->protocol || parameter->table != old->table ||
+                  parameter->distance != old->distance || parameter->source_specific != old->source_specific;
+
   /* copy parameters */
-  memcpy(&_domain_parameter[domain->index], parameter, sizeof(*parameter));
+  memcpy(old, parameter, sizeof(*parameter));
 
   if (avl_is_empty(&_routing_tree[domain->index])) {
     /* no routes present */
     return;
   }
 
+  if (!kernel_change) {
+    /* recalculate routes with the new parameters */
+    olsrv2_routing_domain_changed_ext(domain, false, OLSRV2_ROUTING_CAUSE_CONFIG);
+    return;
+  }
+
   /* remove old kernel routes */
   avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
     if (rtentry->set) {
@@ -425,8 +637,8 @@ olsrv2_routing_set_domain_parameter(struct nhdp_domain *domain, struct olsrv2_ro
   _process_kernel_queue();
 
   /* trigger a dijkstra to write new routes in 100 milliseconds */
-  oonf_timer_set(&_rate_limit_timer, 100);
-  _trigger_dijkstra = true;
+  olsrv2_routing_domain_changed_ext(domain, false, OLSRV2_ROUTING_CAUSE_CONFIG);
+  oonf_timer_set(&_dijkstra_schedule[domain->index].timer, 100);
 }
 
 /**
@@ -463,9 +675,7 @@ _cb_mpr_update(struct nhdp_domain *domain) {
 
   OONF_INFO(LOG_OLSRV2, "MPR update for domain %u", domain->index);
 
-  _update_ansn = true;
-  _domain_changed[domain->index] = true;
-  olsrv2_routing_trigger_update();
+  olsrv2_routing_domain_changed_ext(domain, true, OLSRV2_ROUTING_CAUSE_MPR);
 }
 
 /**
@@ -483,9 +693,132 @@ _cb_metric_update(struct nhdp_domain *domain) {
 
   OONF_INFO(LOG_OLSRV2, "Metric update for domain %u", domain->index);
 
-  _update_ansn = true;
-  _domain_changed[domain->index] = true;
-  olsrv2_routing_trigger_update();
+  olsrv2_routing_domain_changed_ext(domain, true, OLSRV2_ROUTING_CAUSE_METRIC);
+}
+
+/**
+ * Start the timer for the next dijkstra run of a domain,
+ * unless it is already running
+ * @param domain nhdp domain
+ */
+static void
+_schedule_dijkstra(struct nhdp_domain *domain) {
+  struct _dijkstra_schedule *schedule;
+  uint64_t now, delay;
+
+  schedule = &_dijkstra_schedule[domain->index];
+  if (oonf_timer_is_active(&schedule->timer)) {
+    /* dijkstra is already scheduled */
+    return;
+  }
+
+  now = oonf_clock_getNow();
+  delay = _domain_parameter[domain->index].spf_initial_delay;
+  if (schedule->last_run != 0 && schedule->last_run + schedule->hold > now + delay) {
+    /* wait for the hold time of the last run */
+    delay = schedule->last_run + schedule->hold - now;
+  }
+  if (delay == 0) {
+    /* trigger as soon as we hit the next time slice */
+    delay = 1;
+  }
+
+  OONF_DEBUG(LOG_OLSRV2_ROUTING, "Schedule Dijkstra for domain %u in %" PRIu64 " ms", domain->index, delay);
+  oonf_timer_set(&schedule->timer, delay);
+}
+
+/**
+ * Run dijkstra for a domain and update its routing set.
+ * Kernel queue must be processed afterwards.
+ * @param domain nhdp domain
+ */
+static void
+_update_domain_routes(struct nhdp_domain *domain) {
+  struct olsrv2_routing_domain *param;
+  struct olsrv2_routing_statistics *stats;
+  struct olsrv2_routing_dijkstra_run *run;
+  struct _dijkstra_schedule *schedule;
+  uint64_t now, max_hold, start, end;
+  uint32_t causes;
+  bool splitv4, splitv6;
+
+  param = &_domain_parameter[domain->index];
+  stats = &_domain_statistics[domain->index];
+  schedule = &_dijkstra_schedule[domain->index];
+
+  if (_update_ansn) {
+    _ansn++;
+    _update_ansn = false;
+    OONF_DEBUG(LOG_OLSRV2_ROUTING, "Update ANSN to %u", _ansn);
+  }
+
+  /* double the hold time during continuous changes, reset it when network is calm */
+  now = oonf_clock_getNow();
+  max_hold = param->spf_max_wait > param->spf_hold ? param->spf_max_wait : param->spf_hold;
+  if (schedule->last_run == 0 || now - schedule->last_run > 2 * schedule->hold) {
+    /* a hold time below the initial delay would be reset before it could grow */
+    schedule->hold = param->spf_hold > param->spf_initial_delay ? param->spf_hold : param->spf_initial_delay;
+    if (schedule->hold < DIJKSTRA_MIN_HOLD) {
+      schedule->hold = DIJKSTRA_MIN_HOLD;
+    }
+  }
+  else if (schedule->hold < max_hold / 2) {
+    schedule->hold *= 2;
+  }
+  else {
+    schedule->hold = max_hold;
+  }
+
+  causes = schedule->causes;
+  schedule->causes = 0;
+
+  OONF_DEBUG(LOG_OLSRV2_ROUTING, "Run Dijkstra for domain %u", domain->index);
+  os_clock_gettime64_ns(&start);
+
+  /* initialize dijkstra specific fields */
+  _prepare_routes(domain);
+  _prepare_nodes();
+
+  /* run IPv4 dijkstra (might be two times because of source-specific data) */
+  splitv4 = _check_ssnode_split(domain, AF_INET);
+  _run_dijkstra(domain, AF_INET, true, !splitv4);
+
+  /* run IPv6 dijkstra (might be two times because of source-specific data) */
+  splitv6 = _check_ssnode_split(domain, AF_INET6);
+  _run_dijkstra(domain, AF_INET6, true, !splitv6);
+
+  /* handle source-specific sub-topology if necessary */
+  if (splitv4 || splitv6) {
+    /* re-initialize dijkstra specific node fields */
+    _prepare_nodes();
+
+    if (splitv4) {
+      _run_dijkstra(domain, AF_INET, false, true);
+    }
+    if (splitv6) {
+      _run_dijkstra(domain, AF_INET6, false, true);
+    }
+  }
+
+  /* check if direct one-hop routes are quicker */
+  _handle_nhdp_routes(domain);
+
+  /* update kernel routes */
+  _process_dijkstra_result(domain);
+
+  os_clock_gettime64_ns(&end);
+
+  /* remember statistics of dijkstra run */
+  run = &stats->history[stats->dijkstra_runs % OLSRV2_ROUTING_HISTORY_LENGTH];
+  stats->dijkstra_runs++;
+
+  run->timestamp = now;
+  run->delay = now - schedule->first_trigger;
+  run->hold = schedule->hold;
+  run->duration = (end - start) / 1000;
+  run->causes = causes;
+
+  schedule->last_run = now;
 }
 
 /**
@@ -566,8 +899,10 @@ _remove_entry(struct olsrv2_routing_entry *entry) {
 
 /**
  * Insert a new entry into the dijkstra working queue
+ * @param domain nhdp domain
  * @param target pointer to tc target
  * @param neigh next hop through which the target can be reached
+ * @param first_hop_cost cost of the link to the next hop
  * @param link_cost cost of the last hop of the path towards the target
  * @param path_cost remainder of the cost to the target
  * @param distance hopcount to be used for the route to the target
@@ -576,9 +911,12 @@ _remove_entry(struct olsrv2_routing_entry *entry) {
  *   destination prefix
  */
 static void
-_insert_into_working_tree(struct olsrv2_tc_target *target, struct nhdp_neighbor *neigh, uint32_t link_cost,
-  uint32_t path_cost, uint8_t path_hops, uint8_t distance, bool single_hop, const struct netaddr *last_originator) {
+_insert_into_working_tree(struct nhdp_domain *domain, struct olsrv2_tc_target *target, struct nhdp_neighbor *neigh,
+  uint32_t first_hop_cost, uint32_t link_cost, uint32_t path_cost, uint8_t path_hops, uint8_t distance,
+  bool single_hop, const struct netaddr *last_originator) {
   struct olsrv2_dijkstra_node *node;
+  struct nhdp_neighbor *old_first_hop;
+  uint32_t old_first_hop_cost, old_path_cost;
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf1, nbuf2;
 #endif
@@ -600,16 +938,26 @@ _insert_into_working_tree(struct olsrv2_tc_target *target, struct nhdp_neighbor
   path_cost += link_cost;
   path_hops += 1;
 
+  old_first_hop = NULL;
+  old_first_hop_cost = 0;
+  old_path_cost = 0;
+
   if (avl_is_node_added(&node->_node)) {
     /* node already in dijkstra working queue */
 
     if (node->path_cost <= path_cost) {
-      /* current path is shorter than new one */
+      /* current path is shorter than new one, it might still be useful for multipath */
+      _add_ecmp_nexthop(domain, node, neigh, first_hop_cost, path_cost);
       return;
     }
 
     /* we found a better path, remove node from working queue */
     avl_remove(&_dijkstra_working_tree, &node->_node);
+
+    /* remember old path as a multipath candidate */
+    old_first_hop = node->first_hop;
+    old_first_hop_cost = node->first_hop_cost;
+    old_path_cost = node->path_cost;
   }
 
   OONF_DEBUG(LOG_OLSRV2_ROUTING, "Add dst %s [%s] with pathcost %u to dijstra tree (0x%zx)",
@@ -619,20 +967,145 @@ _insert_into_working_tree(struct olsrv2_tc_target *target, struct nhdp_neighbor
   node->path_cost = path_cost;
   node->path_hops = path_hops;
   node->first_hop = neigh;
+  node->first_hop_cost = first_hop_cost;
   node->distance = distance;
   node->single_hop = single_hop;
   node->last_originator = last_originator;
 
+  if (old_first_hop) {
+    _filter_ecmp_nexthops(domain, node);
+    _add_ecmp_nexthop(domain, node, old_first_hop, old_first_hop_cost, old_path_cost);
+  }
+
   avl_insert(&_dijkstra_working_tree, &node->_node);
   return;
 }
 
+/**
+ * Forward the alternative first hops of a processed dijkstra node
+ * to a target already in the working queue
+ * @param domain nhdp domain
+ * @param target pointer to tc target
+ * @param predecessor dijkstra node the target is reached through
+ * @param link_cost cost of the last hop of the path towards the target
+ */
+static void
+_insert_ecmp_into_working_tree(struct nhdp_domain *domain, struct olsrv2_tc_target *target,
+  const struct olsrv2_dijkstra_node *predecessor, uint32_t link_cost) {
+  struct olsrv2_dijkstra_node *node;
+  uint8_t i;
+
+  node = &target->_dijkstra;
+  if (node->local || node->done || !avl_is_node_added(&node->_node)) {
+    return;
+  }
+
+  for (i = 0; i < predecessor->ecmp_count; i++) {
+    _add_ecmp_nexthop(domain, node, predecessor->ecmp[i].first_hop, predecessor->ecmp[i].link_cost,
+      predecessor->ecmp[i].path_cost + link_cost);
+  }
+}
+
+/**
+ * Check if a path can be used as an alternative next hop for a multipath route
+ * @param domain nhdp domain
+ * @param best_cost cost of the best path to the target
+ * @param link_cost cost of the first hop of the alternative path
+ * @param path_cost total cost of the alternative path
+ * @return true if path can be used for multipath routing
+ */
+static bool
+_is_ecmp_candidate(struct nhdp_domain *domain, uint32_t best_cost, uint32_t link_cost, uint32_t path_cost) {
+  if ((uint64_t)path_cost > (uint64_t)best_cost + (uint64_t)_domain_parameter[domain->index].ecmp_tolerance) {
+    /* alternative path is too expensive */
+    return false;
+  }
+
+  /* loop-free: the first hop must be closer to the target than this router */
+  return path_cost - link_cost < best_cost;
+}
+
+/**
+ * Add an alternative first hop to a node in the dijkstra working queue
+ * @param domain nhdp domain
+ * @param node dijkstra node
+ * @param neigh alternative first hop
+ * @param link_cost cost of the link to the alternative first hop
+ * @param path_cost total path cost through the alternative first hop
+ */
+static void
+_add_ecmp_nexthop(struct nhdp_domain *domain, struct olsrv2_dijkstra_node *node, struct nhdp_neighbor *neigh,
+  uint32_t link_cost, uint32_t path_cost) {
+  struct olsrv2_dijkstra_nexthop *nexthop;
+  int32_t max_count;
+  uint8_t i;
+
+  max_count = _domain_parameter[domain->index].ecmp_max_paths - 1;
+  if (max_count <= 0 || neigh == node->first_hop ||
+      !_is_ecmp_candidate(domain, node->path_cost, link_cost, path_cost)) {
+    return;
+  }
+
+  nexthop = NULL;
+  for (i = 0; i < node->ecmp_count; i++) {
+    if (node->ecmp[i].first_hop == neigh) {
+      if (node->ecmp[i].path_cost > path_cost) {
+        /* same first hop with a better path */
+        node->ecmp[i].link_cost = link_cost;
+        node->ecmp[i].path_cost = path_cost;
+      }
+      return;
+    }
+    if (nexthop == NULL || nexthop->path_cost < node->ecmp[i].path_cost) {
+      nexthop = &node->ecmp[i];
+    }
+  }
+
+  if (node->ecmp_count < max_count) {
+    /* add new alternative */
+    nexthop = &node->ecmp[node->ecmp_count++];
+  }
+  else if (nexthop->path_cost <= path_cost) {
+    /* all alternatives are better than the new one */
+    return;
+  }
+
+  nexthop->first_hop = neigh;
+  nexthop->link_cost = link_cost;
+  nexthop->path_cost = path_cost;
+}
+
+/**
+ * Remove all alternative first hops of a dijkstra node that are not
+ * multipath candidates anymore after its best path has changed
+ * @param domain nhdp domain
+ * @param node dijkstra node
+ */
+static void
+_filter_ecmp_nexthops(struct nhdp_domain *domain, struct olsrv2_dijkstra_node *node) {
+  uint8_t i;
+
+  i = 0;
+  while (i < node->ecmp_count) {
+    if (node->ecmp[i].first_hop == node->first_hop ||
+        !_is_ecmp_candidate(domain, node->path_cost, node->ecmp[i].link_cost, node->ecmp[i].path_cost)) {
+      /* overwrite with last entry */
+      node->ecmp_count--;
+      memcpy(&node->ecmp[i], &node->ecmp[node->ecmp_count], sizeof(node->ecmp[i]));
+    }
+    else {
+      i++;
+    }
+  }
+}
+
 /**
  * Initialize a routing entry with the result of the dijkstra calculation
  * @param domain nhdp domain
  * @param dst_prefix routing destination prefix
  * @param dst_originator originator address of destination
  * @param first_hop nhdp neighbor for first hop to target
+ * @param ecmp dijkstra node with alternative first hops, NULL if none
  * @param distance hopcount distance that should be used for route
  * @param pathcost pathcost to target
  * @param path_hops number of hops to the target
@@ -641,8 +1114,8 @@ _insert_into_working_tree(struct olsrv2_tc_target *target, struct nhdp_neighbor
  */
 static void
 _update_routing_entry(struct nhdp_domain *domain, struct os_route_key *dst_prefix, const struct netaddr *dst_originator,
-  struct nhdp_neighbor *first_hop, uint8_t distance, uint32_t pathcost, uint8_t path_hops, bool single_hop,
-  const struct netaddr *last_originator) {
+  struct nhdp_neighbor *first_hop, const struct olsrv2_dijkstra_node *ecmp, uint8_t distance, uint32_t pathcost,
+  uint8_t path_hops, bool single_hop, const struct netaddr *last_originator) {
   struct nhdp_neighbor_domaindata *neighdata;
   struct olsrv2_routing_entry *rtentry;
   const struct netaddr *originator;
@@ -726,6 +1199,124 @@ _update_routing_entry(struct nhdp_domain *domain, struct os_route_key *dst_prefi
   else {
     memcpy(&rtentry->route.p.gw, &neighdata->best_out_link->if_addr, sizeof(struct netaddr));
   }
+
+  /* add additional next hops for multipath routes */
+  _update_multipath(domain, rtentry, first_hop, ecmp);
+}
+
+/**
+ * Calculate the additional next hops of a multipath route
+ * @param domain nhdp domain
+ * @param rtentry routing entry with primary next hop already set
+ * @param first_hop nhdp neighbor for first hop to target
+ * @param ecmp dijkstra node with alternative first hops, NULL if none
+ */
+static void
+_update_multipath(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry, struct nhdp_neighbor *first_hop,
+  const struct olsrv2_dijkstra_node *ecmp) {
+  struct os_route_nexthop tmp;
+  unsigned i, j;
+
+  rtentry->route.p.multipath_count = 0;
+  memset(rtentry->route.p.multipath, 0, sizeof(rtentry->route.p.multipath));
+
+  if (_domain_parameter[domain->index].ecmp_max_paths <= 1 ||
+      netaddr_get_address_family(&rtentry->route.p.gw) == AF_UNSPEC) {
+    /* no multipath or direct route without gateway */
+    return;
+  }
+
+  /* parallel links to the first hop */
+  _add_multipath_links(domain, rtentry, first_hop);
+
+  /* alternative first hops */
+  for (i = 0; ecmp != NULL && i < ecmp->ecmp_count; i++) {
+    _add_multipath_links(domain, rtentry, ecmp->ecmp[i].first_hop);
+  }
+
+  /* sort next hops to keep route comparable between dijkstra runs */
+  for (i = 1; i < rtentry->route.p.multipath_count; i++) {
+    for (j = i; j > 0; j--) {
+      if (rtentry->route.p.multipath[j - 1].if_index < rtentry->route.p.multipath[j].if_index ||
+          (rtentry->route.p.multipath[j - 1].if_index == rtentry->route.p.multipath[j].if_index &&
+            netaddr_cmp(&rtentry->route.p.multipath[j - 1].gw, &rtentry->route.p.multipath[j].gw) < 0)) {
+        break;
+      }
+      memcpy(&tmp, &rtentry->route.p.multipath[j], sizeof(tmp));
+      memcpy(&rtentry->route.p.multipath[j], &rtentry->route.p.multipath[j - 1], sizeof(tmp));
+      memcpy(&rtentry->route.p.multipath[j - 1], &tmp, sizeof(tmp));
+    }
+  }
+}
+
+/**
+ * Add the symmetric links of a neighbor as next hops to a multipath route
+ * @param domain nhdp domain
+ * @param rtentry routing entry
+ * @param neigh nhdp neighbor
+ */
+static void
+_add_multipath_links(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry, struct nhdp_neighbor *neigh) {
+  struct nhdp_neighbor_domaindata *neighdata;
+  struct nhdp_link *lnk;
+
+  neighdata = nhdp_domain_get_neighbordata(domain, neigh);
+  if (neighdata->best_out_link == NULL) {
+    return;
+  }
+
+  /* best link first, then all parallel links */
+  _add_multipath_link(domain, rtentry, neighdata, neighdata->best_out_link);
+  list_for_each_element(&neigh->_links, lnk, _neigh_node) {
+    if (lnk != neighdata->best_out_link) {
+      _add_multipath_link(domain, rtentry, neighdata, lnk);
+    }
+  }
+}
+
+/**
+ * Add a single link as a next hop to a multipath route
+ * @param domain nhdp domain
+ * @param rtentry routing entry
+ * @param neighdata domain data of the neighbor of the link
+ * @param lnk nhdp link
+ */
+static void
+_add_multipath_link(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry,
+  struct nhdp_neighbor_domaindata *neighdata, struct nhdp_link *lnk) {
+  struct os_route_nexthop *nexthop;
+  unsigned if_index;
+  unsigned i;
+
+  if (rtentry->route.p.multipath_count + 1 >= (unsigned)_domain_parameter[domain->index].ecmp_max_paths) {
+    /* route is full */
+    return;
+  }
+  if (lnk->status != NHDP_LINK_SYMMETRIC ||
+      netaddr_get_address_family(&lnk->if_addr) != netaddr_get_address_family(&rtentry->route.p.gw)) {
+    return;
+  }
+  if ((uint64_t)nhdp_domain_get_linkdata(domain, lnk)->metric.out >
+      (uint64_t)neighdata->best_out_link_metric + (uint64_t)_domain_parameter[domain->index].ecmp_tolerance) {
+    /* parallel link is too expensive */
+    return;
+  }
+
+  /* check for duplicates */
+  if_index = nhdp_interface_get_if_listener(lnk->local_if)->data->index;
+  if (if_index == rtentry->route.p.if_index && netaddr_cmp(&lnk->if_addr, &rtentry->route.p.gw) == 0) {
+    return;
+  }
+  for (i = 0; i < rtentry->route.p.multipath_count; i++) {
+    if (if_index == rtentry->route.p.multipath[i].if_index &&
+        netaddr_cmp(&lnk->if_addr, &rtentry->route.p.multipath[i].gw) == 0) {
+      return;
+    }
+  }
+
+  nexthop = &rtentry->route.p.multipath[rtentry->route.p.multipath_count++];
+  memcpy(&nexthop->gw, &lnk->if_addr, sizeof(nexthop->gw));
+  nexthop->if_index = if_index;
 }
 
 /**
@@ -739,9 +1330,29 @@ _prepare_routes(struct nhdp_domain *domain) {
   avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
     rtentry->set = false;
     memcpy(&rtentry->_old, &rtentry->route.p, sizeof(rtentry->_old));
+    rtentry->_old_path_cost = rtentry->path_cost;
+    rtentry->_old_path_hops = rtentry->path_hops;
+    memcpy(&rtentry->_old_originator, &rtentry->originator, sizeof(rtentry->_old_originator));
+    memcpy(&rtentry->_old_next_originator, &rtentry->next_originator, sizeof(rtentry->_old_next_originator));
+    memcpy(&rtentry->_old_last_originator, &rtentry->last_originator, sizeof(rtentry->_old_last_originator));
   }
 }
 
+/**
+ * Reset a routing entry to its state before the current dijkstra run
+ * @param rtentry routing entry
+ */
+static void
+_restore_routing_entry(struct olsrv2_routing_entry *rtentry) {
+  memcpy(&rtentry->route.p, &rtentry->_old, sizeof(rtentry->route.p));
+  rtentry->path_cost = rtentry->_old_path_cost;
+  rtentry->path_hops = rtentry->_old_path_hops;
+  memcpy(&rtentry->originator, &rtentry->_old_originator, sizeof(rtentry->originator));
+  memcpy(&rtentry->next_originator, &rtentry->_old_next_originator, sizeof(rtentry->next_originator));
+  memcpy(&rtentry->last_originator, &rtentry->_old_last_originator, sizeof(rtentry->last_originator));
+  rtentry->set = true;
+}
+
 /**
  * Initialize internal fields for dijkstra calculation
  */
@@ -753,6 +1364,7 @@ _prepare_nodes(void) {
   /* initialize private dijkstra data on nodes */
   avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     node->target._dijkstra.first_hop = NULL;
+    node->target._dijkstra.ecmp_count = 0;
     node->target._dijkstra.path_cost = RFC7181_METRIC_INFINITE_PATH;
     node->target._dijkstra.path_hops = 255;
     node->target._dijkstra.local = olsrv2_originator_is_local(&node->target.prefix.dst);
@@ -762,6 +1374,7 @@ _prepare_nodes(void) {
   /* initialize private dijkstra data on endpoints */
   avl_for_each_element(olsrv2_tc_get_endpoint_tree(), end, _node) {
     end->target._dijkstra.first_hop = NULL;
+    end->target._dijkstra.ecmp_count = 0;
     end->target._dijkstra.path_cost = RFC7181_METRIC_INFINITE_PATH;
     end->target._dijkstra.path_hops = 255;
     end->target._dijkstra.done = false;
@@ -846,8 +1459,8 @@ _add_one_hop_nodes(struct nhdp_domain *domain, int af_family, bool use_non_ss, b
     OONF_DEBUG(LOG_OLSRV2_ROUTING, "Add one-hop node %s", netaddr_to_string(&nbuf, &neigh->originator));
 
     /* found node for neighbor, add to worker list */
-    _insert_into_working_tree(
-      &node->target, neigh, neigh_metric->metric.out, 0, 0, 0, true, olsrv2_originator_get(af_family));
+    _insert_into_working_tree(domain, &node->target, neigh, neigh_metric->metric.out, neigh_metric->metric.out, 0, 0,
+      0, true, olsrv2_originator_get(af_family));
   }
 }
 
@@ -884,7 +1497,7 @@ _handle_working_queue(struct nhdp_domain *domain, bool use_non_ss, bool use_ss)
   /* fill routing entry with dijkstra result */
   if (use_non_ss) {
     _update_routing_entry(domain, &target->prefix, target->_dijkstra.originator, target->_dijkstra.first_hop,
-      target->_dijkstra.distance, target->_dijkstra.path_cost, target->_dijkstra.path_hops,
+      &target->_dijkstra, target->_dijkstra.distance, target->_dijkstra.path_cost, target->_dijkstra.path_hops,
       target->_dijkstra.single_hop, target->_dijkstra.last_originator);
   }
 
@@ -903,8 +1516,10 @@ _handle_working_queue(struct nhdp_domain *domain, bool use_non_ss, bool use_ss)
         }
 
         /* add new tc_node to working tree */
-        _insert_into_working_tree(&tc_edge->dst->target, first_hop, tc_edge->cost[domain->index],
-          target->_dijkstra.path_cost, target->_dijkstra.path_hops, 0, false, &target->prefix.dst);
+        _insert_into_working_tree(domain, &tc_edge->dst->target, first_hop, target->_dijkstra.first_hop_cost,
+          tc_edge->cost[domain->index], target->_dijkstra.path_cost, target->_dijkstra.path_hops, 0, false,
+          &target->prefix.dst);
+        _insert_ecmp_into_working_tree(domain, &tc_edge->dst->target, &target->_dijkstra, tc_edge->cost[domain->index]);
       }
     }
 
@@ -919,9 +1534,11 @@ _handle_working_queue(struct nhdp_domain *domain, bool use_non_ss, bool use_ss)
         }
         if (tc_endpoint->_attached_networks.count > 1) {
           /* add attached network or address to working tree */
-          _insert_into_working_tree(&tc_attached->dst->target, first_hop, tc_attached->cost[domain->index],
-            target->_dijkstra.path_cost, target->_dijkstra.path_hops, tc_attached->distance[domain->index], false,
-            &target->prefix.dst);
+          _insert_into_working_tree(domain, &tc_attached->dst->target, first_hop, target->_dijkstra.first_hop_cost,
+            tc_attached->cost[domain->index], target->_dijkstra.path_cost, target->_dijkstra.path_hops,
+            tc_attached->distance[domain->index], false, &target->prefix.dst);
+          _insert_ecmp_into_working_tree(
+            domain, &tc_attached->dst->target, &target->_dijkstra, tc_attached->cost[domain->index]);
         }
         else {
           /* no other way to this endpoint */
@@ -929,8 +1546,9 @@ _handle_working_queue(struct nhdp_domain *domain, bool use_non_ss, bool use_ss)
 
           /* fill routing entry with dijkstra result */
           _update_routing_entry(domain, &tc_endpoint->target.prefix, &tc_node->target.prefix.dst, first_hop,
-            tc_attached->distance[domain->index], target->_dijkstra.path_cost + tc_attached->cost[domain->index],
-            target->_dijkstra.path_hops + 1, false, &target->prefix.dst);
+            &target->_dijkstra, tc_attached->distance[domain->index],
+            target->_dijkstra.path_cost + tc_attached->cost[domain->index], target->_dijkstra.path_hops + 1, false,
+            &target->prefix.dst);
         }
       }
     }
@@ -979,7 +1597,7 @@ _handle_nhdp_routes(struct nhdp_domain *domain) {
       os_routing_init_sourcespec_prefix(&ssprefix, &naddr->neigh_addr);
 
       /* update routing entry */
-      _update_routing_entry(domain, &ssprefix, originator, neigh, 0, neighcost, 1, true, originator);
+      _update_routing_entry(domain, &ssprefix, originator, neigh, NULL, 0, neighcost, 1, true, originator);
     }
 
     list_for_each_element(&neigh->_links, lnk, _neigh_node) {
@@ -1001,7 +1619,7 @@ _handle_nhdp_routes(struct nhdp_domain *domain) {
 
         /* the 2-hop route is better than the dijkstra calculation */
         _update_routing_entry(
-          domain, &ssprefix, &NETADDR_UNSPEC, neigh, 0, l2hop_pathcost, 2, false, &neigh->originator);
+          domain, &ssprefix, &NETADDR_UNSPEC, neigh, NULL, 0, l2hop_pathcost, 2, false, &neigh->originator);
       }
     }
   }
@@ -1035,11 +1653,11 @@ _add_route_to_kernel_queue(struct olsrv2_routing_entry *rtentry) {
 
     if (netaddr_get_address_family(&rtentry->route.p.gw) == AF_UNSPEC) {
       /* remove single-hop routes late */
-      list_add_tail(&_kernel_queue, &rtentry->_working_node);
+      list_add_tail(&_kernel_remove_queue, &rtentry->_working_node);
     }
     else {
       /* remove multi-hop routes early */
-      list_add_head(&_kernel_queue, &rtentry->_working_node);
+      list_add_head(&_kernel_remove_queue, &rtentry->_working_node);
     }
   }
 }
@@ -1055,11 +1673,16 @@ _process_dijkstra_result(struct nhdp_domain *domain) {
   struct olsrv2_routing_filter *filter;
   struct olsrv2_lan_entry *lan_entry;
   struct olsrv2_lan_domaindata *lan_data;
+  struct olsrv2_routing_statistics *stats;
 
 #ifdef OONF_LOG_INFO
   struct os_route_str rbuf1, rbuf2;
 #endif
 
+  stats = &_domain_statistics[domain->index];
+  stats->suppressed_routes = 0;
+  stats->multipath_routes = 0;
+
   avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
     /* initialize rest of route parameters */
     rtentry->route.p.table = _domain_parameter[rtentry->domain->index].table;
@@ -1088,6 +1711,44 @@ _process_dijkstra_result(struct nhdp_domain *domain) {
       }
     }
 
+    if (rtentry->adopted) {
+      if (rtentry->set) {
+        /* dijkstra has calculated the route found in the kernel */
+        rtentry->adopted = false;
+      }
+      else if (oonf_timer_is_active(&_warm_restart_timer)) {
+        /* keep route of previous instance until the topology has been learned again */
+        _restore_routing_entry(rtentry);
+        continue;
+      }
+    }
+
+    if (rtentry->suppressed) {
+      /* release route if its penalty has decayed */
+      _update_route_penalty(domain, rtentry);
+    }
+
+    if (rtentry->set && _is_nexthop_change(rtentry)) {
+      if (_domain_parameter[domain->index].dampening && _dampen_nexthop_change(domain, rtentry)) {
+        /* keep the current kernel route */
+        OONF_INFO(LOG_OLSRV2_ROUTING, "Suppress route change: %s -> %s",
+          os_routing_to_string(&rbuf1, &rtentry->_old), os_routing_to_string(&rbuf2, &rtentry->route.p));
+
+        _restore_routing_entry(rtentry);
+        stats->suppressed_changes++;
+        stats->suppressed_routes++;
+        continue;
+      }
+      stats->nexthop_changes++;
+    }
+
+    if (rtentry->suppressed) {
+      stats->suppressed_routes++;
+    }
+    if (rtentry->set && rtentry->route.p.multipath_count > 0) {
+      stats->multipath_routes++;
+    }
+
     if (rtentry->set && memcmp(&rtentry->_old, &rtentry->route.p, sizeof(rtentry->_old)) == 0) {
       /* no change, ignore this entry */
       OONF_INFO(LOG_OLSRV2_ROUTING, "Ignore route change: %s -> %s", os_routing_to_string(&rbuf1, &rtentry->_old),
@@ -1099,14 +1760,25 @@ _process_dijkstra_result(struct nhdp_domain *domain) {
 }
 
 /**
- * Process all entries in kernel processing queue and send them to the kernel
+ * Process all entries in kernel processing queues and send them to the kernel
  */
 static void
 _process_kernel_queue(void) {
+  /* make before break: install new routes before removing old ones */
+  _process_kernel_queue_list(&_kernel_queue);
+  _process_kernel_queue_list(&_kernel_remove_queue);
+}
+
+/**
+ * Process all entries in a kernel processing queue and send them to the kernel
+ * @param queue kernel processing queue
+ */
+static void
+_process_kernel_queue_list(struct list_entity *queue) {
   struct olsrv2_routing_entry *rtentry, *rt_it;
   struct os_route_str rbuf;
 
-  list_for_each_element_safe(&_kernel_queue, rtentry, _working_node, rt_it) {
+  list_for_each_element_safe(queue, rtentry, _working_node, rt_it) {
     /* remove from routing queue */
     list_remove(&rtentry->_working_node);
 
@@ -1133,16 +1805,370 @@ _process_kernel_queue(void) {
 }
 
 /**
- * Callback for checking if dijkstra was triggered during
- * rate limitation time
+ * @param rtentry routing entry
+ * @return true if the dijkstra result changes the next hop of
+ *   a route already known to the kernel
+ */
+static bool
+_is_nexthop_change(struct olsrv2_routing_entry *rtentry) {
+  if (rtentry->_old.if_index == 0) {
+    /* new route */
+    return false;
+  }
+  return rtentry->_old.if_index != rtentry->route.p.if_index ||
+         netaddr_cmp(&rtentry->_old.gw, &rtentry->route.p.gw) != 0 ||
+         rtentry->_old.multipath_count != rtentry->route.p.multipath_count ||
+         memcmp(rtentry->_old.multipath, rtentry->route.p.multipath, sizeof(rtentry->_old.multipath)) != 0;
+}
+
+/**
+ * Apply route dampening to a next-hop change of a routing entry
+ * @param domain nhdp domain
+ * @param rtentry routing entry
+ * @return true if the next-hop change should be suppressed,
+ *   false if it should be sent to the kernel
+ */
+static bool
+_dampen_nexthop_change(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry) {
+  const struct olsrv2_routing_domain *param;
+  uint32_t max_penalty;
+
+  param = &_domain_parameter[domain->index];
+
+  _update_route_penalty(domain, rtentry);
+  if (rtentry->suppressed && _is_old_nexthop_usable(domain, rtentry)) {
+    _schedule_dampening_reuse(domain, rtentry);
+    return true;
+  }
+
+  /* change will be applied, increase penalty */
+  max_penalty = (uint32_t)param->dampening_suppress * DAMPENING_MAX_PENALTY_FACTOR;
+  rtentry->_penalty += param->dampening_penalty;
+  if (rtentry->_penalty > max_penalty) {
+    rtentry->_penalty = max_penalty;
+  }
+
+  if (rtentry->_penalty >= (uint32_t)param->dampening_suppress) {
+    rtentry->suppressed = true;
+    _schedule_dampening_reuse(domain, rtentry);
+  }
+  return false;
+}
+
+/**
+ * Decay the dampening penalty of a routing entry to the current
+ * time and release the route if its penalty is low enough.
+ * @param domain nhdp domain
+ * @param rtentry routing entry
+ */
+static void
+_update_route_penalty(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry) {
+  const struct olsrv2_routing_domain *param;
+  uint64_t now, elapsed, half_lifes;
+
+  param = &_domain_parameter[domain->index];
+  now = oonf_clock_getNow();
+
+  if (rtentry->_penalty > 0 && param->dampening_half_life > 0) {
+    elapsed = now - rtentry->_penalty_time;
+    half_lifes = elapsed / param->dampening_half_life;
+
+    if (half_lifes >= 32) {
+      rtentry->_penalty = 0;
+    }
+    else {
+      rtentry->_penalty >>= half_lifes;
+
+      /* linear approximation of the decay within a half-life */
+      elapsed %= param->dampening_half_life;
+      rtentry->_penalty -= (uint32_t)(rtentry->_penalty * elapsed / (2 * param->dampening_half_life));
+    }
+  }
+  rtentry->_penalty_time = now;
+
+  if (rtentry->suppressed && rtentry->_penalty < (uint32_t)param->dampening_reuse) {
+    rtentry->suppressed = false;
+  }
+}
+
+/**
+ * Checks if the next hop of the kernel route can still be used
+ * @param domain nhdp domain
+ * @param rtentry routing entry
+ * @return true if the next hop is still a symmetric neighbor
+ *   on the same interface, false otherwise
+ */
+static bool
+_is_old_nexthop_usable(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry) {
+  const struct netaddr *nexthop;
+  struct nhdp_naddr *naddr;
+  struct nhdp_link *lnk;
+
+  nexthop = &rtentry->_old.gw;
+  if (netaddr_get_address_family(nexthop) == AF_UNSPEC) {
+    /* single-hop route */
+    nexthop = &rtentry->_old.key.dst;
+  }
+
+  naddr = nhdp_db_neighbor_addr_get(nexthop);
+  if (naddr == NULL || nhdp_db_neighbor_addr_is_lost(naddr) || naddr->neigh->symmetric == 0) {
+    return false;
+  }
+
+  if (nhdp_domain_get_neighbordata(domain, naddr->neigh)->metric.out > RFC7181_METRIC_MAX) {
+    return false;
+  }
+
+  list_for_each_element(&naddr->neigh->_links, lnk, _neigh_node) {
+    if (lnk->status == NHDP_LINK_SYMMETRIC &&
+        nhdp_interface_get_if_listener(lnk->local_if)->data->index == rtentry->_old.if_index) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Make sure the dampening timer fires when the penalty of a suppressed
+ * routing entry has decayed below the reuse threshold.
+ * @param domain nhdp domain
+ * @param rtentry routing entry
+ */
+static void
+_schedule_dampening_reuse(struct nhdp_domain *domain, struct olsrv2_routing_entry *rtentry) {
+  const struct olsrv2_routing_domain *param;
+  uint64_t delay;
+  uint32_t penalty;
+
+  param = &_domain_parameter[domain->index];
+
+  delay = 0;
+  penalty = rtentry->_penalty;
+  while (penalty >= (uint32_t)param->dampening_reuse) {
+    penalty /= 2;
+    delay += param->dampening_half_life;
+  }
+
+  if (delay == 0) {
+    delay = 1;
+  }
+  if (!oonf_timer_is_active(&_dampening_timer) || oonf_timer_get_due(&_dampening_timer) > (int64_t)delay) {
+    oonf_timer_set(&_dampening_timer, delay);
+  }
+}
+
+/**
+ * Send all routes to the kernel that were missing or different
+ * in the last kernel routing table dump
+ */
+static void
+_repair_kernel_routes(void) {
+  struct olsrv2_routing_entry *rtentry;
+  struct nhdp_domain *domain;
+  struct os_route_str rbuf;
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
+      if (!rtentry->set || rtentry->in_processing || (!rtentry->_audit_missing && !rtentry->_audit_repair)) {
+        continue;
+      }
+
+      OONF_WARN(LOG_OLSRV2_ROUTING, "Repair kernel route %s", os_routing_to_string(&rbuf, &rtentry->route.p));
+
+      _domain_statistics[domain->index].audit_repaired++;
+      _add_route_to_kernel_queue(rtentry);
+    }
+  }
+
+  _process_kernel_queue();
+}
+
+/**
+ * @param route route of the routing set
+ * @param kernel route of the kernel routing table with the same key
+ * @return true if the kernel route matches the route of the routing set
+ */
+static bool
+_is_kernel_route_equal(const struct os_route_parameter *route, const struct os_route_parameter *kernel) {
+  const struct netaddr *gw;
+
+  gw = &route->gw;
+  if (netaddr_is_unspec(gw) && netaddr_get_address_family(&route->key.dst) == AF_INET &&
+      netaddr_get_prefix_length(&route->key.dst) == netaddr_get_maxprefix(&route->key.dst)) {
+    /* the kernel uses the destination as gateway for IPv4 host routes */
+    gw = &route->key.dst;
+  }
+
+  if (netaddr_get_address_family(&route->src_ip) != AF_UNSPEC && netaddr_cmp(&route->src_ip, &kernel->src_ip) != 0) {
+    return false;
+  }
+  return netaddr_cmp(gw, &kernel->gw) == 0 && route->if_index == kernel->if_index && route->metric == kernel->metric &&
+         route->multipath_count == kernel->multipath_count &&
+         memcmp(route->multipath, kernel->multipath, sizeof(route->multipath[0]) * route->multipath_count) == 0;
+}
+
+/**
+ * Callback for running a scheduled dijkstra of a domain
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_trigger_dijkstra(struct oonf_timer_instance *ptr) {
+  struct _dijkstra_schedule *schedule;
+
+  schedule = container_of(ptr, struct _dijkstra_schedule, timer);
+  if (_initiate_shutdown || _freeze_routes || schedule->causes == 0) {
+    return;
+  }
+
+  _update_domain_routes(schedule->domain);
+  _process_kernel_queue();
+}
+
+/**
+ * Callback to re-evaluate domains with routes suppressed by route dampening
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_dampening_reuse(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  struct nhdp_domain *domain;
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    if (_domain_statistics[domain->index].suppressed_routes > 0) {
+      olsrv2_routing_domain_changed_ext(domain, false, OLSRV2_ROUTING_CAUSE_DAMPENING);
+    }
+  }
+}
+
+/**
+ * Callback to start a dump of the kernel routing table
  * @param ptr timer instance that fired
  */
 static void
-_cb_trigger_dijkstra(struct oonf_timer_instance *ptr __attribute__((unused))) {
-  if (_trigger_dijkstra) {
-    _trigger_dijkstra = false;
-    olsrv2_routing_force_update(false);
+_cb_kernel_audit(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  struct olsrv2_routing_entry *rtentry;
+  struct nhdp_domain *domain;
+
+  _audit_started = true;
+  if (_audit_interval > 0) {
+    oonf_timer_set(&_audit_timer, _audit_interval);
+  }
+
+  if (_initiate_shutdown || _freeze_routes || os_routing_is_in_progress(&_kernel_query)) {
+    return;
+  }
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
+      rtentry->_audit_missing = rtentry->set;
+      rtentry->_audit_repair = false;
+    }
+  }
+
+  OONF_DEBUG(LOG_OLSRV2_ROUTING, "Start kernel route audit");
+  if (os_routing_query(&_kernel_query)) {
+    OONF_WARN(LOG_OLSRV2_ROUTING, "Could not start kernel route audit");
+  }
+}
+
+/**
+ * Callback to remove remaining routes of a previous instance
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_warm_restart_finished(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  OONF_INFO(LOG_OLSRV2_ROUTING, "Warm restart hold time is over");
+  olsrv2_routing_domain_changed_ext(NULL, false, OLSRV2_ROUTING_CAUSE_KERNEL);
+}
+
+/**
+ * Callback for each route of the kernel routing table dump
+ * @param filter kernel query
+ * @param route route found in kernel routing table
+ */
+static void
+_cb_kernel_query(struct os_route *filter __attribute__((unused)), struct os_route *route) {
+  struct olsrv2_routing_entry *rtentry;
+  struct nhdp_domain *domain, *rt_domain;
+  struct os_route_key key;
+#ifdef OONF_LOG_INFO
+  struct os_route_str rbuf1, rbuf2;
+#endif
+
+  /* the kernel does not report a source prefix for normal routes */
+  memcpy(&key, &route->p.key, sizeof(key));
+  if (netaddr_get_address_family(&key.src) == AF_UNSPEC) {
+    os_routing_init_sourcespec_prefix(&key, &route->p.key.dst);
+  }
+
+  rt_domain = NULL;
+  rtentry = NULL;
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    if (_domain_parameter[domain->index].protocol != route->p.protocol ||
+        _domain_parameter[domain->index].table != route->p.table) {
+      continue;
+    }
+
+    if (rt_domain == NULL) {
+      rt_domain = domain;
+    }
+    rtentry = avl_find_element(&_routing_tree[domain->index], &key, rtentry, _node);
+    if (rtentry) {
+      break;
+    }
+  }
+
+  if (rt_domain == NULL) {
+    /* not an olsrv2 route */
+    return;
+  }
+
+  if (rtentry) {
+    rtentry->_audit_missing = false;
+    if (rtentry->set && !rtentry->in_processing && !_is_kernel_route_equal(&rtentry->route.p, &route->p)) {
+      OONF_INFO(LOG_OLSRV2_ROUTING, "Kernel route %s differs from %s", os_routing_to_string(&rbuf1, &route->p),
+        os_routing_to_string(&rbuf2, &rtentry->route.p));
+      rtentry->_audit_repair = true;
+    }
+    return;
+  }
+
+  /* unknown kernel route, adopt it so dijkstra can take it over or remove it */
+  rtentry = _add_entry(rt_domain, &key);
+  if (rtentry == NULL) {
+    return;
+  }
+
+  memcpy(&rtentry->route.p, &route->p, sizeof(rtentry->route.p));
+  memcpy(&rtentry->route.p.key, &key, sizeof(key));
+  if (netaddr_get_address_family(&key.dst) == AF_INET && netaddr_cmp(&rtentry->route.p.gw, &key.dst) == 0) {
+    /* IPv4 host route without gateway */
+    netaddr_invalidate(&rtentry->route.p.gw);
+  }
+
+  rtentry->set = true;
+  rtentry->adopted = true;
+
+  OONF_INFO(LOG_OLSRV2_ROUTING, "Adopt kernel route %s", os_routing_to_string(&rbuf1, &rtentry->route.p));
+
+  _domain_statistics[rt_domain->index].audit_adopted++;
+  olsrv2_routing_domain_changed_ext(rt_domain, false, OLSRV2_ROUTING_CAUSE_KERNEL);
+}
+
+/**
+ * Callback for end of kernel routing table dump
+ * @param route kernel query
+ * @param error 0 if no error happened
+ */
+static void
+_cb_kernel_query_finished(struct os_route *route __attribute__((unused)), int error) {
+  if (error) {
+    OONF_DEBUG(LOG_OLSRV2_ROUTING, "Kernel route audit failed: %d", error);
+    return;
+  }
+  if (_initiate_shutdown || _freeze_routes) {
+    return;
   }
+  _repair_kernel_routes();
 }
 
 /**
@@ -45,6 +45,7 @@
 
 #include <oonf/libcommon/avl.h>
 #include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
 #include <oonf/oonf.h>
 #include <oonf/libcommon/netaddr.h>
 #include <oonf/base/oonf_class.h>
@@ -60,6 +61,14 @@
 /* prototypes */
 static void _cb_tc_node_timeout(struct oonf_timer_instance *);
 static bool _remove_edge(struct olsrv2_tc_edge *edge, bool cleanup);
+static int _insert_edge(struct olsrv2_tc_node *src, struct olsrv2_tc_node *dst, struct olsrv2_tc_edge *edge);
+static void _unhook_edge(struct olsrv2_tc_edge *edge);
+static void _free_edge_pair(
+  struct olsrv2_tc_edge *edge, struct olsrv2_tc_edge *inverse, struct olsrv2_tc_node *virtual_dst);
+
+static uint32_t _hash_edge_key(const void *key);
+static int _avl_comp_edge_key(const void *k1, const void *k2);
+static uint32_t _hash_route_key(const void *key);
 
 static void _cb_neighbor_change(void *ptr);
 static void _cb_neighbor_remove(void *ptr);
@@ -103,6 +112,11 @@ static struct oonf_timer_class _validity_info = {
 static struct avl_tree _tc_tree;
 static struct avl_tree _tc_endpoint_tree;
 
+/* global hash indices for looking up tc nodes, edges and endpoints */
+static struct hashmap _tc_hash;
+static struct hashmap _tc_edge_hash;
+static struct hashmap _tc_endpoint_hash;
+
 /**
  * Initialize tc database
  */
@@ -117,6 +131,10 @@ olsrv2_tc_init(void) {
 
   avl_init(&_tc_tree, avl_comp_netaddr, false);
   avl_init(&_tc_endpoint_tree, os_routing_avl_cmp_route_key, true);
+
+  hashmap_init(&_tc_hash, hashmap_hash_netaddr, avl_comp_netaddr);
+  hashmap_init(&_tc_edge_hash, _hash_edge_key, _avl_comp_edge_key);
+  hashmap_init(&_tc_endpoint_hash, _hash_route_key, os_routing_avl_cmp_route_key);
 }
 
 /**
@@ -145,6 +163,10 @@ olsrv2_tc_cleanup(void) {
 
   oonf_class_extension_remove(&_nhdp_neighbor_extension);
 
+  hashmap_free(&_tc_endpoint_hash);
+  hashmap_free(&_tc_edge_hash);
+  hashmap_free(&_tc_hash);
+
   oonf_class_remove(&_tc_endpoint_class);
   oonf_class_remove(&_tc_attached_class);
   oonf_class_remove(&_tc_edge_class);
@@ -162,7 +184,7 @@ struct olsrv2_tc_node *
 olsrv2_tc_node_add(struct netaddr *originator, uint64_t vtime, uint16_t ansn) {
   struct olsrv2_tc_node *node;
 
-  node = avl_find_element(&_tc_tree, originator, node, _originator_node);
+  node = olsrv2_tc_node_get(originator);
   if (!node) {
     node = oonf_class_malloc(&_tc_node_class);
     if (node == NULL) {
@@ -172,6 +194,13 @@ olsrv2_tc_node_add(struct netaddr *originator, uint64_t vtime, uint16_t ansn) {
     /* copy key and attach it to node */
     os_routing_init_sourcespec_prefix(&node->target.prefix, originator);
     node->_originator_node.key = &node->target.prefix.dst;
+    node->_originator_hnode.key = &node->target.prefix.dst;
+
+    /* hook into global hash index */
+    if (hashmap_insert(&_tc_hash, &node->_originator_hnode)) {
+      oonf_class_free(&_tc_node_class, node);
+      return NULL;
+    }
 
     /* initialize node */
     avl_init(&node->_edges, avl_comp_netaddr, false);
@@ -202,6 +231,17 @@ olsrv2_tc_node_add(struct netaddr *originator, uint64_t vtime, uint16_t ansn) {
   return node;
 }
 
+/**
+ * @param originator originator address of a tc node
+ * @return pointer to tc node, NULL if not found
+ */
+struct olsrv2_tc_node *
+olsrv2_tc_node_get(const struct netaddr *originator) {
+  struct olsrv2_tc_node *node;
+
+  return hashmap_find_element(&_tc_hash, originator, node, _originator_hnode);
+}
+
 /**
  * Remove a tc node from the database
  * @param node pointer to node
@@ -230,11 +270,12 @@ olsrv2_tc_node_remove(struct olsrv2_tc_node *node) {
   /* remove from global tree and free memory if node is not needed anymore*/
   if (node->_edges.count == 0 && !node->direct_neighbor) {
     avl_remove(&_tc_tree, &node->_originator_node);
+    hashmap_remove(&_tc_hash, &node->_originator_hnode);
     oonf_class_free(&_tc_node_class, node);
   }
 
   /* all domains might have changed */
-  olsrv2_routing_domain_changed(NULL, true);
+  olsrv2_routing_domain_changed_ext(NULL, true, OLSRV2_ROUTING_CAUSE_TOPOLOGY);
 }
 
 /**
@@ -246,10 +287,14 @@ olsrv2_tc_node_remove(struct olsrv2_tc_node *node) {
 struct olsrv2_tc_edge *
 olsrv2_tc_edge_add(struct olsrv2_tc_node *src, struct netaddr *addr) {
   struct olsrv2_tc_edge *edge = NULL, *inverse = NULL;
-  struct olsrv2_tc_node *dst = NULL;
+  struct olsrv2_tc_node *dst = NULL, *virtual_dst = NULL;
+  struct olsrv2_tc_edge_key key;
   int i;
 
-  edge = avl_find_element(&src->_edges, addr, edge, _node);
+  memcpy(&key.src, &src->target.prefix.dst, sizeof(key.src));
+  memcpy(&key.dst, addr, sizeof(key.dst));
+
+  edge = hashmap_find_element(&_tc_edge_hash, &key, edge, _hnode);
   if (edge != NULL) {
     edge->virtual = false;
 
@@ -277,15 +322,15 @@ olsrv2_tc_edge_add(struct olsrv2_tc_node *src, struct netaddr *addr) {
   }
 
   /* find or allocate destination node */
-  dst = avl_find_element(&_tc_tree, addr, dst, _originator_node);
+  dst = olsrv2_tc_node_get(addr);
   if (dst == NULL) {
     /* create virtual node */
     dst = olsrv2_tc_node_add(addr, 0, 0);
     if (dst == NULL) {
-      oonf_class_free(&_tc_edge_class, edge);
-      oonf_class_free(&_tc_edge_class, inverse);
+      _free_edge_pair(edge, inverse, NULL);
       return NULL;
     }
+    virtual_dst = dst;
   }
 
   /* initialize edge */
@@ -296,10 +341,6 @@ olsrv2_tc_edge_add(struct olsrv2_tc_node *src, struct netaddr *addr) {
     edge->cost[i] = RFC7181_METRIC_INFINITE;
   }
 
-  /* hook edge into src node */
-  edge->_node.key = &dst->target.prefix.dst;
-  avl_insert(&src->_edges, &edge->_node);
-
   /* initialize inverse (virtual) edge */
   inverse->src = dst;
   inverse->dst = src;
@@ -309,9 +350,16 @@ olsrv2_tc_edge_add(struct olsrv2_tc_node *src, struct netaddr *addr) {
     inverse->cost[i] = RFC7181_METRIC_INFINITE;
   }
 
-  /* hook inverse edge into dst node */
-  inverse->_node.key = &src->target.prefix.dst;
-  avl_insert(&dst->_edges, &inverse->_node);
+  /* hook edge into src node and inverse edge into dst node */
+  if (_insert_edge(src, dst, edge)) {
+    _free_edge_pair(edge, inverse, virtual_dst);
+    return NULL;
+  }
+  if (_insert_edge(dst, src, inverse)) {
+    _unhook_edge(edge);
+    _free_edge_pair(edge, inverse, virtual_dst);
+    return NULL;
+  }
 
   /* fire event */
   oonf_class_event(&_tc_edge_class, edge, OONF_OBJECT_ADDED);
@@ -326,7 +374,7 @@ olsrv2_tc_edge_add(struct olsrv2_tc_node *src, struct netaddr *addr) {
 bool
 olsrv2_tc_edge_remove(struct olsrv2_tc_edge *edge) {
   /* all domains might have changed */
-  olsrv2_routing_domain_changed(NULL, true);
+  olsrv2_routing_domain_changed_ext(NULL, true, OLSRV2_ROUTING_CAUSE_TOPOLOGY);
 
   return _remove_edge(edge, true);
 }
@@ -355,7 +403,7 @@ olsrv2_tc_endpoint_add(struct olsrv2_tc_node *node, struct os_route_key *prefix,
     return NULL;
   }
 
-  end = avl_find_element(&_tc_endpoint_tree, prefix, end, _node);
+  end = hashmap_find_element(&_tc_endpoint_hash, prefix, end, _hnode);
   if (end == NULL) {
     /* create new endpoint */
     end = oonf_class_malloc(&_tc_endpoint_class);
@@ -368,8 +416,14 @@ olsrv2_tc_endpoint_add(struct olsrv2_tc_node *node, struct os_route_key *prefix,
     end->target.type = mesh ? OLSRV2_ADDRESS_TARGET : OLSRV2_NETWORK_TARGET;
     avl_init(&end->_attached_networks, os_routing_avl_cmp_route_key, false);
 
-    /* attach to global tree */
+    /* attach to global hash index and tree */
     memcpy(&end->target.prefix, prefix, sizeof(*prefix));
+    end->_hnode.key = &end->target.prefix;
+    if (hashmap_insert(&_tc_endpoint_hash, &end->_hnode)) {
+      oonf_class_free(&_tc_endpoint_class, end);
+      oonf_class_free(&_tc_attached_class, net);
+      return NULL;
+    }
     end->_node.key = &end->target.prefix;
     avl_insert(&_tc_endpoint_tree, &end->_node);
 
@@ -417,6 +471,7 @@ olsrv2_tc_endpoint_remove(struct olsrv2_tc_attachment *net) {
 
     /* remove endpoint */
     avl_remove(&_tc_endpoint_tree, &net->dst->_node);
+    hashmap_remove(&_tc_endpoint_hash, &net->dst->_hnode);
     oonf_class_free(&_tc_endpoint_class, net->dst);
   }
 
@@ -424,7 +479,7 @@ olsrv2_tc_endpoint_remove(struct olsrv2_tc_attachment *net) {
   oonf_class_free(&_tc_attached_class, net);
 
   /* all domains might have changed */
-  olsrv2_routing_domain_changed(NULL, true);
+  olsrv2_routing_domain_changed_ext(NULL, true, OLSRV2_ROUTING_CAUSE_TOPOLOGY);
 }
 
 /**
@@ -495,8 +550,8 @@ _remove_edge(struct olsrv2_tc_edge *edge, bool cleanup) {
   }
 
   /* unhook edge from both sides */
-  avl_remove(&edge->src->_edges, &edge->_node);
-  avl_remove(&edge->dst->_edges, &edge->inverse->_node);
+  _unhook_edge(edge);
+  _unhook_edge(edge->inverse);
 
   if (edge->dst->_edges.count == 0 && cleanup && olsrv2_tc_is_node_virtual(edge->dst)) {
     /*
@@ -514,6 +569,87 @@ _remove_edge(struct olsrv2_tc_edge *edge, bool cleanup) {
   return removed_node;
 }
 
+/**
+ * Hook a tc edge into its source node and the global edge index
+ * @param src source node of edge
+ * @param dst destination node of edge
+ * @param edge pointer to tc edge
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_insert_edge(struct olsrv2_tc_node *src, struct olsrv2_tc_node *dst, struct olsrv2_tc_edge *edge) {
+  memcpy(&edge->_key.src, &src->target.prefix.dst, sizeof(edge->_key.src));
+  memcpy(&edge->_key.dst, &dst->target.prefix.dst, sizeof(edge->_key.dst));
+  edge->_hnode.key = &edge->_key;
+  if (hashmap_insert(&_tc_edge_hash, &edge->_hnode)) {
+    return -1;
+  }
+
+  edge->_node.key = &dst->target.prefix.dst;
+  avl_insert(&src->_edges, &edge->_node);
+  return 0;
+}
+
+/**
+ * Remove a tc edge from its source node and the global edge index
+ * @param edge pointer to tc edge
+ */
+static void
+_unhook_edge(struct olsrv2_tc_edge *edge) {
+  avl_remove(&edge->src->_edges, &edge->_node);
+  hashmap_remove(&_tc_edge_hash, &edge->_hnode);
+}
+
+/**
+ * Free a tc edge and its inverse edge that could not be added
+ * to the database
+ * @param edge pointer to tc edge
+ * @param inverse pointer to inverse tc edge
+ * @param virtual_dst virtual destination node created for the edge,
+ *   NULL if the node was already in the database
+ */
+static void
+_free_edge_pair(struct olsrv2_tc_edge *edge, struct olsrv2_tc_edge *inverse, struct olsrv2_tc_node *virtual_dst) {
+  oonf_class_free(&_tc_edge_class, edge);
+  oonf_class_free(&_tc_edge_class, inverse);
+
+  if (virtual_dst) {
+    /* virtual node has no other edges */
+    olsrv2_tc_node_remove(virtual_dst);
+  }
+}
+
+/**
+ * Hash function for tc edge keys
+ * @param key pointer to olsrv2_tc_edge_key
+ * @return hash value
+ */
+static uint32_t
+_hash_edge_key(const void *key) {
+  return hashmap_hash_bytes(key, sizeof(struct olsrv2_tc_edge_key));
+}
+
+/**
+ * Comparator for tc edge keys
+ * @param k1 pointer to first olsrv2_tc_edge_key
+ * @param k2 pointer to second olsrv2_tc_edge_key
+ * @return 0 if both keys are equal
+ */
+static int
+_avl_comp_edge_key(const void *k1, const void *k2) {
+  return memcmp(k1, k2, sizeof(struct olsrv2_tc_edge_key));
+}
+
+/**
+ * Hash function for os_route_key keys
+ * @param key pointer to os_route_key
+ * @return hash value
+ */
+static uint32_t
+_hash_route_key(const void *key) {
+  return hashmap_hash_bytes(key, sizeof(struct os_route_key));
+}
+
 static void
 _cb_neighbor_change(void *ptr) {
   struct nhdp_neighbor *neigh;
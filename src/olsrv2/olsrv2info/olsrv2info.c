@@ -83,6 +83,8 @@ static void _initialize_node_values(struct olsrv2_tc_node *);
 static void _initialize_attached_network_values(struct olsrv2_tc_attachment *edge);
 static void _initialize_edge_values(struct olsrv2_tc_edge *edge);
 static void _initialize_route_values(struct olsrv2_routing_entry *route);
+static void _initialize_routing_stats_values(struct nhdp_domain *domain);
+static void _initialize_dijkstra_values(const struct olsrv2_routing_dijkstra_run *run);
 
 static int _cb_create_text_originator(struct oonf_viewer_template *);
 static int _cb_create_text_old_originator(struct oonf_viewer_template *);
@@ -91,6 +93,8 @@ static int _cb_create_text_node(struct oonf_viewer_template *);
 static int _cb_create_text_attached_network(struct oonf_viewer_template *);
 static int _cb_create_text_edge(struct oonf_viewer_template *);
 static int _cb_create_text_route(struct oonf_viewer_template *);
+static int _cb_create_text_routing_stats(struct oonf_viewer_template *);
+static int _cb_create_text_dijkstra(struct oonf_viewer_template *);
 
 /*
  * list of template keys and corresponding buffers for values.
@@ -197,6 +201,48 @@ static int _cb_create_text_route(struct oonf_viewer_template *);
 /*! template key for the last hop before the route destination */
 #define KEY_ROUTE_LASTHOP "route_lasthop"
 
+/*! template key for routes suppressed by route dampening */
+#define KEY_ROUTE_SUPPRESSED "route_suppressed"
+
+/*! template key for number of additional next hops of multipath routes */
+#define KEY_ROUTE_MULTIPATH "route_multipath"
+
+/*! template key for number of next-hop changes sent to the kernel */
+#define KEY_ROUTING_NEXTHOP_CHANGES "routing_nexthop_changes"
+
+/*! template key for number of next-hop changes suppressed by route dampening */
+#define KEY_ROUTING_SUPPRESSED_CHANGES "routing_suppressed_changes"
+
+/*! template key for number of routes currently suppressed by route dampening */
+#define KEY_ROUTING_SUPPRESSED_ROUTES "routing_suppressed_routes"
+
+/*! template key for number of routes currently using multiple next hops */
+#define KEY_ROUTING_MULTIPATH_ROUTES "routing_multipath_routes"
+
+/*! template key for number of kernel routes adopted by kernel audit */
+#define KEY_ROUTING_AUDIT_ADOPTED "routing_audit_adopted"
+
+/*! template key for number of kernel routes repaired by kernel audit */
+#define KEY_ROUTING_AUDIT_REPAIRED "routing_audit_repaired"
+
+/*! template key for total number of dijkstra runs */
+#define KEY_ROUTING_DIJKSTRA_RUNS "routing_dijkstra_runs"
+
+/*! template key for time since a dijkstra run */
+#define KEY_DIJKSTRA_AGE "dijkstra_age"
+
+/*! template key for time between first trigger and dijkstra run */
+#define KEY_DIJKSTRA_DELAY "dijkstra_delay"
+
+/*! template key for hold time after dijkstra run */
+#define KEY_DIJKSTRA_HOLD "dijkstra_hold"
+
+/*! template key for duration of dijkstra run in microseconds */
+#define KEY_DIJKSTRA_DURATION "dijkstra_duration"
+
+/*! template key for causes of dijkstra run */
+#define KEY_DIJKSTRA_CAUSE "dijkstra_cause"
+
 /*
  * buffer space for values that will be assembled
  * into the output of the plugin
@@ -239,6 +285,22 @@ static char _value_route_proto[4];
 static char _value_route_if[IF_NAMESIZE];
 static char _value_route_ifindex[12];
 static struct netaddr_str _value_route_lasthop;
+static char _value_route_suppressed[TEMPLATE_JSON_BOOL_LENGTH];
+static char _value_route_multipath[4];
+
+static char _value_routing_nexthop_changes[11];
+static char _value_routing_suppressed_changes[11];
+static char _value_routing_suppressed_routes[11];
+static char _value_routing_multipath_routes[11];
+static char _value_routing_audit_adopted[11];
+static char _value_routing_audit_repaired[11];
+static char _value_routing_dijkstra_runs[11];
+
+static struct isonumber_str _value_dijkstra_age;
+static struct isonumber_str _value_dijkstra_delay;
+static struct isonumber_str _value_dijkstra_hold;
+static char _value_dijkstra_duration[21];
+static struct olsrv2_routing_cause_str _value_dijkstra_cause;
 
 /* definition of the template data entries for JSON and table output */
 static struct abuf_template_data_entry _tde_originator[] = {
@@ -307,6 +369,26 @@ static struct abuf_template_data_entry _tde_route[] = {
   { KEY_ROUTE_IF, _value_route_if, true },
   { KEY_ROUTE_IFINDEX, _value_route_ifindex, false },
   { KEY_ROUTE_LASTHOP, _value_route_lasthop.buf, true },
+  { KEY_ROUTE_SUPPRESSED, _value_route_suppressed, true },
+  { KEY_ROUTE_MULTIPATH, _value_route_multipath, false },
+};
+
+static struct abuf_template_data_entry _tde_routing_stats[] = {
+  { KEY_ROUTING_NEXTHOP_CHANGES, _value_routing_nexthop_changes, false },
+  { KEY_ROUTING_SUPPRESSED_CHANGES, _value_routing_suppressed_changes, false },
+  { KEY_ROUTING_SUPPRESSED_ROUTES, _value_routing_suppressed_routes, false },
+  { KEY_ROUTING_MULTIPATH_ROUTES, _value_routing_multipath_routes, false },
+  { KEY_ROUTING_AUDIT_ADOPTED, _value_routing_audit_adopted, false },
+  { KEY_ROUTING_AUDIT_REPAIRED, _value_routing_audit_repaired, false },
+  { KEY_ROUTING_DIJKSTRA_RUNS, _value_routing_dijkstra_runs, false },
+};
+
+static struct abuf_template_data_entry _tde_dijkstra[] = {
+  { KEY_DIJKSTRA_AGE, _value_dijkstra_age.buf, false },
+  { KEY_DIJKSTRA_DELAY, _value_dijkstra_delay.buf, false },
+  { KEY_DIJKSTRA_HOLD, _value_dijkstra_hold.buf, false },
+  { KEY_DIJKSTRA_DURATION, _value_dijkstra_duration, false },
+  { KEY_DIJKSTRA_CAUSE, _value_dijkstra_cause.buf, true },
 };
 
 static struct abuf_template_storage _template_storage;
@@ -346,6 +428,14 @@ static struct abuf_template_data _td_route[] = {
   { _tde_domain_metric_out, ARRAYSIZE(_tde_domain_metric_out) },
   { _tde_domain_path_hops, ARRAYSIZE(_tde_domain_path_hops) },
 };
+static struct abuf_template_data _td_routing_stats[] = {
+  { _tde_domain, ARRAYSIZE(_tde_domain) },
+  { _tde_routing_stats, ARRAYSIZE(_tde_routing_stats) },
+};
+static struct abuf_template_data _td_dijkstra[] = {
+  { _tde_domain, ARRAYSIZE(_tde_domain) },
+  { _tde_dijkstra, ARRAYSIZE(_tde_dijkstra) },
+};
 
 /* OONF viewer templates (based on Template Data arrays) */
 static struct oonf_viewer_template _templates[] = { {
@@ -389,6 +479,18 @@ static struct oonf_viewer_template _templates[] = { {
     .data_size = ARRAYSIZE(_td_route),
     .json_name = "route",
     .cb_function = _cb_create_text_route,
+  },
+  {
+    .data = _td_routing_stats,
+    .data_size = ARRAYSIZE(_td_routing_stats),
+    .json_name = "routing_stats",
+    .cb_function = _cb_create_text_routing_stats,
+  },
+  {
+    .data = _td_dijkstra,
+    .data_size = ARRAYSIZE(_td_dijkstra),
+    .json_name = "dijkstra",
+    .cb_function = _cb_create_text_dijkstra,
   } };
 
 /* telnet command of this plugin */
@@ -592,6 +694,42 @@ _initialize_route_values(struct olsrv2_routing_entry *route) {
   snprintf(_value_route_ifindex, sizeof(_value_route_ifindex), "%u", route->route.p.if_index);
 
   netaddr_to_string(&_value_route_lasthop, &route->last_originator);
+
+  strscpy(_value_route_suppressed, json_getbool(route->suppressed), sizeof(_value_route_suppressed));
+  snprintf(_value_route_multipath, sizeof(_value_route_multipath), "%u", route->route.p.multipath_count);
+}
+
+/**
+ * Initialize the value buffers for the routing statistics of a domain
+ * @param domain NHDP domain
+ */
+static void
+_initialize_routing_stats_values(struct nhdp_domain *domain) {
+  const struct olsrv2_routing_statistics *stats;
+
+  stats = olsrv2_routing_get_statistics(domain);
+
+  snprintf(_value_routing_nexthop_changes, sizeof(_value_routing_nexthop_changes), "%u", stats->nexthop_changes);
+  snprintf(
+    _value_routing_suppressed_changes, sizeof(_value_routing_suppressed_changes), "%u", stats->suppressed_changes);
+  snprintf(_value_routing_suppressed_routes, sizeof(_value_routing_suppressed_routes), "%u", stats->suppressed_routes);
+  snprintf(_value_routing_multipath_routes, sizeof(_value_routing_multipath_routes), "%u", stats->multipath_routes);
+  snprintf(_value_routing_audit_adopted, sizeof(_value_routing_audit_adopted), "%u", stats->audit_adopted);
+  snprintf(_value_routing_audit_repaired, sizeof(_value_routing_audit_repaired), "%u", stats->audit_repaired);
+  snprintf(_value_routing_dijkstra_runs, sizeof(_value_routing_dijkstra_runs), "%u", stats->dijkstra_runs);
+}
+
+/**
+ * Initialize the value buffers for a dijkstra run
+ * @param run dijkstra run statistics
+ */
+static void
+_initialize_dijkstra_values(const struct olsrv2_routing_dijkstra_run *run) {
+  oonf_clock_toIntervalString(&_value_dijkstra_age, oonf_clock_getNow() - run->timestamp);
+  oonf_clock_toIntervalString(&_value_dijkstra_delay, run->delay);
+  oonf_clock_toIntervalString(&_value_dijkstra_hold, run->hold);
+  snprintf(_value_dijkstra_duration, sizeof(_value_dijkstra_duration), "%" PRIu64, run->duration);
+  olsrv2_routing_cause_to_string(&_value_dijkstra_cause, run->causes);
 }
 
 /**
@@ -768,3 +906,44 @@ _cb_create_text_route(struct oonf_viewer_template *template) {
   }
   return 0;
 }
+
+/**
+ * Display the routing statistics of all domains
+ * @param template oonf viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_routing_stats(struct oonf_viewer_template *template) {
+  struct nhdp_domain *domain;
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    _initialize_domain_values(domain);
+    _initialize_routing_stats_values(domain);
+
+    oonf_viewer_output_print_line(template);
+  }
+  return 0;
+}
+
+/**
+ * Display the history of recent dijkstra runs of all domains
+ * @param template oonf viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_dijkstra(struct oonf_viewer_template *template) {
+  const struct olsrv2_routing_dijkstra_run *run;
+  struct nhdp_domain *domain;
+  uint32_t age;
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    _initialize_domain_values(domain);
+
+    for (age = 0; (run = olsrv2_routing_get_dijkstra_run(domain, age)) != NULL; age++) {
+      _initialize_dijkstra_values(run);
+
+      oonf_viewer_output_print_line(template);
+    }
+  }
+  return 0;
+}
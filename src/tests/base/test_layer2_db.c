@@ -0,0 +1,847 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <oonf/libcommon/autobuf.h>
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+#include <oonf/libconfig/cfg_db.h>
+#include <oonf/libconfig/cfg_schema.h>
+
+#include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_layer2.h>
+#include <oonf/base/os_interface.h>
+
+/*
+ * The layer2 database is linked directly into this test, memory
+ * classes, the clock and the interface listeners are replaced by
+ * the stubs below.
+ */
+
+/* number of neighbors per network */
+#define NEIGHBORS 100
+
+/* IPs per neighbor */
+#define NEIGH_ADDRS 3
+
+/* synthetic radio interface with many neighbors for the benchmark */
+#define BENCH_NEIGHBORS 500
+
+/* number of lookup rounds for benchmark */
+#define ROUNDS 20
+
+static struct oonf_layer2_origin origin = {
+  .name = "test",
+  .priority = OONF_LAYER2_ORIGIN_CONFIGURED,
+};
+
+static struct oonf_layer2_origin lid_origin = {
+  .name = "test lid",
+  .priority = OONF_LAYER2_ORIGIN_CONFIGURED,
+  .lid = true,
+};
+
+/* stubs for memory classes, clock and interfaces */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+/* copy of the change set of the last layer2 change event */
+static struct {
+  uint32_t count;
+  void *ptr;
+  bool changeset;
+  struct bitmap256 data, neighdata;
+  uint32_t modified;
+
+  /* change set of the last neighbor change event */
+  struct bitmap256 neigh_data;
+} changed_event;
+
+void
+oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+
+  if (evt != OONF_OBJECT_CHANGED) {
+    return;
+  }
+
+  changed_event.count++;
+  changed_event.ptr = ptr;
+  if (strcmp(c->name, LAYER2_CLASS_NEIGHBOR) == 0) {
+    l2neigh = ptr;
+    changed_event.changeset = oonf_layer2_neigh_has_changeset(l2neigh);
+    changed_event.data = l2neigh->modified_data;
+    changed_event.neigh_data = l2neigh->modified_data;
+    memset(&changed_event.neighdata, 0, sizeof(changed_event.neighdata));
+    changed_event.modified = l2neigh->modified;
+  }
+  else if (strcmp(c->name, LAYER2_CLASS_NETWORK) == 0) {
+    l2net = ptr;
+    changed_event.changeset = oonf_layer2_net_has_changeset(l2net);
+    changed_event.data = l2net->modified_data;
+    changed_event.neighdata = l2net->modified_neighdata;
+    changed_event.modified = l2net->modified;
+  }
+}
+
+/* current time of the clock stub */
+static uint64_t now;
+
+uint64_t
+oonf_clock_getNow(void) {
+  return now;
+}
+
+struct os_interface *
+os_interface_linux_add(struct os_interface_listener *if_listener __attribute__((unused))) {
+  return NULL;
+}
+
+void
+os_interface_linux_remove(struct os_interface_listener *if_listener __attribute__((unused))) {}
+
+static void
+create_mac(struct netaddr *mac, uint32_t idx) {
+  uint8_t bin[6] = { 2, 0, 0, 0, idx >> 8, idx & 255 };
+
+  netaddr_from_binary(mac, bin, sizeof(bin), AF_MAC48);
+}
+
+static void
+create_ip(struct netaddr *ip, uint8_t net, uint32_t idx, uint8_t prefix_len) {
+  uint8_t bin[4] = { 10, net, idx >> 8, idx & 255 };
+
+  netaddr_from_binary_prefix(ip, bin, sizeof(bin), AF_INET, prefix_len);
+}
+
+static struct oonf_layer2_neigh *
+add_neighbor(struct oonf_layer2_net *l2net, uint32_t idx) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct netaddr mac;
+
+  create_mac(&mac, idx);
+  l2neigh = oonf_layer2_neigh_add(l2net, &mac);
+  if (l2neigh) {
+    /* keep the neighbor in the database without IPs */
+    oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, 1000000, 1);
+  }
+  return l2neigh;
+}
+
+static void
+clear_elements(void) {
+  oonf_layer2_origin_remove(&origin);
+  oonf_layer2_origin_remove(&lid_origin);
+  oonf_layer2_origin_add(&origin);
+  oonf_layer2_origin_add(&lid_origin);
+  memset(&changed_event, 0, sizeof(changed_event));
+  now = 0;
+}
+
+static void
+test_neighbor_index(void) {
+  struct oonf_layer2_neigh_key key;
+  struct oonf_layer2_neigh *l2neigh, *lid_neigh[2];
+  struct oonf_layer2_net *l2net;
+  struct netaddr mac;
+  uint32_t i, found;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add("wlan0");
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+
+  found = 0;
+  for (i = 0; i < NEIGHBORS; i++) {
+    l2neigh = add_neighbor(l2net, i);
+    create_mac(&mac, i);
+    if (l2neigh != NULL && oonf_layer2_neigh_get(l2net, &mac) == l2neigh) {
+      found++;
+    }
+  }
+  CHECK_TRUE(found == NEIGHBORS, "found only %u neighbors", found);
+
+  /* two link ids for the same MAC are two neighbors */
+  create_mac(&mac, 1);
+  for (i = 0; i < 2; i++) {
+    lid_neigh[i] = NULL;
+    if (oonf_layer2_neigh_generate_lid(&key, &lid_origin, &mac) == 0) {
+      lid_neigh[i] = oonf_layer2_neigh_add_lid(l2net, &key);
+    }
+    if (lid_neigh[i]) {
+      /* let the neighbor be removed together with its origin */
+      oonf_layer2_data_set_int64(&lid_neigh[i]->data[OONF_LAYER2_NEIGH_RX_BITRATE], &lid_origin, NULL, 1000000, 1);
+    }
+    CHECK_TRUE(lid_neigh[i] != NULL && oonf_layer2_neigh_get_lid(l2net, &key) == lid_neigh[i],
+      "link id neighbor %u not found", i);
+  }
+  CHECK_TRUE(lid_neigh[0] != lid_neigh[1], "link ids did not create separate neighbors");
+  CHECK_TRUE(l2net->neighbors.count == NEIGHBORS + 2, "network has %u neighbors", l2net->neighbors.count);
+
+  /* removed neighbors disappear from the index */
+  create_mac(&mac, 7);
+  oonf_layer2_neigh_remove(oonf_layer2_neigh_get(l2net, &mac), &origin);
+  CHECK_TRUE(oonf_layer2_neigh_get(l2net, &mac) == NULL, "removed neighbor found");
+
+  END_TEST();
+}
+
+static void
+test_remote_ip_index(void) {
+  struct oonf_layer2_neighbor_address *l2ip;
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+  struct netaddr ip;
+  uint32_t i, a, found;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add("wlan0");
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+
+  found = 0;
+  for (i = 0; i < NEIGHBORS; i++) {
+    l2neigh = add_neighbor(l2net, i);
+    for (a = 0; l2neigh != NULL && a < NEIGH_ADDRS; a++) {
+      create_ip(&ip, a, i, 32);
+      l2ip = oonf_layer2_neigh_add_ip(l2neigh, &origin, &ip);
+      if (l2ip != NULL && oonf_layer2_net_get_remote_ip(l2net, &ip) == l2ip &&
+          oonf_layer2_net_get_best_neighbor_match(&ip) == l2ip &&
+          oonf_layer2_neigh_get_remote_ip(l2neigh, &ip) == l2ip) {
+        found++;
+      }
+    }
+  }
+  CHECK_TRUE(found == NEIGHBORS * NEIGH_ADDRS, "found only %u addresses", found);
+
+  /* removed IPs disappear from both indices */
+  create_ip(&ip, 0, 5, 32);
+  l2ip = oonf_layer2_net_get_remote_ip(l2net, &ip);
+  CHECK_TRUE(l2ip != NULL && oonf_layer2_neigh_remove_ip(l2ip, &origin) == 0, "could not remove IP");
+  CHECK_TRUE(oonf_layer2_net_get_remote_ip(l2net, &ip) == NULL, "removed IP found in index");
+  CHECK_TRUE(oonf_layer2_net_get_best_neighbor_match(&ip) == NULL, "removed IP found in prefix index");
+
+  END_TEST();
+}
+
+static void
+test_duplicate_ip(void) {
+  struct oonf_layer2_neighbor_address *l2ip[2];
+  struct oonf_layer2_neigh *l2neigh[2];
+  struct oonf_layer2_net *l2net;
+  struct netaddr ip;
+  uint32_t i;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add("wlan0");
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+
+  /* two neighbors of the network report the same IP */
+  create_ip(&ip, 0, 1, 32);
+  for (i = 0; i < 2; i++) {
+    l2neigh[i] = add_neighbor(l2net, i);
+    l2ip[i] = l2neigh[i] ? oonf_layer2_neigh_add_ip(l2neigh[i], &origin, &ip) : NULL;
+  }
+  CHECK_TRUE(l2ip[0] != NULL && l2ip[1] != NULL && l2ip[0] != l2ip[1], "duplicate IP not added to both neighbors");
+  if (l2ip[0] == NULL || l2ip[1] == NULL) {
+    END_TEST();
+    return;
+  }
+  CHECK_TRUE(oonf_layer2_net_get_remote_ip(l2net, &ip) == l2ip[0], "first IP not indexed");
+  CHECK_TRUE(l2net->remote_neighbor_ips.count == 2, "network tree has %u IPs", l2net->remote_neighbor_ips.count);
+
+  /* the second neighbor takes over the index when the first one loses the IP */
+  oonf_layer2_neigh_remove_ip(l2ip[0], &origin);
+  CHECK_TRUE(oonf_layer2_net_get_remote_ip(l2net, &ip) == l2ip[1], "duplicate IP did not take over index");
+  CHECK_TRUE(oonf_layer2_net_get_best_neighbor_match(&ip) == l2ip[1], "duplicate IP did not take over prefix index");
+
+  oonf_layer2_neigh_remove(l2neigh[1], &origin);
+  CHECK_TRUE(oonf_layer2_net_get_remote_ip(l2net, &ip) == NULL, "IP of removed neighbor found");
+  CHECK_TRUE(oonf_layer2_net_get_best_neighbor_match(&ip) == NULL, "IP of removed neighbor found in prefix index");
+
+  END_TEST();
+}
+
+static void
+test_best_match(void) {
+  struct oonf_layer2_neighbor_address *host, *subnet, *def;
+  struct oonf_layer2_neigh *l2neigh[2];
+  struct oonf_layer2_net *l2net[2];
+  struct netaddr ip;
+
+  START_TEST();
+
+  l2net[0] = oonf_layer2_net_add("wlan0");
+  l2net[1] = oonf_layer2_net_add("wlan1");
+  CHECK_TRUE(l2net[0] != NULL && l2net[1] != NULL, "layer2 networks not added");
+  if (!l2net[0] || !l2net[1]) {
+    END_TEST();
+    return;
+  }
+
+  /* the prefix index spans all networks */
+  l2neigh[0] = add_neighbor(l2net[0], 1);
+  l2neigh[1] = add_neighbor(l2net[1], 2);
+  CHECK_TRUE(l2neigh[0] != NULL && l2neigh[1] != NULL, "layer2 neighbors not added");
+  if (!l2neigh[0] || !l2neigh[1]) {
+    END_TEST();
+    return;
+  }
+
+  create_ip(&ip, 1, 0x0101, 32);
+  host = oonf_layer2_neigh_add_ip(l2neigh[0], &origin, &ip);
+  create_ip(&ip, 1, 0x0100, 24);
+  subnet = oonf_layer2_neigh_add_ip(l2neigh[1], &origin, &ip);
+  def = oonf_layer2_neigh_add_ip(l2neigh[1], &origin, &NETADDR_IPV4_ANY);
+  CHECK_TRUE(host != NULL && subnet != NULL && def != NULL, "IPs not added");
+
+  create_ip(&ip, 1, 0x0101, 32);
+  CHECK_TRUE(oonf_layer2_net_get_best_neighbor_match(&ip) == host, "host route not found");
+  create_ip(&ip, 1, 0x0102, 32);
+  CHECK_TRUE(oonf_layer2_net_get_best_neighbor_match(&ip) == subnet, "subnet not found");
+  create_ip(&ip, 2, 0x0102, 32);
+  CHECK_TRUE(oonf_layer2_net_get_best_neighbor_match(&ip) == def, "default route not found");
+  CHECK_TRUE(oonf_layer2_net_get_best_neighbor_match(&NETADDR_IPV6_ANY) == NULL,
+    "IPv6 address matched IPv4 default route");
+
+  END_TEST();
+}
+
+static void
+test_neigh_changeset(void) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+  struct netaddr ip;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add("wlan0");
+  l2neigh = l2net ? add_neighbor(l2net, 1) : NULL;
+  CHECK_TRUE(l2neigh != NULL, "layer2 neighbor not added");
+  if (!l2neigh) {
+    END_TEST();
+    return;
+  }
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(changed_event.count == 1 && changed_event.ptr == l2neigh, "no change event for neighbor");
+  CHECK_TRUE(changed_event.changeset, "change set not marked during event");
+  CHECK_TRUE(bitmap256_get(&changed_event.data, OONF_LAYER2_NEIGH_RX_BITRATE), "new rx bitrate not in change set");
+  CHECK_TRUE(!oonf_layer2_neigh_has_changeset(l2neigh), "change set still marked after event");
+  CHECK_TRUE(oonf_layer2_neigh_is_data_modified(l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE),
+    "data not reported as modified outside of change event");
+
+  /* only changed values are part of the change set */
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, 1000000, 1);
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_BITRATE], &origin, NULL, 2000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(changed_event.count == 2, "no change event for neighbor");
+  CHECK_TRUE(bitmap256_get(&changed_event.data, OONF_LAYER2_NEIGH_TX_BITRATE), "tx bitrate not in change set");
+  CHECK_TRUE(!bitmap256_get(&changed_event.data, OONF_LAYER2_NEIGH_RX_BITRATE), "unchanged rx bitrate in change set");
+  CHECK_TRUE(changed_event.modified == OONF_LAYER2_NEIGH_MODIFY_NONE, "neighbor modified flags set: %x",
+    changed_event.modified);
+
+  /* a commit without changes has an empty change set */
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_BITRATE], &origin, NULL, 2000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(changed_event.count == 3 && bitmap256_is_empty(&changed_event.data), "change set of same value not empty");
+
+  /* IP changes are reported by the modified flags */
+  create_ip(&ip, 0, 1, 32);
+  oonf_layer2_neigh_add_ip(l2neigh, &origin, &ip);
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(changed_event.count == 4 && bitmap256_is_empty(&changed_event.data), "IP change modified data");
+  CHECK_TRUE(changed_event.modified & OONF_LAYER2_NEIGH_MODIFY_REMOTE_IPS, "remote IP change not reported");
+  CHECK_TRUE(!oonf_layer2_neigh_is_modified(l2neigh, OONF_LAYER2_NEIGH_MODIFY_REMOTE_IPS),
+    "modified flags not reset after commit");
+
+  END_TEST();
+}
+
+static void
+test_net_changeset(void) {
+  struct oonf_layer2_peer_address *peer_ip;
+  struct oonf_layer2_net *l2net;
+  struct netaddr ip;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add("wlan0");
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+
+  oonf_layer2_data_set_int64(&l2net->data[OONF_LAYER2_NET_FREQUENCY_1], &origin, NULL, 2412000000, 1);
+  oonf_layer2_data_set_int64(&l2net->neighdata[OONF_LAYER2_NEIGH_TX_BITRATE], &origin, NULL, 1000000, 1);
+  oonf_layer2_net_commit(l2net);
+  CHECK_TRUE(changed_event.count == 1 && changed_event.ptr == l2net, "no change event for network");
+  CHECK_TRUE(changed_event.changeset, "change set not marked during event");
+  CHECK_TRUE(bitmap256_get(&changed_event.data, OONF_LAYER2_NET_FREQUENCY_1), "frequency not in change set");
+  CHECK_TRUE(bitmap256_get(&changed_event.neighdata, OONF_LAYER2_NEIGH_TX_BITRATE),
+    "neighbor default not in change set");
+  CHECK_TRUE(!oonf_layer2_net_has_changeset(l2net), "change set still marked after event");
+
+  /* a commit without changes has an empty change set */
+  oonf_layer2_data_set_int64(&l2net->data[OONF_LAYER2_NET_FREQUENCY_1], &origin, NULL, 2412000000, 1);
+  oonf_layer2_net_commit(l2net);
+  CHECK_TRUE(changed_event.count == 2, "no change event for network");
+  CHECK_TRUE(bitmap256_is_empty(&changed_event.data) && bitmap256_is_empty(&changed_event.neighdata),
+    "change set of same value not empty");
+  CHECK_TRUE(changed_event.modified == OONF_LAYER2_NET_MODIFY_NONE, "network modified flags set: %x",
+    changed_event.modified);
+
+  /* peer IP changes are reported by the modified flags */
+  create_ip(&ip, 0, 1, 32);
+  peer_ip = oonf_layer2_net_add_ip(l2net, &origin, &ip);
+  oonf_layer2_net_commit(l2net);
+  CHECK_TRUE(changed_event.count == 3 && (changed_event.modified & OONF_LAYER2_NET_MODIFY_PEER_IPS),
+    "peer IP change not reported");
+  CHECK_TRUE(!oonf_layer2_net_is_modified(l2net, OONF_LAYER2_NET_MODIFY_PEER_IPS),
+    "modified flags not reset after commit");
+
+  /* peer IPs are not removed together with their origin */
+  CHECK_TRUE(peer_ip != NULL && oonf_layer2_net_remove_ip(peer_ip, &origin) == 0, "could not remove peer IP");
+  oonf_layer2_net_commit(l2net);
+  CHECK_TRUE(changed_event.count == 4 && (changed_event.modified & OONF_LAYER2_NET_MODIFY_PEER_IPS),
+    "peer IP removal not reported");
+
+  END_TEST();
+}
+
+static void
+test_transaction(void) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add("wlan0");
+  l2neigh = l2net ? add_neighbor(l2net, 1) : NULL;
+  CHECK_TRUE(l2neigh != NULL, "layer2 neighbor not added");
+  if (!l2neigh) {
+    END_TEST();
+    return;
+  }
+  oonf_layer2_neigh_commit(l2neigh);
+  changed_event.count = 0;
+
+  /* commits inside a (nested) transaction are delayed */
+  oonf_layer2_transaction_start();
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_BITRATE], &origin, NULL, 2000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+
+  oonf_layer2_transaction_start();
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, 3000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  oonf_layer2_data_set_int64(&l2net->data[OONF_LAYER2_NET_FREQUENCY_1], &origin, NULL, 2412000000, 1);
+  oonf_layer2_net_commit(l2net);
+  oonf_layer2_transaction_commit();
+  CHECK_TRUE(changed_event.count == 0, "%u change events inside transaction", changed_event.count);
+
+  /* the outer commit triggers one event per object with the combined change set */
+  oonf_layer2_neigh_commit(l2neigh);
+  oonf_layer2_transaction_commit();
+  CHECK_TRUE(changed_event.count == 2, "%u change events for transaction", changed_event.count);
+  CHECK_TRUE(changed_event.ptr == l2net, "network not committed after neighbor");
+  CHECK_TRUE(bitmap256_get(&changed_event.neigh_data, OONF_LAYER2_NEIGH_TX_BITRATE) &&
+               bitmap256_get(&changed_event.neigh_data, OONF_LAYER2_NEIGH_RX_BITRATE),
+    "neighbor change set does not combine all commits");
+  CHECK_TRUE(bitmap256_get(&changed_event.data, OONF_LAYER2_NET_FREQUENCY_1), "frequency not in change set");
+
+  /* without a transaction every commit triggers an event */
+  changed_event.count = 0;
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_BITRATE], &origin, NULL, 4000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, 5000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(changed_event.count == 2, "%u change events without transaction", changed_event.count);
+  CHECK_TRUE(bitmap256_get(&changed_event.data, OONF_LAYER2_NEIGH_RX_BITRATE) &&
+               !bitmap256_get(&changed_event.data, OONF_LAYER2_NEIGH_TX_BITRATE),
+    "change set of single commit contains earlier commit");
+
+  END_TEST();
+}
+
+static void
+configure_history(struct oonf_subsystem *layer2, struct cfg_db *db) {
+  /* without a configuration section the defaults disable the history */
+  layer2->cfg_section->post = db ? cfg_db_find_unnamedsection(db, OONF_LAYER2_SUBSYSTEM) : NULL;
+  layer2->cfg_section->cb_delta_handler();
+}
+
+static void
+set_tx_sample(struct oonf_layer2_neigh *l2neigh, uint64_t time, int64_t value) {
+  now = time;
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_BITRATE], &origin, NULL, value, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+}
+
+static void
+test_history(struct oonf_subsystem *layer2) {
+  static const int64_t expected[] = { 50, 30, 30, 20 };
+  struct oonf_layer2_history_stats stats;
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+  struct cfg_db *db;
+  uint64_t timestamp;
+  int64_t value;
+  size_t i;
+
+  START_TEST();
+
+  /* keep the last four tx bitrate samples */
+  db = cfg_db_add();
+  CHECK_TRUE(db != NULL, "configuration database not allocated");
+  if (!db) {
+    END_TEST();
+    return;
+  }
+  cfg_db_overwrite_entry(db, OONF_LAYER2_SUBSYSTEM, NULL, "history_depth", "4");
+  cfg_db_add_entry(db, OONF_LAYER2_SUBSYSTEM, NULL, "history", "tx_bitrate");
+  configure_history(layer2, db);
+
+  CHECK_TRUE(oonf_layer2_neigh_is_history_index(OONF_LAYER2_NEIGH_TX_BITRATE), "tx bitrate has no history");
+  CHECK_TRUE(!oonf_layer2_neigh_is_history_index(OONF_LAYER2_NEIGH_RX_BITRATE), "rx bitrate has a history");
+
+  l2net = oonf_layer2_net_add("wlan0");
+  l2neigh = l2net ? add_neighbor(l2net, 1) : NULL;
+  CHECK_TRUE(l2neigh != NULL, "layer2 neighbor not added");
+  if (!l2neigh) {
+    configure_history(layer2, NULL);
+    cfg_db_remove(db);
+    END_TEST();
+    return;
+  }
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(oonf_layer2_neigh_get_history_count(l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE) == 0,
+    "history without tx bitrate");
+
+  /* a stable value is sampled again, the fifth sample overwrites the oldest one */
+  set_tx_sample(l2neigh, 1000, 10);
+  set_tx_sample(l2neigh, 2000, 20);
+  set_tx_sample(l2neigh, 3000, 30);
+  set_tx_sample(l2neigh, 4000, 30);
+  set_tx_sample(l2neigh, 5000, 50);
+  CHECK_TRUE(oonf_layer2_neigh_get_history_count(l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE) == 4,
+    "history has %zu samples", oonf_layer2_neigh_get_history_count(l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE));
+
+  for (i = 0; i < ARRAYSIZE(expected); i++) {
+    CHECK_TRUE(oonf_layer2_neigh_get_history_sample(&value, &timestamp, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, i) == 0
+      && value == expected[i] && timestamp == 5000 - 1000 * i,
+      "sample %zu: %" PRId64 " at %" PRIu64, i, value, timestamp);
+  }
+  CHECK_TRUE(oonf_layer2_neigh_get_history_sample(&value, NULL, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 4) != 0,
+    "sample beyond history depth found");
+
+  /* commits that do not set the value add no sample */
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, 2000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(oonf_layer2_neigh_get_history_sample(&value, &timestamp, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 0) == 0
+    && timestamp == 5000, "commit without tx bitrate added a sample");
+
+  /* nearest rank percentiles of 20, 30, 30, 50 */
+  CHECK_TRUE(oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 0, 50) == 0
+    && stats.count == 4 && stats.min == 20 && stats.max == 50 && stats.avg == 32 && stats.percentile == 30,
+    "stats: count=%u min=%" PRId64 " max=%" PRId64 " avg=%" PRId64 " median=%" PRId64,
+    stats.count, stats.min, stats.max, stats.avg, stats.percentile);
+  oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 0, 0);
+  CHECK_TRUE(stats.percentile == 20, "0th percentile is %" PRId64, stats.percentile);
+  oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 0, 26);
+  CHECK_TRUE(stats.percentile == 30, "26th percentile is %" PRId64, stats.percentile);
+  oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 0, 75);
+  CHECK_TRUE(stats.percentile == 30, "75th percentile is %" PRId64, stats.percentile);
+  oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 0, 100);
+  CHECK_TRUE(stats.percentile == 50, "100th percentile is %" PRId64, stats.percentile);
+
+  /* the window only contains samples of the last milliseconds */
+  now = 5500;
+  CHECK_TRUE(oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 1500, 50) == 0
+    && stats.count == 2 && stats.avg == 40 && stats.min == 30, "window of two samples has %u samples", stats.count);
+  CHECK_TRUE(oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 500, 50) == 0
+    && stats.count == 1 && stats.percentile == 50, "window of one sample has %u samples", stats.count);
+
+  now = 10000;
+  CHECK_TRUE(oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 1000, 50) != 0,
+    "window without samples has %u samples", stats.count);
+
+  /* a stable link keeps the window filled */
+  set_tx_sample(l2neigh, 10000, 50);
+  CHECK_TRUE(oonf_layer2_neigh_get_history_stats(&stats, l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE, 1000, 50) == 0
+    && stats.count == 1 && stats.avg == 50, "stable value not sampled");
+
+  /* disable the history again */
+  configure_history(layer2, NULL);
+  cfg_db_remove(db);
+
+  CHECK_TRUE(!oonf_layer2_neigh_is_history_index(OONF_LAYER2_NEIGH_TX_BITRATE), "history not disabled");
+  CHECK_TRUE(oonf_layer2_neigh_get_history_count(l2neigh, OONF_LAYER2_NEIGH_TX_BITRATE) == 0, "history not dropped");
+
+  END_TEST();
+}
+
+static void
+test_history_validation(struct oonf_subsystem *layer2) {
+  static const char *valid[] = { "tx_bitrate", "rx_bitrate", "latency", "rx_bc_loss" };
+  static const char *invalid[] = { "", "bitrate", "mcs_by_probing", "tx_bitrate2" };
+  struct cfg_schema_entry *entry;
+  struct autobuf out;
+  size_t i;
+
+  START_TEST();
+
+  entry = NULL;
+  for (i = 0; i < layer2->cfg_section->entry_count; i++) {
+    if (strcmp(layer2->cfg_section->entries[i].key.entry, "history") == 0) {
+      entry = &layer2->cfg_section->entries[i];
+    }
+  }
+  CHECK_TRUE(entry != NULL && entry->cb_validate != NULL, "no validator for history entry");
+  if (!entry || !entry->cb_validate || abuf_init(&out)) {
+    END_TEST();
+    return;
+  }
+
+  for (i = 0; i < ARRAYSIZE(valid); i++) {
+    CHECK_TRUE(entry->cb_validate(entry, OONF_LAYER2_SUBSYSTEM, valid[i], &out) == 0, "'%s' rejected: %s", valid[i],
+      abuf_getptr(&out));
+  }
+
+  /* only integer neighbor data indices can have a history */
+  for (i = 0; i < ARRAYSIZE(invalid); i++) {
+    abuf_clear(&out);
+    CHECK_TRUE(entry->cb_validate(entry, OONF_LAYER2_SUBSYSTEM, invalid[i], &out) != 0 && abuf_getlen(&out) > 0,
+      "'%s' accepted", invalid[i]);
+  }
+  for (i = 0; i < OONF_LAYER2_NEIGH_COUNT; i++) {
+    abuf_clear(&out);
+    CHECK_TRUE((entry->cb_validate(entry, OONF_LAYER2_SUBSYSTEM, oonf_layer2_neigh_metadata_get(i)->key, &out) == 0)
+      == (oonf_layer2_neigh_metadata_get(i)->type == OONF_LAYER2_INTEGER_DATA),
+      "validation of '%s' does not match its data type", oonf_layer2_neigh_metadata_get(i)->key);
+  }
+
+  abuf_free(&out);
+  END_TEST();
+}
+
+static struct oonf_layer2_neighbor_address *
+get_best_match_tree(struct oonf_layer2_net *l2net, const struct netaddr *addr) {
+  struct oonf_layer2_neighbor_address *best_match, *l2addr;
+  int prefix_length;
+
+  prefix_length = -1;
+  best_match = NULL;
+
+  avl_for_each_element(&l2net->remote_neighbor_ips, l2addr, _net_node) {
+    if (netaddr_is_in_subnet(&l2addr->ip, addr) && netaddr_get_prefix_length(&l2addr->ip) > prefix_length) {
+      best_match = l2addr;
+      prefix_length = netaddr_get_prefix_length(&l2addr->ip);
+    }
+  }
+  return best_match;
+}
+
+static uint64_t
+get_time_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void
+test_benchmark(void) {
+  static struct oonf_layer2_neighbor_address *best_match[BENCH_NEIGHBORS];
+  struct oonf_layer2_neighbor_address *l2addr;
+  struct oonf_layer2_neigh_key key;
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+  struct netaddr mac, ip;
+  uint64_t start, tree_time, index_time, scan_time, lpm_time;
+  uint32_t r, n, found_tree, found_index, found_scan, found_lpm;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add("wlan0");
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+
+  /* each neighbor has two router addresses and a /24 prefix */
+  for (n = 0; n < BENCH_NEIGHBORS; n++) {
+    l2neigh = add_neighbor(l2net, n);
+    if (!l2neigh) {
+      break;
+    }
+    create_ip(&ip, 0, n, 32);
+    oonf_layer2_neigh_add_ip(l2neigh, &origin, &ip);
+    create_ip(&ip, 1, n, 32);
+    oonf_layer2_neigh_add_ip(l2neigh, &origin, &ip);
+    create_ip(&ip, 100 + (n >> 8), (n & 255) << 8, 24);
+    oonf_layer2_neigh_add_ip(l2neigh, &origin, &ip);
+  }
+  CHECK_TRUE(l2net->remote_neighbor_ips.count == BENCH_NEIGHBORS * NEIGH_ADDRS, "network has %u IPs",
+    l2net->remote_neighbor_ips.count);
+
+  memset(&key, 0, sizeof(key));
+  found_tree = 0;
+  start = get_time_ns();
+  for (r = 0; r < ROUNDS; r++) {
+    for (n = 0; n < BENCH_NEIGHBORS; n++) {
+      create_mac(&key.addr, n);
+      create_ip(&ip, 1, n, 32);
+      found_tree += avl_find_element(&l2net->neighbors, &key, l2neigh, _node) != NULL;
+      found_tree += avl_find_element(&l2net->remote_neighbor_ips, &ip, l2addr, _net_node) != NULL;
+    }
+  }
+  tree_time = get_time_ns() - start;
+  CHECK_TRUE(found_tree == ROUNDS * BENCH_NEIGHBORS * 2, "tree found %u objects", found_tree);
+
+  found_index = 0;
+  start = get_time_ns();
+  for (r = 0; r < ROUNDS; r++) {
+    for (n = 0; n < BENCH_NEIGHBORS; n++) {
+      create_mac(&mac, n);
+      create_ip(&ip, 1, n, 32);
+      found_index += oonf_layer2_neigh_get(l2net, &mac) != NULL;
+      found_index += oonf_layer2_net_get_remote_ip(l2net, &ip) != NULL;
+    }
+  }
+  index_time = get_time_ns() - start;
+  CHECK_TRUE(found_tree == found_index, "tree found %u objects, index %u", found_tree, found_index);
+
+  /* addresses inside the prefixes of the neighbors */
+  found_scan = 0;
+  start = get_time_ns();
+  for (n = 0; n < BENCH_NEIGHBORS; n++) {
+    create_ip(&ip, 100 + (n >> 8), ((n & 255) << 8) | 1, 32);
+    best_match[n] = get_best_match_tree(l2net, &ip);
+    found_scan += best_match[n] != NULL;
+  }
+  scan_time = get_time_ns() - start;
+
+  found_lpm = 0;
+  start = get_time_ns();
+  for (n = 0; n < BENCH_NEIGHBORS; n++) {
+    create_ip(&ip, 100 + (n >> 8), ((n & 255) << 8) | 1, 32);
+    found_lpm += best_match[n] != NULL && oonf_layer2_net_get_best_neighbor_match(&ip) == best_match[n];
+  }
+  lpm_time = get_time_ns() - start;
+  CHECK_TRUE(found_scan == BENCH_NEIGHBORS && found_scan == found_lpm, "scan found %u prefixes, lpm %u", found_scan,
+    found_lpm);
+
+  printf("layer2 lookups (%u neighbors): avl %llu ns/lookup, hash index %llu ns/lookup\n", BENCH_NEIGHBORS,
+    (unsigned long long)(tree_time / (ROUNDS * BENCH_NEIGHBORS * 2)),
+    (unsigned long long)(index_time / (ROUNDS * BENCH_NEIGHBORS * 2)));
+  printf("best neighbor match (%u prefixes): scan %llu ns/lookup, lpm index %llu ns/lookup\n",
+    BENCH_NEIGHBORS * NEIGH_ADDRS, (unsigned long long)(scan_time / BENCH_NEIGHBORS),
+    (unsigned long long)(lpm_time / BENCH_NEIGHBORS));
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *layer2;
+
+  layer2 = oonf_subsystem_get(OONF_LAYER2_SUBSYSTEM);
+  if (layer2 == NULL || layer2->init()) {
+    return 1;
+  }
+
+  BEGIN_TESTING(clear_elements);
+
+  test_neighbor_index();
+  test_remote_ip_index();
+  test_duplicate_ip();
+  test_best_match();
+  test_neigh_changeset();
+  test_net_changeset();
+  test_transaction();
+  test_history(layer2);
+  test_history_validation(layer2);
+  test_benchmark();
+
+  oonf_layer2_origin_remove(&origin);
+  oonf_layer2_origin_remove(&lid_origin);
+  layer2->cleanup();
+  return FINISH_TESTING();
+}
@@ -0,0 +1,230 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+
+struct map_element {
+  struct netaddr addr;
+  struct avl_node anode;
+  struct hashmap_node hnode;
+};
+
+/* number of nodes of a large synthetic topology */
+#define COUNT 2000
+
+/* number of lookup rounds for benchmark */
+#define ROUNDS 100
+
+static struct hashmap map;
+static struct avl_tree tree;
+static struct map_element elements[COUNT];
+
+static void clear_elements(void) {
+  uint32_t i;
+
+  memset(&map, 0, sizeof(map));
+  memset(elements, 0, sizeof(elements));
+
+  for (i=0; i<COUNT; i++) {
+    /* IPv6 addresses 2001:db8::x */
+    uint8_t bin[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+
+    bin[14] = i >> 8;
+    bin[15] = i & 255;
+    netaddr_from_binary(&elements[i].addr, bin, sizeof(bin), AF_INET6);
+    elements[i].hnode.key = &elements[i].addr;
+    elements[i].anode.key = &elements[i].addr;
+  }
+  hashmap_init(&map, hashmap_hash_netaddr, avl_comp_netaddr);
+}
+
+static void add_elements(uint32_t count) {
+  uint32_t i;
+
+  for (i=0; i<count; i++) {
+    hashmap_insert(&map, &elements[i].hnode);
+  }
+}
+
+static void test_insert_find(void) {
+  struct map_element *e;
+  uint32_t i;
+  bool ok;
+
+  START_TEST();
+  CHECK_TRUE(hashmap_is_empty(&map), "hashmap not empty");
+  CHECK_TRUE(hashmap_find(&map, &elements[0].addr) == NULL, "found element in empty map");
+
+  add_elements(COUNT);
+  CHECK_TRUE(map.count == COUNT, "count is %u", map.count);
+  CHECK_TRUE(map._bucket_count >= COUNT, "only %u buckets for %u elements", map._bucket_count, map.count);
+
+  ok = true;
+  for (i=0; i<COUNT; i++) {
+    e = hashmap_find_element(&map, &elements[i].addr, e, hnode);
+    ok &= (e == &elements[i]);
+  }
+  CHECK_TRUE(ok, "could not find all elements");
+
+  hashmap_free(&map);
+  END_TEST();
+}
+
+static void test_duplicate(void) {
+  struct map_element dup;
+
+  START_TEST();
+  add_elements(10);
+
+  memset(&dup, 0, sizeof(dup));
+  memcpy(&dup.addr, &elements[5].addr, sizeof(dup.addr));
+  dup.hnode.key = &dup.addr;
+
+  CHECK_TRUE(hashmap_insert(&map, &dup.hnode) != 0, "duplicate key was inserted");
+  CHECK_TRUE(!hashmap_is_node_added(&dup.hnode), "duplicate node is in map");
+  CHECK_TRUE(map.count == 10, "count is %u", map.count);
+
+  hashmap_free(&map);
+  END_TEST();
+}
+
+static void test_remove(void) {
+  struct map_element *e;
+  uint32_t i;
+  bool ok;
+
+  START_TEST();
+  add_elements(COUNT);
+
+  for (i=0; i<COUNT; i+=2) {
+    hashmap_remove(&map, &elements[i].hnode);
+  }
+  CHECK_TRUE(map.count == COUNT/2, "count is %u", map.count);
+
+  ok = true;
+  for (i=0; i<COUNT; i++) {
+    e = hashmap_find_element(&map, &elements[i].addr, e, hnode);
+    ok &= (i % 2 == 0) ? (e == NULL) : (e == &elements[i]);
+  }
+  CHECK_TRUE(ok, "lookup after removal failed");
+  CHECK_TRUE(!hashmap_is_node_added(&elements[0].hnode), "removed node still added");
+
+  /* removing twice must not change the map */
+  hashmap_remove(&map, &elements[0].hnode);
+  CHECK_TRUE(map.count == COUNT/2, "count is %u", map.count);
+
+  hashmap_free(&map);
+  END_TEST();
+}
+
+static uint64_t get_time_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void test_benchmark(void) {
+  struct map_element *e;
+  uint64_t start, avl_time, hash_time;
+  uint32_t i, r, found;
+
+  START_TEST();
+  avl_init(&tree, avl_comp_netaddr, false);
+  for (i=0; i<COUNT; i++) {
+    avl_insert(&tree, &elements[i].anode);
+  }
+  add_elements(COUNT);
+
+  found = 0;
+  start = get_time_ns();
+  for (r=0; r<ROUNDS; r++) {
+    for (i=0; i<COUNT; i++) {
+      e = avl_find_element(&tree, &elements[(i * 7) % COUNT].addr, e, anode);
+      found += e != NULL;
+    }
+  }
+  avl_time = get_time_ns() - start;
+  CHECK_TRUE(found == COUNT * ROUNDS, "avl found %u elements", found);
+
+  found = 0;
+  start = get_time_ns();
+  for (r=0; r<ROUNDS; r++) {
+    for (i=0; i<COUNT; i++) {
+      e = hashmap_find_element(&map, &elements[(i * 7) % COUNT].addr, e, hnode);
+      found += e != NULL;
+    }
+  }
+  hash_time = get_time_ns() - start;
+  CHECK_TRUE(found == COUNT * ROUNDS, "hashmap found %u elements", found);
+
+  printf("%u lookups in %u addresses: avl %llu ns/lookup, hashmap %llu ns/lookup\n",
+      COUNT * ROUNDS, COUNT,
+      (unsigned long long)(avl_time / (COUNT * ROUNDS)),
+      (unsigned long long)(hash_time / (COUNT * ROUNDS)));
+
+  hashmap_free(&map);
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  BEGIN_TESTING(clear_elements);
+
+  test_insert_find();
+  test_duplicate();
+  test_remove();
+  test_benchmark();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,457 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+#include <oonf/libconfig/cfg_db.h>
+#include <oonf/libconfig/cfg_schema.h>
+
+#include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_layer2.h>
+#include <oonf/base/oonf_telnet.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/base/oonf_viewer.h>
+#include <oonf/base/os_clock.h>
+#include <oonf/base/os_interface.h>
+
+#include <oonf/generic/layer2_generator/layer2_generator.h>
+
+/*
+ * The layer2 generator plugin and the layer2 database are linked directly
+ * into this test, memory classes, timers, the telnet viewer and the
+ * interface listeners are replaced by the stubs below.
+ */
+
+/* number of neighbor data indices, all of them are integer data */
+#define NEIGH_DATA (OONF_LAYER2_NEIGH_COUNT)
+
+static struct oonf_subsystem *plugin;
+static struct oonf_timer_instance *event_timer;
+
+/* number of layer2 neighbor change events */
+static uint32_t neigh_events;
+
+/* stubs for memory classes, clock, timers, telnet and interfaces */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *c, void *ptr __attribute__((unused)), enum oonf_class_event evt) {
+  if (evt == OONF_OBJECT_CHANGED && strcmp(c->name, LAYER2_CLASS_NEIGHBOR) == 0) {
+    neigh_events++;
+  }
+}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return 0;
+}
+
+int
+os_clock_linux_gettime64_ns(uint64_t *t64) {
+  *t64 = 0;
+  return 0;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_start_ext(struct oonf_timer_instance *timer, uint64_t first __attribute__((unused)),
+  uint64_t interval __attribute__((unused))) {
+  event_timer = timer;
+}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first __attribute__((unused)),
+  uint64_t interval __attribute__((unused))) {
+  event_timer = timer;
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer __attribute__((unused))) {}
+
+int
+oonf_telnet_add(struct oonf_telnet_command *command __attribute__((unused))) {
+  return 0;
+}
+
+void
+oonf_telnet_remove(struct oonf_telnet_command *command __attribute__((unused))) {}
+
+enum oonf_telnet_result
+oonf_viewer_telnet_handler(struct autobuf *out __attribute__((unused)),
+  struct abuf_template_storage *storage __attribute__((unused)), const char *cmd __attribute__((unused)),
+  const char *param __attribute__((unused)), struct oonf_viewer_template *templates __attribute__((unused)),
+  size_t count __attribute__((unused))) {
+  return TELNET_RESULT_ACTIVE;
+}
+
+enum oonf_telnet_result
+oonf_viewer_telnet_help(struct autobuf *out __attribute__((unused)), const char *cmd __attribute__((unused)),
+  const char *param __attribute__((unused)), struct oonf_viewer_template *templates __attribute__((unused)),
+  size_t count __attribute__((unused))) {
+  return TELNET_RESULT_ACTIVE;
+}
+
+void
+oonf_viewer_output_print_line(struct oonf_viewer_template *template __attribute__((unused))) {}
+
+struct os_interface *
+os_interface_linux_add(struct os_interface_listener *if_listener __attribute__((unused))) {
+  return NULL;
+}
+
+void
+os_interface_linux_remove(struct os_interface_listener *if_listener __attribute__((unused))) {}
+
+/* apply a generator configuration, all other settings keep their defaults */
+static void
+configure(const char **settings, size_t count) {
+  struct cfg_db *db;
+  size_t i;
+
+  db = cfg_db_add();
+  cfg_db_overwrite_entry(db, OONF_L2GEN_SUBSYSTEM, NULL, "active", "true");
+  for (i = 0; i + 1 < count; i += 2) {
+    cfg_db_overwrite_entry(db, OONF_L2GEN_SUBSYSTEM, NULL, settings[i], settings[i + 1]);
+  }
+
+  plugin->cfg_section->post = cfg_db_find_namedsection(db, OONF_L2GEN_SUBSYSTEM, NULL);
+  plugin->cfg_section->cb_delta_handler();
+  plugin->cfg_section->post = NULL;
+
+  cfg_db_remove(db);
+}
+
+/* trigger one generator event and count the neighbor change events */
+static uint32_t
+generate(void) {
+  neigh_events = 0;
+  event_timer->class->callback(event_timer);
+  return neigh_events;
+}
+
+/* get a generated neighbor by its number */
+static struct oonf_layer2_neigh *
+get_neighbor(const char *if_name, uint32_t number) {
+  struct oonf_layer2_neigh_key key;
+  struct oonf_layer2_net *l2net;
+  uint8_t mac[6] = { 2, 0, 0, 0, 0, 1 };
+
+  l2net = oonf_layer2_net_get(if_name);
+  if (!l2net) {
+    return NULL;
+  }
+
+  number += 1;
+  mac[4] = (number >> 8) & 0xff;
+  mac[5] = number & 0xff;
+  memset(&key, 0, sizeof(key));
+  netaddr_from_binary(&key.addr, mac, sizeof(mac), AF_MAC48);
+  return oonf_layer2_neigh_get_lid(l2net, &key);
+}
+
+/* internal value of a neighbor data index */
+static int64_t
+get_value(struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx) {
+  return oonf_layer2_data_get_int64(&l2neigh->data[idx], oonf_layer2_neigh_metadata_get(idx)->scaling, INT64_MIN);
+}
+
+static size_t
+get_neighbor_count(const char *if_name) {
+  struct oonf_layer2_net *l2net;
+
+  l2net = oonf_layer2_net_get(if_name);
+  return l2net ? l2net->neighbors.count : 0;
+}
+
+static void
+clear_elements(void) {
+  /* an inactive generator drops all generated data */
+  static const char *inactive[] = { "active", "false" };
+
+  configure(inactive, ARRAYSIZE(inactive));
+}
+
+static void
+test_neighbors(void) {
+  static const char *settings[] = { "interfaces", "2", "neighbors", "50", "neighbor_ips", "3" };
+  struct oonf_layer2_neigh *l2neigh;
+  uint32_t i, events, found;
+
+  START_TEST();
+
+  configure(settings, ARRAYSIZE(settings));
+  events = generate();
+  CHECK_TRUE(events == 100, "%u neighbor events for new neighbors", events);
+  CHECK_TRUE(get_neighbor_count("eth0") == 50 && get_neighbor_count("eth0-1") == 50,
+    "generated %zu and %zu neighbors", get_neighbor_count("eth0"), get_neighbor_count("eth0-1"));
+  CHECK_TRUE(oonf_layer2_net_get("eth0-2") == NULL, "third interface generated");
+
+  /* mac addresses are counted up from the configured neighbor */
+  found = 0;
+  for (i = 0; i < 50; i++) {
+    l2neigh = get_neighbor("eth0-1", i);
+    if (l2neigh && l2neigh->remote_neighbor_ips.count == 3 && l2neigh->destinations.count == 1) {
+      found++;
+    }
+  }
+  CHECK_TRUE(found == 50, "found only %u neighbors with 3 IPs and a destination", found);
+
+  /* existing neighbors are updated, not added again */
+  events = generate();
+  CHECK_TRUE(events == 100, "%u neighbor events for updated neighbors", events);
+  l2neigh = get_neighbor("eth0", 49);
+  CHECK_TRUE(get_neighbor_count("eth0") == 50 && l2neigh != NULL && l2neigh->remote_neighbor_ips.count == 3,
+    "neighbors changed by update");
+
+  END_TEST();
+}
+
+static void
+test_mac_carry(void) {
+  static const char *settings[] = { "neighbor", "02:00:00:00:01:ff", "neighbors", "2" };
+  struct oonf_layer2_neigh_key key;
+  struct oonf_layer2_net *l2net;
+
+  START_TEST();
+
+  /* the neighbor number is added to the two lower octets of the mac */
+  configure(settings, ARRAYSIZE(settings));
+  generate();
+  l2net = oonf_layer2_net_get("eth0");
+  memset(&key, 0, sizeof(key));
+  CHECK_TRUE(netaddr_from_string(&key.addr, "02:00:00:00:02:00") == 0 && l2net != NULL && l2net->neighbors.count == 2
+      && oonf_layer2_neigh_get_lid(l2net, &key) != NULL,
+    "second neighbor mac did not carry into the fifth octet");
+
+  END_TEST();
+}
+
+static void
+test_update_churn(void) {
+  static const char *no_update[] = { "neighbors", "200", "update", "0" };
+  static const char *full_churn[] = { "neighbors", "20", "churn", "100" };
+  uint32_t i, events;
+
+  START_TEST();
+
+  /* without updates only new neighbors are committed */
+  configure(no_update, ARRAYSIZE(no_update));
+  events = generate();
+  CHECK_TRUE(events == 200 && get_neighbor_count("eth0") == 200, "%u events for new neighbors", events);
+  events = 0;
+  for (i = 0; i < 5; i++) {
+    events += generate();
+  }
+  CHECK_TRUE(events == 0 && get_neighbor_count("eth0") == 200, "%u events without updates", events);
+
+  /* with full churn all neighbors disappear and reappear with the next event */
+  configure(full_churn, ARRAYSIZE(full_churn));
+  CHECK_TRUE(get_neighbor_count("eth0") == 0, "configuration change did not drop generated neighbors");
+  generate();
+  CHECK_TRUE(get_neighbor_count("eth0") == 20, "%zu neighbors generated", get_neighbor_count("eth0"));
+  generate();
+  CHECK_TRUE(get_neighbor_count("eth0") == 0, "%zu neighbors left after churn", get_neighbor_count("eth0"));
+  generate();
+  CHECK_TRUE(get_neighbor_count("eth0") == 20, "%zu neighbors reappeared", get_neighbor_count("eth0"));
+
+  END_TEST();
+}
+
+static void
+test_distribution(void) {
+  static const char *counter[] = { "distribution", "counter" };
+  static const char *uniform[] = { "distribution", "uniform", "value_min", "-5", "value_max", "5" };
+  static const char *walk[] = { "distribution", "walk", "value_min", "0", "value_max", "1000" };
+  static const char *inverted[] = { "distribution", "uniform", "value_min", "7", "value_max", "3" };
+  int64_t first, previous[NEIGH_DATA], value;
+  struct oonf_layer2_neigh *l2neigh;
+  uint32_t i, e, wrong, changed;
+
+  START_TEST();
+
+  /* all values are the event counter */
+  configure(counter, ARRAYSIZE(counter));
+  generate();
+  l2neigh = get_neighbor("eth0", 0);
+  CHECK_TRUE(l2neigh != NULL, "no neighbor generated");
+  if (!l2neigh) {
+    END_TEST();
+    return;
+  }
+  first = get_value(l2neigh, 0);
+  wrong = 0;
+  for (i = 0; i < NEIGH_DATA; i++) {
+    wrong += get_value(l2neigh, i) != first;
+  }
+  CHECK_TRUE(wrong == 0, "%u values differ from the event counter", wrong);
+  generate();
+  CHECK_TRUE(get_value(l2neigh, NEIGH_DATA - 1) == first + 1, "counter did not advance");
+
+  /* uniform values stay inside the value range */
+  configure(uniform, ARRAYSIZE(uniform));
+  wrong = 0;
+  for (e = 0; e < 20; e++) {
+    generate();
+    l2neigh = get_neighbor("eth0", 0);
+    for (i = 0; l2neigh != NULL && i < NEIGH_DATA; i++) {
+      value = get_value(l2neigh, i);
+      wrong += value < -5 || value > 5;
+    }
+  }
+  CHECK_TRUE(l2neigh != NULL && wrong == 0, "%u uniform values outside of range", wrong);
+
+  /* a random walk moves at most 10% of the range per event */
+  configure(walk, ARRAYSIZE(walk));
+  generate();
+  l2neigh = get_neighbor("eth0", 0);
+  for (i = 0; l2neigh != NULL && i < NEIGH_DATA; i++) {
+    previous[i] = get_value(l2neigh, i);
+  }
+  wrong = 0;
+  changed = 0;
+  for (e = 0; l2neigh != NULL && e < 20; e++) {
+    generate();
+    for (i = 0; i < NEIGH_DATA; i++) {
+      value = get_value(l2neigh, i);
+      wrong += value < 0 || value > 1000 || llabs(value - previous[i]) > 1000 / 10 + 1;
+      changed += value != previous[i];
+      previous[i] = value;
+    }
+  }
+  CHECK_TRUE(l2neigh != NULL && wrong == 0, "%u random walk steps too large or outside of range", wrong);
+  CHECK_TRUE(changed > 0, "random walk did not move");
+
+  /* an inverted range collapses to the lower bound */
+  configure(inverted, ARRAYSIZE(inverted));
+  generate();
+  l2neigh = get_neighbor("eth0", 0);
+  wrong = 0;
+  for (i = 0; l2neigh != NULL && i < NEIGH_DATA; i++) {
+    wrong += get_value(l2neigh, i) != 7;
+  }
+  CHECK_TRUE(l2neigh != NULL && wrong == 0, "%u values not at lower bound of inverted range", wrong);
+
+  END_TEST();
+}
+
+static void
+test_commits(void) {
+  static const char *single[] = { "neighbors", "10", "commits", "4", "transaction", "false" };
+  static const char *transaction[] = { "neighbors", "10", "commits", "4", "transaction", "true" };
+  struct oonf_layer2_neigh *l2neigh;
+  uint32_t i, events, missing;
+
+  START_TEST();
+
+  /* without a transaction every commit of a neighbor triggers an event */
+  configure(single, ARRAYSIZE(single));
+  events = generate();
+  CHECK_TRUE(events == 40, "%u events for 4 commits of 10 neighbors", events);
+
+  /* a transaction coalesces the commits of each neighbor */
+  configure(transaction, ARRAYSIZE(transaction));
+  events = generate();
+  CHECK_TRUE(events == 10, "%u events for 4 commits of 10 neighbors in a transaction", events);
+  events = generate();
+  CHECK_TRUE(events == 10, "%u events for updated neighbors in a transaction", events);
+
+  /* the commits together set every data index */
+  l2neigh = get_neighbor("eth0", 9);
+  missing = 0;
+  for (i = 0; l2neigh != NULL && i < NEIGH_DATA; i++) {
+    missing += !oonf_layer2_data_has_value(&l2neigh->data[i]);
+  }
+  CHECK_TRUE(l2neigh != NULL && missing == 0, "%u data indices not set by split commits", missing);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *layer2;
+
+  layer2 = oonf_subsystem_get(OONF_LAYER2_SUBSYSTEM);
+  plugin = oonf_subsystem_get(OONF_L2GEN_SUBSYSTEM);
+  if (layer2 == NULL || plugin == NULL || layer2->init() || plugin->init() || event_timer == NULL) {
+    return 1;
+  }
+
+  BEGIN_TESTING(clear_elements);
+
+  test_neighbors();
+  test_mac_carry();
+  test_update_churn();
+  test_distribution();
+  test_commits();
+
+  plugin->cleanup();
+  layer2->cleanup();
+  return FINISH_TESTING();
+}
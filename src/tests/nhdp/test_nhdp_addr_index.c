@@ -0,0 +1,449 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/nhdp/nhdp/nhdp.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+/*
+ * The NHDP database is linked directly into this test, memory classes,
+ * timers and the NHDP domains are replaced by the stubs below.
+ */
+
+/* synthetic neighborhood: neighbors with two interface addresses each */
+#define NEIGHBORS 200
+#define NEIGH_ADDRS 2
+
+/* two-hop addresses advertised by each neighbor */
+#define TWOHOPS 100
+
+static struct nhdp_interface interf;
+static struct list_entity domain_list;
+
+/* stubs for memory classes and timers */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *c __attribute__((unused)), void *ptr __attribute__((unused)),
+  enum oonf_class_event evt __attribute__((unused))) {}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return 0;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer __attribute__((unused)), uint64_t first __attribute__((unused)),
+  uint64_t interval __attribute__((unused))) {}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer __attribute__((unused))) {}
+
+/* stubs for NHDP domains, interfaces and hysteresis */
+int
+nhdp_domain_init_link(struct nhdp_link *lnk __attribute__((unused))) {
+  return 0;
+}
+
+int
+nhdp_domain_init_l2hop(struct nhdp_l2hop *l2hop __attribute__((unused))) {
+  return 0;
+}
+
+int
+nhdp_domain_init_neighbor(struct nhdp_neighbor *neigh __attribute__((unused))) {
+  return 0;
+}
+
+void
+nhdp_domain_cleanup_link(struct nhdp_link *lnk __attribute__((unused))) {}
+
+void
+nhdp_domain_cleanup_l2hop(struct nhdp_l2hop *l2hop __attribute__((unused))) {}
+
+void
+nhdp_domain_cleanup_neighbor(struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+struct list_entity *
+nhdp_domain_get_list(void) {
+  return &domain_list;
+}
+
+void
+nhdp_domain_delayed_mpr_recalculation(
+  struct nhdp_domain *domain __attribute__((unused)), struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+bool
+nhdp_domain_recalculate_metrics(
+  struct nhdp_domain *domain __attribute__((unused)), struct nhdp_neighbor *neigh __attribute__((unused))) {
+  return false;
+}
+
+bool
+nhdp_domain_recalculate_neighbor_metrics(struct nhdp_neighbor *neigh __attribute__((unused))) {
+  return false;
+}
+
+void
+nhdp_domain_trigger_metric_update(struct nhdp_domain *domain __attribute__((unused)),
+  bool changed __attribute__((unused))) {}
+
+const struct netaddr *
+nhdp_get_originator(int af_type __attribute__((unused))) {
+  return &NETADDR_UNSPEC;
+}
+
+struct nhdp_hysteresis_handler *
+nhdp_hysteresis_get_handler(void) {
+  return NULL;
+}
+
+void
+nhdp_interface_trigger_hello(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+void
+nhdp_interface_update_status(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+static void
+create_address(struct netaddr *addr, uint8_t net, uint32_t idx) {
+  uint8_t bin[4] = { 10, net, idx >> 8, idx & 255 };
+
+  netaddr_from_binary(addr, bin, sizeof(bin), AF_INET);
+}
+
+static void
+clear_elements(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+
+  list_for_each_element_safe(nhdp_db_get_neigh_list(), neigh, _global_node, n_it) {
+    nhdp_db_neighbor_remove(neigh);
+  }
+}
+
+static struct nhdp_link *
+add_neighbor(uint32_t n) {
+  struct nhdp_neighbor *neigh;
+  struct nhdp_link *lnk;
+  struct netaddr addr;
+  uint32_t a;
+
+  neigh = nhdp_db_neighbor_add();
+  if (neigh == NULL) {
+    return NULL;
+  }
+  lnk = nhdp_db_link_add(neigh, &interf);
+  if (lnk == NULL) {
+    return NULL;
+  }
+
+  for (a = 0; a < NEIGH_ADDRS; a++) {
+    create_address(&addr, a + 1, n);
+    if (nhdp_db_neighbor_addr_add(neigh, &addr) == NULL || nhdp_db_link_addr_add(lnk, &addr) == NULL) {
+      return NULL;
+    }
+  }
+  return lnk;
+}
+
+static void
+test_neighbor_addr(void) {
+  struct nhdp_link *lnk1, *lnk2;
+  struct nhdp_naddr *naddr;
+  struct netaddr addr;
+
+  START_TEST();
+
+  lnk1 = add_neighbor(1);
+  lnk2 = add_neighbor(2);
+  CHECK_TRUE(lnk1 != NULL && lnk2 != NULL, "neighbors not added");
+  if (lnk1 == NULL || lnk2 == NULL) {
+    END_TEST();
+    return;
+  }
+  CHECK_TRUE(nhdp_db_get_naddr_index()->count == 2 * NEIGH_ADDRS, "index has %u addresses",
+    nhdp_db_get_naddr_index()->count);
+
+  create_address(&addr, 1, 2);
+  naddr = nhdp_db_neighbor_addr_get(&addr);
+  CHECK_TRUE(naddr != NULL && naddr->neigh == lnk2->neigh, "address of neighbor 2 not found");
+
+  /* a duplicate address is rejected without touching the existing one */
+  CHECK_TRUE(nhdp_db_neighbor_addr_add(lnk1->neigh, &addr) == NULL, "duplicate address added");
+  CHECK_TRUE(nhdp_db_neighbor_addr_get(&addr) == naddr, "duplicate address replaced index entry");
+  CHECK_TRUE(nhdp_db_get_naddr_tree()->count == 2 * NEIGH_ADDRS, "tree has %u addresses",
+    nhdp_db_get_naddr_tree()->count);
+  CHECK_TRUE(lnk1->neigh->_neigh_addresses.count == NEIGH_ADDRS, "duplicate address added to neighbor 1");
+
+  /* the index follows moves and removals */
+  nhdp_db_neighbor_addr_move(lnk1->neigh, naddr);
+  CHECK_TRUE(nhdp_db_neighbor_addr_get(&addr) == naddr && naddr->neigh == lnk1->neigh, "moved address not found");
+
+  nhdp_db_neighbor_addr_remove(naddr);
+  CHECK_TRUE(nhdp_db_neighbor_addr_get(&addr) == NULL, "removed address still in index");
+
+  nhdp_db_neighbor_remove(lnk2->neigh);
+  create_address(&addr, 2, 2);
+  CHECK_TRUE(nhdp_db_neighbor_addr_get(&addr) == NULL, "address of removed neighbor still in index");
+  CHECK_TRUE(nhdp_db_get_naddr_index()->count == NEIGH_ADDRS, "index has %u addresses",
+    nhdp_db_get_naddr_index()->count);
+
+  END_TEST();
+}
+
+static void
+test_link_addr(void) {
+  struct nhdp_link *lnk1, *lnk2;
+  struct nhdp_laddr *laddr;
+  struct netaddr addr;
+
+  START_TEST();
+
+  lnk1 = add_neighbor(1);
+  lnk2 = add_neighbor(2);
+  CHECK_TRUE(lnk1 != NULL && lnk2 != NULL, "neighbors not added");
+  if (lnk1 == NULL || lnk2 == NULL) {
+    END_TEST();
+    return;
+  }
+
+  create_address(&addr, 1, 1);
+  laddr = nhdp_interface_get_link_addr(&interf, &addr);
+  CHECK_TRUE(laddr != NULL && laddr->link == lnk1, "link address of neighbor 1 not found");
+
+  /* a link address can only be used once per interface */
+  CHECK_TRUE(nhdp_db_link_addr_add(lnk2, &addr) == NULL, "duplicate link address added");
+  CHECK_TRUE(lnk2->_addresses.count == NEIGH_ADDRS, "duplicate link address added to link 2");
+  CHECK_TRUE(lnk2->neigh->_link_addresses.count == NEIGH_ADDRS, "duplicate link address added to neighbor 2");
+
+  /* the index follows moves and removals */
+  nhdp_db_link_addr_move(lnk2, laddr);
+  CHECK_TRUE(nhdp_interface_get_link_addr(&interf, &addr) == laddr && laddr->link == lnk2, "moved address not found");
+
+  nhdp_db_link_remove(lnk2);
+  CHECK_TRUE(nhdp_interface_get_link_addr(&interf, &addr) == NULL, "address of removed link still in index");
+  CHECK_TRUE(interf._link_addresses.count == NEIGH_ADDRS - 1, "index has %u addresses",
+    interf._link_addresses.count);
+
+  END_TEST();
+}
+
+static void
+test_2hop(void) {
+  struct nhdp_link *lnk1, *lnk2;
+  struct nhdp_l2hop *l2hop1, *l2hop2;
+  struct netaddr addr;
+
+  START_TEST();
+
+  lnk1 = add_neighbor(1);
+  lnk2 = add_neighbor(2);
+  CHECK_TRUE(lnk1 != NULL && lnk2 != NULL, "neighbors not added");
+  if (lnk1 == NULL || lnk2 == NULL) {
+    END_TEST();
+    return;
+  }
+
+  /* the same two-hop address can be reached over two links */
+  create_address(&addr, 100, 1);
+  l2hop1 = nhdp_db_link_2hop_add(lnk1, &addr);
+  l2hop2 = nhdp_db_link_2hop_add(lnk2, &addr);
+  CHECK_TRUE(l2hop1 != NULL && l2hop2 != NULL, "two-hop address not added");
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk1, &addr) == l2hop1, "two-hop address of link 1 not found");
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk2, &addr) == l2hop2, "two-hop address of link 2 not found");
+  CHECK_TRUE(interf._if_twohops.count == 2, "interface has %u two-hop addresses", interf._if_twohops.count);
+
+  /* but only once per link */
+  CHECK_TRUE(nhdp_db_link_2hop_add(lnk1, &addr) == NULL, "duplicate two-hop address added");
+  CHECK_TRUE(lnk1->_2hop.count == 1, "duplicate two-hop address added to link tree");
+  CHECK_TRUE(interf._if_twohops.count == 2, "duplicate two-hop address added to interface");
+
+  nhdp_db_link_2hop_remove(l2hop1);
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk1, &addr) == NULL, "removed two-hop address still in index");
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk2, &addr) == l2hop2, "two-hop address of link 2 lost");
+
+  END_TEST();
+}
+
+static void
+test_neighborhood(void) {
+  struct nhdp_link *lnk[NEIGHBORS];
+  struct nhdp_naddr *naddr;
+  struct nhdp_laddr *laddr;
+  struct nhdp_l2hop *l2hop;
+  struct netaddr addr;
+  uint32_t n, t, missing;
+
+  START_TEST();
+
+  missing = 0;
+  for (n = 0; n < NEIGHBORS; n++) {
+    lnk[n] = add_neighbor(n);
+    if (lnk[n] == NULL) {
+      missing++;
+      continue;
+    }
+    for (t = 0; t < TWOHOPS; t++) {
+      /* neighbors share two-hop addresses */
+      create_address(&addr, 100, (n + t) % NEIGHBORS);
+      if (nhdp_db_link_2hop_add(lnk[n], &addr) == NULL) {
+        missing++;
+      }
+    }
+  }
+  CHECK_TRUE(missing == 0, "%u elements not added", missing);
+  if (missing) {
+    END_TEST();
+    return;
+  }
+
+  /* index and trees must contain the same objects */
+  missing = 0;
+  avl_for_each_element(nhdp_db_get_naddr_tree(), naddr, _global_node) {
+    if (nhdp_db_neighbor_addr_get(&naddr->neigh_addr) != naddr) {
+      missing++;
+    }
+  }
+  for (n = 0; n < NEIGHBORS; n++) {
+    avl_for_each_element(&lnk[n]->_addresses, laddr, _link_node) {
+      if (nhdp_interface_get_link_addr(&interf, &laddr->link_addr) != laddr) {
+        missing++;
+      }
+    }
+    avl_for_each_element(&lnk[n]->_2hop, l2hop, _link_node) {
+      if (ndhp_db_link_2hop_get(lnk[n], &l2hop->twohop_addr) != l2hop) {
+        missing++;
+      }
+    }
+    if (lnk[n]->_2hop_index.count != TWOHOPS) {
+      missing++;
+    }
+  }
+  CHECK_TRUE(missing == 0, "%u elements not found in index", missing);
+  CHECK_TRUE(nhdp_db_get_naddr_index()->count == NEIGHBORS * NEIGH_ADDRS, "index has %u addresses",
+    nhdp_db_get_naddr_index()->count);
+  CHECK_TRUE(interf._link_addresses.count == NEIGHBORS * NEIGH_ADDRS, "interface index has %u addresses",
+    interf._link_addresses.count);
+
+  /* removing every second neighbor must only drop its own entries */
+  for (n = 0; n < NEIGHBORS; n += 2) {
+    nhdp_db_neighbor_remove(lnk[n]->neigh);
+  }
+
+  missing = 0;
+  for (n = 0; n < NEIGHBORS; n++) {
+    create_address(&addr, 1, n);
+    naddr = nhdp_db_neighbor_addr_get(&addr);
+    laddr = nhdp_interface_get_link_addr(&interf, &addr);
+    if ((n & 1) == 0 && (naddr != NULL || laddr != NULL)) {
+      missing++;
+    }
+    if ((n & 1) == 1 && (naddr == NULL || laddr == NULL)) {
+      missing++;
+    }
+  }
+  CHECK_TRUE(missing == 0, "%u addresses wrong after neighbor removal", missing);
+  CHECK_TRUE(interf._if_twohops.count == NEIGHBORS / 2 * TWOHOPS, "interface has %u two-hop addresses",
+    interf._if_twohops.count);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  list_init_head(&domain_list);
+
+  list_init_head(&interf._links);
+  hashmap_init(&interf._link_addresses, hashmap_hash_netaddr, avl_comp_netaddr);
+  avl_init(&interf._link_originators, avl_comp_netaddr, false);
+  avl_init(&interf._if_twohops, avl_comp_netaddr, true);
+
+  nhdp_db_init();
+
+  BEGIN_TESTING(clear_elements);
+
+  test_neighbor_addr();
+  test_link_addr();
+  test_2hop();
+  test_neighborhood();
+
+  nhdp_db_cleanup();
+  hashmap_free(&interf._link_addresses);
+  return FINISH_TESTING();
+}
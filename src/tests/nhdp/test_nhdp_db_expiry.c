@@ -0,0 +1,386 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/nhdp/nhdp/nhdp.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+/*
+ * The NHDP database is linked directly into this test, memory classes,
+ * timers and the NHDP domains are replaced by the stubs below. The clock
+ * is controlled by the test and the periodic expiry sweep is fired by hand.
+ */
+
+static struct nhdp_interface interf;
+static struct list_entity domain_list;
+
+static struct netaddr neigh_addr, twohop_addr[2];
+
+/* current time of the clock stub */
+static uint64_t now;
+
+/* timer instance of the expiry sweep, captured when it is started */
+static struct oonf_timer_instance *sweep_timer;
+
+/* stubs for memory classes, clock and timers */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *c __attribute__((unused)), void *ptr __attribute__((unused)),
+  enum oonf_class_event evt __attribute__((unused))) {}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return now;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first, uint64_t interval __attribute__((unused))) {
+  timer->_clock = now + first;
+  if (timer->class->periodic) {
+    sweep_timer = timer;
+  }
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer) {
+  timer->_clock = 0;
+}
+
+/* stubs for NHDP domains, interfaces and hysteresis */
+int
+nhdp_domain_init_link(struct nhdp_link *lnk __attribute__((unused))) {
+  return 0;
+}
+
+int
+nhdp_domain_init_l2hop(struct nhdp_l2hop *l2hop __attribute__((unused))) {
+  return 0;
+}
+
+int
+nhdp_domain_init_neighbor(struct nhdp_neighbor *neigh __attribute__((unused))) {
+  return 0;
+}
+
+void
+nhdp_domain_cleanup_link(struct nhdp_link *lnk __attribute__((unused))) {}
+
+void
+nhdp_domain_cleanup_l2hop(struct nhdp_l2hop *l2hop __attribute__((unused))) {}
+
+void
+nhdp_domain_cleanup_neighbor(struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+struct list_entity *
+nhdp_domain_get_list(void) {
+  return &domain_list;
+}
+
+void
+nhdp_domain_delayed_mpr_recalculation(
+  struct nhdp_domain *domain __attribute__((unused)), struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+bool
+nhdp_domain_recalculate_metrics(
+  struct nhdp_domain *domain __attribute__((unused)), struct nhdp_neighbor *neigh __attribute__((unused))) {
+  return false;
+}
+
+bool
+nhdp_domain_recalculate_neighbor_metrics(struct nhdp_neighbor *neigh __attribute__((unused))) {
+  return false;
+}
+
+void
+nhdp_domain_trigger_metric_update(struct nhdp_domain *domain __attribute__((unused)),
+  bool changed __attribute__((unused))) {}
+
+const struct netaddr *
+nhdp_get_originator(int af_type __attribute__((unused))) {
+  return &NETADDR_UNSPEC;
+}
+
+struct nhdp_hysteresis_handler *
+nhdp_hysteresis_get_handler(void) {
+  return NULL;
+}
+
+void
+nhdp_interface_trigger_hello(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+void
+nhdp_interface_update_status(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+
+static void
+clear_elements(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+
+  list_for_each_element_safe(nhdp_db_get_neigh_list(), neigh, _global_node, n_it) {
+    nhdp_db_neighbor_remove(neigh);
+  }
+  nhdp_db_set_timer_free_expiry(false, 0);
+  now = 1000;
+}
+
+static struct nhdp_link *
+add_neighbor(void) {
+  struct nhdp_neighbor *neigh;
+
+  neigh = nhdp_db_neighbor_add();
+  if (neigh == NULL) {
+    return NULL;
+  }
+  if (nhdp_db_neighbor_addr_add(neigh, &neigh_addr) == NULL) {
+    return NULL;
+  }
+  return nhdp_db_link_add(neigh, &interf);
+}
+
+/* run the periodic sweep at the given time */
+static void
+sweep(uint64_t time) {
+  now = time;
+  sweep_timer->class->callback(sweep_timer);
+}
+
+static void
+test_sweep(void) {
+  struct nhdp_link *lnk;
+  struct nhdp_l2hop *l2hop[2];
+  struct nhdp_naddr *naddr;
+
+  START_TEST();
+
+  nhdp_db_set_timer_free_expiry(true, 500);
+  CHECK_TRUE(sweep_timer != NULL && oonf_timer_is_active(sweep_timer), "expiry sweep not started");
+
+  lnk = add_neighbor();
+  CHECK_TRUE(lnk != NULL, "cannot add neighbor");
+  if (!lnk || !sweep_timer) {
+    END_TEST();
+    return;
+  }
+
+  l2hop[0] = nhdp_db_link_2hop_add(lnk, &twohop_addr[0]);
+  l2hop[1] = nhdp_db_link_2hop_add(lnk, &twohop_addr[1]);
+  naddr = nhdp_db_neighbor_addr_get(&neigh_addr);
+  CHECK_TRUE(l2hop[0] && l2hop[1] && naddr, "cannot add addresses");
+  if (!l2hop[0] || !l2hop[1] || !naddr) {
+    END_TEST();
+    return;
+  }
+
+  nhdp_db_link_2hop_set_vtime(l2hop[0], 1000);
+  nhdp_db_link_2hop_set_vtime(l2hop[1], 3000);
+  nhdp_db_neighbor_addr_set_lost(naddr, 2000);
+
+  /* the tuples expire without their own timers */
+  CHECK_TRUE(!oonf_timer_is_active(&l2hop[0]->_vtime), "two-hop timer started");
+  CHECK_TRUE(!oonf_timer_is_active(&naddr->_lost_vtime), "lost address timer started");
+  CHECK_TRUE(nhdp_db_link_2hop_get_vtime(l2hop[1]) == 3000, "two-hop vtime is %" PRId64,
+    nhdp_db_link_2hop_get_vtime(l2hop[1]));
+  CHECK_TRUE(nhdp_db_neighbor_addr_is_lost(naddr), "address not lost");
+
+  /* nothing is removed exactly at the expiry time */
+  sweep(2000);
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk, &twohop_addr[0]) != NULL, "two-hop neighbor removed early");
+
+  sweep(2001);
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk, &twohop_addr[0]) == NULL, "first two-hop neighbor not expired");
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk, &twohop_addr[1]) != NULL, "second two-hop neighbor expired");
+  CHECK_TRUE(nhdp_db_neighbor_addr_get(&neigh_addr) != NULL, "lost address expired");
+
+  sweep(3001);
+  CHECK_TRUE(nhdp_db_neighbor_addr_get(&neigh_addr) == NULL, "lost address not expired");
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk, &twohop_addr[1]) != NULL, "second two-hop neighbor expired");
+
+  sweep(4001);
+  CHECK_TRUE(ndhp_db_link_2hop_get(lnk, &twohop_addr[1]) == NULL, "second two-hop neighbor not expired");
+
+  END_TEST();
+}
+
+static void
+test_not_lost(void) {
+  struct nhdp_link *lnk;
+  struct nhdp_naddr *naddr;
+
+  START_TEST();
+
+  nhdp_db_set_timer_free_expiry(true, 500);
+
+  lnk = add_neighbor();
+  CHECK_TRUE(lnk != NULL, "cannot add neighbor");
+  if (!lnk) {
+    END_TEST();
+    return;
+  }
+
+  naddr = nhdp_db_neighbor_addr_get(&neigh_addr);
+  nhdp_db_neighbor_addr_set_lost(naddr, 1000);
+  nhdp_db_neighbor_addr_not_lost(naddr);
+  CHECK_TRUE(!nhdp_db_neighbor_addr_is_lost(naddr), "address still lost");
+
+  /* an address that is not lost anymore is kept by the sweep */
+  sweep(5000);
+  CHECK_TRUE(nhdp_db_neighbor_addr_get(&neigh_addr) != NULL, "address removed");
+
+  END_TEST();
+}
+
+static void
+test_mode_switch(void) {
+  struct nhdp_link *lnk;
+  struct nhdp_l2hop *l2hop;
+  struct nhdp_naddr *naddr;
+
+  START_TEST();
+
+  lnk = add_neighbor();
+  CHECK_TRUE(lnk != NULL, "cannot add neighbor");
+  if (!lnk) {
+    END_TEST();
+    return;
+  }
+
+  l2hop = nhdp_db_link_2hop_add(lnk, &twohop_addr[0]);
+  naddr = nhdp_db_neighbor_addr_get(&neigh_addr);
+  CHECK_TRUE(l2hop && naddr, "cannot add addresses");
+  if (!l2hop || !naddr) {
+    END_TEST();
+    return;
+  }
+
+  /* timers are used by default */
+  nhdp_db_link_2hop_set_vtime(l2hop, 2000);
+  nhdp_db_neighbor_addr_set_lost(naddr, 3000);
+  CHECK_TRUE(oonf_timer_is_active(&l2hop->_vtime) && l2hop->_vtime_expire == 0, "two-hop timer not started");
+  CHECK_TRUE(oonf_timer_is_active(&naddr->_lost_vtime) && naddr->_lost_expire == 0, "lost timer not started");
+
+  /* running timers are converted to expiry timestamps */
+  now = 1500;
+  nhdp_db_set_timer_free_expiry(true, 500);
+  CHECK_TRUE(!oonf_timer_is_active(&l2hop->_vtime), "two-hop timer still running");
+  CHECK_TRUE(!oonf_timer_is_active(&naddr->_lost_vtime), "lost timer still running");
+  CHECK_TRUE(l2hop->_vtime_expire == 3000, "two-hop expires at %" PRIu64, l2hop->_vtime_expire);
+  CHECK_TRUE(naddr->_lost_expire == 4000, "lost address expires at %" PRIu64, naddr->_lost_expire);
+  CHECK_TRUE(nhdp_db_neighbor_addr_is_lost(naddr), "address not lost");
+
+  /* and back to timers with the remaining validity time */
+  now = 2000;
+  nhdp_db_set_timer_free_expiry(false, 0);
+  CHECK_TRUE(!oonf_timer_is_active(sweep_timer), "expiry sweep still running");
+  CHECK_TRUE(l2hop->_vtime_expire == 0 && naddr->_lost_expire == 0, "expiry timestamps not cleared");
+  CHECK_TRUE(l2hop->_vtime._clock == 3000, "two-hop timer fires at %" PRIu64, l2hop->_vtime._clock);
+  CHECK_TRUE(naddr->_lost_vtime._clock == 4000, "lost timer fires at %" PRIu64, naddr->_lost_vtime._clock);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  uint8_t bin_neigh[4] = { 10, 0, 0, 2 };
+  uint8_t bin_twohop[2][4] = { { 10, 0, 1, 1 }, { 10, 0, 1, 2 } };
+
+  netaddr_from_binary(&neigh_addr, bin_neigh, 4, AF_INET);
+  netaddr_from_binary(&twohop_addr[0], bin_twohop[0], 4, AF_INET);
+  netaddr_from_binary(&twohop_addr[1], bin_twohop[1], 4, AF_INET);
+
+  list_init_head(&domain_list);
+
+  list_init_head(&interf._links);
+  hashmap_init(&interf._link_addresses, hashmap_hash_netaddr, avl_comp_netaddr);
+  avl_init(&interf._link_originators, avl_comp_netaddr, false);
+  avl_init(&interf._if_twohops, avl_comp_netaddr, true);
+
+  nhdp_db_init();
+
+  BEGIN_TESTING(clear_elements);
+
+  test_sweep();
+  test_not_lost();
+  test_mode_switch();
+
+  nhdp_db_cleanup();
+  hashmap_free(&interf._link_addresses);
+  return FINISH_TESTING();
+}
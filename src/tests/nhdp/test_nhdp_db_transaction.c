@@ -0,0 +1,446 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/nhdp/nhdp/nhdp.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+/*
+ * The NHDP database is linked directly into this test, memory classes,
+ * timers and the NHDP domains are replaced by the stubs below. The stubs
+ * record the change events and metric recalculations of the database.
+ */
+
+/* maximum number of recorded change events */
+#define MAX_EVENTS 16
+
+static struct nhdp_interface interf;
+static struct list_entity domain_list;
+
+/* CHANGED events of links and neighbors in the order they were triggered */
+static void *events[MAX_EVENTS];
+static int event_count;
+
+/* number of ADDED and REMOVED events */
+static int add_remove_count;
+
+/* metric recalculations */
+static int immediate_metric_count, neighbor_metric_count, metric_update_count;
+
+/* stubs for memory classes and timers */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
+  if (strcmp(c->name, NHDP_CLASS_LINK) != 0 && strcmp(c->name, NHDP_CLASS_NEIGHBOR) != 0) {
+    return;
+  }
+
+  if (evt != OONF_OBJECT_CHANGED) {
+    add_remove_count++;
+  }
+  else if (event_count < MAX_EVENTS) {
+    events[event_count++] = ptr;
+  }
+}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return 0;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first __attribute__((unused)),
+  uint64_t interval __attribute__((unused))) {
+  /* timers never fire, but link status depends on them being active */
+  timer->_clock = 1;
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer) {
+  timer->_clock = 0;
+}
+
+/* stubs for NHDP domains, interfaces and hysteresis */
+int
+nhdp_domain_init_link(struct nhdp_link *lnk __attribute__((unused))) {
+  return 0;
+}
+
+int
+nhdp_domain_init_l2hop(struct nhdp_l2hop *l2hop __attribute__((unused))) {
+  return 0;
+}
+
+int
+nhdp_domain_init_neighbor(struct nhdp_neighbor *neigh __attribute__((unused))) {
+  return 0;
+}
+
+void
+nhdp_domain_cleanup_link(struct nhdp_link *lnk __attribute__((unused))) {}
+
+void
+nhdp_domain_cleanup_l2hop(struct nhdp_l2hop *l2hop __attribute__((unused))) {}
+
+void
+nhdp_domain_cleanup_neighbor(struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+struct list_entity *
+nhdp_domain_get_list(void) {
+  return &domain_list;
+}
+
+void
+nhdp_domain_delayed_mpr_recalculation(
+  struct nhdp_domain *domain __attribute__((unused)), struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+bool
+nhdp_domain_recalculate_metrics(
+  struct nhdp_domain *domain __attribute__((unused)), struct nhdp_neighbor *neigh __attribute__((unused))) {
+  immediate_metric_count++;
+  return true;
+}
+
+bool
+nhdp_domain_recalculate_neighbor_metrics(struct nhdp_neighbor *neigh __attribute__((unused))) {
+  neighbor_metric_count++;
+  return true;
+}
+
+void
+nhdp_domain_trigger_metric_update(struct nhdp_domain *domain __attribute__((unused)),
+  bool changed __attribute__((unused))) {
+  metric_update_count++;
+}
+
+const struct netaddr *
+nhdp_get_originator(int af_type __attribute__((unused))) {
+  return &NETADDR_UNSPEC;
+}
+
+static bool
+_cb_link_flag(struct nhdp_link *lnk __attribute__((unused))) {
+  return false;
+}
+
+static struct nhdp_hysteresis_handler hysteresis = {
+  .is_pending = _cb_link_flag,
+  .is_lost = _cb_link_flag,
+};
+
+struct nhdp_hysteresis_handler *
+nhdp_hysteresis_get_handler(void) {
+  return &hysteresis;
+}
+
+void
+nhdp_interface_trigger_hello(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+void
+nhdp_interface_update_status(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+static void
+create_address(struct netaddr *addr, uint8_t net, uint32_t idx) {
+  uint8_t bin[4] = { 10, net, idx >> 8, idx & 255 };
+
+  netaddr_from_binary(addr, bin, sizeof(bin), AF_INET);
+}
+
+static void
+clear_elements(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+
+  list_for_each_element_safe(nhdp_db_get_neigh_list(), neigh, _global_node, n_it) {
+    nhdp_db_neighbor_remove(neigh);
+  }
+
+  event_count = 0;
+  add_remove_count = 0;
+  immediate_metric_count = 0;
+  neighbor_metric_count = 0;
+  metric_update_count = 0;
+}
+
+static struct nhdp_link *
+add_neighbor(uint32_t n) {
+  struct nhdp_neighbor *neigh;
+  struct nhdp_link *lnk;
+  struct netaddr addr;
+
+  neigh = nhdp_db_neighbor_add();
+  if (neigh == NULL) {
+    return NULL;
+  }
+  lnk = nhdp_db_link_add(neigh, &interf);
+  if (lnk == NULL) {
+    return NULL;
+  }
+
+  create_address(&addr, 1, n);
+  memcpy(&lnk->if_addr, &addr, sizeof(addr));
+  if (nhdp_db_neighbor_addr_add(neigh, &addr) == NULL || nhdp_db_link_addr_add(lnk, &addr) == NULL) {
+    return NULL;
+  }
+  return lnk;
+}
+
+/* make a link heard or symmetric, every step changes the link status */
+static void
+set_link_status(struct nhdp_link *lnk, bool symmetric) {
+  oonf_timer_set(&lnk->heard_time, 1);
+  if (symmetric) {
+    oonf_timer_set(&lnk->sym_time, 1);
+  }
+  else {
+    oonf_timer_stop(&lnk->sym_time);
+  }
+  nhdp_db_link_update_status(lnk);
+}
+
+static void
+test_without_transaction(void) {
+  struct nhdp_link *lnk;
+  struct netaddr addr;
+
+  START_TEST();
+
+  lnk = add_neighbor(1);
+  CHECK_TRUE(lnk != NULL, "neighbor not added");
+  if (lnk == NULL) {
+    END_TEST();
+    return;
+  }
+  event_count = 0;
+
+  /* every change is delivered immediately */
+  set_link_status(lnk, false);
+  set_link_status(lnk, true);
+  CHECK_TRUE(event_count == 2, "%d link events without transaction", event_count);
+  CHECK_TRUE(immediate_metric_count == 2, "%d immediate metric recalculations", immediate_metric_count);
+  CHECK_TRUE(neighbor_metric_count == 0 && metric_update_count == 0, "metric recalculation was delayed");
+
+  create_address(&addr, 2, 1);
+  nhdp_db_neighbor_set_originator(lnk->neigh, &addr);
+  CHECK_TRUE(event_count == 3 && events[2] == lnk->neigh, "neighbor event not delivered");
+
+  END_TEST();
+}
+
+static void
+test_coalesced_events(void) {
+  struct nhdp_link *lnk1, *lnk2;
+  struct netaddr addr;
+
+  START_TEST();
+
+  lnk1 = add_neighbor(1);
+  lnk2 = add_neighbor(2);
+  CHECK_TRUE(lnk1 != NULL && lnk2 != NULL, "neighbors not added");
+  if (lnk1 == NULL || lnk2 == NULL) {
+    END_TEST();
+    return;
+  }
+  add_remove_count = 0;
+
+  nhdp_db_transaction_start();
+
+  /* the neighbor changes before its link */
+  create_address(&addr, 2, 1);
+  nhdp_db_neighbor_set_originator(lnk1->neigh, &addr);
+  create_address(&addr, 2, 2);
+  nhdp_db_neighbor_set_originator(lnk1->neigh, &addr);
+
+  set_link_status(lnk1, false);
+  set_link_status(lnk1, true);
+  set_link_status(lnk2, true);
+  set_link_status(lnk1, false);
+
+  /* adding objects is not delayed */
+  CHECK_TRUE(add_neighbor(3) != NULL, "third neighbor not added");
+  CHECK_TRUE(add_remove_count > 0, "added events were delayed");
+  CHECK_TRUE(event_count == 0, "%d change events during transaction", event_count);
+  CHECK_TRUE(immediate_metric_count == 0 && neighbor_metric_count == 0, "metrics recalculated during transaction");
+
+  nhdp_db_transaction_commit();
+
+  /* one event per modified object, links first */
+  CHECK_TRUE(event_count == 3, "%d change events after commit", event_count);
+  CHECK_TRUE(event_count == 3 && events[0] == lnk1 && events[1] == lnk2 && events[2] == lnk1->neigh,
+    "wrong order of change events");
+
+  /* one recalculation per neighbor, one notification for all of them */
+  CHECK_TRUE(neighbor_metric_count == 2, "%d neighbor metric recalculations", neighbor_metric_count);
+  CHECK_TRUE(metric_update_count == 1, "%d metric update notifications", metric_update_count);
+  CHECK_TRUE(immediate_metric_count == 0, "%d immediate metric recalculations", immediate_metric_count);
+
+  END_TEST();
+}
+
+static void
+test_nested_transactions(void) {
+  struct nhdp_link *lnk;
+
+  START_TEST();
+
+  lnk = add_neighbor(1);
+  CHECK_TRUE(lnk != NULL, "neighbor not added");
+  if (lnk == NULL) {
+    END_TEST();
+    return;
+  }
+
+  nhdp_db_transaction_start();
+  nhdp_db_transaction_start();
+  set_link_status(lnk, true);
+
+  /* only the outermost commit delivers the events */
+  nhdp_db_transaction_commit();
+  CHECK_TRUE(event_count == 0, "%d change events after inner commit", event_count);
+
+  nhdp_db_transaction_commit();
+  CHECK_TRUE(event_count == 1 && events[0] == lnk, "%d change events after outer commit", event_count);
+
+  /* unbalanced commit is ignored */
+  nhdp_db_transaction_commit();
+  set_link_status(lnk, false);
+  CHECK_TRUE(event_count == 2, "change not delivered after unbalanced commit");
+
+  END_TEST();
+}
+
+static void
+test_removed_objects(void) {
+  struct nhdp_link *lnk1, *lnk2;
+  struct netaddr addr;
+
+  START_TEST();
+
+  lnk1 = add_neighbor(1);
+  lnk2 = add_neighbor(2);
+  CHECK_TRUE(lnk1 != NULL && lnk2 != NULL, "neighbors not added");
+  if (lnk1 == NULL || lnk2 == NULL) {
+    END_TEST();
+    return;
+  }
+
+  nhdp_db_transaction_start();
+
+  create_address(&addr, 2, 1);
+  nhdp_db_neighbor_set_originator(lnk1->neigh, &addr);
+  set_link_status(lnk1, true);
+  nhdp_db_neighbor_update_metrics(lnk1->neigh);
+  set_link_status(lnk2, true);
+
+  /* a removed object loses its pending events */
+  add_remove_count = 0;
+  nhdp_db_neighbor_remove(lnk1->neigh);
+  CHECK_TRUE(add_remove_count > 0, "removed events were delayed");
+
+  nhdp_db_transaction_commit();
+
+  CHECK_TRUE(event_count == 1 && events[0] == lnk2, "%d change events after commit", event_count);
+  CHECK_TRUE(neighbor_metric_count == 1, "%d neighbor metric recalculations", neighbor_metric_count);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  list_init_head(&domain_list);
+
+  list_init_head(&interf._links);
+  hashmap_init(&interf._link_addresses, hashmap_hash_netaddr, avl_comp_netaddr);
+  avl_init(&interf._link_originators, avl_comp_netaddr, false);
+  avl_init(&interf._if_twohops, avl_comp_netaddr, true);
+
+  nhdp_db_init();
+
+  BEGIN_TESTING(clear_elements);
+
+  test_without_transaction();
+  test_coalesced_events();
+  test_nested_transactions();
+  test_removed_objects();
+
+  nhdp_db_cleanup();
+  hashmap_free(&interf._link_addresses);
+  return FINISH_TESTING();
+}
@@ -0,0 +1,468 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+#include <oonf/librfc5444/rfc5444_writer.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_rfc5444.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/nhdp/nhdp/nhdp.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+/*
+ * The NHDP database and domains are linked directly into this test,
+ * memory classes, timers, interfaces and the hysteresis are replaced by the
+ * stubs below.
+ */
+
+/* more objects than fit into two storage pages */
+#define OBJECTS (2 * NHDP_DOMAIN_PAGE_SIZE + 20)
+
+static struct oonf_rfc5444_protocol protocol;
+static uint8_t proto_msg_buffer[1500], proto_addrtlv_buffer[1500];
+
+static struct nhdp_interface interf;
+static struct avl_tree interface_tree, interface_address_tree;
+
+static struct nhdp_domain *domains[2];
+
+static struct nhdp_domain_metric metric = {
+  .name = "test",
+};
+
+/* current time of the clock stub */
+static uint64_t now;
+
+static struct nhdp_neighbor *neighs[OBJECTS];
+static struct nhdp_link *links[OBJECTS];
+
+/* stubs for memory classes and timers */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *c __attribute__((unused)), void *ptr __attribute__((unused)),
+  enum oonf_class_event evt __attribute__((unused))) {}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return now;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer __attribute__((unused)), uint64_t first __attribute__((unused)),
+  uint64_t interval __attribute__((unused))) {}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer __attribute__((unused))) {}
+
+/* stubs for NHDP core, interfaces and hysteresis */
+const struct netaddr *
+nhdp_get_originator(int af_type __attribute__((unused))) {
+  return &NETADDR_UNSPEC;
+}
+
+struct avl_tree *
+nhdp_interface_get_tree(void) {
+  return &interface_tree;
+}
+
+struct avl_tree *
+nhdp_interface_get_address_tree(void) {
+  return &interface_address_tree;
+}
+
+void
+nhdp_interface_trigger_hello(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+void
+nhdp_interface_update_status(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+static bool
+_cb_link_flag(struct nhdp_link *lnk __attribute__((unused))) {
+  return false;
+}
+
+static struct nhdp_hysteresis_handler hysteresis = {
+  .is_pending = _cb_link_flag,
+  .is_lost = _cb_link_flag,
+};
+
+struct nhdp_hysteresis_handler *
+nhdp_hysteresis_get_handler(void) {
+  return &hysteresis;
+}
+
+static void
+clear_elements(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+
+  list_for_each_element_safe(nhdp_db_get_neigh_list(), neigh, _global_node, n_it) {
+    nhdp_db_neighbor_remove(neigh);
+  }
+}
+
+static bool
+_add_links(size_t count) {
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    neighs[i] = nhdp_db_neighbor_add();
+    if (!neighs[i]) {
+      return false;
+    }
+    links[i] = nhdp_db_link_add(neighs[i], &interf);
+    if (!links[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void
+_modify_data(const struct nhdp_domain *domain, size_t i, uint32_t value) {
+  struct nhdp_link_domaindata *linkdata;
+  struct nhdp_neighbor_domaindata *neighdata;
+
+  linkdata = nhdp_domain_get_linkdata(domain, links[i]);
+  linkdata->metric.in = value;
+  linkdata->metric.out = value;
+
+  neighdata = nhdp_domain_get_neighbordata(domain, neighs[i]);
+  neighdata->metric.in = value;
+  neighdata->willingness = RFC7181_WILLINGNESS_ALWAYS;
+  neighdata->neigh_is_mpr = true;
+}
+
+static bool
+_has_default_data(const struct nhdp_domain *domain, size_t i, uint32_t value) {
+  struct nhdp_link_domaindata *linkdata;
+  struct nhdp_neighbor_domaindata *neighdata;
+
+  linkdata = nhdp_domain_get_linkdata(domain, links[i]);
+  neighdata = nhdp_domain_get_neighbordata(domain, neighs[i]);
+
+  /* the link and neighbor metrics of new objects are initialized to the same value */
+  return linkdata->metric.in == value && linkdata->metric.out == value && neighdata->metric.in == value
+         && neighdata->willingness == RFC7181_WILLINGNESS_NEVER
+         && !neighdata->neigh_is_mpr;
+}
+
+static void
+test_flooding_slot_reuse(void) {
+  const struct nhdp_domain *flooding;
+  uint32_t link_slot, neigh_slot;
+
+  START_TEST();
+
+  /* no domain is registered, only the flooding domain uses the storage */
+  CHECK_TRUE(list_is_empty(nhdp_domain_get_list()), "domains registered");
+  flooding = nhdp_domain_get_flooding_domain();
+
+  CHECK_TRUE(_add_links(1), "cannot add link");
+  CHECK_TRUE(_has_default_data(flooding, 0, RFC7181_METRIC_INFINITE), "new objects have no default data");
+
+  _modify_data(flooding, 0, 1000);
+  link_slot = links[0]->_domain_slot;
+  neigh_slot = neighs[0]->_domain_slot;
+  nhdp_db_neighbor_remove(neighs[0]);
+
+  /* new objects reuse the slots and must not see the data of the old ones */
+  CHECK_TRUE(_add_links(1), "cannot add link");
+  CHECK_TRUE(links[0]->_domain_slot == link_slot, "link slot %u not reused", link_slot);
+  CHECK_TRUE(neighs[0]->_domain_slot == neigh_slot, "neighbor slot %u not reused", neigh_slot);
+  CHECK_TRUE(_has_default_data(flooding, 0, RFC7181_METRIC_INFINITE), "reused slot has stale flooding data");
+
+  END_TEST();
+}
+
+static void
+test_domain_added_later(void) {
+  size_t d;
+
+  START_TEST();
+
+  CHECK_TRUE(_add_links(3), "cannot add links");
+  _modify_data(nhdp_domain_get_flooding_domain(), 1, 1000);
+
+  domains[0] = nhdp_domain_add(0);
+  domains[1] = nhdp_domain_add(1);
+  CHECK_TRUE(domains[0] != NULL && domains[1] != NULL, "cannot add domains");
+  if (!domains[0] || !domains[1]) {
+    END_TEST();
+    return;
+  }
+
+  /* the first domain index shares its storage with the flooding domain */
+  CHECK_TRUE(domains[0]->_storage == nhdp_domain_get_flooding_domain()->_storage, "first domain has own storage");
+  CHECK_TRUE(domains[1]->_storage != domains[0]->_storage, "second domain has no own storage");
+
+  /* the second domain index gets default data for existing objects */
+  for (d = 0; d < 3; d++) {
+    CHECK_TRUE(_has_default_data(domains[1], d, RFC7181_METRIC_INFINITE),
+      "existing object %" PRINTF_SIZE_T_SPECIFIER " has no default data", d);
+  }
+
+  END_TEST();
+}
+
+static void
+test_slot_reuse_all_domains(void) {
+  size_t d;
+
+  START_TEST();
+
+  CHECK_TRUE(_add_links(2), "cannot add links");
+  for (d = 0; d < 2; d++) {
+    _modify_data(domains[d], 0, 1000 + d);
+    _modify_data(domains[d], 1, 2000 + d);
+  }
+
+  nhdp_db_neighbor_remove(neighs[0]);
+  nhdp_db_neighbor_remove(neighs[1]);
+
+  /* the hopcount metric of the domains starts new links with the maximum metric */
+  CHECK_TRUE(_add_links(2), "cannot add links");
+  for (d = 0; d < 2; d++) {
+    CHECK_TRUE(
+      _has_default_data(domains[d], 0, RFC7181_METRIC_MAX) && _has_default_data(domains[d], 1, RFC7181_METRIC_MAX),
+      "reused slot has stale data in domain %" PRINTF_SIZE_T_SPECIFIER, d);
+  }
+
+  END_TEST();
+}
+
+static void
+test_page_growth(void) {
+  uint32_t max_slot;
+  size_t d, i, errors;
+
+  START_TEST();
+
+  CHECK_TRUE(_add_links(OBJECTS), "cannot add links");
+
+  /* every object of every domain gets its own value */
+  for (d = 0; d < 2; d++) {
+    for (i = 0; i < OBJECTS; i++) {
+      _modify_data(domains[d], i, d * 10000 + i);
+    }
+  }
+
+  max_slot = 0;
+  errors = 0;
+  for (d = 0; d < 2; d++) {
+    for (i = 0; i < OBJECTS; i++) {
+      if (nhdp_domain_get_linkdata(domains[d], links[i])->metric.in != d * 10000 + i
+          || nhdp_domain_get_neighbordata(domains[d], neighs[i])->metric.in != d * 10000 + i) {
+        errors++;
+      }
+      if (links[i]->_domain_slot > max_slot) {
+        max_slot = links[i]->_domain_slot;
+      }
+    }
+  }
+  CHECK_TRUE(errors == 0, "%" PRINTF_SIZE_T_SPECIFIER " objects share domain data", errors);
+  CHECK_TRUE(max_slot >= 2 * NHDP_DOMAIN_PAGE_SIZE, "only %u slots used", max_slot + 1);
+
+  /* removed objects free their slots, the storage does not grow further */
+  clear_elements();
+  CHECK_TRUE(_add_links(OBJECTS), "cannot add links");
+
+  errors = 0;
+  for (i = 0; i < OBJECTS; i++) {
+    if (links[i]->_domain_slot > max_slot) {
+      errors++;
+    }
+    for (d = 0; d < 2; d++) {
+      if (!_has_default_data(domains[d], i, RFC7181_METRIC_MAX)) {
+        errors++;
+      }
+    }
+  }
+  CHECK_TRUE(errors == 0, "%" PRINTF_SIZE_T_SPECIFIER " reused slots are invalid", errors);
+
+  END_TEST();
+}
+
+static void
+test_metric_hysteresis(void) {
+  struct nhdp_link_domaindata *linkdata;
+  struct nhdp_domain *domain;
+  uint64_t suppressed;
+
+  START_TEST();
+
+  domain = nhdp_domain_configure(1, metric.name, CFG_DOMAIN_NO_METRIC_MPR, RFC7181_WILLINGNESS_DEFAULT);
+  CHECK_TRUE(domain == domains[1] && domain->metric == &metric, "cannot configure metric");
+
+  /* changes need at least 10 percent and 50 units, refresh after 10 seconds */
+  nhdp_domain_set_metric_hysteresis(domain, 100, 50, 10000);
+
+  now = 1000;
+  CHECK_TRUE(_add_links(1), "cannot add link");
+  linkdata = nhdp_domain_get_linkdata(domain, links[0]);
+  suppressed = domain->metric_suppressed_count;
+
+  /* a link getting its first metric is always significant */
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&metric, links[0], 1000), "first metric suppressed");
+  CHECK_TRUE(linkdata->metric.in == 1000, "metric is %u", linkdata->metric.in);
+  CHECK_TRUE(linkdata->last_metric_change == 1000, "last change at %" PRIu64, linkdata->last_metric_change);
+
+  /* the unchanged metric is not counted as suppressed */
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&metric, links[0], 1000), "same metric applied");
+  CHECK_TRUE(domain->metric_suppressed_count == suppressed, "same metric counted as suppressed");
+
+  /* enough absolute, not enough relative change */
+  now = 2000;
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&metric, links[0], 1099), "change below relative threshold applied");
+
+  /* below both thresholds */
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&metric, links[0], 960), "change below both thresholds applied");
+  CHECK_TRUE(linkdata->metric.in == 1000, "metric is %u", linkdata->metric.in);
+  CHECK_TRUE(domain->metric_suppressed_count == suppressed + 2, "%" PRIu64 " changes suppressed",
+    domain->metric_suppressed_count - suppressed);
+
+  /* exactly at both thresholds */
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&metric, links[0], 900), "change at thresholds suppressed");
+  CHECK_TRUE(linkdata->metric.in == 900, "metric is %u", linkdata->metric.in);
+  CHECK_TRUE(linkdata->last_metric_change == 2000, "last change at %" PRIu64, linkdata->last_metric_change);
+
+  /* every change is applied after the refresh interval */
+  now = 11999;
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&metric, links[0], 901), "change before refresh applied");
+  now = 12000;
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&metric, links[0], 901), "change after refresh suppressed");
+
+  /* losing the metric is always significant */
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&metric, links[0], RFC7181_METRIC_INFINITE), "infinite metric suppressed");
+
+  /* small metrics need the absolute threshold */
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&metric, links[0], 100), "first metric suppressed");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&metric, links[0], 140), "change below absolute threshold applied");
+  CHECK_TRUE(linkdata->metric.in == 100, "metric is %u", linkdata->metric.in);
+
+  /* the domain with the hopcount metric is not affected */
+  CHECK_TRUE(nhdp_domain_get_linkdata(domains[0], links[0])->metric.in == RFC7181_METRIC_MAX, "other domain changed");
+
+  /* without thresholds every change is applied */
+  nhdp_domain_set_metric_hysteresis(domain, 0, 0, 0);
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&metric, links[0], 101), "change without hysteresis suppressed");
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  /* fake RFC5444 protocol, the domains register their TLVs at its writer */
+  protocol.writer.msg_buffer = proto_msg_buffer;
+  protocol.writer.msg_size = sizeof(proto_msg_buffer);
+  protocol.writer.addrtlv_buffer = proto_addrtlv_buffer;
+  protocol.writer.addrtlv_size = sizeof(proto_addrtlv_buffer);
+  rfc5444_writer_init(&protocol.writer);
+
+  /* local NHDP interface without addresses */
+  avl_init(&interface_tree, avl_comp_strcasecmp, false);
+  avl_init(&interface_address_tree, avl_comp_netaddr, true);
+
+  interf._node.key = "if0";
+  avl_insert(&interface_tree, &interf._node);
+
+  list_init_head(&interf._links);
+  avl_init(&interf._if_addresses, avl_comp_netaddr, false);
+  hashmap_init(&interf._link_addresses, hashmap_hash_netaddr, avl_comp_netaddr);
+  avl_init(&interf._link_originators, avl_comp_netaddr, false);
+  avl_init(&interf._if_twohops, avl_comp_netaddr, true);
+
+  nhdp_domain_init(&protocol);
+  nhdp_domain_metric_add(&metric);
+  nhdp_db_init();
+
+  BEGIN_TESTING(clear_elements);
+
+  /* the tests depend on each other, domains cannot be removed */
+  test_flooding_slot_reuse();
+  test_domain_added_later();
+  test_slot_reuse_all_domains();
+  test_page_growth();
+  test_metric_hysteresis();
+
+  nhdp_db_cleanup();
+  nhdp_domain_cleanup();
+
+  rfc5444_writer_cleanup(&protocol.writer);
+  hashmap_free(&interf._link_addresses);
+  return FINISH_TESTING();
+}
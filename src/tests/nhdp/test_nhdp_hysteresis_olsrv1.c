@@ -0,0 +1,388 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/cunit/cunit.h>
+#include <oonf/libconfig/cfg_db.h>
+#include <oonf/libconfig/cfg_schema.h>
+
+#include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+#include <oonf/nhdp/hysteresis_olsrv1/hysteresis_olsrv1.h>
+
+/*
+ * The hysteresis_olsrv1 plugin is linked directly into this test, NHDP,
+ * timers and the memory classes are replaced by the stubs below. The link
+ * quality of the plugin is compared with the per-Hello exponential aging
+ * q' = q * (1 - scaling) (+ scaling for a received Hello), rounded up to the
+ * next per mille like the calculation the lookup tables replaced.
+ */
+
+#define IF_NAME "wlan0"
+
+/* Hello interval of the test link in milliseconds */
+#define ITIME 1000
+
+/* NHDP interface and link with space for their class extensions */
+static struct {
+  struct nhdp_interface nhdp_if;
+  uint64_t ext[8];
+} interf;
+
+static struct {
+  struct nhdp_link lnk;
+  uint64_t ext[8];
+} test_link;
+
+/* must match struct link_hysteresis_data of hysteresis_olsrv1.c */
+struct link_hysteresis_mirror {
+  uint64_t hello_due;
+  uint64_t itime;
+  int32_t quality;
+  bool pending;
+  bool lost;
+};
+
+static struct avl_tree if_tree;
+static struct list_entity link_list;
+
+/* class extensions of the plugin for interfaces and links */
+static struct oonf_class_extension *extensions[2];
+
+static struct nhdp_hysteresis_handler *handler;
+static struct oonf_timer_instance *sweep_timer;
+static struct oonf_subsystem *plugin;
+
+static struct oonf_class test_linkclass = {
+  .name = NHDP_CLASS_LINK,
+};
+
+static uint64_t now;
+static uint32_t status_updates;
+
+/* stubs for memory classes, clock and timers */
+int
+oonf_class_extension_add(struct oonf_class_extension *ext) {
+  if (strcmp(ext->class_name, NHDP_CLASS_INTERFACE) == 0) {
+    ext->_offset = offsetof(typeof(interf), ext);
+    extensions[0] = ext;
+  }
+  else {
+    ext->_offset = offsetof(typeof(test_link), ext);
+    extensions[1] = ext;
+  }
+  return 0;
+}
+
+void
+oonf_class_extension_remove(struct oonf_class_extension *ext __attribute__((unused))) {}
+
+void
+oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
+  size_t i;
+
+  for (i = 0; i < ARRAYSIZE(extensions); i++) {
+    if (extensions[i] && strcmp(extensions[i]->class_name, c->name) == 0 && evt == OONF_OBJECT_ADDED
+        && extensions[i]->cb_add) {
+      extensions[i]->cb_add(ptr);
+    }
+  }
+}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return now;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first, uint64_t interval __attribute__((unused))) {
+  timer->_clock = now + first;
+  sweep_timer = timer;
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer) {
+  timer->_clock = 0;
+}
+
+/* stubs for NHDP */
+struct avl_tree *
+nhdp_interface_get_tree(void) {
+  return &if_tree;
+}
+
+struct list_entity *
+nhdp_db_get_link_list(void) {
+  return &link_list;
+}
+
+void
+nhdp_db_link_update_status(struct nhdp_link *lnk __attribute__((unused))) {
+  status_updates++;
+}
+
+void
+nhdp_db_transaction_start(void) {}
+
+void
+nhdp_db_transaction_commit(void) {}
+
+void
+nhdp_hysteresis_set_handler(struct nhdp_hysteresis_handler *h) {
+  handler = h;
+}
+
+/* apply a hysteresis configuration to the plugin */
+static void
+configure(const char *accept, const char *reject, const char *scaling) {
+  struct cfg_db *db;
+
+  db = cfg_db_add();
+  cfg_db_overwrite_entry(db, OONF_HYSTERESIS_OLSRV1_SUBSYSTEM, NULL, "accept", accept);
+  cfg_db_overwrite_entry(db, OONF_HYSTERESIS_OLSRV1_SUBSYSTEM, NULL, "reject", reject);
+  cfg_db_overwrite_entry(db, OONF_HYSTERESIS_OLSRV1_SUBSYSTEM, NULL, "scaling", scaling);
+
+  plugin->cfg_section->post = cfg_db_find_namedsection(db, OONF_HYSTERESIS_OLSRV1_SUBSYSTEM, NULL);
+  plugin->cfg_section->cb_delta_handler();
+  plugin->cfg_section->post = NULL;
+
+  cfg_db_remove(db);
+}
+
+/* link quality in per mille, read from the link extension of the plugin */
+static int32_t
+quality(void) {
+  const struct link_hysteresis_mirror *data;
+
+  data = (const struct link_hysteresis_mirror *)test_link.ext;
+  return data->quality;
+}
+
+/* per-Hello exponential aging as calculated before the quality tables */
+static int32_t
+aged_quality(int32_t q, int32_t scaling, bool lost) {
+  q = (q * (1000 - scaling) + 999) / 1000;
+  if (!lost) {
+    q += scaling;
+  }
+  return q;
+}
+
+/* receive a Hello from the test link */
+static void
+receive_hello(void) {
+  handler->update_hysteresis(&test_link.lnk, NULL);
+}
+
+/* run the lost Hello sweep at the given time */
+static void
+sweep(uint64_t time) {
+  now = time;
+  sweep_timer->class->callback(sweep_timer);
+}
+
+static void
+clear_elements(void) {
+  memset(&test_link, 0, sizeof(test_link));
+  test_link.lnk.itime_value = ITIME;
+  test_link.lnk.vtime_value = 3 * ITIME;
+
+  list_init_head(&interf.nhdp_if._links);
+  list_add_tail(&interf.nhdp_if._links, &test_link.lnk._if_node);
+  oonf_class_event(&test_linkclass, &test_link.lnk, OONF_OBJECT_ADDED);
+
+  now = 1;
+  status_updates = 0;
+}
+
+static void
+test_quality_tables(void) {
+  static const int32_t scalings[] = { 1, 3, 250, 500, 999, 1000 };
+  char scaling_str[16];
+  int32_t q, expected;
+  size_t i, step, errors;
+  bool lost;
+
+  START_TEST();
+
+  for (i = 0; i < ARRAYSIZE(scalings); i++) {
+    snprintf(scaling_str, sizeof(scaling_str), "%d.%03d", scalings[i] / 1000, scalings[i] % 1000);
+    configure("0.7", "0.3", scaling_str);
+    clear_elements();
+
+    /* received Hellos from quality 0 up to 1000, then lost Hellos back down */
+    errors = 0;
+    q = 0;
+    for (step = 0; step < 4000; step++) {
+      lost = step >= 2000;
+      expected = aged_quality(q, scalings[i], lost);
+
+      if (lost) {
+        /* the first Hello is lost 1.5 intervals after the last received one */
+        sweep(now + (step == 2000 ? 3 * ITIME / 2 : ITIME));
+      }
+      else {
+        receive_hello();
+      }
+
+      q = quality();
+      if (q != expected) {
+        errors++;
+      }
+      if (step == 1999) {
+        CHECK_TRUE(q == 1000, "scaling %d: quality %d after received Hellos", scalings[i], q);
+      }
+    }
+    CHECK_TRUE(errors == 0, "scaling %d: %" PRINTF_SIZE_T_SPECIFIER " qualities differ", scalings[i], errors);
+  }
+
+  END_TEST();
+}
+
+static void
+test_thresholds(void) {
+  START_TEST();
+
+  /* with a scaling of 0.5 the quality is 500, 750, 875 after received Hellos */
+  configure("0.75", "0.5", "0.5");
+
+  receive_hello();
+  CHECK_TRUE(quality() == 500 && handler->is_pending(&test_link.lnk), "link accepted at quality %d", quality());
+  receive_hello();
+  CHECK_TRUE(quality() == 750 && handler->is_pending(&test_link.lnk), "link accepted at accept threshold");
+  receive_hello();
+  CHECK_TRUE(quality() == 875 && !handler->is_pending(&test_link.lnk), "link not accepted above accept threshold");
+  CHECK_TRUE(status_updates == 1, "%u status updates", status_updates);
+
+  /* lost Hellos age the quality to 438, 219 */
+  sweep(now + 3 * ITIME / 2);
+  CHECK_TRUE(quality() == 438 && handler->is_lost(&test_link.lnk), "link not lost below reject threshold");
+  CHECK_TRUE(status_updates == 2, "%u status updates", status_updates);
+
+  /* the link needs the accept threshold again */
+  receive_hello();
+  CHECK_TRUE(quality() == 719 && handler->is_lost(&test_link.lnk), "lost link accepted below accept threshold");
+  receive_hello();
+  CHECK_TRUE(quality() == 860 && !handler->is_lost(&test_link.lnk), "lost link not accepted");
+
+  END_TEST();
+}
+
+static void
+test_lost_sweep(void) {
+  int32_t expected;
+  int i;
+
+  START_TEST();
+
+  configure("0.7", "0.3", "0.25");
+  now = 1000;
+  receive_hello();
+  receive_hello();
+  expected = quality();
+
+  /* the first Hello is lost after 1.5 Hello intervals */
+  sweep(1000 + 3 * ITIME / 2 - 1);
+  CHECK_TRUE(quality() == expected, "Hello lost early");
+  sweep(1000 + 3 * ITIME / 2);
+  expected = aged_quality(expected, 250, true);
+  CHECK_TRUE(quality() == expected, "first Hello not lost");
+
+  /* a late sweep applies all Hellos lost since the last one */
+  sweep(1000 + 3 * ITIME / 2 + 3 * ITIME);
+  for (i = 0; i < 3; i++) {
+    expected = aged_quality(expected, 250, true);
+  }
+  CHECK_TRUE(quality() == expected, "quality %d after three lost Hellos, expected %d", quality(), expected);
+
+  /* a received Hello restarts the timeout */
+  receive_hello();
+  expected = quality();
+  sweep(now + ITIME);
+  CHECK_TRUE(quality() == expected, "Hello lost before timeout");
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  avl_init(&if_tree, avl_comp_strcasecmp, false);
+  list_init_head(&link_list);
+  list_init_head(&interf.nhdp_if._links);
+  interf.nhdp_if._node.key = IF_NAME;
+  avl_insert(&if_tree, &interf.nhdp_if._node);
+
+  plugin = oonf_subsystem_get(OONF_HYSTERESIS_OLSRV1_SUBSYSTEM);
+  if (plugin == NULL || plugin->init() || handler == NULL) {
+    return 1;
+  }
+
+  BEGIN_TESTING(clear_elements);
+
+  test_quality_tables();
+  test_thresholds();
+  test_lost_sweep();
+
+  plugin->cleanup();
+  return FINISH_TESTING();
+}
@@ -0,0 +1,425 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_layer2.h>
+#include <oonf/base/os_interface.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+#include <oonf/nhdp/layer2_metric/layer2_metric.h>
+
+/*
+ * The layer2_metric plugin and the layer2 database are linked directly
+ * into this test, NHDP and the memory classes are replaced by the
+ * stubs below. The test network has one interface with two links.
+ */
+
+#define IF_NAME "wlan0"
+#define LINK_COUNT 2
+
+/* maximum number of class extensions of the test */
+#define MAX_EXTENSIONS 8
+
+/* NHDP interface with space for its class extension */
+static struct {
+  struct nhdp_interface nhdp_if;
+  uint64_t ext[8];
+} interf;
+
+static struct avl_tree if_tree;
+static struct list_entity neigh_list;
+static struct nhdp_neighbor neighbors[LINK_COUNT];
+static struct nhdp_link links[LINK_COUNT];
+
+/* link cost set by the plugin, number of set calls */
+static uint32_t link_cost[LINK_COUNT];
+static uint32_t cost_updates;
+
+static struct nhdp_domain_metric *l2metric;
+static struct oonf_class_extension *extensions[MAX_EXTENSIONS];
+
+static struct oonf_class nhdp_link_class = {
+  .name = NHDP_CLASS_LINK,
+};
+
+static struct oonf_layer2_origin origin = {
+  .name = "test",
+  .priority = OONF_LAYER2_ORIGIN_CONFIGURED,
+};
+
+/* stubs for memory classes and clock */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+int
+oonf_class_extension_add(struct oonf_class_extension *ext) {
+  size_t i;
+
+  if (strcmp(ext->class_name, NHDP_CLASS_INTERFACE) == 0) {
+    ext->_offset = offsetof(typeof(interf), ext);
+  }
+  for (i = 0; i < MAX_EXTENSIONS; i++) {
+    if (extensions[i] == NULL) {
+      extensions[i] = ext;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void
+oonf_class_extension_remove(struct oonf_class_extension *ext) {
+  size_t i;
+
+  for (i = 0; i < MAX_EXTENSIONS; i++) {
+    if (extensions[i] == ext) {
+      extensions[i] = NULL;
+    }
+  }
+}
+
+void
+oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
+  struct oonf_class_extension *ext;
+  size_t i;
+
+  for (i = 0; i < MAX_EXTENSIONS; i++) {
+    ext = extensions[i];
+    if (ext == NULL || strcmp(ext->class_name, c->name) != 0) {
+      continue;
+    }
+    if (evt == OONF_OBJECT_ADDED && ext->cb_add) {
+      ext->cb_add(ptr);
+    }
+    else if (evt == OONF_OBJECT_CHANGED && ext->cb_change) {
+      ext->cb_change(ptr);
+    }
+    else if (evt == OONF_OBJECT_REMOVED && ext->cb_remove) {
+      ext->cb_remove(ptr);
+    }
+  }
+}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return 0;
+}
+
+struct os_interface *
+os_interface_linux_add(struct os_interface_listener *if_listener __attribute__((unused))) {
+  return NULL;
+}
+
+void
+os_interface_linux_remove(struct os_interface_listener *if_listener __attribute__((unused))) {}
+
+/* stubs for NHDP */
+struct avl_tree *
+nhdp_interface_get_tree(void) {
+  return &if_tree;
+}
+
+struct nhdp_interface *
+nhdp_interface_add(const char *name __attribute__((unused))) {
+  return &interf.nhdp_if;
+}
+
+void
+nhdp_interface_remove(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+struct list_entity *
+nhdp_db_get_neigh_list(void) {
+  return &neigh_list;
+}
+
+void
+nhdp_db_neighbor_update_metrics(struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+void
+nhdp_db_transaction_start(void) {}
+
+void
+nhdp_db_transaction_commit(void) {}
+
+int
+nhdp_domain_metric_add(struct nhdp_domain_metric *metric) {
+  l2metric = metric;
+  return 0;
+}
+
+void
+nhdp_domain_metric_remove(struct nhdp_domain_metric *metric __attribute__((unused))) {
+  l2metric = NULL;
+}
+
+bool
+nhdp_domain_set_incoming_metric(
+  struct nhdp_domain_metric *metric __attribute__((unused)), struct nhdp_link *lnk, uint32_t metric_in) {
+  size_t i = lnk - links;
+
+  cost_updates++;
+  if (link_cost[i] == metric_in) {
+    return false;
+  }
+  link_cost[i] = metric_in;
+  return true;
+}
+
+static void
+create_mac(struct netaddr *mac, uint8_t idx) {
+  uint8_t bin[6] = { 2, 0, 0, 0, 0, idx };
+
+  netaddr_from_binary(mac, bin, sizeof(bin), AF_MAC48);
+}
+
+static struct oonf_layer2_neigh *
+add_l2neigh(struct oonf_layer2_net *l2net, uint8_t idx, int64_t throughput, int64_t bitrate) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct netaddr mac;
+
+  create_mac(&mac, idx);
+  l2neigh = oonf_layer2_neigh_add(l2net, &mac);
+  if (l2neigh) {
+    if (throughput) {
+      oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_THROUGHPUT], &origin, NULL, throughput, 1);
+    }
+    if (bitrate) {
+      oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, bitrate, 1);
+    }
+    oonf_layer2_neigh_commit(l2neigh);
+  }
+  return l2neigh;
+}
+
+static void
+add_link(size_t i) {
+  create_mac(&links[i].remote_mac, i);
+  list_add_tail(&interf.nhdp_if._links, &links[i]._if_node);
+  oonf_class_event(&nhdp_link_class, &links[i], OONF_OBJECT_ADDED);
+}
+
+static void
+clear_elements(void) {
+  struct oonf_layer2_net *l2net;
+  size_t i;
+
+  l2net = oonf_layer2_net_get(IF_NAME);
+  if (l2net) {
+    oonf_layer2_net_remove(l2net, &origin);
+  }
+
+  list_init_head(&interf.nhdp_if._links);
+  memset(interf.ext, 0, sizeof(interf.ext));
+  for (i = 0; i < LINK_COUNT; i++) {
+    memset(&links[i], 0, sizeof(links[i]));
+    links[i].neigh = &neighbors[i];
+    links[i].local_if = &interf.nhdp_if;
+    link_cost[i] = 0;
+  }
+  cost_updates = 0;
+}
+
+static void
+test_new_link(void) {
+  struct oonf_layer2_net *l2net;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add(IF_NAME);
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+  CHECK_TRUE(add_l2neigh(l2net, 0, 10000000, 0) != NULL, "layer2 neighbor not added");
+
+  /* a new link must get its cost without waiting for a layer2 change */
+  add_link(0);
+  CHECK_TRUE(link_cost[0] >= RFC7181_METRIC_MIN && link_cost[0] <= RFC7181_METRIC_MAX,
+    "new link has cost %u", link_cost[0]);
+
+  /* no layer2 data for the second link */
+  add_link(1);
+  CHECK_TRUE(link_cost[1] == RFC7181_METRIC_INFINITE, "link without layer2 data has cost %u", link_cost[1]);
+
+  END_TEST();
+}
+
+static void
+test_cost(void) {
+  struct oonf_layer2_net *l2net;
+  uint32_t cost_fast, cost_bitrate;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add(IF_NAME);
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+  add_link(0);
+  add_link(1);
+
+  /* throughput is preferred over bitrate */
+  add_l2neigh(l2net, 0, 50000000, 1000000);
+  add_l2neigh(l2net, 1, 10000000, 0);
+  cost_fast = link_cost[0];
+  CHECK_TRUE(cost_fast < link_cost[1], "cost %u for 50 Mbit/s not lower than %u for 10 Mbit/s", cost_fast,
+    link_cost[1]);
+
+  /* without throughput the bitrate is used */
+  oonf_layer2_neigh_remove(oonf_layer2_neigh_get(l2net, &links[0].remote_mac), &origin);
+  add_l2neigh(l2net, 0, 0, 10000000);
+  cost_bitrate = link_cost[0];
+  CHECK_TRUE(cost_bitrate == link_cost[1], "cost %u for 10 Mbit/s bitrate differs from %u for throughput",
+    cost_bitrate, link_cost[1]);
+
+  /* network defaults are used for neighbors without own data */
+  oonf_layer2_data_set_int64(&l2net->neighdata[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, 50000000, 1);
+  oonf_layer2_neigh_remove(oonf_layer2_neigh_get(l2net, &links[0].remote_mac), &origin);
+  CHECK_TRUE(link_cost[0] == cost_fast, "cost %u of removed neighbor not %u from network default", link_cost[0],
+    cost_fast);
+
+  END_TEST();
+}
+
+static void
+test_l2neigh_commit(void) {
+  struct oonf_layer2_net *l2net;
+  struct oonf_layer2_neigh *l2neigh;
+  uint32_t cost, updates;
+
+  START_TEST();
+
+  l2net = oonf_layer2_net_add(IF_NAME);
+  CHECK_TRUE(l2net != NULL, "layer2 network not added");
+  if (!l2net) {
+    END_TEST();
+    return;
+  }
+  add_link(0);
+  l2neigh = add_l2neigh(l2net, 0, 10000000, 0);
+  CHECK_TRUE(l2neigh != NULL, "layer2 neighbor not added");
+  if (!l2neigh) {
+    END_TEST();
+    return;
+  }
+  cost = link_cost[0];
+
+  /* a commit of a value the metric uses updates the link */
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_THROUGHPUT], &origin, NULL, 20000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(link_cost[0] < cost, "cost %u not lower than %u after throughput increase", link_cost[0], cost);
+
+  /* other values do not trigger a recalculation */
+  updates = cost_updates;
+  oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_BITRATE], &origin, NULL, 20000000, 1);
+  oonf_layer2_neigh_commit(l2neigh);
+  CHECK_TRUE(cost_updates == updates, "%u updates for unused layer2 value", cost_updates - updates);
+
+  /* a removed neighbor makes the link unusable */
+  oonf_layer2_neigh_remove(l2neigh, &origin);
+  CHECK_TRUE(link_cost[0] == RFC7181_METRIC_INFINITE, "removed neighbor has cost %u", link_cost[0]);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *layer2, *plugin;
+
+  avl_init(&if_tree, avl_comp_strcasecmp, false);
+  list_init_head(&neigh_list);
+  interf.nhdp_if._node.key = IF_NAME;
+  avl_insert(&if_tree, &interf.nhdp_if._node);
+
+  layer2 = oonf_subsystem_get(OONF_LAYER2_SUBSYSTEM);
+  plugin = oonf_subsystem_get(OONF_LAYER2_METRIC_SUBSYSTEM);
+  if (layer2 == NULL || plugin == NULL || layer2->init() || plugin->init()) {
+    return 1;
+  }
+  oonf_layer2_origin_add(&origin);
+  l2metric->enable();
+
+  BEGIN_TESTING(clear_elements);
+
+  test_new_link();
+  test_cost();
+  test_l2neigh_commit();
+
+  clear_elements();
+  plugin->cleanup();
+  oonf_layer2_origin_remove(&origin);
+  layer2->cleanup();
+  return FINISH_TESTING();
+}
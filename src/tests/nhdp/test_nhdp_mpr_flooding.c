@@ -0,0 +1,423 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/libconfig/cfg_db.h>
+#include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_telnet.h>
+#include <oonf/base/oonf_viewer.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+#include <oonf/nhdp/mpr/mpr.h>
+
+/*
+ * The MPR plugin is linked directly into this test, the NHDP
+ * database is replaced by the synthetic neighborhood below.
+ *
+ * Every neighbor N0..N3 has one link on each of the three local
+ * interfaces and reports the two-hop neighbors 10.1.0.x:
+ *
+ *        if1 and if2    if3
+ *   N0   0 1 2          0 1 2
+ *   N1   2 3 4          2 3 4
+ *   N2   4 5 6          4 5 6
+ *   N3   3 6 7 0        6 7 0
+ *
+ * if1 and if2 share the same neighborhood, on if3 the two-hop
+ * neighbor 3 can only be reached through N1.
+ */
+
+/* number of local interfaces, one-hop and two-hop neighbors */
+#define IF_COUNT    3
+#define NEIGH_COUNT 4
+#define N2_COUNT    8
+
+/* maximum number of two-hop neighbors of a link */
+#define MAX_N2_PER_LINK 4
+
+/* metric of all links and two-hop neighbors */
+#define LINK_COST 1000
+
+/* two-hop neighbors reported by each neighbor, -1 terminated */
+static const int n2_of_neigh[NEIGH_COUNT][MAX_N2_PER_LINK + 1] = {
+  { 0, 1, 2, -1 },
+  { 2, 3, 4, -1 },
+  { 4, 5, 6, -1 },
+  { 3, 6, 7, 0, -1 },
+};
+
+/* synthetic NHDP database */
+static struct nhdp_domain domain;
+static struct nhdp_domain_storage storage;
+static void *link_pages[1], *neigh_pages[1], *l2hop_pages[1];
+static struct nhdp_link_domaindata linkdata[IF_COUNT * NEIGH_COUNT];
+static struct nhdp_neighbor_domaindata neighdata[NEIGH_COUNT];
+static struct nhdp_l2hop_domaindata l2hopdata[IF_COUNT * NEIGH_COUNT * MAX_N2_PER_LINK];
+
+static struct list_entity link_list, neigh_list;
+static struct avl_tree if_tree;
+
+static char if_names[IF_COUNT][IF_NAMESIZE];
+static struct nhdp_interface nhdp_if[IF_COUNT];
+static struct nhdp_neighbor neighbors[NEIGH_COUNT];
+static struct nhdp_link links[IF_COUNT][NEIGH_COUNT];
+static struct nhdp_l2hop l2hops[IF_COUNT][NEIGH_COUNT][MAX_N2_PER_LINK];
+static struct netaddr n2_addr[N2_COUNT];
+
+/* MPR handler registered by the plugin */
+static struct nhdp_domain_mpr *mpr_handler;
+
+/* stubs for the NHDP API */
+int
+nhdp_domain_mpr_add(struct nhdp_domain_mpr *mpr) {
+  mpr_handler = mpr;
+  return 0;
+}
+
+void
+nhdp_domain_delayed_mpr_recalculation(
+  struct nhdp_domain *d __attribute__((unused)), struct nhdp_neighbor *neigh __attribute__((unused))) {}
+
+const struct nhdp_domain *
+nhdp_domain_get_flooding_domain(void) {
+  return &domain;
+}
+
+struct list_entity *
+nhdp_db_get_link_list(void) {
+  return &link_list;
+}
+
+struct list_entity *
+nhdp_db_get_neigh_list(void) {
+  return &neigh_list;
+}
+
+struct avl_tree *
+nhdp_interface_get_tree(void) {
+  return &if_tree;
+}
+
+/* stubs for the core API */
+uint64_t
+oonf_clock_getNow(void) {
+  return 1000;
+}
+
+int
+oonf_class_extension_add(struct oonf_class_extension *ext __attribute__((unused))) {
+  return 0;
+}
+
+void
+oonf_class_extension_remove(struct oonf_class_extension *ext __attribute__((unused))) {}
+
+int
+oonf_telnet_add(struct oonf_telnet_command *command __attribute__((unused))) {
+  return 0;
+}
+
+void
+oonf_telnet_remove(struct oonf_telnet_command *command __attribute__((unused))) {}
+
+void
+oonf_viewer_output_print_line(struct oonf_viewer_template *template __attribute__((unused))) {}
+
+enum oonf_telnet_result
+oonf_viewer_telnet_handler(struct autobuf *out __attribute__((unused)),
+  struct abuf_template_storage *tstorage __attribute__((unused)), const char *cmd __attribute__((unused)),
+  const char *param __attribute__((unused)), struct oonf_viewer_template *templates __attribute__((unused)),
+  size_t count __attribute__((unused))) {
+  return TELNET_RESULT_ACTIVE;
+}
+
+enum oonf_telnet_result
+oonf_viewer_telnet_help(struct autobuf *out __attribute__((unused)), const char *cmd __attribute__((unused)),
+  const char *parameter __attribute__((unused)), struct oonf_viewer_template *template __attribute__((unused)),
+  size_t count __attribute__((unused))) {
+  return TELNET_RESULT_ACTIVE;
+}
+
+static void
+make_addr(struct netaddr *addr, uint8_t net, uint8_t host) {
+  uint8_t bin[4] = { 10, net, 0, host };
+
+  netaddr_from_binary(addr, bin, sizeof(bin), AF_INET);
+}
+
+static void
+add_l2hop(struct nhdp_link *lnk, struct nhdp_l2hop *l2hop, int n2) {
+  memcpy(&l2hop->twohop_addr, &n2_addr[n2], sizeof(l2hop->twohop_addr));
+  l2hop->link = lnk;
+  l2hop->_domain_slot = l2hop - &l2hops[0][0][0];
+  l2hop->_link_node.key = &l2hop->twohop_addr;
+  l2hop->_link_index_node.key = &l2hop->twohop_addr;
+  avl_insert(&lnk->_2hop, &l2hop->_link_node);
+  hashmap_insert(&lnk->_2hop_index, &l2hop->_link_index_node);
+
+  l2hopdata[l2hop->_domain_slot].metric.in = LINK_COST;
+  l2hopdata[l2hop->_domain_slot].metric.out = LINK_COST;
+}
+
+static void
+add_link(int if_idx, int n_idx) {
+  struct nhdp_link *lnk = &links[if_idx][n_idx];
+  int i;
+
+  lnk->status = NHDP_LINK_SYMMETRIC;
+  lnk->flooding_willingness = RFC7181_WILLINGNESS_DEFAULT;
+  lnk->local_if = &nhdp_if[if_idx];
+  lnk->neigh = &neighbors[n_idx];
+  lnk->_domain_slot = lnk - &links[0][0];
+  avl_init(&lnk->_2hop, avl_comp_netaddr, false);
+  hashmap_init(&lnk->_2hop_index, hashmap_hash_netaddr, avl_comp_netaddr);
+
+  list_add_tail(&link_list, &lnk->_global_node);
+  list_add_tail(&nhdp_if[if_idx]._links, &lnk->_if_node);
+  list_add_tail(&neighbors[n_idx]._links, &lnk->_neigh_node);
+
+  linkdata[lnk->_domain_slot].metric.in = LINK_COST;
+  linkdata[lnk->_domain_slot].metric.out = LINK_COST;
+
+  for (i = 0; n2_of_neigh[n_idx][i] >= 0; i++) {
+    if (if_idx == 2 && n_idx == 3 && n2_of_neigh[n_idx][i] == 3) {
+      /* N3 does not reach 3 on if3 */
+      continue;
+    }
+    add_l2hop(lnk, &l2hops[if_idx][n_idx][i], n2_of_neigh[n_idx][i]);
+  }
+}
+
+static void
+clear_elements(void) {
+  int i, j;
+
+  memset(&domain, 0, sizeof(domain));
+  memset(&storage, 0, sizeof(storage));
+  memset(linkdata, 0, sizeof(linkdata));
+  memset(neighdata, 0, sizeof(neighdata));
+  memset(l2hopdata, 0, sizeof(l2hopdata));
+  memset(nhdp_if, 0, sizeof(nhdp_if));
+  memset(neighbors, 0, sizeof(neighbors));
+  memset(links, 0, sizeof(links));
+  memset(l2hops, 0, sizeof(l2hops));
+
+  /* flooding domain */
+  link_pages[0] = linkdata;
+  neigh_pages[0] = neighdata;
+  l2hop_pages[0] = l2hopdata;
+  storage.pages[NHDP_DOMAIN_DATA_LINK] = link_pages;
+  storage.pages[NHDP_DOMAIN_DATA_NEIGHBOR] = neigh_pages;
+  storage.pages[NHDP_DOMAIN_DATA_L2HOP] = l2hop_pages;
+  domain._storage = &storage;
+
+  list_init_head(&link_list);
+  list_init_head(&neigh_list);
+  avl_init(&if_tree, avl_comp_strcasecmp, false);
+
+  for (i = 0; i < IF_COUNT; i++) {
+    snprintf(if_names[i], sizeof(if_names[i]), "if%d", i + 1);
+    list_init_head(&nhdp_if[i]._links);
+    nhdp_if[i]._node.key = if_names[i];
+    avl_insert(&if_tree, &nhdp_if[i]._node);
+  }
+
+  for (j = 0; j < N2_COUNT; j++) {
+    make_addr(&n2_addr[j], 1, j);
+  }
+
+  for (j = 0; j < NEIGH_COUNT; j++) {
+    make_addr(&neighbors[j].originator, 0, j);
+    neighbors[j].symmetric = IF_COUNT;
+    neighbors[j]._domain_slot = j;
+    list_init_head(&neighbors[j]._links);
+    avl_init(&neighbors[j]._neigh_addresses, avl_comp_netaddr, false);
+    list_add_tail(&neigh_list, &neighbors[j]._global_node);
+  }
+
+  for (i = 0; i < IF_COUNT; i++) {
+    for (j = 0; j < NEIGH_COUNT; j++) {
+      add_link(i, j);
+    }
+  }
+}
+
+static void
+free_elements(void) {
+  int i, j;
+
+  for (i = 0; i < IF_COUNT; i++) {
+    for (j = 0; j < NEIGH_COUNT; j++) {
+      hashmap_free(&links[i][j]._2hop_index);
+    }
+  }
+}
+
+/* set the configuration of the MPR plugin, NULL for the defaults */
+static void
+configure_mpr(struct oonf_subsystem *mpr, struct cfg_db *db) {
+  mpr->cfg_section->post = db ? cfg_db_find_unnamedsection(db, OONF_MPR_SUBSYSTEM) : NULL;
+  mpr->cfg_section->cb_delta_handler();
+}
+
+/* check that the flooding MPRs of an interface reach all its two-hop neighbors */
+static bool
+is_covered(int if_idx) {
+  struct nhdp_l2hop *l2hop;
+  int j, k;
+  bool found;
+
+  for (j = 0; j < NEIGH_COUNT; j++) {
+    avl_for_each_element(&links[if_idx][j]._2hop, l2hop, _link_node) {
+      found = false;
+      for (k = 0; k < NEIGH_COUNT && !found; k++) {
+        found = links[if_idx][k].neigh_is_flooding_mpr &&
+                ndhp_db_link_2hop_get(&links[if_idx][k], &l2hop->twohop_addr) != NULL;
+      }
+      if (!found) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* calculate the flooding MPRs and remember them */
+static void
+calculate_flooding_mpr(bool mpr[IF_COUNT][NEIGH_COUNT]) {
+  int i, j;
+
+  mpr_handler->update_flooding_mpr(&domain);
+
+  for (i = 0; i < IF_COUNT; i++) {
+    for (j = 0; j < NEIGH_COUNT; j++) {
+      mpr[i][j] = links[i][j].neigh_is_flooding_mpr;
+    }
+  }
+}
+
+static void
+test_shared_flooding_coverage(struct oonf_subsystem *mpr) {
+  bool separate[IF_COUNT][NEIGH_COUNT], shared[IF_COUNT][NEIGH_COUNT];
+  struct cfg_db *db;
+  int i;
+
+  START_TEST();
+
+  /* default is a separate calculation for each interface */
+  configure_mpr(mpr, NULL);
+  calculate_flooding_mpr(separate);
+  for (i = 0; i < IF_COUNT; i++) {
+    CHECK_TRUE(is_covered(i), "flooding MPRs of if%d do not cover all two-hop neighbors", i + 1);
+  }
+  CHECK_TRUE(separate[2][1], "N1 is no flooding MPR on if3");
+
+  db = cfg_db_add();
+  CHECK_TRUE(db != NULL, "configuration database not allocated");
+  if (!db) {
+    free_elements();
+    END_TEST();
+    return;
+  }
+  cfg_db_overwrite_entry(db, OONF_MPR_SUBSYSTEM, NULL, "share_flooding", "true");
+  configure_mpr(mpr, db);
+
+  /* shared flooding MPR sets must still cover each interface */
+  calculate_flooding_mpr(shared);
+  for (i = 0; i < IF_COUNT; i++) {
+    CHECK_TRUE(is_covered(i), "shared flooding MPRs of if%d do not cover all two-hop neighbors", i + 1);
+  }
+  CHECK_TRUE(memcmp(separate, shared, sizeof(separate)) == 0, "shared flooding MPRs differ from separate ones");
+  CHECK_TRUE(memcmp(shared[0], shared[1], sizeof(shared[0])) == 0, "if1 and if2 have different flooding MPRs");
+
+  /* a change on one of the identical interfaces stops the sharing */
+  hashmap_remove(&links[1][3]._2hop_index, &l2hops[1][3][0]._link_index_node);
+  avl_remove(&links[1][3]._2hop, &l2hops[1][3][0]._link_node);
+
+  calculate_flooding_mpr(shared);
+  for (i = 0; i < IF_COUNT; i++) {
+    CHECK_TRUE(is_covered(i), "shared flooding MPRs of if%d do not cover all two-hop neighbors after change", i + 1);
+  }
+  CHECK_TRUE(shared[1][1], "N1 is no flooding MPR on if2 after change");
+
+  configure_mpr(mpr, NULL);
+  cfg_db_remove(db);
+  free_elements();
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *mpr;
+
+  mpr = oonf_subsystem_get(OONF_MPR_SUBSYSTEM);
+  if (mpr == NULL) {
+    return 1;
+  }
+  mpr->early_cfg_init();
+  if (mpr->init() || mpr_handler == NULL) {
+    return 1;
+  }
+
+  BEGIN_TESTING(clear_elements);
+
+  test_shared_flooding_coverage(mpr);
+
+  mpr->cleanup();
+  return FINISH_TESTING();
+}
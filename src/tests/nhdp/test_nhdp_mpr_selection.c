@@ -0,0 +1,534 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/mpr/neighbor-graph.h>
+#include <oonf/nhdp/mpr/selection-rfc7181.h>
+
+/* maximum size of a synthetic neighborhood */
+#define MAX_N1 80
+#define MAX_N2 1500
+
+/* number of random neighborhoods to compare */
+#define ROUNDS 500
+
+/* synthetic neighborhood */
+static uint32_t n1_count, n2_count;
+static struct nhdp_neighbor neighbors[MAX_N1];
+static struct nhdp_link links[MAX_N1];
+static struct netaddr n2_addr[MAX_N2];
+static uint32_t d1[MAX_N1];
+static uint32_t d2[MAX_N1][MAX_N2];
+static uint32_t willingness[MAX_N1];
+static struct mpr_arena arenas[2];
+static bool old_mpr[MAX_N1];
+
+static int
+get_n1_index(struct n1_node *x) {
+  return x->neigh - neighbors;
+}
+
+static int
+get_n2_index(struct addr_node *y) {
+  const uint8_t *bin = netaddr_get_binptr(&y->addr);
+
+  /* both 10.0.x.y and 10.1.x.y addresses encode the N2 index */
+  return (bin[2] << 8) | bin[3];
+}
+
+static uint32_t
+_calculate_d1_x_of_n2_addr(const struct nhdp_domain *domain __attribute__((unused)),
+    struct neighbor_graph *graph __attribute__((unused)), struct addr_node *y) {
+  const uint8_t *bin = netaddr_get_binptr(&y->addr);
+
+  if (bin[1] == 0) {
+    /* 10.0.x.y is a one-hop neighbor */
+    return d1[get_n2_index(y)];
+  }
+  return RFC7181_METRIC_INFINITE;
+}
+
+static uint32_t
+_calculate_d2_x_y(const struct nhdp_domain *domain __attribute__((unused)),
+    struct n1_node *x, struct addr_node *y) {
+  return d2[get_n1_index(x)][get_n2_index(y)];
+}
+
+static uint32_t
+_calculate_d_x_y(const struct nhdp_domain *domain,
+    struct neighbor_graph *graph, struct n1_node *x, struct addr_node *y) {
+  uint32_t idx, cost2;
+
+  idx = x->table_offset + y->table_offset;
+  if (!graph->d_x_y_cache[idx]) {
+    cost2 = _calculate_d2_x_y(domain, x, y);
+    if (cost2 > RFC7181_METRIC_MAX) {
+      graph->d_x_y_cache[idx] = RFC7181_METRIC_INFINITE_PATH;
+    }
+    else {
+      graph->d_x_y_cache[idx] = d1[get_n1_index(x)] + cost2;
+    }
+  }
+  return graph->d_x_y_cache[idx];
+}
+
+static uint32_t
+_calculate_d1_x(const struct nhdp_domain *domain __attribute__((unused)), struct n1_node *x) {
+  return d1[get_n1_index(x)];
+}
+
+static uint32_t
+_get_willingness_n1(const struct nhdp_domain *domain __attribute__((unused)), struct n1_node *x) {
+  return willingness[get_n1_index(x)];
+}
+
+static struct neighbor_graph_interface _test_interface = {
+  .calculate_d1_x_of_n2_addr = _calculate_d1_x_of_n2_addr,
+  .calculate_d1_x = _calculate_d1_x,
+  .calculate_d_x_y = _calculate_d_x_y,
+  .calculate_d2_x_y = _calculate_d2_x_y,
+  .get_willingness_n1 = _get_willingness_n1,
+};
+
+static void clear_elements(void) {
+  memset(neighbors, 0, sizeof(neighbors));
+  memset(links, 0, sizeof(links));
+  n1_count = 0;
+  n2_count = 0;
+}
+
+static void
+create_neighborhood(uint32_t n1, uint32_t n2, uint32_t density) {
+  uint8_t bin[4];
+  uint32_t i, j;
+
+  n1_count = n1;
+  n2_count = n2;
+
+  for (i=0; i<n1_count; i++) {
+    bin[0] = 10;
+    bin[1] = 0;
+    bin[2] = i >> 8;
+    bin[3] = i & 255;
+    netaddr_from_binary(&neighbors[i].originator, bin, sizeof(bin), AF_INET);
+    links[i].neigh = &neighbors[i];
+
+    /* few different metric values to get lots of ties */
+    d1[i] = 1 + rand() % 4;
+    willingness[i] = (rand() % 10) == 0 ? RFC7181_WILLINGNESS_ALWAYS : RFC7181_WILLINGNESS_DEFAULT;
+  }
+
+  for (j=0; j<n2_count; j++) {
+    if (j < n1_count && (rand() % 4) == 0) {
+      /* two-hop neighbor that is also a one-hop neighbor */
+      memcpy(&n2_addr[j], &neighbors[j].originator, sizeof(n2_addr[j]));
+    }
+    else {
+      bin[0] = 10;
+      bin[1] = 1;
+      bin[2] = j >> 8;
+      bin[3] = j & 255;
+      netaddr_from_binary(&n2_addr[j], bin, sizeof(bin), AF_INET);
+    }
+
+    for (i=0; i<n1_count; i++) {
+      d2[i][j] = (uint32_t)(rand() % 100) < density ? (uint32_t)(1 + rand() % 4) : RFC7181_METRIC_INFINITE;
+    }
+
+    /* every two-hop neighbor must be reachable */
+    d2[rand() % n1_count][j] = 1 + rand() % 4;
+  }
+}
+
+static void
+build_graph(struct neighbor_graph *graph, struct mpr_arena *arena) {
+  uint32_t i, j;
+
+  memset(graph, 0, sizeof(*graph));
+  mpr_init_neighbor_graph(graph, &_test_interface);
+  graph->arena = arena;
+
+  for (i=0; i<n1_count; i++) {
+    neighbors[i].selection_is_mpr = false;
+    mpr_add_n1_node_to_set(graph, &graph->set_n1, &neighbors[i], &links[i], 0);
+  }
+  for (j=0; j<n2_count; j++) {
+    mpr_add_addr_node_to_set(graph, &graph->set_n2, n2_addr[j], 0);
+  }
+}
+
+static bool
+compare_mpr_sets(struct neighbor_graph *g1, struct neighbor_graph *g2) {
+  struct n1_node *n1, *n2;
+
+  if (g1->set_mpr.count != g2->set_mpr.count) {
+    return false;
+  }
+
+  n2 = avl_first_element(&g2->set_mpr, n2, _avl_node);
+  avl_for_each_element(&g1->set_mpr, n1, _avl_node) {
+    if (netaddr_cmp(&n1->addr, &n2->addr) != 0) {
+      return false;
+    }
+    n2 = avl_next_element(n2, _avl_node);
+  }
+  return true;
+}
+
+static void test_random_neighborhoods(void) {
+  struct neighbor_graph classic, bitset;
+  uint32_t r, density, failed;
+
+  START_TEST();
+
+  srand(42);
+  failed = 0;
+  for (r=0; r<ROUNDS; r++) {
+    density = 5 + rand() % 60;
+    create_neighborhood(1 + rand() % 40, 1 + rand() % 200, density);
+
+    build_graph(&classic, &arenas[0]);
+    mpr_calculate_mpr_rfc7181(NULL, &classic);
+
+    build_graph(&bitset, &arenas[1]);
+    mpr_calculate_mpr_rfc7181_bitset(NULL, &bitset);
+
+    if (!compare_mpr_sets(&classic, &bitset)) {
+      failed++;
+      printf("round %u (n1=%u, n2=%u, density=%u): classic %u MPRs, bitset %u MPRs\n",
+          r, n1_count, n2_count, density, classic.set_mpr.count, bitset.set_mpr.count);
+    }
+
+    mpr_clear_neighbor_graph(&classic);
+    mpr_clear_neighbor_graph(&bitset);
+  }
+
+  CHECK_TRUE(failed == 0, "%u of %u random neighborhoods had different MPR sets", failed, ROUNDS);
+  END_TEST();
+}
+
+static bool
+is_valid_mpr_set(struct neighbor_graph *graph) {
+  struct n1_node *n1;
+  struct addr_node *n2;
+
+  avl_for_each_element(&graph->set_n1, n1, _avl_node) {
+    if (willingness[get_n1_index(n1)] == RFC7181_WILLINGNESS_ALWAYS && !mpr_is_mpr(graph, &n1->addr)) {
+      return false;
+    }
+  }
+  avl_for_each_element(&graph->set_n2, n2, _avl_node) {
+    if (mpr_calculate_d_of_y_s(NULL, graph, n2, &graph->set_n1)
+        != mpr_calculate_d_of_y_s(NULL, graph, n2, &graph->set_mpr)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void
+remember_mpr_set(struct neighbor_graph *graph) {
+  struct n1_node *n1;
+
+  memset(old_mpr, 0, sizeof(old_mpr));
+  avl_for_each_element(&graph->set_mpr, n1, _avl_node) {
+    old_mpr[get_n1_index(n1)] = true;
+  }
+}
+
+static bool
+is_old_mpr_set_kept(struct neighbor_graph *graph, bool same_size) {
+  uint32_t i, count;
+
+  count = 0;
+  for (i=0; i<n1_count; i++) {
+    if (old_mpr[i]) {
+      if (!mpr_is_mpr(graph, &neighbors[i].originator)) {
+        return false;
+      }
+      count++;
+    }
+  }
+  return !same_size || count == graph->set_mpr.count;
+}
+
+static bool
+is_n2_member(struct neighbor_graph *graph, uint32_t j) {
+  struct addr_node *y;
+
+  y = avl_find_element(&graph->set_n2, &n2_addr[j], y, _avl_node);
+  return y != NULL;
+}
+
+static void
+set_n2_addr(uint32_t j) {
+  uint8_t bin[4];
+
+  bin[0] = 10;
+  bin[1] = 1;
+  bin[2] = j >> 8;
+  bin[3] = j & 255;
+  netaddr_from_binary(&n2_addr[j], bin, sizeof(bin), AF_INET);
+}
+
+static void test_incremental_update(void) {
+  struct neighbor_graph graph;
+  struct netaddr changed[4];
+  uint32_t r, c, i, j, changes, changed_count, failed_update, failed_valid, failed_subset;
+
+  START_TEST();
+
+  srand(4711);
+  failed_update = failed_valid = failed_subset = 0;
+  for (r=0; r<ROUNDS; r++) {
+    create_neighborhood(1 + rand() % 40, 1 + rand() % 200, 5 + rand() % 60);
+
+    build_graph(&graph, &arenas[0]);
+    mpr_calculate_mpr_rfc7181_bitset(NULL, &graph);
+    remember_mpr_set(&graph);
+
+    /* change some metrics, but keep every two-hop neighbor reachable */
+    changes = rand() % 4;
+    changed_count = 0;
+    for (c=0; c<changes; c++) {
+      i = rand() % n1_count;
+      j = rand() % n2_count;
+      if (rand() % 4 == 0) {
+        /* found by the incremental update itself */
+        d1[i] = 1 + rand() % 4;
+      }
+      else {
+        d2[i][j] = 1 + rand() % 4;
+        memcpy(&changed[changed_count++], &n2_addr[j], sizeof(changed[0]));
+      }
+    }
+
+    if (mpr_update_mpr_rfc7181(NULL, &graph, changed, changed_count, n2_count)) {
+      failed_update++;
+    }
+    else {
+      if (!is_valid_mpr_set(&graph)) {
+        failed_valid++;
+      }
+      if (!is_old_mpr_set_kept(&graph, changes == 0)) {
+        failed_subset++;
+      }
+    }
+
+    mpr_clear_neighbor_graph(&graph);
+  }
+
+  CHECK_TRUE(failed_update == 0, "%u incremental updates failed", failed_update);
+  CHECK_TRUE(failed_valid == 0, "%u incremental updates produced invalid MPR sets", failed_valid);
+  CHECK_TRUE(failed_subset == 0, "%u incremental updates did not keep the previous MPR set", failed_subset);
+  END_TEST();
+}
+
+static void test_incremental_n2_change(void) {
+  struct neighbor_graph graph;
+  uint32_t c, i, j;
+
+  START_TEST();
+
+  srand(17);
+  create_neighborhood(20, 100, 20);
+
+  build_graph(&graph, &arenas[0]);
+  mpr_calculate_mpr_rfc7181_bitset(NULL, &graph);
+  remember_mpr_set(&graph);
+
+  /* a new two-hop neighbor only reachable over a node that is no MPR */
+  for (i=0; i<n1_count && old_mpr[i]; i++);
+  CHECK_TRUE(i < n1_count, "all N1 nodes are MPRs");
+
+  j = n2_count++;
+  set_n2_addr(j);
+  for (c=0; c<n1_count; c++) {
+    d2[c][j] = c == i ? 1 : RFC7181_METRIC_INFINITE;
+  }
+
+  CHECK_TRUE(mpr_update_mpr_rfc7181(NULL, &graph, &n2_addr[j], 1, n2_count) == 0, "adding N2 node failed");
+  CHECK_TRUE(is_n2_member(&graph, j), "new two-hop neighbor not in N2");
+  CHECK_TRUE(mpr_is_mpr(&graph, &neighbors[i].originator), "new two-hop neighbor not covered");
+  CHECK_TRUE(is_valid_mpr_set(&graph), "MPR set invalid after adding N2 node");
+
+  /* remove the two-hop neighbor again */
+  d2[i][j] = RFC7181_METRIC_INFINITE;
+  CHECK_TRUE(mpr_update_mpr_rfc7181(NULL, &graph, &n2_addr[j], 1, n2_count) == 0, "removing N2 node failed");
+  CHECK_TRUE(!is_n2_member(&graph, j), "lost two-hop neighbor still in N2");
+  CHECK_TRUE(is_valid_mpr_set(&graph), "MPR set invalid after removing N2 node");
+
+  mpr_clear_neighbor_graph(&graph);
+  END_TEST();
+}
+
+static void test_incremental_fallback(void) {
+  struct neighbor_graph graph;
+
+  START_TEST();
+
+  srand(815);
+  create_neighborhood(20, 100, 20);
+
+  build_graph(&graph, &arenas[0]);
+  mpr_calculate_mpr_rfc7181_bitset(NULL, &graph);
+
+  /* a willingness change needs a full calculation */
+  willingness[3] = willingness[3] == RFC7181_WILLINGNESS_ALWAYS
+      ? RFC7181_WILLINGNESS_DEFAULT : RFC7181_WILLINGNESS_ALWAYS;
+  CHECK_TRUE(mpr_update_mpr_rfc7181(NULL, &graph, NULL, 0, n2_count) != 0,
+      "willingness change was handled incrementally");
+  mpr_clear_neighbor_graph(&graph);
+
+  /* too many changed two-hop neighbors need a full calculation */
+  build_graph(&graph, &arenas[0]);
+  mpr_calculate_mpr_rfc7181_bitset(NULL, &graph);
+  d1[3] = d1[3] % 4 + 1;
+  CHECK_TRUE(mpr_update_mpr_rfc7181(NULL, &graph, n2_addr, 2, 0) != 0,
+      "metric change was handled incrementally");
+  mpr_clear_neighbor_graph(&graph);
+  END_TEST();
+}
+
+static uint64_t get_time_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void test_large_neighborhood(void) {
+  struct neighbor_graph classic, bitset;
+  uint64_t start, classic_time, bitset_time;
+
+  START_TEST();
+
+  /* large neighborhood, each two-hop neighbor is reachable over ~10% of N1 */
+  srand(23);
+  create_neighborhood(MAX_N1, MAX_N2, 10);
+
+  build_graph(&classic, &arenas[0]);
+  start = get_time_ns();
+  mpr_calculate_mpr_rfc7181(NULL, &classic);
+  classic_time = get_time_ns() - start;
+
+  build_graph(&bitset, &arenas[1]);
+  start = get_time_ns();
+  mpr_calculate_mpr_rfc7181_bitset(NULL, &bitset);
+  bitset_time = get_time_ns() - start;
+
+  CHECK_TRUE(compare_mpr_sets(&classic, &bitset), "MPR sets are different");
+
+  printf("MPR selection for %u N1 and %u N2 nodes: classic %llu us, bitset %llu us (%u MPRs)\n",
+      n1_count, n2_count, (unsigned long long)(classic_time / 1000),
+      (unsigned long long)(bitset_time / 1000), bitset.set_mpr.count);
+
+  mpr_clear_neighbor_graph(&classic);
+  mpr_clear_neighbor_graph(&bitset);
+  END_TEST();
+}
+
+static void test_arena_reuse(void) {
+  struct neighbor_graph graph;
+  const struct mpr_arena_stats *stats;
+  uint64_t block_allocs, node_allocs;
+  uint32_t r;
+
+  START_TEST();
+
+  srand(1234);
+  create_neighborhood(MAX_N1, MAX_N2, 10);
+
+  /* first calculation allocates the arena blocks */
+  build_graph(&graph, &arenas[0]);
+  mpr_calculate_mpr_rfc7181_bitset(NULL, &graph);
+  mpr_clear_neighbor_graph(&graph);
+
+  stats = mpr_arena_get_stats();
+  block_allocs = stats->block_allocs;
+  node_allocs = stats->node_allocs;
+
+  for (r=0; r<ROUNDS; r++) {
+    build_graph(&graph, &arenas[0]);
+    mpr_calculate_mpr_rfc7181_bitset(NULL, &graph);
+    mpr_clear_neighbor_graph(&graph);
+  }
+
+  CHECK_TRUE(stats->block_allocs == block_allocs, "%llu blocks allocated by later calculations",
+      (unsigned long long)(stats->block_allocs - block_allocs));
+  CHECK_TRUE(stats->node_allocs > node_allocs, "no nodes allocated from arena");
+
+  mpr_arena_free(&arenas[0]);
+  mpr_arena_free(&arenas[1]);
+  CHECK_TRUE(stats->blocks == 0, "%u arena blocks left after free", stats->blocks);
+  CHECK_TRUE(stats->block_allocs == stats->block_frees, "%llu blocks allocated, %llu freed",
+      (unsigned long long)stats->block_allocs, (unsigned long long)stats->block_frees);
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  mpr_arena_init(&arenas[0]);
+  mpr_arena_init(&arenas[1]);
+
+  BEGIN_TESTING(clear_elements);
+
+  test_random_neighborhoods();
+  test_large_neighborhood();
+  test_incremental_update();
+  test_incremental_n2_change();
+  test_incremental_fallback();
+  test_arena_reuse();
+
+  return FINISH_TESTING();
+}
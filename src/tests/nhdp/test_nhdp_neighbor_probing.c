@@ -0,0 +1,542 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+#include <oonf/libconfig/cfg_db.h>
+#include <oonf/libconfig/cfg_schema.h>
+
+#include <oonf/libcore/oonf_subsystem.h>
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_layer2.h>
+#include <oonf/base/oonf_rfc5444.h>
+#include <oonf/base/oonf_telnet.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/base/oonf_viewer.h>
+#include <oonf/base/os_interface.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+
+#include <oonf/nhdp/neighbor_probing/neighbor_probing.h>
+
+/*
+ * The neighbor_probing plugin and the layer2 database are linked directly
+ * into this test, NHDP, RFC5444 targets, timers and the memory classes are
+ * replaced by the stubs below. The test network has one wireless interface
+ * with more links than the plugin can probe in one tick.
+ */
+
+#define IF_NAME "wlan0"
+#define LINK_COUNT 20
+
+/* maximum number of links probed in one tick, see neighbor_probing.c */
+#define MAX_BATCH 16
+
+/* probing interval in milliseconds */
+#define INTERVAL 200
+
+/* maximum number of class extensions of the test */
+#define MAX_EXTENSIONS 8
+
+/* NHDP interface and links with space for their class extensions */
+static struct {
+  struct nhdp_interface nhdp_if;
+  uint64_t ext[8];
+} interf;
+
+static struct os_interface os_if;
+
+static struct test_link {
+  struct nhdp_link lnk;
+  uint64_t ext[32];
+} links[LINK_COUNT];
+
+static struct avl_tree if_tree;
+static struct list_entity link_list, domain_list;
+
+/* one domain with its link data in a single storage page */
+static struct nhdp_domain domain;
+static struct nhdp_domain_storage storage;
+static struct nhdp_link_domaindata linkdata[NHDP_DOMAIN_PAGE_SIZE];
+static void *linkdata_pages[1] = { linkdata };
+
+/* RFC5444 protocol of the plugin, a target and the number of probes for each link */
+static struct oonf_rfc5444_protocol protocol;
+static uint8_t proto_msg_buffer[1500], proto_addrtlv_buffer[1500];
+static struct oonf_rfc5444_target targets[LINK_COUNT];
+static uint32_t probes[LINK_COUNT];
+
+static struct oonf_class_extension *extensions[MAX_EXTENSIONS];
+static struct oonf_timer_instance *probe_timer;
+static struct oonf_subsystem *plugin;
+static uint64_t now;
+
+static struct oonf_class nhdp_link_class = {
+  .name = NHDP_CLASS_LINK,
+};
+
+static struct oonf_layer2_origin origin = {
+  .name = "test",
+  .priority = OONF_LAYER2_ORIGIN_CONFIGURED,
+};
+
+/* stubs for memory classes, clock and timers */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+int
+oonf_class_extension_add(struct oonf_class_extension *ext) {
+  size_t i;
+
+  if (strcmp(ext->class_name, NHDP_CLASS_INTERFACE) == 0) {
+    ext->_offset = offsetof(typeof(interf), ext);
+  }
+  else if (strcmp(ext->class_name, NHDP_CLASS_LINK) == 0) {
+    ext->_offset = offsetof(struct test_link, ext);
+  }
+  for (i = 0; i < MAX_EXTENSIONS; i++) {
+    if (extensions[i] == NULL) {
+      extensions[i] = ext;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void
+oonf_class_extension_remove(struct oonf_class_extension *ext) {
+  size_t i;
+
+  for (i = 0; i < MAX_EXTENSIONS; i++) {
+    if (extensions[i] == ext) {
+      extensions[i] = NULL;
+    }
+  }
+}
+
+void
+oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
+  struct oonf_class_extension *ext;
+  size_t i;
+
+  for (i = 0; i < MAX_EXTENSIONS; i++) {
+    ext = extensions[i];
+    if (ext == NULL || strcmp(ext->class_name, c->name) != 0) {
+      continue;
+    }
+    if (evt == OONF_OBJECT_ADDED && ext->cb_add) {
+      ext->cb_add(ptr);
+    }
+    else if (evt == OONF_OBJECT_REMOVED && ext->cb_remove) {
+      ext->cb_remove(ptr);
+    }
+  }
+}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return now;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first, uint64_t interval __attribute__((unused))) {
+  timer->_clock = now + first;
+  probe_timer = timer;
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer) {
+  timer->_clock = 0;
+}
+
+struct os_interface *
+os_interface_linux_add(struct os_interface_listener *if_listener __attribute__((unused))) {
+  return NULL;
+}
+
+void
+os_interface_linux_remove(struct os_interface_listener *if_listener __attribute__((unused))) {}
+
+/* stubs for RFC5444, telnet and viewer */
+struct oonf_rfc5444_protocol *
+oonf_rfc5444_get_default_protocol(void) {
+  return &protocol;
+}
+
+void
+oonf_rfc5444_remove_protocol(struct oonf_rfc5444_protocol *p __attribute__((unused))) {}
+
+struct oonf_rfc5444_target *
+oonf_rfc5444_add_target(struct oonf_rfc5444_interface *interface __attribute__((unused)), struct netaddr *dst) {
+  size_t i;
+
+  for (i = 0; i < LINK_COUNT; i++) {
+    if (netaddr_cmp(&links[i].lnk.if_addr, dst) == 0) {
+      memcpy(&targets[i].dst, dst, sizeof(*dst));
+      return &targets[i];
+    }
+  }
+  return NULL;
+}
+
+void
+oonf_rfc5444_remove_target(struct oonf_rfc5444_target *target __attribute__((unused))) {}
+
+enum rfc5444_result
+oonf_rfc5444_send_if(struct oonf_rfc5444_target *target, uint8_t msgid __attribute__((unused))) {
+  probes[target - targets]++;
+  return RFC5444_OKAY;
+}
+
+int
+oonf_telnet_add(struct oonf_telnet_command *command __attribute__((unused))) {
+  return 0;
+}
+
+void
+oonf_telnet_remove(struct oonf_telnet_command *command __attribute__((unused))) {}
+
+enum oonf_telnet_result
+oonf_viewer_telnet_handler(struct autobuf *out __attribute__((unused)),
+  struct abuf_template_storage *s __attribute__((unused)), const char *cmd __attribute__((unused)),
+  const char *param __attribute__((unused)), struct oonf_viewer_template *templates __attribute__((unused)),
+  size_t count __attribute__((unused))) {
+  return TELNET_RESULT_ACTIVE;
+}
+
+enum oonf_telnet_result
+oonf_viewer_telnet_help(struct autobuf *out __attribute__((unused)), const char *cmd __attribute__((unused)),
+  const char *parameter __attribute__((unused)), struct oonf_viewer_template *template __attribute__((unused)),
+  size_t count __attribute__((unused))) {
+  return TELNET_RESULT_ACTIVE;
+}
+
+void
+oonf_viewer_output_print_line(struct oonf_viewer_template *template __attribute__((unused))) {}
+
+/* stubs for NHDP */
+struct avl_tree *
+nhdp_interface_get_tree(void) {
+  return &if_tree;
+}
+
+struct list_entity *
+nhdp_db_get_link_list(void) {
+  return &link_list;
+}
+
+struct list_entity *
+nhdp_domain_get_list(void) {
+  return &domain_list;
+}
+
+/* apply a probing configuration to the plugin */
+static void
+configure(const char *batch, const char *max_backoff) {
+  struct cfg_db *db;
+
+  db = cfg_db_add();
+  cfg_db_overwrite_entry(db, OONF_NEIGHBOR_PROBING_SUBSYSTEM, NULL, "batch", batch);
+  cfg_db_overwrite_entry(db, OONF_NEIGHBOR_PROBING_SUBSYSTEM, NULL, "max_backoff", max_backoff);
+
+  plugin->cfg_section->post = cfg_db_find_namedsection(db, OONF_NEIGHBOR_PROBING_SUBSYSTEM, NULL);
+  plugin->cfg_section->cb_delta_handler();
+  plugin->cfg_section->post = NULL;
+
+  cfg_db_remove(db);
+}
+
+/* run a probing tick at the given time */
+static void
+tick(uint64_t time) {
+  now = time;
+  probe_timer->class->callback(probe_timer);
+}
+
+static void
+add_links(size_t count) {
+  struct oonf_layer2_net *l2net;
+  struct oonf_layer2_neigh *l2neigh;
+  uint8_t bin_mac[6] = { 2, 0, 0, 0, 0, 0 };
+  uint8_t bin_ip[4] = { 10, 0, 0, 0 };
+  size_t i;
+
+  l2net = oonf_layer2_net_add(IF_NAME);
+  if (!l2net) {
+    return;
+  }
+
+  /* the interface reports that it needs probing */
+  oonf_layer2_data_set_bool(&l2net->data[OONF_LAYER2_NET_MCS_BY_PROBING], &origin, NULL, true);
+
+  for (i = 0; i < count; i++) {
+    bin_mac[5] = i + 1;
+    bin_ip[3] = i + 1;
+    netaddr_from_binary(&links[i].lnk.remote_mac, bin_mac, sizeof(bin_mac), AF_MAC48);
+    netaddr_from_binary(&links[i].lnk.if_addr, bin_ip, sizeof(bin_ip), AF_INET);
+    links[i].lnk.status = NHDP_LINK_SYMMETRIC;
+    links[i].lnk.local_if = &interf.nhdp_if;
+    links[i].lnk._domain_slot = i;
+
+    list_add_tail(&interf.nhdp_if._links, &links[i].lnk._if_node);
+    list_add_tail(&link_list, &links[i].lnk._global_node);
+    oonf_class_event(&nhdp_link_class, &links[i].lnk, OONF_OBJECT_ADDED);
+
+    /* the plugin needs the rx bitrate and the tx frame counter */
+    l2neigh = oonf_layer2_neigh_add(l2net, &links[i].lnk.remote_mac);
+    if (l2neigh) {
+      oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BITRATE], &origin, NULL, 1000000, 1);
+      oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_FRAMES], &origin, NULL, 0, 1);
+    }
+    linkdata[i].metric.in = 1000;
+  }
+}
+
+static size_t
+probed_links(void) {
+  size_t i, count;
+
+  count = 0;
+  for (i = 0; i < LINK_COUNT; i++) {
+    if (probes[i] > 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+static void
+clear_elements(void) {
+  struct oonf_layer2_net *l2net;
+  size_t i;
+
+  l2net = oonf_layer2_net_get(IF_NAME);
+  if (l2net) {
+    oonf_layer2_net_remove(l2net, &origin);
+  }
+
+  for (i = 0; i < LINK_COUNT; i++) {
+    if (list_is_node_added(&links[i].lnk._if_node)) {
+      oonf_class_event(&nhdp_link_class, &links[i].lnk, OONF_OBJECT_REMOVED);
+    }
+  }
+  list_init_head(&interf.nhdp_if._links);
+  list_init_head(&link_list);
+  memset(links, 0, sizeof(links));
+  memset(linkdata, 0, sizeof(linkdata));
+  memset(probes, 0, sizeof(probes));
+  now = 0;
+}
+
+static void
+test_batch(void) {
+  size_t i, count;
+
+  START_TEST();
+
+  configure("1", "0");
+  add_links(LINK_COUNT);
+
+  /* one link per tick by default */
+  tick(1000);
+  CHECK_TRUE(probed_links() == 1, "%" PRINTF_SIZE_T_SPECIFIER " links probed", probed_links());
+
+  /* the largest batch probes the links that waited longest first */
+  configure("16", "0");
+  tick(1200);
+  CHECK_TRUE(probed_links() == 1 + MAX_BATCH, "%" PRINTF_SIZE_T_SPECIFIER " links probed", probed_links());
+
+  tick(1400);
+  count = 0;
+  for (i = 0; i < LINK_COUNT; i++) {
+    count += probes[i];
+  }
+  CHECK_TRUE(probed_links() == LINK_COUNT, "%" PRINTF_SIZE_T_SPECIFIER " links probed", probed_links());
+  CHECK_TRUE(count == 1 + 2 * MAX_BATCH, "%" PRINTF_SIZE_T_SPECIFIER " probes sent", count);
+
+  END_TEST();
+}
+
+static void
+test_traffic_skip(void) {
+  struct oonf_layer2_neigh *l2neigh;
+
+  START_TEST();
+
+  configure("16", "0");
+  add_links(2);
+
+  /* a link with unicast traffic since the last check is not probed */
+  l2neigh = oonf_layer2_neigh_get(oonf_layer2_net_get(IF_NAME), &links[0].lnk.remote_mac);
+  CHECK_TRUE(l2neigh != NULL, "layer2 neighbor not found");
+  if (l2neigh) {
+    oonf_layer2_data_set_int64(&l2neigh->data[OONF_LAYER2_NEIGH_TX_FRAMES], &origin, NULL, 100, 1);
+  }
+
+  tick(1000);
+  CHECK_TRUE(probes[0] == 0, "link with traffic probed");
+  CHECK_TRUE(probes[1] == 1, "idle link not probed");
+
+  /* the counter did not move since the last check */
+  tick(2000);
+  CHECK_TRUE(probes[0] == 1, "idle link not probed");
+
+  END_TEST();
+}
+
+static void
+test_backoff(void) {
+  uint64_t time;
+  size_t i;
+
+  START_TEST();
+
+  configure("1", "2");
+  add_links(1);
+
+  /* the first probe sees a new metric, the second one a stable metric */
+  tick(INTERVAL);
+  tick(2 * INTERVAL);
+  CHECK_TRUE(probes[0] == 2, "%u probes sent", probes[0]);
+
+  /* after one stable probe the link waits two intervals */
+  tick(3 * INTERVAL);
+  CHECK_TRUE(probes[0] == 2, "link probed during backoff");
+  tick(4 * INTERVAL);
+  CHECK_TRUE(probes[0] == 3, "link not probed after backoff");
+
+  /* the backoff is limited to max_backoff halvings */
+  time = 4 * INTERVAL;
+  for (i = 0; i < 4; i++) {
+    time += 4 * INTERVAL;
+    tick(time - INTERVAL);
+    CHECK_TRUE(probes[0] == 3 + i, "link probed during backoff %" PRINTF_SIZE_T_SPECIFIER, i);
+    tick(time);
+    CHECK_TRUE(probes[0] == 4 + i, "link not probed after backoff %" PRINTF_SIZE_T_SPECIFIER, i);
+  }
+
+  /* a changed metric resets the backoff */
+  linkdata[0].metric.in = 2000;
+  time += 4 * INTERVAL;
+  tick(time);
+  CHECK_TRUE(probes[0] == 8, "%u probes sent", probes[0]);
+  tick(time + INTERVAL);
+  CHECK_TRUE(probes[0] == 9, "link with changed metric in backoff");
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *layer2;
+
+  avl_init(&if_tree, avl_comp_strcasecmp, false);
+  list_init_head(&link_list);
+  list_init_head(&interf.nhdp_if._links);
+  interf.nhdp_if._node.key = IF_NAME;
+  strscpy(os_if.name, IF_NAME, sizeof(os_if.name));
+  interf.nhdp_if.os_if_listener.data = &os_if;
+  avl_insert(&if_tree, &interf.nhdp_if._node);
+
+  /* a single domain with the link data of all links */
+  list_init_head(&domain_list);
+  storage.pages[NHDP_DOMAIN_DATA_LINK] = linkdata_pages;
+  domain._storage = &storage;
+  list_add_tail(&domain_list, &domain._node);
+
+  /* fake RFC5444 protocol for the probing message */
+  protocol.writer.msg_buffer = proto_msg_buffer;
+  protocol.writer.msg_size = sizeof(proto_msg_buffer);
+  protocol.writer.addrtlv_buffer = proto_addrtlv_buffer;
+  protocol.writer.addrtlv_size = sizeof(proto_addrtlv_buffer);
+  rfc5444_writer_init(&protocol.writer);
+
+  layer2 = oonf_subsystem_get(OONF_LAYER2_SUBSYSTEM);
+  plugin = oonf_subsystem_get(OONF_NEIGHBOR_PROBING_SUBSYSTEM);
+  if (layer2 == NULL || plugin == NULL || layer2->init() || plugin->init()) {
+    return 1;
+  }
+  oonf_layer2_origin_add(&origin);
+
+  BEGIN_TESTING(clear_elements);
+
+  test_batch();
+  test_traffic_skip();
+  test_backoff();
+
+  clear_elements();
+  plugin->cleanup();
+  oonf_layer2_origin_remove(&origin);
+  layer2->cleanup();
+  rfc5444_writer_cleanup(&protocol.writer);
+  return FINISH_TESTING();
+}
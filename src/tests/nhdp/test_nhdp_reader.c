@@ -0,0 +1,436 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+#include <oonf/librfc5444/rfc5444.h>
+#include <oonf/librfc5444/rfc5444_iana.h>
+#include <oonf/librfc5444/rfc5444_reader.h>
+#include <oonf/librfc5444/rfc5444_writer.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_packet_socket.h>
+#include <oonf/base/oonf_rfc5444.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/nhdp/nhdp/nhdp.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+#include <oonf/nhdp/nhdp/nhdp_reader.h>
+
+/*
+ * The NHDP reader, database and domains are linked directly into this test,
+ * memory classes, timers, interfaces and the hysteresis are replaced by the
+ * stubs below. HELLOs are generated with the RFC5444 writer and fed into
+ * the reader of a fake protocol instance.
+ */
+
+/* number of domains with metric in the test HELLOs */
+#define DOMAINS 2
+
+/* link metric flags, the link specific ones are the last TLVs of a domain */
+static const enum rfc7181_linkmetric_flags _flags[4] = {
+  RFC7181_LINKMETRIC_OUTGOING_LINK,
+  RFC7181_LINKMETRIC_OUTGOING_NEIGH,
+  RFC7181_LINKMETRIC_INCOMING_NEIGH,
+  RFC7181_LINKMETRIC_INCOMING_LINK,
+};
+
+static struct oonf_rfc5444_protocol protocol;
+static struct oonf_rfc5444_interface rfc5444_if = { .name = "if0" };
+
+static struct nhdp_interface interf;
+static struct nhdp_interface_addr interf_addr;
+static struct avl_tree interface_tree, interface_address_tree;
+
+static struct netaddr local_addr, neigh_addr, twohop_addr;
+static union netaddr_socket neigh_socket;
+
+static struct nhdp_domain_metric metric = {
+  .name = "test",
+};
+
+/* buffers of the domain TLV registration and of the HELLO generator */
+static uint8_t proto_msg_buffer[1500], proto_addrtlv_buffer[1500];
+static uint8_t msg_buffer[1500], addrtlv_buffer[5000], packet_buffer[1500];
+
+static struct rfc5444_writer writer = {
+  .msg_buffer = msg_buffer,
+  .msg_size = sizeof(msg_buffer),
+  .addrtlv_buffer = addrtlv_buffer,
+  .addrtlv_size = sizeof(addrtlv_buffer),
+};
+
+static void _cb_add_message_tlvs(struct rfc5444_writer *wr);
+static void _cb_add_addresses(struct rfc5444_writer *wr);
+static void _cb_send_packet(struct rfc5444_writer *wr, struct rfc5444_writer_target *target, void *ptr, size_t len);
+
+static struct rfc5444_writer_content_provider cpr = {
+  .msg_type = RFC6130_MSGTYPE_HELLO,
+  .addMessageTLVs = _cb_add_message_tlvs,
+  .addAddresses = _cb_add_addresses,
+};
+
+/* LINK_STATUS, OTHER_NEIGHB and one LINK_METRIC per domain and flag */
+static struct rfc5444_writer_tlvtype addrtlvs[2 + DOMAINS * 4];
+
+static struct rfc5444_writer_target target = {
+  .packet_buffer = packet_buffer,
+  .packet_size = sizeof(packet_buffer),
+  .sendPacket = _cb_send_packet,
+};
+
+/* metric value of each domain and flag in the generated HELLO */
+static uint32_t hello_metric[DOMAINS][4];
+
+/* stubs for memory classes and timers */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *c __attribute__((unused)), void *ptr __attribute__((unused)),
+  enum oonf_class_event evt __attribute__((unused))) {}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return 0;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer __attribute__((unused)), uint64_t first __attribute__((unused)),
+  uint64_t interval __attribute__((unused))) {}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer __attribute__((unused))) {}
+
+/* stubs for sockets, NHDP core, interfaces and hysteresis */
+bool
+oonf_packet_managed_is_active(
+  struct oonf_packet_managed *managed __attribute__((unused)), int af_type __attribute__((unused))) {
+  return true;
+}
+
+const struct netaddr *
+nhdp_get_originator(int af_type __attribute__((unused))) {
+  return &NETADDR_UNSPEC;
+}
+
+struct avl_tree *
+nhdp_interface_get_tree(void) {
+  return &interface_tree;
+}
+
+struct avl_tree *
+nhdp_interface_get_address_tree(void) {
+  return &interface_address_tree;
+}
+
+void
+nhdp_interface_trigger_hello(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+void
+nhdp_interface_update_status(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+static void
+_cb_update_hysteresis(struct nhdp_link *lnk __attribute__((unused)),
+  struct rfc5444_reader_tlvblock_context *context __attribute__((unused))) {}
+
+static bool
+_cb_link_flag(struct nhdp_link *lnk __attribute__((unused))) {
+  return false;
+}
+
+static struct nhdp_hysteresis_handler hysteresis = {
+  .update_hysteresis = _cb_update_hysteresis,
+  .is_pending = _cb_link_flag,
+  .is_lost = _cb_link_flag,
+};
+
+struct nhdp_hysteresis_handler *
+nhdp_hysteresis_get_handler(void) {
+  return &hysteresis;
+}
+
+static void
+_cb_add_message_tlvs(struct rfc5444_writer *wr) {
+  uint8_t vtime;
+
+  vtime = rfc5497_timetlv_encode(6000);
+  rfc5444_writer_add_messagetlv(wr, RFC5497_MSGTLV_VALIDITY_TIME, 0, &vtime, sizeof(vtime));
+}
+
+static void
+_add_metric_tlvs(struct rfc5444_writer *wr, struct rfc5444_writer_address *addr) {
+  struct rfc7181_metric_field field;
+  int d, f;
+
+  for (d = 0; d < DOMAINS; d++) {
+    for (f = 0; f < 4; f++) {
+      memset(&field, 0, sizeof(field));
+      rfc7181_metric_encode(&field, hello_metric[d][f]);
+      rfc7181_metric_set_flag(&field, _flags[f]);
+
+      rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[2 + d * 4 + f], &field, sizeof(field), true);
+    }
+  }
+}
+
+static void
+_cb_add_addresses(struct rfc5444_writer *wr) {
+  struct rfc5444_writer_address *addr;
+  uint8_t value;
+
+  /* the neighbor hears our interface address */
+  addr = rfc5444_writer_add_address(wr, cpr.creator, &local_addr, false);
+  value = RFC6130_LINKSTATUS_SYMMETRIC;
+  rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[0], &value, sizeof(value), false);
+  _add_metric_tlvs(wr, addr);
+
+  /* and has a symmetric two-hop neighbor */
+  addr = rfc5444_writer_add_address(wr, cpr.creator, &twohop_addr, false);
+  value = RFC6130_OTHERNEIGHB_SYMMETRIC;
+  rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[1], &value, sizeof(value), false);
+  _add_metric_tlvs(wr, addr);
+}
+
+static void
+_cb_send_packet(struct rfc5444_writer *wr __attribute__((unused)),
+  struct rfc5444_writer_target *t __attribute__((unused)), void *ptr, size_t len) {
+  /* the HELLO arrives from the neighbor over the local interface */
+  protocol.input.src_address = &neigh_addr;
+  protocol.input.src_socket = &neigh_socket;
+  protocol.input.interface = &rfc5444_if;
+
+  rfc5444_reader_handle_packet(&protocol.reader, ptr, len);
+}
+
+static int
+_cb_add_message_header(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  rfc5444_writer_set_msg_header(wr, msg, false, false, false, false);
+  return RFC5444_OKAY;
+}
+
+/* metric as the reader sees it after encoding */
+static uint32_t
+_transmitted_metric(uint32_t value) {
+  struct rfc7181_metric_field field;
+
+  memset(&field, 0, sizeof(field));
+  rfc7181_metric_encode(&field, value);
+  return rfc7181_metric_decode(&field);
+}
+
+static void
+_send_hello(void) {
+  rfc5444_writer_create_message_alltarget(&writer, RFC6130_MSGTYPE_HELLO, 4);
+  rfc5444_writer_flush(&writer, &target, false);
+}
+
+static void
+clear_elements(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+
+  list_for_each_element_safe(nhdp_db_get_neigh_list(), neigh, _global_node, n_it) {
+    nhdp_db_neighbor_remove(neigh);
+  }
+}
+
+static void
+test_metrics_of_all_domains(void) {
+  struct nhdp_domain *domain;
+  struct nhdp_link *lnk;
+  struct nhdp_l2hop *l2hop;
+  struct nhdp_l2hop_domaindata *l2data;
+  int d, f;
+
+  START_TEST();
+
+  /* every TLV of the HELLO carries a different metric */
+  for (d = 0; d < DOMAINS; d++) {
+    for (f = 0; f < 4; f++) {
+      hello_metric[d][f] = 1000 * (d + 1) + 200 * f;
+    }
+  }
+
+  _send_hello();
+
+  CHECK_TRUE(!list_is_empty(&interf._links), "link not added");
+  if (list_is_empty(&interf._links)) {
+    END_TEST();
+    return;
+  }
+
+  lnk = list_first_element(&interf._links, lnk, _if_node);
+  l2hop = ndhp_db_link_2hop_get(lnk, &twohop_addr);
+  CHECK_TRUE(l2hop != NULL, "two-hop neighbor not added");
+
+  for (d = 0; d < DOMAINS; d++) {
+    domain = nhdp_domain_get_by_ext(d);
+
+    /* our incoming metric is the outgoing metric of the link */
+    CHECK_TRUE(nhdp_domain_get_linkdata(domain, lnk)->metric.out == _transmitted_metric(hello_metric[d][3]),
+      "domain %d: link metric out is %u", d, nhdp_domain_get_linkdata(domain, lnk)->metric.out);
+
+    if (l2hop) {
+      /* two-hop metrics are not reversed */
+      l2data = nhdp_domain_get_l2hopdata(domain, l2hop);
+      CHECK_TRUE(l2data->metric.in == _transmitted_metric(hello_metric[d][2]), "domain %d: two-hop metric in is %u",
+        d, l2data->metric.in);
+      CHECK_TRUE(l2data->metric.out == _transmitted_metric(hello_metric[d][1]), "domain %d: two-hop metric out is %u",
+        d, l2data->metric.out);
+    }
+  }
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  uint8_t bin_local[4] = { 10, 0, 0, 1 };
+  uint8_t bin_neigh[4] = { 10, 0, 0, 2 };
+  uint8_t bin_twohop[4] = { 10, 0, 1, 1 };
+  struct rfc5444_writer_message *msg;
+  size_t i;
+
+  netaddr_from_binary(&local_addr, bin_local, 4, AF_INET);
+  netaddr_from_binary(&neigh_addr, bin_neigh, 4, AF_INET);
+  netaddr_from_binary(&twohop_addr, bin_twohop, 4, AF_INET);
+  netaddr_socket_init(&neigh_socket, &neigh_addr, 269, 0);
+
+  /* fake RFC5444 protocol, the domains register their TLVs at its writer */
+  protocol.writer.msg_buffer = proto_msg_buffer;
+  protocol.writer.msg_size = sizeof(proto_msg_buffer);
+  protocol.writer.addrtlv_buffer = proto_addrtlv_buffer;
+  protocol.writer.addrtlv_size = sizeof(proto_addrtlv_buffer);
+  rfc5444_writer_init(&protocol.writer);
+  rfc5444_reader_init(&protocol.reader);
+
+  /* local NHDP interface with a single address */
+  avl_init(&interface_tree, avl_comp_strcasecmp, false);
+  avl_init(&interface_address_tree, avl_comp_netaddr, true);
+
+  interf._node.key = rfc5444_if.name;
+  avl_insert(&interface_tree, &interf._node);
+
+  list_init_head(&interf._links);
+  avl_init(&interf._if_addresses, avl_comp_netaddr, false);
+  hashmap_init(&interf._link_addresses, hashmap_hash_netaddr, avl_comp_netaddr);
+  avl_init(&interf._link_originators, avl_comp_netaddr, false);
+  avl_init(&interf._if_twohops, avl_comp_netaddr, true);
+  interf.l_hold_time = 6000;
+  interf.n_hold_time = 6000;
+
+  memcpy(&interf_addr.if_addr, &local_addr, sizeof(local_addr));
+  interf_addr._if_node.key = &interf_addr.if_addr;
+  interf_addr._global_node.key = &interf_addr.if_addr;
+  avl_insert(&interf._if_addresses, &interf_addr._if_node);
+  avl_insert(&interface_address_tree, &interf_addr._global_node);
+
+  /* NHDP core with two domains using a metric with default handling */
+  nhdp_domain_init(&protocol);
+  nhdp_domain_metric_add(&metric);
+  for (i = 0; i < DOMAINS; i++) {
+    nhdp_domain_configure(i, metric.name, CFG_DOMAIN_NO_METRIC_MPR, RFC7181_WILLINGNESS_DEFAULT);
+  }
+  nhdp_db_init();
+  nhdp_reader_init(&protocol);
+
+  /* HELLO generator */
+  addrtlvs[0].type = RFC6130_ADDRTLV_LINK_STATUS;
+  addrtlvs[1].type = RFC6130_ADDRTLV_OTHER_NEIGHB;
+  for (i = 2; i < ARRAYSIZE(addrtlvs); i++) {
+    addrtlvs[i].type = RFC7181_ADDRTLV_LINK_METRIC;
+    addrtlvs[i].exttype = (i - 2) / 4;
+  }
+
+  rfc5444_writer_init(&writer);
+  rfc5444_writer_register_target(&writer, &target);
+  msg = rfc5444_writer_register_message(&writer, RFC6130_MSGTYPE_HELLO, false);
+  msg->addMessageHeader = _cb_add_message_header;
+  rfc5444_writer_register_msgcontentprovider(&writer, &cpr, addrtlvs, ARRAYSIZE(addrtlvs));
+
+  BEGIN_TESTING(clear_elements);
+
+  test_metrics_of_all_domains();
+
+  rfc5444_writer_cleanup(&writer);
+
+  nhdp_reader_cleanup();
+  nhdp_db_cleanup();
+  nhdp_domain_cleanup();
+
+  rfc5444_reader_cleanup(&protocol.reader);
+  rfc5444_writer_cleanup(&protocol.writer);
+  hashmap_free(&interf._link_addresses);
+  return FINISH_TESTING();
+}
@@ -0,0 +1,451 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+#include <oonf/librfc5444/rfc5444.h>
+#include <oonf/librfc5444/rfc5444_iana.h>
+#include <oonf/librfc5444/rfc5444_writer.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_rfc5444.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/base/os_interface.h>
+#include <oonf/nhdp/nhdp/nhdp.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_hysteresis.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+#include <oonf/nhdp/nhdp/nhdp_writer.h>
+
+/*
+ * The NHDP writer, database and domains are linked directly into this test,
+ * memory classes, timers, interfaces and the RFC5444 sockets are replaced by
+ * the stubs below. Only the IPv4 target of the interface is active, its
+ * packets are captured by the test.
+ */
+
+static struct oonf_rfc5444_protocol protocol;
+static struct oonf_rfc5444_interface rfc5444_if = { .name = "if0" };
+static struct oonf_rfc5444_target target4, target6;
+
+static struct os_interface os_if;
+static struct nhdp_interface interf;
+static struct nhdp_interface_addr interf_addr;
+static struct avl_tree interface_tree, interface_address_tree;
+
+static uint8_t msg_buffer[1500], addrtlv_buffer[5000];
+
+/* originator lookups since the last _send_hello(), only a generated HELLO needs the originator */
+static int generated;
+
+/* number of triggered HELLO requests of the database */
+static int triggered;
+
+/* last packet sent through the IPv4 target */
+static uint8_t packet[RFC5444_MAX_PACKET_SIZE];
+static size_t packet_length;
+
+/* stubs for memory classes and timers */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *c __attribute__((unused)), void *ptr __attribute__((unused)),
+  enum oonf_class_event evt __attribute__((unused))) {}
+
+uint64_t
+oonf_clock_getNow(void) {
+  return 0;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first __attribute__((unused)),
+  uint64_t interval __attribute__((unused))) {
+  /* timers never fire, but link status depends on them being active */
+  timer->_clock = 1;
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer) {
+  timer->_clock = 0;
+}
+
+/* stubs for RFC5444 sockets, NHDP core, interfaces and hysteresis */
+enum rfc5444_result
+oonf_rfc5444_send_if(struct oonf_rfc5444_target *target, uint8_t msgid) {
+  if (target != &target4) {
+    /* socket not active */
+    return RFC5444_OKAY;
+  }
+  return rfc5444_writer_create_message_singletarget(&protocol.writer, msgid, 4, &target->rfc5444_target);
+}
+
+enum rfc5444_result
+oonf_rfc5444_send_if_binary(struct oonf_rfc5444_target *target, const uint8_t *msg, size_t len) {
+  if (target != &target4) {
+    /* socket not active */
+    return RFC5444_OKAY;
+  }
+  return rfc5444_writer_add_binary_msg(&protocol.writer, &target->rfc5444_target, msg, len);
+}
+
+const struct netaddr *
+nhdp_get_originator(int af_type __attribute__((unused))) {
+  generated++;
+  return &NETADDR_UNSPEC;
+}
+
+struct avl_tree *
+nhdp_interface_get_tree(void) {
+  return &interface_tree;
+}
+
+struct avl_tree *
+nhdp_interface_get_address_tree(void) {
+  return &interface_address_tree;
+}
+
+void
+nhdp_interface_trigger_hello(struct nhdp_interface *nhdp_if __attribute__((unused))) {
+  triggered++;
+}
+
+void
+nhdp_interface_update_status(struct nhdp_interface *nhdp_if __attribute__((unused))) {}
+
+static bool
+_cb_link_flag(struct nhdp_link *lnk __attribute__((unused))) {
+  return false;
+}
+
+static struct nhdp_hysteresis_handler hysteresis = {
+  .is_pending = _cb_link_flag,
+  .is_lost = _cb_link_flag,
+};
+
+struct nhdp_hysteresis_handler *
+nhdp_hysteresis_get_handler(void) {
+  return &hysteresis;
+}
+
+static void
+_cb_send_packet(struct rfc5444_writer *wr __attribute__((unused)),
+  struct rfc5444_writer_target *t __attribute__((unused)), void *ptr, size_t len) {
+  memcpy(packet, ptr, len);
+  packet_length = len;
+}
+
+/* other content provider for HELLOs */
+static struct rfc5444_writer_content_provider foreign_provider = {
+  .msg_type = RFC6130_MSGTYPE_HELLO,
+};
+
+static struct nhdp_link *
+_add_neighbor(uint8_t idx) {
+  uint8_t bin[4] = { 10, 0, 0, idx };
+  struct nhdp_neighbor *neigh;
+  struct nhdp_link *lnk;
+  struct netaddr addr;
+
+  netaddr_from_binary(&addr, bin, sizeof(bin), AF_INET);
+
+  neigh = nhdp_db_neighbor_add();
+  lnk = nhdp_db_link_add(neigh, &interf);
+  nhdp_db_neighbor_addr_add(neigh, &addr);
+  nhdp_db_link_addr_add(lnk, &addr);
+  memcpy(&lnk->if_addr, &addr, sizeof(addr));
+
+  /* the neighbor has heard us */
+  oonf_timer_set(&lnk->heard_time, 1);
+  nhdp_db_link_update_status(lnk);
+  return lnk;
+}
+
+static void
+_send_hello(void) {
+  generated = 0;
+  packet_length = 0;
+
+  nhdp_writer_send_hello(&interf);
+  rfc5444_writer_flush(&protocol.writer, &target4.rfc5444_target, false);
+}
+
+static void
+clear_elements(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+  uint8_t mac[6] = { 2, 0, 0, 0, 0, 1 };
+
+  list_for_each_element_safe(nhdp_db_get_neigh_list(), neigh, _global_node, n_it) {
+    nhdp_db_neighbor_remove(neigh);
+  }
+  nhdp_writer_clear_hello_cache(&interf);
+
+  netaddr_from_binary(&os_if.mac, mac, sizeof(mac), AF_MAC48);
+  interf.hello_cache = true;
+  triggered = 0;
+}
+
+static void
+test_cached_resend(void) {
+  uint8_t first[sizeof(packet)];
+  size_t first_length;
+
+  START_TEST();
+
+  _add_neighbor(2);
+
+  _send_hello();
+  CHECK_TRUE(generated > 0, "first HELLO was not generated: %d", generated);
+  CHECK_TRUE(packet_length > 0, "no HELLO sent");
+
+  memcpy(first, packet, packet_length);
+  first_length = packet_length;
+
+  /* nothing changed, the cached HELLO must be sent unchanged */
+  _send_hello();
+  CHECK_TRUE(generated == 0, "HELLO generated again: %d", generated);
+  CHECK_TRUE(packet_length == first_length, "cached HELLO has %zu bytes instead of %zu", packet_length, first_length);
+  CHECK_TRUE(memcmp(packet, first, first_length) == 0, "cached HELLO differs");
+
+  /* without cache each HELLO is generated */
+  interf.hello_cache = false;
+  _send_hello();
+  CHECK_TRUE(generated > 0, "HELLO without cache was not generated: %d", generated);
+  CHECK_TRUE(packet_length == first_length && memcmp(packet, first, first_length) == 0,
+    "generated HELLO differs from cached one");
+
+  END_TEST();
+}
+
+static void
+test_cache_invalidation(void) {
+  uint8_t first[sizeof(packet)];
+  size_t first_length;
+
+  START_TEST();
+
+  _add_neighbor(2);
+  _send_hello();
+  memcpy(first, packet, packet_length);
+  first_length = packet_length;
+
+  /* a new neighbor changes the NHDP database */
+  _add_neighbor(3);
+  _send_hello();
+  CHECK_TRUE(generated > 0, "HELLO not generated after database change: %d", generated);
+  CHECK_TRUE(packet_length > first_length, "new neighbor is missing in HELLO");
+
+  _send_hello();
+  CHECK_TRUE(generated == 0, "HELLO not cached after database change: %d", generated);
+
+  /* domain data (metrics, MPRs, willingness) changed */
+  nhdp_domain_increase_generation();
+  _send_hello();
+  CHECK_TRUE(generated > 0, "HELLO not generated after domain change: %d", generated);
+
+  /* a new MAC address of the interface is part of the HELLO */
+  memcpy(first, packet, packet_length);
+  first_length = packet_length;
+
+  os_if.mac._addr[5] = 2;
+  _send_hello();
+  CHECK_TRUE(generated > 0, "HELLO not generated after MAC change: %d", generated);
+  CHECK_TRUE(packet_length == first_length && memcmp(packet, first, first_length) != 0,
+    "new MAC address is missing in HELLO");
+
+  END_TEST();
+}
+
+static void
+test_triggered_hello(void) {
+  uint8_t first[sizeof(packet)];
+  size_t first_length;
+  struct nhdp_link *lnk;
+
+  START_TEST();
+
+  lnk = _add_neighbor(2);
+  CHECK_TRUE(lnk->status == NHDP_LINK_HEARD, "link is not heard: %d", lnk->status);
+  _send_hello();
+  memcpy(first, packet, packet_length);
+  first_length = packet_length;
+
+  /* link becomes symmetric and requests an early HELLO */
+  triggered = 0;
+  oonf_timer_set(&lnk->sym_time, 1);
+  nhdp_db_link_update_status(lnk);
+  CHECK_TRUE(lnk->status == NHDP_LINK_SYMMETRIC, "link is not symmetric: %d", lnk->status);
+  CHECK_TRUE(triggered == 1, "link status change triggered %d HELLOs", triggered);
+
+  /* the triggered HELLO must not use the stale cache */
+  _send_hello();
+  CHECK_TRUE(generated > 0, "triggered HELLO was not generated: %d", generated);
+  CHECK_TRUE(packet_length != first_length || memcmp(packet, first, first_length) != 0,
+    "triggered HELLO has old link status");
+
+  END_TEST();
+}
+
+static void
+test_foreign_content(void) {
+  START_TEST();
+
+  /* HELLOs with content of another provider cannot be cached */
+  rfc5444_writer_register_msgcontentprovider(&protocol.writer, &foreign_provider, NULL, 0);
+
+  _add_neighbor(2);
+  _send_hello();
+  _send_hello();
+  CHECK_TRUE(generated > 0, "HELLO with foreign content was not generated: %d", generated);
+  CHECK_TRUE(interf._hello_cache[0].buffer == NULL, "HELLO with foreign content was cached");
+
+  rfc5444_writer_unregister_content_provider(&protocol.writer, &foreign_provider, NULL, 0);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  uint8_t bin_local[4] = { 10, 0, 0, 1 };
+  uint8_t bin_mc4[4] = { 224, 0, 0, 109 };
+  int result;
+
+  /* fake RFC5444 protocol with an IPv4 and an IPv6 target */
+  protocol.writer.msg_buffer = msg_buffer;
+  protocol.writer.msg_size = sizeof(msg_buffer);
+  protocol.writer.addrtlv_buffer = addrtlv_buffer;
+  protocol.writer.addrtlv_size = sizeof(addrtlv_buffer);
+  rfc5444_writer_init(&protocol.writer);
+
+  rfc5444_if.protocol = &protocol;
+  rfc5444_if.multicast4 = &target4;
+  rfc5444_if.multicast6 = &target6;
+
+  target4.interface = &rfc5444_if;
+  netaddr_from_binary(&target4.dst, bin_mc4, sizeof(bin_mc4), AF_INET);
+  target4.rfc5444_target.packet_buffer = target4._packet_buffer;
+  target4.rfc5444_target.packet_size = sizeof(target4._packet_buffer);
+  target4.rfc5444_target.sendPacket = _cb_send_packet;
+  rfc5444_writer_register_target(&protocol.writer, &target4.rfc5444_target);
+
+  target6.interface = &rfc5444_if;
+
+  /* local NHDP interface with a single address */
+  avl_init(&interface_tree, avl_comp_strcasecmp, false);
+  avl_init(&interface_address_tree, avl_comp_netaddr, true);
+
+  interf._node.key = rfc5444_if.name;
+  avl_insert(&interface_tree, &interf._node);
+
+  interf.rfc5444_if.interface = &rfc5444_if;
+  interf.os_if_listener.data = &os_if;
+  interf.refresh_interval = 2000;
+  interf.h_hold_time = 6000;
+  list_init_head(&interf._links);
+  avl_init(&interf._if_addresses, avl_comp_netaddr, false);
+  hashmap_init(&interf._link_addresses, hashmap_hash_netaddr, avl_comp_netaddr);
+  avl_init(&interf._link_originators, avl_comp_netaddr, false);
+  avl_init(&interf._if_twohops, avl_comp_netaddr, true);
+
+  netaddr_from_binary(&interf_addr.if_addr, bin_local, sizeof(bin_local), AF_INET);
+  interf_addr._if_node.key = &interf_addr.if_addr;
+  interf_addr._global_node.key = &interf_addr.if_addr;
+  avl_insert(&interf._if_addresses, &interf_addr._if_node);
+  avl_insert(&interface_address_tree, &interf_addr._global_node);
+
+  /* NHDP core with a single domain */
+  nhdp_domain_init(&protocol);
+  nhdp_domain_add(0);
+  nhdp_db_init();
+  if (nhdp_writer_init(&protocol)) {
+    return 1;
+  }
+
+  BEGIN_TESTING(clear_elements);
+
+  test_cached_resend();
+  test_cache_invalidation();
+  test_triggered_hello();
+  test_foreign_content();
+
+  result = FINISH_TESTING();
+
+  clear_elements();
+  nhdp_writer_cleanup();
+  nhdp_db_cleanup();
+  nhdp_domain_cleanup();
+
+  rfc5444_writer_cleanup(&protocol.writer);
+  hashmap_free(&interf._link_addresses);
+  return result;
+}
@@ -0,0 +1,1191 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/avl_comp.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/list.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/libcommon/string.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_clock.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/base/os_clock.h>
+#include <oonf/base/os_routing.h>
+#include <oonf/nhdp/nhdp/nhdp_db.h>
+#include <oonf/nhdp/nhdp/nhdp_domain.h>
+#include <oonf/nhdp/nhdp/nhdp_interfaces.h>
+#include <oonf/olsrv2/olsrv2/olsrv2.h>
+#include <oonf/olsrv2/olsrv2/olsrv2_lan.h>
+#include <oonf/olsrv2/olsrv2/olsrv2_originator.h>
+#include <oonf/olsrv2/olsrv2/olsrv2_routing.h>
+#include <oonf/olsrv2/olsrv2/olsrv2_tc.h>
+
+/*
+ * The routing code is linked directly into this test. NHDP, the
+ * topology database, timers and the kernel are replaced by the
+ * synthetic network below:
+ *
+ *  local (10.0.0.1) -- if1 -- N1 (10.0.0.2) --+
+ *                   \                         +-- D (10.0.0.4)
+ *                    - if2 -- N2 (10.0.0.3) --+
+ */
+
+/* number of one-hop neighbors, links and timers of the test */
+#define NEIGH_COUNT 2
+#define LINK_COUNT  3
+#define MAX_TIMERS  16
+
+/* maximum number of kernel operations of a test */
+#define MAX_KERNEL_ROUTES 64
+
+/* cost of the link to each one-hop neighbor */
+#define LINK_COST 1000
+
+/* simulated time */
+static uint64_t now;
+
+/* synthetic NHDP database */
+static struct nhdp_domain domain;
+static struct list_entity domain_list;
+static struct nhdp_domain_storage storage;
+static void *link_pages[1], *neigh_pages[1];
+static struct nhdp_link_domaindata linkdata[LINK_COUNT];
+static struct nhdp_neighbor_domaindata neighdata[NEIGH_COUNT];
+
+static struct list_entity neigh_list;
+static struct hashmap naddr_index;
+static struct avl_tree if_addr_tree;
+
+static struct os_interface os_if[2];
+static struct nhdp_interface nhdp_if[2];
+
+static struct nhdp_neighbor neighbors[NEIGH_COUNT];
+static struct nhdp_link links[LINK_COUNT];
+static struct nhdp_naddr naddrs[NEIGH_COUNT];
+
+/* synthetic topology database */
+static struct netaddr originator;
+static struct avl_tree tc_tree, endpoint_tree, lan_tree;
+static struct olsrv2_tc_node tc_nodes[NEIGH_COUNT + 1];
+static struct olsrv2_tc_edge edges[NEIGH_COUNT];
+
+/* timers started by the routing code */
+static struct oonf_timer_instance *timers[MAX_TIMERS];
+static size_t timer_count;
+
+/* one operation handed to the kernel */
+struct kernel_op {
+  struct os_route *route;
+  bool set;
+  bool del_similar;
+};
+
+/* routes handed to the kernel, waiting for their feedback */
+static struct os_route *kernel_pending[MAX_KERNEL_ROUTES];
+static size_t kernel_pending_count;
+static struct os_route *kernel_query;
+
+/* all operations handed to the kernel */
+static struct kernel_op kernel_log[MAX_KERNEL_ROUTES];
+static size_t kernel_log_count;
+
+/* routing parameters of the synthetic domain */
+static struct olsrv2_routing_domain parameter;
+
+/* stubs for the timer and clock API */
+uint64_t
+oonf_clock_getNow(void) {
+  return now;
+}
+
+int
+os_clock_linux_gettime64_ns(uint64_t *t64) {
+  *t64 = now * 1000000ull;
+  return 0;
+}
+
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first, uint64_t interval) {
+  size_t i;
+
+  timer->_clock = now + first;
+  timer->_period = interval;
+
+  for (i = 0; i < timer_count; i++) {
+    if (timers[i] == timer) {
+      return;
+    }
+  }
+  timers[timer_count++] = timer;
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer) {
+  timer->_clock = 0;
+}
+
+/* stubs for the memory class API */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+/* stubs for the kernel routing API */
+static const struct os_route_parameter OS_ROUTE_WILDCARD = { .family = AF_UNSPEC,
+  .src_ip = { ._type = AF_UNSPEC },
+  .gw = { ._type = AF_UNSPEC },
+  .type = OS_ROUTE_UNDEFINED,
+  .key =
+    {
+      .dst = { ._type = AF_UNSPEC },
+      .src = { ._type = AF_UNSPEC },
+    },
+  .table = RT_TABLE_UNSPEC,
+  .metric = -1,
+  .protocol = RTPROT_UNSPEC,
+  .if_index = 0 };
+
+void
+os_routing_linux_init_wildcard_route(struct os_route *route) {
+  memset(route, 0, sizeof(*route));
+  memcpy(&route->p, &OS_ROUTE_WILDCARD, sizeof(route->p));
+}
+
+int
+os_routing_linux_set(struct os_route *route, bool set, bool del_similar) {
+  if (kernel_log_count < MAX_KERNEL_ROUTES) {
+    kernel_log[kernel_log_count].route = route;
+    kernel_log[kernel_log_count].set = set;
+    kernel_log[kernel_log_count].del_similar = del_similar;
+    kernel_log_count++;
+  }
+
+  if (route->cb_finished) {
+    kernel_pending[kernel_pending_count++] = route;
+  }
+  return 0;
+}
+
+int
+os_routing_linux_query(struct os_route *route) {
+  kernel_query = route;
+  return 0;
+}
+
+bool
+os_routing_linux_is_in_progress(struct os_route *route) {
+  size_t i;
+
+  if (route == kernel_query) {
+    return true;
+  }
+  for (i = 0; i < kernel_pending_count; i++) {
+    if (kernel_pending[i] == route) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+os_routing_linux_interrupt(struct os_route *route) {
+  size_t i;
+
+  if (route == kernel_query) {
+    kernel_query = NULL;
+  }
+  else {
+    for (i = 0; i < kernel_pending_count && kernel_pending[i] != route; i++)
+      ;
+    if (i == kernel_pending_count) {
+      return;
+    }
+    kernel_pending[i] = kernel_pending[--kernel_pending_count];
+  }
+
+  if (route->cb_finished) {
+    route->cb_finished(route, -1);
+  }
+}
+
+/* stubs for the NHDP API */
+struct list_entity *
+nhdp_domain_get_list(void) {
+  return &domain_list;
+}
+
+void
+nhdp_domain_listener_add(struct nhdp_domain_listener *listener __attribute__((unused))) {}
+
+void
+nhdp_domain_listener_remove(struct nhdp_domain_listener *listener __attribute__((unused))) {}
+
+struct list_entity *
+nhdp_db_get_neigh_list(void) {
+  return &neigh_list;
+}
+
+struct hashmap *
+nhdp_db_get_naddr_index(void) {
+  return &naddr_index;
+}
+
+struct avl_tree *
+nhdp_interface_get_address_tree(void) {
+  return &if_addr_tree;
+}
+
+/* stubs for the OLSRv2 API */
+bool
+olsrv2_is_nhdp_routable(struct netaddr *addr __attribute__((unused))) {
+  return true;
+}
+
+bool
+olsrv2_is_routable(struct netaddr *addr __attribute__((unused))) {
+  return true;
+}
+
+const struct netaddr *
+olsrv2_originator_get(int af_type) {
+  return af_type == AF_INET ? &originator : &NETADDR_UNSPEC;
+}
+
+bool
+olsrv2_originator_is_local(const struct netaddr *addr) {
+  return netaddr_cmp(addr, &originator) == 0;
+}
+
+struct avl_tree *
+olsrv2_lan_get_tree(void) {
+  return &lan_tree;
+}
+
+struct avl_tree *
+olsrv2_tc_get_tree(void) {
+  return &tc_tree;
+}
+
+struct avl_tree *
+olsrv2_tc_get_endpoint_tree(void) {
+  return &endpoint_tree;
+}
+
+struct olsrv2_tc_node *
+olsrv2_tc_node_get(const struct netaddr *addr) {
+  struct olsrv2_tc_node *node;
+
+  return avl_find_element(&tc_tree, addr, node, _originator_node);
+}
+
+static void
+make_addr(struct netaddr *addr, const char *str) {
+  if (netaddr_from_string(addr, str)) {
+    netaddr_invalidate(addr);
+  }
+}
+
+static void
+init_tc_node(struct olsrv2_tc_node *node, const char *addr) {
+  struct netaddr dst;
+
+  make_addr(&dst, addr);
+  os_routing_init_sourcespec_prefix(&node->target.prefix, &dst);
+  node->target.type = OLSRV2_NODE_TARGET;
+  olsrv2_routing_dijkstra_node_init(&node->target._dijkstra, &node->target.prefix.dst);
+
+  avl_init(&node->_edges, avl_comp_netaddr, false);
+  avl_init(&node->_attached_networks, os_routing_avl_cmp_route_key, false);
+
+  node->_originator_node.key = &node->target.prefix.dst;
+  avl_insert(&tc_tree, &node->_originator_node);
+}
+
+static void
+init_link(struct nhdp_link *lnk, struct nhdp_neighbor *neigh, int if_idx, const char *addr) {
+  make_addr(&lnk->if_addr, addr);
+  lnk->status = NHDP_LINK_SYMMETRIC;
+  lnk->local_if = &nhdp_if[if_idx];
+  lnk->neigh = neigh;
+  lnk->_domain_slot = lnk - links;
+  avl_init(&lnk->_2hop, avl_comp_netaddr, false);
+  list_add_tail(&neigh->_links, &lnk->_neigh_node);
+
+  linkdata[lnk->_domain_slot].metric.in = LINK_COST;
+  linkdata[lnk->_domain_slot].metric.out = LINK_COST;
+}
+
+static void
+init_neighbor(int idx, const char *addr) {
+  struct nhdp_neighbor *neigh = &neighbors[idx];
+  struct nhdp_naddr *naddr = &naddrs[idx];
+
+  make_addr(&neigh->originator, addr);
+  neigh->symmetric = 1;
+  neigh->_domain_slot = idx;
+  list_init_head(&neigh->_links);
+  avl_init(&neigh->_neigh_addresses, avl_comp_netaddr, false);
+  list_add_tail(&neigh_list, &neigh->_global_node);
+
+  /* the neighbor is reached through a link on its own interface */
+  init_link(&links[idx], neigh, idx, addr);
+
+  memcpy(&naddr->neigh_addr, &neigh->originator, sizeof(naddr->neigh_addr));
+  naddr->neigh = neigh;
+  naddr->_neigh_node.key = &naddr->neigh_addr;
+  naddr->_global_index_node.key = &naddr->neigh_addr;
+  avl_insert(&neigh->_neigh_addresses, &naddr->_neigh_node);
+  hashmap_insert(&naddr_index, &naddr->_global_index_node);
+
+  neighdata[idx].metric.in = LINK_COST;
+  neighdata[idx].metric.out = LINK_COST;
+  neighdata[idx].best_out_link = &links[idx];
+  neighdata[idx].best_out_link_metric = LINK_COST;
+  neighdata[idx].best_link_ifindex = os_if[idx].index;
+
+  init_tc_node(&tc_nodes[idx], addr);
+}
+
+static void
+set_edge_costs(uint32_t cost1, uint32_t cost2) {
+  edges[0].cost[0] = cost1;
+  edges[1].cost[0] = cost2;
+}
+
+static void
+clear_elements(void) {
+  int i;
+
+  now = 1000;
+
+  memset(&domain, 0, sizeof(domain));
+  memset(&storage, 0, sizeof(storage));
+  memset(linkdata, 0, sizeof(linkdata));
+  memset(neighdata, 0, sizeof(neighdata));
+  memset(neighbors, 0, sizeof(neighbors));
+  memset(links, 0, sizeof(links));
+  memset(naddrs, 0, sizeof(naddrs));
+  memset(tc_nodes, 0, sizeof(tc_nodes));
+  memset(edges, 0, sizeof(edges));
+  memset(os_if, 0, sizeof(os_if));
+  memset(nhdp_if, 0, sizeof(nhdp_if));
+
+  timer_count = 0;
+  kernel_pending_count = 0;
+  kernel_query = NULL;
+  kernel_log_count = 0;
+
+  /* one NHDP domain */
+  link_pages[0] = linkdata;
+  neigh_pages[0] = neighdata;
+  storage.pages[NHDP_DOMAIN_DATA_LINK] = link_pages;
+  storage.pages[NHDP_DOMAIN_DATA_NEIGHBOR] = neigh_pages;
+  domain._storage = &storage;
+  list_init_head(&domain_list);
+  list_add_tail(&domain_list, &domain._node);
+
+  /* two local interfaces */
+  for (i = 0; i < 2; i++) {
+    os_if[i].index = i + 1;
+    snprintf(os_if[i].name, sizeof(os_if[i].name), "if%d", i + 1);
+    nhdp_if[i].os_if_listener.data = &os_if[i];
+  }
+
+  list_init_head(&neigh_list);
+  hashmap_init(&naddr_index, hashmap_hash_netaddr, avl_comp_netaddr);
+  avl_init(&if_addr_tree, avl_comp_netaddr, false);
+  avl_init(&tc_tree, avl_comp_netaddr, false);
+  avl_init(&endpoint_tree, os_routing_avl_cmp_route_key, false);
+  avl_init(&lan_tree, os_routing_avl_cmp_route_key, false);
+
+  make_addr(&originator, "10.0.0.1");
+  init_neighbor(0, "10.0.0.2");
+  init_neighbor(1, "10.0.0.3");
+  init_tc_node(&tc_nodes[NEIGH_COUNT], "10.0.0.4");
+
+  /* both neighbors announce the destination D */
+  for (i = 0; i < NEIGH_COUNT; i++) {
+    edges[i].src = &tc_nodes[i];
+    edges[i].dst = &tc_nodes[NEIGH_COUNT];
+    edges[i]._node.key = &tc_nodes[NEIGH_COUNT].target.prefix.dst;
+    avl_insert(&tc_nodes[i]._edges, &edges[i]._node);
+  }
+  set_edge_costs(10, 20);
+
+  memset(&parameter, 0, sizeof(parameter));
+  parameter.protocol = 100;
+  parameter.table = 254;
+  parameter.distance = 2;
+  parameter.ecmp_max_paths = 1;
+  parameter.spf_initial_delay = 10;
+  parameter.spf_hold = 100;
+  parameter.spf_max_wait = 1000;
+}
+
+/* fire all timers that are due */
+static void
+run_timers(void) {
+  struct oonf_timer_instance *timer;
+  bool fired;
+  size_t i;
+
+  do {
+    fired = false;
+    for (i = 0; i < timer_count; i++) {
+      timer = timers[i];
+      if (timer->_clock != 0 && timer->_clock <= now) {
+        timer->_clock = 0;
+        timer->class->callback(timer);
+        fired = true;
+      }
+    }
+  } while (fired);
+}
+
+/* advance simulated time millisecond by millisecond */
+static void
+advance_time(uint64_t interval) {
+  uint64_t end = now + interval;
+
+  while (now < end) {
+    now++;
+    run_timers();
+  }
+}
+
+/* report success for all routes handed to the kernel */
+static void
+finish_kernel_routes(void) {
+  struct os_route *route;
+
+  while (kernel_pending_count > 0) {
+    route = kernel_pending[--kernel_pending_count];
+    route->cb_finished(route, 0);
+  }
+}
+
+/* count the kernel operations since a position in the log */
+static uint32_t
+count_kernel_ops(size_t start, bool set) {
+  uint32_t count = 0;
+  size_t i;
+
+  for (i = start; i < kernel_log_count; i++) {
+    if (kernel_log[i].set == set) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/* get the last kernel operation of a routing entry since a position in the log */
+static struct kernel_op *
+get_kernel_op(size_t start, struct olsrv2_routing_entry *rtentry) {
+  size_t i;
+
+  for (i = kernel_log_count; rtentry != NULL && i > start; i--) {
+    if (kernel_log[i - 1].route == &rtentry->route) {
+      return &kernel_log[i - 1];
+    }
+  }
+  return NULL;
+}
+
+/* add a route of this domain to a kernel routing table dump */
+static void
+add_kernel_route(const char *dst, const char *gw, unsigned if_index, unsigned char protocol) {
+  struct os_route route;
+  struct netaddr addr;
+
+  if (kernel_query == NULL) {
+    return;
+  }
+
+  os_routing_init_wildcard_route(&route);
+  make_addr(&addr, dst);
+  os_routing_init_sourcespec_prefix(&route.p.key, &addr);
+  make_addr(&route.p.gw, gw);
+  route.p.family = AF_INET;
+  route.p.type = OS_ROUTE_UNICAST;
+  route.p.if_index = if_index;
+  route.p.protocol = protocol;
+  route.p.table = parameter.table;
+  route.p.metric = parameter.distance;
+
+  kernel_query->cb_get(kernel_query, &route);
+}
+
+/* end the kernel routing table dump */
+static void
+finish_kernel_query(void) {
+  struct os_route *query = kernel_query;
+
+  if (query != NULL) {
+    kernel_query = NULL;
+    query->cb_finished(query, 0);
+  }
+}
+
+/* run the dijkstra immediately and apply the result to the kernel */
+static void
+run_dijkstra(void) {
+  olsrv2_routing_domain_changed_ext(&domain, false, OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+  olsrv2_routing_force_update(true);
+  finish_kernel_routes();
+}
+
+static void
+start_routing(void) {
+  olsrv2_routing_init();
+  olsrv2_routing_set_domain_parameter(&domain, &parameter);
+}
+
+static void
+stop_routing(void) {
+  olsrv2_routing_cleanup();
+  hashmap_free(&naddr_index);
+}
+
+static struct olsrv2_routing_entry *
+get_route(const char *dst) {
+  struct olsrv2_routing_entry *rtentry;
+  struct os_route_key key;
+  struct netaddr addr;
+
+  make_addr(&addr, dst);
+  os_routing_init_sourcespec_prefix(&key, &addr);
+  return avl_find_element(olsrv2_routing_get_tree(&domain), &key, rtentry, _node);
+}
+
+static bool
+is_route_via(struct olsrv2_routing_entry *rtentry, const char *gw, unsigned if_index) {
+  struct netaddr_str nbuf;
+
+  return rtentry != NULL && rtentry->set && rtentry->route.p.if_index == if_index &&
+         strcmp(netaddr_to_string(&nbuf, &rtentry->route.p.gw), gw) == 0;
+}
+
+static bool
+has_nexthop(struct olsrv2_routing_entry *rtentry, const char *gw, unsigned if_index) {
+  struct netaddr_str nbuf;
+  unsigned i;
+
+  if (is_route_via(rtentry, gw, if_index)) {
+    return true;
+  }
+  for (i = 0; rtentry != NULL && i < rtentry->route.p.multipath_count; i++) {
+    if (rtentry->route.p.multipath[i].if_index == if_index &&
+        strcmp(netaddr_to_string(&nbuf, &rtentry->route.p.multipath[i].gw), gw) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool
+is_next_originator(struct olsrv2_routing_entry *rtentry, const char *addr) {
+  struct netaddr_str nbuf;
+
+  return strcmp(netaddr_to_string(&nbuf, &rtentry->next_originator), addr) == 0;
+}
+
+static void
+enable_dampening(void) {
+  parameter.dampening = true;
+  parameter.dampening_penalty = 1000;
+  parameter.dampening_suppress = 1500;
+  parameter.dampening_reuse = 750;
+  parameter.dampening_half_life = 10000;
+}
+
+/* flip the best path to D between N1 and N2 until the route is suppressed */
+static void
+flap_until_suppressed(void) {
+  set_edge_costs(10, 20);
+  run_dijkstra();
+
+  set_edge_costs(30, 5);
+  now += 100;
+  run_dijkstra();
+
+  set_edge_costs(10, 20);
+  now += 100;
+  run_dijkstra();
+}
+
+static void
+test_warm_restart(void) {
+  const struct olsrv2_routing_statistics *stats;
+  struct olsrv2_routing_entry *rtentry;
+  struct kernel_op *op;
+  uint32_t adopted;
+  size_t log_start;
+
+  START_TEST();
+
+  start_routing();
+  olsrv2_routing_set_kernel_audit(0, 5000);
+  stats = olsrv2_routing_get_statistics(&domain);
+  adopted = stats->audit_adopted;
+
+  /* startup audit finds the routes of a previous instance */
+  advance_time(1);
+  CHECK_TRUE(kernel_query != NULL, "no kernel audit during startup");
+
+  add_kernel_route("10.0.0.4", "10.0.0.3", 2, parameter.protocol);
+  add_kernel_route("10.0.0.99", "10.0.0.3", 2, parameter.protocol);
+  add_kernel_route("10.0.0.98", "10.0.0.3", 2, parameter.protocol + 1);
+  finish_kernel_query();
+
+  CHECK_TRUE(stats->audit_adopted == adopted + 2, "%u kernel routes adopted", stats->audit_adopted - adopted);
+  CHECK_TRUE(get_route("10.0.0.98") == NULL, "route of other protocol was adopted");
+
+  rtentry = get_route("10.0.0.99");
+  CHECK_TRUE(rtentry != NULL && rtentry->adopted, "stale kernel route was not adopted");
+
+  /* first dijkstra takes over the adopted route and keeps the stale one */
+  log_start = kernel_log_count;
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.2", 1), "adopted route was not taken over by dijkstra");
+  CHECK_TRUE(rtentry != NULL && !rtentry->adopted, "calculated route is still marked as adopted");
+  op = get_kernel_op(log_start, rtentry);
+  CHECK_TRUE(op != NULL && op->set, "adopted route was not set again");
+
+  rtentry = get_route("10.0.0.99");
+  CHECK_TRUE(rtentry != NULL && rtentry->set, "stale route was removed during warm restart hold");
+  CHECK_TRUE(count_kernel_ops(log_start, false) == 0, "route was removed during warm restart hold");
+
+  /* routes of the previous instance are removed after the hold time */
+  log_start = kernel_log_count;
+  advance_time(5000 + parameter.spf_hold);
+  rtentry = get_route("10.0.0.99");
+  op = get_kernel_op(log_start, rtentry);
+  CHECK_TRUE(op != NULL && !op->set && !op->del_similar, "stale route was not removed after warm restart hold");
+
+  finish_kernel_routes();
+  CHECK_TRUE(get_route("10.0.0.99") == NULL, "stale route is still in the routing set");
+
+  olsrv2_routing_set_kernel_audit(0, 0);
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_kernel_audit(void) {
+  const struct olsrv2_routing_statistics *stats;
+  struct olsrv2_routing_entry *rtentry;
+  struct kernel_op *op;
+  uint32_t repaired;
+  size_t log_start;
+
+  START_TEST();
+
+  start_routing();
+  stats = olsrv2_routing_get_statistics(&domain);
+  repaired = stats->audit_repaired;
+
+  run_dijkstra();
+  olsrv2_routing_set_kernel_audit(1000, 0);
+
+  /* drop the startup audit, nothing has been set at this point */
+  advance_time(1);
+  kernel_query = NULL;
+
+  advance_time(1000);
+  CHECK_TRUE(kernel_query != NULL, "no periodic kernel audit");
+
+  /* route to D was changed, route to N2 was removed by someone else */
+  add_kernel_route("10.0.0.2", "10.0.0.2", 1, parameter.protocol);
+  add_kernel_route("10.0.0.4", "10.0.0.3", 2, parameter.protocol);
+
+  log_start = kernel_log_count;
+  finish_kernel_query();
+
+  CHECK_TRUE(stats->audit_repaired == repaired + 2, "%u kernel routes repaired", stats->audit_repaired - repaired);
+  CHECK_TRUE(get_kernel_op(log_start, get_route("10.0.0.2")) == NULL, "unchanged kernel route was repaired");
+
+  rtentry = get_route("10.0.0.4");
+  op = get_kernel_op(log_start, rtentry);
+  CHECK_TRUE(op != NULL && op->set, "changed kernel route was not set again");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.2", 1), "repaired route does not use N1");
+
+  op = get_kernel_op(log_start, get_route("10.0.0.3"));
+  CHECK_TRUE(op != NULL && op->set, "missing kernel route was not set again");
+
+  finish_kernel_routes();
+  olsrv2_routing_set_kernel_audit(0, 0);
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_dampening_suppress(void) {
+  const struct olsrv2_routing_statistics *stats;
+  struct olsrv2_routing_entry *rtentry;
+  uint32_t suppressed;
+  size_t log_start;
+
+  START_TEST();
+
+  enable_dampening();
+  start_routing();
+  stats = olsrv2_routing_get_statistics(&domain);
+
+  flap_until_suppressed();
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.2", 1), "route to D does not use N1");
+  CHECK_TRUE(rtentry != NULL && rtentry->suppressed, "route to D was not suppressed after two changes");
+
+  /* next change is cheaper through N2, but must be suppressed */
+  suppressed = stats->suppressed_changes;
+  log_start = kernel_log_count;
+  set_edge_costs(30, 5);
+  now += 100;
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(stats->suppressed_changes == suppressed + 1, "change was not counted as suppressed");
+  CHECK_TRUE(count_kernel_ops(log_start, true) == 0, "suppressed change was sent to the kernel");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.2", 1), "suppressed route does not use N1 anymore");
+  if (rtentry) {
+    CHECK_TRUE(is_next_originator(rtentry, "10.0.0.2"), "next originator was not restored");
+    CHECK_TRUE(rtentry->path_cost == LINK_COST + 10, "path cost %u was not restored", rtentry->path_cost);
+    CHECK_TRUE(rtentry->path_hops == 2, "path hops %u were not restored", rtentry->path_hops);
+  }
+
+  /* after three half-lifes the penalty has decayed, so the route moves to N2 */
+  advance_time(30000);
+  finish_kernel_routes();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.3", 2), "released route does not use N2");
+  CHECK_TRUE(stats->suppressed_changes == suppressed + 1, "released change was suppressed again");
+  if (rtentry) {
+    CHECK_TRUE(is_next_originator(rtentry, "10.0.0.3"), "next originator of released route is not N2");
+    CHECK_TRUE(rtentry->path_cost == LINK_COST + 5, "path cost of released route is %u", rtentry->path_cost);
+  }
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_dampening_lost_nexthop(void) {
+  struct olsrv2_routing_entry *rtentry;
+
+  START_TEST();
+
+  enable_dampening();
+  start_routing();
+
+  flap_until_suppressed();
+
+  /* N1 is lost, the suppressed route must not keep it */
+  neighbors[0].symmetric = 0;
+  now += 100;
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.3", 2), "route to D does not switch to N2 when N1 is lost");
+  if (rtentry) {
+    CHECK_TRUE(is_next_originator(rtentry, "10.0.0.3"), "next originator is not N2");
+  }
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_no_dampening(void) {
+  const struct olsrv2_routing_statistics *stats;
+  struct olsrv2_routing_entry *rtentry;
+  uint32_t suppressed;
+
+  START_TEST();
+
+  start_routing();
+  stats = olsrv2_routing_get_statistics(&domain);
+  suppressed = stats->suppressed_changes;
+
+  flap_until_suppressed();
+  set_edge_costs(30, 5);
+  now += 100;
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.3", 2), "route to D does not follow the topology");
+  CHECK_TRUE(stats->suppressed_changes == suppressed, "change was suppressed without dampening");
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_ecmp_equal_cost(void) {
+  struct olsrv2_routing_entry *rtentry;
+
+  START_TEST();
+
+  parameter.ecmp_max_paths = 2;
+  start_routing();
+
+  set_edge_costs(10, 10);
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(rtentry != NULL && rtentry->route.p.multipath_count == 1, "route to D is not a multipath route");
+  CHECK_TRUE(has_nexthop(rtentry, "10.0.0.2", 1), "route to D does not use N1");
+  CHECK_TRUE(has_nexthop(rtentry, "10.0.0.3", 2), "route to D does not use N2");
+  CHECK_TRUE(olsrv2_routing_get_statistics(&domain)->multipath_routes == 1, "multipath route was not counted");
+
+  /* direct routes to the neighbors have no gateway and no alternative */
+  rtentry = get_route("10.0.0.2");
+  CHECK_TRUE(rtentry != NULL && rtentry->route.p.multipath_count == 0, "route to N1 is a multipath route");
+
+  /* a cheaper path through one neighbor removes the alternative */
+  set_edge_costs(10, 20);
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(rtentry != NULL && rtentry->route.p.multipath_count == 0, "more expensive path is used for multipath");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.2", 1), "route to D does not use N1");
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_ecmp_tolerance(void) {
+  struct olsrv2_routing_entry *rtentry;
+
+  START_TEST();
+
+  parameter.ecmp_max_paths = 2;
+  parameter.ecmp_tolerance = 10;
+  start_routing();
+
+  set_edge_costs(10, 20);
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.2", 1), "route to D does not use the cheapest path through N1");
+  CHECK_TRUE(has_nexthop(rtentry, "10.0.0.3", 2), "path within the tolerance is not used");
+
+  /* path outside of the tolerance */
+  set_edge_costs(10, 21);
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(rtentry != NULL && rtentry->route.p.multipath_count == 0, "path outside the tolerance is used");
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_ecmp_parallel_links(void) {
+  struct olsrv2_routing_entry *rtentry;
+
+  START_TEST();
+
+  /* second link to N1 on the interface of N2 */
+  init_link(&links[NEIGH_COUNT], &neighbors[0], 1, "10.0.1.2");
+
+  parameter.ecmp_max_paths = 2;
+  start_routing();
+
+  set_edge_costs(10, 100);
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(rtentry != NULL && rtentry->route.p.multipath_count == 1, "route to D is not a multipath route");
+  CHECK_TRUE(is_route_via(rtentry, "10.0.0.2", 1), "route to D does not use the best link to N1");
+  CHECK_TRUE(has_nexthop(rtentry, "10.0.1.2", 2), "route to D does not use the parallel link to N1");
+
+  /* a more expensive parallel link is not used */
+  linkdata[NEIGH_COUNT].metric.out = LINK_COST + 1;
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(rtentry != NULL && rtentry->route.p.multipath_count == 0, "expensive parallel link is used");
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_ecmp_disabled(void) {
+  struct olsrv2_routing_entry *rtentry;
+
+  START_TEST();
+
+  start_routing();
+
+  set_edge_costs(10, 10);
+  run_dijkstra();
+
+  rtentry = get_route("10.0.0.4");
+  CHECK_TRUE(rtentry != NULL && rtentry->set && rtentry->route.p.multipath_count == 0,
+    "route to D is a multipath route without ECMP");
+
+  stop_routing();
+  END_TEST();
+}
+
+/* trigger a dijkstra and wait until the rate limitation allows it to run */
+static uint64_t
+trigger_dijkstra(enum olsrv2_routing_cause cause) {
+  const struct olsrv2_routing_statistics *stats;
+  uint64_t start;
+  uint32_t runs;
+
+  stats = olsrv2_routing_get_statistics(&domain);
+  runs = stats->dijkstra_runs;
+  start = now;
+
+  olsrv2_routing_domain_changed_ext(&domain, false, cause);
+  while (stats->dijkstra_runs == runs && now - start < 10000) {
+    advance_time(1);
+  }
+  finish_kernel_routes();
+  return now - start;
+}
+
+static void
+test_spf_hold_time(void) {
+  const struct olsrv2_routing_dijkstra_run *run;
+  uint64_t delay, expected;
+  int i;
+
+  START_TEST();
+
+  start_routing();
+
+  /* a single change waits for the initial delay */
+  delay = trigger_dijkstra(OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+  run = olsrv2_routing_get_dijkstra_run(&domain, 0);
+  CHECK_TRUE(delay == parameter.spf_initial_delay, "first dijkstra ran after %" PRIu64 " ms", delay);
+  CHECK_TRUE(run != NULL && run->hold == parameter.spf_hold, "hold time of first run is wrong");
+
+  /* continuous changes double the hold time up to the maximum */
+  expected = parameter.spf_hold;
+  for (i = 0; i < 6; i++) {
+    delay = trigger_dijkstra(OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+    CHECK_TRUE(delay == expected, "dijkstra %d ran after %" PRIu64 " ms instead of %" PRIu64 " ms", i, delay, expected);
+
+    expected *= 2;
+    if (expected > parameter.spf_max_wait) {
+      expected = parameter.spf_max_wait;
+    }
+    run = olsrv2_routing_get_dijkstra_run(&domain, 0);
+    CHECK_TRUE(run != NULL && run->hold == expected, "hold time of dijkstra %d is %" PRIu64 " ms", i,
+      run ? run->hold : 0);
+  }
+
+  /* the hold time is reset after a calm period */
+  advance_time(2 * parameter.spf_max_wait + 1);
+  delay = trigger_dijkstra(OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+  run = olsrv2_routing_get_dijkstra_run(&domain, 0);
+  CHECK_TRUE(delay == parameter.spf_initial_delay, "dijkstra after calm period ran after %" PRIu64 " ms", delay);
+  CHECK_TRUE(run != NULL && run->hold == parameter.spf_hold, "hold time was not reset after calm period");
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_spf_causes(void) {
+  const struct olsrv2_routing_statistics *stats;
+  const struct olsrv2_routing_dijkstra_run *run;
+  struct olsrv2_routing_cause_str cbuf;
+  uint32_t runs;
+
+  START_TEST();
+
+  start_routing();
+  stats = olsrv2_routing_get_statistics(&domain);
+
+  /* all changes until the dijkstra runs are handled by a single run */
+  runs = stats->dijkstra_runs;
+  olsrv2_routing_domain_changed_ext(&domain, false, OLSRV2_ROUTING_CAUSE_LAN);
+  advance_time(5);
+  olsrv2_routing_domain_changed_ext(&domain, false, OLSRV2_ROUTING_CAUSE_METRIC);
+  advance_time(parameter.spf_initial_delay);
+
+  run = olsrv2_routing_get_dijkstra_run(&domain, 0);
+  CHECK_TRUE(stats->dijkstra_runs == runs + 1, "%u dijkstra runs for two changes", stats->dijkstra_runs - runs);
+  CHECK_TRUE(run != NULL && run->causes == (OLSRV2_ROUTING_CAUSE_LAN | OLSRV2_ROUTING_CAUSE_METRIC),
+    "causes of dijkstra run are %s", run ? olsrv2_routing_cause_to_string(&cbuf, run->causes) : "-");
+  CHECK_TRUE(run != NULL && run->delay == parameter.spf_initial_delay, "delay of dijkstra run is wrong");
+
+  /* the old API triggers a dijkstra without a specific cause */
+  advance_time(2 * parameter.spf_max_wait + 1);
+  olsrv2_routing_domain_changed(&domain, false);
+  advance_time(parameter.spf_initial_delay);
+
+  run = olsrv2_routing_get_dijkstra_run(&domain, 0);
+  CHECK_TRUE(run != NULL && run->causes == OLSRV2_ROUTING_CAUSE_EXTERNAL, "causes of dijkstra run are %s",
+    run ? olsrv2_routing_cause_to_string(&cbuf, run->causes) : "-");
+
+  run = olsrv2_routing_get_dijkstra_run(&domain, 1);
+  CHECK_TRUE(run != NULL && strcmp(olsrv2_routing_cause_to_string(&cbuf, run->causes), "lan,metric") == 0,
+    "causes of older dijkstra run are %s", run ? olsrv2_routing_cause_to_string(&cbuf, run->causes) : "-");
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_spf_zero_hold(void) {
+  const struct olsrv2_routing_dijkstra_run *run;
+  uint64_t hold;
+  int i;
+
+  START_TEST();
+
+  parameter.spf_hold = 0;
+  start_routing();
+
+  /* the hold time starts with a minimal value instead of zero */
+  trigger_dijkstra(OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+  run = olsrv2_routing_get_dijkstra_run(&domain, 0);
+  CHECK_TRUE(run != NULL && run->hold > 0, "hold time of first run is zero");
+
+  /* and still doubles with continuous changes */
+  for (i = 0; i < 4 && run != NULL; i++) {
+    hold = run->hold;
+    trigger_dijkstra(OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+    run = olsrv2_routing_get_dijkstra_run(&domain, 0);
+    CHECK_TRUE(run != NULL && run->hold == 2 * hold, "hold time of dijkstra %d did not grow from %" PRIu64 " ms",
+      i, hold);
+  }
+
+  stop_routing();
+  END_TEST();
+}
+
+static void
+test_spf_force_update(void) {
+  const struct olsrv2_routing_statistics *stats;
+  uint32_t runs;
+
+  START_TEST();
+
+  start_routing();
+  stats = olsrv2_routing_get_statistics(&domain);
+  runs = stats->dijkstra_runs;
+
+  /* a forced update without skip_wait respects the running rate limitation */
+  olsrv2_routing_domain_changed_ext(&domain, false, OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+  olsrv2_routing_force_update(false);
+  CHECK_TRUE(stats->dijkstra_runs == runs, "dijkstra ran despite rate limitation");
+
+  advance_time(parameter.spf_initial_delay);
+  finish_kernel_routes();
+  CHECK_TRUE(stats->dijkstra_runs == runs + 1, "dijkstra did not run after rate limitation");
+
+  /* skip_wait runs the dijkstra immediately */
+  olsrv2_routing_domain_changed_ext(&domain, false, OLSRV2_ROUTING_CAUSE_TOPOLOGY);
+  olsrv2_routing_force_update(true);
+  finish_kernel_routes();
+  CHECK_TRUE(stats->dijkstra_runs == runs + 2, "dijkstra did not run with skip_wait");
+
+  /* nothing to do without a pending change */
+  olsrv2_routing_force_update(true);
+  CHECK_TRUE(stats->dijkstra_runs == runs + 2, "dijkstra ran without a change");
+
+  stop_routing();
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  BEGIN_TESTING(clear_elements);
+
+  /* the startup audit of the routing code only happens once */
+  test_warm_restart();
+  test_kernel_audit();
+
+  test_dampening_suppress();
+  test_dampening_lost_nexthop();
+  test_no_dampening();
+  test_ecmp_equal_cost();
+  test_ecmp_tolerance();
+  test_ecmp_parallel_links();
+  test_ecmp_disabled();
+  test_spf_hold_time();
+  test_spf_causes();
+  test_spf_zero_hold();
+  test_spf_force_update();
+
+  return FINISH_TESTING();
+}
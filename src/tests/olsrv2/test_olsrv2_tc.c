@@ -0,0 +1,370 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <oonf/libcommon/avl.h>
+#include <oonf/libcommon/hashmap.h>
+#include <oonf/libcommon/netaddr.h>
+#include <oonf/cunit/cunit.h>
+
+#include <oonf/base/oonf_class.h>
+#include <oonf/base/oonf_timer.h>
+#include <oonf/base/os_routing.h>
+#include <oonf/olsrv2/olsrv2/olsrv2_routing.h>
+#include <oonf/olsrv2/olsrv2/olsrv2_tc.h>
+
+/*
+ * The topology database is linked directly into this test,
+ * memory classes, timers and the routing code are replaced by stubs.
+ */
+
+/* number of nodes of the synthetic topology */
+#define NODE_COUNT 2000
+
+/* number of edges each node announces in its TC */
+#define EDGE_COUNT 4
+
+/* number of times the topology is received for the benchmark */
+#define ROUNDS 20
+
+static struct netaddr addr[NODE_COUNT];
+static uint32_t edge_events;
+
+/* stubs for the timer API */
+void
+oonf_timer_add(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_remove(struct oonf_timer_class *ti __attribute__((unused))) {}
+
+void
+oonf_timer_set_ext(struct oonf_timer_instance *timer, uint64_t first, uint64_t interval) {
+  /* only remember if the timer is active */
+  timer->_clock = first;
+  timer->_period = interval;
+}
+
+void
+oonf_timer_stop(struct oonf_timer_instance *timer) {
+  timer->_clock = 0;
+}
+
+/* stubs for the memory class API */
+void
+oonf_class_add(struct oonf_class *ci __attribute__((unused))) {}
+
+void
+oonf_class_remove(struct oonf_class *ci __attribute__((unused))) {}
+
+void *
+oonf_class_malloc(struct oonf_class *ci) {
+  return calloc(1, ci->size);
+}
+
+void
+oonf_class_free(struct oonf_class *ci __attribute__((unused)), void *ptr) {
+  free(ptr);
+}
+
+void
+oonf_class_event(struct oonf_class *ci, void *ptr __attribute__((unused)),
+  enum oonf_class_event evt __attribute__((unused))) {
+  if (strcmp(ci->name, OLSRV2_CLASS_TC_EDGE) == 0) {
+    edge_events++;
+  }
+}
+
+int
+oonf_class_extension_add(struct oonf_class_extension *ext __attribute__((unused))) {
+  return 0;
+}
+
+void
+oonf_class_extension_remove(struct oonf_class_extension *ext __attribute__((unused))) {}
+
+/* stubs for the routing API */
+void
+olsrv2_routing_dijkstra_node_init(struct olsrv2_dijkstra_node *dijkstra, const struct netaddr *originator) {
+  dijkstra->originator = originator;
+}
+
+void
+olsrv2_routing_domain_changed_ext(struct nhdp_domain *domain __attribute__((unused)),
+  bool autoupdate_ansn __attribute__((unused)), enum olsrv2_routing_cause cause __attribute__((unused))) {}
+
+void
+olsrv2_routing_trigger_update(void) {}
+
+static void
+clear_elements(void) {
+  edge_events = 0;
+}
+
+static uint64_t
+get_time_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* receive the TC of node i, it announces the next EDGE_COUNT nodes of the ring */
+static struct olsrv2_tc_node *
+receive_tc(uint32_t i) {
+  struct olsrv2_tc_node *node;
+  uint32_t e;
+
+  node = olsrv2_tc_node_add(&addr[i], 10000, 1);
+  for (e = 1; node != NULL && e <= EDGE_COUNT; e++) {
+    if (olsrv2_tc_edge_add(node, &addr[(i + e) % NODE_COUNT]) == NULL) {
+      return NULL;
+    }
+  }
+  return node;
+}
+
+static void
+test_node_index(void) {
+  struct olsrv2_tc_node *node, *prev;
+  struct netaddr unknown;
+  uint32_t i, count;
+  bool ok;
+
+  START_TEST();
+  olsrv2_tc_init();
+
+  ok = true;
+  for (i = 0; i < NODE_COUNT; i++) {
+    ok &= olsrv2_tc_node_add(&addr[i], 10000, 1) != NULL;
+  }
+  CHECK_TRUE(ok, "adding nodes failed");
+  CHECK_TRUE(olsrv2_tc_get_tree()->count == NODE_COUNT, "tree contains %u nodes", olsrv2_tc_get_tree()->count);
+
+  /* adding a known originator returns the existing node */
+  CHECK_TRUE(olsrv2_tc_node_add(&addr[5], 10000, 2) == olsrv2_tc_node_get(&addr[5]), "duplicate node was created");
+  CHECK_TRUE(olsrv2_tc_get_tree()->count == NODE_COUNT, "tree contains %u nodes", olsrv2_tc_get_tree()->count);
+
+  ok = true;
+  for (i = 0; i < NODE_COUNT; i++) {
+    node = olsrv2_tc_node_get(&addr[i]);
+    ok &= node != NULL && netaddr_cmp(&node->target.prefix.dst, &addr[i]) == 0;
+  }
+  CHECK_TRUE(ok, "lookup of nodes failed");
+
+  netaddr_from_binary(&unknown, (uint8_t[]){ 0xfd, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff }, 16, AF_INET6);
+  CHECK_TRUE(olsrv2_tc_node_get(&unknown) == NULL, "unknown originator was found");
+
+  /* the tree keeps the ordered iteration for the info plugins */
+  ok = true;
+  count = 0;
+  prev = NULL;
+  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+    ok &= prev == NULL || netaddr_cmp(&prev->target.prefix.dst, &node->target.prefix.dst) < 0;
+    prev = node;
+    count++;
+  }
+  CHECK_TRUE(ok && count == NODE_COUNT, "ordered iteration failed (%u nodes)", count);
+
+  /* removed nodes vanish from the index */
+  for (i = 0; i < NODE_COUNT; i += 2) {
+    olsrv2_tc_node_remove(olsrv2_tc_node_get(&addr[i]));
+  }
+
+  ok = true;
+  for (i = 0; i < NODE_COUNT; i++) {
+    node = olsrv2_tc_node_get(&addr[i]);
+    ok &= (i % 2 == 0) ? (node == NULL) : (node != NULL);
+  }
+  CHECK_TRUE(ok, "lookup after removal failed");
+  CHECK_TRUE(olsrv2_tc_get_tree()->count == NODE_COUNT / 2, "tree contains %u nodes", olsrv2_tc_get_tree()->count);
+
+  olsrv2_tc_cleanup();
+  END_TEST();
+}
+
+static void
+test_edge_index(void) {
+  struct olsrv2_tc_node *src, *dst;
+  struct olsrv2_tc_edge *edge, *edge2;
+
+  START_TEST();
+  olsrv2_tc_init();
+
+  /* an edge to an unknown originator creates a virtual node */
+  src = olsrv2_tc_node_add(&addr[0], 10000, 1);
+  edge = olsrv2_tc_edge_add(src, &addr[1]);
+  dst = olsrv2_tc_node_get(&addr[1]);
+  CHECK_TRUE(edge != NULL && !edge->virtual, "edge was not added");
+  CHECK_TRUE(dst != NULL && olsrv2_tc_is_node_virtual(dst), "destination is not a virtual node");
+  CHECK_TRUE(edge != NULL && edge->dst == dst && edge->inverse != NULL && edge->inverse->virtual,
+    "inverse edge is not virtual");
+
+  /* adding the edge again finds it in the index */
+  edge2 = olsrv2_tc_edge_add(src, &addr[1]);
+  CHECK_TRUE(edge2 == edge, "duplicate edge was created");
+  CHECK_TRUE(src->_edges.count == 1, "source has %u edges", src->_edges.count);
+
+  /* the inverse edge becomes real when the destination announces it */
+  dst = olsrv2_tc_node_add(&addr[1], 10000, 1);
+  edge2 = olsrv2_tc_edge_add(dst, &addr[0]);
+  CHECK_TRUE(edge != NULL && edge2 == edge->inverse && !edge2->virtual, "inverse edge was not reused");
+
+  /* removing the real edge leaves a virtual one */
+  olsrv2_tc_edge_remove(edge2);
+  edge2 = olsrv2_tc_edge_add(src, &addr[1]);
+  CHECK_TRUE(edge2 == edge, "edge lookup after removal of inverse edge failed");
+
+  olsrv2_tc_cleanup();
+  END_TEST();
+}
+
+static void
+test_endpoint_index(void) {
+  struct olsrv2_tc_attachment *net1, *net2;
+  struct olsrv2_tc_node *node1, *node2;
+  struct os_route_key prefix;
+
+  START_TEST();
+  olsrv2_tc_init();
+
+  node1 = olsrv2_tc_node_add(&addr[0], 10000, 1);
+  node2 = olsrv2_tc_node_add(&addr[1], 10000, 1);
+  os_routing_init_sourcespec_prefix(&prefix, &addr[2]);
+
+  /* both nodes share one endpoint */
+  net1 = olsrv2_tc_endpoint_add(node1, &prefix, false);
+  net2 = olsrv2_tc_endpoint_add(node2, &prefix, false);
+  CHECK_TRUE(net1 != NULL && net2 != NULL && net1 != net2, "attachments were not added");
+  CHECK_TRUE(net1 != NULL && net2 != NULL && net1->dst == net2->dst, "endpoint was not shared");
+  CHECK_TRUE(olsrv2_tc_get_endpoint_tree()->count == 1, "%u endpoints", olsrv2_tc_get_endpoint_tree()->count);
+
+  CHECK_TRUE(olsrv2_tc_endpoint_add(node1, &prefix, false) == net1, "duplicate attachment was created");
+
+  olsrv2_tc_endpoint_remove(net1);
+  olsrv2_tc_endpoint_remove(net2);
+  CHECK_TRUE(olsrv2_tc_get_endpoint_tree()->count == 0, "%u endpoints", olsrv2_tc_get_endpoint_tree()->count);
+
+  olsrv2_tc_cleanup();
+  END_TEST();
+}
+
+static void
+test_ingest_benchmark(void) {
+  struct olsrv2_tc_node *node;
+  struct olsrv2_tc_edge *edge;
+  uint64_t start, duration;
+  uint32_t i, r, edges;
+  bool ok;
+
+  START_TEST();
+  olsrv2_tc_init();
+
+  /* first reception creates the whole topology */
+  ok = true;
+  for (i = 0; i < NODE_COUNT; i++) {
+    ok &= receive_tc(i) != NULL;
+  }
+  CHECK_TRUE(ok, "creating topology failed");
+  CHECK_TRUE(olsrv2_tc_get_tree()->count == NODE_COUNT, "tree contains %u nodes", olsrv2_tc_get_tree()->count);
+
+  /* all edges of the ring are real, each of them has one virtual inverse */
+  edges = 0;
+  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+    avl_for_each_element(&node->_edges, edge, _node) {
+      edges += edge->virtual ? 0 : 1;
+    }
+  }
+  CHECK_TRUE(edges == NODE_COUNT * EDGE_COUNT, "topology contains %u real edges", edges);
+
+  /* refreshing the topology only uses lookups */
+  edge_events = 0;
+  start = get_time_ns();
+  for (r = 0; r < ROUNDS; r++) {
+    for (i = 0; i < NODE_COUNT; i++) {
+      ok &= receive_tc(i) != NULL;
+    }
+  }
+  duration = get_time_ns() - start;
+  CHECK_TRUE(ok, "refreshing topology failed");
+  CHECK_TRUE(edge_events == ROUNDS * NODE_COUNT * EDGE_COUNT, "%u edge events", edge_events);
+  CHECK_TRUE(olsrv2_tc_get_tree()->count == NODE_COUNT, "tree contains %u nodes", olsrv2_tc_get_tree()->count);
+
+  printf("%u TCs with %u edges of a %u node topology: %" PRIu64 " ns/TC, %" PRIu64 " TCs/s\n",
+    ROUNDS * NODE_COUNT, EDGE_COUNT, NODE_COUNT, duration / (ROUNDS * NODE_COUNT),
+    duration ? (uint64_t)(ROUNDS * NODE_COUNT * 1000000000ull / duration) : 0);
+
+  olsrv2_tc_cleanup();
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  uint8_t bin[16];
+  uint32_t i;
+
+  /* spread originators over the address space */
+  memset(bin, 0, sizeof(bin));
+  bin[0] = 0xfd;
+  for (i = 0; i < NODE_COUNT; i++) {
+    bin[13] = (uint8_t)(i * 37);
+    bin[14] = (uint8_t)(i >> 8);
+    bin[15] = (uint8_t)i;
+    netaddr_from_binary(&addr[i], bin, sizeof(bin), AF_INET6);
+  }
+
+  BEGIN_TESTING(clear_elements);
+
+  test_node_index();
+  test_edge_index();
+  test_endpoint_index();
+  test_ingest_benchmark();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,202 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <oonf/librfc5444/rfc5444_context.h>
+#include <oonf/librfc5444/rfc5444_writer.h>
+#include <oonf/cunit/cunit.h>
+
+#define MSG_TYPE 1
+
+static void write_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+
+static uint8_t msg_buffer[128];
+static uint8_t msg_addrtlvs[1000];
+
+static struct rfc5444_writer writer = {
+  .msg_buffer = msg_buffer,
+  .msg_size = sizeof(msg_buffer),
+  .addrtlv_buffer = msg_addrtlvs,
+  .addrtlv_size = sizeof(msg_addrtlvs),
+};
+
+static uint8_t packet_buffer_if[64];
+static struct rfc5444_writer_target out_if = {
+  .packet_buffer = packet_buffer_if,
+  .packet_size = sizeof(packet_buffer_if),
+  .sendPacket = write_packet,
+};
+
+/* message without address block: type, flags/addrlen, size, empty tlv block */
+static uint8_t binary_msg[6] = { MSG_TYPE, 0x03, 0x00, 0x06, 0x00, 0x00 };
+
+static int packets;
+static uint8_t last_packet[64];
+static size_t last_length;
+
+static int addMessageHeader(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  rfc5444_writer_set_msg_header(wr, msg, false, false, false, false);
+  return RFC5444_OKAY;
+}
+
+static void write_packet(struct rfc5444_writer *w __attribute__ ((unused)),
+    struct rfc5444_writer_target *iface __attribute__ ((unused)),
+    void *buffer, size_t length) {
+  packets++;
+
+  memcpy(last_packet, buffer, length);
+  last_length = length;
+}
+
+static void clear_elements(void) {
+  packets = 0;
+  last_length = 0;
+  memset(last_packet, 0, sizeof(last_packet));
+}
+
+static void test_binary_copy(void) {
+  START_TEST();
+
+  CHECK_TRUE(rfc5444_writer_add_binary_msg(&writer, &out_if, binary_msg, sizeof(binary_msg)) == RFC5444_OKAY,
+      "binary message not added");
+  CHECK_TRUE(packets == 0, "packet sent before flush");
+
+  rfc5444_writer_flush(&writer, &out_if, false);
+
+  /* packet header is a single byte without sequence number or TLVs */
+  CHECK_TRUE(packets == 1, "bad number of packets: %d", packets);
+  CHECK_TRUE(last_length == 1 + sizeof(binary_msg), "bad packet length: %zu", last_length);
+  CHECK_TRUE(memcmp(&last_packet[1], binary_msg, sizeof(binary_msg)) == 0, "message was modified");
+
+  END_TEST();
+}
+
+static void test_binary_after_generated(void) {
+  uint8_t generated[sizeof(binary_msg)];
+
+  START_TEST();
+
+  /* a generated message and a binary copy of it end up in the same packet */
+  CHECK_TRUE(rfc5444_writer_create_message_alltarget(&writer, MSG_TYPE, 4) == RFC5444_OKAY,
+      "message not generated");
+  CHECK_TRUE(rfc5444_writer_add_binary_msg(&writer, &out_if, binary_msg, sizeof(binary_msg)) == RFC5444_OKAY,
+      "binary message not added");
+  rfc5444_writer_flush(&writer, &out_if, false);
+
+  CHECK_TRUE(packets == 1, "bad number of packets: %d", packets);
+  CHECK_TRUE(last_length == 1 + 2 * sizeof(binary_msg), "bad packet length: %zu", last_length);
+
+  memcpy(generated, &last_packet[1], sizeof(generated));
+  CHECK_TRUE(memcmp(generated, binary_msg, sizeof(binary_msg)) == 0, "generated message differs from binary one");
+  CHECK_TRUE(memcmp(&last_packet[1 + sizeof(binary_msg)], binary_msg, sizeof(binary_msg)) == 0,
+      "message was modified");
+
+  END_TEST();
+}
+
+static void test_binary_full_packet(void) {
+  size_t count, i;
+
+  START_TEST();
+
+  /* messages that do not fit into the current packet start a new one */
+  count = (sizeof(packet_buffer_if) - 1) / sizeof(binary_msg) + 1;
+  for (i = 0; i < count; i++) {
+    CHECK_TRUE(rfc5444_writer_add_binary_msg(&writer, &out_if, binary_msg, sizeof(binary_msg)) == RFC5444_OKAY,
+        "binary message %zu not added", i);
+  }
+  CHECK_TRUE(packets == 1, "full packet not sent: %d", packets);
+  CHECK_TRUE(last_length == 1 + (count - 1) * sizeof(binary_msg), "bad length of full packet: %zu", last_length);
+
+  rfc5444_writer_flush(&writer, &out_if, false);
+  CHECK_TRUE(packets == 2, "bad number of packets: %d", packets);
+  CHECK_TRUE(last_length == 1 + sizeof(binary_msg), "bad length of second packet: %zu", last_length);
+
+  END_TEST();
+}
+
+static void test_binary_too_long(void) {
+  uint8_t long_msg[sizeof(packet_buffer_if)];
+
+  START_TEST();
+
+  memset(long_msg, 0, sizeof(long_msg));
+  memcpy(long_msg, binary_msg, sizeof(binary_msg));
+  long_msg[3] = sizeof(long_msg);
+
+  CHECK_TRUE(rfc5444_writer_add_binary_msg(&writer, &out_if, long_msg, sizeof(long_msg))
+      == RFC5444_FW_MESSAGE_TOO_LONG, "message longer than packet accepted");
+
+  /* like a forwarded message, the message might leave an empty packet behind */
+  rfc5444_writer_flush(&writer, &out_if, false);
+  CHECK_TRUE(last_length <= 1, "message longer than packet was sent: %zu", last_length);
+
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  struct rfc5444_writer_message *msg;
+
+  rfc5444_writer_init(&writer);
+
+  rfc5444_writer_register_target(&writer, &out_if);
+
+  msg = rfc5444_writer_register_message(&writer, MSG_TYPE, false);
+  msg->addMessageHeader = addMessageHeader;
+
+  BEGIN_TESTING(clear_elements);
+
+  test_binary_copy();
+  test_binary_after_generated();
+  test_binary_full_packet();
+  test_binary_too_long();
+
+  rfc5444_writer_cleanup(&writer);
+
+  return FINISH_TESTING();
+}